@@ -0,0 +1,153 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKATOMICINTEGER_H
+#define MITKATOMICINTEGER_H
+
+#include <itkSimpleFastMutexLock.h>
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+  #pragma intrinsic(_InterlockedIncrement, _InterlockedDecrement, _InterlockedExchangeAdd, _InterlockedExchange, _InterlockedCompareExchange)
+  #define MITK_ATOMIC_USE_MSVC_INTRINSICS
+#elif defined(__GNUC__) && ((__GNUC__ > 4) || ((__GNUC__ == 4) && (__GNUC_MINOR__ >= 2)))
+  #define MITK_ATOMIC_USE_GCC_INTRINSICS
+#endif
+
+namespace mitk {
+
+//##Documentation
+//## @brief Integer with atomic increment, decrement, addition, store and compare-and-swap.
+//##
+//## Every operation acts as a full memory barrier. On compilers without
+//## atomic intrinsics the operations are serialized by a mutex, which keeps
+//## the semantics but not the performance.
+//## @ingroup Data
+class AtomicInteger
+{
+public:
+
+  AtomicInteger(long value = 0) : m_Value(value) {}
+
+  /** \brief Increments the value and returns the new value. */
+  long Increment()
+  {
+#if defined(MITK_ATOMIC_USE_MSVC_INTRINSICS)
+    return _InterlockedIncrement(&m_Value);
+#elif defined(MITK_ATOMIC_USE_GCC_INTRINSICS)
+    return __sync_add_and_fetch(&m_Value, 1);
+#else
+    m_Mutex.Lock();
+    long value = ++m_Value;
+    m_Mutex.Unlock();
+    return value;
+#endif
+  }
+
+  /** \brief Decrements the value and returns the new value. */
+  long Decrement()
+  {
+#if defined(MITK_ATOMIC_USE_MSVC_INTRINSICS)
+    return _InterlockedDecrement(&m_Value);
+#elif defined(MITK_ATOMIC_USE_GCC_INTRINSICS)
+    return __sync_sub_and_fetch(&m_Value, 1);
+#else
+    m_Mutex.Lock();
+    long value = --m_Value;
+    m_Mutex.Unlock();
+    return value;
+#endif
+  }
+
+  /** \brief Adds value and returns the new value. */
+  long Add(long value)
+  {
+#if defined(MITK_ATOMIC_USE_MSVC_INTRINSICS)
+    return _InterlockedExchangeAdd(&m_Value, value) + value;
+#elif defined(MITK_ATOMIC_USE_GCC_INTRINSICS)
+    return __sync_add_and_fetch(&m_Value, value);
+#else
+    m_Mutex.Lock();
+    long newValue = (m_Value += value);
+    m_Mutex.Unlock();
+    return newValue;
+#endif
+  }
+
+  /** \brief Sets the value and returns the previous value. */
+  long Set(long value)
+  {
+#if defined(MITK_ATOMIC_USE_MSVC_INTRINSICS)
+    return _InterlockedExchange(&m_Value, value);
+#elif defined(MITK_ATOMIC_USE_GCC_INTRINSICS)
+    // __sync_lock_test_and_set is only an acquire barrier
+    __sync_synchronize();
+    return __sync_lock_test_and_set(&m_Value, value);
+#else
+    m_Mutex.Lock();
+    long previous = m_Value;
+    m_Value = value;
+    m_Mutex.Unlock();
+    return previous;
+#endif
+  }
+
+  /** \brief Sets the value to newValue if it equals expected. Returns true on success. */
+  bool CompareAndSwap(long expected, long newValue)
+  {
+#if defined(MITK_ATOMIC_USE_MSVC_INTRINSICS)
+    return _InterlockedCompareExchange(&m_Value, newValue, expected) == expected;
+#elif defined(MITK_ATOMIC_USE_GCC_INTRINSICS)
+    return __sync_bool_compare_and_swap(&m_Value, expected, newValue);
+#else
+    m_Mutex.Lock();
+    bool swapped = (m_Value == expected);
+    if (swapped)
+      m_Value = newValue;
+    m_Mutex.Unlock();
+    return swapped;
+#endif
+  }
+
+  /** \brief Returns the current value (with full barrier semantics). */
+  long Get() const
+  {
+#if defined(MITK_ATOMIC_USE_MSVC_INTRINSICS)
+    return _InterlockedCompareExchange(&m_Value, 0, 0);
+#elif defined(MITK_ATOMIC_USE_GCC_INTRINSICS)
+    return __sync_add_and_fetch(&m_Value, 0);
+#else
+    m_Mutex.Lock();
+    long value = m_Value;
+    m_Mutex.Unlock();
+    return value;
+#endif
+  }
+
+private:
+
+  AtomicInteger(const AtomicInteger&);            // Not implemented on purpose.
+  AtomicInteger& operator=(const AtomicInteger&); // Not implemented on purpose.
+
+  mutable volatile long m_Value;
+#if !defined(MITK_ATOMIC_USE_MSVC_INTRINSICS) && !defined(MITK_ATOMIC_USE_GCC_INTRINSICS)
+  mutable itk::SimpleFastMutexLock m_Mutex;
+#endif
+};
+
+} // namespace mitk
+
+#endif // MITKATOMICINTEGER_H
@@ -19,8 +19,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkRenderingManager.h>
 
 mitk::LimitedLinearUndo::LimitedLinearUndo()
+: m_MemoryLimit(0)
 {
-  // nothing to do
 }
 
 mitk::LimitedLinearUndo::~LimitedLinearUndo()
@@ -54,6 +54,8 @@ bool mitk::LimitedLinearUndo::SetOperationEvent(UndoStackItem* stackItem)
 
   m_UndoList.push_back(operationEvent);
 
+  this->LimitMemoryUsage();
+
   InvokeEvent( UndoNotEmptyEvent() );
 
   return true;
@@ -195,6 +197,40 @@ mitk::OperationEvent* mitk::LimitedLinearUndo::GetLastOfType(OperationActor* des
   return NULL;
 }
 
+unsigned long mitk::LimitedLinearUndo::GetMemoryUsage()
+{
+  unsigned long memoryUsage(0);
+  for ( UndoContainer::iterator iter = m_UndoList.begin(); iter != m_UndoList.end(); ++iter )
+    memoryUsage += (*iter)->GetMemorySize();
+  for ( UndoContainer::iterator iter = m_RedoList.begin(); iter != m_RedoList.end(); ++iter )
+    memoryUsage += (*iter)->GetMemorySize();
+  return memoryUsage;
+}
+
+void mitk::LimitedLinearUndo::LimitMemoryUsage()
+{
+  if (m_MemoryLimit == 0 || m_UndoList.empty()) return;
+
+  unsigned long memoryUsage = this->GetMemoryUsage();
+  if (memoryUsage <= m_MemoryLimit) return;
+
+  // the oldest items are at the front of the undo list. Remove whole object events
+  // from there, but keep the newest one in any case
+  int newestObjectEventId = m_UndoList.back()->GetObjectEventId();
+  UndoContainer::iterator firstKept = m_UndoList.begin();
+  while ( memoryUsage > m_MemoryLimit && (*firstKept)->GetObjectEventId() != newestObjectEventId )
+  {
+    int oldestObjectEventId = (*firstKept)->GetObjectEventId();
+    while ( (*firstKept)->GetObjectEventId() == oldestObjectEventId )
+    {
+      memoryUsage -= (*firstKept)->GetMemorySize();
+      delete *firstKept;
+      ++firstKept;
+    }
+  }
+  m_UndoList.erase(m_UndoList.begin(), firstKept);
+}
+
 int mitk::LimitedLinearUndo::FirstObjectEventIdOfCurrentGroup(mitk::LimitedLinearUndo::UndoContainer& stack)
 {
   int currentGroupEventId = stack.back()->GetGroupEventId();
@@ -36,6 +36,9 @@ namespace mitk {
 //##
 //## Derived from UndoModel AND itk::Object. Invokes ITK-events to signal listening
 //## GUI elements, whether each of the stacks is empty or not (to enable/disable button, ...)
+//##
+//## The memory occupied by the stacks can be limited by SetMemoryLimit(). If a new item
+//## exceeds the limit, the oldest items of the undo stack are deleted.
 class MITK_CORE_EXPORT LimitedLinearUndo : public UndoModel
 {
 public:
@@ -103,6 +106,19 @@ public:
   //## corresponding to the given values; if nothing found, then returns NULL
   virtual OperationEvent* GetLastOfType(OperationActor* destination, OperationType opType);
 
+  //##Documentation
+  //## @brief Sets the maximum number of bytes the items of both stacks may occupy.
+  //##
+  //## Items of the same ObjectEventId are always removed together and the items of the
+  //## newest ObjectEventId are never removed. 0 (default) means no limit. Undo models created
+  //## by the UndoController are limited to a quarter of the physical memory.
+  itkSetMacro(MemoryLimit, unsigned long);
+  itkGetConstMacro(MemoryLimit, unsigned long);
+
+  //##Documentation
+  //## @brief Returns the number of bytes occupied by the items of both stacks
+  unsigned long GetMemoryUsage();
+
 protected:
   //##Documentation
   //## Constructor
@@ -116,10 +132,15 @@ protected:
   //## elements in the list and to clear the list
   void ClearList(UndoContainer* list);
 
+  //## @brief Deletes the oldest items of the undo list until the memory limit is met
+  void LimitMemoryUsage();
+
   UndoContainer m_UndoList;
 
   UndoContainer m_RedoList;
 
+  unsigned long m_MemoryLimit;
+
 private:
   int FirstObjectEventIdOfCurrentGroup(UndoContainer& stack);
 
@@ -98,6 +98,11 @@ void mitk::UndoStackItem::ReverseAndExecute()
   ReverseOperations();
 }
 
+unsigned long mitk::UndoStackItem::GetMemorySize()
+{
+  return 0;
+}
+
 // ******************** mitk::OperationEvent ********************
 
 mitk::Operation* mitk::OperationEvent::GetOperation()
@@ -173,3 +178,13 @@ bool mitk::OperationEvent::IsValid()
 {
   return !m_Invalid;
 }
+
+unsigned long mitk::OperationEvent::GetMemorySize()
+{
+  unsigned long memorySize(0);
+  if (m_Operation)
+    memorySize += m_Operation->GetMemorySize();
+  if (m_UndoOperation)
+    memorySize += m_UndoOperation->GetMemorySize();
+  return memorySize;
+}
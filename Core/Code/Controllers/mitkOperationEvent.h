@@ -84,6 +84,10 @@ class MITK_CORE_EXPORT UndoStackItem
     virtual void ReverseOperations();
     virtual void ReverseAndExecute();
 
+    //##Documentation
+    //## @brief Returns the number of bytes of data held by this item. The default implementation returns 0.
+    virtual unsigned long GetMemorySize();
+
     //##Documentation
     //## @brief Sets the current ObjectEventId to be incremended when ExecuteIncrement is called
     //## For example if a button click generates operations the ObjectEventId has to be incremented to be able to undo the operations.
@@ -177,6 +181,9 @@ public:
   //## and false if it already has been deleted
   virtual bool IsValid();
 
+  //## @brief Returns the memory size of the operation and the undo operation
+  virtual unsigned long GetMemorySize();
+
 protected:
 
   void OnObjectDeleted();
@@ -20,6 +20,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkVerboseLimitedLinearUndo.h"
 #include "mitkInteractionConst.h"
 #include "mitkRenderingManager.h"
+#include "mitkMemoryUtilities.h"
+
+#include <limits>
 
 //static member-variables init.
 mitk::UndoModel::Pointer mitk::UndoController::m_CurUndoModel;
@@ -54,6 +57,7 @@ mitk::UndoController::UndoController(UndoType undoType)
       m_CurUndoType = undoType;
       m_UndoModelList.insert(UndoModelMap::value_type(undoType, m_CurUndoModel));
     }
+    SetDefaultMemoryLimit(m_CurUndoModel);
   }
 }
 
@@ -160,9 +164,24 @@ bool mitk::UndoController::AddUndoModel(UndoType undoType)
     //that undoType is not implemented!
     return false;
   }
+  SetDefaultMemoryLimit(m_CurUndoModel);
   return true;
 }
 
+void mitk::UndoController::SetDefaultMemoryLimit(UndoModel* undoModel)
+{
+  LimitedLinearUndo* limitedUndoModel = dynamic_cast<LimitedLinearUndo*>(undoModel);
+  if (limitedUndoModel == NULL)
+    return;
+
+  // a quarter of the physical memory, but at most what fits into the limit (4 GB on 64 bit Windows)
+  size_t memoryLimit = MemoryUtilities::GetTotalSizeOfPhysicalRam() / 4;
+  if (memoryLimit > std::numeric_limits<unsigned long>::max())
+    memoryLimit = std::numeric_limits<unsigned long>::max();
+
+  limitedUndoModel->SetMemoryLimit(static_cast<unsigned long>(memoryLimit));
+}
+
 //##Documentation
 //##Removes an UndoModel from the set of UndoModels
 //##If that UndoModel is currently selected, then the DefaultUndoModel(const) is set.
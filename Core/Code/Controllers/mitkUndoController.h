@@ -118,6 +118,13 @@ class MITK_CORE_EXPORT UndoController
   static UndoModel* GetCurrentUndoModel();
 
   private:
+  //##Documentation
+  //## @brief Limits the memory of a new LimitedLinearUndo to a quarter of the physical memory
+  //##
+  //## Without a limit the compressed slices of long segmentation sessions are kept until the
+  //## memory is exhausted. Applications may change the limit via GetCurrentUndoModel().
+  static void SetDefaultMemoryLimit(UndoModel* undoModel);
+
   //##Documentation
   //## current selected UndoModel
   static UndoModel::Pointer m_CurUndoModel;
@@ -20,6 +20,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkPixelTypeMultiplex.h"
 #include <mitkProportionalTimeGeometry.h>
 #include "mitkCompareImageDataFilter.h"
+#include "mitkMemoryMappedFile.h"
+
+//ITK
+#include <itkMutexLockHolder.h>
 
 //VTK
 #include <vtkImageData.h>
@@ -32,8 +36,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 
 mitk::Image::Image() :
+  m_CopiedBytes(0), m_AliasedBytes(0), m_PreallocateChannel(false),
   m_Dimension(0), m_Dimensions(NULL), m_ImageDescriptor(NULL), m_OffsetTable(NULL), m_CompleteData(NULL),
-  m_ImageStatistics(NULL)
+  m_ImageStatistics(NULL), m_FastReaderReleased(itk::ConditionVariable::New())
 {
   m_Dimensions = new unsigned int[MAX_IMAGE_DIMENSIONS];
   FILL_C_ARRAY( m_Dimensions, MAX_IMAGE_DIMENSIONS, 0u);
@@ -41,8 +46,9 @@ mitk::Image::Image() :
   m_Initialized = false;
 }
 
-mitk::Image::Image(const Image &other) : SlicedData(other), m_Dimension(0), m_Dimensions(NULL),
-  m_ImageDescriptor(NULL), m_OffsetTable(NULL), m_CompleteData(NULL), m_ImageStatistics(NULL)
+mitk::Image::Image(const Image &other) : SlicedData(other), m_CopiedBytes(0), m_AliasedBytes(0), m_PreallocateChannel(false), m_Dimension(0), m_Dimensions(NULL),
+  m_ImageDescriptor(NULL), m_OffsetTable(NULL), m_CompleteData(NULL), m_ImageStatistics(NULL),
+  m_FastReaderReleased(itk::ConditionVariable::New())
 {
   m_Dimensions = new unsigned int[MAX_IMAGE_DIMENSIONS];
   FILL_C_ARRAY( m_Dimensions, MAX_IMAGE_DIMENSIONS, 0u);
@@ -58,12 +64,15 @@ mitk::Image::Image(const Image &other) : SlicedData(other), m_Dimension(0), m_Di
   {
     const unsigned int time_steps = this->GetDimension(3);
 
+    // all volumes are copied, keep them together in one channel buffer
+    this->SetPreallocateChannel(true);
     for (unsigned int i = 0u; i < time_steps; ++i)
     {
       ImageDataItemPointer volume = const_cast<Image&>(other).GetVolumeData(i);
 
       this->SetVolume(volume->GetData(), i);
     }
+    this->SetPreallocateChannel(false);
   }
   else
   {
@@ -227,6 +236,44 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetSliceData(int s, int t, int n,
 {
   if(IsValidSlice(s,t,n)==false) return NULL;
 
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+
+    ImageDataItemPointer sl = LookupSliceData(s,t,n,data,importMemoryManagement);
+    if(sl.GetPointer()!=NULL)
+      return sl;
+
+    if((GetSource().IsNull()) || (GetSource()->Updating()==true))
+    {
+      ImageDataItemPointer item = AllocateSliceData(s,t,n,data,importMemoryManagement);
+      item->SetComplete(true);
+      return item;
+    }
+  }
+
+  // slice is unavailable, so we have to calculate it. The lock is not held
+  // during the update, since the source will set the data of this image.
+  m_RequestedRegion.SetIndex(0, 0);
+  m_RequestedRegion.SetIndex(1, 0);
+  m_RequestedRegion.SetIndex(2, s);
+  m_RequestedRegion.SetIndex(3, t);
+  m_RequestedRegion.SetIndex(4, n);
+  m_RequestedRegion.SetSize(0, m_Dimensions[0]);
+  m_RequestedRegion.SetSize(1, m_Dimensions[1]);
+  m_RequestedRegion.SetSize(2, 1);
+  m_RequestedRegion.SetSize(3, 1);
+  m_RequestedRegion.SetSize(4, 1);
+  m_RequestedRegionInitialized=true;
+  GetSource()->Update();
+  if(IsSliceSet(s,t,n))
+    //yes: now we can call ourselves without the risk of a endless loop (see "if" above)
+    return GetSliceData(s,t,n,data,importMemoryManagement);
+  else
+    return NULL;
+}
+
+mitk::Image::ImageDataItemPointer mitk::Image::LookupSliceData(int s, int t, int n, void *data, ImportMemoryManagementType importMemoryManagement)
+{
   const size_t ptypeSize = this->m_ImageDescriptor->GetChannelTypeById(n).GetSize();
 
   // slice directly available?
@@ -241,6 +288,7 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetSliceData(int s, int t, int n,
   {
     sl=new ImageDataItem(*vol, m_ImageDescriptor, 2, data, importMemoryManagement == ManageMemory, ((size_t) s)*m_OffsetTable[2]*(ptypeSize));
     sl->SetComplete(true);
+    m_AliasedBytes += m_OffsetTable[2]*ptypeSize;
     return m_Slices[pos]=sl;
   }
 
@@ -250,43 +298,54 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetSliceData(int s, int t, int n,
   {
     sl=new ImageDataItem(*ch, m_ImageDescriptor, 2, data, importMemoryManagement == ManageMemory, (((size_t) s)*m_OffsetTable[2]+((size_t) t)*m_OffsetTable[3])*(ptypeSize));
     sl->SetComplete(true);
+    m_AliasedBytes += m_OffsetTable[2]*ptypeSize;
     return m_Slices[pos]=sl;
   }
 
-  // slice is unavailable. Can we calculate it?
-  if((GetSource().IsNotNull()) && (GetSource()->Updating()==false))
-  {
-    // ... wir mussen rechnen!!! ....
-    m_RequestedRegion.SetIndex(0, 0);
-    m_RequestedRegion.SetIndex(1, 0);
-    m_RequestedRegion.SetIndex(2, s);
-    m_RequestedRegion.SetIndex(3, t);
-    m_RequestedRegion.SetIndex(4, n);
-    m_RequestedRegion.SetSize(0, m_Dimensions[0]);
-    m_RequestedRegion.SetSize(1, m_Dimensions[1]);
-    m_RequestedRegion.SetSize(2, 1);
-    m_RequestedRegion.SetSize(3, 1);
-    m_RequestedRegion.SetSize(4, 1);
-    m_RequestedRegionInitialized=true;
-    GetSource()->Update();
-    if(IsSliceSet(s,t,n))
-      //yes: now we can call ourselves without the risk of a endless loop (see "if" above)
-      return GetSliceData(s,t,n,data,importMemoryManagement);
-    else
-      return NULL;
-  }
-  else
-  {
-    ImageDataItemPointer item = AllocateSliceData(s,t,n,data,importMemoryManagement);
-    item->SetComplete(true);
-    return item;
-  }
+  return NULL;
 }
 
 mitk::Image::ImageDataItemPointer mitk::Image::GetVolumeData(int t, int n, void *data, ImportMemoryManagementType importMemoryManagement)
 {
   if(IsValidVolume(t,n)==false) return NULL;
 
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+
+    ImageDataItemPointer vol = LookupVolumeData(t,n,data,importMemoryManagement);
+    if(vol.GetPointer()!=NULL)
+      return vol;
+
+    if((GetSource().IsNull()) || (GetSource()->Updating()==true))
+    {
+      ImageDataItemPointer item = AllocateVolumeData(t,n,data,importMemoryManagement);
+      item->SetComplete(true);
+      return item;
+    }
+  }
+
+  // volume is unavailable, so we have to calculate it (without holding the lock)
+  m_RequestedRegion.SetIndex(0, 0);
+  m_RequestedRegion.SetIndex(1, 0);
+  m_RequestedRegion.SetIndex(2, 0);
+  m_RequestedRegion.SetIndex(3, t);
+  m_RequestedRegion.SetIndex(4, n);
+  m_RequestedRegion.SetSize(0, m_Dimensions[0]);
+  m_RequestedRegion.SetSize(1, m_Dimensions[1]);
+  m_RequestedRegion.SetSize(2, m_Dimensions[2]);
+  m_RequestedRegion.SetSize(3, 1);
+  m_RequestedRegion.SetSize(4, 1);
+  m_RequestedRegionInitialized=true;
+  GetSource()->Update();
+  if(IsVolumeSet(t,n))
+    //yes: now we can call ourselves without the risk of a endless loop (see "if" above)
+    return GetVolumeData(t,n,data,importMemoryManagement);
+  else
+    return NULL;
+}
+
+mitk::Image::ImageDataItemPointer mitk::Image::LookupVolumeData(int t, int n, void *data, ImportMemoryManagementType importMemoryManagement)
+{
   ImageDataItemPointer ch, vol;
 
   // volume directly available?
@@ -303,202 +362,187 @@ mitk::Image::ImageDataItemPointer mitk::Image::GetVolumeData(int t, int n, void
   {
     vol=new ImageDataItem(*ch, m_ImageDescriptor, 3, data, importMemoryManagement == ManageMemory, (((size_t) t)*m_OffsetTable[3])*(ptypeSize));
     vol->SetComplete(true);
+    m_AliasedBytes += m_OffsetTable[3]*ptypeSize;
     return m_Volumes[pos]=vol;
   }
 
   // let's see if all slices of the volume are set, so that we can (could) combine them to a volume
-  bool complete=true;
   unsigned int s;
   for(s=0;s<m_Dimensions[2];++s)
   {
     if(m_Slices[GetSliceIndex(s,t,n)].GetPointer()==NULL)
-    {
-      complete=false;
-      break;
-    }
+      return NULL;
   }
-  if(complete)
+
+  // if there is only single slice we do not need to combine anything
+  if(m_Dimensions[2]<=1)
   {
-    // if there is only single slice we do not need to combine anything
-    if(m_Dimensions[2]<=1)
+    ImageDataItemPointer sl = m_Slices[GetSliceIndex(0,t,n)];
+    vol=new ImageDataItem(*sl, m_ImageDescriptor, 3, data, importMemoryManagement == ManageMemory);
+    vol->SetComplete(true);
+    m_AliasedBytes += m_OffsetTable[2]*ptypeSize;
+  }
+  else
+  {
+    mitk::PixelType chPixelType = this->m_ImageDescriptor->GetChannelTypeById(n);
+
+    vol=m_Volumes[pos];
+    // ok, let's combine the slices!
+    if(vol.GetPointer()==NULL)
+      vol=new ImageDataItem( chPixelType, 3, m_Dimensions, NULL, true);
+    vol->SetComplete(true);
+    size_t size=m_OffsetTable[2]*(ptypeSize);
+    for(s=0;s<m_Dimensions[2];++s)
     {
+      int posSl;
       ImageDataItemPointer sl;
-      sl=GetSliceData(0,t,n,data,importMemoryManagement);
-      vol=new ImageDataItem(*sl, m_ImageDescriptor, 3, data, importMemoryManagement == ManageMemory);
-      vol->SetComplete(true);
-    }
-    else
-    {
-      mitk::PixelType chPixelType = this->m_ImageDescriptor->GetChannelTypeById(n);
-
-      vol=m_Volumes[pos];
-      // ok, let's combine the slices!
-      if(vol.GetPointer()==NULL)
-        vol=new ImageDataItem( chPixelType, 3, m_Dimensions, NULL, true);
-      vol->SetComplete(true);
-      size_t size=m_OffsetTable[2]*(ptypeSize);
-      for(s=0;s<m_Dimensions[2];++s)
+      posSl=GetSliceIndex(s,t,n);
+
+      sl=m_Slices[posSl];
+      if(sl->GetParent()!=vol)
       {
-        int posSl;
-        ImageDataItemPointer sl;
-        posSl=GetSliceIndex(s,t,n);
+        // copy data of slices in volume
+        size_t offset = ((size_t) s)*size;
+        std::memcpy(static_cast<char*>(vol->GetData())+offset, sl->GetData(), size);
+        m_CopiedBytes += size;
+
+        // FIXME mitkIpPicDescriptor * pic = sl->GetPicDescriptor();
+
+        // replace old slice with reference to volume
+        sl=new ImageDataItem(*vol, m_ImageDescriptor, 2, data, importMemoryManagement == ManageMemory, ((size_t) s)*size);
+        sl->SetComplete(true);
+        //mitkIpFuncCopyTags(sl->GetPicDescriptor(), pic);
+        m_Slices[posSl]=sl;
+      }
+    }
+    //if(vol->GetPicDescriptor()->info->tags_head==NULL)
+    //  mitkIpFuncCopyTags(vol->GetPicDescriptor(), m_Slices[GetSliceIndex(0,t,n)]->GetPicDescriptor());
+  }
+  return m_Volumes[pos]=vol;
+}
 
-        sl=m_Slices[posSl];
-        if(sl->GetParent()!=vol)
-        {
-          // copy data of slices in volume
-          size_t offset = ((size_t) s)*size;
-          std::memcpy(static_cast<char*>(vol->GetData())+offset, sl->GetData(), size);
+mitk::Image::ImageDataItemPointer mitk::Image::GetChannelData(int n, void *data, ImportMemoryManagementType importMemoryManagement)
+{
+  if(IsValidChannel(n)==false) return NULL;
 
-          // FIXME mitkIpPicDescriptor * pic = sl->GetPicDescriptor();
+  {
+    itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
 
-          // replace old slice with reference to volume
-          sl=new ImageDataItem(*vol, m_ImageDescriptor, 2, data, importMemoryManagement == ManageMemory, ((size_t) s)*size);
-          sl->SetComplete(true);
-          //mitkIpFuncCopyTags(sl->GetPicDescriptor(), pic);
-          m_Slices[posSl]=sl;
-        }
-      }
-      //if(vol->GetPicDescriptor()->info->tags_head==NULL)
-      //  mitkIpFuncCopyTags(vol->GetPicDescriptor(), m_Slices[GetSliceIndex(0,t,n)]->GetPicDescriptor());
+    ImageDataItemPointer ch = LookupChannelData(n,data,importMemoryManagement);
+    if(ch.GetPointer()!=NULL)
+      return ch;
+
+    if((GetSource().IsNull()) || (GetSource()->Updating()==true))
+    {
+      ImageDataItemPointer item = AllocateChannelData(n,data,importMemoryManagement);
+      item->SetComplete(true);
+      return item;
     }
-    return m_Volumes[pos]=vol;
   }
 
-  // volume is unavailable. Can we calculate it?
-  if((GetSource().IsNotNull()) && (GetSource()->Updating()==false))
-  {
-    // ... wir muessen rechnen!!! ....
-    m_RequestedRegion.SetIndex(0, 0);
-    m_RequestedRegion.SetIndex(1, 0);
-    m_RequestedRegion.SetIndex(2, 0);
-    m_RequestedRegion.SetIndex(3, t);
-    m_RequestedRegion.SetIndex(4, n);
-    m_RequestedRegion.SetSize(0, m_Dimensions[0]);
-    m_RequestedRegion.SetSize(1, m_Dimensions[1]);
-    m_RequestedRegion.SetSize(2, m_Dimensions[2]);
-    m_RequestedRegion.SetSize(3, 1);
-    m_RequestedRegion.SetSize(4, 1);
-    m_RequestedRegionInitialized=true;
-    GetSource()->Update();
-    if(IsVolumeSet(t,n))
-      //yes: now we can call ourselves without the risk of a endless loop (see "if" above)
-      return GetVolumeData(t,n,data,importMemoryManagement);
-    else
-      return NULL;
-  }
+  // channel is unavailable, so we have to calculate it (without holding the lock)
+  m_RequestedRegion.SetIndex(0, 0);
+  m_RequestedRegion.SetIndex(1, 0);
+  m_RequestedRegion.SetIndex(2, 0);
+  m_RequestedRegion.SetIndex(3, 0);
+  m_RequestedRegion.SetIndex(4, n);
+  m_RequestedRegion.SetSize(0, m_Dimensions[0]);
+  m_RequestedRegion.SetSize(1, m_Dimensions[1]);
+  m_RequestedRegion.SetSize(2, m_Dimensions[2]);
+  m_RequestedRegion.SetSize(3, m_Dimensions[3]);
+  m_RequestedRegion.SetSize(4, 1);
+  m_RequestedRegionInitialized=true;
+  GetSource()->Update();
+  // did it work?
+  if(IsChannelSet(n))
+    //yes: now we can call ourselves without the risk of a endless loop (see "if" above)
+    return GetChannelData(n,data,importMemoryManagement);
   else
-  {
-    ImageDataItemPointer item = AllocateVolumeData(t,n,data,importMemoryManagement);
-    item->SetComplete(true);
-    return item;
-  }
+    return NULL;
 }
 
-mitk::Image::ImageDataItemPointer mitk::Image::GetChannelData(int n, void *data, ImportMemoryManagementType importMemoryManagement)
+mitk::Image::ImageDataItemPointer mitk::Image::LookupChannelData(int n, void *data, ImportMemoryManagementType importMemoryManagement)
 {
-  if(IsValidChannel(n)==false) return NULL;
   ImageDataItemPointer ch, vol;
   ch=m_Channels[n];
   if((ch.GetPointer()!=NULL) && (ch->IsComplete()))
     return ch;
 
   // let's see if all volumes are set, so that we can (could) combine them to a channel
-  if(IsChannelSet(n))
+  if(IsChannelSetUnlocked(n)==false)
+    return NULL;
+
+  // if there is only one time frame we do not need to combine anything
+  if(m_Dimensions[3]<=1)
   {
-    // if there is only one time frame we do not need to combine anything
-    if(m_Dimensions[3]<=1)
-    {
-      vol=GetVolumeData(0,n,data,importMemoryManagement);
-      ch=new ImageDataItem(*vol, m_ImageDescriptor, m_ImageDescriptor->GetNumberOfDimensions(), data, importMemoryManagement == ManageMemory);
-      ch->SetComplete(true);
-    }
-    else
+    vol=LookupVolumeData(0,n,data,importMemoryManagement);
+    ch=new ImageDataItem(*vol, m_ImageDescriptor, m_ImageDescriptor->GetNumberOfDimensions(), data, importMemoryManagement == ManageMemory);
+    ch->SetComplete(true);
+    m_AliasedBytes += m_OffsetTable[3]*this->m_ImageDescriptor->GetChannelTypeById(n).GetSize();
+  }
+  else
+  {
+    const size_t ptypeSize = this->m_ImageDescriptor->GetChannelTypeById(n).GetSize();
+
+    ch=m_Channels[n];
+    // ok, let's combine the volumes! If the volumes have been allocated as parts
+    // of the channel buffer (see AllocateVolumeData), nothing needs to be copied.
+    if(ch.GetPointer()==NULL)
+      ch=new ImageDataItem(this->m_ImageDescriptor, NULL, true);
+    ch->SetComplete(true);
+    size_t size=m_OffsetTable[m_Dimension-1]*(ptypeSize);
+    unsigned int t;
+    ImageDataItemPointerArray::iterator slicesIt = m_Slices.begin()+n*m_Dimensions[2]*m_Dimensions[3];
+    for(t=0;t<m_Dimensions[3];++t)
     {
-      const size_t ptypeSize = this->m_ImageDescriptor->GetChannelTypeById(n).GetSize();
-
-      ch=m_Channels[n];
-      // ok, let's combine the volumes!
-      if(ch.GetPointer()==NULL)
-        ch=new ImageDataItem(this->m_ImageDescriptor, NULL, true);
-      ch->SetComplete(true);
-      size_t size=m_OffsetTable[m_Dimension-1]*(ptypeSize);
-      unsigned int t;
-      ImageDataItemPointerArray::iterator slicesIt = m_Slices.begin()+n*m_Dimensions[2]*m_Dimensions[3];
-      for(t=0;t<m_Dimensions[3];++t)
+      int posVol;
+      ImageDataItemPointer vol;
+
+      posVol=GetVolumeIndex(t,n);
+      vol=LookupVolumeData(t,n,data,importMemoryManagement);
+
+      if(vol->GetParent()!=ch)
       {
-        int posVol;
-        ImageDataItemPointer vol;
+        // copy data of volume in channel
+        size_t offset = ((size_t) t)*m_OffsetTable[3]*(ptypeSize);
+        std::memcpy(static_cast<char*>(ch->GetData())+offset, vol->GetData(), size);
+        m_CopiedBytes += size;
+
+        // REVEIW FIX mitkIpPicDescriptor * pic = vol->GetPicDescriptor();
+
+        // replace old volume with reference to channel
+        vol=new ImageDataItem(*ch, m_ImageDescriptor, 3, data, importMemoryManagement == ManageMemory, offset);
+        vol->SetComplete(true);
+        //mitkIpFuncCopyTags(vol->GetPicDescriptor(), pic);
 
-        posVol=GetVolumeIndex(t,n);
-        vol=GetVolumeData(t,n,data,importMemoryManagement);
+        m_Volumes[posVol]=vol;
 
-        if(vol->GetParent()!=ch)
+        // get rid of slices - they may point to old volume
+        ImageDataItemPointer dnull=NULL;
+        for(unsigned int i = 0; i < m_Dimensions[2]; ++i, ++slicesIt)
         {
-          // copy data of volume in channel
-          size_t offset = ((size_t) t)*m_OffsetTable[3]*(ptypeSize);
-          std::memcpy(static_cast<char*>(ch->GetData())+offset, vol->GetData(), size);
-
-          // REVEIW FIX mitkIpPicDescriptor * pic = vol->GetPicDescriptor();
-
-          // replace old volume with reference to channel
-          vol=new ImageDataItem(*ch, m_ImageDescriptor, 3, data, importMemoryManagement == ManageMemory, offset);
-          vol->SetComplete(true);
-          //mitkIpFuncCopyTags(vol->GetPicDescriptor(), pic);
-
-          m_Volumes[posVol]=vol;
-
-          // get rid of slices - they may point to old volume
-          ImageDataItemPointer dnull=NULL;
-          for(unsigned int i = 0; i < m_Dimensions[2]; ++i, ++slicesIt)
-          {
-            assert(slicesIt != m_Slices.end());
-            *slicesIt = dnull;
-          }
+          assert(slicesIt != m_Slices.end());
+          *slicesIt = dnull;
         }
       }
-      // REVIEW FIX
-      //   if(ch->GetPicDescriptor()->info->tags_head==NULL)
-      //     mitkIpFuncCopyTags(ch->GetPicDescriptor(), m_Volumes[GetVolumeIndex(0,n)]->GetPicDescriptor());
+      else
+      {
+        slicesIt += m_Dimensions[2];
+      }
     }
-    return m_Channels[n]=ch;
-  }
-
-  // channel is unavailable. Can we calculate it?
-  if((GetSource().IsNotNull()) && (GetSource()->Updating()==false))
-  {
-    // ... wir muessen rechnen!!! ....
-    m_RequestedRegion.SetIndex(0, 0);
-    m_RequestedRegion.SetIndex(1, 0);
-    m_RequestedRegion.SetIndex(2, 0);
-    m_RequestedRegion.SetIndex(3, 0);
-    m_RequestedRegion.SetIndex(4, n);
-    m_RequestedRegion.SetSize(0, m_Dimensions[0]);
-    m_RequestedRegion.SetSize(1, m_Dimensions[1]);
-    m_RequestedRegion.SetSize(2, m_Dimensions[2]);
-    m_RequestedRegion.SetSize(3, m_Dimensions[3]);
-    m_RequestedRegion.SetSize(4, 1);
-    m_RequestedRegionInitialized=true;
-    GetSource()->Update();
-    // did it work?
-    if(IsChannelSet(n))
-      //yes: now we can call ourselves without the risk of a endless loop (see "if" above)
-      return GetChannelData(n,data,importMemoryManagement);
-    else
-      return NULL;
-  }
-  else
-  {
-    ImageDataItemPointer item = AllocateChannelData(n,data,importMemoryManagement);
-    item->SetComplete(true);
-    return item;
+    // REVIEW FIX
+    //   if(ch->GetPicDescriptor()->info->tags_head==NULL)
+    //     mitkIpFuncCopyTags(ch->GetPicDescriptor(), m_Volumes[GetVolumeIndex(0,n)]->GetPicDescriptor());
   }
+  return m_Channels[n]=ch;
 }
 
 bool mitk::Image::IsSliceSet(int s, int t, int n) const
 {
   if(IsValidSlice(s,t,n)==false) return false;
 
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+
   if(m_Slices[GetSliceIndex(s,t,n)].GetPointer()!=NULL)
     return true;
 
@@ -515,6 +559,13 @@ bool mitk::Image::IsSliceSet(int s, int t, int n) const
 bool mitk::Image::IsVolumeSet(int t, int n) const
 {
   if(IsValidVolume(t,n)==false) return false;
+
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+  return IsVolumeSetUnlocked(t,n);
+}
+
+bool mitk::Image::IsVolumeSetUnlocked(int t, int n) const
+{
   ImageDataItemPointer ch, vol;
 
   // volume directly available?
@@ -538,6 +589,13 @@ bool mitk::Image::IsVolumeSet(int t, int n) const
 bool mitk::Image::IsChannelSet(int n) const
 {
   if(IsValidChannel(n)==false) return false;
+
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+  return IsChannelSetUnlocked(n);
+}
+
+bool mitk::Image::IsChannelSetUnlocked(int n) const
+{
   ImageDataItemPointer ch, vol;
   ch=m_Channels[n];
   if((ch.GetPointer()!=NULL) && (ch->IsComplete()))
@@ -546,11 +604,35 @@ bool mitk::Image::IsChannelSet(int n) const
   // let's see if all volumes are set, so that we can (could) combine them to a channel
   unsigned int t;
   for(t=0;t<m_Dimensions[3];++t)
-    if(IsVolumeSet(t,n)==false)
+    if(IsValidVolume(t,n)==false || IsVolumeSetUnlocked(t,n)==false)
       return false;
   return true;
 }
 
+void mitk::Image::SetPreallocateChannel(bool preallocate)
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+  m_PreallocateChannel = preallocate;
+}
+
+bool mitk::Image::GetPreallocateChannel() const
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+  return m_PreallocateChannel;
+}
+
+size_t mitk::Image::GetNumberOfCopiedBytes() const
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+  return m_CopiedBytes;
+}
+
+size_t mitk::Image::GetNumberOfAliasedBytes() const
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+  return m_AliasedBytes;
+}
+
 bool mitk::Image::SetSlice(const void *data, int s, int t, int n)
 {
   // const_cast is no risk for ImportMemoryManagementType == CopyMemory
@@ -580,7 +662,10 @@ bool mitk::Image::SetImportSlice(void *data, int s, int t, int n, ImportMemoryMa
     sl=GetSliceData(s,t,n,data,importMemoryManagement);
     if(sl->GetManageMemory()==false)
     {
-      sl=AllocateSliceData(s,t,n,data,importMemoryManagement);
+      {
+        itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+        sl=AllocateSliceData(s,t,n,data,importMemoryManagement);
+      }
       if(sl.GetPointer()==NULL) return false;
     }
     if ( sl->GetData() != data )
@@ -591,7 +676,10 @@ bool mitk::Image::SetImportSlice(void *data, int s, int t, int n, ImportMemoryMa
   }
   else
   {
-    sl=AllocateSliceData(s,t,n,data,importMemoryManagement);
+    {
+      itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+      sl=AllocateSliceData(s,t,n,data,importMemoryManagement);
+    }
     if(sl.GetPointer()==NULL) return false;
     if ( sl->GetData() != data )
       std::memcpy(sl->GetData(), data, m_OffsetTable[2]*(ptypeSize));
@@ -612,7 +700,10 @@ bool mitk::Image::SetImportVolume(void *data, int t, int n, ImportMemoryManageme
     vol=GetVolumeData(t,n,data,importMemoryManagement);
     if(vol->GetManageMemory()==false)
     {
-      vol=AllocateVolumeData(t,n,data,importMemoryManagement);
+      {
+        itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+        vol=AllocateVolumeData(t,n,data,importMemoryManagement);
+      }
       if(vol.GetPointer()==NULL) return false;
     }
     if ( vol->GetData() != data )
@@ -624,7 +715,10 @@ bool mitk::Image::SetImportVolume(void *data, int t, int n, ImportMemoryManageme
   }
   else
   {
-    vol=AllocateVolumeData(t,n,data,importMemoryManagement);
+    {
+      itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+      vol=AllocateVolumeData(t,n,data,importMemoryManagement);
+    }
     if(vol.GetPointer()==NULL) return false;
     if ( vol->GetData() != data )
     {
@@ -652,7 +746,10 @@ bool mitk::Image::SetImportChannel(void *data, int n, ImportMemoryManagementType
     ch=GetChannelData(n,data,importMemoryManagement);
     if(ch->GetManageMemory()==false)
     {
-      ch=AllocateChannelData(n,data,importMemoryManagement);
+      {
+        itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+        ch=AllocateChannelData(n,data,importMemoryManagement);
+      }
       if(ch.GetPointer()==NULL) return false;
     }
     if ( ch->GetData() != data )
@@ -664,7 +761,10 @@ bool mitk::Image::SetImportChannel(void *data, int n, ImportMemoryManagementType
   }
   else
   {
-    ch=AllocateChannelData(n,data,importMemoryManagement);
+    {
+      itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+      ch=AllocateChannelData(n,data,importMemoryManagement);
+    }
     if(ch.GetPointer()==NULL) return false;
     if ( ch->GetData() != data )
       std::memcpy(ch->GetData(), data, m_OffsetTable[4]*(ptypeSize));
@@ -677,6 +777,28 @@ bool mitk::Image::SetImportChannel(void *data, int n, ImportMemoryManagementType
   return true;
 }
 
+bool mitk::Image::SetMappedChannel(MemoryMappedFile* file, int n)
+{
+  if(IsValidChannel(n)==false || file==NULL || file->GetData()==NULL)
+    return false;
+
+  const size_t ptypeSize = this->m_ImageDescriptor->GetChannelTypeById(n).GetSize();
+  if(file->GetSize() < m_OffsetTable[4]*ptypeSize)
+  {
+    MITK_WARN << "Mapped file " << file->GetFileName() << " is smaller than a channel of the image";
+    return false;
+  }
+
+  if(SetImportChannel(file->GetData(), n, ReferenceMemory)==false)
+    return false;
+
+  // if the channel already owned memory, the data has been copied and the file is not needed
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ImageDataItemsMutex);
+  if(m_Channels[n]->m_Data == file->GetData())
+    m_Channels[n]->m_MappedFile = file;
+  return true;
+}
+
 void mitk::Image::Initialize()
 {
   ImageDataItemPointerArray::iterator it, end;
@@ -1055,6 +1177,7 @@ mitk::Image::ImageDataItemPointer mitk::Image::AllocateSliceData(int s, int t, i
   {
     sl=new ImageDataItem(*vol, m_ImageDescriptor, 2, data, importMemoryManagement == ManageMemory, ((size_t) s)*m_OffsetTable[2]*(ptypeSize));
     sl->SetComplete(true);
+    m_AliasedBytes += m_OffsetTable[2]*ptypeSize;
     return m_Slices[pos]=sl;
   }
 
@@ -1064,6 +1187,7 @@ mitk::Image::ImageDataItemPointer mitk::Image::AllocateSliceData(int s, int t, i
   {
     sl=new ImageDataItem(*ch, m_ImageDescriptor, 2, data, importMemoryManagement == ManageMemory, (((size_t) s)*m_OffsetTable[2]+((size_t) t)*m_OffsetTable[3])*(ptypeSize));
     sl->SetComplete(true);
+    m_AliasedBytes += m_OffsetTable[2]*ptypeSize;
     return m_Slices[pos]=sl;
   }
 
@@ -1071,6 +1195,7 @@ mitk::Image::ImageDataItemPointer mitk::Image::AllocateSliceData(int s, int t, i
   m_Volumes[GetVolumeIndex(t,n)]=vol=AllocateVolumeData(t,n,NULL,importMemoryManagement);
   sl=new ImageDataItem(*vol, m_ImageDescriptor, 2, data, importMemoryManagement == ManageMemory, ((size_t) s)*m_OffsetTable[2]*(ptypeSize));
   sl->SetComplete(true);
+  m_AliasedBytes += m_OffsetTable[2]*ptypeSize;
   return m_Slices[pos]=sl;
 
   ////ALTERNATIVE:
@@ -1093,6 +1218,19 @@ mitk::Image::ImageDataItemPointer mitk::Image::AllocateVolumeData(int t, int n,
   if(ch.GetPointer()!=NULL)
   {
     vol=new ImageDataItem(*ch, m_ImageDescriptor, 3, data,importMemoryManagement == ManageMemory, (((size_t) t)*m_OffsetTable[3])*(ptypeSize));
+    m_AliasedBytes += m_OffsetTable[3]*ptypeSize;
+    return m_Volumes[pos]=vol;
+  }
+
+  // if all volumes are going to be set, allocate the whole channel at once (to keep
+  // data together!), so that the volumes do not need to be copied into a channel later
+  if(m_PreallocateChannel && importMemoryManagement == CopyMemory && m_Dimensions[3] > 1)
+  {
+    ch=AllocateChannelData(n,NULL,CopyMemory);
+    vol=new ImageDataItem(*ch, m_ImageDescriptor, 3, NULL, false, (((size_t) t)*m_OffsetTable[3])*(ptypeSize));
+    if(data != NULL)
+      std::memcpy(vol->GetData(), data, m_OffsetTable[3]*(ptypeSize));
+    m_AliasedBytes += m_OffsetTable[3]*ptypeSize;
     return m_Volumes[pos]=vol;
   }
 
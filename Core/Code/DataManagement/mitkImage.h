@@ -32,6 +32,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 //DEPRECATED
 #include <mitkTimeSlicedGeometry.h>
 
+#include <itkSimpleMutexLock.h>
+#include <itkConditionVariable.h>
+
 #ifndef __itkHistogram_h
 #include <itkHistogram.h>
 #endif
@@ -46,6 +49,8 @@ class ImageTimeSelector;
 
 class ImageStatisticsHolder;
 
+class MemoryMappedFile;
+
 //##Documentation
 //## @brief Image class for storing images
 //##
@@ -231,6 +236,16 @@ public:
   //## @sa SetPicChannel
   virtual bool SetImportChannel(void *data, int n = 0, ImportMemoryManagementType importMemoryManagement = CopyMemory );
 
+  //##Documentation
+  //## @brief Use the memory of @a file as channel @a n without copying or reading it.
+  //##
+  //## The operating system loads the pages of the file on first access, so only the
+  //## slices that are actually used occupy memory. The image keeps @a file mapped as long
+  //## as the channel exists. Since the mapping is copy-on-write, writing to the image
+  //## never changes the file. The mapped size must be at least the size of a channel.
+  //## @sa MemoryMappedFile
+  virtual bool SetMappedChannel(MemoryMappedFile* file, int n = 0);
+
   //##Documentation
   //## initialize new (or re-initialize) image information
   //## @warning Initialize() by pic assumes a plane, evenly spaced geometry starting at (0,0,0).
@@ -491,6 +506,29 @@ public:
   */
   virtual ImageDataItemPointer GetChannelData(int n = 0, void *data = NULL, ImportMemoryManagementType importMemoryManagement = CopyMemory);
 
+  /**
+  * \brief Number of bytes copied to assemble volumes or channels from separately allocated slices or volumes.
+  *
+  * Together with GetNumberOfAliasedBytes() this allows to check that slice and volume
+  * access does not duplicate image data. Both counters are accumulated over the lifetime of the image.
+  */
+  size_t GetNumberOfCopiedBytes() const;
+
+  /**
+  * \brief Number of bytes made accessible as slice, volume or channel views into existing buffers without copying.
+  */
+  size_t GetNumberOfAliasedBytes() const;
+
+  /**
+  * \brief Allocate the buffer of the whole channel together with the first volume of an image with several time steps.
+  *
+  * Enable this before all volumes are set one after another with SetVolume() or SetImportVolume(..., CopyMemory).
+  * The volumes are then views into the channel buffer, and GetChannelData() does not need to copy them.
+  * Off by default, so that setting a single volume only allocates the memory of that volume.
+  */
+  void SetPreallocateChannel(bool preallocate);
+  bool GetPreallocateChannel() const;
+
   /**
   \brief (DEPRECATED) Get the minimum for scalar images
   */
@@ -606,6 +644,27 @@ protected:
 
   virtual ImageDataItemPointer AllocateChannelData(int n = 0, void *data = NULL, ImportMemoryManagementType importMemoryManagement = CopyMemory);
 
+  //##Documentation
+  //## @brief Returns the slice if it exists or can be created as a view into an existing volume or channel, NULL otherwise.
+  //## Neither updates the source nor allocates memory. m_ImageDataItemsMutex must be locked by the caller.
+  ImageDataItemPointer LookupSliceData(int s, int t, int n, void *data, ImportMemoryManagementType importMemoryManagement);
+
+  //##Documentation
+  //## @brief Volume counterpart of LookupSliceData(). Combines the slices of the volume if all of them are set.
+  ImageDataItemPointer LookupVolumeData(int t, int n, void *data, ImportMemoryManagementType importMemoryManagement);
+
+  //##Documentation
+  //## @brief Channel counterpart of LookupSliceData(). Combines the volumes of the channel if all of them are set.
+  ImageDataItemPointer LookupChannelData(int n, void *data, ImportMemoryManagementType importMemoryManagement);
+
+  //##Documentation
+  //## @brief IsVolumeSet() for callers which already locked m_ImageDataItemsMutex
+  bool IsVolumeSetUnlocked(int t, int n) const;
+
+  //##Documentation
+  //## @brief IsChannelSet() for callers which already locked m_ImageDataItemsMutex
+  bool IsChannelSetUnlocked(int n) const;
+
   Image();
 
   Image(const Image &other);
@@ -623,6 +682,17 @@ protected:
   mutable ImageDataItemPointerArray m_Volumes;
   mutable ImageDataItemPointerArray m_Slices;
 
+  /** Guards the lazy creation of the items in m_Channels, m_Volumes and m_Slices, so that
+    * every slice, volume or channel view is created exactly once, even for concurrent requests */
+  mutable itk::SimpleFastMutexLock m_ImageDataItemsMutex;
+
+  /** Instrumentation, see GetNumberOfCopiedBytes() and GetNumberOfAliasedBytes() */
+  size_t m_CopiedBytes;
+  size_t m_AliasedBytes;
+
+  /** See SetPreallocateChannel() */
+  bool m_PreallocateChannel;
+
   unsigned int m_Dimension;
 
   unsigned int* m_Dimensions;
@@ -650,6 +720,16 @@ private:
   /** A mutex, which needs to be locked to manage m_VtkReaders */
   itk::SimpleFastMutexLock m_VtkReadersLock;
 
+  /** Number of existing ImageWriteAccessors, including those waiting for access. While it is zero,
+    * ImageReadAccessors register in m_FastReaders instead of locking m_ReadWriteLock */
+  AtomicInteger m_WriterCount;
+  /** Lock-free registry of ImageReadAccessors, see ImageAccessorBase::FastReaderSlot */
+  ImageAccessorBase::FastReaderSlot m_FastReaders[ImageAccessorBase::NumberOfFastReaderSlots];
+  /** A mutex, which write accessors lock while waiting for m_FastReaderReleased */
+  itk::SimpleMutexLock m_FastReadersMutex;
+  /** Signaled when an ImageReadAccessor leaves m_FastReaders while a writer exists */
+  itk::ConditionVariable::Pointer m_FastReaderReleased;
+
 };
 
  /**
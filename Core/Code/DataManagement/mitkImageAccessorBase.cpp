@@ -46,14 +46,12 @@ bool mitk::ImageAccessorBase::CompareThreadHandles(mitk::ImageAccessorBase::Thre
     // imageDataItem(iDI),
     m_SubRegion(NULL),
     m_Options(OptionFlags),
-    m_CoherentMemory(false)
+    m_CoherentMemory(false),
+    m_WaitLock(NULL),
+    m_FastReaderSlot(-1)
     {
       m_Thread = CurrentThreadHandle();
 
-      // Initialize WaitLock
-      m_WaitLock = new ImageAccessorWaitLock();
-      m_WaitLock->m_WaiterCount = 0;
-
       // Check validity of ImageAccessor
 
       // Is there an Image?
@@ -128,17 +126,7 @@ bool mitk::ImageAccessorBase::CompareThreadHandles(mitk::ImageAccessorBase::Thre
   {
     if(m_CoherentMemory)
     {
-      if((iAB->m_AddressBegin >= m_AddressBegin && iAB->m_AddressBegin <  m_AddressEnd) ||
-         (iAB->m_AddressEnd   >  m_AddressBegin && iAB->m_AddressEnd   <= m_AddressEnd))
-      {
-        return true;
-      }
-      if((m_AddressBegin >= iAB->m_AddressBegin && m_AddressBegin <  iAB->m_AddressEnd) ||
-         (m_AddressEnd   >  iAB->m_AddressBegin && m_AddressEnd   <= iAB->m_AddressEnd))
-      {
-        return true;
-      }
-
+      return Overlap(iAB->m_AddressBegin, iAB->m_AddressEnd);
     }
     else {
       m_Image->m_ReadWriteLock.Unlock();
@@ -148,6 +136,135 @@ bool mitk::ImageAccessorBase::CompareThreadHandles(mitk::ImageAccessorBase::Thre
     return false;
   }
 
+  bool mitk::ImageAccessorBase::Overlap(const void* addressBegin, const void* addressEnd) const
+  {
+    if((addressBegin >= m_AddressBegin && addressBegin <  m_AddressEnd) ||
+       (addressEnd   >  m_AddressBegin && addressEnd   <= m_AddressEnd))
+    {
+      return true;
+    }
+    if((m_AddressBegin >= addressBegin && m_AddressBegin <  addressEnd) ||
+       (m_AddressEnd   >  addressBegin && m_AddressEnd   <= addressEnd))
+    {
+      return true;
+    }
+    return false;
+  }
+
+  bool mitk::ImageAccessorBase::TryRegisterFastReader()
+  {
+    // Incoherent memory areas cannot be compared by the writers, use the locked list
+    if(!m_CoherentMemory || m_Image->m_WriterCount.Get() != 0)
+      return false;
+
+    for(int i = 0; i < NumberOfFastReaderSlots; ++i)
+    {
+      FastReaderSlot& slot = m_Image->m_FastReaders[i];
+
+      // claim a free slot
+      if(!slot.m_State.CompareAndSwap(FastReaderSlot::Free, FastReaderSlot::Claimed))
+        continue;
+
+      slot.m_AddressBegin = m_AddressBegin;
+      slot.m_AddressEnd = m_AddressEnd;
+      slot.m_Thread = m_Thread;
+
+      // publish the slot. Both operations are full barriers: either a concurrent writer sees
+      // the published slot or we see its increment of the writer count.
+      slot.m_State.CompareAndSwap(FastReaderSlot::Claimed, FastReaderSlot::Published);
+      if(m_Image->m_WriterCount.Get() == 0)
+      {
+        m_FastReaderSlot = i;
+        return true;
+      }
+
+      // a writer is coming up, step back and use the locked list
+      ReleaseFastReaderSlot(slot);
+      return false;
+    }
+
+    // all slots are in use
+    return false;
+  }
+
+  void mitk::ImageAccessorBase::UnregisterFastReader()
+  {
+    if(m_FastReaderSlot < 0)
+      return;
+
+    ReleaseFastReaderSlot(m_Image->m_FastReaders[m_FastReaderSlot]);
+    m_FastReaderSlot = -1;
+  }
+
+  void mitk::ImageAccessorBase::ReleaseFastReaderSlot(FastReaderSlot& slot)
+  {
+    slot.m_State.CompareAndSwap(FastReaderSlot::Published, FastReaderSlot::Free);
+
+    // Wake up waiting writers. The compare-and-swap and the increment of the writer count are
+    // full barriers, so either the writer finds the slot free or we see the writer. Signaling
+    // under the mutex cannot get lost, as writers check the slots and wait under the mutex.
+    if(m_Image->m_WriterCount.Get() != 0)
+    {
+      m_Image->m_FastReadersMutex.Lock();
+      m_Image->m_FastReaderReleased->Broadcast();
+      m_Image->m_FastReadersMutex.Unlock();
+    }
+  }
+
+  void mitk::ImageAccessorBase::WaitForFastReaders()
+  {
+    m_Image->m_FastReadersMutex.Lock();
+
+    for(int i = 0; i < NumberOfFastReaderSlots; ++i)
+    {
+      FastReaderSlot& slot = m_Image->m_FastReaders[i];
+
+      for(;;)
+      {
+        long state = slot.m_State.Get();
+
+        if(state == FastReaderSlot::Free)
+          break;
+
+        if(state == FastReaderSlot::Published)
+        {
+          const void* begin = slot.m_AddressBegin;
+          const void* end = slot.m_AddressEnd;
+          #ifdef MITK_USE_RECURSIVE_MUTEX_PREVENTION
+          ThreadIDType thread = slot.m_Thread;
+          #endif
+
+          // the reader released the slot while we were looking at it
+          if(slot.m_State.Get() != FastReaderSlot::Published)
+            continue;
+
+          if(!Overlap(begin, end))
+            break;
+
+          #ifdef MITK_USE_RECURSIVE_MUTEX_PREVENTION
+          if(CompareThreadHandles(CurrentThreadHandle(), thread))
+          {
+            m_Image->m_FastReadersMutex.Unlock();
+            mitkThrow() << "Prohibited image access: the requested image part is already in use and cannot be requested recursively!";
+          }
+          #endif
+
+          if(m_Options & ExceptionIfLocked)
+          {
+            m_Image->m_FastReadersMutex.Unlock();
+            mitkThrowException(mitk::MemoryIsLockedException) << "The image part being ordered by the ImageAccessor is already in use and locked";
+          }
+        }
+
+        // either an overlapping reader is active or a reader is just about to notice
+        // the writer and step back to the locked list, both release the slot
+        m_Image->m_FastReaderReleased->Wait(&m_Image->m_FastReadersMutex);
+      }
+    }
+
+    m_Image->m_FastReadersMutex.Unlock();
+  }
+
   /** \brief Uses the WaitLock to wait for another ImageAccessor*/
   void mitk::ImageAccessorBase::WaitForReleaseOf(ImageAccessorWaitLock* wL) {
     wL->m_Mutex.Lock();
@@ -24,6 +24,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkMultiThreader.h>
 
 #include "mitkImageDataItem.h"
+#include "mitkAtomicInteger.h"
 
 namespace mitk {
 
@@ -77,6 +78,11 @@ public:
     IgnoreLock = 4
   };
 
+  /** \brief Number of read accessors per image which can be registered without locking m_ReadWriteLock.
+    * Further concurrent readers fall back to the locked reader list.
+    */
+  enum { NumberOfFastReaderSlots = 32 };
+
   virtual ~ImageAccessorBase()
   {
   }
@@ -96,6 +102,23 @@ typedef DWORD ThreadIDType;
 typedef pthread_t ThreadIDType;
 #endif
 
+  /** \brief Lock-free registration of a read accessor in mitk::Image.
+    *
+    * m_State is one of Free, Claimed (a reader is setting the address range) and Published.
+    * Only the reader owning the slot changes it, always by compare-and-swap: Free to Claimed,
+    * Claimed to Published and Published back to Free. A writer reads the address range of a
+    * published slot and accepts it only if the slot is still published afterwards. If the
+    * slot was reused meanwhile, the new reader registered after the writer and steps back
+    * to the locked list without accessing the image, so its address range does not matter.
+    */
+  struct FastReaderSlot {
+    enum { Free = 0, Claimed = 1, Published = 2 };
+    AtomicInteger m_State;
+    const void* volatile m_AddressBegin;
+    const void* volatile m_AddressEnd;
+    ThreadIDType m_Thread;
+  };
+
   /** \brief Checks validity of given parameters from inheriting classes and stores those parameters in member variables. */
   ImageAccessorBase(
       ImagePointer iP,
@@ -123,9 +146,24 @@ typedef pthread_t ThreadIDType;
   /** Defines if the accessed image part lies coherently in memory */
   bool m_CoherentMemory;
 
-  /** \brief Pointer to a WaitLock struct, that allows other ImageAccessors to wait for this ImageAccessor */
+  /** \brief Pointer to a WaitLock struct, that allows other ImageAccessors to wait for this ImageAccessor.
+    * Only allocated when the accessor is registered in the locked reader or writer list of the image.
+    */
   ImageAccessorWaitLock* m_WaitLock;
 
+  /** \brief Index of the fast reader slot in mitk::Image occupied by this accessor, -1 if none */
+  int m_FastReaderSlot;
+
+  /** \brief Allocates m_WaitLock, if this has not been done yet. */
+  inline void InitializeWaitLock()
+  {
+    if(m_WaitLock == NULL)
+    {
+      m_WaitLock = new ImageAccessorWaitLock();
+      m_WaitLock->m_WaiterCount = 0;
+    }
+  }
+
   /** \brief Increments m_WaiterCount. A call of this method is prohibited unless the Mutex m_ReadWriteLock in the mitk::Image class is Locked. */
   inline void Increment()
   {
@@ -137,6 +175,27 @@ typedef pthread_t ThreadIDType;
     */
   bool Overlap(const ImageAccessorBase* iAB);
 
+  /** \brief Computes if the image part of this ImageAccessor overlaps the memory area [addressBegin, addressEnd) */
+  bool Overlap(const void* addressBegin, const void* addressEnd) const;
+
+  /** \brief Tries to register this read accessor in a free fast reader slot of the image.
+    * Succeeds only if no write accessor exists or is being created, otherwise the locked reader list has to be used.
+    */
+  bool TryRegisterFastReader();
+
+  /** \brief Releases the fast reader slot occupied by this accessor. */
+  void UnregisterFastReader();
+
+  /** \brief Sets the given published slot free and wakes up write accessors waiting in WaitForFastReaders(). */
+  void ReleaseFastReaderSlot(FastReaderSlot& slot);
+
+  /** \brief Waits until no read accessor registered in a fast reader slot overlaps the image part of this accessor.
+    * Must only be called by write accessors after incrementing the writer count of the image.
+    * \throws mitk::MemoryIsLockedException if an overlapping reader exists and ExceptionIfLocked is set
+    * \throws mitk::Exception if the overlapping reader belongs to the calling thread
+    */
+  void WaitForFastReaders();
+
   /** \brief Uses the WaitLock to wait for another ImageAccessor*/
   void WaitForReleaseOf(ImageAccessorWaitLock* wL);
 
@@ -163,6 +163,9 @@ namespace mitk {
 
     unsigned long m_Size;
 
+    //## Keeps a MemoryMappedFile alive, if m_Data points into a mapped file (see Image::SetMappedChannel)
+    itk::LightObject::Pointer m_MappedFile;
+
   private:
     void ComputeItemSize( const unsigned int* dimensions, unsigned int dimension);
 
@@ -56,7 +56,11 @@ public:
   {
     if(!(OptionFlags & ImageAccessorBase::IgnoreLock))
     {
-      OrganizeReadAccess();
+      // As long as no writer exists, readers do not need to lock anything
+      if(!TryRegisterFastReader())
+      {
+        OrganizeReadAccess();
+      }
     }
   }
 
@@ -73,6 +77,12 @@ public:
     {
       // Future work: In case of non-coherent memory, copied area needs to be deleted
 
+      if(m_FastReaderSlot >= 0)
+      {
+        UnregisterFastReader();
+        return;
+      }
+
       m_Image->m_ReadWriteLock.Lock();
 
       // delete self from list of ImageReadAccessors in Image
@@ -103,6 +113,8 @@ private:
   /** \brief manages a consistent read access and locks the ordered image part */
   void OrganizeReadAccess()
   {
+    InitializeWaitLock();
+
     m_Image->m_ReadWriteLock.Lock();
 
     // Check, if there is any Write-Access going on
@@ -19,7 +19,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 //#include "mitkImageTimeSelector.h"
 
 mitk::ImageStatisticsHolder::ImageStatisticsHolder( mitk::Image* image)
-  : m_Image(image)/*, m_TimeSelectorForExtremaObject(NULL)*/
+  : m_Image(image)/*, m_TimeSelectorForExtremaObject(NULL)*/,
+    m_ExtremaImageMTime(0),
+    m_HistogramImageMTime(0)
 {
   m_CountOfMinValuedVoxels.resize(1, 0);
   m_CountOfMaxValuedVoxels.resize(1, 0);
@@ -46,18 +48,38 @@ mitk::ImageStatisticsHolder::~ImageStatisticsHolder()
 
 const mitk::ImageStatisticsHolder::HistogramType* mitk::ImageStatisticsHolder::GetScalarHistogram(int t)
 {
-  mitk::ImageTimeSelector* timeSelector = this->GetTimeSelector();
-  if(timeSelector!=NULL)
+  if(!m_Image->IsValidTimeStep(t))
+    return NULL;
+
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ComputationMutex);
+
+  if (m_HistogramImageMTime == 0 || m_HistogramImageMTime != m_Image->GetMTime())
   {
+    m_Histograms.clear();
+  }
+  if (m_Histograms.size() < m_Image->GetTimeSteps())
+  {
+    m_Histograms.resize(m_Image->GetTimeSteps());
+  }
+
+  if (m_Histograms[t].IsNull())
+  {
+    mitk::ImageTimeSelector::Pointer timeSelector = this->GetTimeSelector();
+    if(timeSelector.IsNull())
+      return NULL;
+
     timeSelector->SetTimeNr(t);
     timeSelector->UpdateLargestPossibleRegion();
 
     mitk::HistogramGenerator* generator = static_cast<mitk::HistogramGenerator*>(m_HistogramGeneratorObject.GetPointer());
     generator->SetImage(timeSelector->GetOutput());
     generator->ComputeHistogram();
-    return static_cast<const mitk::ImageStatisticsHolder::HistogramType*>(generator->GetHistogram());
+    m_Histograms[t] = static_cast<const mitk::ImageStatisticsHolder::HistogramType*>(generator->GetHistogram());
+
+    // taken after the computation, updating the time selector may touch the image
+    m_HistogramImageMTime = m_Image->GetMTime();
   }
-  return NULL;
+  return m_Histograms[t];
 }
 
 bool mitk::ImageStatisticsHolder::IsValidTimeStep( int t) const
@@ -109,88 +131,184 @@ void mitk::ImageStatisticsHolder::ResetImageStatistics()
 
 #include "mitkImageAccessByItk.h"
 
-//#define BOUNDINGOBJECT_IGNORE
+#include <itkMultiThreader.h>
+#include <itkMutexLockHolder.h>
 
-template < typename ItkImageType >
-void mitk::_ComputeExtremaInItkImage( const ItkImageType* itkImage, mitk::ImageStatisticsHolder* statisticsHolder, int t)
+#include <algorithm>
+
+namespace
 {
-  typename ItkImageType::RegionType region;
-  region = itkImage->GetBufferedRegion();
-  if(region.Crop(itkImage->GetRequestedRegion()) == false) return;
-  if(region != itkImage->GetRequestedRegion()) return;
+  /** \brief Extrema of a part of the image, merged into the result of the whole image */
+  struct ExtremaResult
+  {
+    ExtremaResult()
+      : Min(itk::NumericTraits<mitk::ScalarType>::max()), SecondMin(itk::NumericTraits<mitk::ScalarType>::max()),
+        Max(itk::NumericTraits<mitk::ScalarType>::NonpositiveMin()), SecondMax(itk::NumericTraits<mitk::ScalarType>::NonpositiveMin()),
+        CountOfMin(0), CountOfMax(0)
+    {
+    }
 
-  itk::ImageRegionConstIterator<ItkImageType> it(itkImage, region);
-  typedef typename ItkImageType::PixelType TPixel;
-  TPixel value = 0;
+    mitk::ScalarType Min;
+    mitk::ScalarType SecondMin;
+    mitk::ScalarType Max;
+    mitk::ScalarType SecondMax;
+    unsigned int CountOfMin;
+    unsigned int CountOfMax;
+  };
+
+  // The second extrema are the closest values that differ from the extrema,
+  // so merging only has to consider the extrema of both parts.
+  void MergeExtrema(ExtremaResult& result, const ExtremaResult& part)
+  {
+    if (part.Min < result.Min)
+    {
+      result.SecondMin = std::min(result.Min, part.SecondMin);
+      result.Min = part.Min;
+      result.CountOfMin = part.CountOfMin;
+    }
+    else if (part.Min == result.Min)
+    {
+      result.SecondMin = std::min(result.SecondMin, part.SecondMin);
+      result.CountOfMin += part.CountOfMin;
+    }
+    else
+    {
+      result.SecondMin = std::min(result.SecondMin, part.Min);
+    }
 
-  if ( statisticsHolder == NULL || !statisticsHolder->IsValidTimeStep( t ) ) return;
-  statisticsHolder->Expand(t+1); // make sure we have initialized all arrays
-  statisticsHolder->m_CountOfMinValuedVoxels[t] = 0;
-  statisticsHolder->m_CountOfMaxValuedVoxels[t] = 0;
+    if (part.Max > result.Max)
+    {
+      result.SecondMax = std::max(result.Max, part.SecondMax);
+      result.Max = part.Max;
+      result.CountOfMax = part.CountOfMax;
+    }
+    else if (part.Max == result.Max)
+    {
+      result.SecondMax = std::max(result.SecondMax, part.SecondMax);
+      result.CountOfMax += part.CountOfMax;
+    }
+    else
+    {
+      result.SecondMax = std::max(result.SecondMax, part.Max);
+    }
+  }
 
-  statisticsHolder->m_Scalar2ndMin[t]=
-      statisticsHolder->m_ScalarMin[t] = itk::NumericTraits<ScalarType>::max();
-  statisticsHolder->m_Scalar2ndMax[t]=
-      statisticsHolder->m_ScalarMax[t] = itk::NumericTraits<ScalarType>::NonpositiveMin();
+  template < typename ItkImageType >
+  struct ExtremaThreadData
+  {
+    const ItkImageType* Image;
+    typename ItkImageType::RegionType Region;
+    std::vector<ExtremaResult> Parts;
+  };
 
-  while( !it.IsAtEnd() )
+  template < typename ItkImageType >
+  ITK_THREAD_RETURN_TYPE ComputeExtremaThread(void* arg)
   {
-    value = it.Get();
-    //  if ( (value > mitkImage->m_ScalarMin) && (value < mitkImage->m_Scalar2ndMin) )        mitkImage->m_Scalar2ndMin = value;
-    //  else if ( (value < mitkImage->m_ScalarMax) && (value > mitkImage->m_Scalar2ndMax) )   mitkImage->m_Scalar2ndMax = value;
-    //  else if (value > mitkImage->m_ScalarMax)                                              mitkImage->m_ScalarMax = value;
-    //  else if (value < mitkImage->m_ScalarMin)                                              mitkImage->m_ScalarMin = value;
-
-    // if numbers start with 2ndMin or 2ndMax and never have that value again, the previous above logic failed
-#ifdef BOUNDINGOBJECT_IGNORE
-    if( value > -32765)
+    itk::MultiThreader::ThreadInfoStruct* info = static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+    ExtremaThreadData<ItkImageType>* data = static_cast<ExtremaThreadData<ItkImageType>*>(info->UserData);
+
+    // split along the slowest dimension, each thread gets a slab of consecutive memory
+    const unsigned int splitAxis = ItkImageType::ImageDimension - 1;
+    typename ItkImageType::RegionType region = data->Region;
+    const itk::SizeValueType extent = region.GetSize(splitAxis);
+    const itk::SizeValueType chunk = (extent + info->NumberOfThreads - 1) / info->NumberOfThreads;
+    const itk::SizeValueType begin = std::min<itk::SizeValueType>(extent, chunk * info->ThreadID);
+    const itk::SizeValueType end = std::min<itk::SizeValueType>(extent, begin + chunk);
+    if (begin == end)
+      return ITK_THREAD_RETURN_VALUE;
+
+    region.SetIndex(splitAxis, region.GetIndex(splitAxis) + begin);
+    region.SetSize(splitAxis, end - begin);
+
+    // accumulate in locals, the partial results of neighboring threads share cache lines
+    ExtremaResult result;
+    itk::ImageRegionConstIterator<ItkImageType> it(data->Image, region);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
     {
-#endif
+      const mitk::ScalarType value = it.Get();
+
       // update min
-      if ( value < statisticsHolder->m_ScalarMin[t] )
+      if ( value < result.Min )
       {
-        statisticsHolder->m_Scalar2ndMin[t] =
-            statisticsHolder->m_ScalarMin[t];    statisticsHolder->m_ScalarMin[t] = value;
-        statisticsHolder->m_CountOfMinValuedVoxels[t] = 1;
+        result.SecondMin = result.Min;
+        result.Min = value;
+        result.CountOfMin = 1;
       }
-      else if ( value == statisticsHolder->m_ScalarMin[t] )
+      else if ( value == result.Min )
       {
-        ++statisticsHolder->m_CountOfMinValuedVoxels[t];
+        ++result.CountOfMin;
       }
-      else if ( value < statisticsHolder->m_Scalar2ndMin[t] )
+      else if ( value < result.SecondMin )
       {
-        statisticsHolder->m_Scalar2ndMin[t] = value;
+        result.SecondMin = value;
       }
 
       // update max
-      if ( value > statisticsHolder->m_ScalarMax[t] )
+      if ( value > result.Max )
       {
-        statisticsHolder->m_Scalar2ndMax[t] =
-            statisticsHolder->m_ScalarMax[t];    statisticsHolder->m_ScalarMax[t] = value;
-        statisticsHolder->m_CountOfMaxValuedVoxels[t] = 1;
+        result.SecondMax = result.Max;
+        result.Max = value;
+        result.CountOfMax = 1;
       }
-      else if ( value == statisticsHolder->m_ScalarMax[t] )
+      else if ( value == result.Max )
       {
-        ++statisticsHolder->m_CountOfMaxValuedVoxels[t];
+        ++result.CountOfMax;
       }
-      else if ( value > statisticsHolder->m_Scalar2ndMax[t] )
+      else if ( value > result.SecondMax )
       {
-        statisticsHolder->m_Scalar2ndMax[t] = value;
+        result.SecondMax = value;
       }
-#ifdef BOUNDINGOBJECT_IGNORE
     }
-#endif
 
-    ++it;
+    data->Parts[info->ThreadID] = result;
+    return ITK_THREAD_RETURN_VALUE;
   }
+}
+
+template < typename ItkImageType >
+void mitk::_ComputeExtremaInItkImage( const ItkImageType* itkImage, mitk::ImageStatisticsHolder* statisticsHolder, int t)
+{
+  typename ItkImageType::RegionType region;
+  region = itkImage->GetBufferedRegion();
+  if(region.Crop(itkImage->GetRequestedRegion()) == false) return;
+  if(region != itkImage->GetRequestedRegion()) return;
+
+  if ( statisticsHolder == NULL || !statisticsHolder->IsValidTimeStep( t ) ) return;
+  statisticsHolder->Expand(t+1); // make sure we have initialized all arrays
+
+  ExtremaThreadData<ItkImageType> data;
+  data.Image = itkImage;
+  data.Region = region;
+
+  const itk::SizeValueType extent = region.GetSize(ItkImageType::ImageDimension - 1);
+  int numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  if (extent < static_cast<itk::SizeValueType>(numberOfThreads))
+    numberOfThreads = static_cast<int>(std::max<itk::SizeValueType>(extent, 1));
+  data.Parts.resize(numberOfThreads);
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ComputeExtremaThread<ItkImageType>, &data);
+  threader->SingleMethodExecute();
+
+  ExtremaResult result;
+  for (std::vector<ExtremaResult>::const_iterator part = data.Parts.begin(); part != data.Parts.end(); ++part)
+  {
+    MergeExtrema(result, *part);
+  }
+
+  statisticsHolder->m_ScalarMin[t] = result.Min;
+  statisticsHolder->m_Scalar2ndMin[t] = result.SecondMin;
+  statisticsHolder->m_ScalarMax[t] = result.Max;
+  statisticsHolder->m_Scalar2ndMax[t] = result.SecondMax;
+  statisticsHolder->m_CountOfMinValuedVoxels[t] = result.CountOfMin;
+  statisticsHolder->m_CountOfMaxValuedVoxels[t] = result.CountOfMax;
 
   //// guard for wrong 2dMin/Max on single constant value images
   if (statisticsHolder->m_ScalarMax[t] == statisticsHolder->m_ScalarMin[t])
   {
     statisticsHolder->m_Scalar2ndMax[t] = statisticsHolder->m_Scalar2ndMin[t] = statisticsHolder->m_ScalarMax[t];
   }
-  statisticsHolder->m_LastRecomputeTimeStamp.Modified();
-  //MITK_DEBUG <<"extrema "<<itk::NumericTraits<TPixel>::NonpositiveMin()<<" "<<mitkImage->m_ScalarMin<<" "<<mitkImage->m_Scalar2ndMin<<" "<<mitkImage->m_Scalar2ndMax<<" "<<mitkImage->m_ScalarMax<<" "<<itk::NumericTraits<TPixel>::max();
 }
 
 void mitk::ImageStatisticsHolder::ComputeImageStatistics(int t)
@@ -198,36 +316,44 @@ void mitk::ImageStatisticsHolder::ComputeImageStatistics(int t)
   // timestep valid?
   if (!m_Image->IsValidTimeStep(t)) return;
 
-  // image modified?
-  if (this->m_Image->GetMTime() > m_LastRecomputeTimeStamp.GetMTime())
-    this->ResetImageStatistics();
-
-  Expand(t+1);
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_ComputationMutex);
 
   // do we have valid information already?
-  if( m_ScalarMin[t] != itk::NumericTraits<ScalarType>::max() ||
-      m_Scalar2ndMin[t] != itk::NumericTraits<ScalarType>::max() ) return; // Values already calculated before...
+  if (m_ExtremaImageMTime != 0 && m_ExtremaImageMTime == m_Image->GetMTime() &&
+      static_cast<unsigned int>(t) < m_ScalarMin.size())
+    return;
+
+  // the image is new or modified, compute all time steps in one go
+  this->ResetImageStatistics();
+  const unsigned int timeSteps = m_Image->GetTimeSteps();
+  Expand(timeSteps);
 
   const mitk::PixelType pType = m_Image->GetPixelType(0);
-  if(pType.GetNumberOfComponents() == 1)
+  for (unsigned int timeStep = 0; timeStep < timeSteps; ++timeStep)
   {
-    // recompute
-    mitk::ImageTimeSelector::Pointer timeSelector = this->GetTimeSelector();
-    if(timeSelector.IsNotNull())
+    if(pType.GetNumberOfComponents() == 1)
     {
-      timeSelector->SetTimeNr(t);
-      timeSelector->UpdateLargestPossibleRegion();
-      mitk::Image* image = timeSelector->GetOutput();
-      AccessByItk_2( image, _ComputeExtremaInItkImage, this, t );
+      // recompute
+      mitk::ImageTimeSelector::Pointer timeSelector = this->GetTimeSelector();
+      if(timeSelector.IsNotNull())
+      {
+        timeSelector->SetTimeNr(timeStep);
+        timeSelector->UpdateLargestPossibleRegion();
+        mitk::Image* image = timeSelector->GetOutput();
+        AccessByItk_2( image, _ComputeExtremaInItkImage, this, timeStep );
+      }
+    }
+    else if(pType.GetNumberOfComponents() > 1)
+    {
+      m_ScalarMin[timeStep] = 0;
+      m_ScalarMax[timeStep] = 255;
+      m_Scalar2ndMin[timeStep] = 0;
+      m_Scalar2ndMax[timeStep] = 255;
     }
   }
-  else if(pType.GetNumberOfComponents() > 1)
-  {
-    m_ScalarMin[t] = 0;
-    m_ScalarMax[t] = 255;
-    m_Scalar2ndMin[t] = 0;
-    m_Scalar2ndMax[t] = 255;
-  }
+
+  // taken after the computation, updating the time selector may touch the image
+  m_ExtremaImageMTime = m_Image->GetMTime();
 }
 
 
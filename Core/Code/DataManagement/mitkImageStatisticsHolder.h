@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #ifndef __itkHistogram_h
 #include <itkHistogram.h>
 #endif
+#include <itkSimpleFastMutexLock.h>
 
 namespace mitk
 {
@@ -35,6 +36,9 @@ namespace mitk
 
   Each mitk::Image holds a normal pointer to its StatisticsHolder object. To get access to the methods, use the GetStatistics() method
   in mitk::Image class.
+
+  The extrema of all time steps are computed in one multi-threaded pass when any of them is requested first. Extrema and
+  histograms are cached and only recomputed when the modification time of the image changes.
   */
 class MITK_CORE_EXPORT ImageStatisticsHolder
 {
@@ -47,6 +51,8 @@ public:
 
     typedef itk::Statistics::Histogram<double> HistogramType;
 
+    //##Documentation
+    //## \brief Get the histogram of time step \a t. The histogram is cached until the image is modified.
     virtual const HistogramType* GetScalarHistogram(int t=0);
 
     //##Documentation
@@ -136,6 +142,8 @@ protected:
 
       virtual void ResetImageStatistics();
 
+      //##Documentation
+      //## \brief Computes the extrema of all time steps if the cached values of time step \a t are outdated
       virtual void ComputeImageStatistics(int t=0);
 
       virtual void Expand( unsigned int timeSteps );
@@ -154,7 +162,15 @@ protected:
       mutable std::vector<ScalarType> m_Scalar2ndMin;
       mutable std::vector<ScalarType> m_Scalar2ndMax;
 
-      itk::TimeStamp m_LastRecomputeTimeStamp;
+      mutable std::vector<HistogramType::ConstPointer> m_Histograms;
+
+      /** \brief Image modification time the cached extrema belong to (0 if nothing is cached) */
+      unsigned long m_ExtremaImageMTime;
+      /** \brief Image modification time the cached histograms belong to (0 if nothing is cached) */
+      unsigned long m_HistogramImageMTime;
+
+      /** \brief Serializes the computation of extrema and histograms */
+      itk::SimpleFastMutexLock m_ComputationMutex;
 
 };
 
@@ -44,7 +44,18 @@ public:
     ImageAccessorBase(iP , iDI, OptionFlags)
 
   {
-    OrganizeWriteAccess();
+    // Divert new readers to the locked list, then wait for the remaining lock-free readers
+    m_Image->m_WriterCount.Increment();
+    try
+    {
+      WaitForFastReaders();
+      OrganizeWriteAccess();
+    }
+    catch(...)
+    {
+      m_Image->m_WriterCount.Decrement();
+      throw;
+    }
   }
 
 /** \brief Gives full data access. */
@@ -77,6 +88,8 @@ public:
     }
 
     m_Image->m_ReadWriteLock.Unlock();
+
+    m_Image->m_WriterCount.Decrement();
   }
 
 private:
@@ -84,6 +97,8 @@ private:
   /** \brief manages a consistent write access and locks the ordered image part */
   void OrganizeWriteAccess()
   {
+    InitializeWaitLock();
+
     m_Image->m_ReadWriteLock.Lock();
 
     bool readOverlap = false;
@@ -31,10 +31,258 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <gdcmUIDs.h>
 
 #include "mitkProperties.h"
+#include "mitkAtomicInteger.h"
+
+#include <itkMultiThreader.h>
+
+#include <algorithm>
+
+namespace
+{
+  // smaller chunks do not pay off the thread start
+  unsigned int MinimumNumberOfFilesPerScanThread = 16;
+
+  unsigned int NumberOfScanThreads = 0;
+
+  unsigned int ResolveNumberOfThreads(unsigned int requested, unsigned int numberOfWorkItems, unsigned int minimumItemsPerThread)
+  {
+    unsigned int numberOfThreads = requested > 0 ? requested : static_cast<unsigned int>(itk::MultiThreader::GetGlobalDefaultNumberOfThreads());
+    numberOfThreads = std::min(numberOfThreads, numberOfWorkItems / std::max(1u, minimumItemsPerThread));
+    return std::max(1u, numberOfThreads);
+  }
+
+  struct ScanThreadData
+  {
+    const mitk::DicomSeriesReader::StringContainer* Files;
+    std::vector<gdcm::Scanner*>* Scanners;
+    std::vector<int> Successful; // no std::vector<bool>, threads write concurrently
+  };
+
+  ITK_THREAD_RETURN_TYPE ScanThread(void* arg)
+  {
+    itk::MultiThreader::ThreadInfoStruct* info = static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+    ScanThreadData* data = static_cast<ScanThreadData*>(info->UserData);
+    const unsigned int threadId = info->ThreadID;
+    const unsigned int numberOfThreads = info->NumberOfThreads;
+
+    // contiguous chunks keep the files of one directory (and series) together
+    const std::size_t numberOfFiles = data->Files->size();
+    const std::size_t begin = numberOfFiles * threadId / numberOfThreads;
+    const std::size_t end = numberOfFiles * (threadId + 1) / numberOfThreads;
+
+    mitk::DicomSeriesReader::StringContainer chunk(data->Files->begin() + begin, data->Files->begin() + end);
+    try
+    {
+      data->Successful[threadId] = chunk.empty() || (*data->Scanners)[threadId]->Scan(chunk);
+    }
+    catch (...)
+    {
+      data->Successful[threadId] = 0;
+    }
+
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  struct SortThreadData
+  {
+    typedef mitk::DicomSeriesReader::StringContainer (*SortFunction)(const mitk::DicomSeriesReader::StringContainer&);
+
+    SortFunction Sort;
+    std::vector<mitk::DicomSeriesReader::StringContainer> Groups;
+    std::vector<int> Successful;
+    mitk::AtomicInteger NextGroup;
+  };
+
+  ITK_THREAD_RETURN_TYPE SortThread(void* arg)
+  {
+    itk::MultiThreader::ThreadInfoStruct* info = static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+    SortThreadData* data = static_cast<SortThreadData*>(info->UserData);
+
+    // group sizes vary a lot (localizers vs. volumes), so groups are handed out one by one
+    const long numberOfGroups = static_cast<long>(data->Groups.size());
+    for (long group = data->NextGroup.Increment() - 1; group < numberOfGroups; group = data->NextGroup.Increment() - 1)
+    {
+      try
+      {
+        data->Groups[group] = data->Sort(data->Groups[group]);
+        data->Successful[group] = 1;
+      }
+      catch (...)
+      {
+        data->Successful[group] = 0;
+      }
+    }
+
+    return ITK_THREAD_RETURN_VALUE;
+  }
+}
 
 namespace mitk
 {
 
+DicomSeriesReader::ParallelScanner::ParallelScanner()
+{
+}
+
+DicomSeriesReader::ParallelScanner::~ParallelScanner()
+{
+  this->Clear();
+}
+
+void
+DicomSeriesReader::ParallelScanner::Clear()
+{
+  m_Mappings.clear();
+  for (std::vector<gdcm::Scanner*>::iterator iter = m_Scanners.begin(); iter != m_Scanners.end(); ++iter)
+  {
+    delete *iter;
+  }
+  m_Scanners.clear();
+}
+
+void
+DicomSeriesReader::ParallelScanner::AddTag(const gdcm::Tag& tag)
+{
+  m_Tags.push_back(tag);
+}
+
+bool
+DicomSeriesReader::ParallelScanner::Scan(const StringContainer& files, unsigned int numberOfThreads)
+{
+  this->Clear();
+
+  numberOfThreads = ResolveNumberOfThreads(numberOfThreads, files.size(), MinimumNumberOfFilesPerScanThread);
+
+  for (unsigned int i = 0; i < numberOfThreads; ++i)
+  {
+    gdcm::Scanner* scanner = new gdcm::Scanner;
+    for (std::vector<gdcm::Tag>::const_iterator tagIter = m_Tags.begin(); tagIter != m_Tags.end(); ++tagIter)
+    {
+      scanner->AddTag(*tagIter);
+    }
+    m_Scanners.push_back(scanner);
+  }
+
+  ScanThreadData data;
+  data.Files = &files;
+  data.Scanners = &m_Scanners;
+  data.Successful.resize(numberOfThreads, 1);
+
+  if (numberOfThreads == 1)
+  {
+    data.Successful[0] = m_Scanners[0]->Scan(files);
+  }
+  else
+  {
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(ScanThread, &data);
+    threader->SingleMethodExecute();
+  }
+
+  bool successful = true;
+  for (unsigned int i = 0; i < numberOfThreads; ++i)
+  {
+    successful = successful && data.Successful[i] != 0;
+
+    // keys are compared by content, so the merged map is ordered exactly like a single scanner's map
+    const gdcm::Scanner::MappingType& mappings = m_Scanners[i]->GetMappings();
+    m_Mappings.insert(mappings.begin(), mappings.end());
+  }
+
+  return successful;
+}
+
+const gdcm::Scanner::MappingType&
+DicomSeriesReader::ParallelScanner::GetMappings() const
+{
+  return m_Mappings;
+}
+
+const char*
+DicomSeriesReader::ParallelScanner::GetValue(const char* filename, const gdcm::Tag& tag) const
+{
+  gdcm::Scanner::MappingType::const_iterator fileIter = m_Mappings.find(filename);
+  if (fileIter == m_Mappings.end())
+  {
+    return NULL;
+  }
+
+  gdcm::Scanner::TagToValue::const_iterator tagIter = fileIter->second.find(tag);
+  if (tagIter == fileIter->second.end())
+  {
+    return NULL;
+  }
+
+  return tagIter->second;
+}
+
+void
+DicomSeriesReader::SetNumberOfScanThreads(unsigned int numberOfThreads)
+{
+  NumberOfScanThreads = numberOfThreads;
+}
+
+unsigned int
+DicomSeriesReader::GetNumberOfScanThreads()
+{
+  return NumberOfScanThreads;
+}
+
+void
+DicomSeriesReader::SetMinimumNumberOfFilesPerScanThread(unsigned int numberOfFiles)
+{
+  MinimumNumberOfFilesPerScanThread = std::max(1u, numberOfFiles);
+}
+
+unsigned int
+DicomSeriesReader::GetMinimumNumberOfFilesPerScanThread()
+{
+  return MinimumNumberOfFilesPerScanThread;
+}
+
+void
+DicomSeriesReader::SortSeriesSlicesOfGroups(FileNamesGrouping& groups, unsigned int numberOfThreads)
+{
+  SortThreadData data;
+  data.Sort = &DicomSeriesReader::SortSeriesSlices;
+  for (FileNamesGrouping::const_iterator groupIter = groups.begin(); groupIter != groups.end(); ++groupIter)
+  {
+    data.Groups.push_back( groupIter->second.GetFilenames() );
+  }
+  data.Successful.resize(data.Groups.size(), 0);
+
+  numberOfThreads = ResolveNumberOfThreads(numberOfThreads, data.Groups.size(), 1);
+  if (numberOfThreads == 1)
+  {
+    itk::MultiThreader::ThreadInfoStruct info;
+    info.ThreadID = 0;
+    info.NumberOfThreads = 1;
+    info.UserData = &data;
+    SortThread(&info);
+  }
+  else
+  {
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(SortThread, &data);
+    threader->SingleMethodExecute();
+  }
+
+  unsigned int group(0);
+  for ( FileNamesGrouping::iterator groupIter = groups.begin(); groupIter != groups.end(); ++groupIter, ++group )
+  {
+    if (data.Successful[group])
+    {
+      groupIter->second = ImageBlockDescriptor( data.Groups[group] ); // sort each slice group spatially
+    }
+    else
+    {
+      MITK_ERROR << "Caught something.";
+    }
+  }
+}
+
 std::string DicomSeriesReader::ReaderImplementationLevelToString( const ReaderImplementationLevel& enumValue )
 {
   switch (enumValue)
@@ -721,7 +969,7 @@ DicomSeriesReader::GetSeries(const StringContainer& files, bool sortTo3DPlust, b
   //         attributes (they cannot possibly form a 3D block)
 
   // scan for relevant tags in dicom files
-  gdcm::Scanner scanner;
+  ParallelScanner scanner;
   const gdcm::Tag tagSOPClassUID(0x0008, 0x0016); // SOP class UID
     scanner.AddTag( tagSOPClassUID );
 
@@ -765,15 +1013,15 @@ DicomSeriesReader::GetSeries(const StringContainer& files, bool sortTo3DPlust, b
   FileNamesGrouping result;
 
   // let GDCM scan files
-  if ( !scanner.Scan( files ) )
+  if ( !scanner.Scan( files, GetNumberOfScanThreads() ) )
   {
     MITK_ERROR << "gdcm::Scanner failed when scanning " << files.size() << " input files.";
     return result;
   }
 
   // assign files IDs that will separate them for loading into image blocks
-  for (gdcm::Scanner::ConstIterator fileIter = scanner.Begin();
-       fileIter != scanner.End();
+  for (gdcm::Scanner::ConstIterator fileIter = scanner.GetMappings().begin();
+       fileIter != scanner.GetMappings().end();
        ++fileIter)
   {
     if ( std::string(fileIter->first).empty() ) continue; // TODO understand why Scanner has empty string entries
@@ -795,19 +1043,9 @@ DicomSeriesReader::GetSeries(const StringContainer& files, bool sortTo3DPlust, b
   }
 
   // PART II: sort slices spatially (or at least consistently if this is NOT possible, see method)
+  //          sorting re-reads the files of each group, so groups are sorted in parallel
 
-  for ( FileNamesGrouping::const_iterator groupIter = result.begin();
-        groupIter != result.end();
-        ++groupIter )
-  {
-    try
-    {
-      result[ groupIter->first ] = ImageBlockDescriptor( SortSeriesSlices( groupIter->second.GetFilenames() ) ); // sort each slice group spatially
-    } catch(...)
-    {
-       MITK_ERROR << "Caught something.";
-    }
-  }
+  SortSeriesSlicesOfGroups( result, GetNumberOfScanThreads() );
 
   // PART III: analyze pre-sorted images for valid blocks (i.e. blocks of equal z-spacing),
   //          separate into multiple blocks if necessary.
@@ -1162,8 +1400,9 @@ DicomSeriesReader::GdcmSortFunction(const gdcm::DataSet &ds1, const gdcm::DataSe
      - slice thickness
      - number of rows/columns
   */
-  static const gdcm::Tag tagImagePositionPatient(0x0020,0x0032); // Image Position (Patient)
-  static const gdcm::Tag    tagImageOrientation(0x0020, 0x0037); // Image Orientation
+  // no function local statics: this is called concurrently by SortSeriesSlicesOfGroups()
+  const gdcm::Tag tagImagePositionPatient(0x0020,0x0032); // Image Position (Patient)
+  const gdcm::Tag    tagImageOrientation(0x0020, 0x0037); // Image Orientation
 
   // see if we have Image Position and Orientation
   if ( ds1.FindDataElement(tagImagePositionPatient) && ds1.FindDataElement(tagImageOrientation) &&
@@ -1223,7 +1462,7 @@ DicomSeriesReader::GdcmSortFunction(const gdcm::DataSet &ds1, const gdcm::DataSe
     else // we need to check more properties to distinguish slices
     {
       // try to sort by Acquisition Number
-      static const gdcm::Tag tagAcquisitionNumber(0x0020, 0x0012);
+      const gdcm::Tag tagAcquisitionNumber(0x0020, 0x0012);
       if (ds1.FindDataElement(tagAcquisitionNumber) && ds2.FindDataElement(tagAcquisitionNumber))
       {
         gdcm::Attribute<0x0020,0x0012> acquisition_number1; // Acquisition number
@@ -1239,7 +1478,7 @@ DicomSeriesReader::GdcmSortFunction(const gdcm::DataSet &ds1, const gdcm::DataSe
         else // neither position nor acquisition number are good for sorting, so check more
         {
           // try to sort by Acquisition Time
-          static const gdcm::Tag tagAcquisitionTime(0x0008, 0x0032);
+          const gdcm::Tag tagAcquisitionTime(0x0008, 0x0032);
           if (ds1.FindDataElement(tagAcquisitionTime) && ds2.FindDataElement(tagAcquisitionTime))
           {
             gdcm::Attribute<0x0008,0x0032> acquisition_time1; // Acquisition time
@@ -1255,7 +1494,7 @@ DicomSeriesReader::GdcmSortFunction(const gdcm::DataSet &ds1, const gdcm::DataSe
             else // we gave up on image position, acquisition number and acquisition time now
             {
               // let's try trigger time
-              static const gdcm::Tag tagTriggerTime(0x0018, 0x1060);
+              const gdcm::Tag tagTriggerTime(0x0018, 0x1060);
               if (ds1.FindDataElement(tagTriggerTime) && ds2.FindDataElement(tagTriggerTime))
               {
                 gdcm::Attribute<0x0018,0x1060> trigger_time1; // Trigger time
@@ -1280,7 +1519,7 @@ DicomSeriesReader::GdcmSortFunction(const gdcm::DataSet &ds1, const gdcm::DataSe
 
   // LAST RESORT: all valuable information for sorting is missing.
   // Sort by some meaningless but unique identifiers to satisfy the sort function
-  static const gdcm::Tag tagSOPInstanceUID(0x0008, 0x0018);
+  const gdcm::Tag tagSOPInstanceUID(0x0008, 0x0018);
   if (ds1.FindDataElement(tagSOPInstanceUID) && ds2.FindDataElement(tagSOPInstanceUID))
   {
     MITK_DEBUG << "Dicom images are missing attributes for a meaningful sorting, falling back to SOP instance UID comparison.";
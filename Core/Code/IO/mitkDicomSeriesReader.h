@@ -523,6 +523,28 @@ public:
             bool groupImagesWithGantryTilt,
             const StringContainer &restrictions = StringContainer());
 
+  /**
+    \brief Number of threads that GetSeries() uses to scan DICOM headers and to sort slice groups.
+
+    The file list is partitioned into contiguous chunks, each of which is scanned by its own
+    gdcm::Scanner. Afterwards the slice groups are sorted concurrently. The grouping result
+    does not depend on the number of threads.
+
+    0 (default) selects itk::MultiThreader's global default number of threads,
+    1 scans and sorts sequentially on the calling thread.
+  */
+  static void SetNumberOfScanThreads(unsigned int numberOfThreads);
+  static unsigned int GetNumberOfScanThreads();
+
+  /**
+    \brief Minimum number of files scanned by each thread (default 16).
+
+    Fewer threads than requested by SetNumberOfScanThreads() are used for short file lists,
+    because starting a thread does not pay off for a few files.
+  */
+  static void SetMinimumNumberOfFilesPerScanThread(unsigned int numberOfFiles);
+  static unsigned int GetMinimumNumberOfFilesPerScanThread();
+
   /**
    Loads a DICOM series composed by the file names enumerated in the file names container.
    If a callback method is supplied, it will be called after every progress update with a progress value in [0,1].
@@ -720,6 +742,54 @@ protected:
   */
   typedef std::pair<StringContainer, StringContainer> TwoStringContainers;
 
+  /**
+    \brief Scans a list of files for a set of tags using several gdcm::Scanner instances in parallel.
+
+    Each thread scans a contiguous part of the file list with its own gdcm::Scanner, the
+    resulting tag maps are merged afterwards. GetMappings() has the same layout as
+    gdcm::Scanner::GetMappings() for the complete list, its strings point into the
+    scanners owned by this object and are valid as long as the object exists.
+  */
+  class ParallelScanner
+  {
+    public:
+
+      ParallelScanner();
+      ~ParallelScanner();
+
+      void AddTag(const gdcm::Tag& tag);
+
+      /**
+        \brief Scan files using up to numberOfThreads threads; 0 selects the ITK default.
+      */
+      bool Scan(const StringContainer& files, unsigned int numberOfThreads);
+
+      const gdcm::Scanner::MappingType& GetMappings() const;
+
+      /**
+        \brief Same as gdcm::Scanner::GetValue(), returns NULL for unknown files or tags.
+      */
+      const char* GetValue(const char* filename, const gdcm::Tag& tag) const;
+
+    private:
+
+      ParallelScanner(const ParallelScanner&);            // Not implemented on purpose.
+      ParallelScanner& operator=(const ParallelScanner&); // Not implemented on purpose.
+
+      void Clear();
+
+      std::vector<gdcm::Tag> m_Tags;
+      std::vector<gdcm::Scanner*> m_Scanners;
+      gdcm::Scanner::MappingType m_Mappings;
+  };
+
+  /**
+    \brief Calls SortSeriesSlices() for every group, distributing the groups across numberOfThreads threads.
+
+    Groups that cannot be sorted keep their previous order.
+  */
+  static void SortSeriesSlicesOfGroups(FileNamesGrouping& groups, unsigned int numberOfThreads);
+
   /**
     \brief Maps DICOM tags to MITK properties.
   */
@@ -70,6 +70,7 @@ Image::Pointer DicomSeriesReader::LoadDICOMByITK4D( std::list<StringContainer>&
 
     unsigned int volume_count = imageBlocks.size();
     image->InitializeByItk( readVolume.GetPointer(), 1, volume_count);
+    image->SetPreallocateChannel(true); // all volumes are imported below
     image->SetImportVolume( readVolume->GetBufferPointer(), 0u);
 
     FixSpacingInformation( image, imageBlockDescriptor );
@@ -111,6 +112,7 @@ Image::Pointer DicomSeriesReader::LoadDICOMByITK4D( std::list<StringContainer>&
 
       image->SetImportVolume(readVolume->GetBufferPointer(), act_volume++);
     }
+    image->SetPreallocateChannel(false);
   }
 
   return image;
@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkItkImageFileReader.h"
 #include "mitkConfig.h"
 #include "mitkException.h"
+#include "mitkMemoryMappedFile.h"
 #include <mitkProportionalTimeGeometry.h>
 
 #include <itkImageFileReader.h>
@@ -28,6 +29,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImageFileReader.h>
 #include <itkImageIOFactory.h>
 #include <itkImageIORegion.h>
+#include <itkByteSwapper.h>
 //#include <itkImageSeriesReader.h>
 //#include <itkDICOMImageIO2.h>
 //#include <itkDICOMSeriesFileNames.h>
@@ -35,6 +37,108 @@ See LICENSE.txt or http://www.mitk.org for details.
 //#include <itkGDCMSeriesFileNames.h>
 //#include <itkNumericSeriesFileNames.h>
 
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+  std::string TrimAndLower(const std::string& text, bool lower)
+  {
+    const std::string whitespace = " \t\r";
+    std::string::size_type begin = text.find_first_not_of(whitespace);
+    if (begin == std::string::npos)
+      return std::string();
+    std::string::size_type end = text.find_last_not_of(whitespace);
+    std::string result = text.substr(begin, end - begin + 1);
+    if (lower)
+      std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+    return result;
+  }
+
+  /**
+   * Determines where the raw pixel data of a NRRD file is stored, so that it can be mapped
+   * into memory. Returns false if the data is not stored as one uncompressed block in the
+   * byte order of this machine and in the memory layout itk::NrrdImageIO produces.
+   */
+  bool GetMappableNrrdData(const std::string& fileName, const itk::ImageIOBase* imageIO,
+                           std::string& dataFileName, itk::uint64_t& dataOffset)
+  {
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line) || line.compare(0, 4, "NRRD") != 0)
+      return false;
+
+    std::string encoding, endian, dataFile, firstKind;
+    bool headerComplete = false;
+    while (std::getline(file, line))
+    {
+      if (TrimAndLower(line, false).empty())
+      {
+        headerComplete = true;
+        break;
+      }
+      if (line[0] == '#' || line.find(":=") != std::string::npos)
+        continue; // comments and key/value pairs
+
+      std::string::size_type colon = line.find(':');
+      if (colon == std::string::npos)
+        continue;
+      std::string field = TrimAndLower(line.substr(0, colon), true);
+      std::string value = TrimAndLower(line.substr(colon + 1), false);
+
+      if (field == "encoding")
+        encoding = TrimAndLower(value, true);
+      else if (field == "endian")
+        endian = TrimAndLower(value, true);
+      else if (field == "data file" || field == "datafile")
+        dataFile = value;
+      else if (field == "kinds")
+      {
+        std::istringstream kinds(TrimAndLower(value, true));
+        kinds >> firstKind;
+      }
+      else if ((field == "byte skip" || field == "byteskip" || field == "line skip" || field == "lineskip") && value != "0")
+        return false;
+    }
+
+    if (encoding != "raw")
+      return false;
+
+    if (imageIO->GetComponentSize() > 1)
+    {
+      const bool bigEndian = itk::ByteSwapper<int>::SystemIsBigEndian();
+      if (endian != (bigEndian ? "big" : "little"))
+        return false;
+    }
+
+    // NrrdImageIO reorders the data, if the component axis is not the fastest one
+    if (imageIO->GetNumberOfComponents() > 1 &&
+        (firstKind.empty() || firstKind == "domain" || firstKind == "space" || firstKind == "time"))
+      return false;
+
+    if (dataFile.empty())
+    {
+      // data is attached to the header
+      if (!headerComplete)
+        return false;
+      dataFileName = fileName;
+      dataOffset = static_cast<itk::uint64_t>(file.tellg());
+      return true;
+    }
+
+    // detached data must be a single file, not a list or pattern of files
+    if (dataFile.find(' ') != std::string::npos || dataFile.find('%') != std::string::npos)
+      return false;
+    if (!itksys::SystemTools::FileIsFullPath(dataFile.c_str()))
+      dataFile = itksys::SystemTools::GetFilenamePath(fileName) + "/" + dataFile;
+    dataFileName = dataFile;
+    dataOffset = 0;
+    return true;
+  }
+}
+
 
 void mitk::ItkImageFileReader::GenerateData()
 {
@@ -129,11 +233,30 @@ void mitk::ItkImageFileReader::GenerateData()
 
   MITK_INFO("mitkItkImageFileReader") << "ioRegion: " << ioRegion << std::endl;
   imageIO->SetIORegion( ioRegion );
-  void* buffer = new unsigned char[imageIO->GetImageSizeInBytes()];
-  imageIO->Read( buffer );
+
+  MemoryMappedFile::Pointer mappedFile;
+  std::string dataFileName;
+  itk::uint64_t dataOffset = 0;
+  if ( m_UseMemoryMapping && std::string(imageIO->GetNameOfClass()) == "NrrdImageIO" &&
+       GetMappableNrrdData(m_FileName, imageIO, dataFileName, dataOffset) )
+  {
+    mappedFile = MemoryMappedFile::New();
+    if ( !mappedFile->Map(dataFileName, dataOffset, imageIO->GetImageSizeInBytes()) )
+      mappedFile = NULL;
+  }
 
   image->Initialize( MakePixelType(imageIO), ndim, dimensions );
-  image->SetImportChannel( buffer, 0, Image::ManageMemory );
+
+  if ( mappedFile.IsNotNull() && image->SetMappedChannel(mappedFile) )
+  {
+    MITK_INFO("mitkItkImageFileReader") << "mapped " << dataFileName << " into memory" << std::endl;
+  }
+  else
+  {
+    void* buffer = new unsigned char[imageIO->GetImageSizeInBytes()];
+    imageIO->Read( buffer );
+    image->SetImportChannel( buffer, 0, Image::ManageMemory );
+  }
 
   // access direction of itk::Image and include spacing
   mitk::Matrix3D matrix;
@@ -161,7 +284,6 @@ void mitk::ItkImageFileReader::GenerateData()
   timeGeometry->Initialize(slicedGeometry, image->GetDimension(3));
   image->SetTimeGeometry(timeGeometry);
 
-  buffer = NULL;
   MITK_INFO("mitkItkImageFileReader") << "number of image components: "<< image->GetPixelType().GetNumberOfComponents() << std::endl;
 //  mitk::DataNode::Pointer node = this->GetOutput();
 //  node->SetData( image );
@@ -202,7 +324,7 @@ bool mitk::ItkImageFileReader::CanReadFile(const std::string filename, const std
 }
 
 mitk::ItkImageFileReader::ItkImageFileReader()
-    : m_FileName(""), m_FilePrefix(""), m_FilePattern("")
+    : m_FileName(""), m_FilePrefix(""), m_FilePattern(""), m_UseMemoryMapping(false)
 {
 }
 
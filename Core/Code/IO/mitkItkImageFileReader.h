@@ -44,6 +44,17 @@ public:
     itkSetStringMacro(FilePattern);
     itkGetStringMacro(FilePattern);
 
+    /** \brief Map uncompressed NRRD files into memory instead of reading them.
+      *
+      * The image is available immediately and the operating system loads only the pages
+      * which are accessed, see mitk::MemoryMappedFile. Files which cannot be mapped
+      * (compressed or foreign byte order data, other formats) are read as usual.
+      * The file must not be overwritten while the image exists. Default is off.
+      */
+    itkSetMacro(UseMemoryMapping, bool);
+    itkGetConstMacro(UseMemoryMapping, bool);
+    itkBooleanMacro(UseMemoryMapping);
+
     static bool CanReadFile(const std::string filename, const std::string filePrefix, const std::string filePattern);
 
 protected:
@@ -60,6 +71,8 @@ protected:
 
     std::string m_FilePattern;
 
+    bool m_UseMemoryMapping;
+
 };
 
 } // namespace mitk
@@ -0,0 +1,173 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkMemoryMappedFile.h"
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+mitk::MemoryMappedFile::MemoryMappedFile()
+  : m_View(NULL), m_ViewSize(0), m_Data(NULL), m_Size(0)
+{
+}
+
+mitk::MemoryMappedFile::~MemoryMappedFile()
+{
+  this->Unmap();
+}
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+
+bool mitk::MemoryMappedFile::Map(const std::string& fileName, itk::uint64_t offset, size_t size)
+{
+  this->Unmap();
+
+  if (size == 0)
+    return false;
+
+  HANDLE file = ::CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    MITK_WARN << "Could not open " << fileName << " for memory mapping";
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!::GetFileSizeEx(file, &fileSize) || static_cast<itk::uint64_t>(fileSize.QuadPart) < offset + size)
+  {
+    MITK_WARN << "File " << fileName << " is too short to map " << size << " bytes at offset " << offset;
+    ::CloseHandle(file);
+    return false;
+  }
+
+  // PAGE_WRITECOPY: the mapping is private, writes are never propagated to the file
+  HANDLE mapping = ::CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  ::CloseHandle(file);
+  if (mapping == NULL)
+  {
+    MITK_WARN << "Could not create a file mapping for " << fileName;
+    return false;
+  }
+
+  SYSTEM_INFO systemInfo;
+  ::GetSystemInfo(&systemInfo);
+  const itk::uint64_t alignedOffset = offset - offset % systemInfo.dwAllocationGranularity;
+  const size_t delta = static_cast<size_t>(offset - alignedOffset);
+
+  void* view = ::MapViewOfFile(mapping, FILE_MAP_COPY,
+                               static_cast<DWORD>(alignedOffset >> 32), static_cast<DWORD>(alignedOffset & 0xFFFFFFFF),
+                               size + delta);
+  // the view keeps the mapping object alive
+  ::CloseHandle(mapping);
+  if (view == NULL)
+  {
+    MITK_WARN << "Could not map " << size << " bytes of " << fileName;
+    return false;
+  }
+
+  m_View = view;
+  m_ViewSize = size + delta;
+  m_Data = static_cast<char*>(view) + delta;
+  m_Size = size;
+  m_FileName = fileName;
+  return true;
+}
+
+void mitk::MemoryMappedFile::Unmap()
+{
+  if (m_View != NULL)
+  {
+    ::UnmapViewOfFile(m_View);
+  }
+  m_View = NULL;
+  m_ViewSize = 0;
+  m_Data = NULL;
+  m_Size = 0;
+  m_FileName.clear();
+}
+
+#else
+
+bool mitk::MemoryMappedFile::Map(const std::string& fileName, itk::uint64_t offset, size_t size)
+{
+  this->Unmap();
+
+  if (size == 0)
+    return false;
+
+  int file = ::open(fileName.c_str(), O_RDONLY);
+  if (file < 0)
+  {
+    MITK_WARN << "Could not open " << fileName << " for memory mapping";
+    return false;
+  }
+
+  struct stat fileStatus;
+  if (::fstat(file, &fileStatus) != 0 || static_cast<itk::uint64_t>(fileStatus.st_size) < offset + size)
+  {
+    MITK_WARN << "File " << fileName << " is too short to map " << size << " bytes at offset " << offset;
+    ::close(file);
+    return false;
+  }
+
+  const itk::uint64_t pageSize = static_cast<itk::uint64_t>(::sysconf(_SC_PAGESIZE));
+  const itk::uint64_t alignedOffset = offset - offset % pageSize;
+  const size_t delta = static_cast<size_t>(offset - alignedOffset);
+
+  // MAP_PRIVATE: copy-on-write, writes are never propagated to the file
+  void* view = ::mmap(NULL, size + delta, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, static_cast<off_t>(alignedOffset));
+  // the mapping stays valid after closing the descriptor
+  ::close(file);
+  if (view == MAP_FAILED)
+  {
+    MITK_WARN << "Could not map " << size << " bytes of " << fileName;
+    return false;
+  }
+
+  m_View = view;
+  m_ViewSize = size + delta;
+  m_Data = static_cast<char*>(view) + delta;
+  m_Size = size;
+  m_FileName = fileName;
+  return true;
+}
+
+void mitk::MemoryMappedFile::Unmap()
+{
+  if (m_View != NULL)
+  {
+    ::munmap(m_View, m_ViewSize);
+  }
+  m_View = NULL;
+  m_ViewSize = 0;
+  m_Data = NULL;
+  m_Size = 0;
+  m_FileName.clear();
+}
+
+#endif
@@ -0,0 +1,93 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKMEMORYMAPPEDFILE_H
+#define MITKMEMORYMAPPEDFILE_H
+
+#include <MitkCoreExports.h>
+#include <mitkCommon.h>
+
+#include <itkLightObject.h>
+#include <itkIntTypes.h>
+
+#include <string>
+
+namespace mitk {
+
+//##Documentation
+//## @brief Maps a part of a file into memory.
+//##
+//## The mapping is private (copy-on-write): the memory can be read and written like
+//## an ordinary buffer, but modifications never reach the file. Nothing is read
+//## while mapping; the operating system loads the pages on first access, so only
+//## the parts of the file that are actually used occupy memory.
+//##
+//## The file must not be truncated or overwritten while it is mapped.
+//## Use Image::SetMappedChannel() to let an image use the mapped memory.
+//## @ingroup IO
+class MITK_CORE_EXPORT MemoryMappedFile : public itk::LightObject
+{
+public:
+  mitkClassMacro(MemoryMappedFile, itk::LightObject);
+  itkFactorylessNewMacro(Self)
+
+  /** \brief Maps @a size bytes of @a fileName, starting at byte @a offset.
+    * Any previous mapping is released.
+    * \return false if the file could not be opened, is too short or the mapping failed
+    */
+  bool Map(const std::string& fileName, itk::uint64_t offset, size_t size);
+
+  /** \brief Releases the mapping. */
+  void Unmap();
+
+  /** \brief Pointer to the mapped data, i.e. the byte at the requested offset in the file. NULL if nothing is mapped. */
+  void* GetData() const
+  {
+    return m_Data;
+  }
+
+  /** \brief Number of mapped bytes, as requested in Map(). */
+  size_t GetSize() const
+  {
+    return m_Size;
+  }
+
+  std::string GetFileName() const
+  {
+    return m_FileName;
+  }
+
+protected:
+  MemoryMappedFile();
+  virtual ~MemoryMappedFile();
+
+private:
+  MemoryMappedFile(const MemoryMappedFile&);            // Not implemented on purpose.
+  MemoryMappedFile& operator=(const MemoryMappedFile&); // Not implemented on purpose.
+
+  /** Start of the mapped view, which is aligned to the allocation granularity and may precede m_Data */
+  void* m_View;
+  size_t m_ViewSize;
+
+  void* m_Data;
+  size_t m_Size;
+
+  std::string m_FileName;
+};
+
+} // namespace mitk
+
+#endif // MITKMEMORYMAPPEDFILE_H
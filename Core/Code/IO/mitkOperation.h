@@ -39,6 +39,13 @@ public:
 
   OperationType GetOperationType();
 
+  //##Documentation
+  //## @brief Returns the number of bytes of data held by this operation, e.g. stored image slices.
+  //##
+  //## Used by memory limited undo models to decide when old operations are dropped.
+  //## The default implementation returns 0.
+  virtual unsigned long GetMemorySize();
+
   protected:
   OperationType m_OperationType;
 };
@@ -17,13 +17,15 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkRawImageFileReader.h"
 #include "mitkITKImageImport.h"
+#include "mitkMemoryMappedFile.h"
 
 #include <itkImage.h>
 #include <itkRawImageIO.h>
 #include <itkImageFileReader.h>
+#include <itkByteSwapper.h>
 
 mitk::RawImageFileReader::RawImageFileReader()
-    : m_FileName(""), m_FilePrefix(""), m_FilePattern("")
+    : m_FileName(""), m_FilePrefix(""), m_FilePattern(""), m_UseMemoryMapping(false)
 {
 }
 
@@ -138,6 +140,27 @@ void mitk::RawImageFileReader::TypedGenerateData()
     return ;
   }
 
+  const bool bigEndian = itk::ByteSwapper<int>::SystemIsBigEndian();
+  if (m_UseMemoryMapping && (sizeof(TPixel) == 1 || (m_Endianity == BIG) == bigEndian))
+  {
+    unsigned int dimensions[VImageDimensions];
+    size_t size = sizeof(TPixel);
+    for (unsigned int dim = 0; dim < VImageDimensions; ++dim)
+    {
+      dimensions[dim] = m_Dimensions[dim];
+      size *= m_Dimensions[dim];
+    }
+
+    mitk::MemoryMappedFile::Pointer mappedFile = mitk::MemoryMappedFile::New();
+    if (mappedFile->Map(m_FileName, 0, size))
+    {
+      output->Initialize(mitk::MakeScalarPixelType<TPixel>(), VImageDimensions, dimensions);
+      if (output->SetMappedChannel(mappedFile))
+        return;
+    }
+    MITK_INFO << "Could not map " << m_FileName << " into memory, reading it instead";
+  }
+
   typedef itk::Image< TPixel, VImageDimensions > ImageType;
   typedef itk::ImageFileReader< ImageType > ReaderType;
   typedef itk::RawImageIO< TPixel, VImageDimensions >  IOType;
@@ -64,6 +64,13 @@ public:
     itkSetMacro(Dimensionality, int);
     itkGetMacro(Dimensionality, int);
 
+    /** \brief Map the file into memory instead of reading it, see mitk::MemoryMappedFile.
+      * Only used if the endianity of the file matches this machine. Default is off.
+      */
+    itkSetMacro(UseMemoryMapping, bool);
+    itkGetConstMacro(UseMemoryMapping, bool);
+    itkBooleanMacro(UseMemoryMapping);
+
     /** Image dimensions must be set one by one, starting from dimension 0. */
     void SetDimensions(unsigned int i, unsigned int dim);
 
@@ -102,6 +109,9 @@ protected:
     /** Vector containing dimensions of image to be read. */
     itk::Vector<int, 3> m_Dimensions;
 
+    /** Map the file instead of reading it. */
+    bool m_UseMemoryMapping;
+
 };
 
 } // namespace mitk
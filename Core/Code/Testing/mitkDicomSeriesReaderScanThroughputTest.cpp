@@ -0,0 +1,105 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkDicomSeriesReader.h"
+#include <mitkTestingMacros.h>
+
+#include <itkTimeProbe.h>
+
+#include <gdcmDirectory.h>
+
+/**
+ * Benchmark for the parallel header scan of DicomSeriesReader::GetSeries().
+ * The files of a directory are grouped with an increasing number of scan
+ * threads; the throughput is reported in files per second. The test fails
+ * if the grouping differs from the sequential result.
+ *
+ * The test data is small, so the minimum number of files per thread is
+ * lowered to have all requested threads actually scan.
+ */
+
+namespace
+{
+  const unsigned int Repetitions = 5;
+
+  bool EqualGroupings(const mitk::DicomSeriesReader::FileNamesGrouping& a, const mitk::DicomSeriesReader::FileNamesGrouping& b)
+  {
+    if (a.size() != b.size())
+      return false;
+
+    for (mitk::DicomSeriesReader::FileNamesGrouping::const_iterator aIter = a.begin(), bIter = b.begin();
+         aIter != a.end();
+         ++aIter, ++bIter)
+    {
+      if (aIter->first != bIter->first || aIter->second.GetFilenames() != bIter->second.GetFilenames())
+        return false;
+    }
+
+    return true;
+  }
+
+  mitk::DicomSeriesReader::FileNamesGrouping RunScan(const mitk::DicomSeriesReader::StringContainer& files, unsigned int numberOfThreads)
+  {
+    mitk::DicomSeriesReader::SetNumberOfScanThreads(numberOfThreads);
+
+    mitk::DicomSeriesReader::FileNamesGrouping result;
+    itk::TimeProbe probe;
+    for (unsigned int i = 0; i < Repetitions; ++i)
+    {
+      probe.Start();
+      result = mitk::DicomSeriesReader::GetSeries(files, true, true);
+      probe.Stop();
+    }
+
+    double seconds = probe.GetTotal();
+    double scannedFiles = static_cast<double>(files.size()) * Repetitions;
+    MITK_TEST_OUTPUT(<< numberOfThreads << " scan threads: " << files.size() << " files in "
+                     << seconds / Repetitions << " s (" << (seconds > 0 ? scannedFiles / seconds : 0.0) << " files/s)");
+
+    return result;
+  }
+}
+
+int mitkDicomSeriesReaderScanThroughputTest(int argc, char* argv[])
+{
+  MITK_TEST_BEGIN("mitkDicomSeriesReaderScanThroughputTest");
+
+  MITK_TEST_CONDITION_REQUIRED(argc > 1, "Test data directory given");
+
+  gdcm::Directory directoryLister;
+  directoryLister.Load(argv[1], false);
+  const mitk::DicomSeriesReader::StringContainer files = directoryLister.GetFilenames();
+  MITK_TEST_CONDITION_REQUIRED(!files.empty(), "Test data directory contains files");
+
+  const unsigned int previousNumberOfThreads = mitk::DicomSeriesReader::GetNumberOfScanThreads();
+  const unsigned int previousMinimumNumberOfFiles = mitk::DicomSeriesReader::GetMinimumNumberOfFilesPerScanThread();
+  mitk::DicomSeriesReader::SetMinimumNumberOfFilesPerScanThread(1);
+
+  mitk::DicomSeriesReader::FileNamesGrouping reference = RunScan(files, 1);
+  MITK_TEST_CONDITION_REQUIRED(!reference.empty(), "Sequential scan finds image blocks");
+
+  const unsigned int threadCounts[] = { 2, 4, 8, 0 };
+  for (unsigned int i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); ++i)
+  {
+    mitk::DicomSeriesReader::FileNamesGrouping result = RunScan(files, threadCounts[i]);
+    MITK_TEST_CONDITION(EqualGroupings(reference, result), "Grouping with " << threadCounts[i] << " scan threads equals sequential grouping");
+  }
+
+  mitk::DicomSeriesReader::SetNumberOfScanThreads(previousNumberOfThreads);
+  mitk::DicomSeriesReader::SetMinimumNumberOfFilesPerScanThread(previousMinimumNumberOfFiles);
+
+  MITK_TEST_END();
+}
@@ -0,0 +1,184 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkImage.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
+#include "mitkImageGenerator.h"
+#include <mitkTestingMacros.h>
+
+#include <itkMultiThreader.h>
+#include <itkTimeProbe.h>
+
+#include <vector>
+
+/**
+ * Micro-benchmark for concurrent image accessors. Several threads repeatedly
+ * create read accessors on the same image, once without any writer and once
+ * while another thread keeps writing a different slice. The throughput of both
+ * scenarios is reported; the test fails only if accessors throw unexpectedly.
+ */
+
+namespace
+{
+  const unsigned int NumberOfSlices = 16;
+  const unsigned int AccessorsPerThread = 20000;
+
+  struct ThroughputData
+  {
+    mitk::Image::Pointer m_Image;
+    std::vector<mitk::ImageDataItem*> m_Slices;
+    bool m_UseWriter;
+    std::vector<unsigned int> m_Accesses;
+    std::vector<int> m_Successful; // no std::vector<bool>, threads write concurrently
+  };
+
+  ITK_THREAD_RETURN_TYPE ThroughputThread(void* arg)
+  {
+    itk::MultiThreader::ThreadInfoStruct* info = static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+    ThroughputData* data = static_cast<ThroughputData*>(info->UserData);
+    const unsigned int threadId = info->ThreadID;
+
+    try
+    {
+      if (data->m_UseWriter && threadId == 0)
+      {
+        // keeps slice 0 exclusively locked most of the time
+        for (unsigned int i = 0; i < AccessorsPerThread / 10; ++i)
+        {
+          mitk::ImageWriteAccessor writeAccess(data->m_Image, data->m_Slices[0]);
+          static_cast<short*>(writeAccess.GetData())[0] = static_cast<short>(i);
+          ++data->m_Accesses[threadId];
+        }
+      }
+      else
+      {
+        long sum = 0;
+        for (unsigned int i = 0; i < AccessorsPerThread; ++i)
+        {
+          // slice 0 is left to the writer, readers must never collide with it
+          unsigned int slice = 1 + (threadId + i) % (NumberOfSlices - 1);
+          mitk::ImageReadAccessor readAccess(data->m_Image, data->m_Slices[slice], mitk::ImageAccessorBase::ExceptionIfLocked);
+          sum += static_cast<const short*>(readAccess.GetData())[0];
+          ++data->m_Accesses[threadId];
+        }
+        if (sum < 0)
+          data->m_Successful[threadId] = 0;
+      }
+    }
+    catch (const mitk::Exception& e)
+    {
+      MITK_ERROR << e.GetDescription();
+      data->m_Successful[threadId] = 0;
+    }
+
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  void RunThroughput(mitk::Image* image, const std::vector<mitk::ImageDataItem*>& slices, unsigned int numberOfThreads, bool useWriter)
+  {
+    ThroughputData data;
+    data.m_Image = image;
+    data.m_Slices = slices;
+    data.m_UseWriter = useWriter;
+    data.m_Accesses.resize(numberOfThreads, 0);
+    data.m_Successful.resize(numberOfThreads, 1);
+
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(ThroughputThread, &data);
+
+    itk::TimeProbe probe;
+    probe.Start();
+    threader->SingleMethodExecute();
+    probe.Stop();
+
+    unsigned int accesses = 0;
+    bool successful = true;
+    for (unsigned int i = 0; i < numberOfThreads; ++i)
+    {
+      accesses += data.m_Accesses[i];
+      successful = successful && data.m_Successful[i] != 0;
+    }
+
+    double seconds = probe.GetTotal();
+    MITK_TEST_OUTPUT(<< numberOfThreads << " threads" << (useWriter ? " with writer: " : ": ")
+                     << accesses << " accessors in " << seconds << " s ("
+                     << (seconds > 0 ? accesses / seconds : 0.0) << " accessors/s)");
+
+    MITK_TEST_CONDITION_REQUIRED(successful, "Accessors on disjoint slices never block each other");
+  }
+}
+
+int mitkImageAccessorThroughputTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("mitkImageAccessorThroughputTest");
+
+  mitk::Image::Pointer image = mitk::ImageGenerator::GenerateRandomImage<short>(64, 64, NumberOfSlices);
+
+  // create the slice views up front, so that only the accessors are measured
+  std::vector<mitk::ImageDataItem*> slices;
+  for (unsigned int s = 0; s < NumberOfSlices; ++s)
+  {
+    slices.push_back(image->GetSliceData(s));
+  }
+
+  // a lock-free reader must still be detected by a writer of the same thread
+  MITK_TEST_FOR_EXCEPTION_BEGIN(mitk::Exception)
+    mitk::ImageReadAccessor first(image, slices[1]);
+    mitk::ImageWriteAccessor second(image, slices[1]);
+  MITK_TEST_FOR_EXCEPTION_END(mitk::Exception)
+
+  // region granular locking: a written slice does not lock the others
+  {
+    mitk::ImageWriteAccessor writeAccess(image, slices[0]);
+    bool otherSliceReadable = true;
+    try
+    {
+      mitk::ImageReadAccessor readAccess(image, slices[1], mitk::ImageAccessorBase::ExceptionIfLocked);
+    }
+    catch (const mitk::MemoryIsLockedException&)
+    {
+      otherSliceReadable = false;
+    }
+    MITK_TEST_CONDITION_REQUIRED(otherSliceReadable, "Reading a slice while another slice is written");
+
+    MITK_TEST_FOR_EXCEPTION_BEGIN(mitk::MemoryIsLockedException)
+      mitk::ImageReadAccessor lockedRead(image, slices[0], mitk::ImageAccessorBase::ExceptionIfLocked);
+    MITK_TEST_FOR_EXCEPTION_END(mitk::MemoryIsLockedException)
+  }
+
+  // a released lock-free reader does not block a subsequent writer
+  {
+    {
+      mitk::ImageReadAccessor readAccess(image, slices[2]);
+    }
+    mitk::ImageWriteAccessor writeAccess(image, slices[2]);
+    MITK_TEST_CONDITION_REQUIRED(writeAccess.GetData() != NULL, "Write access after a released lock-free read access");
+  }
+
+  const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+  for (unsigned int i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); ++i)
+  {
+    RunThroughput(image, slices, threadCounts[i], false);
+    if (threadCounts[i] > 1)
+    {
+      RunThroughput(image, slices, threadCounts[i], true);
+    }
+  }
+
+  MITK_TEST_END();
+}
@@ -0,0 +1,106 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include "mitkImage.h"
+#include "mitkImageStatisticsHolder.h"
+#include "mitkImageGenerator.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
+
+#include <algorithm>
+
+namespace
+{
+  const unsigned int SizeX = 31;
+  const unsigned int SizeY = 17;
+  const unsigned int SizeZ = 9;
+  const unsigned int TimeSteps = 3;
+
+  /** \brief Sequential reference for the extrema of one time step */
+  void CheckExtrema(mitk::Image* image, unsigned int t)
+  {
+    mitk::ImageReadAccessor readAccess(image, image->GetVolumeData(t));
+    const short* data = static_cast<const short*>(readAccess.GetData());
+    const unsigned int numberOfVoxels = SizeX * SizeY * SizeZ;
+
+    short min = data[0], max = data[0];
+    for (unsigned int i = 1; i < numberOfVoxels; ++i)
+    {
+      min = std::min(min, data[i]);
+      max = std::max(max, data[i]);
+    }
+
+    short secondMin = max, secondMax = min;
+    unsigned int countOfMin = 0, countOfMax = 0;
+    for (unsigned int i = 0; i < numberOfVoxels; ++i)
+    {
+      if (data[i] == min) ++countOfMin;
+      else secondMin = std::min(secondMin, data[i]);
+      if (data[i] == max) ++countOfMax;
+      else secondMax = std::max(secondMax, data[i]);
+    }
+
+    mitk::ImageStatisticsHolder* statistics = image->GetStatistics();
+    MITK_TEST_CONDITION(statistics->GetScalarValueMin(t) == min, "Minimum of time step " << t);
+    MITK_TEST_CONDITION(statistics->GetScalarValueMax(t) == max, "Maximum of time step " << t);
+    MITK_TEST_CONDITION(statistics->GetScalarValue2ndMin(t) == secondMin, "Second minimum of time step " << t);
+    MITK_TEST_CONDITION(statistics->GetScalarValue2ndMax(t) == secondMax, "Second maximum of time step " << t);
+    MITK_TEST_CONDITION(statistics->GetCountOfMinValuedVoxels(t) == countOfMin, "Count of minimum valued voxels of time step " << t);
+    MITK_TEST_CONDITION(statistics->GetCountOfMaxValuedVoxels(t) == countOfMax, "Count of maximum valued voxels of time step " << t);
+  }
+}
+
+int mitkImageStatisticsHolderTest(int /*argc*/, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("ImageStatisticsHolderTest");
+
+  mitk::Image::Pointer image = mitk::ImageGenerator::GenerateRandomImage<short>(SizeX, SizeY, SizeZ, TimeSteps, 1, 1, 1, 50, -50);
+  mitk::ImageStatisticsHolder* statistics = image->GetStatistics();
+
+  // the first request computes all time steps at once
+  statistics->GetScalarValueMax(0);
+  MITK_TEST_CONDITION(statistics->GetScalarValueMaxNoRecompute(TimeSteps - 1) != itk::NumericTraits<mitk::ScalarType>::NonpositiveMin(),
+                      "Extrema of the last time step are available after requesting the first one");
+
+  for (unsigned int t = 0; t < TimeSteps; ++t)
+  {
+    CheckExtrema(image, t);
+  }
+
+  const mitk::ImageStatisticsHolder::HistogramType* histogram = statistics->GetScalarHistogram(1);
+  MITK_TEST_CONDITION_REQUIRED(histogram != NULL, "Histogram is computed");
+  MITK_TEST_CONDITION(statistics->GetScalarHistogram(1) == histogram, "Histogram is cached while the image is unmodified");
+  MITK_TEST_CONDITION(statistics->GetScalarHistogram(7) == NULL, "No histogram for invalid time steps");
+
+  // modified images are recomputed
+  {
+    mitk::ImageWriteAccessor writeAccess(image, image->GetVolumeData(1));
+    static_cast<short*>(writeAccess.GetData())[5] = -1000;
+  }
+  image->Modified();
+  MITK_TEST_CONDITION(statistics->GetScalarValueMin(1) == -1000, "Minimum is recomputed after the image was modified");
+  MITK_TEST_CONDITION(statistics->GetCountOfMinValuedVoxels(1) == 1, "Count of minimum valued voxels is recomputed");
+  CheckExtrema(image, 0);
+  CheckExtrema(image, 1);
+
+  // constant images have no distinct second extrema
+  mitk::Image::Pointer constantImage = mitk::ImageGenerator::GenerateGradientImage<short>(1, 1, 1);
+  MITK_TEST_CONDITION(constantImage->GetStatistics()->GetScalarValue2ndMin() == constantImage->GetStatistics()->GetScalarValueMin(),
+                      "Second minimum equals minimum for constant images");
+
+  MITK_TEST_END();
+}
@@ -32,9 +32,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 // itk includes
 #include <itkImage.h>
 #include <itkMersenneTwisterRandomVariateGenerator.h>
+#include <itkMultiThreader.h>
 
 // stl includes
+#include <algorithm>
 #include <fstream>
+#include <vector>
 
 // vtk includes
 #include <vtkImageData.h>
@@ -160,6 +163,79 @@ public:
     MITK_TEST_CONDITION(matrixEqual, "Matrix elements of cloned matrix equal original matrix");
 
   }
+
+  void SetVolume_SingleTimeStep_ChannelNotAllocated()
+  {
+    mitk::Image::Pointer image = mitk::Image::New();
+    unsigned int dim[] = {32, 32, 8, 4};
+    image->Initialize(mitk::MakeScalarPixelType<short>(), 4, dim);
+
+    std::vector<short> volume(dim[0]*dim[1]*dim[2], 7);
+    image->SetVolume(&volume[0], 1);
+
+    MITK_TEST_CONDITION(image->GetNumberOfAliasedBytes() == 0, "A single volume is allocated on its own, not as part of the channel");
+    MITK_TEST_CONDITION(image->IsVolumeSet(1) && !image->IsVolumeSet(0), "Only the set volume is available");
+  }
+
+  void SetVolume_TimeSteps_ChannelAssembledWithoutCopy()
+  {
+    mitk::Image::Pointer image = mitk::Image::New();
+    unsigned int dim[] = {32, 32, 8, 4};
+    image->Initialize(mitk::MakeScalarPixelType<short>(), 4, dim);
+
+    std::vector<short> volume(dim[0]*dim[1]*dim[2]);
+    image->SetPreallocateChannel(true);
+    for (unsigned int t = 0; t < dim[3]; ++t)
+    {
+      std::fill(volume.begin(), volume.end(), static_cast<short>(t));
+      image->SetVolume(&volume[0], t);
+    }
+    image->SetPreallocateChannel(false);
+
+    mitk::Image::ImageDataItemPointer channel = image->GetChannelData();
+    MITK_TEST_CONDITION_REQUIRED(channel.IsNotNull() && channel->IsComplete(), "Channel is assembled from the volumes");
+    MITK_TEST_CONDITION(image->GetNumberOfCopiedBytes() == 0, "No bytes are copied to assemble the channel");
+
+    const size_t aliasedBefore = image->GetNumberOfAliasedBytes();
+    MITK_TEST_CONDITION(aliasedBefore > 0, "Volumes are views into the channel");
+
+    const short* channelData = static_cast<const short*>(channel->GetData());
+    MITK_TEST_CONDITION(channelData[volume.size()*3] == 3, "Volume data is found at its position in the channel");
+
+    // the same slice view is returned for repeated and concurrent requests
+    SliceRequestData data;
+    data.m_Image = image;
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(4);
+    data.m_Slices.resize(threader->GetNumberOfThreads());
+    threader->SetSingleMethod(RequestSlice, &data);
+    threader->SingleMethodExecute();
+
+    bool sameSlice = true;
+    for (unsigned int i = 0; i < data.m_Slices.size(); ++i)
+    {
+      sameSlice = sameSlice && data.m_Slices[i] == image->GetSliceData(5, 2);
+    }
+    MITK_TEST_CONDITION(sameSlice, "Concurrently requested slice views are created once");
+    MITK_TEST_CONDITION(image->GetNumberOfAliasedBytes() == aliasedBefore + dim[0]*dim[1]*sizeof(short), "The slice view is counted once as aliased");
+    MITK_TEST_CONDITION(image->GetNumberOfCopiedBytes() == 0, "Slice views do not copy");
+  }
+
+private:
+
+  struct SliceRequestData
+  {
+    mitk::Image::Pointer m_Image;
+    std::vector<mitk::ImageDataItem*> m_Slices;
+  };
+
+  static ITK_THREAD_RETURN_TYPE RequestSlice(void* arg)
+  {
+    itk::MultiThreader::ThreadInfoStruct* info = static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+    SliceRequestData* data = static_cast<SliceRequestData*>(info->UserData);
+    data->m_Slices[info->ThreadID] = data->m_Image->GetSliceData(5, 2).GetPointer();
+    return ITK_THREAD_RETURN_VALUE;
+  }
 };
 
 
@@ -170,6 +246,8 @@ int mitkImageTest(int argc, char* argv[])
 
   mitkImageTestClass tester;
   tester.SetClonedGeometry_None_ClonedEqualInput();
+  tester.SetVolume_TimeSteps_ChannelAssembledWithoutCopy();
+  tester.SetVolume_SingleTimeStep_ChannelNotAllocated();
 
 
   //Create Image out of nowhere
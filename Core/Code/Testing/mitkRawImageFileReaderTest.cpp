@@ -27,6 +27,7 @@ class mitkRawImageFileReaderTestSuite : public mitk::TestFixture
   CPPUNIT_TEST_SUITE(mitkRawImageFileReaderTestSuite);
   MITK_TEST(testInstantiation);
   MITK_TEST(testReadFile);
+  MITK_TEST(testReadFileMemoryMapped);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -77,6 +78,24 @@ public:
     mitk::Image::Pointer compareImage = mitk::IOUtil::LoadImage(m_ImagePathNrrdRef);
     CPPUNIT_ASSERT_MESSAGE("Testing if image is equal to the same image as reference file loaded with mitk",mitk::Equal(compareImage,readFile,mitk::eps,true));
   }
+
+  void testReadFileMemoryMapped()
+  {
+    m_FileReader->SetFileName(m_ImagePath.c_str());
+    m_FileReader->SetPixelType(mitk::RawImageFileReader::FLOAT);
+    m_FileReader->SetDimensionality(3);
+    m_FileReader->SetDimensions(0,91);
+    m_FileReader->SetDimensions(1,109);
+    m_FileReader->SetDimensions(2,91);
+    m_FileReader->SetEndianity(mitk::RawImageFileReader::LITTLE);
+    m_FileReader->UseMemoryMappingOn();
+    m_FileReader->Update();
+    mitk::Image::Pointer readFile = m_FileReader->GetOutput();
+    CPPUNIT_ASSERT_MESSAGE("Testing reading a raw file via memory mapping.",readFile.IsNotNull());
+
+    mitk::Image::Pointer compareImage = mitk::IOUtil::LoadImage(m_ImagePathNrrdRef);
+    CPPUNIT_ASSERT_MESSAGE("Testing if the mapped image is equal to the reference file",mitk::Equal(compareImage,readFile,mitk::eps,true));
+  }
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkRawImageFileReader)
@@ -43,6 +43,11 @@ public:
   {
     g_GlobalCounter--;
   };
+
+  virtual unsigned long GetMemorySize()
+  {
+    return 100;
+  }
 };
 }//namespace
 
@@ -138,6 +143,32 @@ int mitkVerboseLimitedLinearUndoTest(int /* argc */, char* /*argv*/[])
   //after deleting UndoController g_GlobalCounter will still be 4 because m_CurrentUndoModel inside myUndoModel is a static singleton
   MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 4,"checking singleton UndoModel");
 
+  //a memory limit of 500 bytes allows to keep two OperationEvents with 2 * 100 bytes each
+  mitk::VerboseLimitedLinearUndo::Pointer limitedUndoModel = mitk::VerboseLimitedLinearUndo::New();
+  limitedUndoModel->SetMemoryLimit(500);
+  for (int i = 0; i<5; i++)
+  {
+    mitk::TestOperation* doOp = new mitk::TestOperation(mitk::OpTEST);
+    mitk::TestOperation *undoOp = new mitk::TestOperation(mitk::OpTEST);
+    mitk::OperationEvent *operationEvent = new mitk::OperationEvent(NULL, doOp, undoOp, "Test");
+    limitedUndoModel->SetOperationEvent(operationEvent);
+    mitk::OperationEvent::IncCurrObjectEventId();
+    mitk::UndoStackItem::ExecuteIncrement();
+  }
+  MITK_TEST_CONDITION_REQUIRED(limitedUndoModel->GetMemoryUsage() == 400,"checking memory usage of limited UndoModel");
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 8,"checking deletion of the oldest operations");
+
+  //the newest OperationEvent is kept even if it exceeds the limit on its own
+  limitedUndoModel->SetMemoryLimit(100);
+  mitk::OperationEvent *largeOperationEvent = new mitk::OperationEvent(NULL, new mitk::TestOperation(mitk::OpTEST), new mitk::TestOperation(mitk::OpTEST), "Test");
+  limitedUndoModel->SetOperationEvent(largeOperationEvent);
+  mitk::OperationEvent::IncCurrObjectEventId();
+  mitk::UndoStackItem::ExecuteIncrement();
+  MITK_TEST_CONDITION_REQUIRED(limitedUndoModel->GetMemoryUsage() == 200,"checking that the newest OperationEvent is kept");
+
+  limitedUndoModel->Clear();
+  MITK_TEST_CONDITION_REQUIRED(g_GlobalCounter == 4,"checking deleting all operations in limited UndoModel");
+
   // always end with this!
   MITK_TEST_END()
   //operations will be deleted after terminating the application
@@ -40,6 +40,7 @@ set(H_FILES
   Algorithms/mitkConvert2Dto3DImageFilter.h
   Algorithms/mitkPlaneClipping.h
 
+  Common/mitkAtomicInteger.h
   Common/mitkCommon.h
   Common/mitkExceptionMacro.h
 
@@ -320,6 +321,7 @@ set(CPP_FILES
   IO/mitkItkPictureWrite.cpp
   IO/mitkIOUtil.cpp
   IO/mitkLookupTableProperty.cpp
+  IO/mitkMemoryMappedFile.cpp
   IO/mitkOperation.cpp
 # IO/mitkPicFileIOFactory.cpp
 # IO/mitkPicFileReader.cpp
@@ -20,8 +20,22 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vnl/vnl_random.h"
 #include "vnl/vnl_math.h"
 
+#include <mitkAtomicInteger.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+struct mitk::ConnectomicsSimulatedAnnealingManager::Jobs
+{
+  std::vector< mitk::ConnectomicsSimulatedAnnealingPermutationBase::Pointer > Chains;
+  std::vector< double > Temperatures;
+  mitk::AtomicInteger NextChain;
+};
+
 mitk::ConnectomicsSimulatedAnnealingManager::ConnectomicsSimulatedAnnealingManager()
 : m_Permutation( 0 )
+, m_NumberOfChains( 1 )
 {
 }
 
@@ -79,17 +93,92 @@ void mitk::ConnectomicsSimulatedAnnealingManager::RunSimulatedAnnealing(
   // Initialize the associated permutation
   m_Permutation->Initialize();
 
+  //the random number generator for the seeds of the chains and the exchanges between them
+  vnl_random rng( (unsigned int) rand() );
+
+  // the given permutation is the coldest chain, the others run their own random sequences
+  Jobs jobs;
+  jobs.Chains.push_back( m_Permutation );
+  for( unsigned int chain( 1 ); chain < m_NumberOfChains; chain++ )
+  {
+    mitk::ConnectomicsSimulatedAnnealingPermutationBase::Pointer permutation = m_Permutation->CreateChain( rng.lrand32() );
+    if( permutation.IsNull() )
+    {
+      MBI_WARN << "Permutation does not support parallel chains, running a single chain.";
+      break;
+    }
+    permutation->Initialize();
+    jobs.Chains.push_back( permutation );
+  }
+  const unsigned int numberOfChains = jobs.Chains.size();
+  jobs.Temperatures.resize( numberOfChains );
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( std::min( numberOfChains, (unsigned int)itk::MultiThreader::GetGlobalDefaultNumberOfThreads() ) );
+  threader->SetSingleMethod( PermutateChainsCallback, &jobs );
 
   for( double currentTemperature( temperature );
     currentTemperature > 0.00001;
     currentTemperature = currentTemperature / stepSize )
   {
-    // Run Permutations at the current temperature
-    m_Permutation->Permutate( currentTemperature );
+    if( numberOfChains == 1 )
+    {
+      // Run Permutations at the current temperature
+      m_Permutation->Permutate( currentTemperature );
+      continue;
+    }
+
+    // Run Permutations of all chains, the temperatures lie between the current and the previous step
+    for( unsigned int chain( 0 ); chain < numberOfChains; chain++ )
+    {
+      jobs.Temperatures[ chain ] = currentTemperature * std::pow( stepSize, (double) chain / numberOfChains );
+    }
+    // the threads of the previous step have finished, restart the chain counter
+    jobs.NextChain.Set( 0 );
+    threader->SingleMethodExecute();
+
+    // exchange the solutions of neighbouring chains, a better solution always moves to the colder chain
+    for( unsigned int chain( numberOfChains - 1 ); chain > 0; chain-- )
+    {
+      double exponent = ( 1.0 / jobs.Temperatures[ chain - 1 ] - 1.0 / jobs.Temperatures[ chain ] )
+        * ( jobs.Chains[ chain - 1 ]->GetCost() - jobs.Chains[ chain ]->GetCost() );
+      if( exponent >= 0 || rng.drand64( 0.0, 1.0 ) < std::exp( exponent ) )
+      {
+        jobs.Chains[ chain - 1 ]->SwapSolution( jobs.Chains[ chain ] );
+      }
+    }
+  }
 
+  // the best solution of all chains is the result
+  unsigned int bestChain( 0 );
+  double bestCost( m_Permutation->GetCost() );
+  for( unsigned int chain( 1 ); chain < numberOfChains; chain++ )
+  {
+    double cost = jobs.Chains[ chain ]->GetCost();
+    if( cost < bestCost )
+    {
+      bestCost = cost;
+      bestChain = chain;
+    }
+  }
+  if( bestChain > 0 )
+  {
+    m_Permutation->SwapSolution( jobs.Chains[ bestChain ] );
   }
 
   // Clean up result
   m_Permutation->CleanUp();
 
 }
+
+ITK_THREAD_RETURN_TYPE mitk::ConnectomicsSimulatedAnnealingManager::PermutateChainsCallback( void* arg )
+{
+  Jobs* jobs = static_cast< Jobs* >( static_cast< itk::MultiThreader::ThreadInfoStruct* >( arg )->UserData );
+
+  for( long chain = jobs->NextChain.Increment() - 1; chain < (long)jobs->Chains.size(); chain = jobs->NextChain.Increment() - 1 )
+  {
+    jobs->Chains[ chain ]->Permutate( jobs->Temperatures[ chain ] );
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
@@ -20,6 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkObject.h>
 #include <itkObjectFactory.h>
 #include <itkMacro.h>
+#include <itkMultiThreader.h>
 
 #include "mitkCommon.h"
 
@@ -30,7 +31,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 namespace mitk
 {
   /**
-  * \brief A class allow generic simulated annealing by using classes derived from ConnectomicsSimulatedAnnealingPermutationBase */
+  * \brief A class allow generic simulated annealing by using classes derived from ConnectomicsSimulatedAnnealingPermutationBase
+  *
+  * With more than one chain the manager runs a parallel tempering: chain k permutates at the current temperature
+  * multiplied by stepSize^(k/NumberOfChains), all chains in parallel. After each temperature step the solutions of
+  * neighbouring chains are exchanged with the Metropolis probability, the final result is the best solution of all chains. */
   class MitkConnectomics_EXPORT ConnectomicsSimulatedAnnealingManager : public itk::Object
   {
   public:
@@ -51,16 +56,28 @@ namespace mitk
     // Set the permutation to be used
     void SetPermutation( mitk::ConnectomicsSimulatedAnnealingPermutationBase::Pointer permutation );
 
+    // Set the number of chains run in parallel, default is one
+    itkSetMacro( NumberOfChains, unsigned int );
+    itkGetMacro( NumberOfChains, unsigned int );
+
   protected:
 
     //////////////////// Functions ///////////////////////
     ConnectomicsSimulatedAnnealingManager();
     ~ConnectomicsSimulatedAnnealingManager();
 
+    // Permutate the chains of a parallel tempering at their temperatures
+    static ITK_THREAD_RETURN_TYPE PermutateChainsCallback( void* arg );
+
+    struct Jobs;
+
     /////////////////////// Variables ////////////////////////
     // The permutation assigned to the simulated annealing manager
     mitk::ConnectomicsSimulatedAnnealingPermutationBase::Pointer m_Permutation;
 
+    // The number of chains of the parallel tempering
+    unsigned int m_NumberOfChains;
+
   };
 
 }// end namespace mitk
@@ -58,6 +58,16 @@ namespace mitk
     // Do clean up necessary after a permutation
     virtual void CleanUp(){};
 
+    // Cost of the current solution
+    virtual double GetCost(){ return 0.0; };
+
+    // Create a permutation with the same settings and its own random sequence, to be run as an additional
+    // chain in parallel tempering. Returns a null pointer if the permutation does not support this.
+    virtual Pointer CreateChain( unsigned long /*seed*/ ){ return NULL; };
+
+    // Exchange the current solution with the one of a chain created by CreateChain
+    virtual void SwapSolution( Self* /*chain*/ ){};
+
   protected:
 
     //////////////////// Functions ///////////////////////
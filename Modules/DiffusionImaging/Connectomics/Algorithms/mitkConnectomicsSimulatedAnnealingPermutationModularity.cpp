@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vnl/vnl_math.h"
 
 mitk::ConnectomicsSimulatedAnnealingPermutationModularity::ConnectomicsSimulatedAnnealingPermutationModularity()
+: m_RandomGenerator( (unsigned long) rand() )
 {
 }
 
@@ -103,6 +104,33 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::CleanUp()
   }
 }
 
+double mitk::ConnectomicsSimulatedAnnealingPermutationModularity::GetCost()
+{
+  return Evaluate( &m_BestSolution );
+}
+
+mitk::ConnectomicsSimulatedAnnealingPermutationBase::Pointer
+mitk::ConnectomicsSimulatedAnnealingPermutationModularity::CreateChain( unsigned long seed )
+{
+  // the network and the cost function are only read and can be shared between the chains
+  Self::Pointer chain = Self::New();
+  chain->SetCostFunction( m_CostFunction );
+  chain->SetNetwork( m_Network );
+  chain->SetDepth( m_Depth );
+  chain->SetStepSize( m_StepSize );
+  chain->SetRandomSeed( seed );
+  return chain.GetPointer();
+}
+
+void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::SwapSolution( ConnectomicsSimulatedAnnealingPermutationBase* chain )
+{
+  Self* other = dynamic_cast< Self* >( chain );
+  if( other )
+  {
+    m_BestSolution.swap( other->m_BestSolution );
+  }
+}
+
 void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::permutateMappingSingleNodeShift(
   ToModuleMapType *vertexToModuleMap, mitk::ConnectomicsNetwork::Pointer network )
 {
@@ -110,8 +138,8 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::permutateMapping
   const int nodeCount = vertexToModuleMap->size();
   const int moduleCount = getNumberOfModules( vertexToModuleMap );
 
-  // the random number generators
-  vnl_random rng( (unsigned int) rand() );
+  // the random number generator of this chain
+  vnl_random& rng = m_RandomGenerator;
   unsigned long randomNode = rng.lrand32( nodeCount - 1 );
   // move the node either to any existing module, or to its own
   //unsigned long randomModule = rng.lrand32( moduleCount );
@@ -148,8 +176,8 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::permutateMapping
 void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::permutateMappingModuleChange(
   ToModuleMapType *vertexToModuleMap, double currentTemperature, mitk::ConnectomicsNetwork::Pointer network )
 {
-  //the random number generators
-  vnl_random rng( (unsigned int) rand() );
+  //the random number generator of this chain
+  vnl_random& rng = m_RandomGenerator;
 
   //randomly generate threshold
   const double threshold = rng.drand64( 0.0 , 1.0);
@@ -249,6 +277,7 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::splitModule(
     permutation->SetNetwork( subNetwork );
     permutation->SetDepth( m_Depth - 1 );
     permutation->SetStepSize( m_StepSize * 2 );
+    permutation->SetRandomSeed( m_RandomGenerator.lrand32() );
 
     manager->SetPermutation( permutation.GetPointer() );
 
@@ -433,8 +462,8 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::randomlyAssignNo
     numberOfIntendedModules = vertexToModuleMap->size();
   }
 
-  //the random number generators
-  vnl_random rng( (unsigned int) rand() );
+  //the random number generator of this chain
+  vnl_random& rng = m_RandomGenerator;
 
   std::vector< int > histogram;
   std::vector< int > nodeList;
@@ -511,8 +540,8 @@ bool mitk::ConnectomicsSimulatedAnnealingPermutationModularity::AcceptChange( do
     return true;
   }
 
-  //the random number generators
-  vnl_random rng( (unsigned int) rand() );
+  //the random number generator of this chain
+  vnl_random& rng = m_RandomGenerator;
 
   //randomly generate threshold
   const double threshold = rng.drand64( 0.0 , 1.0);
@@ -538,3 +567,8 @@ void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::SetStepSize( dou
 {
   m_StepSize = size;
 }
+
+void mitk::ConnectomicsSimulatedAnnealingPermutationModularity::SetRandomSeed( unsigned long seed )
+{
+  m_RandomGenerator.reseed( seed );
+}
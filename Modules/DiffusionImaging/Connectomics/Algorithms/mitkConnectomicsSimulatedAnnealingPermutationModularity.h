@@ -21,6 +21,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkConnectomicsNetwork.h"
 
+#include "vnl/vnl_random.h"
+
 namespace mitk
 {
   /**
@@ -49,6 +51,15 @@ namespace mitk
     // Do clean up necessary after a permutation
     virtual void CleanUp();
 
+    // Cost of the current best solution
+    virtual double GetCost();
+
+    // Create a permutation of the same network with the same settings
+    virtual ConnectomicsSimulatedAnnealingPermutationBase::Pointer CreateChain( unsigned long seed );
+
+    // Exchange the current best solution with the one of another chain
+    virtual void SwapSolution( ConnectomicsSimulatedAnnealingPermutationBase* chain );
+
     // set the network permutation is to be run upon
     void SetNetwork( mitk::ConnectomicsNetwork::Pointer theNetwork );
 
@@ -70,6 +81,9 @@ namespace mitk
     // Set stepSize
     void SetStepSize( double size );
 
+    // Seed the random numbers of this permutation, by default they are seeded with rand()
+    void SetRandomSeed( unsigned long seed );
+
   protected:
 
     //////////////////// Functions ///////////////////////
@@ -133,6 +147,9 @@ namespace mitk
 
     // The step size for recursive configuring of simulated annealing manager
     double m_StepSize;
+
+    // The random numbers of this permutation, every chain of a parallel tempering has its own
+    mutable vnl_random m_RandomGenerator;
   };
 
 }// end namespace mitk
@@ -17,44 +17,48 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkConnectomicsStatisticsCalculator.h"
 #include "mitkConnectomicsNetworkConverter.h"
 
+#include <mitkAtomicInteger.h>
+#include <itkSimpleFastMutexLock.h>
+
 #include <numeric>
 
 #include <boost/graph/connected_components.hpp>
 #include <boost/graph/clustering_coefficient.hpp>
-#include <boost/graph/betweenness_centrality.hpp>
-#include <boost/graph/visitors.hpp>
 
 #include "vnl/algo/vnl_symmetric_eigensystem.h"
 
-template<typename GraphType>
-class all_pairs_shortest_recorder : public boost::default_bfs_visitor
+struct mitk::ConnectomicsStatisticsCalculator::Jobs
 {
-public:
-  typedef typename boost::graph_traits<GraphType>::vertex_descriptor VertexType;
-  typedef typename boost::graph_traits<GraphType>::edge_descriptor EdgeType;
+  Jobs() : NumberOfVertices( 0 ), NumberOfEdges( 0 ), NumberOfBlocks( 0 ), NextReducedBlock( 0 ), DistanceHistograms( 0 ),
+    VertexCentralities( 0 ), EdgeCentralities( 0 ) {}
 
-  all_pairs_shortest_recorder(int* dist, int &max, unsigned int &size)
-  {
-    d = dist;
-    ecc = &max;
-    component_size = &size;
-  }
+  enum { BlockSize = 64 }; // source vertices per block
 
-  void tree_edge(EdgeType edge, const GraphType& graph) {
-    VertexType u = boost::source(edge, graph);
-    VertexType v = boost::target(edge, graph);
-    d[v] = d[u] + 1;
-    *ecc = d[v];
-    *component_size = *component_size + 1;
-  }
-private:
-  int* d;
-  int* ecc;
-  unsigned int* component_size;
+  unsigned int NumberOfVertices;
+  unsigned int NumberOfEdges;
+  unsigned int NumberOfBlocks;
+
+  // adjacency in compressed row form, the neighbours of vertex v are AdjacentVertices[ AdjacencyOffsets[v] ... AdjacencyOffsets[v+1]-1 ]
+  std::vector< unsigned int > AdjacencyOffsets;
+  std::vector< unsigned int > AdjacentVertices;
+  std::vector< unsigned int > AdjacentEdges;
+
+  mitk::AtomicInteger NextBlock;
+
+  // centralities of the blocks that are finished but can not be added yet, because a previous block is still running
+  std::vector< std::vector< double > > BlockCentralities;
+  std::vector< bool > BlockFinished;
+  unsigned int NextReducedBlock;
+  itk::SimpleFastMutexLock Mutex; // guards the block reduction
+
+  std::vector< std::vector< unsigned int > >* DistanceHistograms;
+  std::vector< double >* VertexCentralities;
+  std::vector< double >* EdgeCentralities;
 };
 
 mitk::ConnectomicsStatisticsCalculator::ConnectomicsStatisticsCalculator()
   : m_Network( 0 )
+  , m_NumberOfThreads( itk::MultiThreader::GetGlobalDefaultNumberOfThreads() )
   , m_NumberOfVertices( 0 )
   , m_NumberOfEdges( 0 )
   , m_AverageDegree( 0.0 )
@@ -128,6 +132,7 @@ void mitk::ConnectomicsStatisticsCalculator::Update()
   CalculateAverageComponentSize();
   CalculateLargestComponentSize();
   CalculateRatioOfNodesInLargestComponent();
+  CalculateAllPairsShortestPaths();
   CalculateHopPlotValues();
   CalculateClusteringCoefficients();
   CalculateBetweennessCentrality();
@@ -196,31 +201,183 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateRatioOfNodesInLargestCompo
   m_RatioOfNodesInLargestComponent = (double) m_LargestComponentSize / (double) m_NumberOfVertices ;
 }
 
-void mitk::ConnectomicsStatisticsCalculator::CalculateHopPlotValues()
+void mitk::ConnectomicsStatisticsCalculator::CalculateAllPairsShortestPaths()
 {
-  std::vector<int> bins( m_NumberOfVertices );
+  NetworkType* graph = m_Network->GetBoostGraph();
 
+  Jobs jobs;
+  jobs.NumberOfVertices = boost::num_vertices( *graph );
+  jobs.NumberOfEdges = boost::num_edges( *graph );
+  jobs.NumberOfBlocks = ( jobs.NumberOfVertices + Jobs::BlockSize - 1 ) / Jobs::BlockSize;
+
+  // index the edges in the order of the edge iterator
+  m_EdgeIndices.clear();
+  EdgeIteratorType ei, ei_end;
+  int edgeIndex( 0 );
+  for( boost::tie( ei, ei_end ) = boost::edges( *graph ); ei != ei_end; ++ei, ++edgeIndex )
+  {
+    m_EdgeIndices.insert( std::pair< EdgeDescriptorType, int >( *ei, edgeIndex ) );
+  }
+
+  // the threads only read the adjacency arrays, not the boost graph
+  jobs.AdjacencyOffsets.reserve( jobs.NumberOfVertices + 1 );
+  jobs.AdjacencyOffsets.push_back( 0 );
   VertexIteratorType vi, vi_end;
-  unsigned int index( 0 );
+  for( boost::tie( vi, vi_end ) = boost::vertices( *graph ); vi != vi_end; ++vi )
+  {
+    OutEdgeIteratorType oi, oi_end;
+    for( boost::tie( oi, oi_end ) = boost::out_edges( *vi, *graph ); oi != oi_end; ++oi )
+    {
+      jobs.AdjacentVertices.push_back( boost::target( *oi, *graph ) );
+      jobs.AdjacentEdges.push_back( m_EdgeIndices.find( *oi )->second );
+    }
+    jobs.AdjacencyOffsets.push_back( jobs.AdjacentVertices.size() );
+  }
+
+  m_DistanceHistograms.clear();
+  m_DistanceHistograms.resize( jobs.NumberOfVertices );
+  m_VectorOfVertexBetweennessCentralities.assign( jobs.NumberOfVertices, 0.0 );
+  m_VectorOfEdgeBetweennessCentralities.assign( jobs.NumberOfEdges, 0.0 );
+  jobs.DistanceHistograms = &m_DistanceHistograms;
+  jobs.VertexCentralities = &m_VectorOfVertexBetweennessCentralities;
+  jobs.EdgeCentralities = &m_VectorOfEdgeBetweennessCentralities;
+  jobs.BlockCentralities.resize( jobs.NumberOfBlocks );
+  jobs.BlockFinished.resize( jobs.NumberOfBlocks, false );
+
+  unsigned int numberOfThreads = std::max( 1u, std::min( m_NumberOfThreads, jobs.NumberOfBlocks ) );
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( numberOfThreads );
+  threader->SetSingleMethod( AllPairsShortestPathsCallback, &jobs );
+  threader->SingleMethodExecute();
+
+  // every shortest path of the undirected graph has been found from both of its ends
+  for( unsigned int i = 0; i < m_VectorOfVertexBetweennessCentralities.size(); i++ )
+  {
+    m_VectorOfVertexBetweennessCentralities[ i ] /= 2.0;
+  }
+  for( unsigned int i = 0; i < m_VectorOfEdgeBetweennessCentralities.size(); i++ )
+  {
+    m_VectorOfEdgeBetweennessCentralities[ i ] /= 2.0;
+  }
+}
 
-  for( boost::tie( vi, vi_end ) = boost::vertices( *(m_Network->GetBoostGraph()) ); vi != vi_end; ++vi)
+ITK_THREAD_RETURN_TYPE mitk::ConnectomicsStatisticsCalculator::AllPairsShortestPathsCallback( void* arg )
+{
+  Jobs* jobs = static_cast< Jobs* >( static_cast< itk::MultiThreader::ThreadInfoStruct* >( arg )->UserData );
+  const unsigned int numberOfVertices = jobs->NumberOfVertices;
+  const unsigned int* offsets = &jobs->AdjacencyOffsets[0];
+  const unsigned int* adjacentVertices = jobs->AdjacentVertices.empty() ? 0 : &jobs->AdjacentVertices[0];
+  const unsigned int* adjacentEdges = jobs->AdjacentEdges.empty() ? 0 : &jobs->AdjacentEdges[0];
+
+  std::vector< int > distances( numberOfVertices, -1 );
+  std::vector< std::size_t > pathCounts( numberOfVertices, 0 );
+  std::vector< double > dependencies( numberOfVertices, 0.0 );
+  std::vector< unsigned int > queue( numberOfVertices );
+
+  for( long block = jobs->NextBlock.Increment() - 1; block < (long)jobs->NumberOfBlocks; block = jobs->NextBlock.Increment() - 1 )
   {
-    std::vector<int> distances(m_NumberOfVertices, 0);
-    int max_distance = 0;
-    VertexDescriptorType src = *vi;
-    distances[src] = 0;
-    unsigned int size = 0;
+    // vertex centralities followed by the edge centralities of this block
+    std::vector< double > centralities( numberOfVertices + jobs->NumberOfEdges, 0.0 );
+    double* vertexCentralities = &centralities[0];
+    double* edgeCentralities = vertexCentralities + numberOfVertices;
+
+    unsigned int lastSource = std::min( numberOfVertices, (unsigned int)( block + 1 ) * Jobs::BlockSize );
+    for( unsigned int src = block * Jobs::BlockSize; src < lastSource; src++ )
+    {
+      // breadth first search, counting the shortest paths from the source
+      distances[ src ] = 0;
+      pathCounts[ src ] = 1;
+      queue[ 0 ] = src;
+      unsigned int queueEnd( 1 );
+      for( unsigned int head = 0; head < queueEnd; head++ )
+      {
+        unsigned int v = queue[ head ];
+        for( unsigned int a = offsets[ v ]; a < offsets[ v + 1 ]; a++ )
+        {
+          unsigned int w = adjacentVertices[ a ];
+          if( distances[ w ] < 0 )
+          {
+            distances[ w ] = distances[ v ] + 1;
+            queue[ queueEnd++ ] = w;
+          }
+          if( distances[ w ] == distances[ v ] + 1 )
+          {
+            pathCounts[ w ] += pathCounts[ v ];
+          }
+        }
+      }
+
+      std::vector< unsigned int >& histogram = ( *jobs->DistanceHistograms )[ src ];
+      histogram.assign( distances[ queue[ queueEnd - 1 ] ] + 1, 0 );
+      for( unsigned int i = 1; i < queueEnd; i++ )
+      {
+        histogram[ distances[ queue[ i ] ] ]++;
+      }
 
-    boost::breadth_first_search(*(m_Network->GetBoostGraph()), src,
-      visitor(all_pairs_shortest_recorder< NetworkType >
-      (&distances[0], max_distance, size)));
+      // accumulate the dependencies in order of non-increasing distance from the source
+      for( unsigned int i = queueEnd; i-- > 0; )
+      {
+        unsigned int w = queue[ i ];
+        for( unsigned int a = offsets[ w ]; a < offsets[ w + 1 ]; a++ )
+        {
+          unsigned int v = adjacentVertices[ a ];
+          if( distances[ v ] == distances[ w ] - 1 )
+          {
+            double factor = double( pathCounts[ v ] ) / double( pathCounts[ w ] );
+            factor *= 1.0 + dependencies[ w ];
+            dependencies[ v ] += factor;
+            edgeCentralities[ adjacentEdges[ a ] ] += factor;
+          }
+        }
+        if( w != src )
+        {
+          vertexCentralities[ w ] += dependencies[ w ];
+        }
+      }
 
-    for(index=0; index < distances.size(); index++)
+      for( unsigned int i = 0; i < queueEnd; i++ )
+      {
+        distances[ queue[ i ] ] = -1;
+        pathCounts[ queue[ i ] ] = 0;
+        dependencies[ queue[ i ] ] = 0.0;
+      }
+    }
+
+    // add all finished blocks in block order
+    jobs->Mutex.Lock();
+    jobs->BlockCentralities[ block ].swap( centralities );
+    jobs->BlockFinished[ block ] = true;
+    while( jobs->NextReducedBlock < jobs->NumberOfBlocks && jobs->BlockFinished[ jobs->NextReducedBlock ] )
     {
-      if(distances[index] > 0)
+      std::vector< double >& blockCentralities = jobs->BlockCentralities[ jobs->NextReducedBlock ];
+      for( unsigned int i = 0; i < numberOfVertices; i++ )
       {
-        bins[distances[index]]++;
+        ( *jobs->VertexCentralities )[ i ] += blockCentralities[ i ];
       }
+      for( unsigned int i = 0; i < jobs->NumberOfEdges; i++ )
+      {
+        ( *jobs->EdgeCentralities )[ i ] += blockCentralities[ numberOfVertices + i ];
+      }
+      std::vector< double >().swap( blockCentralities );
+      jobs->NextReducedBlock++;
+    }
+    jobs->Mutex.Unlock();
+  }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void mitk::ConnectomicsStatisticsCalculator::CalculateHopPlotValues()
+{
+  std::vector<int> bins( m_NumberOfVertices );
+
+  unsigned int index( 0 );
+
+  for( unsigned int src = 0; src < m_DistanceHistograms.size(); src++ )
+  {
+    for( index=1; index < m_DistanceHistograms[src].size(); index++ )
+    {
+      bins[index] += m_DistanceHistograms[src][index];
     }
   }
 
@@ -341,36 +498,18 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateClusteringCoefficients()
 
 void mitk::ConnectomicsStatisticsCalculator::CalculateBetweennessCentrality()
 {
-  // std::map used for convenient initialization
-  EdgeIndexStdMapType stdEdgeIndex;
+  // the centralities have been accumulated by CalculateAllPairsShortestPaths()
   // associative property map needed for iterator property map-wrapper
-  EdgeIndexMapType edgeIndex(stdEdgeIndex);
+  EdgeIndexMapType edgeIndex( m_EdgeIndices );
 
-  EdgeIteratorType iterator, end;
-
-  // sets iterator to start end end to end
-  boost::tie(iterator, end) = boost::edges( *(m_Network->GetBoostGraph()) );
-
-  int i(0);
-  for ( ; iterator != end; ++iterator, ++i)
-  {
-    stdEdgeIndex.insert(std::pair< EdgeDescriptorType, int >( *iterator, i));
-  }
-
-  // Define EdgeCentralityMap
-  m_VectorOfEdgeBetweennessCentralities.resize( m_NumberOfEdges, 0.0);
   // Create the external property map
   m_PropertyMapOfEdgeBetweennessCentralities = EdgeIteratorPropertyMapType(m_VectorOfEdgeBetweennessCentralities.begin(), edgeIndex);
 
   // Define VertexCentralityMap
   VertexIndexMapType vertexIndex = get(boost::vertex_index, *(m_Network->GetBoostGraph()) );
-  m_VectorOfVertexBetweennessCentralities.resize( m_NumberOfVertices, 0.0);
   // Create the external property map
   m_PropertyMapOfVertexBetweennessCentralities = VertexIteratorPropertyMapType(m_VectorOfVertexBetweennessCentralities.begin(), vertexIndex);
 
-  boost::brandes_betweenness_centrality( *(m_Network->GetBoostGraph()),
-    m_PropertyMapOfVertexBetweennessCentralities, m_PropertyMapOfEdgeBetweennessCentralities );
-
   m_AverageVertexBetweennessCentrality = std::accumulate(m_VectorOfVertexBetweennessCentralities.begin(),
     m_VectorOfVertexBetweennessCentralities.end(),
     0.0) / (double) m_NumberOfVertices;
@@ -406,7 +545,7 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateIsolatedAndEndPoints()
 
 /**
 * Calculates Shortest Path Related metrics of the graph.  The
-* function runs a BFS from each node to find out the shortest
+* function uses the BFS from each node to find out the shortest
 * distances to other nodes in the graph. The maximum of this distance
 * is called the eccentricity of that node. The maximum eccentricity
 * in the graph is called diameter and the minimum eccentricity is
@@ -421,7 +560,7 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateShortestPathMetrics()
   //store the eccentricities in a vector.
   m_VectorOfEccentrities.resize( m_NumberOfVertices );
   m_VectorOfEccentrities90.resize( m_NumberOfVertices );
-  m_VectorOfAveragePathLengths.resize( m_NumberOfVertices );
+  m_VectorOfAveragePathLengths.assign( m_NumberOfVertices, 0.0 );
 
   //assign diameter and radius while iterating over the ecccencirities.
   m_Diameter              = 0;
@@ -436,26 +575,18 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateShortestPathMetrics()
   unsigned int giant_component_size = 0;
   VertexDescriptorType radius_src(0);
 
-  //Loop over the vertices
-  for( boost::tie(vi, vi_end) = boost::vertices( *(m_Network->GetBoostGraph()) ); vi!=vi_end; ++vi)
+  //Loop over the vertices. The breadth first search from every vertex
+  //has been run by CalculateAllPairsShortestPaths(), that stored the
+  //number of nodes at each distance from the source in the distance
+  //histogram. The maximum distance is the last entry of the histogram,
+  //size gives the number of nodes discovered during the search.
+  for( VertexDescriptorType src = 0; src < m_DistanceHistograms.size(); src++ )
   {
-    //We are going to start a BFS, initialize the neccessary
-    //structures for that.  Store the distances of nodes from the
-    //source in distance vector. The maximum distance is stored in
-    //max. The BFS will start from the node that vi is pointing, that
-    //is the src is *vi. We also init the distance of the src node to
-    //itself to 0. size gives the number of nodes discovered during
-    //this BFS.
-    std::vector<int> distances( m_NumberOfVertices );
-    int max_distance = 0;
-    VertexDescriptorType src = *vi;
-    distances[src] = 0;
-    unsigned int size = 0;
-
-    breadth_first_search(*(m_Network->GetBoostGraph()), src,
-      visitor(all_pairs_shortest_recorder<NetworkType>
-      (&distances[0], max_distance, size)));
-    // vertex vi has eccentricity equal to max_distance
+    const std::vector<unsigned int>& bucket = m_DistanceHistograms[ src ];
+    int max_distance = bucket.size() - 1;
+    unsigned int size = std::accumulate( bucket.begin(), bucket.end(), 0u );
+
+    // vertex src has eccentricity equal to max_distance
     m_VectorOfEccentrities[src] = max_distance;
 
     //check whether there is any change in the diameter or the radius.
@@ -480,27 +611,18 @@ void mitk::ConnectomicsStatisticsCalculator::CalculateShortestPathMetrics()
     }
 
     //Calculate in how many hops we can reach 90 percent of the
-    //nodes. We store the number of hops we can reach in h hops in the
-    //bucket vector. That is bucket[h] gives the number of nodes
-    //reachable in exactly h hops. sum of bucket[i<h] gives the number
-    //of nodes that are reachable in less than h hops. We also
-    //calculate sum of the distances from this node to every single
-    //other node in the graph.
+    //nodes. bucket[h] gives the number of nodes reachable in exactly h
+    //hops. sum of bucket[i<h] gives the number of nodes that are
+    //reachable in less than h hops. We also calculate the average of
+    //the distances from this node to every other reachable node.
     int reachable90 = std::ceil((double)size * 0.9);
-    std::vector <int> bucket (max_distance+1);
-    int counter = 0;
-    for(unsigned int i=0; i<distances.size(); i++)
+    for(unsigned int h=1; h<bucket.size(); h++)
     {
-      if(distances[i]>0)
-      {
-        bucket[distances[i]]++;
-        m_VectorOfAveragePathLengths[src] += distances[i];
-        counter ++;
-      }
+      m_VectorOfAveragePathLengths[src] += (double) h * bucket[h];
     }
-    if(counter > 0)
+    if(size > 0)
     {
-      m_VectorOfAveragePathLengths[src] = m_VectorOfAveragePathLengths[src] / counter;
+      m_VectorOfAveragePathLengths[src] = m_VectorOfAveragePathLengths[src] / size;
     }
 
     int eccentricity90 = 0;
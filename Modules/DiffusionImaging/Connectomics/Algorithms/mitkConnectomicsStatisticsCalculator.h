@@ -20,6 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkObject.h>
 #include <itkObjectFactory.h>
 #include <itkMacro.h>
+#include <itkMultiThreader.h>
 
 #include "mitkCommon.h"
 
@@ -30,7 +31,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 namespace mitk
 {
   /**
-  * \brief A class giving functions for calculating a variety of network indices */
+  * \brief A class giving functions for calculating a variety of network indices
+  *
+  * The shortest path and betweenness based indices are calculated from one breadth first search per vertex.
+  * These searches are distributed over NumberOfThreads threads, the results do not depend on the number of threads. */
   class MitkConnectomics_EXPORT ConnectomicsStatisticsCalculator : public itk::Object
   {
   public:
@@ -49,6 +53,7 @@ namespace mitk
     typedef boost::graph_traits<NetworkType>::vertex_iterator VertexIteratorType;
     typedef boost::graph_traits<NetworkType>::edge_iterator EdgeIteratorType;
     typedef boost::graph_traits<NetworkType>::adjacency_iterator AdjacencyIteratorType;
+    typedef boost::graph_traits<NetworkType>::out_edge_iterator OutEdgeIteratorType;
     typedef std::map<EdgeDescriptorType, int> EdgeIndexStdMapType;
     typedef boost::associative_property_map< EdgeIndexStdMapType > EdgeIndexMapType;
     typedef boost::iterator_property_map< std::vector< double >::iterator, EdgeIndexMapType > EdgeIteratorPropertyMapType;
@@ -57,6 +62,8 @@ namespace mitk
 
     // Set/Get Macros
     itkSetObjectMacro( Network, mitk::ConnectomicsNetwork );
+    itkSetMacro( NumberOfThreads, unsigned int );
+    itkGetMacro( NumberOfThreads, unsigned int );
     itkGetMacro( NumberOfVertices, unsigned int );
     itkGetMacro( NumberOfEdges, unsigned int );
     itkGetMacro( AverageDegree, double );
@@ -139,6 +146,16 @@ namespace mitk
 
     void CalculateRatioOfNodesInLargestComponent();
 
+    /**
+    * \brief Run a breadth first search from every vertex
+    *
+    * Stores the number of vertices at each distance from every vertex and accumulates the vertex and
+    * edge betweenness centralities (Brandes, 2001). The sources are processed in blocks, each block by
+    * one thread. The contributions of a block are summed in source order and the blocks are added in
+    * block order, so the result is the same for any number of threads.
+    */
+    void CalculateAllPairsShortestPaths();
+
     void CalculateHopPlotValues();
 
     /**
@@ -173,11 +190,25 @@ namespace mitk
      */
     void CalculateSmallWorldness();
 
+    // Breadth first searches of one thread
+    static ITK_THREAD_RETURN_TYPE AllPairsShortestPathsCallback( void* arg );
+
+    struct Jobs;
+
     /////////////////////// Variables ////////////////////////
 
     // The connectomics network, which is used for statistics calculation
     mitk::ConnectomicsNetwork::Pointer m_Network;
 
+    // Number of threads for the breadth first searches, default is the global default of the multithreader
+    unsigned int m_NumberOfThreads;
+
+    // Index of every edge in the edge betweenness vector
+    EdgeIndexStdMapType m_EdgeIndices;
+
+    // For every source vertex the number of vertices at distance 0 <= d <= eccentricity (without the source)
+    std::vector< std::vector< unsigned int > > m_DistanceHistograms;
+
     // Statistics
     unsigned int m_NumberOfVertices;
     unsigned int m_NumberOfEdges;
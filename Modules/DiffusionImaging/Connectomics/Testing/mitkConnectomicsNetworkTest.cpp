@@ -514,6 +514,24 @@ int mitkConnectomicsNetworkTest(int argc, char* argv[])
 
     bool noInternalThreeModuleModularity( std::abs(-0.3395 - costFunction->CalculateModularity( network, &noInternalLinksThreeModuleSolution )) < eps);
     MITK_TEST_CONDITION_REQUIRED( noInternalThreeModuleModularity, "Expected three module modularity containing no internal links")
+
+    // Test simulated annealing with four chains in parallel
+    permutation->SetCostFunction( costFunction.GetPointer() );
+    permutation->SetNetwork( network );
+    permutation->SetDepth( 1 );
+    permutation->SetStepSize( 4.0 );
+    manager->SetPermutation( permutation.GetPointer() );
+    manager->SetNumberOfChains( 4 );
+    manager->RunSimulatedAnnealing( 2.0, 4.0 );
+
+    ToModuleMapType annealedSolution = permutation->GetMapping();
+    bool completeAnnealedSolution( annealedSolution.size() == vertexInVector.size() );
+    for( int module( 0 ); module < permutation->getNumberOfModules( &annealedSolution ); module++ )
+    {
+      completeAnnealedSolution = completeAnnealedSolution && permutation->getNumberOfVerticesInModule( &annealedSolution, module ) > 0;
+    }
+    MITK_TEST_CONDITION_REQUIRED( completeAnnealedSolution, "Parallel tempering assigns every vertex to a non-empty module")
+    MITK_TEST_CONDITION_REQUIRED( costFunction->CalculateModularity( network, &annealedSolution ) > 0.0, "Parallel tempering finds a modular solution")
   }
   catch (...)
   {
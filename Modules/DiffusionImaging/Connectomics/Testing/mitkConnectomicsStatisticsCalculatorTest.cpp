@@ -32,6 +32,7 @@ class mitkConnectomicsStatisticsCalculatorTestSuite : public mitk::TestFixture
 {
   CPPUNIT_TEST_SUITE(mitkConnectomicsStatisticsCalculatorTestSuite);
   MITK_TEST(StatisticsCalculatorUpdate);
+  MITK_TEST(StatisticsCalculatorNumberOfThreads);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -132,6 +133,75 @@ public:
     CPPUNIT_ASSERT_MESSAGE( "GetSmallWorldness", mitk::Equal( statisticsCalculator->GetSmallWorldness( ), 1.72908 , eps, true ) );
 
   }
+
+  /**
+  * @brief Creates a connected network of ring edges and chords, with enough vertices to be split into several blocks of source vertices.
+  */
+  mitk::ConnectomicsNetwork::Pointer CreateSyntheticNetwork( int numberOfVertices )
+  {
+    mitk::ConnectomicsNetwork::Pointer network = mitk::ConnectomicsNetwork::New();
+
+    std::vector< mitk::ConnectomicsNetwork::VertexDescriptorType > vertices;
+    for( int i = 0; i < numberOfVertices; i++ )
+    {
+      vertices.push_back( network->AddVertex( i ) );
+    }
+
+    for( int i = 0; i < numberOfVertices; i++ )
+    {
+      int neighbour = ( i + 1 ) % numberOfVertices;
+      int chord = ( i * 37 + 11 ) % numberOfVertices;
+      network->AddEdge( vertices[ i ], vertices[ neighbour ] );
+      if( chord != i && !network->EdgeExists( vertices[ i ], vertices[ chord ] ) )
+      {
+        network->AddEdge( vertices[ i ], vertices[ chord ] );
+      }
+    }
+
+    return network;
+  }
+
+  void StatisticsCalculatorNumberOfThreads()
+  {
+    // 5 blocks of 64 source vertices
+    mitk::ConnectomicsNetwork::Pointer network = CreateSyntheticNetwork( 5 * 64 - 7 );
+
+    mitk::ConnectomicsStatisticsCalculator::Pointer singleThreaded = mitk::ConnectomicsStatisticsCalculator::New();
+    singleThreaded->SetNetwork( network );
+    singleThreaded->SetNumberOfThreads( 1 );
+    singleThreaded->Update();
+
+    mitk::ConnectomicsStatisticsCalculator::Pointer multiThreaded = mitk::ConnectomicsStatisticsCalculator::New();
+    multiThreaded->SetNetwork( network );
+    multiThreaded->SetNumberOfThreads( 4 );
+    multiThreaded->Update();
+
+    // the reference is computed by boost::brandes_betweenness_centrality
+    std::vector< double > vertexReference = network->GetNodeBetweennessVector();
+    std::vector< double > edgeReference = network->GetEdgeBetweennessVector();
+    std::vector< double > vertexCentralities = singleThreaded->GetVectorOfVertexBetweennessCentralities();
+    std::vector< double > edgeCentralities = singleThreaded->GetVectorOfEdgeBetweennessCentralities();
+
+    double eps( 0.0001 );
+    CPPUNIT_ASSERT_MESSAGE( "Number of vertex centralities", vertexCentralities.size() == vertexReference.size() );
+    CPPUNIT_ASSERT_MESSAGE( "Number of edge centralities", edgeCentralities.size() == edgeReference.size() );
+    for( unsigned int i = 0; i < vertexReference.size(); i++ )
+    {
+      CPPUNIT_ASSERT_MESSAGE( "VertexBetweennessCentrality equals brandes", mitk::Equal( vertexCentralities[ i ], vertexReference[ i ], eps, true ) );
+    }
+    for( unsigned int i = 0; i < edgeReference.size(); i++ )
+    {
+      CPPUNIT_ASSERT_MESSAGE( "EdgeBetweennessCentrality equals brandes", mitk::Equal( edgeCentralities[ i ], edgeReference[ i ], eps, true ) );
+    }
+
+    // the results must be identical, not only equal up to rounding
+    CPPUNIT_ASSERT_MESSAGE( "VertexBetweennessCentralities", singleThreaded->GetVectorOfVertexBetweennessCentralities() == multiThreaded->GetVectorOfVertexBetweennessCentralities() );
+    CPPUNIT_ASSERT_MESSAGE( "EdgeBetweennessCentralities", singleThreaded->GetVectorOfEdgeBetweennessCentralities() == multiThreaded->GetVectorOfEdgeBetweennessCentralities() );
+    CPPUNIT_ASSERT_MESSAGE( "Eccentricities", singleThreaded->GetVectorOfEccentrities() == multiThreaded->GetVectorOfEccentrities() );
+    CPPUNIT_ASSERT_MESSAGE( "Eccentricities90", singleThreaded->GetVectorOfEccentrities90() == multiThreaded->GetVectorOfEccentrities90() );
+    CPPUNIT_ASSERT_MESSAGE( "AveragePathLengths", singleThreaded->GetVectorOfAveragePathLengths() == multiThreaded->GetVectorOfAveragePathLengths() );
+    CPPUNIT_ASSERT_MESSAGE( "HopPlotExponent", singleThreaded->GetHopPlotExponent() == multiThreaded->GetHopPlotExponent() );
+  }
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkConnectomicsStatisticsCalculator)
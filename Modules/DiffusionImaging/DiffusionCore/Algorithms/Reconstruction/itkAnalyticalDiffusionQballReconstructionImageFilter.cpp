@@ -148,18 +148,17 @@ template<
         class TOdfPixelType,
         int NOrderL,
         int NrOdfDirections>
-vnl_vector<TOdfPixelType>
+void
 itk::AnalyticalDiffusionQballReconstructionImageFilter
 <TReferenceImagePixelType, TGradientImagePixelType, TOdfPixelType,
 NOrderL, NrOdfDirections>
-::PreNormalize( vnl_vector<TOdfPixelType> vec,
+::PreNormalize( vnl_vector<TOdfPixelType>& vec,
                 typename NumericTraits<ReferencePixelType>::AccumulateType b0 )
 {
     switch( m_NormalizationMethod )
     {
     case QBAR_STANDARD:
     {
-        return vec;
         break;
     }
     case QBAR_B_ZERO_B_VALUE:
@@ -172,17 +171,14 @@ NOrderL, NrOdfDirections>
 
             vec[i] = log(vec[i]);
         }
-        return vec;
         break;
     }
     case QBAR_B_ZERO:
     {
-        return vec;
         break;
     }
     case QBAR_NONE:
     {
-        return vec;
         break;
     }
     case QBAR_ADC_ONLY:
@@ -195,12 +191,10 @@ NOrderL, NrOdfDirections>
 
             vec[i] = log(vec[i]);
         }
-        return vec;
         break;
     }
     case QBAR_RAW_SIGNAL:
     {
-        return vec;
         break;
     }
     case QBAR_SOLID_ANGLE:
@@ -223,12 +217,9 @@ NOrderL, NrOdfDirections>
 
             vec[i] = log(-log(vec[i]));
         }
-        return vec;
         break;
     }
     }
-
-    return vec;
 }
 
 template< class T, class TG, class TO, int L, int NODF>
@@ -258,6 +249,11 @@ void AnalyticalDiffusionQballReconstructionImageFilter<T,TG,TO,L,NODF>
     }
 
     this->ComputeReconstructionMatrix();
+    m_CoeffBlockProduct.SetMatrix(*m_CoeffReconstructionMatrix);
+    if(m_NormalizationMethod == QBAR_SOLID_ANGLE)
+        m_OdfBlockProduct.SetMatrix(*m_SphericalHarmonicBasisMatrix);
+    else
+        m_OdfBlockProduct.SetMatrix(*m_ReconstructionMatrix);
 
     typename GradientImagesType::Pointer img = static_cast< GradientImagesType * >(
                 this->ProcessObject::GetInput(0) );
@@ -344,74 +340,95 @@ void AnalyticalDiffusionQballReconstructionImageFilter<T,TG,TO,L,NODF>
             gradientind.push_back(gradientind[i]);
     }
 
+    // the voxels are reconstructed in blocks, see BlockMatrixProduct
+    const unsigned int blockSize = BlockMatrixProduct<TO>::BlockSize;
+    std::vector<TO> signals(m_NumberOfGradientDirections*blockSize);
+    std::vector<TO> coeffs(m_NumberCoefficients*blockSize);
+    std::vector<TO> odfs(NODF*blockSize);
+    std::vector< typename NumericTraits<ReferencePixelType>::AccumulateType > b0s(blockSize);
+    std::vector<int> columns(blockSize);    // column of each voxel in the block, -1 if below threshold
+    vnl_vector<TO> B(m_NumberOfGradientDirections);
+
     while( !git.IsAtEnd() )
     {
-        GradientVectorType b = git.Get();
-
-        typename NumericTraits<ReferencePixelType>::AccumulateType b0 = NumericTraits<ReferencePixelType>::Zero;
-
-        // Average the baseline image pixels
-        for(unsigned int i = 0; i < baselineind.size(); ++i)
+        // gather the pre-normalized signals of the next voxels
+        unsigned int numVoxels = 0;
+        unsigned int numColumns = 0;
+        for( ; numVoxels<blockSize && !git.IsAtEnd(); ++numVoxels, ++git )
         {
-            b0 += b[baselineind[i]];
-        }
-        b0 /= this->m_NumberOfBaselineImages;
+            GradientVectorType b = git.Get();
 
-        OdfPixelType odf(0.0);
-        typename CoefficientImageType::PixelType coeffPixel(0.0);
-        vnl_vector<TO> B(m_NumberOfGradientDirections);
+            typename NumericTraits<ReferencePixelType>::AccumulateType b0 = NumericTraits<ReferencePixelType>::Zero;
 
-        if( (b0 != 0) && (b0 >= m_Threshold) )
-        {
-            for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+            // Average the baseline image pixels
+            for(unsigned int i = 0; i < baselineind.size(); ++i)
             {
-                B[i] = static_cast<TO>(b[gradientind[i]]);
+                b0 += b[baselineind[i]];
             }
+            b0 /= this->m_NumberOfBaselineImages;
+            b0s[numVoxels] = b0;
+            columns[numVoxels] = -1;
 
-            B = PreNormalize(B, b0);
-            if(m_NormalizationMethod == QBAR_SOLID_ANGLE)
-            {
-                vnl_vector<TO> coeffs(m_NumberCoefficients);
-                coeffs = ( (*m_CoeffReconstructionMatrix) * B );
-                coeffs[0] += 1.0/(2.0*sqrt(QBALL_ANAL_RECON_PI));
-                odf = ( (*m_SphericalHarmonicBasisMatrix) * coeffs ).data_block();
-                coeffPixel = coeffs.data_block();
-            }
-            else if(m_NormalizationMethod == QBAR_NONNEG_SOLID_ANGLE)
+            if( (b0 != 0) && (b0 >= m_Threshold) )
             {
-                /** this would be the place to implement a non-negative
-              * solver for quadratic programming problem:
-              * min .5*|| Bc-s ||^2 subject to -CLPc <= 4*pi*ones
-              * (refer to MICCAI 2009 Goh et al. "Estimating ODFs with PDF constraints")
-              * .5*|| Bc-s ||^2 == .5*c'B'Bc - x'B's + .5*s's
-              */
-
-                itkExceptionMacro( << "Nonnegative Solid Angle not yet implemented");
+                for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+                {
+                    B[i] = static_cast<TO>(b[gradientind[i]]);
+                }
+
+                PreNormalize(B, b0);
+                for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+                    signals[i*blockSize+numColumns] = B[i];
+                columns[numVoxels] = numColumns++;
             }
-            else
+        }
+
+        if(m_NormalizationMethod == QBAR_NONNEG_SOLID_ANGLE && numColumns>0)
+        {
+            /** this would be the place to implement a non-negative
+          * solver for quadratic programming problem:
+          * min .5*|| Bc-s ||^2 subject to -CLPc <= 4*pi*ones
+          * (refer to MICCAI 2009 Goh et al. "Estimating ODFs with PDF constraints")
+          * .5*|| Bc-s ||^2 == .5*c'B'Bc - x'B's + .5*s's
+          */
+
+            itkExceptionMacro( << "Nonnegative Solid Angle not yet implemented");
+        }
+
+        m_CoeffBlockProduct.Multiply(&signals[0], &coeffs[0], numColumns);
+        for( unsigned int c=0; c<numColumns; c++ )
+            coeffs[c] += 1.0/(2.0*sqrt(QBALL_ANAL_RECON_PI));
+        if(m_NormalizationMethod == QBAR_SOLID_ANGLE)
+            m_OdfBlockProduct.Multiply(&coeffs[0], &odfs[0], numColumns);
+        else
+            m_OdfBlockProduct.Multiply(&signals[0], &odfs[0], numColumns);
+
+        // normalize the results while writing them to the outputs
+        for( unsigned int v=0; v<numVoxels; v++ )
+        {
+            OdfPixelType odf(0.0);
+            typename CoefficientImageType::PixelType coeffPixel(0.0);
+            if( columns[v]>=0 )
             {
-                vnl_vector<TO> coeffs(m_NumberCoefficients);
-                coeffs = ( (*m_CoeffReconstructionMatrix) * B );
-                coeffs[0] += 1.0/(2.0*sqrt(QBALL_ANAL_RECON_PI));
-                coeffPixel = coeffs.data_block();
-                odf = ( (*m_ReconstructionMatrix) * B ).data_block();
+                for( int k=0; k<NODF; k++ )
+                    odf[k] = odfs[k*blockSize+columns[v]];
+                for( int k=0; k<m_NumberCoefficients; k++ )
+                    coeffPixel[k] = coeffs[k*blockSize+columns[v]];
+                odf = Normalize(odf, b0s[v]);
             }
-            odf = Normalize(odf, b0);
 
+            oit.Set( odf );
+            oit2.Set( b0s[v] );
+            float sum = 0;
+            for (unsigned int k=0; k<odf.Size(); k++)
+                sum += (float) odf[k];
+            oit3.Set( sum-1 );
+            oit4.Set(coeffPixel);
+            ++oit;  // odf image iterator
+            ++oit3; // odf sum image iterator
+            ++oit2; // b0 image iterator
+            ++oit4; // coefficient image iterator
         }
-
-        oit.Set( odf );
-        oit2.Set( b0 );
-        float sum = 0;
-        for (unsigned int k=0; k<odf.Size(); k++)
-            sum += (float) odf[k];
-        oit3.Set( sum-1 );
-        oit4.Set(coeffPixel);
-        ++oit;  // odf image iterator
-        ++oit3; // odf sum image iterator
-        ++oit2; // b0 image iterator
-        ++oit4; // coefficient image iterator
-        ++git;  // Gradient  image iterator
     }
 
     std::cout << "One Thread finished reconstruction" << std::endl;
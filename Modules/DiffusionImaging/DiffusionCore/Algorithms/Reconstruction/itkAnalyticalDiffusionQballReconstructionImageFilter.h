@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vnl/algo/vnl_svd.h"
 #include "itkVectorContainer.h"
 #include "itkVectorImage.h"
+#include "itkBlockMatrixProduct.h"
 
 
 namespace itk{
@@ -191,7 +192,7 @@ public:
     double Legendre0(int l);
 
     OdfPixelType Normalize(OdfPixelType odf, typename NumericTraits<ReferencePixelType>::AccumulateType b0 );
-    vnl_vector<TOdfPixelType> PreNormalize( vnl_vector<TOdfPixelType> vec, typename NumericTraits<ReferencePixelType>::AccumulateType b0  );
+    void PreNormalize( vnl_vector<TOdfPixelType>& vec, typename NumericTraits<ReferencePixelType>::AccumulateType b0  );
 
     /** Threshold on the reference image data. The output ODF will be a null
    * pdf for pixels in the reference image that have a value less than this
@@ -252,6 +253,10 @@ private:
     OdfReconstructionMatrixType                       m_ReconstructionMatrix;
     OdfReconstructionMatrixType                       m_CoeffReconstructionMatrix;
     OdfReconstructionMatrixType                       m_SphericalHarmonicBasisMatrix;
+    /** m_CoeffReconstructionMatrix applied to blocks of voxels */
+    BlockMatrixProduct<TOdfPixelType>                 m_CoeffBlockProduct;
+    /** m_SphericalHarmonicBasisMatrix (solid angle) or m_ReconstructionMatrix applied to blocks of voxels */
+    BlockMatrixProduct<TOdfPixelType>                 m_OdfBlockProduct;
     /** container to hold gradient directions */
     GradientDirectionContainerType::Pointer           m_GradientDirectionContainer;
     /** Number of gradient measurements */
@@ -0,0 +1,122 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef __itkBlockMatrixProduct_h_
+#define __itkBlockMatrixProduct_h_
+
+#include <vnl/vnl_matrix.h>
+#include <vector>
+
+namespace itk{
+
+/** \class BlockMatrixProduct
+ * \brief Applies a reconstruction matrix to a block of voxels at once.
+ *
+ * The reconstruction filters gather the (pre-normalized) signals of up to BlockSize voxels into one block,
+ * a (number of matrix columns x BlockSize) matrix that stores the values of one measurement for all voxels
+ * consecutively. Multiply() computes the product of the reconstruction matrix and such a block. Four rows of the
+ * result are computed at once, so every signal value is loaded once per four rows, and the innermost loop runs
+ * over the consecutive voxels of the block and is vectorized by the compiler. A block of signals fits into the
+ * first level cache for typical numbers of gradient directions.
+ *
+ * The values of the result are accumulated in the same order as in the product of the vnl matrix and a single
+ * signal vector.
+ */
+template< class TValue >
+class BlockMatrixProduct
+{
+public:
+
+  enum { BlockSize = 64 };   ///< Number of voxels per block.
+
+  BlockMatrixProduct() : m_NumberOfRows(0), m_NumberOfColumns(0) {}
+
+  template< class TMatrixValue >
+  void SetMatrix(const vnl_matrix< TMatrixValue >& matrix)
+  {
+    m_NumberOfRows = matrix.rows();
+    m_NumberOfColumns = matrix.cols();
+    m_Matrix.resize(m_NumberOfRows*m_NumberOfColumns);
+    for (unsigned int r=0; r<m_NumberOfRows; r++)
+      for (unsigned int c=0; c<m_NumberOfColumns; c++)
+        m_Matrix[r*m_NumberOfColumns+c] = static_cast<TValue>(matrix(r,c));
+  }
+
+  unsigned int GetNumberOfRows() const { return m_NumberOfRows; }
+  unsigned int GetNumberOfColumns() const { return m_NumberOfColumns; }
+
+  /** result = matrix * block. The block has GetNumberOfColumns() rows, the result GetNumberOfRows() rows, both have
+   *  BlockSize columns. Only the first numVoxels columns are used. */
+  void Multiply(const TValue* block, TValue* result, unsigned int numVoxels) const
+  {
+    unsigned int r = 0;
+    for (; r+4<=m_NumberOfRows; r+=4)
+    {
+      TValue* y0 = result + r*BlockSize;
+      TValue* y1 = y0 + BlockSize;
+      TValue* y2 = y1 + BlockSize;
+      TValue* y3 = y2 + BlockSize;
+      const TValue* m0 = &m_Matrix[r*m_NumberOfColumns];
+      const TValue* m1 = m0 + m_NumberOfColumns;
+      const TValue* m2 = m1 + m_NumberOfColumns;
+      const TValue* m3 = m2 + m_NumberOfColumns;
+
+      for (unsigned int v=0; v<numVoxels; v++)
+        y0[v] = y1[v] = y2[v] = y3[v] = 0;
+
+      for (unsigned int c=0; c<m_NumberOfColumns; c++)
+      {
+        const TValue* x = block + c*BlockSize;
+        const TValue a0 = m0[c];
+        const TValue a1 = m1[c];
+        const TValue a2 = m2[c];
+        const TValue a3 = m3[c];
+        for (unsigned int v=0; v<numVoxels; v++)
+        {
+          y0[v] += a0*x[v];
+          y1[v] += a1*x[v];
+          y2[v] += a2*x[v];
+          y3[v] += a3*x[v];
+        }
+      }
+    }
+
+    for (; r<m_NumberOfRows; r++)
+    {
+      TValue* y = result + r*BlockSize;
+      const TValue* m = &m_Matrix[r*m_NumberOfColumns];
+      for (unsigned int v=0; v<numVoxels; v++)
+        y[v] = 0;
+      for (unsigned int c=0; c<m_NumberOfColumns; c++)
+      {
+        const TValue* x = block + c*BlockSize;
+        const TValue a = m[c];
+        for (unsigned int v=0; v<numVoxels; v++)
+          y[v] += a*x[v];
+      }
+    }
+  }
+
+private:
+
+  std::vector< TValue >   m_Matrix;           ///< row major
+  unsigned int            m_NumberOfRows;
+  unsigned int            m_NumberOfColumns;
+};
+
+}
+
+#endif //__itkBlockMatrixProduct_h_
@@ -574,6 +574,8 @@ void DiffusionMultiShellQballReconstructionImageFilter<T,TG,TO,L,NODF>
     it++; // skip b0 entry
     IndiciesVector shell = it->second;
     ComputeReconstructionMatrix(shell);
+    m_CoeffBlockProduct.SetMatrix(*m_CoeffReconstructionMatrix);
+    m_ODFBlockProduct.SetMatrix(*m_ODFSphericalHarmonicBasisMatrix);
   }
 
 }
@@ -633,52 +635,76 @@ void DiffusionMultiShellQballReconstructionImageFilter<T,TG,TO,L,NODF>
 
   typedef typename GradientImagesType::PixelType         GradientVectorType;
 
+  // the voxels are reconstructed in blocks, see BlockMatrixProduct
+  const unsigned int blockSize = BlockMatrixProduct< double >::BlockSize;
+  std::vector<double> signals(NumbersOfGradientIndicies*blockSize);
+  std::vector<double> coeffs(m_CoeffBlockProduct.GetNumberOfRows()*blockSize);
+  std::vector<double> odfs(NODF*blockSize);
+  std::vector<int> columns(blockSize);    // column of each voxel in the block, -1 if below threshold
+  vnl_vector<double> SignalVector(NumbersOfGradientIndicies);
+
   // iterate overall voxels of the gradient image region
   while( ! git.IsAtEnd() )
   {
-    GradientVectorType b = git.Get();
-    // ODF Vector
-    OdfPixelType odf(0.0);
-
-    double b0average = 0;
-    const unsigned int b0size = BZeroIndicies.size();
-    for(unsigned int i = 0; i < b0size ; ++i)
-    {
-      b0average += b[BZeroIndicies[i]];
-    }
-    b0average /= b0size;
-    bzeroIterator.Set(b0average);
-    ++bzeroIterator;
-
-    // Create the Signal Vector
-    vnl_vector<double> SignalVector(NumbersOfGradientIndicies);
-    if( (b0average != 0) && (b0average >= m_Threshold) )
+    // gather the normalized signals of the next voxels
+    unsigned int numVoxels = 0;
+    unsigned int numColumns = 0;
+    for( ; numVoxels<blockSize && !git.IsAtEnd(); ++numVoxels, ++git )
     {
+      GradientVectorType b = git.Get();
 
-      for( unsigned int i = 0; i< SignalIndicies.size(); i++ )
+      double b0average = 0;
+      const unsigned int b0size = BZeroIndicies.size();
+      for(unsigned int i = 0; i < b0size ; ++i)
       {
-        SignalVector[i] = static_cast<double>(b[SignalIndicies[i]]);
+        b0average += b[BZeroIndicies[i]];
       }
+      b0average /= b0size;
+      bzeroIterator.Set(b0average);
+      ++bzeroIterator;
+
+      columns[numVoxels] = -1;
+      if( (b0average != 0) && (b0average >= m_Threshold) )
+      {
 
-      // apply threashold an generate ln(-ln(E)) signal
-      // Replace SignalVector with PreNormalized SignalVector
-      S_S0Normalization(SignalVector, b0average);
-      Projection1(SignalVector);
+        for( unsigned int i = 0; i< SignalIndicies.size(); i++ )
+        {
+          SignalVector[i] = static_cast<double>(b[SignalIndicies[i]]);
+        }
 
-      DoubleLogarithm(SignalVector);
+        // apply threashold an generate ln(-ln(E)) signal
+        // Replace SignalVector with PreNormalized SignalVector
+        S_S0Normalization(SignalVector, b0average);
+        Projection1(SignalVector);
 
-      // approximate ODF coeffs
-      vnl_vector<double>  coeffs = ( (*m_CoeffReconstructionMatrix) * SignalVector );
-      coeffs[0] = 1.0/(2.0*sqrt(M_PI));
+        DoubleLogarithm(SignalVector);
 
-      odf = element_cast<double, TO>(( (*m_ODFSphericalHarmonicBasisMatrix) * coeffs )).data_block();
-      odf *= (M_PI*4/NODF);
+        for( unsigned int i = 0; i< NumbersOfGradientIndicies; i++ )
+          signals[i*blockSize+numColumns] = SignalVector[i];
+        columns[numVoxels] = numColumns++;
+      }
     }
-    // set ODF to ODF-Image
-    oit.Set( odf );
-    ++oit;
-    ++git;
 
+    // approximate ODF coeffs, the first coeff is a fix value
+    m_CoeffBlockProduct.Multiply(&signals[0], &coeffs[0], numColumns);
+    for( unsigned int c=0; c<numColumns; c++ )
+      coeffs[c] = 1.0/(2.0*sqrt(M_PI));
+    m_ODFBlockProduct.Multiply(&coeffs[0], &odfs[0], numColumns);
+
+    for( unsigned int v=0; v<numVoxels; v++ )
+    {
+      // ODF Vector
+      OdfPixelType odf(0.0);
+      if( columns[v]>=0 )
+      {
+        for( int k=0; k<NODF; k++ )
+          odf[k] = static_cast<TO>(odfs[k*blockSize+columns[v]]);
+        odf *= (M_PI*4/NODF);
+      }
+      // set ODF to ODF-Image
+      oit.Set( odf );
+      ++oit;
+    }
   }
 
   MITK_INFO << "One Thread finished reconstruction";
@@ -18,6 +18,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #define __itkDiffusionMultiShellQballReconstructionImageFilter_h_
 
 #include <itkImageToImageFilter.h>
+#include "itkBlockMatrixProduct.h"
 
 namespace itk{
 /** \class DiffusionMultiShellQballReconstructionImageFilter
@@ -139,6 +140,10 @@ private:
     vnl_matrix< double > * m_CoeffReconstructionMatrix;
     vnl_matrix< double > * m_ODFSphericalHarmonicBasisMatrix;
 
+    /** m_CoeffReconstructionMatrix and m_ODFSphericalHarmonicBasisMatrix applied to blocks of voxels (single shell) */
+    BlockMatrixProduct< double > m_CoeffBlockProduct;
+    BlockMatrixProduct< double > m_ODFBlockProduct;
+
     /** container to hold gradient directions */
     GradientDirectionContainerType::Pointer m_GradientDirectionContainer;
 
@@ -24,6 +24,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vnl/algo/vnl_svd.h"
 #include "itkVectorContainer.h"
 #include "itkVectorImage.h"
+#include "itkBlockMatrixProduct.h"
 
 namespace itk{
 /** \class DiffusionQballReconstructionImageFilter
@@ -230,7 +231,7 @@ public:
   /** Normalization performed on diffusion signal vector according
   * to method set in m_NormalizationMethod
   */
-  vnl_vector<TOdfPixelType> PreNormalize( vnl_vector<TOdfPixelType> vec );
+  void PreNormalize( vnl_vector<TOdfPixelType>& vec );
 
   /** Threshold on the reference image data. The output ODF will be a null
    * pdf for pixels in the reference image that have a value less than this
@@ -298,6 +299,9 @@ private:
   /* Tensor basis coeffs */
   OdfReconstructionMatrixType                       m_ReconstructionMatrix;
 
+  /** m_ReconstructionMatrix applied to blocks of voxels */
+  BlockMatrixProduct<TOdfPixelType>                 m_BlockProduct;
+
   /** container to hold gradient directions */
   GradientDirectionContainerType::Pointer           m_GradientDirectionContainer;
 
@@ -94,6 +94,7 @@ namespace itk {
     // Compute reconstruction matrix that is multiplied to the data-vector
     // each voxel in order to reconstruct the ODFs
     this->ComputeReconstructionMatrix();
+    m_BlockProduct.SetMatrix(*m_ReconstructionMatrix);
 
     // Allocate the b-zero image
     m_BZeroImage = BZeroImageType::New();
@@ -174,14 +175,13 @@ namespace itk {
   class TOdfPixelType,
     int NrOdfDirections,
     int NrBasisFunctionCenters >
-    vnl_vector<TOdfPixelType> itk::DiffusionQballReconstructionImageFilter<TReferenceImagePixelType, TGradientImagePixelType, TOdfPixelType, NrOdfDirections, NrBasisFunctionCenters>::PreNormalize( vnl_vector<TOdfPixelType> vec )
+    void itk::DiffusionQballReconstructionImageFilter<TReferenceImagePixelType, TGradientImagePixelType, TOdfPixelType, NrOdfDirections, NrBasisFunctionCenters>::PreNormalize( vnl_vector<TOdfPixelType>& vec )
   {
     switch( m_NormalizationMethod )
     {
       // standard: no normalization before reconstruction
     case QBR_STANDARD:
       {
-        return vec;
         break;
       }
       // log of signal
@@ -192,24 +192,19 @@ namespace itk {
         {
           vec[i] = log(vec[i]);
         }
-        return vec;
         break;
       }
       // no normalization before reconstruction here
     case QBR_B_ZERO:
       {
-        return vec;
         break;
       }
       // no normalization before reconstruction here
     case QBR_NONE:
       {
-        return vec;
         break;
       }
     }
-
-    return vec;
   }
 
   template< class TReferenceImagePixelType,
@@ -291,7 +286,7 @@ namespace itk {
           }
 
           // pre-normalization according to m_NormalizationMethod
-          B = PreNormalize(B);
+          PreNormalize(B);
 
           // actual reconstruction
           odf = ( (*m_ReconstructionMatrix) * B ).data_block();
@@ -364,53 +359,76 @@ namespace itk {
           gradientind.push_back(gradientind[i]);
       }
 
+      // the voxels are reconstructed in blocks, see BlockMatrixProduct
+      const unsigned int blockSize = BlockMatrixProduct<TOdfPixelType>::BlockSize;
+      std::vector<TOdfPixelType> signals(m_NumberOfGradientDirections*blockSize);
+      std::vector<TOdfPixelType> odfs(NrOdfDirections*blockSize);
+      std::vector< typename NumericTraits<ReferencePixelType>::AccumulateType > b0s(blockSize);
+      std::vector<int> columns(blockSize);    // column of each voxel in the block, -1 if below threshold
+
       // Following loop does the actual reconstruction work in each voxel
       // (Tuch, Q-Ball Reconstruction [1])
       while( !git.IsAtEnd() )
       {
-        // current vector of diffusion measurements
-        GradientVectorType b = git.Get();
-
-        // average of current b-zero reference values
-        typename NumericTraits<ReferencePixelType>::AccumulateType b0 = NumericTraits<ReferencePixelType>::Zero;
-        for(unsigned int i = 0; i < baselineind.size(); ++i)
+        // gather the pre-normalized signals of the next voxels
+        unsigned int numVoxels = 0;
+        unsigned int numColumns = 0;
+        for( ; numVoxels<blockSize && !git.IsAtEnd(); ++numVoxels, ++git )
         {
-          b0 += b[baselineind[i]];
-        }
-        b0 /= this->m_NumberOfBaselineImages;
+          // current vector of diffusion measurements
+          GradientVectorType b = git.Get();
 
-        // init resulting ODF
-        OdfPixelType odf(0.0);
-
-        // threshold on reference value to suppress noisy regions
-        if( (b0 != 0) && (b0 >= m_Threshold) )
-        {
-          for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+          // average of current b-zero reference values
+          typename NumericTraits<ReferencePixelType>::AccumulateType b0 = NumericTraits<ReferencePixelType>::Zero;
+          for(unsigned int i = 0; i < baselineind.size(); ++i)
           {
-            B[i] = static_cast<TOdfPixelType>(b[gradientind[i]]);
+            b0 += b[baselineind[i]];
           }
+          b0 /= this->m_NumberOfBaselineImages;
+          b0s[numVoxels] = b0;
+          columns[numVoxels] = -1;
 
-          // pre-normalization according to m_NormalizationMethod
-          B = PreNormalize(B);
+          // threshold on reference value to suppress noisy regions
+          if( (b0 != 0) && (b0 >= m_Threshold) )
+          {
+            for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+            {
+              B[i] = static_cast<TOdfPixelType>(b[gradientind[i]]);
+            }
 
-          // actual reconstruction
-          odf = ( (*m_ReconstructionMatrix) * B ).data_block();
-
-          // post-normalization according to m_NormalizationMethod
-          odf = Normalize(odf, b0);
+            // pre-normalization according to m_NormalizationMethod
+            PreNormalize(B);
 
+            for( unsigned int i = 0; i< m_NumberOfGradientDirections; i++ )
+              signals[i*blockSize+numColumns] = B[i];
+            columns[numVoxels] = numColumns++;
+          }
         }
 
-        for (unsigned int i=0; i<odf.Size(); i++)
-            if (odf.GetElement(i)!=odf.GetElement(i))
-                odf.Fill(0.0);
+        // actual reconstruction
+        m_BlockProduct.Multiply(&signals[0], &odfs[0], numColumns);
 
-        // set and increment output iterators
-        oit.Set( odf );
-        ++oit;
-        oit2.Set( b0 );
-        ++oit2;
-        ++git; // Gradient  image iterator
+        // post-normalization according to m_NormalizationMethod while writing the outputs
+        for( unsigned int v=0; v<numVoxels; v++ )
+        {
+          OdfPixelType odf(0.0);
+          if( columns[v]>=0 )
+          {
+            for( int k=0; k<NrOdfDirections; k++ )
+              odf[k] = odfs[k*blockSize+columns[v]];
+            odf = Normalize(odf, b0s[v]);
+          }
+
+          for (unsigned int i=0; i<odf.Size(); i++)
+              if (odf.GetElement(i)!=odf.GetElement(i))
+                  odf.Fill(0.0);
+
+          // set and increment output iterators
+          oit.Set( odf );
+          ++oit;
+          oit2.Set( b0s[v] );
+          ++oit2;
+        }
       }
     }
 
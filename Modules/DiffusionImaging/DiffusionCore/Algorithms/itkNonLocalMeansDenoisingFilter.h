@@ -20,6 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkImageToImageFilter.h"
 #include "itkVectorImage.h"
 #include <mitkDiffusionImage.h>
+#include <vector>
 
 
 
@@ -29,6 +30,15 @@ namespace itk{
    *
    * This Filter needs as an input a diffusion weigthed image, which will be denoised unsing the non-local means principle.
    * An input mask is optional to denoise only inside the mask range. All other voxels will be set to 0.
+   *
+   * In the fast mode the image is processed in blocks. For each offset of the search window the squared differences of all
+   * voxel pairs of a block are computed for all channels at once and summed over the comparison neighborhoods with separable
+   * running sums. This replaces the per voxel comparison loops and yields the same weights. Only the order of the final
+   * summation differs from the exact mode, which is kept for validation.
+   *
+   * \note With joint information and Rician adaption the exact mode stores two values per neighbor and therefore pairs
+   * the weights with the wrong values. Its result is pinned by the reference data of the tests. The fast mode pairs them
+   * correctly, so the two modes differ for this combination.
   */
 
   template< class TPixelType >
@@ -85,6 +95,14 @@ namespace itk{
      * If this flag is true the filter uses a method which is optimized for Rician distributed noise.
      */
     itkSetMacro(UseRicianAdaption, bool)
+    /**
+     * @brief Set flag to use the fast blockwise computation
+     *
+     * If this flag is true the patch distances are computed blockwise with running sums (see class description).
+     * Default is false (exact voxelwise computation).
+     */
+    itkSetMacro(UseFastMode, bool)
+    itkGetMacro(UseFastMode, bool)
     /**
      * @brief Get the amount of calculated Voxels
      *
@@ -126,14 +144,33 @@ namespace itk{
      */
     void ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread, ThreadIdType);
 
+    /**
+     * @brief Fast denoising procedure for one block of the output image
+     *
+     * Accumulates the weighted values of all search window offsets for the voxels of the block, see class description.
+     *
+     * @param block Region to denoise, at most BlockSize voxels in each direction.
+     */
+    void DenoiseBlock( const OutputImageRegionType &block );
+
+    /**
+     * @brief Sums the values of a 3D array with interleaved components over 2*radius+1 neighbouring elements along one axis.
+     *
+     * The output is smaller by 2*radius along this axis. Running sums are used, integer valued inputs are summed exactly.
+     */
+    static void BoxSum(const std::vector<double>& in, const int inSize[3], int axis, int radius, int components, std::vector<double>& out);
+
 
 
   private:
 
+    enum { BlockSize = 16 };                          ///< Maximum block edge length of the fast mode.
+
     int m_SearchRadius;                               ///< Radius of the searchblock.
     int m_ComparisonRadius;                           ///< Radius of the comparisonblock.
     bool m_UseJointInformation;                       ///< Flag to use joint information.
     bool m_UseRicianAdaption;                         ///< Flag to use rician adaption.
+    bool m_UseFastMode;                               ///< Flag to use the blockwise computation.
     unsigned int m_CurrentVoxelCount;                 ///< Amount of processed voxels.
     double m_Variance;                                ///< Estimated noise variance.
     typename MaskImageType::Pointer m_Mask;           ///< Pointer to the mask image.
@@ -28,6 +28,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "itkNeighborhoodIterator.h"
 #include <itkImageRegionIteratorWithIndex.h>
 #include <vector>
+#include <algorithm>
 
 namespace itk {
 
@@ -39,6 +40,7 @@ NonLocalMeansDenoisingFilter< TPixelType >
     m_ComparisonRadius(1),
     m_UseJointInformation(false),
     m_UseRicianAdaption(false),
+    m_UseFastMode(false),
     m_Variance(1),
     m_Mask(NULL)
 {
@@ -56,6 +58,7 @@ NonLocalMeansDenoisingFilter< TPixelType >
   MITK_INFO << "Noisevariance: " << m_Variance;
   MITK_INFO << "Use Rician Adaption: " << std::boolalpha << m_UseRicianAdaption;
   MITK_INFO << "Use Joint Information: " << std::boolalpha << m_UseJointInformation;
+  MITK_INFO << "Use Fast Mode: " << std::boolalpha << m_UseFastMode;
 
 
   typename InputImageType::Pointer inputImagePointer = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
@@ -127,6 +130,29 @@ void
 NonLocalMeansDenoisingFilter< TPixelType >
 ::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, ThreadIdType )
 {
+  if (m_UseFastMode)
+  {
+    // process the region of this thread in blocks, so the buffers of the blockwise computation stay small
+    typename OutputImageType::IndexType end = outputRegionForThread.GetUpperIndex();
+    for (long z = outputRegionForThread.GetIndex(2); z <= end[2]; z += BlockSize)
+      for (long y = outputRegionForThread.GetIndex(1); y <= end[1]; y += BlockSize)
+        for (long x = outputRegionForThread.GetIndex(0); x <= end[0]; x += BlockSize)
+        {
+          if (this->GetAbortGenerateData())
+            return;
+
+          OutputImageRegionType block;
+          block.SetIndex(0, x);
+          block.SetIndex(1, y);
+          block.SetIndex(2, z);
+          block.SetSize(0, std::min<long>(BlockSize, end[0] - x + 1));
+          block.SetSize(1, std::min<long>(BlockSize, end[1] - y + 1));
+          block.SetSize(2, std::min<long>(BlockSize, end[2] - z + 1));
+          DenoiseBlock(block);
+        }
+    MITK_INFO << "One Thread finished calculation";
+    return;
+  }
 
 
   // initialize iterators
@@ -372,6 +398,251 @@ NonLocalMeansDenoisingFilter< TPixelType >
   MITK_INFO << "One Thread finished calculation";
 }
 
+template< class TPixelType >
+void
+NonLocalMeansDenoisingFilter< TPixelType >
+::DenoiseBlock(const OutputImageRegionType& block)
+{
+  typename InputImageType::Pointer inputImagePointer = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
+  typename OutputImageType::Pointer outputImage = static_cast< OutputImageType * >(this->ProcessObject::GetOutput(0));
+  const typename InputImageType::RegionType imageRegion = inputImagePointer->GetLargestPossibleRegion();
+
+  const int numChannels = inputImagePointer->GetVectorLength();
+  const int numDistances = m_UseJointInformation ? 1 : numChannels; // independent patch distances per voxel
+  const int radius = m_ComparisonRadius;
+
+  int blockSize[3];
+  int extendedSize[3];
+  for (int d = 0; d < 3; ++d)
+  {
+    blockSize[d] = block.GetSize(d);
+    extendedSize[d] = blockSize[d] + 2 * radius;
+  }
+  const int numBlockVoxels = blockSize[0] * blockSize[1] * blockSize[2];
+  const int numExtendedVoxels = extendedSize[0] * extendedSize[1] * extendedSize[2];
+
+  // voxels of the block that have to be denoised
+  std::vector<char> useVoxel(numBlockVoxels);
+  bool anyVoxel = false;
+  for (int z = 0, v = 0; z < blockSize[2]; ++z)
+    for (int y = 0; y < blockSize[1]; ++y)
+      for (int x = 0; x < blockSize[0]; ++x, ++v)
+      {
+        typename MaskImageType::IndexType index;
+        index[0] = block.GetIndex(0) + x;
+        index[1] = block.GetIndex(1) + y;
+        index[2] = block.GetIndex(2) + z;
+        useVoxel[v] = m_Mask->GetPixel(index) != 0;
+        anyVoxel = anyVoxel || useVoxel[v];
+      }
+
+  std::vector<double> weightSums(numBlockVoxels * numDistances, 0.0);
+  std::vector<double> weightedValues(numBlockVoxels * numChannels, 0.0);
+  std::vector<double> distances(numExtendedVoxels * numDistances);
+  std::vector<double> counts(numExtendedVoxels);
+  std::vector<double> tempDistances, tempCounts, boxDistances, boxCounts;
+
+  for (int dz = -m_SearchRadius; dz <= m_SearchRadius && anyVoxel; ++dz)
+  {
+    for (int dy = -m_SearchRadius; dy <= m_SearchRadius; ++dy)
+    {
+      for (int dx = -m_SearchRadius; dx <= m_SearchRadius; ++dx)
+      {
+        // squared differences of all voxel pairs (i, i+offset) of the block extended by the comparison radius
+        for (int z = 0, e = 0; z < extendedSize[2]; ++z)
+        {
+          for (int y = 0; y < extendedSize[1]; ++y)
+          {
+            for (int x = 0; x < extendedSize[0]; ++x, ++e)
+            {
+              typename InputImageType::IndexType indexI, indexJ;
+              indexI[0] = block.GetIndex(0) - radius + x;
+              indexI[1] = block.GetIndex(1) - radius + y;
+              indexI[2] = block.GetIndex(2) - radius + z;
+              indexJ[0] = indexI[0] + dx;
+              indexJ[1] = indexI[1] + dy;
+              indexJ[2] = indexI[2] + dz;
+
+              double* distance = &distances[e * numDistances];
+              if (imageRegion.IsInside(indexI) && imageRegion.IsInside(indexJ))
+              {
+                const TPixelType* pixelI = inputImagePointer->GetBufferPointer() + inputImagePointer->ComputeOffset(indexI) * numChannels;
+                const TPixelType* pixelJ = inputImagePointer->GetBufferPointer() + inputImagePointer->ComputeOffset(indexJ) * numChannels;
+                if (m_UseJointInformation)
+                {
+                  double sum = 0;
+                  for (int i = 0; i < numChannels; ++i)
+                  {
+                    double diff = (double)pixelI[i] - (double)pixelJ[i];
+                    sum += diff * diff;
+                  }
+                  distance[0] = sum;
+                }
+                else
+                {
+                  for (int i = 0; i < numChannels; ++i)
+                  {
+                    double diff = (double)pixelI[i] - (double)pixelJ[i];
+                    distance[i] = diff * diff;
+                  }
+                }
+                counts[e] = 1;
+              }
+              else
+              {
+                std::fill(distance, distance + numDistances, 0.0);
+                counts[e] = 0;
+              }
+            }
+          }
+        }
+
+        // sum over the comparison neighborhoods
+        int size[3] = { extendedSize[0], extendedSize[1], extendedSize[2] };
+        BoxSum(distances, size, 0, radius, numDistances, boxDistances);
+        BoxSum(counts, size, 0, radius, 1, boxCounts);
+        size[0] = blockSize[0];
+        BoxSum(boxDistances, size, 1, radius, numDistances, tempDistances);
+        BoxSum(boxCounts, size, 1, radius, 1, tempCounts);
+        size[1] = blockSize[1];
+        BoxSum(tempDistances, size, 2, radius, numDistances, boxDistances);
+        BoxSum(tempCounts, size, 2, radius, 1, boxCounts);
+
+        // weight the neighbors of all block voxels
+        for (int z = 0, v = 0; z < blockSize[2]; ++z)
+        {
+          for (int y = 0; y < blockSize[1]; ++y)
+          {
+            for (int x = 0; x < blockSize[0]; ++x, ++v)
+            {
+              typename InputImageType::IndexType indexV;
+              indexV[0] = block.GetIndex(0) + x + dx;
+              indexV[1] = block.GetIndex(1) + y + dy;
+              indexV[2] = block.GetIndex(2) + z + dz;
+              if (!useVoxel[v] || !imageRegion.IsInside(indexV))
+                continue;
+
+              const TPixelType* pixelJ = inputImagePointer->GetBufferPointer() + inputImagePointer->ComputeOffset(indexV) * numChannels;
+              const double* distance = &boxDistances[v * numDistances];
+              double* weightSum = &weightSums[v * numDistances];
+              double* weightedValue = &weightedValues[v * numChannels];
+              if (m_UseJointInformation)
+              {
+                double w = std::exp( - (distance[0] / (boxCounts[v] * (numChannels + 1))) / m_Variance);
+                weightSum[0] += w;
+                if (m_UseRicianAdaption)
+                  for (int i = 0; i < numChannels; ++i)
+                    weightedValue[i] += w * ((double)pixelJ[i] * (double)pixelJ[i]);
+                else
+                  for (int i = 0; i < numChannels; ++i)
+                    weightedValue[i] += w * (double)pixelJ[i];
+              }
+              else
+              {
+                for (int i = 0; i < numChannels; ++i)
+                {
+                  double w = std::exp( - distance[i] / boxCounts[v] / m_Variance);
+                  weightSum[i] += w;
+                  weightedValue[i] += w * (m_UseRicianAdaption ? (double)pixelJ[i] * (double)pixelJ[i] : (double)pixelJ[i]);
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // normalize and write the block
+  for (int z = 0, v = 0; z < blockSize[2]; ++z)
+  {
+    for (int y = 0; y < blockSize[1]; ++y)
+    {
+      for (int x = 0; x < blockSize[0]; ++x, ++v)
+      {
+        typename OutputImageType::IndexType index;
+        index[0] = block.GetIndex(0) + x;
+        index[1] = block.GetIndex(1) + y;
+        index[2] = block.GetIndex(2) + z;
+        TPixelType* outpix = outputImage->GetBufferPointer() + outputImage->ComputeOffset(index) * numChannels;
+
+        for (int i = 0; i < numChannels; ++i)
+        {
+          if (!useVoxel[v])
+          {
+            outpix[i] = 0;
+            continue;
+          }
+          double sumj = weightedValues[v * numChannels + i] / weightSums[v * numDistances + (m_UseJointInformation ? 0 : i)];
+          if (m_UseRicianAdaption)
+          {
+            sumj -= 2 * m_Variance;
+          }
+          if (sumj < 0)
+          {
+            sumj = 0;
+          }
+          if (m_UseRicianAdaption)
+          {
+            outpix[i] = std::floor(std::sqrt(sumj) + 0.5);
+          }
+          else
+          {
+            outpix[i] = std::floor(sumj + 0.5);
+          }
+        }
+      }
+    }
+  }
+  m_CurrentVoxelCount += numBlockVoxels;
+}
+
+template< class TPixelType >
+void
+NonLocalMeansDenoisingFilter< TPixelType >
+::BoxSum(const std::vector<double>& in, const int inSize[3], int axis, int radius, int components, std::vector<double>& out)
+{
+  int outSize[3] = { inSize[0], inSize[1], inSize[2] };
+  outSize[axis] -= 2 * radius;
+  out.resize(outSize[0] * outSize[1] * outSize[2] * components);
+
+  const int inStrides[3] = { components, inSize[0] * components, inSize[0] * inSize[1] * components };
+  const int outStrides[3] = { components, outSize[0] * components, outSize[0] * outSize[1] * components };
+  const int axis1 = axis == 0 ? 1 : 0;
+  const int axis2 = axis == 2 ? 1 : 2;
+  const int inStride = inStrides[axis];
+  const int outStride = outStrides[axis];
+
+  std::vector<double> sums(components);
+  for (int b = 0; b < outSize[axis2]; ++b)
+  {
+    for (int a = 0; a < outSize[axis1]; ++a)
+    {
+      const double* inLine = &in[a * inStrides[axis1] + b * inStrides[axis2]];
+      double* outLine = &out[a * outStrides[axis1] + b * outStrides[axis2]];
+
+      std::fill(sums.begin(), sums.end(), 0.0);
+      for (int i = 0; i < 2 * radius + 1; ++i)
+        for (int k = 0; k < components; ++k)
+          sums[k] += inLine[i * inStride + k];
+      for (int k = 0; k < components; ++k)
+        outLine[k] = sums[k];
+
+      for (int i = 1; i < outSize[axis]; ++i)
+      {
+        const double* entering = inLine + (i + 2 * radius) * inStride;
+        const double* leaving = inLine + (i - 1) * inStride;
+        double* target = outLine + i * outStride;
+        for (int k = 0; k < components; ++k)
+        {
+          sums[k] += entering[k] - leaving[k];
+          target[k] = sums[k];
+        }
+      }
+    }
+  }
+}
+
 template< class TPixelType >
 void NonLocalMeansDenoisingFilter< TPixelType >::SetInputImage(const InputImageType* image)
 {
@@ -3,6 +3,7 @@ set(MODULE_TESTS
   mitkDiffusionImageEqualTest.cpp
   mitkNonLocalMeansDenoisingTest.cpp
   mitkDiffusionImageEqualTest.cpp
+  mitkQballReconstructionBenchmarkTest.cpp
 )
 
 set(MODULE_CUSTOM_TESTS
@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkTestingMacros.h"
 #include "mitkTestFixture.h"
 #include "itkNonLocalMeansDenoisingFilter.h"
+#include <itkImageRegionConstIterator.h>
 
 class mitkNonLocalMeansDenoisingTestSuite : public mitk::TestFixture
 {
@@ -28,6 +29,7 @@ class mitkNonLocalMeansDenoisingTestSuite : public mitk::TestFixture
   MITK_TEST(Denoise_NLMr_shouldReturnTrue);
   MITK_TEST(Denoise_NLMv_shouldReturnTrue);
   MITK_TEST(Denoise_NLMvr_shouldReturnTrue);
+  MITK_TEST(Denoise_FastMode_shouldEqualExactMode);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -171,6 +173,51 @@ public:
     MITK_ASSERT_EQUAL( m_DenoisedImage, m_ReferenceImage, "NLMvr should always return the same result.");
   }
 
+  void Denoise_FastMode_shouldEqualExactMode()
+  {
+    typedef itk::VectorImage<short, 3> DwiImageType;
+
+    // joint information with rician adaption is left out, the exact mode pairs its weights with the wrong values there
+    for (int i = 0; i < 3; ++i)
+    {
+      bool rician = i % 2 == 1;
+      bool joint = i >= 2;
+      m_DenoisingFilter->SetUseRicianAdaption(rician);
+      m_DenoisingFilter->SetUseJointInformation(joint);
+      m_DenoisingFilter->SetComparisonRadius(2);
+      m_DenoisingFilter->SetUseFastMode(false);
+      m_DenoisingFilter->Update();
+      DwiImageType::Pointer exactImage = m_DenoisingFilter->GetOutput();
+      exactImage->DisconnectPipeline();
+
+      // several threads and a comparison radius larger than one, so blocks and thread regions have borders
+      itk::NonLocalMeansDenoisingFilter<short>::Pointer fastFilter = itk::NonLocalMeansDenoisingFilter<short>::New();
+      fastFilter->SetInputImage(m_Image->GetVectorImage());
+      fastFilter->SetNumberOfThreads(4);
+      fastFilter->SetComparisonRadius(2);
+      fastFilter->SetSearchRadius(1);
+      fastFilter->SetVariance(500);
+      fastFilter->SetUseRicianAdaption(rician);
+      fastFilter->SetUseJointInformation(joint);
+      fastFilter->SetUseFastMode(true);
+      fastFilter->Update();
+      DwiImageType::Pointer fastImage = fastFilter->GetOutput();
+
+      // the weights are identical, only the rounding of the weighted sum may differ
+      int maxDifference = 0;
+      itk::ImageRegionConstIterator<DwiImageType> exactIt(exactImage, exactImage->GetLargestPossibleRegion());
+      itk::ImageRegionConstIterator<DwiImageType> fastIt(fastImage, fastImage->GetLargestPossibleRegion());
+      for (; !exactIt.IsAtEnd(); ++exactIt, ++fastIt)
+      {
+        for (unsigned int c = 0; c < exactImage->GetVectorLength(); ++c)
+        {
+          maxDifference = std::max(maxDifference, std::abs(exactIt.Get()[c] - fastIt.Get()[c]));
+        }
+      }
+      CPPUNIT_ASSERT_MESSAGE("Fast mode should return the result of the exact mode.", maxDifference <= 1);
+    }
+  }
+
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkNonLocalMeansDenoising)
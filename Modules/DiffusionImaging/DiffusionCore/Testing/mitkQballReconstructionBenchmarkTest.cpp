@@ -0,0 +1,230 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkQBallImage.h>
+#include <itkDiffusionQballReconstructionImageFilter.h>
+#include <itkAnalyticalDiffusionQballReconstructionImageFilter.h>
+#include <itkOrientationDistributionFunction.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkImageRegionIterator.h>
+#include <itkTimeProbe.h>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+/**
+ * Benchmark for the blockwise Q-ball reconstruction on a synthetic single tensor DWI with 60 gradient directions
+ * (64x64x32 voxels unless the edge length is given as first argument). The fiber of a voxel runs along the x-, y- or
+ * z-axis depending on its position. Every fourth slice has no signal and must result in empty ODFs, the ODFs of all
+ * other voxels must point along their fiber. Sample voxels are also reconstructed one by one, which must give the
+ * ODFs of the blockwise reconstruction. Reports voxels per second.
+ */
+
+namespace
+{
+  typedef itk::VectorImage< short, 3 > DwiImageType;
+  typedef itk::AnalyticalDiffusionQballReconstructionImageFilter< short, short, float, 4, QBALL_ODFSIZE > AnalyticalFilterType;
+  typedef itk::DiffusionQballReconstructionImageFilter< short, short, float, QBALL_ODFSIZE > NumericalFilterType;
+  typedef AnalyticalFilterType::GradientDirectionContainerType GradientContainerType;
+  typedef AnalyticalFilterType::OdfImageType OdfImageType;
+
+  const unsigned int NumGradients = 60;
+  const double BValue = 1000;
+  const unsigned int NumSampleVoxels = 50;
+  const double Epsilon = 1e-5;
+
+  /** axis of the fiber in the voxel, neighboring voxels of a block differ */
+  unsigned int GetFiberAxis(const DwiImageType::IndexType& index)
+  {
+    return (index[0] + index[1]) % 3;
+  }
+
+  /** one b0 and NumGradients directions on a spiral over the half sphere */
+  GradientContainerType::Pointer CreateGradients()
+  {
+    GradientContainerType::Pointer gradients = GradientContainerType::New();
+    AnalyticalFilterType::GradientDirectionType g;
+    g.fill(0.0);
+    gradients->InsertElement(0, g);
+    for (unsigned int i = 0; i < NumGradients; ++i)
+    {
+      double z = 1.0 - (i + 0.5) / NumGradients;
+      double r = std::sqrt(1.0 - z * z);
+      double phi = i * 2.399963229728653;   // golden angle
+      g[0] = r * std::cos(phi);
+      g[1] = r * std::sin(phi);
+      g[2] = z;
+      gradients->InsertElement(i + 1, g);
+    }
+    return gradients;
+  }
+
+  /** signal of a prolate tensor along the fiber axis of each voxel */
+  DwiImageType::Pointer CreateDwi(unsigned int size, GradientContainerType* gradients)
+  {
+    DwiImageType::Pointer dwi = DwiImageType::New();
+    DwiImageType::RegionType region;
+    region.SetSize(0, size);
+    region.SetSize(1, size);
+    region.SetSize(2, size / 2);
+    dwi->SetRegions(region);
+    dwi->SetVectorLength(gradients->Size());
+    dwi->Allocate();
+
+    std::vector< DwiImageType::PixelType > signals;
+    for (unsigned int axis = 0; axis < 3; ++axis)
+    {
+      DwiImageType::PixelType signal(gradients->Size());
+      for (unsigned int i = 0; i < gradients->Size(); ++i)
+      {
+        AnalyticalFilterType::GradientDirectionType g = gradients->ElementAt(i);
+        double adc = 1.7e-3 * g[axis] * g[axis] + 0.3e-3 * (g.squared_magnitude() - g[axis] * g[axis]);
+        signal[i] = (short)(1000 * std::exp(-BValue * adc));
+      }
+      signals.push_back(signal);
+    }
+    DwiImageType::PixelType empty(gradients->Size());
+    empty.Fill(0);
+
+    itk::ImageRegionIterator< DwiImageType > it(dwi, region);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      it.Set(it.GetIndex()[2] % 4 == 3 ? empty : signals[GetFiberAxis(it.GetIndex())]);
+    return dwi;
+  }
+
+  bool CheckOdfs(OdfImageType* odfImage)
+  {
+    itk::ImageRegionConstIterator< OdfImageType > it(odfImage, odfImage->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+      itk::OrientationDistributionFunction< float, QBALL_ODFSIZE > odf;
+      for (unsigned int i = 0; i < QBALL_ODFSIZE; ++i)
+        odf[i] = it.Get()[i];
+
+      if (it.GetIndex()[2] % 4 == 3)
+      {
+        if (odf.GetMaxValue() != 0 || odf.GetMinValue() != 0)
+          return false;
+      }
+      else if (std::fabs(odf.GetDirection(odf.GetPrincipleDiffusionDirection())[GetFiberAxis(it.GetIndex())]) < 0.9)
+        return false;
+    }
+    return true;
+  }
+
+  NumericalFilterType::Pointer CreateNumericalFilter(GradientContainerType* gradients, DwiImageType* dwi)
+  {
+    NumericalFilterType::Pointer filter = NumericalFilterType::New();
+    filter->SetGradientImage(gradients, dwi);
+    filter->SetBValue(BValue);
+    filter->SetNormalizationMethod(NumericalFilterType::QBR_STANDARD);
+    return filter;
+  }
+
+  AnalyticalFilterType::Pointer CreateAnalyticalFilter(GradientContainerType* gradients, DwiImageType* dwi,
+                                                       AnalyticalFilterType::Normalization normalization)
+  {
+    AnalyticalFilterType::Pointer filter = AnalyticalFilterType::New();
+    filter->SetGradientImage(gradients, dwi);
+    filter->SetBValue(BValue);
+    filter->SetLambda(0.006);
+    filter->SetNormalizationMethod(normalization);
+    return filter;
+  }
+
+  AnalyticalFilterType::Pointer CreateStandardFilter(GradientContainerType* gradients, DwiImageType* dwi)
+  {
+    return CreateAnalyticalFilter(gradients, dwi, AnalyticalFilterType::QBAR_STANDARD);
+  }
+
+  AnalyticalFilterType::Pointer CreateCsaFilter(GradientContainerType* gradients, DwiImageType* dwi)
+  {
+    return CreateAnalyticalFilter(gradients, dwi, AnalyticalFilterType::QBAR_SOLID_ANGLE);
+  }
+
+  /** reconstructs sample voxels as images of a single voxel and compares them with the blockwise result */
+  template< class TFilter >
+  bool CheckVoxelwise(typename TFilter::Pointer (*createFilter)(GradientContainerType*, DwiImageType*),
+                      GradientContainerType* gradients, DwiImageType* dwi, OdfImageType* odfImage)
+  {
+    DwiImageType::RegionType voxelRegion;
+    voxelRegion.SetSize(0, 1);
+    voxelRegion.SetSize(1, 1);
+    voxelRegion.SetSize(2, 1);
+    DwiImageType::IndexType voxelIndex = voxelRegion.GetIndex();
+
+    DwiImageType::RegionType region = dwi->GetLargestPossibleRegion();
+    unsigned int numVoxels = region.GetNumberOfPixels();
+    for (unsigned int sample = 0; sample < NumSampleVoxels; ++sample)
+    {
+      // spread over the image, at different positions within a block
+      unsigned int offset = (unsigned int)((double)sample / NumSampleVoxels * numVoxels) + sample % 7;
+      DwiImageType::IndexType index = dwi->ComputeIndex(std::min(offset, numVoxels - 1));
+
+      DwiImageType::Pointer voxel = DwiImageType::New();
+      voxel->SetRegions(voxelRegion);
+      voxel->SetVectorLength(dwi->GetVectorLength());
+      voxel->Allocate();
+      voxel->SetPixel(voxelIndex, dwi->GetPixel(index));
+
+      typename TFilter::Pointer filter = createFilter(gradients, voxel);
+      filter->Update();
+
+      typename TFilter::OdfPixelType expected = filter->GetOutput()->GetPixel(voxelIndex);
+      OdfImageType::PixelType actual = odfImage->GetPixel(index);
+      for (unsigned int i = 0; i < QBALL_ODFSIZE; ++i)
+      {
+        if (std::fabs(actual[i] - expected[i]) > Epsilon * (1 + std::fabs(expected[i])))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  template< class TFilter >
+  void Run(typename TFilter::Pointer (*createFilter)(GradientContainerType*, DwiImageType*),
+           GradientContainerType* gradients, DwiImageType* dwi, const std::string& name)
+  {
+    typename TFilter::Pointer filter = createFilter(gradients, dwi);
+    unsigned int numVoxels = dwi->GetLargestPossibleRegion().GetNumberOfPixels();
+
+    itk::TimeProbe probe;
+    probe.Start();
+    filter->Update();
+    probe.Stop();
+    MITK_TEST_OUTPUT(<< name << ": " << numVoxels / probe.GetTotal() << " voxels/s (" << probe.GetTotal() << " s)");
+    MITK_TEST_CONDITION(CheckOdfs(filter->GetOutput()), name << " ODFs are empty without signal and point along the fiber otherwise");
+    MITK_TEST_CONDITION(CheckVoxelwise< TFilter >(createFilter, gradients, dwi, filter->GetOutput()),
+                        name << " ODFs equal the reconstruction of single voxels");
+  }
+}
+
+int mitkQballReconstructionBenchmarkTest(int argc, char* argv[])
+{
+  MITK_TEST_BEGIN("mitkQballReconstructionBenchmarkTest");
+
+  unsigned int size = argc > 1 ? atoi(argv[1]) : 64;
+  GradientContainerType::Pointer gradients = CreateGradients();
+  DwiImageType::Pointer dwi = CreateDwi(size, gradients);
+
+  Run< NumericalFilterType >(CreateNumericalFilter, gradients, dwi, "Numerical Q-ball");
+  Run< AnalyticalFilterType >(CreateStandardFilter, gradients, dwi, "Standard Q-ball");
+  Run< AnalyticalFilterType >(CreateCsaFilter, gradients, dwi, "CSA Q-ball");
+
+  MITK_TEST_END();
+}
@@ -107,29 +107,95 @@ void EnergyComputer::SetParameters(float particleWeight, float particleWidth, fl
 
 // draw random position from active voxels
 void EnergyComputer::DrawRandomPosition(vnl_vector_fixed<float, 3>& R)
+{
+    DrawRandomPosition(R, m_CumulatedSpatialProbability, m_ActiveIndices, m_NumActiveVoxels);
+}
+
+// draw random position from active voxels overlapping the domain
+void EnergyComputer::DrawRandomPosition(vnl_vector_fixed<float, 3>& R, const ParticleGrid::Domain& domain)
+{
+    DrawRandomPosition(R, domain.m_CumulatedSpatialProbability, domain.m_ActiveIndices, domain.m_ActiveIndices.size());
+}
+
+void EnergyComputer::DrawRandomPosition(vnl_vector_fixed<float, 3>& R, const std::vector< float >& cumulatedSpatialProbability, const std::vector< int >& activeIndices, int numActiveVoxels)
 {
     float r = m_RandGen->GetVariate();//m_RandGen->frand();
     int j;
     int rl = 1;
-    int rh = m_NumActiveVoxels;
+    int rh = numActiveVoxels;
     while(rh != rl)
     {
         j = rl + (rh-rl)/2;
-        if (r < m_CumulatedSpatialProbability[j])
+        if (r < cumulatedSpatialProbability[j])
         {
             rh = j;
             continue;
         }
-        if (r > m_CumulatedSpatialProbability[j])
+        if (r > cumulatedSpatialProbability[j])
         {
             rl = j+1;
             continue;
         }
         break;
     }
-    R[0] = m_Spacing[0]*((float)(m_ActiveIndices[rh-1] % m_Size[0])  + m_RandGen->GetVariate());
-    R[1] = m_Spacing[1]*((float)((m_ActiveIndices[rh-1]/m_Size[0]) % m_Size[1])  + m_RandGen->GetVariate());
-    R[2] = m_Spacing[2]*((float)(m_ActiveIndices[rh-1]/(m_Size[0]*m_Size[1]))    + m_RandGen->GetVariate());
+    R[0] = m_Spacing[0]*((float)(activeIndices[rh-1] % m_Size[0])  + m_RandGen->GetVariate());
+    R[1] = m_Spacing[1]*((float)((activeIndices[rh-1]/m_Size[0]) % m_Size[1])  + m_RandGen->GetVariate());
+    R[2] = m_Spacing[2]*((float)(activeIndices[rh-1]/(m_Size[0]*m_Size[1]))    + m_RandGen->GetVariate());
+}
+
+void EnergyComputer::InitializeDomains(std::vector< ParticleGrid::Domain >& domains)
+{
+    float totalProbability = m_CumulatedSpatialProbability[m_NumActiveVoxels];
+    for (unsigned int d=0; d<domains.size(); d++)
+    {
+        domains[d].m_ActiveIndices.clear();
+        domains[d].m_CumulatedSpatialProbability.assign(1, 0.0);
+    }
+
+    for (int k = 0; k < m_NumActiveVoxels; k++)
+    {
+        int idx = m_ActiveIndices[k];
+        ItkFloatImageType::IndexType index;
+        index[0] = idx % m_Size[0]; index[1] = (idx/m_Size[0]) % m_Size[1]; index[2] = idx/(m_Size[0]*m_Size[1]);
+        float probability = m_Mask->GetPixel(index);
+
+        // grid cells covered by the voxel
+        vnl_vector_fixed<float, 3> lower, upper;
+        for (int i=0; i<3; i++)
+        {
+            lower[i] = m_Spacing[i]*index[i];
+            upper[i] = m_Spacing[i]*(index[i]+1)*0.99999;
+        }
+        vnl_vector_fixed<int, 3> lowerCell, upperCell, cell;
+        m_ParticleGrid->GetCellOfPosition(lower, lowerCell);
+        m_ParticleGrid->GetCellOfPosition(upper, upperCell);
+
+        // add voxel to each overlapping domain once
+        for (cell[2] = lowerCell[2]; cell[2] <= upperCell[2]; cell[2]++)
+            for (cell[1] = lowerCell[1]; cell[1] <= upperCell[1]; cell[1]++)
+                for (cell[0] = lowerCell[0]; cell[0] <= upperCell[0]; cell[0]++)
+                {
+                    int d = m_ParticleGrid->GetDomainIndex(cell);
+                    if (d<0 || (!domains[d].m_ActiveIndices.empty() && domains[d].m_ActiveIndices.back()==idx))
+                        continue;
+                    domains[d].m_ActiveIndices.push_back(idx);
+                    domains[d].m_CumulatedSpatialProbability.push_back(domains[d].m_CumulatedSpatialProbability.back() + probability);
+                }
+    }
+
+    std::vector< ParticleGrid::Domain > activeDomains;
+    for (unsigned int d=0; d<domains.size(); d++)
+    {
+        std::vector< float >& cumulated = domains[d].m_CumulatedSpatialProbability;
+        if (domains[d].m_ActiveIndices.empty() || cumulated.back()<=0)
+            continue;
+        float domainProbability = cumulated.back();
+        domains[d].m_Mass = domainProbability/totalProbability;
+        for (unsigned int k = 0; k < cumulated.size(); k++)
+            cumulated[k] /= domainProbability;
+        activeDomains.push_back(domains[d]);
+    }
+    domains.swap(activeDomains);
 }
 
 // return spatial probability of position
@@ -43,6 +43,11 @@ public:
 
     // get random position inside mask
     void DrawRandomPosition(vnl_vector_fixed<float, 3>& R);
+    // get random position inside mask voxels overlapping the domain
+    void DrawRandomPosition(vnl_vector_fixed<float, 3>& R, const ParticleGrid::Domain& domain);
+
+    // assign the active voxels to the domains and remove domains without active voxels
+    void InitializeDomains(std::vector< ParticleGrid::Domain >& domains);
 
     // external energy calculation
     virtual float ComputeExternalEnergy(vnl_vector_fixed<float, 3>& R, vnl_vector_fixed<float, 3>& N, Particle* dp) =0;
@@ -79,6 +84,9 @@ protected:
     float   m_SquaredParticleLength;        // squared particle length
     float   m_CurvatureThreshold;           // maximum angle accepted between two connected particles
 
+    ParticleGrid::NeighborTracker   m_NeighbourTracker; // own tracker, several energy computers may work on the same grid
+
+    void DrawRandomPosition(vnl_vector_fixed<float, 3>& R, const std::vector< float >& cumulatedSpatialProbability, const std::vector< int >& activeIndices, int numActiveVoxels);
     float SpatProb(vnl_vector_fixed<float, 3> pos);
     float EvaluateOdf(vnl_vector_fixed<float, 3> &pos, vnl_vector_fixed<float, 3> dir);
     float mbesseli0(float x);
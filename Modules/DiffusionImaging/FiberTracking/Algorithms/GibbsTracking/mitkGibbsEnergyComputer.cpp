@@ -132,8 +132,8 @@ float GibbsEnergyComputer::ComputeExternalEnergy(vnl_vector_fixed<float, 3> &R,
     float odfVal = EvaluateOdf(R, N);   // evaluate ODF in given direction
 
     float modelVal = 0;
-    m_ParticleGrid->ComputeNeighbors(R);    // retrieve neighbouring particles from particle grid
-    Particle* neighbour =  m_ParticleGrid->GetNextNeighbor();
+    m_ParticleGrid->ComputeNeighbors(R, m_NeighbourTracker);    // retrieve neighbouring particles from particle grid
+    Particle* neighbour =  m_ParticleGrid->GetNextNeighbor(m_NeighbourTracker);
     while (neighbour!=NULL)                         // iterate over nieghbouring particles
     {
         if (dp != neighbour)                        // don't evaluate against itself
@@ -146,7 +146,7 @@ float GibbsEnergyComputer::ComputeExternalEnergy(vnl_vector_fixed<float, 3> &R,
             modelVal += w*(bw+m_ParticleChemicalPotential);
             w = mexp(dpos*gamma_reg_s);
         }
-        neighbour =  m_ParticleGrid->GetNextNeighbor();
+        neighbour =  m_ParticleGrid->GetNextNeighbor(m_NeighbourTracker);
     }
 
     float energy = 2*(odfVal/m_ParticleWeight-modelVal) - (mbesseli0(1.0)+m_ParticleChemicalPotential);
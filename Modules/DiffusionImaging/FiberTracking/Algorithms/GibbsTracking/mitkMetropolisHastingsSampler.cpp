@@ -29,6 +29,10 @@ MetropolisHastingsSampler::MetropolisHastingsSampler(ParticleGrid* grid, EnergyC
     , m_DelProb(0.1)
     , m_ChempotParticle(0.0)
     , m_AcceptedProposals(0)
+    , m_Domain(NULL)
+    , m_NumDomainParticles(0)
+    , m_ParticleChange(0)
+    , m_ConnectionChange(0)
 {
     m_RandGen = randGen;
     m_ParticleGrid = grid;
@@ -80,6 +84,41 @@ void MetropolisHastingsSampler::PrintProposalTimes()
     std::cout << "Connection: " << 100*m_ConnectionTime.GetTotal()/sum << "/" << m_ConnectionTime.GetMean()*1000 << std::endl;
 }
 
+void MetropolisHastingsSampler::SetDomain(const ParticleGrid::Domain* domain)
+{
+    m_Domain = domain;
+    m_NumDomainParticles = (m_Domain!=NULL)? m_ParticleGrid->GetNumParticles(*m_Domain) : 0;
+}
+
+void MetropolisHastingsSampler::CommitChanges()
+{
+    m_ParticleGrid->m_NumParticles += m_ParticleChange;
+    m_ParticleGrid->m_NumConnections += m_ConnectionChange;
+    m_ParticleChange = 0;
+    m_ConnectionChange = 0;
+}
+
+int MetropolisHastingsSampler::GetNumParticles()
+{
+    if (m_Domain!=NULL)
+        return m_NumDomainParticles;
+    return m_ParticleGrid->m_NumParticles;
+}
+
+Particle* MetropolisHastingsSampler::GetRandomParticle()
+{
+    int pnum = m_RandGen->GetIntegerVariate()%GetNumParticles();
+    if (m_Domain!=NULL)
+        return m_ParticleGrid->GetParticle(*m_Domain, pnum);
+    return m_ParticleGrid->GetParticle(pnum);
+}
+
+// connections reaching out of the domain are frozen, a concurrent sampler may change the particles there
+bool MetropolisHastingsSampler::IsWritable(Particle* p)
+{
+    return m_Domain==NULL || m_ParticleGrid->IsInDomain(*m_Domain, p, 1);
+}
+
 // update temperature of simulated annealing process
 void MetropolisHastingsSampler::SetTemperature(float val)
 {
@@ -116,26 +155,41 @@ void MetropolisHastingsSampler::MakeProposal()
     {
         m_BirthTime.Start();
         vnl_vector_fixed<float, 3> R;
-        m_EnergyComputer->DrawRandomPosition(R);
+        if (m_Domain!=NULL)
+            m_EnergyComputer->DrawRandomPosition(R, *m_Domain);
+        else
+            m_EnergyComputer->DrawRandomPosition(R);
         vnl_vector_fixed<float, 3> N = GetRandomDirection();
-        Particle prop;
-        prop.GetPos() = R;
-        prop.GetDir() = N;
 
-        float prob =  m_Density * m_DeathProb /((m_BirthProb)*(m_ParticleGrid->m_NumParticles+1));
+        // positions outside of the domain core are drawn with the probability of the neighbouring domain
+        if (m_Domain==NULL || m_ParticleGrid->IsInDomain(*m_Domain, R))
+        {
+            Particle prop;
+            prop.GetPos() = R;
+            prop.GetDir() = N;
+
+            float prob =  m_Density * m_DeathProb /((m_BirthProb)*(GetNumParticles()+1));
+            if (m_Domain!=NULL)
+                prob *= m_Domain->m_Mass;
 
-        float ex_energy = m_EnergyComputer->ComputeExternalEnergy(R,N,0);
-        float in_energy = m_EnergyComputer->ComputeInternalEnergy(&prop);
-        prob *= exp((in_energy/m_InTemp+ex_energy/m_ExTemp)) ;
+            float ex_energy = m_EnergyComputer->ComputeExternalEnergy(R,N,0);
+            float in_energy = m_EnergyComputer->ComputeInternalEnergy(&prop);
+            prob *= exp((in_energy/m_InTemp+ex_energy/m_ExTemp)) ;
 
-        if (prob > 1 || m_RandGen->GetVariate() < prob)
-        {
-            Particle *p = m_ParticleGrid->NewParticle(R);
-            if (p!=0)
+            if (prob > 1 || m_RandGen->GetVariate() < prob)
             {
-                p->GetPos() = R;
-                p->GetDir() = N;
-                m_AcceptedProposals++;
+                Particle *p = m_ParticleGrid->NewParticle(R);
+                if (p!=0)
+                {
+                    p->GetPos() = R;
+                    p->GetDir() = N;
+                    m_AcceptedProposals++;
+                    if (m_Domain!=NULL)
+                    {
+                        m_NumDomainParticles++;
+                        m_ParticleChange++;
+                    }
+                }
             }
         }
         m_BirthTime.Stop();
@@ -144,21 +198,27 @@ void MetropolisHastingsSampler::MakeProposal()
     else if (randnum < m_BirthProb+m_DeathProb)
     {
         m_DeathTime.Start();
-        if (m_ParticleGrid->m_NumParticles > 0)
+        if (GetNumParticles() > 0)
         {
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
-            Particle *dp = m_ParticleGrid->GetParticle(pnum);
+            Particle *dp = GetRandomParticle();
             if (dp->pID == -1 && dp->mID == -1)
             {
                 float ex_energy = m_EnergyComputer->ComputeExternalEnergy(dp->GetPos(),dp->GetDir(),dp);
                 float in_energy = m_EnergyComputer->ComputeInternalEnergy(dp);
 
-                float prob = m_ParticleGrid->m_NumParticles * (m_BirthProb) /(m_Density*m_DeathProb); //*SpatProb(dp->R);
+                float prob = GetNumParticles() * (m_BirthProb) /(m_Density*m_DeathProb); //*SpatProb(dp->R);
+                if (m_Domain!=NULL)
+                    prob /= m_Domain->m_Mass;
                 prob *= exp(-(in_energy/m_InTemp+ex_energy/m_ExTemp)) ;
                 if (prob > 1 || m_RandGen->GetVariate() < prob)
                 {
-                    m_ParticleGrid->RemoveParticle(pnum);
+                    m_ParticleGrid->RemoveParticle(dp->ID);
                     m_AcceptedProposals++;
+                    if (m_Domain!=NULL)
+                    {
+                        m_NumDomainParticles--;
+                        m_ParticleChange--;
+                    }
                 }
             }
         }
@@ -167,17 +227,23 @@ void MetropolisHastingsSampler::MakeProposal()
     // Shift Proposal
     else  if (randnum < m_BirthProb+m_DeathProb+m_ShiftProb)
     {
-        if (m_ParticleGrid->m_NumParticles > 0)
+        if (GetNumParticles() > 0)
         {
             m_ShiftTime.Start();
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
-            Particle *p =  m_ParticleGrid->GetParticle(pnum);
+            Particle *p =  GetRandomParticle();
+            int pnum = p->ID;
             Particle prop_p = *p;
 
             DistortVector(m_Sigma, prop_p.GetPos());
             DistortVector(m_Sigma/(2*m_ParticleLength), prop_p.GetDir());
             prop_p.GetDir().normalize();
 
+            // particles are not shifted out of the domain
+            if (m_Domain!=NULL && !m_ParticleGrid->IsInDomain(*m_Domain, prop_p.GetPos()))
+            {
+                m_ShiftTime.Stop();
+                return;
+            }
 
             float ex_energy = m_EnergyComputer->ComputeExternalEnergy(prop_p.GetPos(),prop_p.GetDir(),p)
                     - m_EnergyComputer->ComputeExternalEnergy(p->GetPos(),p->GetDir(),p);
@@ -203,11 +269,11 @@ void MetropolisHastingsSampler::MakeProposal()
     // Optimal Shift Proposal
     else  if (randnum < m_BirthProb+m_DeathProb+m_ShiftProb+m_OptShiftProb)
     {
-        if (m_ParticleGrid->m_NumParticles > 0)
+        if (GetNumParticles() > 0)
         {
             m_OptShiftTime.Start();
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
-            Particle *p =  m_ParticleGrid->GetParticle(pnum);
+            Particle *p =  GetRandomParticle();
+            int pnum = p->ID;
 
             bool no_proposal = false;
             Particle prop_p = *p;
@@ -239,6 +305,10 @@ void MetropolisHastingsSampler::MakeProposal()
             else
                 no_proposal = true;
 
+            // particles are not shifted out of the domain
+            if (m_Domain!=NULL && !m_ParticleGrid->IsInDomain(*m_Domain, prop_p.GetPos()))
+                no_proposal = true;
+
             if (!no_proposal)
             {
                 float cos = dot_product(prop_p.GetDir(), p->GetDir());
@@ -270,11 +340,10 @@ void MetropolisHastingsSampler::MakeProposal()
     // Connection Proposal
     else
     {
-        if (m_ParticleGrid->m_NumParticles > 0)
+        if (GetNumParticles() > 0)
         {
             m_ConnectionTime.Start();
-            int pnum = m_RandGen->GetIntegerVariate()%m_ParticleGrid->m_NumParticles;
-            Particle *p = m_ParticleGrid->GetParticle(pnum);
+            Particle *p = GetRandomParticle();
 
             EndPoint P;
             P.p = p;
@@ -311,9 +380,14 @@ void MetropolisHastingsSampler::ImplementTrack(Track &T)
 {
     for (int k = 1; k < T.m_Length;k++)
         m_ParticleGrid->CreateConnection(T.track[k-1].p,T.track[k-1].ep,T.track[k].p,-T.track[k].ep);
+    if (m_Domain!=NULL && T.m_Length>1)
+        m_ConnectionChange += T.m_Length-1;
 }
 
 // remove pending track from random particle, save it in m_BackupTrack and calculate its probability
+// If the track reaches a particle whose connections must not be changed (outside of the domain), the
+// probability is set to 0 and the caller restores the removed part. Truncating the track there instead would
+// bias the acceptance ratio, because a truncated track lacks the factor of the random stop.
 void MetropolisHastingsSampler::RemoveAndSaveTrack(EndPoint P)
 {
     EndPoint Current = P;
@@ -331,8 +405,16 @@ void MetropolisHastingsSampler::RemoveAndSaveTrack(EndPoint P)
             if (Current.p->pID != -1)
             {
                 Next.p = m_ParticleGrid->GetParticle(Current.p->pID);
+                if (!IsWritable(Next.p))
+                {
+                    AccumProb = 0;  // track leaves the domain, see below
+                    break;
+                }
                 Current.p->pID = -1;
-                m_ParticleGrid->m_NumConnections--;
+                if (m_Domain!=NULL)
+                    m_ConnectionChange--;
+                else
+                    m_ParticleGrid->m_NumConnections--;
             }
         }
         else if (Current.ep == -1)
@@ -340,8 +422,16 @@ void MetropolisHastingsSampler::RemoveAndSaveTrack(EndPoint P)
             if (Current.p->mID != -1)
             {
                 Next.p = m_ParticleGrid->GetParticle(Current.p->mID);
+                if (!IsWritable(Next.p))
+                {
+                    AccumProb = 0;  // track leaves the domain, see below
+                    break;
+                }
                 Current.p->mID = -1;
-                m_ParticleGrid->m_NumConnections--;
+                if (m_Domain!=NULL)
+                    m_ConnectionChange--;
+                else
+                    m_ParticleGrid->m_NumConnections--;
             }
         }
         else
@@ -449,16 +539,16 @@ void MetropolisHastingsSampler::ComputeEndPointProposalDistribution(EndPoint P)
 
     float dist,dot;
     vnl_vector_fixed<float, 3> R = p->GetPos() + (p->GetDir() * (ep*m_ParticleLength) );
-    m_ParticleGrid->ComputeNeighbors(R);
+    m_ParticleGrid->ComputeNeighbors(R, m_NeighbourTracker);
     m_SimpSamp.clear();
 
     m_SimpSamp.add(m_StopProb,EndPoint(0,0));
 
     for (;;)
     {
-        Particle *p2 =  m_ParticleGrid->GetNextNeighbor();
+        Particle *p2 =  m_ParticleGrid->GetNextNeighbor(m_NeighbourTracker);
         if (p2 == 0) break;
-        if (p!=p2 && p2->label == 0)
+        if (p!=p2 && p2->label == 0 && IsWritable(p2))
         {
             if (p2->mID == -1)
             {
@@ -52,6 +52,12 @@ public:
     void SetProbabilities(float birth, float death, float shift, float optShift, float connect);    ///< update the probabilities of the single proposals
     void PrintProposalTimes();  ///< print the state of the proposal time probes
 
+    /** Restrict the proposals to the given domain of the particle grid so that several samplers can work on
+     *  domains of the same color concurrently. The proposal probabilities are corrected for the restriction.
+     *  NULL samples the whole grid (default). */
+    void SetDomain(const ParticleGrid::Domain* domain);
+    void CommitChanges();       ///< add the particles and connections created in domains to the counters of the grid, call after concurrent sampling
+
 protected:
 
     /** connection proposal related methods */
@@ -60,6 +66,11 @@ protected:
     void MakeTrackProposal(EndPoint P);
     void ComputeEndPointProposalDistribution(EndPoint P);
 
+    /** particles that may be selected for a proposal, only those in the domain if one is set */
+    int GetNumParticles();
+    Particle* GetRandomParticle();
+    bool IsWritable(Particle* p);   ///< true if the connections of the particle may be changed
+
     /** generate random vectors */
     void DistortVector(float sigma, vnl_vector_fixed<float, 3>& vec);
     vnl_vector_fixed<float, 3> GetRandomDirection();
@@ -95,6 +106,12 @@ protected:
     EnergyComputer* m_EnergyComputer;       ///< computes internal and external energy of particles
     unsigned int    m_AcceptedProposals;    ///< counts accepted proposals
 
+    const ParticleGrid::Domain*     m_Domain;               ///< domain the proposals are restricted to
+    int                             m_NumDomainParticles;   ///< number of particles in the core of the domain
+    int                             m_ParticleChange;       ///< particles added since the last call of CommitChanges()
+    int                             m_ConnectionChange;     ///< connections added since the last call of CommitChanges()
+    ParticleGrid::NeighborTracker   m_NeighbourTracker;
+
     /** Time probes for the single proposals */
     itk::TimeProbe  m_BirthTime;
     itk::TimeProbe  m_DeathTime;
@@ -18,10 +18,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkParticleGrid.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
+#include <algorithm>
 
 using namespace mitk;
 
 ParticleGrid::ParticleGrid(ItkFloatImageType* image, float particleLength, int cellCapacity)
+    : m_ConcurrentSampling(false)
 {
     // initialize counters
     m_NumParticles = 0;
@@ -48,8 +51,6 @@ ParticleGrid::ParticleGrid(ItkFloatImageType* image, float particleLength, int c
     m_Particles.resize(m_ContainerCapacity);        // allocate and initialize particles
     m_Grid.resize(gridSize, NULL);   // allocate and initialize particle grid
     m_OccupationCount.resize(numCells, 0);          // allocate and initialize occupation counter array
-    m_NeighbourTracker.cellidx.resize(8, 0);        // allocate and initialize neighbour tracker
-    m_NeighbourTracker.cellidx_c.resize(8, 0);
 
     for (int i = 0;i < m_ContainerCapacity;i++)     // initialize particle IDs
         m_Particles[i].ID = i;
@@ -72,16 +73,15 @@ void ParticleGrid::ResetGrid()
     m_Particles.clear();
     m_Grid.clear();
     m_OccupationCount.clear();
-    m_NeighbourTracker.cellidx.clear();
-    m_NeighbourTracker.cellidx_c.clear();
+    m_ConcurrentSampling = false;
+    m_NumUsedSlots.Set(0);
+    m_ConcurrentCellOverflows.Set(0);
 
     int numCells = m_GridSize[0]*m_GridSize[1]*m_GridSize[2];   // number of grid cells
 
     m_Particles.resize(m_ContainerCapacity);        // allocate and initialize particles
     m_Grid.resize(numCells*m_CellCapacity, NULL);   // allocate and initialize particle grid
     m_OccupationCount.resize(numCells, 0);          // allocate and initialize occupation counter array
-    m_NeighbourTracker.cellidx.resize(8, 0);        // allocate and initialize neighbour tracker
-    m_NeighbourTracker.cellidx_c.resize(8, 0);
 
     for (int i = 0;i < m_ContainerCapacity;i++)     // initialize particle IDs
         m_Particles[i].ID = i;
@@ -94,7 +94,7 @@ bool ParticleGrid::ReallocateGrid()
     {
         m_Particles.resize(new_capacity);                   // reallocate particles
 
-        for (int i = 0; i<m_ContainerCapacity; i++)         // update particle addresses (changed during reallocation)
+        for (int i = 0; i<m_NumParticles; i++)              // update particle addresses (changed during reallocation)
             m_Grid[m_Particles[i].gridindex] = &m_Particles[i];
 
         for (int i = m_ContainerCapacity; i < new_capacity; i++)    // initialize IDs of ne particles
@@ -119,38 +119,58 @@ Particle* ParticleGrid::GetParticle(int ID)
 }
 
 
-Particle* ParticleGrid::NewParticle(vnl_vector_fixed<float, 3> R)
+int ParticleGrid::GetCellIndex(const vnl_vector_fixed<float, 3>& R)
 {
-    if (m_NumParticles >= m_ContainerCapacity)
-    {
-        if (!ReallocateGrid())
-            return NULL;
-    }
-
     int xint = int(R[0]*m_GridScale[0]);
     if (xint < 0)
-        return NULL;
+        return -1;
     if (xint >= m_GridSize[0])
-        return NULL;
+        return -1;
     int yint = int(R[1]*m_GridScale[1]);
     if (yint < 0)
-        return NULL;
+        return -1;
     if (yint >= m_GridSize[1])
-        return NULL;
+        return -1;
     int zint = int(R[2]*m_GridScale[2]);
     if (zint < 0)
-        return NULL;
+        return -1;
     if (zint >= m_GridSize[2])
+        return -1;
+
+    return xint + m_GridSize[0]*(yint + m_GridSize[1]*zint);
+}
+
+Particle* ParticleGrid::NewParticle(vnl_vector_fixed<float, 3> R)
+{
+    if (!m_ConcurrentSampling && m_NumParticles >= m_ContainerCapacity)
+    {
+        if (!ReallocateGrid())
+            return NULL;
+    }
+
+    int idx = GetCellIndex(R);
+    if (idx<0)
         return NULL;
 
-    int idx = xint + m_GridSize[0]*(yint + m_GridSize[1]*zint);
     if (m_OccupationCount[idx] < m_CellCapacity)
     {
-        Particle *p = &(m_Particles[m_NumParticles]);
+        Particle *p;
+        if (m_ConcurrentSampling)
+        {
+            // the capacity is reserved in advance, particles are never moved during concurrent sampling
+            int slot = m_NumUsedSlots.Increment()-1;
+            if (slot >= m_ContainerCapacity)
+                return NULL;
+            p = &(m_Particles[slot]);
+        }
+        else
+        {
+            p = &(m_Particles[m_NumParticles]);
+            m_NumParticles++;
+        }
         p->GetPos() = R;
         p->mID = -1;
         p->pID = -1;
-        m_NumParticles++;
         p->gridindex = m_CellCapacity*idx + m_OccupationCount[idx];
         m_Grid[p->gridindex] = p;
         m_OccupationCount[idx]++;
@@ -158,7 +178,10 @@ Particle* ParticleGrid::NewParticle(vnl_vector_fixed<float, 3> R)
     }
     else
     {
-        m_NumCellOverflows++;
+        if (m_ConcurrentSampling)
+            m_ConcurrentCellOverflows.Increment();
+        else
+            m_NumCellOverflows++;
         return NULL;
     }
 }
@@ -204,7 +227,10 @@ bool ParticleGrid::TryUpdateGrid(int k)
         }
         else
         {
-            m_NumCellOverflows++;
+            if (m_ConcurrentSampling)
+                m_ConcurrentCellOverflows.Increment();
+            else
+                m_NumCellOverflows++;
             return false;
         }
     }
@@ -233,6 +259,13 @@ void ParticleGrid::RemoveParticle(int k)
     }
     m_OccupationCount[cellIdx]--;
 
+    // leave a gap in the container, IDs of other particles must not change while sampling concurrently
+    if (m_ConcurrentSampling)
+    {
+        p->gridindex = -1;
+        return;
+    }
+
     // remove from container
     if (k < m_NumParticles-1)
     {
@@ -263,6 +296,16 @@ void ParticleGrid::RemoveParticle(int k)
 }
 
 void ParticleGrid::ComputeNeighbors(vnl_vector_fixed<float, 3> &R)
+{
+    ComputeNeighbors(R, m_NeighbourTracker);
+}
+
+Particle* ParticleGrid::GetNextNeighbor()
+{
+    return GetNextNeighbor(m_NeighbourTracker);
+}
+
+void ParticleGrid::ComputeNeighbors(vnl_vector_fixed<float, 3> &R, NeighborTracker& tracker)
 {
     float xfrac = R[0]*m_GridScale[0];
     float yfrac = R[1]*m_GridScale[1];
@@ -290,47 +333,47 @@ void ParticleGrid::ComputeNeighbors(vnl_vector_fixed<float, 3> &R)
     if (m_GridSize[2] <= 1) { dz = 0; } // Necessary with 2d images (bug 15416)
 
 
-    m_NeighbourTracker.cellidx[0] = xint + m_GridSize[0]*(yint+zint*m_GridSize[1]);
-    m_NeighbourTracker.cellidx[1] = m_NeighbourTracker.cellidx[0] + dx;
-    m_NeighbourTracker.cellidx[2] = m_NeighbourTracker.cellidx[1] + dy*m_GridSize[0];
-    m_NeighbourTracker.cellidx[3] = m_NeighbourTracker.cellidx[2] - dx;
-    m_NeighbourTracker.cellidx[4] = m_NeighbourTracker.cellidx[0] + dz*m_GridSize[0]*m_GridSize[1];
-    m_NeighbourTracker.cellidx[5] = m_NeighbourTracker.cellidx[4] + dx;
-    m_NeighbourTracker.cellidx[6] = m_NeighbourTracker.cellidx[5] + dy*m_GridSize[0];
-    m_NeighbourTracker.cellidx[7] = m_NeighbourTracker.cellidx[6] - dx;
+    tracker.cellidx[0] = xint + m_GridSize[0]*(yint+zint*m_GridSize[1]);
+    tracker.cellidx[1] = tracker.cellidx[0] + dx;
+    tracker.cellidx[2] = tracker.cellidx[1] + dy*m_GridSize[0];
+    tracker.cellidx[3] = tracker.cellidx[2] - dx;
+    tracker.cellidx[4] = tracker.cellidx[0] + dz*m_GridSize[0]*m_GridSize[1];
+    tracker.cellidx[5] = tracker.cellidx[4] + dx;
+    tracker.cellidx[6] = tracker.cellidx[5] + dy*m_GridSize[0];
+    tracker.cellidx[7] = tracker.cellidx[6] - dx;
 
 
-    m_NeighbourTracker.cellidx_c[0] = m_CellCapacity*m_NeighbourTracker.cellidx[0];
-    m_NeighbourTracker.cellidx_c[1] = m_CellCapacity*m_NeighbourTracker.cellidx[1];
-    m_NeighbourTracker.cellidx_c[2] = m_CellCapacity*m_NeighbourTracker.cellidx[2];
-    m_NeighbourTracker.cellidx_c[3] = m_CellCapacity*m_NeighbourTracker.cellidx[3];
-    m_NeighbourTracker.cellidx_c[4] = m_CellCapacity*m_NeighbourTracker.cellidx[4];
-    m_NeighbourTracker.cellidx_c[5] = m_CellCapacity*m_NeighbourTracker.cellidx[5];
-    m_NeighbourTracker.cellidx_c[6] = m_CellCapacity*m_NeighbourTracker.cellidx[6];
-    m_NeighbourTracker.cellidx_c[7] = m_CellCapacity*m_NeighbourTracker.cellidx[7];
+    tracker.cellidx_c[0] = m_CellCapacity*tracker.cellidx[0];
+    tracker.cellidx_c[1] = m_CellCapacity*tracker.cellidx[1];
+    tracker.cellidx_c[2] = m_CellCapacity*tracker.cellidx[2];
+    tracker.cellidx_c[3] = m_CellCapacity*tracker.cellidx[3];
+    tracker.cellidx_c[4] = m_CellCapacity*tracker.cellidx[4];
+    tracker.cellidx_c[5] = m_CellCapacity*tracker.cellidx[5];
+    tracker.cellidx_c[6] = m_CellCapacity*tracker.cellidx[6];
+    tracker.cellidx_c[7] = m_CellCapacity*tracker.cellidx[7];
 
-    m_NeighbourTracker.cellcnt = 0;
-    m_NeighbourTracker.pcnt = 0;
+    tracker.cellcnt = 0;
+    tracker.pcnt = 0;
 }
 
-Particle* ParticleGrid::GetNextNeighbor()
+Particle* ParticleGrid::GetNextNeighbor(NeighborTracker& tracker)
 {
-    if (m_NeighbourTracker.pcnt < m_OccupationCount[m_NeighbourTracker.cellidx[m_NeighbourTracker.cellcnt]])
+    if (tracker.pcnt < m_OccupationCount[tracker.cellidx[tracker.cellcnt]])
     {
-        return m_Grid[m_NeighbourTracker.cellidx_c[m_NeighbourTracker.cellcnt] + (m_NeighbourTracker.pcnt++)];
+        return m_Grid[tracker.cellidx_c[tracker.cellcnt] + (tracker.pcnt++)];
     }
     else
     {
         for(;;)
         {
-            m_NeighbourTracker.cellcnt++;
-            if (m_NeighbourTracker.cellcnt >= 8)
+            tracker.cellcnt++;
+            if (tracker.cellcnt >= 8)
                 return 0;
-            if (m_OccupationCount[m_NeighbourTracker.cellidx[m_NeighbourTracker.cellcnt]] > 0)
+            if (m_OccupationCount[tracker.cellidx[tracker.cellcnt]] > 0)
                 break;
         }
-        m_NeighbourTracker.pcnt = 1;
-        return m_Grid[m_NeighbourTracker.cellidx_c[m_NeighbourTracker.cellcnt]];
+        tracker.pcnt = 1;
+        return m_Grid[tracker.cellidx_c[tracker.cellcnt]];
     }
 }
 
@@ -346,7 +389,8 @@ void ParticleGrid::CreateConnection(Particle *P1,int ep1, Particle *P2, int ep2)
     else
         P2->pID = P1->ID;
 
-    m_NumConnections++;
+    if (!m_ConcurrentSampling)
+        m_NumConnections++;
 }
 
 void ParticleGrid::DestroyConnection(Particle *P1,int ep1, Particle *P2, int ep2)
@@ -360,7 +404,9 @@ void ParticleGrid::DestroyConnection(Particle *P1,int ep1, Particle *P2, int ep2
         P2->mID = -1;
     else
         P2->pID = -1;
-    m_NumConnections--;
+
+    if (!m_ConcurrentSampling)
+        m_NumConnections--;
 }
 
 void ParticleGrid::DestroyConnection(Particle *P1,int ep1)
@@ -383,7 +429,8 @@ void ParticleGrid::DestroyConnection(Particle *P1,int ep1)
     else
         P2->pID = -1;
 
-    m_NumConnections--;
+    if (!m_ConcurrentSampling)
+        m_NumConnections--;
 }
 
 bool ParticleGrid::CheckConsistency()
@@ -418,3 +465,163 @@ bool ParticleGrid::CheckConsistency()
     }
     return true;
 }
+
+void ParticleGrid::BeginConcurrentSampling()
+{
+    m_NumUsedSlots.Set(m_NumParticles);
+    m_ConcurrentSampling = true;
+}
+
+void ParticleGrid::EndConcurrentSampling()
+{
+    Compact();
+    m_ConcurrentSampling = false;
+}
+
+bool ParticleGrid::ReserveParticles(int numNewParticles)
+{
+    if (m_NumUsedSlots.Get()+numNewParticles <= m_ContainerCapacity)
+        return true;
+
+    Compact();
+    while (m_NumParticles+numNewParticles > m_ContainerCapacity)
+        if (!ReallocateGrid())
+            return false;
+    return true;
+}
+
+bool ParticleGrid::IsCompact()
+{
+    return !m_ConcurrentSampling || m_NumUsedSlots.Get()==m_NumParticles;
+}
+
+// close the gaps left by removed particles and recount particles, connections and cell overflows
+void ParticleGrid::Compact()
+{
+    if (!m_ConcurrentSampling)
+        return;
+
+    m_NumCellOverflows += m_ConcurrentCellOverflows.Set(0);
+
+    int numSlots = std::min((int)m_NumUsedSlots.Get(), m_ContainerCapacity);
+    std::vector< int > newIds(numSlots, -1);
+    int numParticles = 0;
+    for (int i=0; i<numSlots; i++)
+        if (m_Particles[i].gridindex >= 0)
+            newIds[i] = numParticles++;
+
+    int numConnections = 0;
+    for (int i=0; i<numSlots; i++)
+    {
+        int k = newIds[i];
+        if (k<0)
+            continue;
+        if (k<i)
+            m_Particles[k] = m_Particles[i];    // slots below k are already processed
+        Particle* p = &m_Particles[k];
+        p->ID = k;
+        if (p->pID != -1)
+        {
+            p->pID = newIds[p->pID];
+            numConnections++;
+        }
+        if (p->mID != -1)
+        {
+            p->mID = newIds[p->mID];
+            numConnections++;
+        }
+        m_Grid[p->gridindex] = p;
+    }
+    for (int i=numParticles; i<numSlots; i++)   // reset freed slots
+    {
+        m_Particles[i] = Particle();
+        m_Particles[i].ID = i;
+    }
+
+    m_NumParticles = numParticles;
+    m_NumConnections = numConnections/2;
+    m_NumUsedSlots.Set(numParticles);
+}
+
+void ParticleGrid::CreateDomains(std::vector< Domain >& domains)
+{
+    domains.clear();
+    vnl_vector_fixed< int, 3 > numDomains;
+    for (int i=0; i<3; i++)
+        numDomains[i] = (m_GridSize[i]+DomainSize-1)/DomainSize;
+
+    for (int z=0; z<numDomains[2]; z++)
+        for (int y=0; y<numDomains[1]; y++)
+            for (int x=0; x<numDomains[0]; x++)
+            {
+                Domain domain;
+                domain.m_Min[0] = x*DomainSize; domain.m_Min[1] = y*DomainSize; domain.m_Min[2] = z*DomainSize;
+                for (int i=0; i<3; i++)
+                    domain.m_Max[i] = std::min(domain.m_Min[i]+DomainSize, m_GridSize[i]);
+                domain.m_Color = x%2 + 2*(y%2) + 4*(z%2);
+                domain.m_Mass = 0;
+                domains.push_back(domain);
+            }
+}
+
+int ParticleGrid::GetDomainIndex(const vnl_vector_fixed<int, 3>& cell)
+{
+    for (int i=0; i<3; i++)
+        if (cell[i]<0 || cell[i]>=m_GridSize[i])
+            return -1;
+    int numDomainsX = (m_GridSize[0]+DomainSize-1)/DomainSize;
+    int numDomainsY = (m_GridSize[1]+DomainSize-1)/DomainSize;
+    return cell[0]/DomainSize + numDomainsX*(cell[1]/DomainSize + numDomainsY*(cell[2]/DomainSize));
+}
+
+void ParticleGrid::GetCellOfPosition(const vnl_vector_fixed<float, 3>& R, vnl_vector_fixed<int, 3>& cell)
+{
+    cell[0] = (int)floor(R[0]*m_GridScale[0]);
+    cell[1] = (int)floor(R[1]*m_GridScale[1]);
+    cell[2] = (int)floor(R[2]*m_GridScale[2]);
+}
+
+bool ParticleGrid::IsInDomain(const Domain& domain, const vnl_vector_fixed<float, 3>& R, int margin)
+{
+    vnl_vector_fixed<int, 3> cell;
+    GetCellOfPosition(R, cell);
+    for (int i=0; i<3; i++)
+        if (cell[i] < domain.m_Min[i]-margin || cell[i] >= domain.m_Max[i]+margin)
+            return false;
+    return true;
+}
+
+bool ParticleGrid::IsInDomain(const Domain& domain, Particle* p, int margin)
+{
+    int cellIdx = p->gridindex/m_CellCapacity;
+    int x = cellIdx % m_GridSize[0];
+    int y = (cellIdx / m_GridSize[0]) % m_GridSize[1];
+    int z = cellIdx / (m_GridSize[0]*m_GridSize[1]);
+    return x >= domain.m_Min[0]-margin && x < domain.m_Max[0]+margin
+        && y >= domain.m_Min[1]-margin && y < domain.m_Max[1]+margin
+        && z >= domain.m_Min[2]-margin && z < domain.m_Max[2]+margin;
+}
+
+int ParticleGrid::GetNumParticles(const Domain& domain)
+{
+    int numParticles = 0;
+    for (int z=domain.m_Min[2]; z<domain.m_Max[2]; z++)
+        for (int y=domain.m_Min[1]; y<domain.m_Max[1]; y++)
+            for (int x=domain.m_Min[0]; x<domain.m_Max[0]; x++)
+                numParticles += m_OccupationCount[x + m_GridSize[0]*(y + m_GridSize[1]*z)];
+    return numParticles;
+}
+
+Particle* ParticleGrid::GetParticle(const Domain& domain, int n)
+{
+    for (int z=domain.m_Min[2]; z<domain.m_Max[2]; z++)
+        for (int y=domain.m_Min[1]; y<domain.m_Max[1]; y++)
+            for (int x=domain.m_Min[0]; x<domain.m_Max[0]; x++)
+            {
+                int idx = x + m_GridSize[0]*(y + m_GridSize[1]*z);
+                if (n < m_OccupationCount[idx])
+                    return m_Grid[idx*m_CellCapacity + n];
+                n -= m_OccupationCount[idx];
+            }
+    return NULL;
+}
@@ -20,6 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 // MITK
 #include <MitkFiberTrackingExports.h>
 #include <mitkParticle.h>
+#include <mitkAtomicInteger.h>
 
 // ITK
 #include <itkImage.h>
@@ -37,6 +38,32 @@ public:
 
     typedef itk::Image< float, 3 >  ItkFloatImageType;
 
+    struct NeighborTracker  // to run over the neighbors
+    {
+        int cellidx[8];
+        int cellidx_c[8];
+        int cellcnt;
+        int pcnt;
+    };
+
+    /**
+    * \brief Box of grid cells that is sampled by a single thread during concurrent sampling.
+    *
+    * Particles in the box (core) are changed by the thread, connections may additionally be changed in a
+    * margin of one cell around the core. Particles up to three cells around the core are read.
+    * Domains of the same color are DomainSize cells apart and can therefore be sampled at the same time. */
+    struct Domain
+    {
+        vnl_vector_fixed< int, 3 >  m_Min;      ///< first cell of the core
+        vnl_vector_fixed< int, 3 >  m_Max;      ///< first cell behind the core
+        int                         m_Color;    ///< 0-7
+        float                       m_Mass;     ///< spatial probability of the voxels overlapping the domain (whole mask = 1)
+        std::vector< int >          m_ActiveIndices;                ///< voxels of the mask overlapping the domain
+        std::vector< float >        m_CumulatedSpatialProbability;  ///< normalized to the domain, used to draw random positions
+    };
+
+    static const int DomainSize = 4;    ///< edge length of a domain in cells
+
     int m_NumParticles;         // number of particles
     int m_NumConnections;       // number of connections
     int m_NumCellOverflows;     // number of cell overflows
@@ -53,6 +80,8 @@ public:
 
     void ComputeNeighbors(vnl_vector_fixed<float, 3> &R);
     Particle* GetNextNeighbor();
+    void ComputeNeighbors(vnl_vector_fixed<float, 3> &R, NeighborTracker& tracker);   ///< uses the given tracker instead of the one of the grid, needed by concurrent samplers
+    Particle* GetNextNeighbor(NeighborTracker& tracker);
 
     void CreateConnection(Particle *P1,int ep1, Particle *P2, int ep2);
     void DestroyConnection(Particle *P1,int ep1, Particle *P2, int ep2);
@@ -61,9 +90,27 @@ public:
     bool CheckConsistency();
     void ResetGrid();
 
+    /** Concurrent sampling of disjoint domains. While active, new particles get consecutive slots of the container
+     *  and removed particles leave gaps, so particle IDs stay valid. The counters are not updated (see MetropolisHastingsSampler::CommitChanges()).
+     *  No other method may be called by several threads at once. */
+    void BeginConcurrentSampling();
+    void EndConcurrentSampling();   ///< compacts the container
+    bool ReserveParticles(int numNewParticles);  ///< makes sure the container can take the given number of new particles without reallocation, call between the sampling phases
+    void Compact();                 ///< closes the gaps in the particle container, changes the particle IDs
+    bool IsCompact();
+
+    void CreateDomains(std::vector< Domain >& domains);     ///< partitions the grid into domains, without the voxel information
+    int GetDomainIndex(const vnl_vector_fixed<int, 3>& cell);  ///< index of the domain containing the cell in the vector created by CreateDomains(), -1 if outside of the grid
+    void GetCellOfPosition(const vnl_vector_fixed<float, 3>& R, vnl_vector_fixed<int, 3>& cell);
+    bool IsInDomain(const Domain& domain, const vnl_vector_fixed<float, 3>& R, int margin=0);
+    bool IsInDomain(const Domain& domain, Particle* p, int margin=0);
+    int GetNumParticles(const Domain& domain);              ///< number of particles in the core of the domain
+    Particle* GetParticle(const Domain& domain, int n);     ///< n-th particle in the core of the domain
+
 protected:
 
     bool ReallocateGrid();
+    int GetCellIndex(const vnl_vector_fixed<float, 3>& R);  ///< -1 if outside of the grid
 
     std::vector< Particle* >    m_Grid;             // the grid
     std::vector< Particle >     m_Particles;        // particle container
@@ -76,13 +123,11 @@ protected:
 
     int m_CellCapacity;      // particle capacity of single cell in grid
 
-    struct NeighborTracker  // to run over the neighbors
-    {
-        std::vector< int > cellidx;
-        std::vector< int > cellidx_c;
-        int cellcnt;
-        int pcnt;
-    } m_NeighbourTracker;
+    NeighborTracker m_NeighbourTracker;
+
+    bool                m_ConcurrentSampling;   // true between BeginConcurrentSampling() and EndConcurrentSampling()
+    mitk::AtomicInteger m_NumUsedSlots;         // container slots handed out, particles and gaps
+    mitk::AtomicInteger m_ConcurrentCellOverflows;  // cell overflows during concurrent sampling, added to m_NumCellOverflows by Compact()
 
 };
 
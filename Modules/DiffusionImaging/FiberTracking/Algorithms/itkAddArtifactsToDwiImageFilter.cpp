@@ -246,6 +246,7 @@ void AddArtifactsToDwiImageFilter< TPixelType >
                 typename SliceType::Pointer newSlice;
                 typename itk::DftImageFilter< SliceType::PixelType >::Pointer dft = itk::DftImageFilter< SliceType::PixelType >::New();
                 dft->SetInput(fSlice);
+                dft->SetUseFft(m_Parameters.m_DoUseFft);
                 dft->Update();
                 newSlice = dft->GetOutput();
 
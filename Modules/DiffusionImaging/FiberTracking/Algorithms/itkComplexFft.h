@@ -0,0 +1,292 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef __itkComplexFft_h_
+#define __itkComplexFft_h_
+
+#include <vcl_complex.h>
+#include <vector>
+#include <algorithm>
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+namespace itk{
+
+/**
+* \brief Complex FFT of arbitrary length (recursive mixed-radix Cooley-Tukey). Used by the Fiberfox k-space filters.
+*
+* The length is factorized into radices 4, 2, 3, 5 and the remaining (prime) factors. Each radix is evaluated by a
+* generic butterfly, so lengths with large prime factors are slower but still exact.
+* Sign -1 computes X[k] = sum_j x[j]*exp(-2*pi*i*j*k/n), sign +1 the same with positive exponent. No normalization is applied.
+*/
+class ComplexFft
+{
+public:
+
+    typedef vcl_complex<double> ComplexType;
+
+    ComplexFft() : m_Length(0), m_MaxRadix(1) {}
+    ComplexFft(unsigned int length, int sign) { Initialize(length, sign); }
+
+    void Initialize(unsigned int length, int sign)
+    {
+        m_Length = length;
+        m_Twiddles.resize(length);
+        for (unsigned int j=0; j<length; j++)
+            m_Twiddles[j] = ComplexType(cos(2*M_PI*j/length), sign*sin(2*M_PI*j/length));
+
+        // pairs of (radix, remaining length)
+        m_Factors.clear();
+        m_MaxRadix = 1;
+        unsigned int n = length;
+        unsigned int p = 4;
+        while (n>1)
+        {
+            while (n%p)
+            {
+                switch (p)
+                {
+                case 4: p = 2; break;
+                case 2: p = 3; break;
+                default: p += 2;
+                }
+                if (p*p>n)
+                    p = n;  // no factor up to sqrt(n) -> n is prime
+            }
+            n /= p;
+            m_Factors.push_back(p);
+            m_Factors.push_back(n);
+            if (p>m_MaxRadix)
+                m_MaxRadix = p;
+        }
+    }
+
+    unsigned int GetLength() const { return m_Length; }
+
+    /** Transforms m_Length samples of in (read with the given stride) into out (contiguous). in and out must not overlap. */
+    void Transform(const ComplexType* in, ComplexType* out, unsigned int inStride = 1) const
+    {
+        if (m_Factors.empty())
+        {
+            if (m_Length==1)
+                out[0] = in[0];
+            return;
+        }
+        std::vector< ComplexType > scratch(m_MaxRadix);
+        Work(out, in, 1, inStride, 0, &scratch[0]);
+    }
+
+    /** In-place 2D transform of a row-major buffer with fftX.GetLength() columns and fftY.GetLength() rows. */
+    static void Transform2D(std::vector< ComplexType >& data, const ComplexFft& fftX, const ComplexFft& fftY)
+    {
+        const unsigned int sizeX = fftX.GetLength();
+        const unsigned int sizeY = fftY.GetLength();
+        std::vector< ComplexType > temp(std::max(sizeX, sizeY));
+
+        for (unsigned int y=0; y<sizeY; y++)
+        {
+            fftX.Transform(&data[y*sizeX], &temp[0]);
+            std::copy(temp.begin(), temp.begin()+sizeX, data.begin()+y*sizeX);
+        }
+        for (unsigned int x=0; x<sizeX; x++)
+        {
+            fftY.Transform(&data[x], &temp[0], sizeX);
+            for (unsigned int y=0; y<sizeY; y++)
+                data[y*sizeX+x] = temp[y];
+        }
+    }
+
+protected:
+
+    void Work(ComplexType* out, const ComplexType* in, unsigned int fStride, unsigned int inStride, unsigned int factor, ComplexType* scratch) const
+    {
+        const unsigned int p = m_Factors[factor];    // radix of this stage
+        const unsigned int m = m_Factors[factor+1];  // length of the sub-transforms
+
+        // decimation in time: transform the p interleaved subsequences
+        if (m==1)
+            for (unsigned int q=0; q<p; q++)
+                out[q] = in[q*fStride*inStride];
+        else
+            for (unsigned int q=0; q<p; q++)
+                Work(out+q*m, in+q*fStride*inStride, fStride*p, inStride, factor+2, scratch);
+
+        // combine them with a radix-p butterfly
+        for (unsigned int u=0; u<m; u++)
+        {
+            for (unsigned int q=0; q<p; q++)
+                scratch[q] = out[u+q*m];
+
+            for (unsigned int q=0; q<p; q++)
+            {
+                const unsigned int k = u+q*m;
+                ComplexType sum = scratch[0];
+                unsigned int twiddle = 0;
+                for (unsigned int r=1; r<p; r++)
+                {
+                    twiddle += fStride*k;
+                    if (twiddle>=m_Length)
+                        twiddle -= m_Length;
+                    sum += scratch[r]*m_Twiddles[twiddle];
+                }
+                out[k] = sum;
+            }
+        }
+    }
+
+    unsigned int                m_Length;
+    unsigned int                m_MaxRadix;
+    std::vector< ComplexType >  m_Twiddles;
+    std::vector< unsigned int > m_Factors;
+};
+
+/**
+* \brief Evaluates the 2D Fourier sum sum_{x,y} f(x,y)*exp(sign*2*pi*i*(kx*x/sizeX + ky*y/sizeY)) at arbitrary real (kx,ky)
+* (type 2 non-uniform FFT). Pixel coordinates are centered: x = xIdx - sizeX/2, y = yIdx - sizeY/2.
+*
+* The image is divided by the Fourier transform of a Kaiser-Bessel kernel, zero padded to twice its size and transformed
+* with an FFT. Each frequency is then interpolated from the 6x6 closest oversampled frequencies (relative error about 1e-5).
+*/
+class NonUniformFft2D
+{
+public:
+
+    typedef ComplexFft::ComplexType ComplexType;
+
+    NonUniformFft2D(unsigned int sizeX, unsigned int sizeY, int sign)
+        : m_SizeX(sizeX)
+        , m_SizeY(sizeY)
+        , m_GridSizeX(2*sizeX)
+        , m_GridSizeY(2*sizeY)
+        , m_Sign(sign)
+        , m_FftX(2*sizeX, sign)
+        , m_FftY(2*sizeY, sign)
+    {
+        m_Beta = M_PI*sqrt(KernelWidth*KernelWidth/4.0*(2-0.5)*(2-0.5)-0.8);
+        m_DeapodizationX = Deapodization(sizeX, m_GridSizeX);
+        m_DeapodizationY = Deapodization(sizeY, m_GridSizeY);
+    }
+
+    /** Image in row-major order, sizeX columns and sizeY rows. */
+    void SetImage(const std::vector< ComplexType >& image)
+    {
+        m_Grid.assign(m_GridSizeX*m_GridSizeY, ComplexType(0,0));
+        for (unsigned int y=0; y<m_SizeY; y++)
+        {
+            unsigned int gridY = (y+m_GridSizeY-m_SizeY/2)%m_GridSizeY;
+            for (unsigned int x=0; x<m_SizeX; x++)
+            {
+                unsigned int gridX = (x+m_GridSizeX-m_SizeX/2)%m_GridSizeX;
+                m_Grid[gridY*m_GridSizeX+gridX] = image[y*m_SizeX+x]/(m_DeapodizationX[x]*m_DeapodizationY[y]);
+            }
+        }
+        ComplexFft::Transform2D(m_Grid, m_FftX, m_FftY);
+    }
+
+    ComplexType Evaluate(double kx, double ky) const
+    {
+        double u = 2*kx;
+        double v = 2*ky;
+        int firstX = (int)ceil(u-KernelWidth/2.0);
+        int firstY = (int)ceil(v-KernelWidth/2.0);
+
+        double weightsX[KernelWidth+1];
+        double weightsY[KernelWidth+1];
+        for (int j=0; j<=KernelWidth; j++)
+        {
+            weightsX[j] = Kernel(u-(firstX+j));
+            weightsY[j] = Kernel(v-(firstY+j));
+        }
+
+        ComplexType s(0,0);
+        for (int j=0; j<=KernelWidth; j++)
+        {
+            if (weightsY[j]==0)
+                continue;
+            int gridY = (firstY+j)%(int)m_GridSizeY;
+            if (gridY<0)
+                gridY += m_GridSizeY;
+            ComplexType row(0,0);
+            for (int i=0; i<=KernelWidth; i++)
+            {
+                int gridX = (firstX+i)%(int)m_GridSizeX;
+                if (gridX<0)
+                    gridX += m_GridSizeX;
+                row += weightsX[i]*m_Grid[gridY*m_GridSizeX+gridX];
+            }
+            s += weightsY[j]*row;
+        }
+
+        // grid coordinates start at -(size/2) instead of -size/2.0 for odd sizes
+        double shiftX = (double)(m_SizeX/2)-m_SizeX/2.0;
+        double shiftY = (double)(m_SizeY/2)-m_SizeY/2.0;
+        return s*exp( ComplexType(0, m_Sign*2*M_PI*(kx*shiftX/m_SizeX + ky*shiftY/m_SizeY)) );
+    }
+
+protected:
+
+    enum { KernelWidth = 6 };
+
+    static double BesselI0(double x)
+    {
+        double sum = 1;
+        double term = 1;
+        for (int k=1; k<50 && term>1e-16*sum; k++)
+        {
+            term *= x*x/(4.0*k*k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    double Kernel(double u) const
+    {
+        double r = 2*u/KernelWidth;
+        if (fabs(r)>=1)
+            return 0;
+        return BesselI0(m_Beta*sqrt(1-r*r));
+    }
+
+    /** Fourier transform of the kernel at the centered pixel coordinates. */
+    std::vector< double > Deapodization(unsigned int size, unsigned int gridSize) const
+    {
+        std::vector< double > result(size);
+        for (unsigned int i=0; i<size; i++)
+        {
+            double omega = M_PI*KernelWidth*((double)i-size/2)/gridSize;
+            double z2 = m_Beta*m_Beta-omega*omega;
+            result[i] = z2>0 ? KernelWidth*sinh(sqrt(z2))/sqrt(z2) : KernelWidth*sin(sqrt(-z2))/sqrt(-z2);
+        }
+        return result;
+    }
+
+    unsigned int                m_SizeX;
+    unsigned int                m_SizeY;
+    unsigned int                m_GridSizeX;
+    unsigned int                m_GridSizeY;
+    int                         m_Sign;
+    double                      m_Beta;
+    ComplexFft                  m_FftX;
+    ComplexFft                  m_FftY;
+    std::vector< double >       m_DeapodizationX;
+    std::vector< double >       m_DeapodizationY;
+    std::vector< ComplexType >  m_Grid;
+};
+
+}
+
+#endif //__itkComplexFft_h_
@@ -25,6 +25,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImageRegionConstIterator.h>
 #include <itkImageRegionConstIteratorWithIndex.h>
 #include <itkImageRegionIterator.h>
+#include "itkComplexFft.h"
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -34,10 +35,36 @@ namespace itk {
 template< class TPixelType >
 DftImageFilter< TPixelType >
 ::DftImageFilter()
+    : m_UseFft(false)
 {
     this->SetNumberOfRequiredInputs( 1 );
 }
 
+template< class TPixelType >
+void DftImageFilter< TPixelType >
+::BeforeThreadedGenerateData()
+{
+    m_Transformed.clear();
+    if (!m_UseFft)
+        return;
+
+    typename InputImageType::Pointer inputImage  = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
+    int szx = inputImage->GetLargestPossibleRegion().GetSize(0);
+    int szy = inputImage->GetLargestPossibleRegion().GetSize(1);
+
+    m_Transformed.resize(szx*szy);
+    ImageRegionConstIteratorWithIndex< InputImageType > it(inputImage, inputImage->GetLargestPossibleRegion() );
+    while( !it.IsAtEnd() )
+    {
+        m_Transformed[it.GetIndex()[1]*szx+it.GetIndex()[0]] = vcl_complex<double>(it.Get().real(), it.Get().imag());
+        ++it;
+    }
+
+    ComplexFft fftX(szx, -1);
+    ComplexFft fftY(szy, -1);
+    ComplexFft::Transform2D(m_Transformed, fftX, fftY);
+}
+
 template< class TPixelType >
 void DftImageFilter< TPixelType >
 ::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, ThreadIdType)
@@ -68,16 +95,23 @@ void DftImageFilter< TPixelType >
             ky = ky - szy/2;
 
         vcl_complex<double> s(0,0);
-        InputIteratorType it(inputImage, inputImage->GetLargestPossibleRegion() );
-        while( !it.IsAtEnd() )
+        if (!m_Transformed.empty())
+        {
+            s = m_Transformed[ky*szx+kx];
+        }
+        else
         {
-            int x = it.GetIndex()[0];
-            int y = it.GetIndex()[1];
+            InputIteratorType it(inputImage, inputImage->GetLargestPossibleRegion() );
+            while( !it.IsAtEnd() )
+            {
+                int x = it.GetIndex()[0];
+                int y = it.GetIndex()[1];
 
-            vcl_complex<double> f(it.Get().real(), it.Get().imag());
-            s += f * exp( std::complex<double>(0, -2 * M_PI * (kx*(double)x/szx + ky*(double)y/szy) ) );
+                vcl_complex<double> f(it.Get().real(), it.Get().imag());
+                s += f * exp( std::complex<double>(0, -2 * M_PI * (kx*(double)x/szx + ky*(double)y/szy) ) );
 
-            ++it;
+                ++it;
+            }
         }
         double magn = sqrt(s.real()*s.real()+s.imag()*s.imag());
         oit.Set(magn);
@@ -26,6 +26,7 @@ This file is based heavily on a corresponding ITK filter.
 #include <itkImageToImageFilter.h>
 #include <itkDiffusionTensor3D.h>
 #include <vcl_complex.h>
+#include <vector>
 
 namespace itk{
 
@@ -55,12 +56,19 @@ namespace itk{
     typedef typename Superclass::OutputImageType        OutputImageType;
     typedef typename Superclass::OutputImageRegionType  OutputImageRegionType;
 
+    itkSetMacro( UseFft, bool )     ///< Use an FFT instead of the direct sum over all pixels.
+    itkGetMacro( UseFft, bool )
+
   protected:
     DftImageFilter();
     ~DftImageFilter() {}
 
+    void BeforeThreadedGenerateData();
     void ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread, ThreadIdType threadId);
 
+    bool                                m_UseFft;
+    std::vector< vcl_complex<double> >  m_Transformed;    ///< FFT of the input (row-major), empty if the direct sum is used
+
   private:
 
   };
@@ -29,12 +29,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImageDuplicator.h>
 #include <itkResampleImageFilter.h>
 #include <itkTimeProbe.h>
+#include <mitkAtomicInteger.h>
 
 // MISC
 #include <fstream>
 // #include <QFile>
 #include <tinyxml.h>
 #include <math.h>
+#include <algorithm>
 #include <boost/progress.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
@@ -59,6 +61,7 @@ GibbsTrackingFilter< ItkQBallImageType >::GibbsTrackingFilter():
     m_BuildFibers(false),
     m_Steps(10),
     m_ProposalAcceptance(0),
+    m_ProposalsPerSecond(0),
     m_CurvatureThreshold(0.7),
     m_DuplicateImage(true),
     m_NumParticles(0),
@@ -66,9 +69,40 @@ GibbsTrackingFilter< ItkQBallImageType >::GibbsTrackingFilter():
     m_RandomSeed(-1),
     m_LoadParameterFile(""),
     m_LutPath(""),
-    m_IsInValidState(true)
+    m_IsInValidState(true),
+    m_IsGridConsistent(true)
 {
+    this->SetNumberOfThreads(1);    // sequential sampling, reproducible with a fixed random seed
+}
+
+template< class ItkQBallImageType >
+struct GibbsTrackingFilter< ItkQBallImageType >::SamplingJobs
+{
+    SamplingJobs() : Filter(NULL), Samplers(NULL), NumProposals(0) {}
+
+    Self*                                       Filter;
+    std::vector< MetropolisHastingsSampler* >*  Samplers;       ///< one sampler per thread
+    std::vector< const ParticleGrid::Domain* >  Domains;        ///< domains of the current color
+    std::vector< unsigned long >                Proposals;      ///< number of proposals per domain
+    unsigned long                               NumProposals;
+    mitk::AtomicInteger                         NextDomain;
+    mitk::AtomicInteger                         NextSampler;
+};
 
+template< class ItkQBallImageType >
+ITK_THREAD_RETURN_TYPE GibbsTrackingFilter< ItkQBallImageType >::SamplingJobsCallback( void* arg )
+{
+    SamplingJobs* jobs = static_cast< SamplingJobs* >( static_cast< MultiThreader::ThreadInfoStruct* >(arg)->UserData );
+    MetropolisHastingsSampler* sampler = jobs->Samplers->at(jobs->NextSampler.Increment()-1);
+
+    for (long d=jobs->NextDomain.Increment()-1; d<(long)jobs->Domains.size() && !jobs->Filter->m_AbortTracking; d=jobs->NextDomain.Increment()-1)
+    {
+        sampler->SetDomain(jobs->Domains[d]);
+        for (unsigned long i=0; i<jobs->Proposals[d]; i++)
+            sampler->MakeProposal();
+    }
+    sampler->SetDomain(NULL);
+    return ITK_THREAD_RETURN_VALUE;
 }
 
 template< class ItkQBallImageType >
@@ -283,8 +317,33 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
     MITK_INFO << "Min. fiber length: " << m_MinFiberLength;
     MITK_INFO << "Curvature threshold: " << m_CurvatureThreshold;
     MITK_INFO << "Random seed: " << m_RandomSeed;
+    MITK_INFO << "Threads: " << this->GetNumberOfThreads();
     MITK_INFO << "----------------------------------------";
 
+    // concurrent sampling: each thread gets its own sampler, energy computer, sphere interpolator and random generator
+    std::vector< ParticleGrid::Domain > domains;
+    std::vector< MetropolisHastingsSampler* > samplers;
+    std::vector< GibbsEnergyComputer* > threadEnergyComputers;
+    std::vector< SphereInterpolator* > threadInterpolators;
+    std::vector< Statistics::MersenneTwisterRandomVariateGenerator::Pointer > threadRandGens;
+    if (this->GetNumberOfThreads()>1 && !m_AbortTracking)
+    {
+        particleGrid->CreateDomains(domains);
+        encomp->InitializeDomains(domains);
+        MITK_INFO << "GibbsTrackingFilter: sampling " << domains.size() << " domains with " << this->GetNumberOfThreads() << " threads";
+
+        for (unsigned int t=0; t<this->GetNumberOfThreads(); t++)
+        {
+            threadRandGens.push_back(Statistics::MersenneTwisterRandomVariateGenerator::New());
+            threadRandGens.back()->SetSeed(randGen->GetIntegerVariate());
+            threadInterpolators.push_back(new SphereInterpolator(*interpolator));
+            threadEnergyComputers.push_back(new GibbsEnergyComputer(m_QBallImage, m_MaskImage, particleGrid, threadInterpolators.back(), threadRandGens.back()));
+            threadEnergyComputers.back()->SetParameters(m_ParticleWeight,m_ParticleWidth,m_ConnectionPotential*m_ParticleLength*m_ParticleLength,m_CurvatureThreshold,m_InexBalance,m_ParticlePotential);
+            samplers.push_back(new MetropolisHastingsSampler(particleGrid, threadEnergyComputers.back(), threadRandGens.back(), m_CurvatureThreshold));
+        }
+        particleGrid->BeginConcurrentSampling();
+    }
+
     // main loop
     preClock.Stop();
     TimeProbe clock; clock.Start();
@@ -298,44 +357,134 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
         // update temperatur for simulated annealing process
         float temperature = m_StartTemperature * exp(alpha*(((1.0)*m_CurrentStep)/((1.0)*m_Steps)));
         sampler->SetTemperature(temperature);
+        for (unsigned int t=0; t<samplers.size(); t++)
+            samplers[t]->SetTemperature(temperature);
 
-        for (unsigned long i=0; i<singleIts; i++)
+        TimeProbe stepClock; stepClock.Start();
+        unsigned long stepProposals = 0;
+        if (samplers.empty())
         {
-            ++disp;
-            if (m_AbortTracking)
-                break;
+            for (unsigned long i=0; i<singleIts; i++)
+            {
+                ++disp;
+                if (m_AbortTracking)
+                    break;
 
-            sampler->MakeProposal();
+                sampler->MakeProposal();
 
-            if (m_BuildFibers || (i==singleIts-1 && m_CurrentStep==m_Steps))
+                if (m_BuildFibers || (i==singleIts-1 && m_CurrentStep==m_Steps))
+                {
+                    m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/counter;
+                    m_NumParticles = particleGrid->m_NumParticles;
+                    m_NumConnections = particleGrid->m_NumConnections;
+
+                    FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
+                    m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
+                    m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+                    m_BuildFibers = false;
+                }
+                counter++;
+                stepProposals++;
+            }
+        }
+        else
+        {
+            // domains of the same color are sampled concurrently, the number of proposals of a domain is proportional to its mass
+            for (int color=0; color<8 && !m_AbortTracking; color++)
             {
-                m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/counter;
-                m_NumParticles = particleGrid->m_NumParticles;
-                m_NumConnections = particleGrid->m_NumConnections;
-
-                FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
-                m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
-                m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
-                m_BuildFibers = false;
+                SamplingJobs jobs;
+                jobs.Filter = this;
+                jobs.Samplers = &samplers;
+                for (unsigned int d=0; d<domains.size(); d++)
+                {
+                    if (domains[d].m_Color!=color)
+                        continue;
+                    float proposals = singleIts*domains[d].m_Mass;
+                    unsigned long numProposals = (unsigned long)proposals;
+                    if (randGen->GetVariate() < proposals-numProposals)
+                        numProposals++;
+                    if (numProposals>0)
+                    {
+                        jobs.Domains.push_back(&domains[d]);
+                        jobs.Proposals.push_back(numProposals);
+                        jobs.NumProposals += numProposals;
+                    }
+                }
+                if (jobs.Domains.empty())
+                    continue;
+
+                // every proposal could be a birth, the particle container must not be reallocated while sampling
+                if (!particleGrid->ReserveParticles(jobs.NumProposals))
+                {
+                    MITK_ERROR << "Particle grid allocation failed. Not enough memory? Try to increase the particle length.";
+                    m_AbortTracking = true;
+                    break;
+                }
+
+                this->GetMultiThreader()->SetNumberOfThreads(std::min((unsigned long)samplers.size(), (unsigned long)jobs.Domains.size()));
+                this->GetMultiThreader()->SetSingleMethod(SamplingJobsCallback, &jobs);
+                this->GetMultiThreader()->SingleMethodExecute();
+
+                for (unsigned int t=0; t<samplers.size(); t++)
+                    samplers[t]->CommitChanges();
+                disp += jobs.NumProposals;
+                counter += jobs.NumProposals;
+                stepProposals += jobs.NumProposals;
+
+                if (m_BuildFibers)
+                {
+                    particleGrid->Compact();
+                    m_NumParticles = particleGrid->m_NumParticles;
+                    m_NumConnections = particleGrid->m_NumConnections;
+
+                    FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
+                    m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
+                    m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+                    m_BuildFibers = false;
+                }
             }
-            counter++;
         }
-
-        m_ProposalAcceptance = (float)sampler->GetNumAcceptedProposals()/counter;
+        stepClock.Stop();
+        if (stepClock.GetTotal()>0)
+            m_ProposalsPerSecond = stepProposals/stepClock.GetTotal();
+
+        unsigned long acceptedProposals = sampler->GetNumAcceptedProposals();
+        for (unsigned int t=0; t<samplers.size(); t++)
+            acceptedProposals += samplers[t]->GetNumAcceptedProposals();
+        m_ProposalAcceptance = (float)acceptedProposals/counter;
         m_NumParticles = particleGrid->m_NumParticles;
         m_NumConnections = particleGrid->m_NumConnections;
 
         if (m_AbortTracking)
             break;
     }
+    if (!samplers.empty())
+    {
+        particleGrid->EndConcurrentSampling();
+        m_NumParticles = particleGrid->m_NumParticles;
+        m_NumConnections = particleGrid->m_NumConnections;
+        if (!m_AbortTracking)
+        {
+            FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
+            m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
+            m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
+        }
+    }
     if (m_AbortTracking)
     {
         FiberBuilder fiberBuilder(particleGrid, m_MaskImage);
         m_FiberPolyData = fiberBuilder.iterate(m_MinFiberLength);
         m_NumAcceptedFibers = m_FiberPolyData->GetNumberOfLines();
     }
+    m_IsGridConsistent = particleGrid->CheckConsistency();
     clock.Stop();
 
+    for (unsigned int t=0; t<samplers.size(); t++)
+    {
+        delete samplers[t];
+        delete threadEnergyComputers[t];
+        delete threadInterpolators[t];
+    }
     delete sampler;
     delete encomp;
     delete interpolator;
@@ -351,6 +500,7 @@ void GibbsTrackingFilter< ItkQBallImageType >::GenerateData()
     s = (int)preClock.GetTotal()%60;
     MITK_INFO << "GibbsTrackingFilter: preparation of the data took " << m << "m and " << s << "s";
     MITK_INFO << "GibbsTrackingFilter: " << m_NumAcceptedFibers << " fibers accepted";
+    MITK_INFO << "GibbsTrackingFilter: " << m_ProposalsPerSecond << " proposals per second in the last step";
 
 //    sampler->PrintProposalTimes();
 
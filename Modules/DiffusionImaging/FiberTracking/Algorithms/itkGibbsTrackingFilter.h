@@ -35,7 +35,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 namespace itk{
 
 /**
-* \brief Performes global fiber tractography on the input Q-Ball or tensor image (Gibbs tracking, Reisert 2010).   */
+* \brief Performes global fiber tractography on the input Q-Ball or tensor image (Gibbs tracking, Reisert 2010).
+*
+* With more than one thread (SetNumberOfThreads(), default 1) the particle grid is split into domains that are
+* sampled concurrently. Domains are processed in eight color phases, domains of one color do not interact.
+* The result of the concurrent sampling depends on the scheduling and is not reproducible with a fixed random seed.   */
 
 template< class ItkQBallImageType >
 class GibbsTrackingFilter : public ProcessObject
@@ -83,8 +87,10 @@ public:
     itkGetMacro( NumConnections, int )
     itkGetMacro( NumAcceptedFibers, int )
     itkGetMacro( ProposalAcceptance, float )
+    itkGetMacro( ProposalsPerSecond, float )        ///< Number of proposals per second during the last temperature step.
     itkGetMacro( Steps, unsigned int)
     itkGetMacro( IsInValidState, bool)
+    itkGetMacro( IsGridConsistent, bool)            ///< Result of the particle grid consistency check after the last tracking run.
     FiberPolyDataType GetFiberBundle();             ///< Output fibers
 
     /** Input images. */
@@ -107,6 +113,9 @@ protected:
     bool LoadParameters();
     bool SaveParameters();
 
+    struct SamplingJobs;    ///< Domains of one color and the samplers working on them.
+    static ITK_THREAD_RETURN_TYPE SamplingJobsCallback(void* arg);
+
     // Input Images
     typename ItkQBallImageType::Pointer m_QBallImage;
     typename ItkFloatImageType::Pointer m_MaskImage;
@@ -129,6 +138,7 @@ protected:
     volatile bool   m_BuildFibers;          ///< set flag to generate fibers from particle grid
     unsigned int    m_Steps;                ///< number of temperature decrease steps
     float           m_ProposalAcceptance;   ///< proposal acceptance rate (0-1)
+    float           m_ProposalsPerSecond;   ///< sampling throughput of the last temperature step
     float           m_CurvatureThreshold;   ///< curvature threshold in radians (1 -> no curvature is accepted, -1 all curvature angles are accepted)
     bool            m_DuplicateImage;       ///< generates a working copy of the qball image so that the original image won't be changed by the mean subtraction
     int             m_NumParticles;         ///< current number of particles in grid
@@ -138,6 +148,7 @@ protected:
     std::string     m_SaveParameterFile;    ///< filename of parameter file (writer)
     std::string     m_LutPath;              ///< path to lookuptables used by the sphere interpolator
     bool            m_IsInValidState;       ///< Whether the filter is in a valid state, false if error occured
+    bool            m_IsGridConsistent;     ///< particle IDs and connections of the final particle grid are consistent
 
     FiberPolyDataType m_FiberPolyData;      ///< container for reconstructed fibers
 
@@ -26,6 +26,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itkImageRegionConstIteratorWithIndex.h>
 #include <itkImageRegionIterator.h>
 #include <itkImageFileWriter.h>
+#include "itkComplexFft.h"
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -38,6 +39,7 @@ KspaceImageFilter< TPixelType >
     : m_FrequencyMapSlice(NULL)
     , m_Z(0)
     , m_UseConstantRandSeed(false)
+    , m_RandSeed(-1)
     , m_SpikesPerSlice(0)
     , m_IsBaseline(true)
 {
@@ -51,7 +53,9 @@ template< class TPixelType >
 void KspaceImageFilter< TPixelType >
 ::BeforeThreadedGenerateData()
 {
-    if (m_UseConstantRandSeed)  // always generate the same random numbers?
+    if (m_RandSeed>=0)
+        m_RandGen->SetSeed(m_RandSeed);
+    else if (m_UseConstantRandSeed)  // always generate the same random numbers?
         m_RandGen->SetSeed(0);
     else
         m_RandGen->SetSeed();
@@ -64,6 +68,7 @@ void KspaceImageFilter< TPixelType >
     outputImage->Allocate();
 
     double gamma = 42576000;    // Gyromagnetic ratio in Hz/T
+    m_IsBaseline = true;
     if (m_Parameters.m_EddyStrength>0 && m_DiffusionGradientDirection.GetNorm()>0.001)
     {
         m_DiffusionGradientDirection.Normalize();
@@ -78,24 +83,20 @@ void KspaceImageFilter< TPixelType >
     for (int i=0; i<3; i++)
         for (int j=0; j<3; j++)
             m_Transform[i][j] *= m_Parameters.m_ImageSpacing[j];
+
+    m_FftKspace.clear();
+    if (m_Parameters.m_DoUseFft && !ComputeKspaceFft())
+        MITK_INFO << "Time segmentation needs more FFTs than the direct DFT. Using the direct DFT.";
 }
 
 template< class TPixelType >
 void KspaceImageFilter< TPixelType >
-::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, ThreadIdType)
+::GetKspaceSample(const itk::Index<2>& acquisitionIdx, itk::Index<2>& kIdx, double& kx, double& ky, double& t) const
 {
-    typename OutputImageType::Pointer outputImage = static_cast< OutputImageType * >(this->ProcessObject::GetOutput(0));
-
-    ImageRegionIterator< OutputImageType > oit(outputImage, outputRegionForThread);
-
-    typedef ImageRegionConstIterator< InputImageType > InputIteratorType;
-
-    double kxMax = outputImage->GetLargestPossibleRegion().GetSize(0);  // k-space size in x-direction
-    double kyMax = outputImage->GetLargestPossibleRegion().GetSize(1);  // k-space size in y-direction
+    double kxMax = m_OutSize[0];  // k-space size in x-direction
+    double kyMax = m_OutSize[1];  // k-space size in y-direction
     double xMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(0); // scanner coverage in x-direction
-    double yMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(1); // scanner coverage in y-direction
 
-    double numPix = kxMax*kyMax;
     double dt = m_Parameters.m_tLine/kxMax;
     double fromMaxEcho = - m_Parameters.m_tLine*kyMax/2;
 
@@ -105,90 +106,362 @@ void KspaceImageFilter< TPixelType >
     int xRingingOffset = xMax-kxMax;
     int yRingingOffset = yMaxFov-kyMax;
 
-    while( !oit.IsAtEnd() )
-    {
-        itk::Index< 2 > kIdx;
-        kIdx[0] = oit.GetIndex()[0];
-        kIdx[1] = oit.GetIndex()[1];
+    kIdx[0] = acquisitionIdx[0];
+    kIdx[1] = acquisitionIdx[1];
 
-        double t = fromMaxEcho + ((double)kIdx[1]*kxMax+(double)kIdx[0])*dt;    // dephasing time
+    t = fromMaxEcho + ((double)kIdx[1]*kxMax+(double)kIdx[0])*dt;    // dephasing time
 
-        // rearrange slice
-        if( kIdx[0] <  kxMax/2 )
-            kIdx[0] = kIdx[0] + kxMax/2;
-        else
-            kIdx[0] = kIdx[0] - kxMax/2;
+    // rearrange slice
+    if( kIdx[0] <  kxMax/2 )
+        kIdx[0] = kIdx[0] + kxMax/2;
+    else
+        kIdx[0] = kIdx[0] - kxMax/2;
 
-        if( kIdx[1] <  kyMax/2 )
-            kIdx[1] = kIdx[1] + kyMax/2;
-        else
-            kIdx[1] = kIdx[1] - kyMax/2;
+    if( kIdx[1] <  kyMax/2 )
+        kIdx[1] = kIdx[1] + kyMax/2;
+    else
+        kIdx[1] = kIdx[1] - kyMax/2;
 
-        // calculate eddy current decay factors
-        double eddyDecay = 0;
-        if (m_Parameters.m_EddyStrength>0)
-            eddyDecay = exp(-(m_Parameters.m_tEcho/2 + t)/m_Parameters.m_Tau) * t/1000;
+    kx = kIdx[0];
+    ky = kIdx[1];
+    if (acquisitionIdx[1]%2 == 1)               // reverse readout direction and add ghosting
+    {
+        kIdx[0] = kxMax-kIdx[0]-1;                // reverse readout direction
+        kx = (double)kIdx[0]-m_Parameters.m_KspaceLineOffset;    // add gradient delay induced offset
+    }
+    else
+        kx += m_Parameters.m_KspaceLineOffset;    // add gradient delay induced offset
 
-        // calcualte signal relaxation factors
-        std::vector< double > relaxFactor;
-        if (m_Parameters.m_DoSimulateRelaxation)
-            for (unsigned int i=0; i<m_CompartmentImages.size(); i++)
-                relaxFactor.push_back(exp(-(m_Parameters.m_tEcho+t)/m_T2.at(i) -fabs(t)/m_Parameters.m_tInhom));
+    // add gibbs ringing offset (cropps k-space)
+    if (kx>=kxMax/2)
+        kx += xRingingOffset;
+    if (ky>=kyMax/2)
+        ky += yRingingOffset;
+}
 
-        double kx = kIdx[0];
-        double ky = kIdx[1];
-        if (oit.GetIndex()[1]%2 == 1)               // reverse readout direction and add ghosting
+template< class TPixelType >
+bool KspaceImageFilter< TPixelType >
+::ComputeKspaceFft()
+{
+    typedef ComplexFft::ComplexType ComplexType;
+
+    // largest phase change (in cycles) between two interpolated time points of the time segmentation
+    const double maxPhaseStep = 0.01;
+
+    const unsigned int kxMax = m_OutSize[0];
+    const unsigned int kyMax = m_OutSize[1];
+    const unsigned int xMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(0);
+    const unsigned int yMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(1);
+    const unsigned int numSamples = kxMax*kyMax;
+    const unsigned int numCompartments = m_CompartmentImages.size();
+    const double yMaxFov = kyMax*(double)xMax/kxMax;
+
+    // k-space rows are transformed with an FFT if the phase encoding FOV matches the image, directly otherwise
+    bool fftRows = yMaxFov==(double)yMax;
+
+    // eddy currents add a phase that is linear in space, i.e. they shift the sampled k-space location.
+    // The shifted locations are evaluated with a non-uniform FFT, or by time segmentation if the FOV is cropped.
+    bool simulateEddy = m_Parameters.m_EddyStrength>0 && !m_IsBaseline;
+    bool nonUniform = simulateEddy && fftRows;
+    double eddyX = 0, eddyY = 0, eddyZ = 0;     // phase per pixel (in cycles) for unit eddy decay
+    if (simulateEddy)
+        for (int i=0; i<3; i++)
         {
-            kIdx[0] = kxMax-kIdx[0]-1;                // reverse readout direction
-            kx = (double)kIdx[0]-m_Parameters.m_KspaceLineOffset;    // add gradient delay induced offset
+            eddyX += m_DiffusionGradientDirection[i]*m_Transform[i][0]/1000;
+            eddyY += m_DiffusionGradientDirection[i]*m_Transform[i][1]/1000;
+            eddyZ += m_DiffusionGradientDirection[i]*m_Transform[i][2]*m_Z/1000;
         }
-        else
-            kx += m_Parameters.m_KspaceLineOffset;    // add gradient delay induced offset
-
-        // add gibbs ringing offset (cropps k-space)
-        if (kx>=kxMax/2)
-            kx += xRingingOffset;
-        if (ky>=kyMax/2)
-            ky += yRingingOffset;
 
-        vcl_complex<double> s(0,0);
-        InputIteratorType it(m_CompartmentImages.at(0), m_CompartmentImages.at(0)->GetLargestPossibleRegion() );
-        while( !it.IsAtEnd() )
+    // sample locations in acquisition order
+    vector< double > sampleTime(numSamples);
+    vector< double > sampleKx(numSamples);
+    vector< double > sampleEddyDecay(numSamples, 0);
+    vector< unsigned int > sampleColumn(numSamples);   // integer part of kx (modulo xMax), the line offset is applied to the image
+    vector< ComplexType > sampleShift(numSamples);     // phase of the centered x coordinate
+    vector< double > rowKy(kyMax);
+    double tMin = 0;
+    double tMax = 0;
+    double maxEddyDecayRate = 0;
+    for (unsigned int row=0; row<kyMax; row++)
+    {
+        double lineOffset = row%2 == 1 ? -m_Parameters.m_KspaceLineOffset : m_Parameters.m_KspaceLineOffset;
+        for (unsigned int column=0; column<kxMax; column++)
         {
-            double x = it.GetIndex()[0]-xMax/2;
-            double y = it.GetIndex()[1]-yMax/2;
+            itk::Index< 2 > acquisitionIdx; acquisitionIdx[0] = column; acquisitionIdx[1] = row;
+            itk::Index< 2 > kIdx;
+            double kx, ky, t;
+            GetKspaceSample(acquisitionIdx, kIdx, kx, ky, t);
+
+            unsigned int n = row*kxMax+column;
+            long m = (long)floor(kx-lineOffset+0.5) % (long)xMax;
+            sampleTime[n] = t;
+            sampleKx[n] = kx;
+            sampleColumn[n] = m<0 ? m+xMax : m;
+            sampleShift[n] = exp( ComplexType(0, -M_PI*kx) );  // x = xIdx-xMax/2
+            rowKy[row] = ky;
+
+            if (simulateEddy)
+            {
+                sampleEddyDecay[n] = exp(-(m_Parameters.m_tEcho/2 + t)/m_Parameters.m_Tau) * t/1000;
+                maxEddyDecayRate = std::max(maxEddyDecayRate, fabs(exp(-(m_Parameters.m_tEcho/2 + t)/m_Parameters.m_Tau) * (1-t/m_Parameters.m_Tau)/1000));
+            }
 
-            vcl_complex<double> f(0, 0);
+            if (n==0 || t<tMin)
+                tMin = t;
+            if (n==0 || t>tMax)
+                tMax = t;
+        }
+    }
 
-            // sum compartment signals and simulate relaxation
-            for (unsigned int i=0; i<m_CompartmentImages.size(); i++)
-                if (m_Parameters.m_DoSimulateRelaxation)
-                    f += std::complex<double>( m_CompartmentImages.at(i)->GetPixel(it.GetIndex()) * relaxFactor.at(i) * m_Parameters.m_SignalScale, 0);
-                else
-                    f += std::complex<double>( m_CompartmentImages.at(i)->GetPixel(it.GetIndex()) * m_Parameters.m_SignalScale );
+    // spatially varying, time dependent phase that is handled by time segmentation
+    double maxPhaseRate = 0;    // in cycles per ms
+    vector< double > eddyPhase;
+    if (simulateEddy && !nonUniform)
+    {
+        eddyPhase.resize(xMax*yMax);
+        double maxEddyPhase = 0;
+        for (unsigned int y=0; y<yMax; y++)
+            for (unsigned int x=0; x<xMax; x++)
+            {
+                eddyPhase[y*xMax+x] = eddyX*(x-xMax/2.0) + eddyY*(y-yMax/2.0) + eddyZ;
+                maxEddyPhase = std::max(maxEddyPhase, fabs(eddyPhase[y*xMax+x]));
+            }
+        maxPhaseRate += maxEddyPhase*maxEddyDecayRate;
+    }
+    vector< double > frequencyMap;
+    if (m_FrequencyMapSlice.IsNotNull())
+    {
+        frequencyMap.resize(xMax*yMax);
+        double maxFrequency = 0;
+        for (unsigned int y=0; y<yMax; y++)
+            for (unsigned int x=0; x<xMax; x++)
+            {
+                itk::Index< 2 > idx; idx[0] = x; idx[1] = y;
+                frequencyMap[y*xMax+x] = m_FrequencyMapSlice->GetPixel(idx);
+                maxFrequency = std::max(maxFrequency, fabs(frequencyMap[y*xMax+x]));
+            }
+        maxPhaseRate += maxFrequency/1000;
+    }
+
+    unsigned int numSegments = 1;
+    if (!eddyPhase.empty() || !frequencyMap.empty())
+        numSegments = std::max(2.0, ceil(maxPhaseRate*(tMax-tMin)/maxPhaseStep)+1);
+    double segmentLength = numSegments>1 ? (tMax-tMin)/(numSegments-1) : 0;
+
+    // the non-uniform FFT applies the line offset to the sampled location, the FFT as phase modulation of the image
+    unsigned int numParities = m_Parameters.m_KspaceLineOffset!=0 && !nonUniform ? 2 : 1;
+
+    // each FFT costs about log2(xMax*yMax) operations per pixel, the DFT numSamples operations
+    if (numParities*numSegments*log((double)xMax*yMax)/log(2.0) > numSamples)
+        return false;
 
-            // simulate eddy currents and other distortions
-            double omega_t = 0;
-            if ( m_Parameters.m_EddyStrength>0 && !m_IsBaseline)
+    vector< ComplexType > rowPhase;
+    if (!fftRows)
+    {
+        rowPhase.resize(kyMax*yMax);
+        for (unsigned int row=0; row<kyMax; row++)
+            for (unsigned int y=0; y<yMax; y++)
             {
-                itk::Vector< double, 3 > pos; pos[0] = x; pos[1] = y; pos[2] = m_Z;
-                pos = m_Transform*pos/1000;   // vector from image center to current position (in meter)
-                omega_t += (m_DiffusionGradientDirection[0]*pos[0]+m_DiffusionGradientDirection[1]*pos[1]+m_DiffusionGradientDirection[2]*pos[2])*eddyDecay;
+                double yPos = y-yMax/2.0;
+                if (yPos<-yMaxFov/2)
+                    yPos += yMaxFov;
+                else if (yPos>=yMaxFov/2)
+                    yPos -= yMaxFov;
+                rowPhase[row*yMax+y] = exp( ComplexType(0, 2 * M_PI * rowKy[row]*yPos/yMaxFov) );
             }
-            if (m_FrequencyMapSlice.IsNotNull()) // simulate distortions
-                omega_t += m_FrequencyMapSlice->GetPixel(it.GetIndex())*t/1000;
+    }
+
+    ComplexFft fftX(xMax, 1);
+    ComplexFft fftY(yMax, 1);
+    NonUniformFft2D* nufft = nonUniform ? new NonUniformFft2D(xMax, yMax, 1) : NULL;
+    vector< ComplexType > kspace(numSamples, ComplexType(0,0));
+    vector< ComplexType > image(xMax*yMax);
+    vector< ComplexType > rows(kyMax*xMax);
+    vector< ComplexType > temp(std::max(xMax, yMax));
+
+    for (unsigned int i=0; i<numCompartments; i++)
+    {
+        vector< double > relaxFactor(numSamples, 1);
+        if (m_Parameters.m_DoSimulateRelaxation)
+            for (unsigned int n=0; n<numSamples; n++)
+                relaxFactor[n] = exp(-(m_Parameters.m_tEcho+sampleTime[n])/m_T2.at(i) -fabs(sampleTime[n])/m_Parameters.m_tInhom);
 
-            if (y<-yMaxFov/2)
-                y += yMaxFov;
-            else if (y>=yMaxFov/2)
-                y -= yMaxFov;
+        for (unsigned int parity=0; parity<numParities; parity++)
+        {
+            double lineOffset = parity == 1 ? -m_Parameters.m_KspaceLineOffset : m_Parameters.m_KspaceLineOffset;
+            if (nonUniform)
+                lineOffset = 0;
 
-            // actual DFT term
-            s += f * exp( std::complex<double>(0, 2 * M_PI * (kx*x/xMax + ky*y/yMaxFov + omega_t )) );
+            for (unsigned int segment=0; segment<numSegments; segment++)
+            {
+                double segmentTime = numSegments>1 ? tMin+segment*segmentLength : 0;
+                double eddyDecay = eddyPhase.empty() ? 0 : exp(-(m_Parameters.m_tEcho/2 + segmentTime)/m_Parameters.m_Tau) * segmentTime/1000;
+
+                for (unsigned int y=0; y<yMax; y++)
+                    for (unsigned int x=0; x<xMax; x++)
+                    {
+                        itk::Index< 2 > idx; idx[0] = x; idx[1] = y;
+                        double phase = lineOffset*x/xMax;
+                        if (!eddyPhase.empty())
+                            phase += eddyPhase[y*xMax+x]*eddyDecay;
+                        if (!frequencyMap.empty())
+                            phase += frequencyMap[y*xMax+x]*segmentTime/1000;
+                        image[y*xMax+x] = m_CompartmentImages.at(i)->GetPixel(idx) * m_Parameters.m_SignalScale * exp( ComplexType(0, 2 * M_PI * phase) );
+                    }
+
+                if (nonUniform)
+                {
+                    nufft->SetImage(image);
+                }
+                else
+                {
+                    // readout direction
+                    for (unsigned int y=0; y<yMax; y++)
+                    {
+                        fftX.Transform(&image[y*xMax], &temp[0]);
+                        std::copy(temp.begin(), temp.begin()+xMax, image.begin()+y*xMax);
+                    }
+
+                    // phase encoding direction, only the acquired rows
+                    for (unsigned int x=0; x<xMax; x++)
+                    {
+                        if (fftRows)
+                        {
+                            fftY.Transform(&image[x], &temp[0], xMax);
+                            for (unsigned int row=0; row<kyMax; row++)
+                            {
+                                long ky = (long)floor(rowKy[row]+0.5) % (long)yMax;
+                                rows[row*xMax+x] = temp[ky<0 ? ky+yMax : ky] * exp( ComplexType(0, -M_PI*rowKy[row]) );  // y = yIdx-yMax/2
+                            }
+                        }
+                        else
+                        {
+                            for (unsigned int row=0; row<kyMax; row++)
+                            {
+                                ComplexType s(0,0);
+                                for (unsigned int y=0; y<yMax; y++)
+                                    s += image[y*xMax+x]*rowPhase[row*yMax+y];
+                                rows[row*xMax+x] = s;
+                            }
+                        }
+                    }
+                }
+
+                // accumulate the samples of this parity, linearly interpolated between the segments
+                for (unsigned int row=parity; row<kyMax; row+=numParities)
+                    for (unsigned int column=0; column<kxMax; column++)
+                    {
+                        unsigned int n = row*kxMax+column;
+                        double weight = relaxFactor[n];
+                        if (numSegments>1)
+                        {
+                            weight *= 1-fabs(sampleTime[n]-segmentTime)/segmentLength;
+                            if (weight<=0)
+                                continue;
+                        }
+
+                        if (nonUniform)
+                        {
+                            double decay = sampleEddyDecay[n];
+                            kspace[n] += weight * nufft->Evaluate(sampleKx[n]+eddyX*decay*xMax, rowKy[row]+eddyY*decay*yMax)
+                                    * exp( ComplexType(0, 2 * M_PI * eddyZ*decay) );
+                        }
+                        else
+                            kspace[n] += weight * rows[row*xMax+sampleColumn[n]] * sampleShift[n];
+                    }
+            }
+        }
+    }
+    delete nufft;
 
-            ++it;
+    for (unsigned int n=0; n<numSamples; n++)
+        kspace[n] /= numSamples;
+    m_FftKspace.swap(kspace);
+    return true;
+}
+
+template< class TPixelType >
+void KspaceImageFilter< TPixelType >
+::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread, ThreadIdType)
+{
+    typename OutputImageType::Pointer outputImage = static_cast< OutputImageType * >(this->ProcessObject::GetOutput(0));
+
+    ImageRegionIterator< OutputImageType > oit(outputImage, outputRegionForThread);
+
+    typedef ImageRegionConstIterator< InputImageType > InputIteratorType;
+
+    double kxMax = outputImage->GetLargestPossibleRegion().GetSize(0);  // k-space size in x-direction
+    double kyMax = outputImage->GetLargestPossibleRegion().GetSize(1);  // k-space size in y-direction
+    double xMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(0); // scanner coverage in x-direction
+    double yMax = m_CompartmentImages.at(0)->GetLargestPossibleRegion().GetSize(1); // scanner coverage in y-direction
+
+    double numPix = kxMax*kyMax;
+
+    double upsampling = xMax/kxMax;     //  discrepany between k-space resolution and image resolution
+    double yMaxFov = kyMax*upsampling;  //  actual FOV in y-direction (in x-direction xMax==FOV)
+
+    while( !oit.IsAtEnd() )
+    {
+        itk::Index< 2 > kIdx;
+        double kx, ky, t;
+        GetKspaceSample(oit.GetIndex(), kIdx, kx, ky, t);
+
+        vcl_complex<double> s(0,0);
+        if (!m_FftKspace.empty())
+        {
+            s = m_FftKspace.at(oit.GetIndex()[1]*m_OutSize[0]+oit.GetIndex()[0]);
+        }
+        else
+        {
+            // calculate eddy current decay factors
+            double eddyDecay = 0;
+            if (m_Parameters.m_EddyStrength>0)
+                eddyDecay = exp(-(m_Parameters.m_tEcho/2 + t)/m_Parameters.m_Tau) * t/1000;
+
+            // calcualte signal relaxation factors
+            std::vector< double > relaxFactor;
+            if (m_Parameters.m_DoSimulateRelaxation)
+                for (unsigned int i=0; i<m_CompartmentImages.size(); i++)
+                    relaxFactor.push_back(exp(-(m_Parameters.m_tEcho+t)/m_T2.at(i) -fabs(t)/m_Parameters.m_tInhom));
+
+            InputIteratorType it(m_CompartmentImages.at(0), m_CompartmentImages.at(0)->GetLargestPossibleRegion() );
+            while( !it.IsAtEnd() )
+            {
+                double x = it.GetIndex()[0]-xMax/2;
+                double y = it.GetIndex()[1]-yMax/2;
+
+                vcl_complex<double> f(0, 0);
+
+                // sum compartment signals and simulate relaxation
+                for (unsigned int i=0; i<m_CompartmentImages.size(); i++)
+                    if (m_Parameters.m_DoSimulateRelaxation)
+                        f += std::complex<double>( m_CompartmentImages.at(i)->GetPixel(it.GetIndex()) * relaxFactor.at(i) * m_Parameters.m_SignalScale, 0);
+                    else
+                        f += std::complex<double>( m_CompartmentImages.at(i)->GetPixel(it.GetIndex()) * m_Parameters.m_SignalScale );
+
+                // simulate eddy currents and other distortions
+                double omega_t = 0;
+                if ( m_Parameters.m_EddyStrength>0 && !m_IsBaseline)
+                {
+                    itk::Vector< double, 3 > pos; pos[0] = x; pos[1] = y; pos[2] = m_Z;
+                    pos = m_Transform*pos/1000;   // vector from image center to current position (in meter)
+                    omega_t += (m_DiffusionGradientDirection[0]*pos[0]+m_DiffusionGradientDirection[1]*pos[1]+m_DiffusionGradientDirection[2]*pos[2])*eddyDecay;
+                }
+                if (m_FrequencyMapSlice.IsNotNull()) // simulate distortions
+                    omega_t += m_FrequencyMapSlice->GetPixel(it.GetIndex())*t/1000;
+
+                if (y<-yMaxFov/2)
+                    y += yMaxFov;
+                else if (y>=yMaxFov/2)
+                    y -= yMaxFov;
+
+                // actual DFT term
+                s += f * exp( std::complex<double>(0, 2 * M_PI * (kx*x/xMax + ky*y/yMaxFov + omega_t )) );
+
+                ++it;
+            }
+            s /= numPix;
         }
-        s /= numPix;
 
         if (m_SpikesPerSlice>0 && sqrt(s.imag()*s.imag()+s.real()*s.real()) > sqrt(m_Spike.imag()*m_Spike.imag()+m_Spike.real()*m_Spike.real()) )
             m_Spike = s;
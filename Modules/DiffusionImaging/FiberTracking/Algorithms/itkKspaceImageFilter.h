@@ -42,7 +42,11 @@ namespace itk{
 * - Image distortions (off-frequency effects)
 * - Gibbs ringing
 * - Eddy current effects
-* Based on a discrete fourier transformation.
+* Based on a discrete fourier transformation. If FiberfoxParameters::m_DoUseFft is set, the k-space is computed with separable FFTs:
+* relaxation only depends on the acquisition time and is applied exactly per compartment, and the N/2 ghost offset is applied as a
+* phase modulation of the image. Eddy currents shift the sampled k-space location, which is evaluated with a non-uniform FFT.
+* The time dependent phase of distortions is approximated by interpolating between FFTs at a few time points (time segmentation).
+* If this needs more FFTs than the direct DFT needs operations, the DFT is used.
 * See "Fiberfox: Facilitating the creation of realistic white matter software phantoms" (DOI: 10.1002/mrm.25045) for details.
 */
 
@@ -77,6 +81,7 @@ namespace itk{
     itkSetMacro( Z, double )                        ///< Slice position, necessary for eddy current simulation.
     itkSetMacro( OutSize, itk::Size<2> )            ///< Output slice size. Can be different from input size, e.g. if Gibbs ringing is enabled.
     itkSetMacro( UseConstantRandSeed, bool )        ///< Use constant seed for random generator for reproducible results.
+    itkSetMacro( RandSeed, int )                    ///< Seed for random generator. Ignored if negative (default).
 
     void SetParameters( FiberfoxParameters<double> param ){ m_Parameters = param; }
     FiberfoxParameters<double> GetParameters(){ return m_Parameters; }
@@ -93,6 +98,12 @@ namespace itk{
     void ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread, ThreadIdType);
     void AfterThreadedGenerateData();
 
+    /** Output location, k-space coordinates and dephasing time of the sample acquired at acquisitionIdx. */
+    void GetKspaceSample(const itk::Index<2>& acquisitionIdx, itk::Index<2>& kIdx, double& kx, double& ky, double& t) const;
+
+    /** Computes all k-space samples with FFTs (see class description). Returns false if the direct DFT is cheaper. */
+    bool ComputeKspaceFft();
+
     FiberfoxParameters<double>              m_Parameters;
     typename InputImageType::Pointer        m_FrequencyMapSlice;
     vector< double >                        m_T2;
@@ -100,6 +111,7 @@ namespace itk{
     itk::Vector<double,3>                   m_DiffusionGradientDirection;
     double                                  m_Z;
     bool                                    m_UseConstantRandSeed;
+    int                                     m_RandSeed;
     unsigned int                            m_SpikesPerSlice;
     itk::Size<2>                            m_OutSize;
 
@@ -107,6 +119,7 @@ namespace itk{
     vcl_complex<double>                     m_Spike;
     MatrixType                              m_Transform;
     itk::Statistics::MersenneTwisterRandomVariateGenerator::Pointer m_RandGen;
+    vector< vcl_complex<double> >           m_FftKspace;    ///< k-space samples in acquisition order, empty if the direct DFT is used
 
   private:
 
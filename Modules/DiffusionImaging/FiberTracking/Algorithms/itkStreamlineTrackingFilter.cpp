@@ -31,13 +31,40 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 namespace itk {
 
+/** Tracks the seed voxels handed out by the mitk::ParallelFiberProcessor. */
+template< class TTensorPixelType, class TPDPixelType>
+class StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>::TrackingKernel : public mitk::FiberKernel
+{
+public:
+
+    TrackingKernel(StreamlineTrackingFilter* filter) : m_Filter(filter) {}
+
+    void Initialize(unsigned int numberOfThreads)
+    {
+        m_ThreadData.resize(numberOfThreads);
+        for (unsigned int i=0; i<numberOfThreads; i++)
+        {
+            m_ThreadData[i].m_Cache.m_Tensors.resize(8*m_Filter->m_NumberOfInputs);
+            m_ThreadData[i].m_Cache.m_Directions.resize(8*m_Filter->m_NumberOfInputs);
+        }
+    }
+
+    void ProcessFiber(unsigned int seed, unsigned int threadId, mitk::FiberBuffer& output)
+    {
+        m_Filter->TrackSeed(seed, m_ThreadData[threadId], output);
+    }
+
+private:
+
+    StreamlineTrackingFilter*           m_Filter;
+    std::vector< TrackingThreadData >   m_ThreadData;
+};
+
 template< class TTensorPixelType, class TPDPixelType>
 StreamlineTrackingFilter< TTensorPixelType,
 TPDPixelType>
 ::StreamlineTrackingFilter()
     : m_FiberPolyData(NULL)
-    , m_Points(NULL)
-    , m_Cells(NULL)
     , m_FaImage(NULL)
     , m_NumberOfInputs(1)
     , m_FaThreshold(0.2)
@@ -75,8 +102,9 @@ TPDPixelType>
 ::BeforeThreadedGenerateData()
 {
     m_FiberPolyData = FiberPolyDataType::New();
-    m_Points = vtkSmartPointer< vtkPoints >::New();
-    m_Cells = vtkSmartPointer< vtkCellArray >::New();
+    m_PdImage.clear();
+    m_EmaxImage.clear();
+    m_InputImage.clear();
 
     InputImageType* inputImage = static_cast< InputImageType * >( this->ProcessObject::GetInput(0) );
     m_ImageSize.resize(3);
@@ -105,12 +133,7 @@ TPDPixelType>
     if (m_ResampleFibers)
         m_PointPistance = 0.5*minSpacing;
 
-    m_PolyDataContainer = itk::VectorContainer< int, FiberPolyDataType >::New();
-    for (unsigned int i=0; i<this->GetNumberOfThreads(); i++)
-    {
-        FiberPolyDataType poly = FiberPolyDataType::New();
-        m_PolyDataContainer->InsertElement(i, poly);
-    }
+    m_InverseDirection = inputImage->GetDirection().GetTranspose();
 
     if (m_SeedImage.IsNull())
     {
@@ -148,6 +171,8 @@ TPDPixelType>
         m_FaImage->FillBuffer(0.0);
         useUserFaImage = false;
     }
+    else if (m_FaImage->GetBufferedRegion()!=inputImage->GetLargestPossibleRegion())
+        itkExceptionMacro("FA image does not match the tensor image");
 
     m_NumberOfInputs = 0;
     for (unsigned int i=0; i<this->GetNumberOfIndexedInputs(); i++)
@@ -226,15 +251,53 @@ TPDPixelType>
     std::cout << "StreamlineTrackingFilter: stepsize: " << m_StepSize << " mm" << std::endl;
     std::cout << "StreamlineTrackingFilter: f: " << m_F << std::endl;
     std::cout << "StreamlineTrackingFilter: g: " << m_G << std::endl;
+
+    // all images share the buffer layout of the input, the corners of an interpolation cell have the same offsets in each of them
+    const typename ItkFloatImgType::OffsetValueType* offsetTable = m_FaImage->GetOffsetTable();
+    m_CornerOffsets[0] = 0;
+    m_CornerOffsets[1] = offsetTable[0];
+    m_CornerOffsets[2] = offsetTable[1];
+    m_CornerOffsets[3] = offsetTable[2];
+    m_CornerOffsets[4] = offsetTable[0] + offsetTable[1];
+    m_CornerOffsets[5] = offsetTable[1] + offsetTable[2];
+    m_CornerOffsets[6] = offsetTable[2] + offsetTable[0];
+    m_CornerOffsets[7] = offsetTable[0] + offsetTable[1] + offsetTable[2];
+
+    m_SeedVoxels.clear();
+    ImageRegionConstIteratorWithIndex< ItkUcharImgType > sit(m_SeedImage, inputImage->GetLargestPossibleRegion());
+    ImageRegionConstIterator< ItkFloatImgType > fit(m_FaImage, inputImage->GetLargestPossibleRegion());
+    ImageRegionConstIterator< ItkUcharImgType > mit(m_MaskImage, inputImage->GetLargestPossibleRegion());
+    for (; !sit.IsAtEnd(); ++sit, ++fit, ++mit)
+        if (sit.Value()!=0 && fit.Value()>=m_FaThreshold && mit.Value()!=0)
+            m_SeedVoxels.push_back(sit.GetIndex());
+
+    std::cout << "StreamlineTrackingFilter: seed voxels: " << m_SeedVoxels.size() << std::endl;
     std::cout << "StreamlineTrackingFilter: starting streamline tracking using " << this->GetNumberOfThreads() << " threads." << std::endl;
 }
 
+template< class TTensorPixelType, class TPDPixelType>
+void StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
+::GenerateData()
+{
+    this->AllocateOutputs();
+    this->BeforeThreadedGenerateData();
+
+    // the seed voxels of all input images are distributed in chunks over the threads instead of splitting the
+    // image into one region per thread, so the threads stay busy if the seeds are concentrated in a small part of the image
+    TrackingKernel kernel(this);
+    mitk::ParallelFiberProcessor processor;
+    processor.SetNumberOfThreads(this->GetNumberOfThreads());
+    processor.Process(m_SeedVoxels.size()*m_NumberOfInputs, kernel);
+    m_FiberPolyData = processor.GetOutput();
+
+    this->AfterThreadedGenerateData();
+}
+
 template< class TTensorPixelType, class TPDPixelType>
 void StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
 ::CalculateNewPosition(itk::ContinuousIndex<double, 3>& pos, vnl_vector_fixed<double,3>& dir, typename InputImageType::IndexType& index)
 {
-    vnl_matrix_fixed< double, 3, 3 > rot = m_InputImage.at(0)->GetDirection().GetTranspose();
-    dir = rot*dir;
+    dir = m_InverseDirection*dir;
     if (true)
     {
         dir *= m_StepSize;
@@ -388,7 +451,7 @@ void StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
 
 template< class TTensorPixelType, class TPDPixelType>
 bool StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
-::IsValidPosition(itk::ContinuousIndex<double, 3>& pos, typename InputImageType::IndexType &index, vnl_vector_fixed< double, 8 >& interpWeights, int imageIdx)
+::IsValidPosition(itk::ContinuousIndex<double, 3>& pos, typename InputImageType::IndexType &index, vnl_vector_fixed< double, 8 >& interpWeights, int imageIdx, InterpolationCache& cache)
 {
     if (!m_InputImage.at(imageIdx)->GetLargestPossibleRegion().IsInside(index) || m_MaskImage->GetPixel(index)==0)
         return false;
@@ -436,22 +499,10 @@ bool StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
         interpWeights[6] = (1-frac_x)*(  frac_y)*(1-frac_z);
         interpWeights[7] = (1-frac_x)*(1-frac_y)*(1-frac_z);
 
-        typename InputImageType::IndexType tmpIdx;
-        double FA = m_FaImage->GetPixel(index) * interpWeights[0];
-        tmpIdx = index; tmpIdx[0]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[1];
-        tmpIdx = index; tmpIdx[1]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[2];
-        tmpIdx = index; tmpIdx[2]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[3];
-        tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[4];
-        tmpIdx = index; tmpIdx[1]++; tmpIdx[2]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[5];
-        tmpIdx = index; tmpIdx[2]++; tmpIdx[0]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[6];
-        tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-        FA +=  m_FaImage->GetPixel(tmpIdx) * interpWeights[7];
+        UpdateInterpolationCache(index, cache);
+        double FA = cache.m_Fa[0] * interpWeights[0];
+        for (int c=1; c<8; c++)
+            FA += cache.m_Fa[c] * interpWeights[c];
 
         if (FA<m_FaThreshold)
             return false;
@@ -462,9 +513,34 @@ bool StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
     return true;
 }
 
+template< class TTensorPixelType, class TPDPixelType>
+void StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
+::UpdateInterpolationCache(const typename InputImageType::IndexType& index, InterpolationCache& cache)
+{
+    OffsetValueType offset = m_FaImage->ComputeOffset(index);
+    if (offset==cache.m_Offset)
+        return;
+    cache.m_Offset = offset;
+
+    const float* fa = m_FaImage->GetBufferPointer() + offset;
+    for (int c=0; c<8; c++)
+        cache.m_Fa[c] = fa[m_CornerOffsets[c]];
+
+    for (int img=0; img<m_NumberOfInputs; img++)
+    {
+        const TensorType* tensors = m_InputImage.at(img)->GetBufferPointer() + offset;
+        const vnl_vector_fixed<double,3>* directions = m_PdImage.at(img)->GetBufferPointer() + offset;
+        for (int c=0; c<8; c++)
+        {
+            cache.m_Tensors[c*m_NumberOfInputs+img] = tensors[m_CornerOffsets[c]];
+            cache.m_Directions[c*m_NumberOfInputs+img] = directions[m_CornerOffsets[c]];
+        }
+    }
+}
+
 template< class TTensorPixelType, class TPDPixelType>
 double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
-::FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, vtkPoints* points, std::vector< vtkIdType >& ids, int imageIdx)
+::FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, std::vector< double >& points, int imageIdx, InterpolationCache& cache)
 {
     double tractLength = 0;
     typedef itk::DiffusionTensor3D<TTensorPixelType>    TensorType;
@@ -498,16 +574,16 @@ double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
         distanceInVoxel += m_StepSize;
 
         // is new position valid (inside image, above FA threshold etc.)
-        if (!IsValidPosition(pos, index, interpWeights, imageIdx))   // if not add last point and end streamline
+        if (!IsValidPosition(pos, index, interpWeights, imageIdx, cache))   // if not add last point and end streamline
         {
             m_SeedImage->TransformContinuousIndexToPhysicalPoint( pos, worldPos );
-            ids.push_back(points->InsertNextPoint(worldPos.GetDataPointer()));
+            points.insert(points.end(), worldPos.GetDataPointer(), worldPos.GetDataPointer()+3);
             return tractLength;
         }
         else if (distance>=m_PointPistance)
         {
             m_SeedImage->TransformContinuousIndexToPhysicalPoint( pos, worldPos );
-            ids.push_back(points->InsertNextPoint(worldPos.GetDataPointer()));
+            points.insert(points.end(), worldPos.GetDataPointer(), worldPos.GetDataPointer()+3);
             distance = 0;
         }
 
@@ -563,133 +639,35 @@ double StreamlineTrackingFilter< TTensorPixelType, TPDPixelType>
         }
         else // use trilinear interpolation (weights calculated in IsValidPosition())
         {
-            typename InputImageType::PixelType tensor;
-
-            typename InputImageType::IndexType tmpIdx = index;
-            typename InputImageType::PixelType tmpTensor;
+            TensorType tensor;
 
             if (m_NumberOfInputs>1)
             {
-                double minAngle = 0;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor = tmpTensor * interpWeights[0];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[0]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[1];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[1]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[2];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[2]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[3];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
+                // use the tensor of each corner that is best aligned with the current direction
+                TensorType tmpTensor;
+                for (int c=0; c<8; c++)
                 {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
+                    double minAngle = 0;
+                    for (int img=0; img<m_NumberOfInputs; img++)
                     {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
+                        double angle = dot_product(dirOld, cache.m_Directions[c*m_NumberOfInputs+img]);
+                        if (fabs(angle)>minAngle)
+                        {
+                            minAngle = angle;
+                            tmpTensor = cache.m_Tensors[c*m_NumberOfInputs+img];
+                        }
                     }
+                    if (c==0)
+                        tensor = tmpTensor * interpWeights[0];
+                    else
+                        tensor += tmpTensor * interpWeights[c];
                 }
-                tensor += tmpTensor * interpWeights[4];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[1]++; tmpIdx[2]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[5];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[2]++; tmpIdx[0]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[6];
-
-                minAngle = 0;
-                tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-                for (int img=0; img<m_NumberOfInputs; img++)
-                {
-                    double angle = dot_product(dirOld, m_PdImage.at(img)->GetPixel(tmpIdx));
-                    if (fabs(angle)>minAngle)
-                    {
-                        minAngle = angle;
-                        tmpTensor = m_InputImage.at(img)->GetPixel(tmpIdx);
-                    }
-                }
-                tensor += tmpTensor * interpWeights[7];
             }
             else
             {
-                tensor = m_InputImage.at(0)->GetPixel(index) * interpWeights[0];
-                typename InputImageType::IndexType tmpIdx = index; tmpIdx[0]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[1];
-                tmpIdx = index; tmpIdx[1]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[2];
-                tmpIdx = index; tmpIdx[2]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[3];
-                tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[4];
-                tmpIdx = index; tmpIdx[1]++; tmpIdx[2]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[5];
-                tmpIdx = index; tmpIdx[2]++; tmpIdx[0]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[6];
-                tmpIdx = index; tmpIdx[0]++; tmpIdx[1]++; tmpIdx[2]++;
-                tensor +=  m_InputImage.at(0)->GetPixel(tmpIdx) * interpWeights[7];
+                tensor = cache.m_Tensors[0] * interpWeights[0];
+                for (int c=1; c<8; c++)
+                    tensor += cache.m_Tensors[c] * interpWeights[c];
             }
 
             tensor.ComputeEigenAnalysis(eigenvalues, eigenvectors);
@@ -733,149 +711,59 @@ template< class TTensorPixelType,
           class TPDPixelType>
 void StreamlineTrackingFilter< TTensorPixelType,
 TPDPixelType>
-::ThreadedGenerateData(const OutputImageRegionType& outputRegionForThread,
-                       ThreadIdType threadId)
+::TrackSeed(unsigned int seed, TrackingThreadData& data, mitk::FiberBuffer& output)
 {
-    FiberPolyDataType poly = m_PolyDataContainer->GetElement(threadId);
-    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> Cells = vtkSmartPointer<vtkCellArray>::New();
-
-    typedef itk::DiffusionTensor3D<TTensorPixelType>        TensorType;
-    typedef ImageRegionConstIterator< InputImageType >      InputIteratorType;
-    typedef ImageRegionConstIterator< ItkUcharImgType >     MaskIteratorType;
-    typedef ImageRegionConstIterator< ItkFloatImgType >     doubleIteratorType;
-    typedef typename InputImageType::PixelType              InputTensorType;
+    int img = seed/m_SeedVoxels.size();
+    const typename InputImageType::IndexType& index = m_SeedVoxels.at(seed%m_SeedVoxels.size());
+    itk::Point<double> worldPos;
 
-    MaskIteratorType    sit(m_SeedImage, outputRegionForThread );
-    doubleIteratorType   fit(m_FaImage, outputRegionForThread );
-    MaskIteratorType    mit(m_MaskImage, outputRegionForThread );
+    // the seeds inside of a voxel do not depend on the thread that tracks the voxel
+    if (m_SeedsPerVoxel>1)
+        data.m_RandGen.reseed(seed);
 
-    for (int img=0; img<m_NumberOfInputs; img++)
+    for (int s=0; s<m_SeedsPerVoxel; s++)
     {
-        sit.GoToBegin();
-        mit.GoToBegin();
-        fit.GoToBegin();
-        itk::Point<double> worldPos;
-        while( !sit.IsAtEnd() )
+        itk::ContinuousIndex<double, 3> start;
+        if (m_SeedsPerVoxel>1)
         {
-            if (sit.Value()==0 || fit.Value()<m_FaThreshold || mit.Value()==0)
-            {
-                ++sit;
-                ++mit;
-                ++fit;
-                continue;
-            }
-
-            for (int s=0; s<m_SeedsPerVoxel; s++)
-            {
-                vtkSmartPointer<vtkPolyLine> line = vtkSmartPointer<vtkPolyLine>::New();
-                std::vector< vtkIdType > pointIDs;
-                typename InputImageType::IndexType index = sit.GetIndex();
-                itk::ContinuousIndex<double, 3> start;
-                unsigned int counter = 0;
-
-                if (m_SeedsPerVoxel>1)
-                {
-                    start[0] = index[0]+(double)(rand()%99-49)/100;
-                    start[1] = index[1]+(double)(rand()%99-49)/100;
-                    start[2] = index[2]+(double)(rand()%99-49)/100;
-                }
-                else
-                {
-                    start[0] = index[0];
-                    start[1] = index[1];
-                    start[2] = index[2];
-                }
-
-                // forward tracking
-                double tractLength = FollowStreamline(start, 1, points, pointIDs, img);
-
-                // add ids to line
-                counter += pointIDs.size();
-                while (!pointIDs.empty())
-                {
-                    line->GetPointIds()->InsertNextId(pointIDs.back());
-                    pointIDs.pop_back();
-                }
-
-                // insert start point
-                m_SeedImage->TransformContinuousIndexToPhysicalPoint( start, worldPos );
-                line->GetPointIds()->InsertNextId(points->InsertNextPoint(worldPos.GetDataPointer()));
-
-                // backward tracking
-                tractLength += FollowStreamline(start, -1, points, pointIDs, img);
-
-                counter += pointIDs.size();
-
-                //MITK_INFO << "Tract length " << tractLength;
-
-                if (tractLength<m_MinTractLength || counter<2)
-                    continue;
-
-                // add ids to line
-                for (unsigned int i=0; i<pointIDs.size(); i++)
-                    line->GetPointIds()->InsertNextId(pointIDs.at(i));
-
-                Cells->InsertNextCell(line);
-            }
-            ++sit;
-            ++mit;
-            ++fit;
+            start[0] = index[0]+(double)data.m_RandGen.lrand32(-49, 49)/100;
+            start[1] = index[1]+(double)data.m_RandGen.lrand32(-49, 49)/100;
+            start[2] = index[2]+(double)data.m_RandGen.lrand32(-49, 49)/100;
         }
-    }
-    poly->SetPoints(points);
-    poly->SetLines(Cells);
-
-    std::cout << "Thread " << threadId << " finished tracking" << std::endl;
-}
-
-template< class TTensorPixelType,
-          class TPDPixelType>
-vtkSmartPointer< vtkPolyData > StreamlineTrackingFilter< TTensorPixelType,
-TPDPixelType>
-::AddPolyData(FiberPolyDataType poly1, FiberPolyDataType poly2)
-{
-    vtkSmartPointer<vtkPolyData> vNewPolyData = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkCellArray> vNewLines = poly1->GetLines();
-    vtkSmartPointer<vtkPoints> vNewPoints = poly1->GetPoints();
-
-    for( int i=0; i<poly2->GetNumberOfLines(); i++ )
-    {
-        vtkCell* cell = poly2->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints; j++)
+        else
         {
-            double p[3];
-            points->GetPoint(j, p);
-
-            vtkIdType id = vNewPoints->InsertNextPoint(p);
-            container->GetPointIds()->InsertNextId(id);
+            start[0] = index[0];
+            start[1] = index[1];
+            start[2] = index[2];
         }
-        vNewLines->InsertNextCell(container);
-    }
-
-    // initialize polydata
-    vNewPolyData->SetPoints(vNewPoints);
-    vNewPolyData->SetLines(vNewLines);
 
-    return vNewPolyData;
+        data.m_Forward.clear();
+        data.m_Backward.clear();
+        double tractLength = FollowStreamline(start, 1, data.m_Forward, img, data.m_Cache);
+        tractLength += FollowStreamline(start, -1, data.m_Backward, img, data.m_Cache);
+
+        if (tractLength<m_MinTractLength || data.m_Forward.size()+data.m_Backward.size()<2*3)
+            continue;
+
+        // forward part in reverse order, start point, backward part
+        for (int i=(int)data.m_Forward.size()-3; i>=0; i-=3)
+            output.AddPoint(&data.m_Forward[i]);
+        m_SeedImage->TransformContinuousIndexToPhysicalPoint( start, worldPos );
+        output.AddPoint(worldPos.GetDataPointer());
+        for (unsigned int i=0; i<data.m_Backward.size(); i+=3)
+            output.AddPoint(&data.m_Backward[i]);
+        output.EndFiber();
+    }
 }
+
 template< class TTensorPixelType,
           class TPDPixelType>
 void StreamlineTrackingFilter< TTensorPixelType,
 TPDPixelType>
 ::AfterThreadedGenerateData()
 {
-    MITK_INFO << "Generating polydata ";
-    m_FiberPolyData = m_PolyDataContainer->GetElement(0);
-    for (unsigned int i=1; i<this->GetNumberOfThreads(); i++)
-    {
-        m_FiberPolyData = AddPolyData(m_FiberPolyData, m_PolyDataContainer->GetElement(i));
-    }
-    MITK_INFO << "done";
+    m_SeedVoxels.clear();
+    MITK_INFO << "Tracked " << m_FiberPolyData->GetNumberOfLines() << " fibers";
 }
 
 template< class TTensorPixelType,
@@ -27,16 +27,19 @@ This file is based heavily on a corresponding ITK filter.
 #include <itkVectorContainer.h>
 #include <itkVectorImage.h>
 #include <itkDiffusionTensor3D.h>
+#include <vnl/vnl_random.h>
+#include <mitkParallelFiberProcessor.h>
 #include <vtkSmartPointer.h>
 #include <vtkPolyData.h>
-#include <vtkCellArray.h>
-#include <vtkPoints.h>
-#include <vtkPolyLine.h>
 
 namespace itk{
 
 /**
-* \brief Performes deterministic streamline tracking on the input tensor image.   */
+* \brief Performes deterministic streamline tracking on the input tensor image.
+*
+* The seed voxels are tracked in chunks by all threads (see mitk::ParallelFiberProcessor), each thread fetches the
+* next chunk when it is done. The fibers are written directly into the point buffers of the chunks and are
+* concatenated in seed order, so the result does not depend on the number of threads.   */
 
   template< class TTensorPixelType, class TPDPixelType=double>
   class StreamlineTrackingFilter :
@@ -90,20 +93,43 @@ namespace itk{
     ~StreamlineTrackingFilter() {}
     void PrintSelf(std::ostream& os, Indent indent) const;
 
+    typedef typename InputImageType::PixelType          TensorType;
+
+    /** Corners of the trilinear interpolation cell a streamline is currently in. The corner voxels are only read
+     *  from the images if the streamline enters a new cell. */
+    struct InterpolationCache
+    {
+        InterpolationCache() : m_Offset(-1) {}
+
+        OffsetValueType                             m_Offset;       ///< Buffer offset of the lower corner of the cached cell, -1 if nothing is cached.
+        float                                       m_Fa[8];
+        std::vector< TensorType >                   m_Tensors;      ///< Eight corners per input image.
+        std::vector< vnl_vector_fixed<double,3> >   m_Directions;   ///< Principal directions of m_Tensors.
+    };
+
+    /** State of one tracking thread. */
+    struct TrackingThreadData
+    {
+        InterpolationCache                                              m_Cache;
+        std::vector< double >                                           m_Forward;      ///< Points of the current streamline in forward direction, x,y,z interleaved.
+        std::vector< double >                                           m_Backward;     ///< Points of the current streamline in backward direction, x,y,z interleaved.
+        vnl_random                                                      m_RandGen;      ///< Places multiple seeds inside of a voxel.
+    };
+
+    class TrackingKernel;
+
     void CalculateNewPosition(itk::ContinuousIndex<double, 3>& pos, vnl_vector_fixed<double,3>& dir, typename InputImageType::IndexType& index);    ///< Calculate next integration step.
-    double FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, vtkPoints* points, std::vector< vtkIdType >& ids, int imageIdx);       ///< Start streamline in one direction.
-    bool IsValidPosition(itk::ContinuousIndex<double, 3>& pos, typename InputImageType::IndexType& index, vnl_vector_fixed< double, 8 >& interpWeights, int imageIdx);   ///< Are we outside of the mask image? Is the FA too low?
+    double FollowStreamline(itk::ContinuousIndex<double, 3> pos, int dirSign, std::vector< double >& points, int imageIdx, InterpolationCache& cache);  ///< Start streamline in one direction.
+    bool IsValidPosition(itk::ContinuousIndex<double, 3>& pos, typename InputImageType::IndexType& index, vnl_vector_fixed< double, 8 >& interpWeights, int imageIdx, InterpolationCache& cache);   ///< Are we outside of the mask image? Is the FA too low?
+    void UpdateInterpolationCache(const typename InputImageType::IndexType& index, InterpolationCache& cache);  ///< Reads the corners of the interpolation cell with the given lower corner, if not cached yet.
+    void TrackSeed(unsigned int seed, TrackingThreadData& data, mitk::FiberBuffer& output);    ///< Tracks all streamlines of the given seed voxel.
 
     double RoundToNearest(double num);
+    void GenerateData();
     void BeforeThreadedGenerateData();
-    void ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread, ThreadIdType threadId);
     void AfterThreadedGenerateData();
 
-    FiberPolyDataType AddPolyData(FiberPolyDataType poly1, FiberPolyDataType poly2);    ///< Combine tracking results generated by the individual threads.
-
     FiberPolyDataType               m_FiberPolyData;
-    vtkSmartPointer<vtkPoints>      m_Points;
-    vtkSmartPointer<vtkCellArray>   m_Cells;
 
     std::vector< ItkDoubleImgType::Pointer >         m_EmaxImage;    ///< Stores largest eigenvalues per voxel (one for each tensor)
     ItkFloatImgType::Pointer                        m_FaImage;      ///< FA image used to determine streamline termination.
@@ -127,7 +153,9 @@ namespace itk{
     ItkUcharImgType::Pointer    m_SeedImage;
     ItkUcharImgType::Pointer    m_MaskImage;
 
-    itk::VectorContainer< int, FiberPolyDataType >::Pointer m_PolyDataContainer;
+    std::vector< typename InputImageType::IndexType >   m_SeedVoxels;           ///< Voxels inside of the seed and tracking mask above the FA threshold.
+    vnl_matrix_fixed< double, 3, 3 >                    m_InverseDirection;     ///< Rotates world directions into the image grid.
+    OffsetValueType                                     m_CornerOffsets[8];     ///< Buffer offsets of the corners of an interpolation cell relative to its lower corner.
 
   private:
 
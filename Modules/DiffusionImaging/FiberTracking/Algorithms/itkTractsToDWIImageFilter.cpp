@@ -43,6 +43,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <itksys/SystemTools.hxx>
 #include <mitkIOUtil.h>
 #include <boost/lexical_cast.hpp>
+#include <mitkAtomicInteger.h>
+#include <itkSimpleFastMutexLock.h>
 
 namespace itk
 {
@@ -64,31 +66,38 @@ TractsToDWIImageFilter< PixelType >::~TractsToDWIImageFilter()
 }
 
 template< class PixelType >
-TractsToDWIImageFilter< PixelType >::DoubleDwiType::Pointer TractsToDWIImageFilter< PixelType >::DoKspaceStuff( std::vector< DoubleDwiType::Pointer >& images )
+struct TractsToDWIImageFilter< PixelType >::KspaceJobs
 {
-    // create slice object
-    ImageRegion<2> sliceRegion;
-    sliceRegion.SetSize(0, m_UpsampledImageRegion.GetSize()[0]);
-    sliceRegion.SetSize(1, m_UpsampledImageRegion.GetSize()[1]);
-    Vector< double, 2 > sliceSpacing;
-    sliceSpacing[0] = m_UpsampledSpacing[0];
-    sliceSpacing[1] = m_UpsampledSpacing[1];
-
-    // frequency map slice
-    SliceType::Pointer fMapSlice = NULL;
-    if (m_Parameters.m_FrequencyMap.IsNotNull())
+    KspaceJobs() : Filter(NULL), Images(NULL), NumSlices(0), NumJobs(0), BaseSeed(-1), FilterThreads(1), Progress(NULL), LastTick(0), Failed(false) {}
+
+    Self*                                   Filter;
+    std::vector< DoubleDwiType::Pointer >*  Images;
+    DoubleDwiType::Pointer                  Output;
+    unsigned int                            NumSlices;
+    long                                    NumJobs;        ///< one job per gradient and slice, job = g*NumSlices+z
+    std::vector< unsigned int >             SpikesPerJob;
+    int                                     BaseSeed;       ///< negative: constant or random seed as set in the filter
+    unsigned int                            FilterThreads;  ///< threads of the k-space and DFT filter of each job
+    mitk::AtomicInteger                     NextJob;
+    boost::progress_display*                Progress;
+    unsigned long                           LastTick;
+    itk::SimpleFastMutexLock                Mutex;          ///< guards progress and error message
+    std::string                             ErrorMessage;   ///< error of the first failed thread, thrown by DoKspaceStuff()
+    volatile bool                           Failed;         ///< set if a thread failed, the others stop after their current job
+
+    void SetError(const std::string& message)
     {
-        fMapSlice = SliceType::New();
-        ImageRegion<2> region;
-        region.SetSize(0, m_UpsampledImageRegion.GetSize()[0]);
-        region.SetSize(1, m_UpsampledImageRegion.GetSize()[1]);
-        fMapSlice->SetLargestPossibleRegion( region );
-        fMapSlice->SetBufferedRegion( region );
-        fMapSlice->SetRequestedRegion( region );
-        fMapSlice->Allocate();
-        fMapSlice->FillBuffer(0.0);
+        Mutex.Lock();
+        if (ErrorMessage.empty())
+            ErrorMessage = message;
+        Failed = true;
+        Mutex.Unlock();
     }
+};
 
+template< class PixelType >
+TractsToDWIImageFilter< PixelType >::DoubleDwiType::Pointer TractsToDWIImageFilter< PixelType >::DoKspaceStuff( std::vector< DoubleDwiType::Pointer >& images )
+{
     DoubleDwiType::Pointer newImage = DoubleDwiType::New();
     newImage->SetSpacing( m_Parameters.m_ImageSpacing );
     newImage->SetOrigin( m_Parameters.m_ImageOrigin );
@@ -99,125 +108,200 @@ TractsToDWIImageFilter< PixelType >::DoubleDwiType::Pointer TractsToDWIImageFilt
     newImage->SetVectorLength( images.at(0)->GetVectorLength() );
     newImage->Allocate();
 
+    KspaceJobs jobs;
+    jobs.Filter = this;
+    jobs.Images = &images;
+    jobs.Output = newImage;
+    jobs.NumSlices = images.at(0)->GetLargestPossibleRegion().GetSize(2);
+    jobs.NumJobs = (long)images.at(0)->GetVectorLength()*jobs.NumSlices;
+
+    // distribute spikes before the jobs are started, so the random numbers are drawn in the same order as in a sequential run
     std::vector< unsigned int > spikeVolume;
     for (unsigned int i=0; i<m_Parameters.m_Spikes; i++)
         spikeVolume.push_back(m_RandGen->GetIntegerVariate()%images.at(0)->GetVectorLength());
     std::sort (spikeVolume.begin(), spikeVolume.end());
     std::reverse (spikeVolume.begin(), spikeVolume.end());
 
-    m_StatusText += "0%   10   20   30   40   50   60   70   80   90   100%\n";
-    m_StatusText += "|----|----|----|----|----|----|----|----|----|----|\n*";
-    unsigned long lastTick = 0;
-
-    boost::progress_display disp(2*images.at(0)->GetVectorLength()*images.at(0)->GetLargestPossibleRegion().GetSize(2));
+    jobs.SpikesPerJob.resize(jobs.NumJobs, 0);
     for (unsigned int g=0; g<images.at(0)->GetVectorLength(); g++)
-    {
-        std::vector< unsigned int > spikeSlice;
         while (!spikeVolume.empty() && spikeVolume.back()==g)
         {
-            spikeSlice.push_back(m_RandGen->GetIntegerVariate()%images.at(0)->GetLargestPossibleRegion().GetSize(2));
+            jobs.SpikesPerJob[g*jobs.NumSlices + m_RandGen->GetIntegerVariate()%jobs.NumSlices]++;
             spikeVolume.pop_back();
         }
-        std::sort (spikeSlice.begin(), spikeSlice.end());
-        std::reverse (spikeSlice.begin(), spikeSlice.end());
 
-        for (unsigned int z=0; z<images.at(0)->GetLargestPossibleRegion().GetSize(2); z++)
-        {
-            std::vector< SliceType::Pointer > compartmentSlices;
-            std::vector< double > t2Vector;
+    // each job is seeded with BaseSeed+job, independent of the thread that executes it
+    if (!m_UseConstantRandSeed)
+        jobs.BaseSeed = m_RandGen->GetIntegerVariate()%(itk::NumericTraits<int>::max()/2);
 
-            for (unsigned int i=0; i<images.size(); i++)
-            {
-                DiffusionSignalModel<double>* signalModel;
-                if (i<m_Parameters.m_FiberModelList.size())
-                    signalModel = m_Parameters.m_FiberModelList.at(i);
-                else
-                    signalModel = m_Parameters.m_NonFiberModelList.at(i-m_Parameters.m_FiberModelList.size());
-
-                SliceType::Pointer slice = SliceType::New();
-                slice->SetLargestPossibleRegion( sliceRegion );
-                slice->SetBufferedRegion( sliceRegion );
-                slice->SetRequestedRegion( sliceRegion );
-                slice->SetSpacing(sliceSpacing);
-                slice->Allocate();
-                slice->FillBuffer(0.0);
-
-                // extract slice from channel g
-                for (unsigned int y=0; y<images.at(0)->GetLargestPossibleRegion().GetSize(1); y++)
-                    for (unsigned int x=0; x<images.at(0)->GetLargestPossibleRegion().GetSize(0); x++)
-                    {
-                        SliceType::IndexType index2D; index2D[0]=x; index2D[1]=y;
-                        DoubleDwiType::IndexType index3D; index3D[0]=x; index3D[1]=y; index3D[2]=z;
+    unsigned int numThreads = std::min( (long)this->GetNumberOfThreads(), jobs.NumJobs );
+    numThreads = std::max( numThreads, 1u );
+    jobs.FilterThreads = std::max( this->GetNumberOfThreads()/numThreads, 1u );
 
-                        slice->SetPixel(index2D, images.at(i)->GetPixel(index3D)[g]);
+    m_StatusText += "0%   10   20   30   40   50   60   70   80   90   100%\n";
+    m_StatusText += "|----|----|----|----|----|----|----|----|----|----|\n*";
+    boost::progress_display disp(jobs.NumJobs);
+    jobs.Progress = &disp;
 
-                        if (fMapSlice.IsNotNull() && i==0)
-                            fMapSlice->SetPixel(index2D, m_Parameters.m_FrequencyMap->GetPixel(index3D));
-                    }
+    this->GetMultiThreader()->SetNumberOfThreads(numThreads);
+    this->GetMultiThreader()->SetSingleMethod(KspaceJobsCallback, &jobs);
+    this->GetMultiThreader()->SingleMethodExecute();
 
-                compartmentSlices.push_back(slice);
-                t2Vector.push_back(signalModel->GetT2());
-            }
+    if (jobs.Failed)
+        itkExceptionMacro(<< "K-space simulation failed: " << jobs.ErrorMessage);
+    if (this->GetAbortGenerateData())
+        return NULL;
 
-            if (this->GetAbortGenerateData())
-                return NULL;
-
-            // create k-sapce (inverse fourier transform slices)
-            itk::Size<2> outSize; outSize.SetElement(0, m_Parameters.m_ImageRegion.GetSize(0)); outSize.SetElement(1, m_Parameters.m_ImageRegion.GetSize(1));
-            itk::KspaceImageFilter< SliceType::PixelType >::Pointer idft = itk::KspaceImageFilter< SliceType::PixelType >::New();
-            idft->SetCompartmentImages(compartmentSlices);
-            idft->SetT2(t2Vector);
-            idft->SetUseConstantRandSeed(m_UseConstantRandSeed);
-            idft->SetParameters(m_Parameters);
-            idft->SetZ((double)z-(double)images.at(0)->GetLargestPossibleRegion().GetSize(2)/2.0);
-            idft->SetDiffusionGradientDirection(m_Parameters.GetGradientDirection(g));
-            idft->SetFrequencyMapSlice(fMapSlice);
-            idft->SetOutSize(outSize);
-            int numSpikes = 0;
-            while (!spikeSlice.empty() && spikeSlice.back()==z)
-            {
-                numSpikes++;
-                spikeSlice.pop_back();
-            }
-            idft->SetSpikesPerSlice(numSpikes);
-            idft->Update();
-
-            ComplexSliceType::Pointer fSlice;
-            fSlice = idft->GetOutput();
-
-            ++disp;
-            unsigned long newTick = 50*disp.count()/disp.expected_count();
-            for (unsigned  long tick = 0; tick<(newTick-lastTick); tick++)
-                m_StatusText += "*";
-            lastTick = newTick;
-
-            // fourier transform slice
-            SliceType::Pointer newSlice;
-            itk::DftImageFilter< SliceType::PixelType >::Pointer dft = itk::DftImageFilter< SliceType::PixelType >::New();
-            dft->SetInput(fSlice);
-            dft->Update();
-            newSlice = dft->GetOutput();
-
-            // put slice back into channel g
-            for (unsigned int y=0; y<fSlice->GetLargestPossibleRegion().GetSize(1); y++)
-                for (unsigned int x=0; x<fSlice->GetLargestPossibleRegion().GetSize(0); x++)
+    m_StatusText += "\n\n";
+    return newImage;
+}
+
+template< class PixelType >
+ITK_THREAD_RETURN_TYPE TractsToDWIImageFilter< PixelType >::KspaceJobsCallback( void* arg )
+{
+    KspaceJobs* jobs = static_cast< KspaceJobs* >( static_cast< MultiThreader::ThreadInfoStruct* >(arg)->UserData );
+    try
+    {
+        jobs->Filter->SimulateKspaceJobs(*jobs);
+    }
+    catch (std::exception& e)
+    {
+        jobs->SetError(e.what());
+    }
+    catch (...)
+    {
+        // nothing may escape the thread, the calling thread throws instead
+        jobs->SetError("Unknown error during the k-space simulation");
+    }
+    return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class PixelType >
+void TractsToDWIImageFilter< PixelType >::SimulateKspaceJobs( KspaceJobs& jobs )
+{
+    std::vector< DoubleDwiType::Pointer >& images = *jobs.Images;
+    ImageRegion<3> imageRegion = images.at(0)->GetLargestPossibleRegion();
+    const unsigned int numGradients = images.at(0)->GetVectorLength();
+
+    // create slice objects, reused for all jobs of this thread
+    ImageRegion<2> sliceRegion;
+    sliceRegion.SetSize(0, m_UpsampledImageRegion.GetSize()[0]);
+    sliceRegion.SetSize(1, m_UpsampledImageRegion.GetSize()[1]);
+    Vector< double, 2 > sliceSpacing;
+    sliceSpacing[0] = m_UpsampledSpacing[0];
+    sliceSpacing[1] = m_UpsampledSpacing[1];
+
+    std::vector< SliceType::Pointer > compartmentSlices;
+    std::vector< double > t2Vector;
+    for (unsigned int i=0; i<images.size(); i++)
+    {
+        DiffusionSignalModel<double>* signalModel;
+        if (i<m_Parameters.m_FiberModelList.size())
+            signalModel = m_Parameters.m_FiberModelList.at(i);
+        else
+            signalModel = m_Parameters.m_NonFiberModelList.at(i-m_Parameters.m_FiberModelList.size());
+
+        SliceType::Pointer slice = SliceType::New();
+        slice->SetLargestPossibleRegion( sliceRegion );
+        slice->SetBufferedRegion( sliceRegion );
+        slice->SetRequestedRegion( sliceRegion );
+        slice->SetSpacing(sliceSpacing);
+        slice->Allocate();
+        slice->FillBuffer(0.0);
+
+        compartmentSlices.push_back(slice);
+        t2Vector.push_back(signalModel->GetT2());
+    }
+
+    // frequency map slice
+    SliceType::Pointer fMapSlice = NULL;
+    if (m_Parameters.m_FrequencyMap.IsNotNull())
+    {
+        fMapSlice = SliceType::New();
+        fMapSlice->SetLargestPossibleRegion( sliceRegion );
+        fMapSlice->SetBufferedRegion( sliceRegion );
+        fMapSlice->SetRequestedRegion( sliceRegion );
+        fMapSlice->Allocate();
+        fMapSlice->FillBuffer(0.0);
+    }
+
+    itk::Size<2> outSize; outSize.SetElement(0, m_Parameters.m_ImageRegion.GetSize(0)); outSize.SetElement(1, m_Parameters.m_ImageRegion.GetSize(1));
+    itk::KspaceImageFilter< SliceType::PixelType >::Pointer idft = itk::KspaceImageFilter< SliceType::PixelType >::New();
+    idft->SetCompartmentImages(compartmentSlices);
+    idft->SetT2(t2Vector);
+    idft->SetUseConstantRandSeed(m_UseConstantRandSeed);
+    idft->SetParameters(m_Parameters);
+    idft->SetFrequencyMapSlice(fMapSlice);
+    idft->SetOutSize(outSize);
+    idft->SetNumberOfThreads(jobs.FilterThreads);
+
+    itk::DftImageFilter< SliceType::PixelType >::Pointer dft = itk::DftImageFilter< SliceType::PixelType >::New();
+    dft->SetUseFft(m_Parameters.m_DoUseFft);
+    dft->SetNumberOfThreads(jobs.FilterThreads);
+
+    const unsigned long sliceSize = imageRegion.GetSize(0)*imageRegion.GetSize(1);
+    const unsigned long outSliceSize = outSize[0]*outSize[1];
+    long job;
+    while ( (job = jobs.NextJob.Increment()-1) < jobs.NumJobs )
+    {
+        if (this->GetAbortGenerateData() || jobs.Failed)
+            return;
+
+        const unsigned int g = job/jobs.NumSlices;
+        const unsigned int z = job%jobs.NumSlices;
+
+        // extract slice from channel g
+        for (unsigned int i=0; i<images.size(); i++)
+        {
+            const double* in = images.at(i)->GetBufferPointer() + z*sliceSize*numGradients + g;
+            double* out = compartmentSlices.at(i)->GetBufferPointer();
+            for (unsigned int y=0; y<imageRegion.GetSize(1); y++)
+                for (unsigned int x=0; x<imageRegion.GetSize(0); x++)
+                    out[y*sliceRegion.GetSize(0)+x] = in[(y*imageRegion.GetSize(0)+x)*numGradients];
+            compartmentSlices.at(i)->Modified();
+        }
+        if (fMapSlice.IsNotNull())
+        {
+            for (unsigned int y=0; y<imageRegion.GetSize(1); y++)
+                for (unsigned int x=0; x<imageRegion.GetSize(0); x++)
                 {
-                    DoubleDwiType::IndexType index3D; index3D[0]=x; index3D[1]=y; index3D[2]=z;
                     SliceType::IndexType index2D; index2D[0]=x; index2D[1]=y;
-
-                    DoubleDwiType::PixelType pix3D = newImage->GetPixel(index3D);
-                    pix3D[g] = newSlice->GetPixel(index2D);
-                    newImage->SetPixel(index3D, pix3D);
+                    DoubleDwiType::IndexType index3D; index3D[0]=x; index3D[1]=y; index3D[2]=z;
+                    fMapSlice->SetPixel(index2D, m_Parameters.m_FrequencyMap->GetPixel(index3D));
                 }
-            ++disp;
-            newTick = 50*disp.count()/disp.expected_count();
-            for (unsigned long tick = 0; tick<(newTick-lastTick); tick++)
-                m_StatusText += "*";
-            lastTick = newTick;
         }
+
+        // create k-sapce (inverse fourier transform slices)
+        idft->SetZ((double)z-(double)jobs.NumSlices/2.0);
+        idft->SetDiffusionGradientDirection(m_Parameters.GetGradientDirection(g));
+        idft->SetSpikesPerSlice(jobs.SpikesPerJob.at(job));
+        if (jobs.BaseSeed>=0)
+            idft->SetRandSeed(jobs.BaseSeed+job);
+        idft->Modified();
+        idft->Update();
+
+        // fourier transform slice
+        ComplexSliceType::Pointer fSlice = idft->GetOutput();
+        dft->SetInput(fSlice);
+        dft->Modified();
+        dft->Update();
+        SliceType::Pointer newSlice = dft->GetOutput();
+
+        // put slice back into channel g, the jobs write disjoint vector components
+        const double* in = newSlice->GetBufferPointer();
+        double* out = jobs.Output->GetBufferPointer() + z*outSliceSize*numGradients + g;
+        for (unsigned int y=0; y<fSlice->GetLargestPossibleRegion().GetSize(1); y++)
+            for (unsigned int x=0; x<fSlice->GetLargestPossibleRegion().GetSize(0); x++)
+                out[(y*outSize[0]+x)*numGradients] = in[y*fSlice->GetLargestPossibleRegion().GetSize(0)+x];
+
+        jobs.Mutex.Lock();
+        ++(*jobs.Progress);
+        unsigned long newTick = 50*jobs.Progress->count()/jobs.Progress->expected_count();
+        for (unsigned long tick = 0; tick<(newTick-jobs.LastTick); tick++)
+            m_StatusText += "*";
+        jobs.LastTick = newTick;
+        jobs.Mutex.Unlock();
     }
-    m_StatusText += "\n\n";
-    return newImage;
 }
 
 template< class PixelType >
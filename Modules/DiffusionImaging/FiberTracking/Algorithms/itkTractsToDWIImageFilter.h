@@ -82,9 +82,14 @@ protected:
     double RoundToNearest(double num);
     std::string GetTime();
 
-    /** Transform generated image compartment by compartment, channel by channel and slice by slice using DFT and add k-space artifacts. */
+    /** Transform generated image compartment by compartment, channel by channel and slice by slice using DFT and add k-space artifacts.
+      * The (gradient, slice) pairs are independent and simulated in parallel. Each pair uses its own random seed, so the result does not depend on the number of threads. */
     DoubleDwiType::Pointer DoKspaceStuff(std::vector< DoubleDwiType::Pointer >& images);
 
+    struct KspaceJobs;  ///< Data shared by the k-space simulation threads.
+    static ITK_THREAD_RETURN_TYPE KspaceJobsCallback(void* arg);
+    void SimulateKspaceJobs(KspaceJobs& jobs);   ///< Simulates (gradient, slice) pairs until none are left. Work buffers and filters are reused for all pairs of the calling thread.
+
     mitk::FiberfoxParameters<double>            m_Parameters;
     itk::Vector<double,3>                       m_UpsampledSpacing;
     itk::Point<double,3>                        m_UpsampledOrigin;
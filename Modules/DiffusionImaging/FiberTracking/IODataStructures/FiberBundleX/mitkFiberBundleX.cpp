@@ -17,6 +17,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #define _USE_MATH_DEFINES
 #include "mitkFiberBundleX.h"
+#include "mitkParallelFiberProcessor.h"
 
 #include <mitkPlanarCircle.h>
 #include <mitkPlanarPolygon.h>
@@ -39,9 +40,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkParametricSpline.h>
 #include <vtkPolygon.h>
 #include <vtkCleanPolyData.h>
+#include <vtkIdTypeArray.h>
 #include <cmath>
+#include <cstring>
 #include <boost/progress.hpp>
 #include <vtkTransformPolyDataFilter.h>
+#include <itkImageRegionConstIteratorWithIndex.h>
 
 const char* mitk::FiberBundleX::COLORCODING_ORIENTATION_BASED = "Color_Orient";
 //const char* mitk::FiberBundleX::COLORCODING_FA_AS_OPACITY = "Color_Orient_FA_Opacity";
@@ -51,10 +55,474 @@ const char* mitk::FiberBundleX::FIBER_ID_ARRAY = "Fiber_IDs";
 
 using namespace std;
 
+namespace
+{
+typedef mitk::FiberBundleX::ItkUcharImgType ItkUcharImgType;
+
+// sampling distance of the mask based fiber extraction
+float GetMinSpacing(ItkUcharImgType* mask)
+{
+    if(mask->GetSpacing()[0]<mask->GetSpacing()[1] && mask->GetSpacing()[0]<mask->GetSpacing()[2])
+        return mask->GetSpacing()[0];
+    else if (mask->GetSpacing()[1] < mask->GetSpacing()[2])
+        return mask->GetSpacing()[1];
+    return mask->GetSpacing()[2];
+}
+
+bool IsInMask(ItkUcharImgType* mask, const float* p)
+{
+    itk::Point<float, 3> itkP;
+    itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
+    itk::Index<3> idx;
+    mask->TransformPhysicalPointToIndex(itkP, idx);
+    return mask->GetLargestPossibleRegion().IsInside(idx) && mask->GetPixel(idx)>0;
+}
+
+// physical bounding box of the non-zero mask voxels, enlarged by one voxel. false if the mask is empty.
+bool GetMaskBounds(ItkUcharImgType* mask, double bounds[6])
+{
+    itk::Index<3> minIndex, maxIndex;
+    bool found = false;
+    itk::ImageRegionConstIteratorWithIndex< ItkUcharImgType > it(mask, mask->GetLargestPossibleRegion());
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+        if (it.Get()<=0)
+            continue;
+        itk::Index<3> idx = it.GetIndex();
+        for (int k=0; k<3; k++)
+        {
+            if (!found || idx[k]<minIndex[k])
+                minIndex[k] = idx[k];
+            if (!found || idx[k]>maxIndex[k])
+                maxIndex[k] = idx[k];
+        }
+        found = true;
+    }
+    if (!found)
+        return false;
+
+    for (int c=0; c<8; c++)
+    {
+        itk::ContinuousIndex<double, 3> corner;
+        for (int k=0; k<3; k++)
+            corner[k] = ((c>>k)&1) ? maxIndex[k]+1.5 : minIndex[k]-1.5;
+        itk::Point<double, 3> p;
+        mask->TransformContinuousIndexToPhysicalPoint(corner, p);
+        for (int k=0; k<3; k++)
+        {
+            if (c==0 || p[k]<bounds[2*k])
+                bounds[2*k] = p[k];
+            if (c==0 || p[k]>bounds[2*k+1])
+                bounds[2*k+1] = p[k];
+        }
+    }
+    return true;
+}
+
+// flags the fibers that may have points inside the mask
+std::vector< bool > GetFibersInMaskBounds(const mitk::FiberContainer& fibers, ItkUcharImgType* mask)
+{
+    std::vector< bool > isCandidate(fibers.GetNumFibers(), false);
+    double bounds[6];
+    if (GetMaskBounds(mask, bounds))
+    {
+        std::vector< unsigned int > candidates = fibers.GetFibersInBox(bounds);
+        for (unsigned int i=0; i<candidates.size(); i++)
+            isCandidate[candidates[i]] = true;
+    }
+    return isCandidate;
+}
+
+// fiber endpoint quantized to a fine grid, used to find identical fibers in SubtractBundle
+struct FiberEndpoint
+{
+    int cell[3];
+    unsigned int fiber;
+
+    FiberEndpoint(const float* p, unsigned int fiberId) : fiber(fiberId)
+    {
+        for (int k=0; k<3; k++)
+            cell[k] = (int)std::floor(p[k]/0.01);
+    }
+
+    bool operator<(const FiberEndpoint& other) const
+    {
+        for (int k=0; k<3; k++)
+            if (cell[k]!=other.cell[k])
+                return cell[k]<other.cell[k];
+        return fiber<other.fiber;
+    }
+};
+
+itk::Point<float, 3> ToItkPoint(const float* p)
+{
+    itk::Point<float, 3> itkPoint;
+    itkPoint[0] = p[0];
+    itkPoint[1] = p[1];
+    itkPoint[2] = p[2];
+    return itkPoint;
+}
+
+void GetPoint(const mitk::FiberContainer& fibers, unsigned int fiber, unsigned int point, double p[3])
+{
+    const float* q = fibers.GetPoint(fiber, point);
+    p[0] = q[0];
+    p[1] = q[1];
+    p[2] = q[2];
+}
+
+/* per-fiber kernels of the FiberBundleX operations, see ParallelFiberProcessor */
+
+class ResampleKernel : public mitk::FiberKernel
+{
+public:
+    ResampleKernel(const mitk::FiberContainer& fibers, float pointDistance) : m_Fibers(fibers), m_PointDistance(pointDistance) {}
+
+    void Initialize(unsigned int numberOfThreads) { m_Resampled.resize(numberOfThreads); }
+
+    void ProcessFiber(unsigned int fiber, unsigned int threadId, mitk::FiberBuffer& output)
+    {
+        std::vector< float >& resampled = m_Resampled[threadId];
+        resampled.clear();
+        mitk::FiberBundleX::ResampleFiber(m_Fibers.GetFiberPoints(fiber), m_Fibers.GetNumPoints(fiber), m_PointDistance, resampled);
+        for (unsigned int j=0; j<resampled.size(); j+=3)
+            output.AddPoint(&resampled[j]);
+        output.EndFiber();
+    }
+
+private:
+    const mitk::FiberContainer&         m_Fibers;
+    float                               m_PointDistance;
+    std::vector< std::vector< float > > m_Resampled;    ///< one buffer per thread
+};
+
+class CompressKernel : public mitk::FiberKernel
+{
+public:
+    CompressKernel(const mitk::FiberContainer& fibers, float error) : m_Fibers(fibers), m_Error(error) {}
+
+    void ProcessFiber(unsigned int i, unsigned int, mitk::FiberBuffer& output)
+    {
+        int numPoints = m_Fibers.GetNumPoints(i);
+        if (numPoints<=0)
+        {
+            output.EndFiber();
+            return;
+        }
+
+        // calculate curvatures
+        std::vector< int > removedPoints; removedPoints.resize(numPoints, 0);
+        removedPoints[0]=-1; removedPoints[numPoints-1]=-1;
+
+        bool pointFound = true;
+        while (pointFound)
+        {
+            pointFound = false;
+            double minError = m_Error;
+            int removeIndex = -1;
+
+            for (int j=0; j<numPoints; j++)
+            {
+                if (removedPoints[j]==0)
+                {
+                    double cand[3];
+                    GetPoint(m_Fibers, i, j, cand);
+                    vnl_vector_fixed< double, 3 > candV;
+                    candV[0]=cand[0]; candV[1]=cand[1]; candV[2]=cand[2];
+
+                    int validP = -1;
+                    vnl_vector_fixed< double, 3 > pred;
+                    for (int k=j-1; k>=0; k--)
+                        if (removedPoints[k]<=0)
+                        {
+                            double ref[3];
+                            GetPoint(m_Fibers, i, k, ref);
+                            pred[0]=ref[0]; pred[1]=ref[1]; pred[2]=ref[2];
+                            validP = k;
+                            break;
+                        }
+                    int validS = -1;
+                    vnl_vector_fixed< double, 3 > succ;
+                    for (int k=j+1; k<numPoints; k++)
+                        if (removedPoints[k]<=0)
+                        {
+                            double ref[3];
+                            GetPoint(m_Fibers, i, k, ref);
+                            succ[0]=ref[0]; succ[1]=ref[1]; succ[2]=ref[2];
+                            validS = k;
+                            break;
+                        }
+
+                    if (validP>=0 && validS>=0)
+                    {
+                        double a = (candV-pred).magnitude();
+                        double b = (candV-succ).magnitude();
+                        double c = (pred-succ).magnitude();
+                        double s=0.5*(a+b+c);
+                        double hc=(2.0/c)*sqrt(fabs(s*(s-a)*(s-b)*(s-c)));
+
+                        if (hc<minError)
+                        {
+                            removeIndex = j;
+                            minError = hc;
+                            pointFound = true;
+                        }
+                    }
+                }
+            }
+
+            if (pointFound)
+                removedPoints[removeIndex] = 1;
+        }
+
+        for (int j=0; j<numPoints; j++)
+            if (removedPoints[j]<=0)
+                output.AddPoint(m_Fibers.GetPoint(i, j));
+        output.EndFiber();
+    }
+
+private:
+    const mitk::FiberContainer& m_Fibers;
+    float                       m_Error;
+};
+
+class SmoothingKernel : public mitk::FiberKernel
+{
+public:
+    SmoothingKernel(const mitk::FiberContainer& fibers, const std::vector< float >& fiberLengths, float pointDistance, double tension, double continuity, double bias)
+        : m_Fibers(fibers), m_FiberLengths(fiberLengths), m_PointDistance(pointDistance), m_Tension(tension), m_Continuity(continuity), m_Bias(bias) {}
+
+    void ProcessFiber(unsigned int i, unsigned int, mitk::FiberBuffer& output)
+    {
+        int numPoints = m_Fibers.GetNumPoints(i);
+
+        vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
+        for (int j=0; j<numPoints; j++)
+        {
+            double p[3];
+            GetPoint(m_Fibers, i, j, p);
+            newPoints->InsertNextPoint(p);
+        }
+
+        float length = m_FiberLengths.at(i);
+        int sampling = std::ceil(length/m_PointDistance);
+
+        vtkSmartPointer<vtkKochanekSpline> xSpline = vtkSmartPointer<vtkKochanekSpline>::New();
+        vtkSmartPointer<vtkKochanekSpline> ySpline = vtkSmartPointer<vtkKochanekSpline>::New();
+        vtkSmartPointer<vtkKochanekSpline> zSpline = vtkSmartPointer<vtkKochanekSpline>::New();
+        xSpline->SetDefaultBias(m_Bias); xSpline->SetDefaultTension(m_Tension); xSpline->SetDefaultContinuity(m_Continuity);
+        ySpline->SetDefaultBias(m_Bias); ySpline->SetDefaultTension(m_Tension); ySpline->SetDefaultContinuity(m_Continuity);
+        zSpline->SetDefaultBias(m_Bias); zSpline->SetDefaultTension(m_Tension); zSpline->SetDefaultContinuity(m_Continuity);
+
+        vtkSmartPointer<vtkParametricSpline> spline = vtkSmartPointer<vtkParametricSpline>::New();
+        spline->SetXSpline(xSpline);
+        spline->SetYSpline(ySpline);
+        spline->SetZSpline(zSpline);
+        spline->SetPoints(newPoints);
+
+        vtkSmartPointer<vtkParametricFunctionSource> functionSource = vtkSmartPointer<vtkParametricFunctionSource>::New();
+        functionSource->SetParametricFunction(spline);
+        functionSource->SetUResolution(sampling);
+        functionSource->SetVResolution(sampling);
+        functionSource->SetWResolution(sampling);
+        functionSource->Update();
+
+        vtkPoints* tmpSmoothPnts = functionSource->GetOutput()->GetPoints(); //smoothPoints of current fiber
+        for (int j=0; j<tmpSmoothPnts->GetNumberOfPoints(); j++)
+        {
+            double p[3];
+            tmpSmoothPnts->GetPoint(j, p);
+            output.AddPoint(p);
+        }
+        output.EndFiber();
+    }
+
+private:
+    const mitk::FiberContainer&     m_Fibers;
+    const std::vector< float >&     m_FiberLengths;
+    float                           m_PointDistance;
+    double                          m_Tension;
+    double                          m_Continuity;
+    double                          m_Bias;
+};
+
+class CurvatureThresholdKernel : public mitk::FiberKernel
+{
+public:
+    CurvatureThresholdKernel(const mitk::FiberContainer& fibers, float minRadius, bool deleteFibers) : m_Fibers(fibers), m_MinRadius(minRadius), m_DeleteFibers(deleteFibers) {}
+
+    void ProcessFiber(unsigned int i, unsigned int, mitk::FiberBuffer& output)
+    {
+        int numPoints = m_Fibers.GetNumPoints(i);
+
+        // calculate curvatures
+        for (int j=0; j<numPoints-2; j++)
+        {
+            double p1[3];
+            GetPoint(m_Fibers, i, j, p1);
+            double p2[3];
+            GetPoint(m_Fibers, i, j+1, p2);
+            double p3[3];
+            GetPoint(m_Fibers, i, j+2, p3);
+
+            vnl_vector_fixed< float, 3 > v1, v2, v3;
+
+            v1[0] = p2[0]-p1[0];
+            v1[1] = p2[1]-p1[1];
+            v1[2] = p2[2]-p1[2];
+
+            v2[0] = p3[0]-p2[0];
+            v2[1] = p3[1]-p2[1];
+            v2[2] = p3[2]-p2[2];
+
+            v3[0] = p1[0]-p3[0];
+            v3[1] = p1[1]-p3[1];
+            v3[2] = p1[2]-p3[2];
+
+            float a = v1.magnitude();
+            float b = v2.magnitude();
+            float c = v3.magnitude();
+            float r = a*b*c/std::sqrt((a+b+c)*(a+b-c)*(b+c-a)*(a-b+c)); // radius of triangle via Heron's formula (area of triangle)
+
+            output.AddPoint(p1);
+
+            if (m_DeleteFibers && r<m_MinRadius)
+                break;
+
+            if (r<m_MinRadius)
+            {
+                j += 2;
+                output.EndFiber();
+            }
+            else if (j==numPoints-3)
+            {
+                output.AddPoint(p2);
+                output.AddPoint(p3);
+                output.EndFiber();
+            }
+        }
+        output.DiscardFiber();
+    }
+
+private:
+    const mitk::FiberContainer& m_Fibers;
+    float                       m_MinRadius;
+    bool                        m_DeleteFibers;
+};
+
+class LengthThresholdKernel : public mitk::FiberKernel
+{
+public:
+    LengthThresholdKernel(const mitk::FiberContainer& fibers, const std::vector< float >& fiberLengths, float minLength, float maxLength)
+        : m_Fibers(fibers), m_FiberLengths(fiberLengths), m_MinLength(minLength), m_MaxLength(maxLength) {}
+
+    void ProcessFiber(unsigned int i, unsigned int, mitk::FiberBuffer& output)
+    {
+        if (m_FiberLengths.at(i)<m_MinLength || m_FiberLengths.at(i)>m_MaxLength)
+            return;
+        for (unsigned int j=0; j<m_Fibers.GetNumPoints(i); j++)
+            output.AddPoint(m_Fibers.GetPoint(i, j));
+        output.EndFiber();
+    }
+
+private:
+    const mitk::FiberContainer& m_Fibers;
+    const std::vector< float >& m_FiberLengths;
+    float                       m_MinLength;
+    float                       m_MaxLength;
+};
+
+class OrientationColorKernel : public mitk::FiberKernel
+{
+public:
+    OrientationColorKernel(vtkPolyData* polyData, unsigned char* colors) : m_Points(polyData->GetPoints()), m_Colors(colors)
+    {
+        // point ids of all fibers, the cell array is not traversed concurrently
+        vtkCellArray* fiberList = polyData->GetLines();
+        fiberList->InitTraversal();
+        vtkIdType pointsPerFiber;
+        vtkIdType* idList;
+        while (fiberList->GetNextCell(pointsPerFiber, idList))
+        {
+            m_PointsPerFiber.push_back(pointsPerFiber);
+            m_IdLists.push_back(idList);
+        }
+    }
+
+    unsigned int GetNumFibers() const { return m_IdLists.size(); }
+
+    void ProcessFiber(unsigned int fi, unsigned int, mitk::FiberBuffer&)
+    {
+        vtkIdType* idList = m_IdLists[fi];
+        vtkIdType pointsPerFiber = m_PointsPerFiber[fi];
+
+        /* single fiber checkpoints: is number of points valid, a single point does not define a fiber */
+        if (pointsPerFiber <= 1)
+            return;
+
+        /* operate on points of single fiber */
+        for (int i=0; i <pointsPerFiber; ++i)
+        {
+            vnl_vector_fixed< double, 3 > diff;
+            if (i<pointsPerFiber-1 && i > 0)
+            {
+                /* The color value of the current point is influenced by the previous point and next point. */
+                vnl_vector_fixed< double, 3 > currentPntvtk = GetPoint(idList[i]);
+                vnl_vector_fixed< double, 3 > nextPntvtk = GetPoint(idList[i+1]);
+                vnl_vector_fixed< double, 3 > prevPntvtk = GetPoint(idList[i-1]);
+
+                vnl_vector_fixed< double, 3 > diff1;
+                diff1 = currentPntvtk - nextPntvtk;
+
+                vnl_vector_fixed< double, 3 > diff2;
+                diff2 = currentPntvtk - prevPntvtk;
+
+                diff = (diff1 - diff2) / 2.0;
+            }
+            else if (i==0)
+            {
+                /* First point has no previous point, therefore only diff1 is taken */
+                diff = GetPoint(idList[i]) - GetPoint(idList[i+1]);
+            }
+            else
+            {
+                /* Last point has no next point, therefore only diff2 is taken */
+                diff = GetPoint(idList[i]) - GetPoint(idList[i-1]);
+            }
+            diff.normalize();
+
+            unsigned char* rgba = m_Colors + 4*idList[i];
+            rgba[0] = (unsigned char) (255.0 * std::fabs(diff[0]));
+            rgba[1] = (unsigned char) (255.0 * std::fabs(diff[1]));
+            rgba[2] = (unsigned char) (255.0 * std::fabs(diff[2]));
+            rgba[3] = (unsigned char) (255.0);
+        }
+    }
+
+private:
+
+    vnl_vector_fixed< double, 3 > GetPoint(vtkIdType id)
+    {
+        // GetPoint(id) returns a pointer to a shared tuple and is not thread safe
+        vnl_vector_fixed< double, 3 > p;
+        m_Points->GetPoint(id, p.data_block());
+        return p;
+    }
+
+    vtkPoints*                  m_Points;
+    unsigned char*              m_Colors;
+    std::vector< vtkIdType >    m_PointsPerFiber;
+    std::vector< vtkIdType* >   m_IdLists;
+};
+}
+
 mitk::FiberBundleX::FiberBundleX( vtkPolyData* fiberPolyData )
-    : m_CurrentColorCoding(NULL)
+    : m_FiberContainerPolyData(NULL)
+    , m_FiberContainerTime(0)
+    , m_CurrentColorCoding(NULL)
     , m_NumFibers(0)
     , m_FiberSampling(0)
+    , m_NumberOfThreads(0)
 {
     m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
     if (fiberPolyData != NULL)
@@ -159,6 +627,35 @@ vtkSmartPointer<vtkPolyData> mitk::FiberBundleX::GeneratePolyDataByIds(std::vect
     return newFiberPolyData;
 }
 
+// polydata of the given fibers with the original fiber ids as cell data
+vtkSmartPointer<vtkPolyData> mitk::FiberBundleX::GeneratePolyDataWithFiberIds(const std::vector< unsigned int >& fiberIds)
+{
+    vtkSmartPointer<vtkPolyData> newPolyData = vtkSmartPointer<vtkPolyData>::New();
+    vtkSmartPointer<vtkCellArray> newLines = vtkSmartPointer<vtkCellArray>::New();
+    vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
+    vtkSmartPointer<vtkIdTypeArray> ids = vtkSmartPointer<vtkIdTypeArray>::New();
+    ids->SetName(FIBER_ID_ARRAY);
+    if (m_FiberPolyData->GetPoints()!=NULL)
+        newPoints->SetDataType(m_FiberPolyData->GetPoints()->GetDataType());
+
+    for (unsigned int i=0; i<fiberIds.size(); i++)
+    {
+        vtkIdType numPoints;
+        vtkIdType* pointIds;
+        m_FiberPolyData->GetCellPoints(fiberIds[i], numPoints, pointIds);
+
+        newLines->InsertNextCell(numPoints);
+        for (vtkIdType j=0; j<numPoints; j++)
+            newLines->InsertCellPoint(newPoints->InsertNextPoint(m_FiberPolyData->GetPoint(pointIds[j])));
+        ids->InsertNextValue(fiberIds[i]);
+    }
+
+    newPolyData->SetPoints(newPoints);
+    newPolyData->SetLines(newLines);
+    newPolyData->GetCellData()->AddArray(ids);
+    return newPolyData;
+}
+
 // merge two fiber bundles
 mitk::FiberBundleX::Pointer mitk::FiberBundleX::AddBundle(mitk::FiberBundleX* fib)
 {
@@ -229,43 +726,68 @@ mitk::FiberBundleX::Pointer mitk::FiberBundleX::SubtractBundle(mitk::FiberBundle
     vtkSmartPointer<vtkCellArray> vNewLines = vtkSmartPointer<vtkCellArray>::New();
     vtkSmartPointer<vtkPoints> vNewPoints = vtkSmartPointer<vtkPoints>::New();
 
+    const FiberContainer& fibers = GetFiberContainer();
+    const FiberContainer& fibers2 = fib->GetFiberContainer();
+
+    // sorted endpoints of the fibers to subtract, fibers with matching endpoints are found by binary search
+    std::vector< FiberEndpoint > endpoints;
+    endpoints.reserve(2*fibers2.GetNumFibers());
+    for (unsigned int i2=0; i2<fibers2.GetNumFibers(); i2++)
+    {
+        int numPoints2 = fibers2.GetNumPoints(i2);
+        if (numPoints2<=0)
+            continue;
+        endpoints.push_back(FiberEndpoint(fibers2.GetPoint(i2, 0), i2));
+        endpoints.push_back(FiberEndpoint(fibers2.GetPoint(i2, numPoints2-1), i2));
+    }
+    std::sort(endpoints.begin(), endpoints.end());
+
     // iterate over current fibers
-    boost::progress_display disp(m_NumFibers);
-    for( int i=0; i<m_NumFibers; i++ )
+    boost::progress_display disp(fibers.GetNumFibers());
+    vtkCellArray* lines = m_FiberPolyData->GetLines();
+    lines->InitTraversal();
+    for (unsigned int i=0; i<fibers.GetNumFibers(); i++)
     {
         ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        vtkIdType numPoints;
+        vtkIdType* pointIds;
+        lines->GetNextCell(numPoints, pointIds);
 
-        if (points==NULL || numPoints<=0)
+        if (numPoints<=0)
             continue;
 
-        int numFibers2 = fib->GetNumFibers();
+        itk::Point<float, 3> point_start = ToItkPoint(fibers.GetPoint(i, 0));
+        itk::Point<float, 3> point_end = ToItkPoint(fibers.GetPoint(i, numPoints-1));
+
+        // candidates have an endpoint in the neighborhood of the start point
         bool contained = false;
-        for( int i2=0; i2<numFibers2; i2++ )
+        FiberEndpoint start(fibers.GetPoint(i, 0), 0);
+        for (int n=0; n<27 && !contained; n++)
         {
-            vtkCell* cell2 = fib->GetFiberPolyData()->GetCell(i2);
-            int numPoints2 = cell2->GetNumberOfPoints();
-            vtkPoints* points2 = cell2->GetPoints();
-
-            if (points2==NULL)// || numPoints2<=0)
-                continue;
+            FiberEndpoint neighbor = start;
+            neighbor.cell[0] += n%3-1;
+            neighbor.cell[1] += (n/3)%3-1;
+            neighbor.cell[2] += n/9-1;
 
-            // check endpoints
-            if (numPoints2==numPoints)
+            std::vector< FiberEndpoint >::const_iterator it = std::lower_bound(endpoints.begin(), endpoints.end(), neighbor);
+            for (; it!=endpoints.end() && !contained; ++it)
             {
-                itk::Point<float, 3> point_start = GetItkPoint(points->GetPoint(0));
-                itk::Point<float, 3> point_end = GetItkPoint(points->GetPoint(numPoints-1));
-                itk::Point<float, 3> point2_start = GetItkPoint(points2->GetPoint(0));
-                itk::Point<float, 3> point2_end = GetItkPoint(points2->GetPoint(numPoints2-1));
+                if (it->cell[0]!=neighbor.cell[0] || it->cell[1]!=neighbor.cell[1] || it->cell[2]!=neighbor.cell[2])
+                    break;
 
-                if ((point_start.SquaredEuclideanDistanceTo(point2_start)<=mitk::eps && point_end.SquaredEuclideanDistanceTo(point2_end)<=mitk::eps) ||
-                        (point_start.SquaredEuclideanDistanceTo(point2_end)<=mitk::eps && point_end.SquaredEuclideanDistanceTo(point2_start)<=mitk::eps))
+                // check endpoints
+                int numPoints2 = fibers2.GetNumPoints(it->fiber);
+                if (numPoints2==numPoints)
                 {
-                    // further checking ???
-                    contained = true;
-                    break;
+                    itk::Point<float, 3> point2_start = ToItkPoint(fibers2.GetPoint(it->fiber, 0));
+                    itk::Point<float, 3> point2_end = ToItkPoint(fibers2.GetPoint(it->fiber, numPoints2-1));
+
+                    if ((point_start.SquaredEuclideanDistanceTo(point2_start)<=mitk::eps && point_end.SquaredEuclideanDistanceTo(point2_end)<=mitk::eps) ||
+                            (point_start.SquaredEuclideanDistanceTo(point2_end)<=mitk::eps && point_end.SquaredEuclideanDistanceTo(point2_start)<=mitk::eps))
+                    {
+                        // further checking ???
+                        contained = true;
+                    }
                 }
             }
         }
@@ -276,7 +798,7 @@ mitk::FiberBundleX::Pointer mitk::FiberBundleX::SubtractBundle(mitk::FiberBundle
             vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
             for( int j=0; j<numPoints; j++)
             {
-                vtkIdType id = vNewPoints->InsertNextPoint(points->GetPoint(j));
+                vtkIdType id = vNewPoints->InsertNextPoint(m_FiberPolyData->GetPoint(pointIds[j]));
                 container->GetPointIds()->InsertNextId(id);
             }
             vNewLines->InsertNextCell(container);
@@ -330,6 +852,17 @@ vtkSmartPointer<vtkPolyData> mitk::FiberBundleX::GetFiberPolyData()
     return m_FiberPolyData;
 }
 
+const mitk::FiberContainer& mitk::FiberBundleX::GetFiberContainer()
+{
+    if (m_FiberContainerPolyData!=m_FiberPolyData.GetPointer() || m_FiberContainerTime!=m_FiberPolyData->GetMTime())
+    {
+        m_FiberContainer.Initialize(m_FiberPolyData);
+        m_FiberContainerPolyData = m_FiberPolyData;
+        m_FiberContainerTime = m_FiberPolyData->GetMTime();
+    }
+    return m_FiberContainer;
+}
+
 void mitk::FiberBundleX::DoColorCodingOrientationBased()
 {
     //===== FOR WRITING A TEST ========================
@@ -361,8 +894,6 @@ void mitk::FiberBundleX::DoColorCodingOrientationBased()
         numOfPoints = extrPoints->GetNumberOfPoints();
 
     //colors and alpha value for each single point, RGBA = 4 components
-    unsigned char rgba[4] = {0,0,0,0};
-    //    int componentSize = sizeof(rgba);
     int componentSize = 4;
 
     vtkSmartPointer<vtkUnsignedCharArray> colorsT = vtkSmartPointer<vtkUnsignedCharArray>::New();
@@ -380,97 +911,14 @@ void mitk::FiberBundleX::DoColorCodingOrientationBased()
     }
 
 
-    /* extract single fibers of fiberBundle */
-    vtkCellArray* fiberList = m_FiberPolyData->GetLines();
-    fiberList->InitTraversal();
-    for (int fi=0; fi<numOfFibers; ++fi) {
-
-        vtkIdType* idList; // contains the point id's of the line
-        vtkIdType pointsPerFiber; // number of points for current line
-        fiberList->GetNextCell(pointsPerFiber, idList);
-
-        //    MITK_DEBUG << "Fib#: " << fi << " of " << numOfFibers << " pnts in fiber: " << pointsPerFiber ;
-
-        /* single fiber checkpoints: is number of points valid */
-        if (pointsPerFiber > 1)
-        {
-            /* operate on points of single fiber */
-            for (int i=0; i <pointsPerFiber; ++i)
-            {
-                /* process all points except starting and endpoint
-         * for calculating color value take current point, previous point and next point */
-                if (i<pointsPerFiber-1 && i > 0)
-                {
-                    /* The color value of the current point is influenced by the previous point and next point. */
-                    vnl_vector_fixed< double, 3 > currentPntvtk(extrPoints->GetPoint(idList[i])[0], extrPoints->GetPoint(idList[i])[1],extrPoints->GetPoint(idList[i])[2]);
-                    vnl_vector_fixed< double, 3 > nextPntvtk(extrPoints->GetPoint(idList[i+1])[0], extrPoints->GetPoint(idList[i+1])[1], extrPoints->GetPoint(idList[i+1])[2]);
-                    vnl_vector_fixed< double, 3 > prevPntvtk(extrPoints->GetPoint(idList[i-1])[0], extrPoints->GetPoint(idList[i-1])[1], extrPoints->GetPoint(idList[i-1])[2]);
-
-                    vnl_vector_fixed< double, 3 > diff1;
-                    diff1 = currentPntvtk - nextPntvtk;
-
-                    vnl_vector_fixed< double, 3 > diff2;
-                    diff2 = currentPntvtk - prevPntvtk;
-
-                    vnl_vector_fixed< double, 3 > diff;
-                    diff = (diff1 - diff2) / 2.0;
-                    diff.normalize();
-
-                    rgba[0] = (unsigned char) (255.0 * std::fabs(diff[0]));
-                    rgba[1] = (unsigned char) (255.0 * std::fabs(diff[1]));
-                    rgba[2] = (unsigned char) (255.0 * std::fabs(diff[2]));
-                    rgba[3] = (unsigned char) (255.0);
-
-
-                } else if (i==0) {
-                    /* First point has no previous point, therefore only diff1 is taken */
-
-                    vnl_vector_fixed< double, 3 > currentPntvtk(extrPoints->GetPoint(idList[i])[0], extrPoints->GetPoint(idList[i])[1],extrPoints->GetPoint(idList[i])[2]);
-                    vnl_vector_fixed< double, 3 > nextPntvtk(extrPoints->GetPoint(idList[i+1])[0], extrPoints->GetPoint(idList[i+1])[1], extrPoints->GetPoint(idList[i+1])[2]);
-
-                    vnl_vector_fixed< double, 3 > diff1;
-                    diff1 = currentPntvtk - nextPntvtk;
-                    diff1.normalize();
-
-                    rgba[0] = (unsigned char) (255.0 * std::fabs(diff1[0]));
-                    rgba[1] = (unsigned char) (255.0 * std::fabs(diff1[1]));
-                    rgba[2] = (unsigned char) (255.0 * std::fabs(diff1[2]));
-                    rgba[3] = (unsigned char) (255.0);
-
-
-                } else if (i==pointsPerFiber-1) {
-                    /* Last point has no next point, therefore only diff2 is taken */
-                    vnl_vector_fixed< double, 3 > currentPntvtk(extrPoints->GetPoint(idList[i])[0], extrPoints->GetPoint(idList[i])[1],extrPoints->GetPoint(idList[i])[2]);
-                    vnl_vector_fixed< double, 3 > prevPntvtk(extrPoints->GetPoint(idList[i-1])[0], extrPoints->GetPoint(idList[i-1])[1], extrPoints->GetPoint(idList[i-1])[2]);
-
-                    vnl_vector_fixed< double, 3 > diff2;
-                    diff2 = currentPntvtk - prevPntvtk;
-                    diff2.normalize();
-
-                    rgba[0] = (unsigned char) (255.0 * std::fabs(diff2[0]));
-                    rgba[1] = (unsigned char) (255.0 * std::fabs(diff2[1]));
-                    rgba[2] = (unsigned char) (255.0 * std::fabs(diff2[2]));
-                    rgba[3] = (unsigned char) (255.0);
-
-                }
-
-                colorsT->InsertTupleValue(idList[i], rgba);
-
-            } //end for loop
-
-        } else if (pointsPerFiber == 1) {
-            /* a single point does not define a fiber (use vertex mechanisms instead */
-            continue;
-            //      colorsT->InsertTupleValue(0, rgba);
-
-        } else {
-            MITK_DEBUG << "Fiber with 0 points detected... please check your tractography algorithm!" ;
-            continue;
-
-        }
-
-
-    }//end for loop
+    /* fibers are colored in parallel, each point is written by the fiber it belongs to */
+    colorsT->SetNumberOfTuples(numOfPoints);
+    if (numOfPoints>0)
+        memset(colorsT->GetPointer(0), 0, numOfPoints*componentSize);
+    OrientationColorKernel kernel(m_FiberPolyData, colorsT->GetPointer(0));
+    ParallelFiberProcessor processor;
+    processor.SetNumberOfThreads(m_NumberOfThreads);
+    processor.Process(kernel.GetNumFibers(), kernel);
 
     m_FiberPolyData->GetPointData()->AddArray(colorsT);
 
@@ -584,92 +1032,53 @@ void mitk::FiberBundleX::GenerateFiberIds()
 
 mitk::FiberBundleX::Pointer mitk::FiberBundleX::ExtractFiberSubset(ItkUcharImgType* mask, bool anyPoint)
 {
-    vtkSmartPointer<vtkPolyData> polyData = m_FiberPolyData;
-    if (anyPoint)
-    {
-        float minSpacing = 1;
-        if(mask->GetSpacing()[0]<mask->GetSpacing()[1] && mask->GetSpacing()[0]<mask->GetSpacing()[2])
-            minSpacing = mask->GetSpacing()[0];
-        else if (mask->GetSpacing()[1] < mask->GetSpacing()[2])
-            minSpacing = mask->GetSpacing()[1];
-        else
-            minSpacing = mask->GetSpacing()[2];
+    float minSpacing = GetMinSpacing(mask);
+    const FiberContainer& fibers = GetFiberContainer();
+    std::vector< bool > isCandidate = GetFibersInMaskBounds(fibers, mask);
 
-        mitk::FiberBundleX::Pointer fibCopy = this->GetDeepCopy();
-        fibCopy->ResampleFibers(minSpacing/10);
-        polyData = fibCopy->GetFiberPolyData();
-    }
     vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
     vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    vtkSmartPointer<vtkPolyLine> emptyFiber = vtkSmartPointer<vtkPolyLine>::New();
+    std::vector< float > resampled;
 
     MITK_INFO << "Extracting fibers";
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<m_NumFibers; i++)
+    boost::progress_display disp(fibers.GetNumFibers());
+    vtkCellArray* lines = m_FiberPolyData->GetLines();
+    lines->InitTraversal();
+    for (unsigned int i=0; i<fibers.GetNumFibers(); i++)
     {
         ++disp;
+        vtkIdType numPointsOriginal;
+        vtkIdType* pointIdsOriginal;
+        lines->GetNextCell(numPointsOriginal, pointIdsOriginal);
 
-        vtkCell* cell = polyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkCell* cellOriginal = m_FiberPolyData->GetCell(i);
-        int numPointsOriginal = cellOriginal->GetNumberOfPoints();
-        vtkPoints* pointsOriginal = cellOriginal->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-
-        if (numPoints>1 && numPointsOriginal)
+        bool inside = false;
+        if (isCandidate[i])
         {
-            if (anyPoint)
+            if (anyPoint && numPointsOriginal>0)
             {
-                for (int j=0; j<numPoints; j++)
-                {
-                    double* p = points->GetPoint(j);
-
-                    itk::Point<float, 3> itkP;
-                    itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
-                    itk::Index<3> idx;
-                    mask->TransformPhysicalPointToIndex(itkP, idx);
-
-                    if ( mask->GetPixel(idx)>0 && mask->GetLargestPossibleRegion().IsInside(idx) )
-                    {
-                        for (int k=0; k<numPointsOriginal; k++)
-                        {
-                            double* p = pointsOriginal->GetPoint(k);
-                            vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                            container->GetPointIds()->InsertNextId(id);
-                        }
-                        break;
-                    }
-                }
+                // the fiber is resampled to minSpacing/10 so that no voxel is skipped
+                resampled.clear();
+                ResampleFiber(fibers.GetFiberPoints(i), numPointsOriginal, minSpacing/10, resampled);
+                for (unsigned int j=0; j<resampled.size() && !inside; j+=3)
+                    inside = IsInMask(mask, &resampled[j]);
             }
-            else
+            else if (!anyPoint && numPointsOriginal>1)
+                inside = IsInMask(mask, fibers.GetPoint(i, 0)) && IsInMask(mask, fibers.GetPoint(i, numPointsOriginal-1));
+        }
+
+        if (inside)
+        {
+            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+            for (int k=0; k<numPointsOriginal; k++)
             {
-                double* start = pointsOriginal->GetPoint(0);
-                itk::Point<float, 3> itkStart;
-                itkStart[0] = start[0]; itkStart[1] = start[1]; itkStart[2] = start[2];
-                itk::Index<3> idxStart;
-                mask->TransformPhysicalPointToIndex(itkStart, idxStart);
-
-                double* end = pointsOriginal->GetPoint(numPointsOriginal-1);
-                itk::Point<float, 3> itkEnd;
-                itkEnd[0] = end[0]; itkEnd[1] = end[1]; itkEnd[2] = end[2];
-                itk::Index<3> idxEnd;
-                mask->TransformPhysicalPointToIndex(itkEnd, idxEnd);
-
-                if ( mask->GetPixel(idxStart)>0 && mask->GetPixel(idxEnd)>0 && mask->GetLargestPossibleRegion().IsInside(idxStart) && mask->GetLargestPossibleRegion().IsInside(idxEnd) )
-                {
-                    for (int j=0; j<numPointsOriginal; j++)
-                    {
-                        double* p = pointsOriginal->GetPoint(j);
-                        vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                        container->GetPointIds()->InsertNextId(id);
-                    }
-                }
+                vtkIdType id = vtkNewPoints->InsertNextPoint(m_FiberPolyData->GetPoint(pointIdsOriginal[k]));
+                container->GetPointIds()->InsertNextId(id);
             }
+            vtkNewCells->InsertNextCell(container);
         }
-
-        vtkNewCells->InsertNextCell(container);
+        else
+            vtkNewCells->InsertNextCell(emptyFiber);
     }
 
     if (vtkNewCells->GetNumberOfCells()<=0)
@@ -683,30 +1092,27 @@ mitk::FiberBundleX::Pointer mitk::FiberBundleX::ExtractFiberSubset(ItkUcharImgTy
 
 mitk::FiberBundleX::Pointer mitk::FiberBundleX::RemoveFibersOutside(ItkUcharImgType* mask, bool invert)
 {
-    float minSpacing = 1;
-    if(mask->GetSpacing()[0]<mask->GetSpacing()[1] && mask->GetSpacing()[0]<mask->GetSpacing()[2])
-        minSpacing = mask->GetSpacing()[0];
-    else if (mask->GetSpacing()[1] < mask->GetSpacing()[2])
-        minSpacing = mask->GetSpacing()[1];
-    else
-        minSpacing = mask->GetSpacing()[2];
-
-    mitk::FiberBundleX::Pointer fibCopy = this->GetDeepCopy();
-    fibCopy->ResampleFibers(minSpacing/10);
-    vtkSmartPointer<vtkPolyData> polyData =fibCopy->GetFiberPolyData();
+    float minSpacing = GetMinSpacing(mask);
+    const FiberContainer& fibers = GetFiberContainer();
+    std::vector< bool > isCandidate = GetFibersInMaskBounds(fibers, mask);
 
     vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
     vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    std::vector< float > resampled;
 
     MITK_INFO << "Cutting fibers";
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<m_NumFibers; i++)
+    boost::progress_display disp(fibers.GetNumFibers());
+    for (unsigned int i=0; i<fibers.GetNumFibers(); i++)
     {
         ++disp;
 
-        vtkCell* cell = polyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+        // fibers outside of the mask bounds are removed completely or kept completely
+        if (!isCandidate[i] && !invert)
+            continue;
+
+        resampled.clear();
+        ResampleFiber(fibers.GetFiberPoints(i), fibers.GetNumPoints(i), minSpacing/10, resampled);
+        int numPoints = resampled.size()/3;
 
         vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
         if (numPoints>1)
@@ -714,22 +1120,12 @@ mitk::FiberBundleX::Pointer mitk::FiberBundleX::RemoveFibersOutside(ItkUcharImgT
             int newNumPoints = 0;
             for (int j=0; j<numPoints; j++)
             {
-                double* p = points->GetPoint(j);
-
-                itk::Point<float, 3> itkP;
-                itkP[0] = p[0]; itkP[1] = p[1]; itkP[2] = p[2];
-                itk::Index<3> idx;
-                mask->TransformPhysicalPointToIndex(itkP, idx);
+                const float* p = &resampled[3*j];
+                bool inside = isCandidate[i] && IsInMask(mask, p);
 
-                if ( mask->GetPixel(idx)>0 && mask->GetLargestPossibleRegion().IsInside(idx) && !invert )
+                if ( inside != invert )
                 {
-                    vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                    container->GetPointIds()->InsertNextId(id);
-                    newNumPoints++;
-                }
-                else if ( (mask->GetPixel(idx)<=0 || !mask->GetLargestPossibleRegion().IsInside(idx)) && invert )
-                {
-                    vtkIdType id = vtkNewPoints->InsertNextPoint(p);
+                    vtkIdType id = vtkNewPoints->InsertNextPoint(p[0], p[1], p[2]);
                     container->GetPointIds()->InsertNextId(id);
                     newNumPoints++;
                 }
@@ -907,6 +1303,50 @@ std::vector<long> mitk::FiberBundleX::ExtractFiberIdSubset(mitk::PlanarFigure* p
         std::vector<int> PointsOnPlane; // contains all pointIds which are crossing the cutting plane
         std::vector<int> PointsInROI; // based on PointsOnPlane, all ROI relevant point IDs are stored here
 
+        mitk::PlanarCircle::Pointer circleName = mitk::PlanarCircle::New();
+        mitk::PlanarPolygon::Pointer polyName = mitk::PlanarPolygon::New();
+
+        /* only fibers passing the bounding box of the ROI can cross it */
+        vtkSmartPointer<vtkDataSet> clipInput = m_FiberIdDataSet;
+        double roiBounds[6];
+        bool hasRoiBounds = false;
+        if ( pf->GetNameOfClass() == circleName->GetNameOfClass() )
+        {
+            mitk::Point3D center = pf->GetWorldControlPoint(0);
+            double radius = center.EuclideanDistanceTo(pf->GetWorldControlPoint(1));
+            for (int k=0; k<3; k++)
+            {
+                roiBounds[2*k] = center[k]-radius;
+                roiBounds[2*k+1] = center[k]+radius;
+            }
+            hasRoiBounds = true;
+        }
+        else if ( pf->GetNameOfClass() == polyName->GetNameOfClass() && pf->GetNumberOfControlPoints()>0 )
+        {
+            for (unsigned int i=0; i<pf->GetNumberOfControlPoints(); ++i)
+                for (int k=0; k<3; k++)
+                {
+                    if (i==0 || pf->GetWorldControlPoint(i)[k]<roiBounds[2*k])
+                        roiBounds[2*k] = pf->GetWorldControlPoint(i)[k];
+                    if (i==0 || pf->GetWorldControlPoint(i)[k]>roiBounds[2*k+1])
+                        roiBounds[2*k+1] = pf->GetWorldControlPoint(i)[k];
+                }
+            hasRoiBounds = true;
+        }
+        if (hasRoiBounds)
+        {
+            // points within 0.01 of the plane are counted as crossing points
+            for (int k=0; k<3; k++)
+            {
+                roiBounds[2*k] -= 0.02;
+                roiBounds[2*k+1] += 0.02;
+            }
+            std::vector< unsigned int > candidates = GetFiberContainer().GetFibersInBox(roiBounds);
+            if (candidates.empty())
+                return FibersInROI;
+            clipInput = GeneratePolyDataWithFiberIds(candidates);
+        }
+
         /* Define cutting plane by ROI (PlanarFigure) */
         vtkSmartPointer<vtkPlane> plane = vtkSmartPointer<vtkPlane>::New();
         plane->SetOrigin(planeOrigin[0],planeOrigin[1],planeOrigin[2]);
@@ -915,7 +1355,7 @@ std::vector<long> mitk::FiberBundleX::ExtractFiberIdSubset(mitk::PlanarFigure* p
         /* get all points/fibers cutting the plane */
         MITK_DEBUG << "start clipping";
         vtkSmartPointer<vtkClipPolyData> clipper = vtkSmartPointer<vtkClipPolyData>::New();
-        clipper->SetInputData(m_FiberIdDataSet);
+        clipper->SetInputData(clipInput);
         clipper->SetClipFunction(plane);
         clipper->GenerateClipScalarsOn();
         clipper->GenerateClippedOutputOn();
@@ -955,8 +1395,6 @@ std::vector<long> mitk::FiberBundleX::ExtractFiberIdSubset(mitk::PlanarFigure* p
         /*=======STEP 2=====
      * extract ROI relevant pointIds */
 
-        mitk::PlanarCircle::Pointer circleName = mitk::PlanarCircle::New();
-        mitk::PlanarPolygon::Pointer polyName = mitk::PlanarPolygon::New();
         if ( pf->GetNameOfClass() == circleName->GetNameOfClass() )
         {
             //calculate circle radius
@@ -1545,77 +1983,16 @@ bool mitk::FiberBundleX::ApplyCurvatureThreshold(float minRadius, bool deleteFib
     if (minRadius<0)
         return true;
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
     MITK_INFO << "Applying curvature threshold";
-    boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
-    {
-        ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        // calculate curvatures
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-        for (int j=0; j<numPoints-2; j++)
-        {
-            double p1[3];
-            points->GetPoint(j, p1);
-            double p2[3];
-            points->GetPoint(j+1, p2);
-            double p3[3];
-            points->GetPoint(j+2, p3);
-
-            vnl_vector_fixed< float, 3 > v1, v2, v3;
-
-            v1[0] = p2[0]-p1[0];
-            v1[1] = p2[1]-p1[1];
-            v1[2] = p2[2]-p1[2];
-
-            v2[0] = p3[0]-p2[0];
-            v2[1] = p3[1]-p2[1];
-            v2[2] = p3[2]-p2[2];
-
-            v3[0] = p1[0]-p3[0];
-            v3[1] = p1[1]-p3[1];
-            v3[2] = p1[2]-p3[2];
-
-            float a = v1.magnitude();
-            float b = v2.magnitude();
-            float c = v3.magnitude();
-            float r = a*b*c/std::sqrt((a+b+c)*(a+b-c)*(b+c-a)*(a-b+c)); // radius of triangle via Heron's formula (area of triangle)
-
-            vtkIdType id = vtkNewPoints->InsertNextPoint(p1);
-            container->GetPointIds()->InsertNextId(id);
-
-            if (deleteFibers && r<minRadius)
-                break;
-
-            if (r<minRadius)
-            {
-                j += 2;
-                vtkNewCells->InsertNextCell(container);
-                container = vtkSmartPointer<vtkPolyLine>::New();
-            }
-            else if (j==numPoints-3)
-            {
-                id = vtkNewPoints->InsertNextPoint(p2);
-                container->GetPointIds()->InsertNextId(id);
-                id = vtkNewPoints->InsertNextPoint(p3);
-                container->GetPointIds()->InsertNextId(id);
-                vtkNewCells->InsertNextCell(container);
-            }
-        }
-    }
+    CurvatureThresholdKernel kernel(GetFiberContainer(), minRadius, deleteFibers);
+    ParallelFiberProcessor processor;
+    processor.SetNumberOfThreads(m_NumberOfThreads);
+    processor.Process(GetFiberContainer().GetNumFibers(), kernel);
 
-    if (vtkNewCells->GetNumberOfCells()<=0)
+    if (processor.GetNumberOfOutputFibers()<=0)
         return false;
 
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
+    m_FiberPolyData = processor.GetOutput();
 
     UpdateColorCoding();
     UpdateFiberGeometry();
@@ -1637,39 +2014,15 @@ bool mitk::FiberBundleX::RemoveShortFibers(float lengthInMM)
         return false;
     }
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-    float min = m_MaxFiberLength;
+    LengthThresholdKernel kernel(GetFiberContainer(), m_FiberLengths, lengthInMM, itk::NumericTraits<float>::max());
+    ParallelFiberProcessor processor;
+    processor.SetNumberOfThreads(m_NumberOfThreads);
+    processor.Process(GetFiberContainer().GetNumFibers(), kernel);
 
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<m_NumFibers; i++)
-    {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        if (m_FiberLengths.at(i)>=lengthInMM)
-        {
-            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-            for (int j=0; j<numPoints; j++)
-            {
-                double* p = points->GetPoint(j);
-                vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                container->GetPointIds()->InsertNextId(id);
-            }
-            vtkNewCells->InsertNextCell(container);
-            if (m_FiberLengths.at(i)<min)
-                min = m_FiberLengths.at(i);
-        }
-    }
-
-    if (vtkNewCells->GetNumberOfCells()<=0)
+    if (processor.GetNumberOfOutputFibers()<=0)
         return false;
 
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
+    m_FiberPolyData = processor.GetOutput();
 
     UpdateColorCoding();
     UpdateFiberGeometry();
@@ -1684,37 +2037,16 @@ bool mitk::FiberBundleX::RemoveLongFibers(float lengthInMM)
     if (lengthInMM<m_MinFiberLength)    // can't remove all fibers
         return false;
 
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
     MITK_INFO << "Removing long fibers";
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<m_NumFibers; i++)
-    {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
+    LengthThresholdKernel kernel(GetFiberContainer(), m_FiberLengths, itk::NumericTraits<float>::NonpositiveMin(), lengthInMM);
+    ParallelFiberProcessor processor;
+    processor.SetNumberOfThreads(m_NumberOfThreads);
+    processor.Process(GetFiberContainer().GetNumFibers(), kernel);
 
-        if (m_FiberLengths.at(i)<=lengthInMM)
-        {
-            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-            for (int j=0; j<numPoints; j++)
-            {
-                double* p = points->GetPoint(j);
-                vtkIdType id = vtkNewPoints->InsertNextPoint(p);
-                container->GetPointIds()->InsertNextId(id);
-            }
-            vtkNewCells->InsertNextCell(container);
-        }
-    }
-
-    if (vtkNewCells->GetNumberOfCells()<=0)
+    if (processor.GetNumberOfOutputFibers()<=0)
         return false;
 
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkNewPoints);
-    m_FiberPolyData->SetLines(vtkNewCells);
+    m_FiberPolyData = processor.GetOutput();
     UpdateColorCoding();
     UpdateFiberGeometry();
     return true;
@@ -1725,66 +2057,13 @@ void mitk::FiberBundleX::DoFiberSmoothing(float pointDistance, double tension, d
     if (pointDistance<=0)
         return;
 
-    vtkSmartPointer<vtkPoints> vtkSmoothPoints = vtkSmartPointer<vtkPoints>::New(); //in smoothpoints the interpolated points representing a fiber are stored.
-
-    //in vtkcells all polylines are stored, actually all id's of them are stored
-    vtkSmartPointer<vtkCellArray> vtkSmoothCells = vtkSmartPointer<vtkCellArray>::New(); //cellcontainer for smoothed lines
-    vtkIdType pointHelperCnt = 0;
-
     MITK_INFO << "Smoothing fibers";
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<m_NumFibers; i++)
-    {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPoints> newPoints = vtkSmartPointer<vtkPoints>::New();
-        for (int j=0; j<numPoints; j++)
-            newPoints->InsertNextPoint(points->GetPoint(j));
-
-        float length = m_FiberLengths.at(i);
-        int sampling = std::ceil(length/pointDistance);
-
-        vtkSmartPointer<vtkKochanekSpline> xSpline = vtkSmartPointer<vtkKochanekSpline>::New();
-        vtkSmartPointer<vtkKochanekSpline> ySpline = vtkSmartPointer<vtkKochanekSpline>::New();
-        vtkSmartPointer<vtkKochanekSpline> zSpline = vtkSmartPointer<vtkKochanekSpline>::New();
-        xSpline->SetDefaultBias(bias); xSpline->SetDefaultTension(tension); xSpline->SetDefaultContinuity(continuity);
-        ySpline->SetDefaultBias(bias); ySpline->SetDefaultTension(tension); ySpline->SetDefaultContinuity(continuity);
-        zSpline->SetDefaultBias(bias); zSpline->SetDefaultTension(tension); zSpline->SetDefaultContinuity(continuity);
+    SmoothingKernel kernel(GetFiberContainer(), m_FiberLengths, pointDistance, tension, continuity, bias);
+    ParallelFiberProcessor processor;
+    processor.SetNumberOfThreads(m_NumberOfThreads);
+    processor.Process(GetFiberContainer().GetNumFibers(), kernel);
 
-        vtkSmartPointer<vtkParametricSpline> spline = vtkSmartPointer<vtkParametricSpline>::New();
-        spline->SetXSpline(xSpline);
-        spline->SetYSpline(ySpline);
-        spline->SetZSpline(zSpline);
-        spline->SetPoints(newPoints);
-
-        vtkSmartPointer<vtkParametricFunctionSource> functionSource = vtkSmartPointer<vtkParametricFunctionSource>::New();
-        functionSource->SetParametricFunction(spline);
-        functionSource->SetUResolution(sampling);
-        functionSource->SetVResolution(sampling);
-        functionSource->SetWResolution(sampling);
-        functionSource->Update();
-
-        vtkPolyData* outputFunction = functionSource->GetOutput();
-        vtkPoints* tmpSmoothPnts = outputFunction->GetPoints(); //smoothPoints of current fiber
-
-        vtkSmartPointer<vtkPolyLine> smoothLine = vtkSmartPointer<vtkPolyLine>::New();
-        smoothLine->GetPointIds()->SetNumberOfIds(tmpSmoothPnts->GetNumberOfPoints());
-
-        for (int j=0; j<smoothLine->GetNumberOfPoints(); j++)
-        {
-            smoothLine->GetPointIds()->SetId(j, j+pointHelperCnt);
-            vtkSmoothPoints->InsertNextPoint(tmpSmoothPnts->GetPoint(j));
-        }
-        vtkSmoothCells->InsertNextCell(smoothLine);
-        pointHelperCnt += tmpSmoothPnts->GetNumberOfPoints();
-    }
-
-    m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-    m_FiberPolyData->SetPoints(vtkSmoothPoints);
-    m_FiberPolyData->SetLines(vtkSmoothCells);
+    m_FiberPolyData = processor.GetOutput();
     UpdateColorCoding();
     UpdateFiberGeometry();
     m_FiberSampling = 10/pointDistance;
@@ -1808,109 +2087,16 @@ unsigned long mitk::FiberBundleX::GetNumberOfPoints()
 
 void mitk::FiberBundleX::CompressFibers(float error)
 {
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
     MITK_INFO << "Compressing fibers";
-    unsigned long numRemovedPoints = 0;
-    boost::progress_display disp(m_FiberPolyData->GetNumberOfCells());
-    for (int i=0; i<m_FiberPolyData->GetNumberOfCells(); i++)
-    {
-        ++disp ;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        // calculate curvatures
-        std::vector< int > removedPoints; removedPoints.resize(numPoints, 0);
-        removedPoints[0]=-1; removedPoints[numPoints-1]=-1;
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-
-        bool pointFound = true;
-        while (pointFound)
-        {
-            pointFound = false;
-            double minError = error;
-            int removeIndex = -1;
-
-            for (int j=0; j<numPoints; j++)
-            {
-                if (removedPoints[j]==0)
-                {
-                    double cand[3];
-                    points->GetPoint(j, cand);
-                    vnl_vector_fixed< double, 3 > candV;
-                    candV[0]=cand[0]; candV[1]=cand[1]; candV[2]=cand[2];
-
-                    int validP = -1;
-                    vnl_vector_fixed< double, 3 > pred;
-                    for (int k=j-1; k>=0; k--)
-                        if (removedPoints[k]<=0)
-                        {
-                            double ref[3];
-                            points->GetPoint(k, ref);
-                            pred[0]=ref[0]; pred[1]=ref[1]; pred[2]=ref[2];
-                            validP = k;
-                            break;
-                        }
-                    int validS = -1;
-                    vnl_vector_fixed< double, 3 > succ;
-                    for (int k=j+1; k<numPoints; k++)
-                        if (removedPoints[k]<=0)
-                        {
-                            double ref[3];
-                            points->GetPoint(k, ref);
-                            succ[0]=ref[0]; succ[1]=ref[1]; succ[2]=ref[2];
-                            validS = k;
-                            break;
-                        }
-
-                    if (validP>=0 && validS>=0)
-                    {
-                        double a = (candV-pred).magnitude();
-                        double b = (candV-succ).magnitude();
-                        double c = (pred-succ).magnitude();
-                        double s=0.5*(a+b+c);
-                        double hc=(2.0/c)*sqrt(fabs(s*(s-a)*(s-b)*(s-c)));
-
-                        if (hc<minError)
-                        {
-                            removeIndex = j;
-                            minError = hc;
-                            pointFound = true;
-                        }
-                    }
-                }
-            }
-
-            if (pointFound)
-            {
-                removedPoints[removeIndex] = 1;
-                numRemovedPoints++;
-            }
-        }
+    CompressKernel kernel(GetFiberContainer(), error);
+    ParallelFiberProcessor processor;
+    processor.SetNumberOfThreads(m_NumberOfThreads);
+    processor.Process(GetFiberContainer().GetNumFibers(), kernel);
 
-        for (int j=0; j<numPoints; j++)
-        {
-            if (removedPoints[j]<=0)
-            {
-                double cand[3];
-                points->GetPoint(j, cand);
-                vtkIdType id = vtkNewPoints->InsertNextPoint(cand);
-                container->GetPointIds()->InsertNextId(id);
-            }
-        }
-
-        vtkNewCells->InsertNextCell(container);
-    }
-
-    if (vtkNewCells->GetNumberOfCells()>0)
+    if (processor.GetNumberOfOutputFibers()>0)
     {
-        MITK_INFO << "Removed points: " << numRemovedPoints;
-        m_FiberPolyData = vtkSmartPointer<vtkPolyData>::New();
-        m_FiberPolyData->SetPoints(vtkNewPoints);
-        m_FiberPolyData->SetLines(vtkNewCells);
+        MITK_INFO << "Removed points: " << GetFiberContainer().GetNumPoints()-processor.GetNumberOfOutputPoints();
+        m_FiberPolyData = processor.GetOutput();
 
         UpdateColorCoding();
         UpdateFiberGeometry();
@@ -1918,86 +2104,71 @@ void mitk::FiberBundleX::CompressFibers(float error)
 }
 
 // Resample fiber to get equidistant points
-void mitk::FiberBundleX::ResampleFibers(float pointDistance)
+void mitk::FiberBundleX::ResampleFiber(const float* points, unsigned int numPoints, float pointDistance, std::vector< float >& resampled)
 {
-    if (pointDistance<=0.00001)
+    if (numPoints<=0)
         return;
 
-    vtkSmartPointer<vtkPolyData> newPoly = vtkSmartPointer<vtkPolyData>::New();
-    vtkSmartPointer<vtkCellArray> newCellArray = vtkSmartPointer<vtkCellArray>::New();
-    vtkSmartPointer<vtkPoints>    newPoints = vtkSmartPointer<vtkPoints>::New();
+    resampled.insert(resampled.end(), points, points+3);
 
-    int numberOfLines = m_NumFibers;
+    float dtau = 0;
+    unsigned int cur_p = 1;
+    itk::Vector<float,3> dR;
+    float normdR = 0;
 
-    MITK_INFO << "Resampling fibers";
-    boost::progress_display disp(m_NumFibers);
-    for (int i=0; i<numberOfLines; i++)
+    for (;;)
     {
-        ++disp;
-        vtkCell* cell = m_FiberPolyData->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
-
-        double* point = points->GetPoint(0);
-        vtkIdType pointId = newPoints->InsertNextPoint(point);
-        container->GetPointIds()->InsertNextId(pointId);
-
-        float dtau = 0;
-        int cur_p = 1;
-        itk::Vector<float,3> dR;
-        float normdR = 0;
-
-        for (;;)
+        while (dtau <= pointDistance && cur_p < numPoints)
         {
-            while (dtau <= pointDistance && cur_p < numPoints)
-            {
-                itk::Vector<float,3> v1;
-                point = points->GetPoint(cur_p-1);
-                v1[0] = point[0];
-                v1[1] = point[1];
-                v1[2] = point[2];
-                itk::Vector<float,3> v2;
-                point = points->GetPoint(cur_p);
-                v2[0] = point[0];
-                v2[1] = point[1];
-                v2[2] = point[2];
-
-                dR  = v2 - v1;
-                normdR = std::sqrt(dR.GetSquaredNorm());
-                dtau += normdR;
-                cur_p++;
-            }
-
-            if (dtau >= pointDistance)
-            {
-                itk::Vector<float,3> v1;
-                point = points->GetPoint(cur_p-1);
-                v1[0] = point[0];
-                v1[1] = point[1];
-                v1[2] = point[2];
-
-                itk::Vector<float,3> v2 = v1 - dR*( (dtau-pointDistance)/normdR );
-                pointId = newPoints->InsertNextPoint(v2.GetDataPointer());
-                container->GetPointIds()->InsertNextId(pointId);
-            }
-            else
-            {
-                point = points->GetPoint(numPoints-1);
-                pointId = newPoints->InsertNextPoint(point);
-                container->GetPointIds()->InsertNextId(pointId);
-                break;
-            }
-            dtau = dtau-pointDistance;
+            itk::Vector<float,3> v1;
+            const float* point = points+3*(cur_p-1);
+            v1[0] = point[0];
+            v1[1] = point[1];
+            v1[2] = point[2];
+            itk::Vector<float,3> v2;
+            point = points+3*cur_p;
+            v2[0] = point[0];
+            v2[1] = point[1];
+            v2[2] = point[2];
+
+            dR  = v2 - v1;
+            normdR = std::sqrt(dR.GetSquaredNorm());
+            dtau += normdR;
+            cur_p++;
         }
 
-        newCellArray->InsertNextCell(container);
+        if (dtau >= pointDistance)
+        {
+            itk::Vector<float,3> v1;
+            const float* point = points+3*(cur_p-1);
+            v1[0] = point[0];
+            v1[1] = point[1];
+            v1[2] = point[2];
+
+            itk::Vector<float,3> v2 = v1 - dR*( (dtau-pointDistance)/normdR );
+            resampled.insert(resampled.end(), v2.GetDataPointer(), v2.GetDataPointer()+3);
+        }
+        else
+        {
+            resampled.insert(resampled.end(), points+3*(numPoints-1), points+3*numPoints);
+            break;
+        }
+        dtau = dtau-pointDistance;
     }
+}
+
+void mitk::FiberBundleX::ResampleFibers(float pointDistance)
+{
+    if (pointDistance<=0.00001)
+        return;
+
+    MITK_INFO << "Resampling fibers";
+    ResampleKernel kernel(GetFiberContainer(), pointDistance);
+    ParallelFiberProcessor processor;
+    processor.SetNumberOfThreads(m_NumberOfThreads);
+    processor.Process(GetFiberContainer().GetNumFibers(), kernel);
 
-    newPoly->SetPoints(newPoints);
-    newPoly->SetLines(newCellArray);
-    m_FiberPolyData = newPoly;
+    m_FiberPolyData = processor.GetOutput();
     UpdateFiberGeometry();
     UpdateColorCoding();
     m_FiberSampling = 10/pointDistance;
@@ -22,6 +22,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkBaseData.h>
 #include <MitkFiberTrackingExports.h>
 #include <mitkImage.h>
+#include <mitkFiberContainer.h>
 
 
 //includes storing fiberdata
@@ -75,6 +76,8 @@ public:
     // fiber smoothing/resampling
     void CompressFibers(float error = 0.0);
     void ResampleFibers(float pointDistance = 1);
+    /** Resamples a single fiber exactly like ResampleFibers(). The new points are appended to resampled (x,y,z triplets). */
+    static void ResampleFiber(const float* points, unsigned int numPoints, float pointDistance, std::vector< float >& resampled);
     void DoFiberSmoothing(float pointDistance);
     void DoFiberSmoothing(float pointDistance, double tension, double continuity, double bias );
     bool RemoveShortFibers(float lengthInMM);
@@ -104,6 +107,7 @@ public:
     // get/set data
     void SetFiberPolyData(vtkSmartPointer<vtkPolyData>, bool updateGeometry = true);
     vtkSmartPointer<vtkPolyData> GetFiberPolyData();
+    const FiberContainer& GetFiberContainer(); ///< compact copy of the fiber points with spatial index, rebuilt if the polydata changed
     std::vector< std::string > GetAvailableColorCodings();
     char* GetCurrentColorCoding();
     itkGetMacro( NumFibers, int)
@@ -113,6 +117,8 @@ public:
     itkGetMacro( MeanFiberLength, float )
     itkGetMacro( MedianFiberLength, float )
     itkGetMacro( LengthStDev, float )
+    itkSetMacro( NumberOfThreads, unsigned int )    ///< threads of the per-fiber operations, 0 uses the global default
+    itkGetMacro( NumberOfThreads, unsigned int )
     unsigned long GetNumberOfPoints();
 
     std::vector<int> GetPointsRoi()
@@ -136,6 +142,9 @@ protected:
 
     itk::Point<float, 3> GetItkPoint(double point[3]);
 
+    // polydata of the given fibers with the original fiber ids as cell data (FIBER_ID_ARRAY)
+    vtkSmartPointer<vtkPolyData> GeneratePolyDataWithFiberIds(const std::vector< unsigned int >& fiberIds);
+
     // calculate geometry from fiber extent
     void UpdateFiberGeometry();
 
@@ -150,6 +159,11 @@ private:
     // contains fiber ids
     vtkSmartPointer<vtkDataSet>   m_FiberIdDataSet;
 
+    // structure-of-arrays copy of m_FiberPolyData used by the spatial queries
+    FiberContainer  m_FiberContainer;
+    vtkPolyData*    m_FiberContainerPolyData;
+    unsigned long   m_FiberContainerTime;
+
     char* m_CurrentColorCoding;
     int   m_NumFibers;
 
@@ -160,6 +174,7 @@ private:
     float   m_MedianFiberLength;
     float   m_LengthStDev;
     int     m_FiberSampling;
+    unsigned int m_NumberOfThreads;
 
     std::vector<int> m_PointsRoi; // this global variable needs to be refactored
 
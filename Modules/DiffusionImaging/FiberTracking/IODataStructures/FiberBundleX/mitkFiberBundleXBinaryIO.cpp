@@ -0,0 +1,249 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberBundleXBinaryIO.h"
+
+#include <mitkMemoryMappedFile.h>
+#include <mitkException.h>
+#include <itkIntTypes.h>
+#include <itksys/SystemTools.hxx>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <vector>
+
+const char* mitk::FiberBundleXBinaryIO::FILE_EXTENSION = ".bfib";
+
+namespace
+{
+const char Magic[8] = "MITKFIB";
+const itk::uint32_t Version = 1;
+
+// fibers per mapped part of the offset table, points per written chunk
+const itk::uint64_t FibersPerChunk = 65536;
+const itk::uint64_t PointsPerChunk = 1048576;
+
+struct BinaryHeader
+{
+    char            Magic[8];
+    itk::uint32_t   Version;
+    itk::uint32_t   Reserved;
+    itk::uint64_t   NumFibers;
+    itk::uint64_t   NumPoints;
+};
+
+void ReportProgress(itk::ProcessObject* progress, float value)
+{
+    if (progress!=NULL)
+        progress->UpdateProgress(value);
+}
+
+bool ReadHeader(const std::string& fileName, BinaryHeader& header)
+{
+    std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader)))
+        return false;
+    return memcmp(header.Magic, Magic, sizeof(Magic))==0;
+}
+
+/** Maps the offsets of the fibers first..last (inclusive) */
+const itk::uint64_t* MapOffsets(mitk::MemoryMappedFile* mappedFile, const std::string& fileName, itk::uint64_t first, itk::uint64_t last)
+{
+    if (!mappedFile->Map(fileName, sizeof(BinaryHeader)+first*sizeof(itk::uint64_t), (last-first+1)*sizeof(itk::uint64_t)))
+        mitkThrow() << "Could not map the fiber offsets of " << fileName;
+    return static_cast<const itk::uint64_t*>(mappedFile->GetData());
+}
+}
+
+bool mitk::FiberBundleXBinaryIO::CanReadFile(const std::string& fileName)
+{
+    BinaryHeader header;
+    return ReadHeader(fileName, header);
+}
+
+void mitk::FiberBundleXBinaryIO::Write(const std::string& fileName, FiberBundleX* fib, itk::ProcessObject* progress)
+{
+    if (fib==NULL)
+        mitkThrow() << "No fiber bundle to write";
+
+    std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+        mitkThrow() << "Could not open " << fileName << " for writing";
+
+    vtkPolyData* polyData = fib->GetFiberPolyData();
+    vtkCellArray* lines = polyData->GetLines();
+
+    BinaryHeader header;
+    memset(&header, 0, sizeof(BinaryHeader));
+    memcpy(header.Magic, Magic, sizeof(Magic));
+    header.Version = Version;
+    header.NumFibers = lines!=NULL ? lines->GetNumberOfCells() : 0;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));   // number of points is written at the end
+
+    vtkIdType numPoints;
+    vtkIdType* pointIds;
+
+    // offset table
+    std::vector< itk::uint64_t > offsets;
+    offsets.reserve(FibersPerChunk+1);
+    itk::uint64_t numWrittenPoints = 0;
+    if (lines!=NULL)
+    {
+        lines->InitTraversal();
+        while (lines->GetNextCell(numPoints, pointIds))
+        {
+            offsets.push_back(numWrittenPoints);
+            numWrittenPoints += numPoints;
+            if (offsets.size()==FibersPerChunk)
+            {
+                file.write(reinterpret_cast<const char*>(&offsets[0]), offsets.size()*sizeof(itk::uint64_t));
+                offsets.clear();
+            }
+        }
+    }
+    offsets.push_back(numWrittenPoints);
+    file.write(reinterpret_cast<const char*>(&offsets[0]), offsets.size()*sizeof(itk::uint64_t));
+    header.NumPoints = numWrittenPoints;
+
+    // points
+    std::vector< float > points;
+    points.reserve(3*PointsPerChunk+3);
+    itk::uint64_t numFlushedPoints = 0;
+    if (lines!=NULL)
+    {
+        lines->InitTraversal();
+        while (lines->GetNextCell(numPoints, pointIds))
+        {
+            for (vtkIdType j=0; j<numPoints; j++)
+            {
+                double p[3];
+                polyData->GetPoint(pointIds[j], p);
+                points.push_back(p[0]);
+                points.push_back(p[1]);
+                points.push_back(p[2]);
+                if (points.size()>=3*PointsPerChunk)
+                {
+                    file.write(reinterpret_cast<const char*>(&points[0]), points.size()*sizeof(float));
+                    numFlushedPoints += points.size()/3;
+                    points.clear();
+                    ReportProgress(progress, (float)numFlushedPoints/header.NumPoints);
+                }
+            }
+        }
+    }
+    if (!points.empty())
+        file.write(reinterpret_cast<const char*>(&points[0]), points.size()*sizeof(float));
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+    file.close();
+    if (file.fail())
+        mitkThrow() << "Error while writing " << fileName;
+    ReportProgress(progress, 1.0);
+}
+
+vtkSmartPointer<vtkPolyData> mitk::FiberBundleXBinaryIO::Read(const std::string& fileName, unsigned int fiberStride, itk::ProcessObject* progress)
+{
+    fiberStride = std::max(1u, fiberStride);
+
+    BinaryHeader header;
+    if (!ReadHeader(fileName, header))
+        mitkThrow() << fileName << " is not a binary fiber bundle file";
+    if (header.Version!=Version)
+        mitkThrow() << "Unsupported version " << header.Version << " of binary fiber bundle file " << fileName;
+
+    itk::uint64_t fileSize = itksys::SystemTools::FileLength(fileName.c_str());
+    itk::uint64_t numFibers = header.NumFibers;
+    itk::uint64_t numPoints = header.NumPoints;
+    if (numFibers>=fileSize/sizeof(itk::uint64_t) || numPoints>fileSize/(3*sizeof(float))
+            || fileSize!=sizeof(BinaryHeader)+(numFibers+1)*sizeof(itk::uint64_t)+numPoints*3*sizeof(float))
+        mitkThrow() << "Binary fiber bundle file " << fileName << " is corrupt (unexpected file size)";
+    const itk::uint64_t pointsStart = sizeof(BinaryHeader)+(numFibers+1)*sizeof(itk::uint64_t);
+
+    mitk::MemoryMappedFile::Pointer mappedOffsets = mitk::MemoryMappedFile::New();
+    mitk::MemoryMappedFile::Pointer mappedPoints = mitk::MemoryMappedFile::New();
+
+    // first pass over the offset table: check it and count the points of the selected fibers
+    itk::uint64_t numSelectedFibers = 0;
+    itk::uint64_t numSelectedPoints = 0;
+    for (itk::uint64_t first=0; first<numFibers; first+=FibersPerChunk)
+    {
+        itk::uint64_t last = std::min(numFibers, first+FibersPerChunk);
+        const itk::uint64_t* offsets = MapOffsets(mappedOffsets, fileName, first, last);
+        for (itk::uint64_t i=first; i<last; i++)
+        {
+            if (offsets[i-first]>offsets[i-first+1] || offsets[i-first+1]>numPoints)
+                mitkThrow() << "Binary fiber bundle file " << fileName << " is corrupt (invalid offset of fiber " << i << ")";
+            if (i%fiberStride==0)
+            {
+                numSelectedFibers++;
+                numSelectedPoints += offsets[i-first+1]-offsets[i-first];
+            }
+        }
+        ReportProgress(progress, 0.1*last/numFibers);
+    }
+
+    vtkSmartPointer<vtkFloatArray> coordinates = vtkSmartPointer<vtkFloatArray>::New();
+    coordinates->SetNumberOfComponents(3);
+    coordinates->SetNumberOfTuples(numSelectedPoints);
+    vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    connectivity->SetNumberOfValues(numSelectedFibers+numSelectedPoints);
+
+    // second pass: copy the points of the selected fibers, one part of the file at a time
+    float* coordinatePointer = coordinates->GetPointer(0);
+    vtkIdType* connectivityPointer = connectivity->GetPointer(0);
+    vtkIdType pointId = 0;
+    for (itk::uint64_t first=0; first<numFibers; first+=FibersPerChunk)
+    {
+        itk::uint64_t last = std::min(numFibers, first+FibersPerChunk);
+        const itk::uint64_t* offsets = MapOffsets(mappedOffsets, fileName, first, last);
+
+        const float* points = NULL;
+        itk::uint64_t chunkPoints = offsets[last-first]-offsets[0];
+        if (chunkPoints>0)
+        {
+            if (!mappedPoints->Map(fileName, pointsStart+offsets[0]*3*sizeof(float), chunkPoints*3*sizeof(float)))
+                mitkThrow() << "Could not map the fiber points of " << fileName;
+            points = static_cast<const float*>(mappedPoints->GetData());
+        }
+
+        for (itk::uint64_t i=(first+fiberStride-1)/fiberStride*fiberStride; i<last; i+=fiberStride)
+        {
+            itk::uint64_t n = offsets[i-first+1]-offsets[i-first];
+            if (n>0)
+                memcpy(coordinatePointer+3*pointId, points+3*(offsets[i-first]-offsets[0]), n*3*sizeof(float));
+            *connectivityPointer++ = n;
+            for (itk::uint64_t j=0; j<n; j++)
+                *connectivityPointer++ = pointId++;
+        }
+        ReportProgress(progress, 0.1+0.9*last/numFibers);
+    }
+
+    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
+    vtkNewPoints->SetData(coordinates);
+    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    vtkNewCells->SetCells(numSelectedFibers, connectivity);
+
+    vtkSmartPointer<vtkPolyData> fiberPolyData = vtkSmartPointer<vtkPolyData>::New();
+    fiberPolyData->SetPoints(vtkNewPoints);
+    fiberPolyData->SetLines(vtkNewCells);
+    ReportProgress(progress, 1.0);
+    return fiberPolyData;
+}
@@ -0,0 +1,70 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef _MITK_FiberBundleXBinaryIO_H
+#define _MITK_FiberBundleXBinaryIO_H
+
+#include <MitkFiberTrackingExports.h>
+#include <mitkFiberBundleX.h>
+#include <itkProcessObject.h>
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <string>
+
+namespace mitk {
+
+/**
+   * \brief Reads and writes fiber bundles in a simple binary format (.bfib) that can be loaded without parsing.
+   *
+   * Layout (native byte order):
+   *   char     magic[8]                    "MITKFIB"
+   *   uint32   version                     1
+   *   uint32   reserved                    0
+   *   uint64   number of fibers N
+   *   uint64   number of points M
+   *   uint64   offsets[N+1]                index of the first point of each fiber, offsets[N] = M
+   *   float    points[3*M]                 x,y,z interleaved, the points of a fiber are contiguous
+   *
+   * The writer streams the fibers in chunks, the reader maps one chunk of the file at a time, so apart from the
+   * resulting polydata the memory needed does not depend on the size of the file. The reader can skip fibers
+   * to quickly preview large tractograms.
+   */
+class MitkFiberTracking_EXPORT FiberBundleXBinaryIO
+{
+public:
+
+    static const char* FILE_EXTENSION;
+
+    /** True if the file starts with the magic string of the format. */
+    static bool CanReadFile(const std::string& fileName);
+
+    /** Writes all fibers of the bundle. Throws an mitk::Exception if the file can not be written.
+     *  The progress of the writing is reported to the process object, if given. */
+    static void Write(const std::string& fileName, FiberBundleX* fib, itk::ProcessObject* progress=NULL);
+
+    /** Reads every fiberStride-th fiber of the file. Throws an mitk::Exception if the file can not be read or is corrupt.
+     *  The progress of the reading is reported to the process object, if given. */
+    static vtkSmartPointer<vtkPolyData> Read(const std::string& fileName, unsigned int fiberStride=1, itk::ProcessObject* progress=NULL);
+
+private:
+
+    FiberBundleXBinaryIO(); // static methods only
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_FiberBundleXBinaryIO_H */
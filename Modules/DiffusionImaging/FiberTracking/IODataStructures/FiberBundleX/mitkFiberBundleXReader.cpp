@@ -26,10 +26,16 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <tinyxml.h>
 #include <vtkCleanPolyData.h>
 #include <mitkTrackvis.h>
+#include <mitkFiberBundleXBinaryIO.h>
 
 namespace mitk
 {
 
+FiberBundleXReader::FiberBundleXReader()
+    : m_FiberStride(1)
+{
+}
+
 void FiberBundleXReader
 ::GenerateData()
 {
@@ -66,11 +72,22 @@ void FiberBundleXReader::GenerateOutputInformation()
             m_OutputCache = OutputType::New();
             TrackVis trk;
             trk.open(m_FileName);
-            trk.read(m_OutputCache);
+            trk.read(m_OutputCache, m_FiberStride, this);
+            setlocale(LC_ALL, currLocale.c_str());
             MITK_INFO << "... done";
             return;
         }
 
+        if (ext==FiberBundleXBinaryIO::FILE_EXTENSION || FiberBundleXBinaryIO::CanReadFile(m_FileName))
+        {
+            MITK_INFO << "Reading binary fiber bundle";
+            vtkSmartPointer<vtkPolyData> fiberPolyData = FiberBundleXBinaryIO::Read(m_FileName, m_FiberStride, this);
+            m_OutputCache = OutputType::New(fiberPolyData);
+            setlocale(LC_ALL, currLocale.c_str());
+            MITK_INFO << "Fiber bundle read";
+            return;
+        }
+
         vtkSmartPointer<vtkDataReader> chooser=vtkSmartPointer<vtkDataReader>::New();
         chooser->SetFileName(m_FileName.c_str() );
         if( chooser->IsFilePolyData())
@@ -84,6 +101,13 @@ void FiberBundleXReader::GenerateOutputInformation()
             {
                 vtkSmartPointer<vtkPolyData> fiberPolyData = reader->GetOutput();
                 m_OutputCache = OutputType::New(fiberPolyData);
+                if (m_FiberStride>1)
+                {
+                    std::vector<long> fiberIds;
+                    for (long i=0; i<m_OutputCache->GetNumFibers(); i+=m_FiberStride)
+                        fiberIds.push_back(i);
+                    m_OutputCache = OutputType::New(m_OutputCache->GeneratePolyDataByIds(fiberIds));
+                }
             }
         }
         else // try to read deprecated fiber bundle file format
@@ -276,7 +300,7 @@ bool FiberBundleXReader
     std::string ext = itksys::SystemTools::GetFilenameLastExtension(filename);
     ext = itksys::SystemTools::LowerCase(ext);
 
-    if (ext == ".fib" || ext == ".trk")
+    if (ext == ".fib" || ext == ".trk" || ext == FiberBundleXBinaryIO::FILE_EXTENSION)
     {
         return true;
     }
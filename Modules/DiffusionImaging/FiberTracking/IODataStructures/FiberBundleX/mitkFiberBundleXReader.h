@@ -51,6 +51,10 @@ namespace mitk
 
     static bool CanReadFile(const std::string filename, const std::string filePrefix, const std::string filePattern);
 
+    /** Only every n-th fiber is loaded (default 1), e.g. to quickly preview large tractograms. */
+    itkSetMacro( FiberStride, unsigned int )
+    itkGetMacro( FiberStride, unsigned int )
+
 //    itkGetMacro(GroupFiberBundleX, FiberGroupType::Pointer);
 //    itkGetMacro(TractContainer, ContainerType::Pointer);
 
@@ -62,6 +66,8 @@ namespace mitk
 
   protected:
 
+    FiberBundleXReader();
+
     /** Does the real work. */
     virtual void GenerateData();
     virtual void GenerateOutputInformation();
@@ -71,7 +77,7 @@ namespace mitk
     std::string m_FileName;
     std::string m_FilePrefix;
     std::string m_FilePattern;
-
+    unsigned int m_FiberStride;
 
   private:
     void operator=(const Self&); //purposely not implemented
@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkCleanPolyData.h>
 #include <itksys/SystemTools.hxx>
 #include <mitkTrackvis.h>
+#include <mitkFiberBundleXBinaryIO.h>
 #include <itkSize.h>
 
 mitk::FiberBundleXWriter::FiberBundleXWriter()
@@ -92,6 +93,11 @@ void mitk::FiberBundleXWriter::GenerateData()
         trk.writeHdr();
         trk.append(input);
     }
+    else if (ext==FiberBundleXBinaryIO::FILE_EXTENSION)
+    {
+        MITK_INFO << "Writing fiber bundle as binary fiber bundle";
+        FiberBundleXBinaryIO::Write(m_FileName, input, this);
+    }
 
     setlocale(LC_ALL, currLocale.c_str());
     m_Success = true;
@@ -131,5 +137,6 @@ std::vector<std::string> mitk::FiberBundleXWriter::GetPossibleFileExtensions()
   possibleFileExtensions.push_back(".vtk");
   possibleFileExtensions.push_back(".avtk");
   possibleFileExtensions.push_back(".trk");
+  possibleFileExtensions.push_back(FiberBundleXBinaryIO::FILE_EXTENSION);
   return possibleFileExtensions;
 }
@@ -117,7 +117,7 @@ public:
 
     // FileWriterWithInformation methods
     virtual const char * GetDefaultFilename() { return "FiberBundle.fib"; }
-    virtual const char * GetFileDialogPattern() { return "Fiber Bundle (*.fib *.vtk *.trk *.afib *.avtk)"; }
+    virtual const char * GetFileDialogPattern() { return "Fiber Bundle (*.fib *.vtk *.trk *.afib *.avtk *.bfib)"; }
     virtual const char * GetDefaultExtension() { return ".fib"; }
     virtual bool CanWriteBaseDataType(BaseData::Pointer data) { return (dynamic_cast<mitk::FiberBundleX*>(data.GetPointer()) != NULL); };
     virtual void DoWrite(BaseData::Pointer data) {
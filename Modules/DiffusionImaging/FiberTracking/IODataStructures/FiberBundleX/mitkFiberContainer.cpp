@@ -0,0 +1,251 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkFiberContainer.h"
+
+#include <vtkCellArray.h>
+#include <itkMutexLockHolder.h>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// maximum number of grid cells along the longest axis of the bundle
+const int MaxGridCellsPerAxis = 64;
+}
+
+mitk::FiberContainer::FiberContainer()
+    : m_CellSize(1)
+{
+    for (int i=0; i<3; i++)
+    {
+        m_GridOrigin[i] = 0;
+        m_GridSize[i] = 0;
+    }
+}
+
+mitk::FiberContainer::FiberContainer(const FiberContainer& other)
+    : m_Points(other.m_Points)
+    , m_FiberOffsets(other.m_FiberOffsets)
+    , m_FiberBounds(other.m_FiberBounds)
+    , m_CellSize(1)
+{
+    for (int i=0; i<3; i++)
+    {
+        m_GridOrigin[i] = 0;
+        m_GridSize[i] = 0;
+    }
+}
+
+mitk::FiberContainer& mitk::FiberContainer::operator=(const FiberContainer& other)
+{
+    if (this!=&other)
+    {
+        Clear();
+        m_Points = other.m_Points;
+        m_FiberOffsets = other.m_FiberOffsets;
+        m_FiberBounds = other.m_FiberBounds;
+    }
+    return *this;
+}
+
+void mitk::FiberContainer::Clear()
+{
+    m_Points.clear();
+    m_FiberOffsets.clear();
+    m_FiberBounds.clear();
+    m_CellOffsets.clear();
+    m_CellFibers.clear();
+    m_GridValid.Set(0);
+}
+
+void mitk::FiberContainer::Initialize(vtkPolyData* fiberPolyData)
+{
+    Clear();
+    if (fiberPolyData==NULL || fiberPolyData->GetLines()==NULL)
+        return;
+
+    vtkCellArray* lines = fiberPolyData->GetLines();
+    m_Points.reserve(3*fiberPolyData->GetNumberOfPoints());
+    m_FiberOffsets.reserve(lines->GetNumberOfCells()+1);
+    m_FiberBounds.reserve(6*lines->GetNumberOfCells());
+
+    vtkIdType numPoints;
+    vtkIdType* pointIds;
+    lines->InitTraversal();
+    while (lines->GetNextCell(numPoints, pointIds))
+    {
+        m_FiberOffsets.push_back(m_Points.size()/3);
+
+        float bounds[6] = {0, 0, 0, 0, 0, 0};
+        for (vtkIdType j=0; j<numPoints; j++)
+        {
+            double p[3];
+            fiberPolyData->GetPoint(pointIds[j], p);
+            for (int k=0; k<3; k++)
+            {
+                float c = p[k];
+                m_Points.push_back(c);
+                if (j==0 || c<bounds[2*k])
+                    bounds[2*k] = c;
+                if (j==0 || c>bounds[2*k+1])
+                    bounds[2*k+1] = c;
+            }
+        }
+        m_FiberBounds.insert(m_FiberBounds.end(), bounds, bounds+6);
+    }
+    m_FiberOffsets.push_back(m_Points.size()/3);
+}
+
+void mitk::FiberContainer::GetCellIndex(const float* point, int index[3]) const
+{
+    for (int k=0; k<3; k++)
+    {
+        index[k] = (int)std::floor((point[k]-m_GridOrigin[k])/m_CellSize);
+        index[k] = std::max(0, std::min(m_GridSize[k]-1, index[k]));
+    }
+}
+
+void mitk::FiberContainer::BuildGrid() const
+{
+    m_CellOffsets.clear();
+    m_CellFibers.clear();
+
+    unsigned int numFibers = GetNumFibers();
+    if (GetNumPoints()==0)
+    {
+        for (int k=0; k<3; k++)
+            m_GridSize[k] = 0;
+        return;
+    }
+
+    // grid covers the bounding box of all fibers
+    float bounds[6];
+    for (int k=0; k<3; k++)
+    {
+        bounds[2*k] = m_Points[k];
+        bounds[2*k+1] = m_Points[k];
+    }
+    for (unsigned int i=0; i<numFibers; i++)
+    {
+        if (GetNumPoints(i)==0)
+            continue;
+        const float* b = GetFiberBounds(i);
+        for (int k=0; k<3; k++)
+        {
+            bounds[2*k] = std::min(bounds[2*k], b[2*k]);
+            bounds[2*k+1] = std::max(bounds[2*k+1], b[2*k+1]);
+        }
+    }
+
+    float extent = std::max(bounds[1]-bounds[0], std::max(bounds[3]-bounds[2], bounds[5]-bounds[4]));
+    m_CellSize = std::max(extent/MaxGridCellsPerAxis, 0.001f);
+    unsigned long numCells = 1;
+    for (int k=0; k<3; k++)
+    {
+        m_GridOrigin[k] = bounds[2*k];
+        m_GridSize[k] = std::max(1, (int)std::ceil((bounds[2*k+1]-bounds[2*k])/m_CellSize));
+        numCells *= m_GridSize[k];
+    }
+
+    // two passes over all segments: count the fibers per cell, then fill the cells. Each fiber is listed once per cell.
+    std::vector< long > lastFiber(numCells);
+    m_CellOffsets.assign(numCells+1, 0);
+    for (int pass=0; pass<2; pass++)
+    {
+        std::fill(lastFiber.begin(), lastFiber.end(), -1);
+        std::vector< unsigned long > fillPosition;
+        if (pass==1)
+        {
+            for (unsigned long c=0; c<numCells; c++)
+                m_CellOffsets[c+1] += m_CellOffsets[c];
+            m_CellFibers.resize(m_CellOffsets[numCells]);
+            fillPosition.assign(m_CellOffsets.begin(), m_CellOffsets.end()-1);
+        }
+
+        for (unsigned int i=0; i<numFibers; i++)
+        {
+            unsigned int numPoints = GetNumPoints(i);
+            for (unsigned int j=0; j<numPoints; j++)
+            {
+                // cells overlapping the bounding box of segment j -> j+1 (or of the single point)
+                int index1[3], index2[3];
+                GetCellIndex(GetPoint(i, j), index1);
+                GetCellIndex(GetPoint(i, std::min(j+1, numPoints-1)), index2);
+                for (int z=std::min(index1[2], index2[2]); z<=std::max(index1[2], index2[2]); z++)
+                    for (int y=std::min(index1[1], index2[1]); y<=std::max(index1[1], index2[1]); y++)
+                        for (int x=std::min(index1[0], index2[0]); x<=std::max(index1[0], index2[0]); x++)
+                        {
+                            unsigned long c = ((unsigned long)z*m_GridSize[1]+y)*m_GridSize[0]+x;
+                            if (lastFiber[c]==(long)i)
+                                continue;
+                            lastFiber[c] = i;
+                            if (pass==0)
+                                m_CellOffsets[c+1]++;
+                            else
+                                m_CellFibers[fillPosition[c]++] = i;
+                        }
+            }
+        }
+    }
+}
+
+std::vector< unsigned int > mitk::FiberContainer::GetFibersInBox(const double bounds[6]) const
+{
+    if (m_GridValid.Get()==0)
+    {
+        // several threads may query first, only one of them builds the grid
+        itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_GridMutex);
+        if (m_GridValid.Get()==0)
+        {
+            BuildGrid();
+            m_GridValid.Set(1);
+        }
+    }
+
+    std::vector< unsigned int > fibers;
+    if (m_CellOffsets.empty())
+        return fibers;
+
+    // box does not overlap the grid
+    for (int k=0; k<3; k++)
+        if (bounds[2*k+1]<m_GridOrigin[k] || bounds[2*k]>m_GridOrigin[k]+m_GridSize[k]*m_CellSize)
+            return fibers;
+
+    float lower[3] = { (float)bounds[0], (float)bounds[2], (float)bounds[4] };
+    float upper[3] = { (float)bounds[1], (float)bounds[3], (float)bounds[5] };
+    int index1[3], index2[3];
+    GetCellIndex(lower, index1);
+    GetCellIndex(upper, index2);
+
+    for (int z=index1[2]; z<=index2[2]; z++)
+        for (int y=index1[1]; y<=index2[1]; y++)
+            for (int x=index1[0]; x<=index2[0]; x++)
+            {
+                unsigned long c = ((unsigned long)z*m_GridSize[1]+y)*m_GridSize[0]+x;
+                for (unsigned long n=m_CellOffsets[c]; n<m_CellOffsets[c+1]; n++)
+                {
+                    // the cells are coarse, the fiber bounds remove most false candidates
+                    const float* b = GetFiberBounds(m_CellFibers[n]);
+                    if (b[0]<=bounds[1] && b[1]>=bounds[0] && b[2]<=bounds[3] && b[3]>=bounds[2] && b[4]<=bounds[5] && b[5]>=bounds[4])
+                        fibers.push_back(m_CellFibers[n]);
+                }
+            }
+
+    std::sort(fibers.begin(), fibers.end());
+    fibers.erase(std::unique(fibers.begin(), fibers.end()), fibers.end());
+    return fibers;
+}
@@ -0,0 +1,87 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef _MITK_FiberContainer_H
+#define _MITK_FiberContainer_H
+
+#include <MitkFiberTrackingExports.h>
+#include <mitkAtomicInteger.h>
+#include <vtkPolyData.h>
+#include <itkSimpleFastMutexLock.h>
+#include <vector>
+
+namespace mitk {
+
+/**
+   * \brief Compact structure-of-arrays copy of the fiber geometry of a vtkPolyData.
+   *
+   * All fiber points are stored in one contiguous float array (x,y,z interleaved), the fibers are given by offsets into this array.
+   * For each fiber the axis aligned bounding box is stored. A uniform grid over the fiber segments (built on first use) lists
+   * the fibers passing each grid cell and allows fast conservative spatial queries. Queries may run concurrently, the first
+   * one builds the grid while the others wait for it.
+   * The container is a snapshot of the polydata and has to be rebuilt if the polydata changes (see FiberBundleX::GetFiberContainer()).
+   */
+class MitkFiberTracking_EXPORT FiberContainer
+{
+public:
+
+    FiberContainer();
+    FiberContainer(const FiberContainer& other);                ///< copies the fibers, the grid of the copy is built on its first query
+    FiberContainer& operator=(const FiberContainer& other);
+
+    /** Copies the points of all lines of the polydata. */
+    void Initialize(vtkPolyData* fiberPolyData);
+    void Clear();
+
+    unsigned int GetNumFibers() const { return m_FiberOffsets.empty() ? 0 : m_FiberOffsets.size()-1; }
+    unsigned long GetNumPoints() const { return m_Points.size()/3; }
+    unsigned int GetNumPoints(unsigned int fiber) const { return m_FiberOffsets[fiber+1]-m_FiberOffsets[fiber]; }
+
+    /** Pointer to the coordinates of the first point of the fiber, the points of a fiber are contiguous. */
+    const float* GetFiberPoints(unsigned int fiber) const { return &m_Points[3*m_FiberOffsets[fiber]]; }
+    const float* GetPoint(unsigned int fiber, unsigned int point) const { return &m_Points[3*(m_FiberOffsets[fiber]+point)]; }
+
+    /** Bounding box of the fiber (xmin, xmax, ymin, ymax, zmin, zmax). */
+    const float* GetFiberBounds(unsigned int fiber) const { return &m_FiberBounds[6*fiber]; }
+
+    /** Sorted ids of all fibers with a segment that may intersect the box (xmin, xmax, ymin, ymax, zmin, zmax). Never misses a fiber. */
+    std::vector< unsigned int > GetFibersInBox(const double bounds[6]) const;
+
+protected:
+
+    void BuildGrid() const;     ///< called with m_GridMutex locked
+    void GetCellIndex(const float* point, int index[3]) const;
+
+private:
+
+    std::vector< float >            m_Points;           ///< x,y,z of all points
+    std::vector< unsigned long >    m_FiberOffsets;     ///< first point of each fiber, m_FiberOffsets[GetNumFibers()] is the number of points
+    std::vector< float >            m_FiberBounds;      ///< six values per fiber
+
+    // uniform grid over the segments, fibers per cell in compressed row storage
+    mutable mitk::AtomicInteger             m_GridValid;        ///< 1 after the grid is built, read without the lock
+    mutable itk::SimpleFastMutexLock        m_GridMutex;        ///< serializes building the grid
+    mutable float                           m_GridOrigin[3];
+    mutable float                           m_CellSize;
+    mutable int                             m_GridSize[3];
+    mutable std::vector< unsigned long >    m_CellOffsets;
+    mutable std::vector< unsigned int >     m_CellFibers;
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_FiberContainer_H */
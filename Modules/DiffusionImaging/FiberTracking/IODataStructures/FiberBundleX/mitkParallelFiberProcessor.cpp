@@ -0,0 +1,167 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkParallelFiberProcessor.h"
+
+#include <mitkAtomicInteger.h>
+#include <mitkException.h>
+#include <itkSimpleFastMutexLock.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkCellArray.h>
+#include <vtkPoints.h>
+#include <algorithm>
+#include <cstring>
+
+struct mitk::ParallelFiberProcessor::Jobs
+{
+    Jobs() : Kernel(NULL), Blocks(NULL), NumFibers(0), Failed(false) {}
+
+    FiberKernel*                    Kernel;
+    std::vector< FiberBuffer >*     Blocks;
+    unsigned int                    NumFibers;
+    mitk::AtomicInteger             NextBlock;
+    mitk::AtomicInteger             NextThreadId;
+    itk::SimpleFastMutexLock        Mutex;          ///< guards the error message
+    std::string                     ErrorMessage;   ///< error of the first failed thread, thrown by Process()
+    volatile bool                   Failed;         ///< set if a thread failed, the others stop after their current block
+
+    void SetError(const std::string& message)
+    {
+        Mutex.Lock();
+        if (ErrorMessage.empty())
+            ErrorMessage = message;
+        Failed = true;
+        Mutex.Unlock();
+    }
+};
+
+mitk::ParallelFiberProcessor::ParallelFiberProcessor()
+    : m_NumberOfThreads(0)
+{
+}
+
+void mitk::ParallelFiberProcessor::Process(unsigned int numFibers, FiberKernel& kernel)
+{
+    m_Blocks.clear();
+    m_Blocks.resize((numFibers+BlockSize-1)/BlockSize);
+
+    unsigned int numThreads = m_NumberOfThreads>0 ? m_NumberOfThreads : itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+    numThreads = std::max(1u, std::min(numThreads, (unsigned int)m_Blocks.size()));
+    kernel.Initialize(numThreads);
+
+    Jobs jobs;
+    jobs.Kernel = &kernel;
+    jobs.Blocks = &m_Blocks;
+    jobs.NumFibers = numFibers;
+
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(numThreads);
+    threader->SetSingleMethod(ProcessCallback, &jobs);
+    threader->SingleMethodExecute();
+
+    if (jobs.Failed)
+    {
+        m_Blocks.clear();
+        mitkThrow() << "Fiber processing failed: " << jobs.ErrorMessage;
+    }
+}
+
+ITK_THREAD_RETURN_TYPE mitk::ParallelFiberProcessor::ProcessCallback(void* arg)
+{
+    Jobs* jobs = static_cast< Jobs* >( static_cast< itk::MultiThreader::ThreadInfoStruct* >(arg)->UserData );
+    std::vector< FiberBuffer >& blocks = *jobs->Blocks;
+
+    // the thread ids of the multithreader are not guaranteed to be dense, the kernel gets its own ones
+    unsigned int threadId = jobs->NextThreadId.Increment()-1;
+    try
+    {
+        for (long b=jobs->NextBlock.Increment()-1; b<(long)blocks.size() && !jobs->Failed; b=jobs->NextBlock.Increment()-1)
+        {
+            unsigned int last = std::min(jobs->NumFibers, (unsigned int)(b+1)*BlockSize);
+            for (unsigned int i=b*BlockSize; i<last; i++)
+                jobs->Kernel->ProcessFiber(i, threadId, blocks[b]);
+            blocks[b].DiscardFiber();   // points not assigned to a fiber
+        }
+    }
+    catch (std::exception& e)
+    {
+        jobs->SetError(e.what());
+    }
+    catch (...)
+    {
+        // nothing may escape the thread, Process() throws on the calling thread instead
+        jobs->SetError("Unknown error in the fiber kernel");
+    }
+    return ITK_THREAD_RETURN_VALUE;
+}
+
+unsigned long mitk::ParallelFiberProcessor::GetNumberOfOutputPoints() const
+{
+    unsigned long numPoints = 0;
+    for (unsigned int b=0; b<m_Blocks.size(); b++)
+        numPoints += m_Blocks[b].GetNumPoints();
+    return numPoints;
+}
+
+unsigned int mitk::ParallelFiberProcessor::GetNumberOfOutputFibers() const
+{
+    unsigned int numFibers = 0;
+    for (unsigned int b=0; b<m_Blocks.size(); b++)
+        numFibers += m_Blocks[b].GetNumFibers();
+    return numFibers;
+}
+
+vtkSmartPointer<vtkPolyData> mitk::ParallelFiberProcessor::GetOutput() const
+{
+    unsigned long numPoints = GetNumberOfOutputPoints();
+    unsigned int numFibers = GetNumberOfOutputFibers();
+
+    // coordinates and connectivity (number of points followed by the point ids) are written directly into the vtk arrays
+    vtkSmartPointer<vtkFloatArray> coordinates = vtkSmartPointer<vtkFloatArray>::New();
+    coordinates->SetNumberOfComponents(3);
+    coordinates->SetNumberOfTuples(numPoints);
+    vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    connectivity->SetNumberOfValues(numFibers+numPoints);
+
+    float* coordinatePointer = coordinates->GetPointer(0);
+    vtkIdType* connectivityPointer = connectivity->GetPointer(0);
+    vtkIdType pointId = 0;
+    for (unsigned int b=0; b<m_Blocks.size(); b++)
+    {
+        const std::vector< float >& points = m_Blocks[b].GetPoints();
+        if (!points.empty())
+            memcpy(coordinatePointer+3*pointId, &points[0], points.size()*sizeof(float));
+
+        const std::vector< unsigned int >& fiberSizes = m_Blocks[b].GetFiberSizes();
+        for (unsigned int i=0; i<fiberSizes.size(); i++)
+        {
+            *connectivityPointer++ = fiberSizes[i];
+            for (unsigned int j=0; j<fiberSizes[i]; j++)
+                *connectivityPointer++ = pointId++;
+        }
+    }
+
+    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
+    vtkNewPoints->SetData(coordinates);
+    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    vtkNewCells->SetCells(numFibers, connectivity);
+
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    polyData->SetPoints(vtkNewPoints);
+    polyData->SetLines(vtkNewCells);
+    return polyData;
+}
@@ -0,0 +1,127 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+
+#ifndef _MITK_ParallelFiberProcessor_H
+#define _MITK_ParallelFiberProcessor_H
+
+#include <MitkFiberTrackingExports.h>
+#include <vtkSmartPointer.h>
+#include <vtkPolyData.h>
+#include <itkMultiThreader.h>
+#include <vector>
+
+namespace mitk {
+
+/**
+   * \brief Points of the fibers created by a FiberKernel, x,y,z interleaved.
+   */
+class MitkFiberTracking_EXPORT FiberBuffer
+{
+public:
+
+    FiberBuffer() : m_NumPointsInFibers(0) {}
+
+    void AddPoint(const float* p) { m_Points.insert(m_Points.end(), p, p+3); }
+    void AddPoint(const double* p) { m_Points.push_back(p[0]); m_Points.push_back(p[1]); m_Points.push_back(p[2]); }
+
+    /** The points added since the last call form a new fiber (possibly without points). */
+    void EndFiber()
+    {
+        m_FiberSizes.push_back(GetNumPoints()-m_NumPointsInFibers);
+        m_NumPointsInFibers = GetNumPoints();
+    }
+
+    /** Drops the points added since the last call of EndFiber(). */
+    void DiscardFiber() { m_Points.resize(3*m_NumPointsInFibers); }
+
+    void Clear()
+    {
+        m_Points.clear();
+        m_FiberSizes.clear();
+        m_NumPointsInFibers = 0;
+    }
+
+    unsigned long GetNumPoints() const { return m_Points.size()/3; }
+    unsigned int GetNumFibers() const { return m_FiberSizes.size(); }
+    const std::vector< float >& GetPoints() const { return m_Points; }
+    const std::vector< unsigned int >& GetFiberSizes() const { return m_FiberSizes; }
+
+private:
+
+    std::vector< float >        m_Points;
+    std::vector< unsigned int > m_FiberSizes;
+    unsigned long               m_NumPointsInFibers;
+};
+
+/**
+   * \brief Operation that is applied to each fiber of a bundle independently (see ParallelFiberProcessor).
+   *
+   * ProcessFiber() is called concurrently for different fibers and must not modify shared state.
+   */
+class FiberKernel
+{
+public:
+
+    virtual ~FiberKernel() {}
+
+    /** Called once before the fibers are processed, e.g. to create helper objects for each thread. */
+    virtual void Initialize(unsigned int /*numberOfThreads*/) {}
+
+    /** Appends the new fibers created from the given fiber to output. threadId is smaller than the number of threads. */
+    virtual void ProcessFiber(unsigned int fiber, unsigned int threadId, FiberBuffer& output) = 0;
+};
+
+/**
+   * \brief Applies a FiberKernel to all fibers of a bundle using all cores.
+   *
+   * The fibers are processed in blocks of consecutive fibers, the threads fetch the next block when they are done.
+   * Each block writes into its own FiberBuffer; GetOutput() concatenates the buffers in fiber order, so the result
+   * does not depend on the number of threads.
+   */
+class MitkFiberTracking_EXPORT ParallelFiberProcessor
+{
+public:
+
+    ParallelFiberProcessor();
+
+    /** Number of threads, 0 uses the global default of itk::MultiThreader. */
+    void SetNumberOfThreads(unsigned int numberOfThreads) { m_NumberOfThreads = numberOfThreads; }
+    unsigned int GetNumberOfThreads() const { return m_NumberOfThreads; }
+
+    /** Applies the kernel to the fibers 0..numFibers-1. Throws an mitk::Exception if the kernel threw. */
+    void Process(unsigned int numFibers, FiberKernel& kernel);
+
+    /** Fibers created by the last call of Process() as polydata with float points. */
+    vtkSmartPointer<vtkPolyData> GetOutput() const;
+
+    unsigned long GetNumberOfOutputPoints() const;
+    unsigned int GetNumberOfOutputFibers() const;
+
+protected:
+
+    enum { BlockSize = 256 };
+
+    struct Jobs;
+    static ITK_THREAD_RETURN_TYPE ProcessCallback(void* arg);
+
+    unsigned int                m_NumberOfThreads;
+    std::vector< FiberBuffer >  m_Blocks;
+};
+
+} // namespace mitk
+
+#endif /*  _MITK_ParallelFiberProcessor_H */
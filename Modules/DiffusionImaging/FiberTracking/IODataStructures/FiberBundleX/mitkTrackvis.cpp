@@ -1,4 +1,8 @@
 #include <mitkTrackvis.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <itksys/SystemTools.hxx>
+#include <algorithm>
 
 TrackVis::TrackVis()  { filename = ""; fp = NULL; maxSteps = 20000; }
 
@@ -44,7 +48,7 @@ short TrackVis::create(string filename , mitk::FiberBundleX *fib)
     hdr.swap_xy = 0;
     hdr.swap_yz = 0;
     hdr.swap_zx = 0;
-    hdr.n_count = 0;
+    hdr.n_count = fib->GetNumFibers();
     hdr.version = 1;
     hdr.hdr_size = 1000;
 
@@ -88,59 +92,85 @@ short TrackVis::open( string filename )
 short TrackVis::append(mitk::FiberBundleX *fib)
 {
     vtkPolyData* poly = fib->GetFiberPolyData();
-    for (int i=0; i<fib->GetNumFibers(); i++)
+    vtkCellArray* lines = poly->GetLines();
+
+    // the fibers are collected in a buffer that is written in large blocks
+    const size_t bufferSize = 1<<20;
+    std::vector< char > buffer;
+    buffer.reserve(bufferSize + 4 + 12*maxSteps);
+
+    vtkIdType numPoints;
+    vtkIdType* pointIds;
+    short result = 0;
+    lines->InitTraversal();
+    while (lines->GetNextCell(numPoints, pointIds))
     {
-        vtkCell* cell = poly->GetCell(i);
-        int numPoints = cell->GetNumberOfPoints();
-        vtkPoints* points = cell->GetPoints();
-
-        unsigned int     numSaved, pos = 0;
-        //float* tmp = new float[3*maxSteps];
-        std::vector< float > tmp;
-        tmp.reserve(3*numPoints);
-
         if ( numPoints > maxSteps )
         {
             printf( "[ERROR] Trying to write a fiber too long!\n" );
-            return 0;
+            result = 0;
+            break;
         }
 
-        numSaved = numPoints;
-        for(unsigned int i=0; i<numSaved ;i++)
+        int numSaved = numPoints;
+        buffer.insert(buffer.end(), (char*)&numSaved, (char*)&numSaved+4);
+        for(vtkIdType i=0; i<numPoints ;i++)
         {
-            double* p = points->GetPoint(i);
-
-            tmp[pos++] = p[0] - m_Origin[0];
-            tmp[pos++] = p[1] - m_Origin[1];
-            tmp[pos++] = p[2] - m_Origin[2];
+            double p[3];
+            poly->GetPoint(pointIds[i], p);
+
+            float tmp[3];
+            tmp[0] = p[0] - m_Origin[0];
+            tmp[1] = p[1] - m_Origin[1];
+            tmp[2] = p[2] - m_Origin[2];
+            buffer.insert(buffer.end(), (char*)tmp, (char*)tmp+12);
         }
 
-        // write the coordinates to the file
-        if ( fwrite((char*)&numSaved, 1, 4, fp) != 4 )
+        if (buffer.size()>=bufferSize)
         {
-            printf( "[ERROR] Problems saving the fiber!\n" );
-            return 1;
-        }
-        if ( fwrite((char*)&(tmp.front()), 1, 4*pos, fp) != 4*pos )
-        {
-            printf( "[ERROR] Problems saving the fiber!\n" );
-            return 1;
+            // write the coordinates to the file
+            if ( fwrite(&buffer.front(), 1, buffer.size(), fp) != buffer.size() )
+            {
+                printf( "[ERROR] Problems saving the fiber!\n" );
+                return 1;
+            }
+            buffer.clear();
         }
     }
 
-    return 0;
+    if ( !buffer.empty() && fwrite(&buffer.front(), 1, buffer.size(), fp) != buffer.size() )
+    {
+        printf( "[ERROR] Problems saving the fiber!\n" );
+        return 1;
+    }
+
+    return result;
 }
 
 
 
-//// Read one fiber from the file
-//// ----------------------------
-short TrackVis::read( mitk::FiberBundleX* fib )
+//// Read the fibers from the file
+//// -----------------------------
+short TrackVis::read( mitk::FiberBundleX* fib, unsigned int fiberStride, itk::ProcessObject* progress )
 {
-    int numPoints;
-    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
-    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
-
+    fiberStride = std::max(1u, fiberStride);
+
+    // each point has 3+n_scalars values, each fiber is followed by n_properties values
+    const int pointSize = 3 + std::max(0, (int)hdr.n_scalars);
+    const int numProperties = std::max(0, (int)hdr.n_properties);
+    const double fileSize = itksys::SystemTools::FileLength(filename.c_str());
+
+    // the points are read directly into the vtk arrays without creating cells for each fiber
+    vtkSmartPointer<vtkFloatArray> coordinates = vtkSmartPointer<vtkFloatArray>::New();
+    coordinates->SetNumberOfComponents(3);
+    vtkSmartPointer<vtkIdTypeArray> connectivity = vtkSmartPointer<vtkIdTypeArray>::New();
+    std::vector< float > fiberBuffer;
+
+    int numPoints = 0;
+    unsigned int numFibers = 0;
+    vtkIdType numSelectedFibers = 0;
+    vtkIdType numSelectedPoints = 0;
+    double bytesRead = 1000;
     while (fread((char*)&numPoints, 1, 4, fp)==4)
     {
         if ( numPoints >= maxSteps || numPoints <= 0 )
@@ -148,24 +178,59 @@ short TrackVis::read( mitk::FiberBundleX* fib )
             printf( "[ERROR] Trying to read a fiber with %d points!\n", numPoints );
             return -1;
         }
-        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
 
-        float tmp[3];
-        for(int i=0; i<numPoints; i++)
+        size_t numValues = (size_t)numPoints*pointSize + numProperties;
+        bytesRead += 4 + 4*numValues;
+        if (progress!=NULL && numFibers%10000==0 && fileSize>0)
+            progress->UpdateProgress(bytesRead/fileSize);
+
+        if (numFibers++ % fiberStride != 0)
         {
-            if (fread((char*)tmp, 1, 12, fp) == 0)
-                MITK_ERROR << "TrackVis::read: Error during read.";
+            if (fseek(fp, 4*numValues, SEEK_CUR)!=0)
+                break;
+            continue;
+        }
 
-            vtkIdType id = vtkNewPoints->InsertNextPoint(tmp);
-            container->GetPointIds()->InsertNextId(id);
+        float* target = NULL;
+        if (numValues==3*(size_t)numPoints)
+            target = coordinates->WritePointer(3*numSelectedPoints, 3*numPoints);
+        else
+        {
+            fiberBuffer.resize(numValues);
+            target = &fiberBuffer.front();
+        }
+        if (fread((char*)target, 4, numValues, fp) != numValues)
+        {
+            MITK_ERROR << "TrackVis::read: Error during read.";
+            coordinates->SetNumberOfTuples(numSelectedPoints);
+            break;
+        }
+        if (target==&fiberBuffer.front())
+        {
+            float* p = coordinates->WritePointer(3*numSelectedPoints, 3*numPoints);
+            for(int i=0; i<numPoints; i++)
+                for(int j=0; j<3; j++)
+                    p[3*i+j] = fiberBuffer[i*pointSize+j];
         }
-        vtkNewCells->InsertNextCell(container);
+
+        connectivity->InsertNextValue(numPoints);
+        for(int i=0; i<numPoints; i++)
+            connectivity->InsertNextValue(numSelectedPoints+i);
+        numSelectedPoints += numPoints;
+        numSelectedFibers++;
     }
 
+    vtkSmartPointer<vtkPoints> vtkNewPoints = vtkSmartPointer<vtkPoints>::New();
+    vtkNewPoints->SetData(coordinates);
+    vtkSmartPointer<vtkCellArray> vtkNewCells = vtkSmartPointer<vtkCellArray>::New();
+    vtkNewCells->SetCells(numSelectedFibers, connectivity);
+
     vtkSmartPointer<vtkPolyData> fiberPolyData = vtkSmartPointer<vtkPolyData>::New();
     fiberPolyData->SetPoints(vtkNewPoints);
     fiberPolyData->SetLines(vtkNewCells);
     fib->SetFiberPolyData(fiberPolyData);
+    if (progress!=NULL)
+        progress->UpdateProgress(1.0);
 
     return numPoints;
 }
@@ -24,6 +24,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkPoints.h>
 #include <vtkPolyLine.h>
 #include <itkSize.h>
+#include <itkProcessObject.h>
 
 using namespace std;
 
@@ -70,7 +71,7 @@ public:
 
     short     create(string filename, mitk::FiberBundleX* fib);
     short     open( string filename );
-    short     read( mitk::FiberBundleX* fib );
+    short     read( mitk::FiberBundleX* fib, unsigned int fiberStride=1, itk::ProcessObject* progress=NULL );
     short    append( mitk::FiberBundleX* fib );
     void    writeHdr();
     void    updateTotal( int totFibers );
@@ -44,6 +44,7 @@ mitk::FiberfoxParameters< ScalarType >::FiberfoxParameters()
     , m_DoDisablePartialVolume(false)
     , m_DoAddMotion(false)
     , m_DoRandomizeMotion(true)
+    , m_DoUseFft(false)
     , m_NoiseModel(NULL)
     , m_FrequencyMap(NULL)
     , m_MaskImage(NULL)
@@ -283,6 +284,7 @@ void mitk::FiberfoxParameters< ScalarType >::LoadParameters(string filename)
             m_DoAddGibbsRinging = v1.second.get<bool>("artifacts.addringing");
             m_DoAddMotion = v1.second.get<bool>("artifacts.doAddMotion");
             m_DoRandomizeMotion = v1.second.get<bool>("artifacts.randomMotion");
+            m_DoUseFft = v1.second.get<bool>("artifacts.useFft", false);
             m_Translation[0] = v1.second.get<double>("artifacts.translation0");
             m_Translation[1] = v1.second.get<double>("artifacts.translation1");
             m_Translation[2] = v1.second.get<double>("artifacts.translation2");
@@ -464,6 +466,7 @@ void mitk::FiberfoxParameters< ScalarType >::PrintSelf()
     MITK_INFO << "m_DoDisablePartialVolume: " << m_DoDisablePartialVolume;
     MITK_INFO << "m_DoAddMotion: " << m_DoAddMotion;
     MITK_INFO << "m_RandomMotion: " << m_DoRandomizeMotion;
+    MITK_INFO << "m_DoUseFft: " << m_DoUseFft;
     MITK_INFO << "m_Translation: " << m_Translation;
     MITK_INFO << "m_Rotation: " << m_Rotation;
     MITK_INFO << "m_SignalModelString: " << m_SignalModelString;
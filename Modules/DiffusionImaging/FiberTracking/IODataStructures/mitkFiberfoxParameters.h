@@ -78,6 +78,7 @@ public:
         out.m_DoDisablePartialVolume = m_DoDisablePartialVolume;
         out.m_DoAddMotion = m_DoAddMotion;
         out.m_DoRandomizeMotion = m_DoRandomizeMotion;
+        out.m_DoUseFft = m_DoUseFft;
         out.m_Translation = m_Translation;
         out.m_Rotation = m_Rotation;
         if (m_NoiseModel!=NULL)
@@ -130,6 +131,7 @@ public:
     bool                                m_DoDisablePartialVolume;   ///< Disable partial volume effects. Each voxel is either all fiber or all non-fiber.
     bool                                m_DoAddMotion;              ///< Enable motion artifacts.
     bool                                m_DoRandomizeMotion;        ///< Toggles between random and linear motion.
+    bool                                m_DoUseFft;                 ///< Simulate k-space with FFTs instead of the direct DFT. Much faster, distortions and eddy currents are approximated.
     itk::Vector<double,3>               m_Translation;              ///< Maximum translational motion.
     itk::Vector<double,3>               m_Rotation;                 ///< Maximum rotational motion.
     NoiseModelType*                     m_NoiseModel;               ///< If != NULL, noise is added to the image.
@@ -6,9 +6,13 @@ SET(MODULE_CUSTOM_TESTS
   mitkLocalFiberPlausibilityTest.cpp
   mitkFiberTransformationTest.cpp
   mitkFiberExtractionTest.cpp
+  mitkFiberContainerTest.cpp
+  mitkFiberBundleXProcessingBenchmarkTest.cpp
+  mitkFiberBundleXBinaryIOTest.cpp
   mitkFiberGenerationTest.cpp
   mitkFiberfoxSignalGenerationTest.cpp
   mitkFiberfoxAddArtifactsToDwiTest.cpp
+  mitkFiberfoxKspaceEngineTest.cpp
 )
 
 
@@ -0,0 +1,87 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestingConfig.h>
+#include <mitkFiberBundleX.h>
+#include <mitkFiberBundleXReader.h>
+#include <mitkFiberBundleXWriter.h>
+#include <mitkFiberBundleXBinaryIO.h>
+#include <vtkCellArray.h>
+#include <vtkPolyLine.h>
+#include <cmath>
+
+namespace
+{
+mitk::FiberBundleX::Pointer Read(const std::string& fileName, unsigned int fiberStride)
+{
+    mitk::FiberBundleXReader::Pointer reader = mitk::FiberBundleXReader::New();
+    reader->SetFileName(fileName.c_str());
+    reader->SetFiberStride(fiberStride);
+    reader->Update();
+    return dynamic_cast<mitk::FiberBundleX*>(reader->GetOutput());
+}
+}
+
+/**Documentation
+ *  Test for the binary fiber bundle format and the streaming TrackVis reader
+ */
+int mitkFiberBundleXBinaryIOTest(int /*argc*/, char* /*argv*/[])
+{
+    MITK_TEST_BEGIN("mitkFiberBundleXBinaryIOTest");
+
+    // 100000 fibers of different length, more than one chunk of the binary reader
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    for (int i=0; i<100000; i++)
+    {
+        vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+        for (int j=0; j<2+i%9; j++)
+            container->GetPointIds()->InsertNextId(points->InsertNextPoint(i%100+0.3*j, i/100%100+sin(0.1*j), i/10000+0.5*j));
+        lines->InsertNextCell(container);
+    }
+    polyData->SetPoints(points);
+    polyData->SetLines(lines);
+    mitk::FiberBundleX::Pointer fib = mitk::FiberBundleX::New(polyData);
+
+    std::vector< long > evenFibers;
+    for (long i=0; i<fib->GetNumFibers(); i+=2)
+        evenFibers.push_back(i);
+    mitk::FiberBundleX::Pointer subsampled = mitk::FiberBundleX::New(fib->GeneratePolyDataByIds(evenFibers));
+
+    std::string extensions[] = { mitk::FiberBundleXBinaryIO::FILE_EXTENSION, ".trk" };
+    for (int e=0; e<2; e++)
+    {
+        std::string fileName = std::string(MITK_TEST_OUTPUT_DIR)+"/binaryIOTest"+extensions[e];
+
+        mitk::FiberBundleXWriter::Pointer writer = mitk::FiberBundleXWriter::New();
+        writer->SetFileName(fileName);
+        writer->DoWrite(fib.GetPointer());
+        MITK_TEST_CONDITION_REQUIRED(writer->GetSuccess(), "write " << extensions[e])
+
+        mitk::FiberBundleX::Pointer fib2 = Read(fileName, 1);
+        MITK_TEST_CONDITION_REQUIRED(fib2.IsNotNull() && fib->Equals(fib2), "fiber bundle is not changed during writing/reading " << extensions[e])
+
+        fib2 = Read(fileName, 2);
+        MITK_TEST_CONDITION_REQUIRED(fib2.IsNotNull() && subsampled->Equals(fib2), "reading every second fiber of " << extensions[e])
+    }
+
+    MITK_TEST_CONDITION(mitk::FiberBundleXBinaryIO::CanReadFile(std::string(MITK_TEST_OUTPUT_DIR)+"/binaryIOTest"+mitk::FiberBundleXBinaryIO::FILE_EXTENSION), "binary file is recognized")
+    MITK_TEST_CONDITION(!mitk::FiberBundleXBinaryIO::CanReadFile(std::string(MITK_TEST_OUTPUT_DIR)+"/binaryIOTest.trk"), "TrackVis file is not recognized as binary fiber bundle")
+
+    MITK_TEST_END();
+}
@@ -0,0 +1,147 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkFiberBundleX.h>
+#include <itkMultiThreader.h>
+#include <itkTimeProbe.h>
+#include <vtkCellArray.h>
+#include <vtkPointData.h>
+#include <vtkUnsignedCharArray.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+
+/**
+ * Benchmark for the parallel per-fiber operations of FiberBundleX on a synthetic bundle
+ * (1,000,000 fibers unless the number is given as first argument). Each operation is run
+ * single threaded and with the default number of threads; the test fails if the results differ.
+ * The registered test uses a small bundle; run it manually with a large one to measure the speedup.
+ */
+
+namespace
+{
+  /** Curved fibers with 20 points, the curvature varies between the fibers. */
+  mitk::FiberBundleX::Pointer CreateBundle(unsigned int numFibers)
+  {
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    const unsigned int numPoints = 20;
+    for (unsigned int i = 0; i < numFibers; ++i)
+    {
+      double start[3] = { (i % 100) * 0.7, (i / 100 % 100) * 0.7, (i / 10000 % 100) * 0.7 };
+      double radius = 5.0 + (i * 7919 % 100) * 0.2;
+      double step = 0.5 + (i % 13) * 0.1;
+
+      lines->InsertNextCell(numPoints);
+      for (unsigned int j = 0; j < numPoints; ++j)
+      {
+        double angle = j * step / radius;
+        lines->InsertCellPoint(points->InsertNextPoint(start[0] + radius * std::sin(angle), start[1] + radius * (1 - std::cos(angle)), start[2] + j * 0.1));
+      }
+    }
+
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    polyData->SetPoints(points);
+    polyData->SetLines(lines);
+    return mitk::FiberBundleX::New(polyData);
+  }
+
+  enum Operation
+  {
+    Resample,
+    Compress,
+    CurvatureThreshold,
+    RemoveShort,
+    RemoveLong,
+    Smoothing,
+    ColorCoding
+  };
+
+  const char* OperationNames[] = { "ResampleFibers", "CompressFibers", "ApplyCurvatureThreshold", "RemoveShortFibers", "RemoveLongFibers", "DoFiberSmoothing", "DoColorCodingOrientationBased" };
+
+  mitk::FiberBundleX::Pointer Run(mitk::FiberBundleX* bundle, Operation operation, unsigned int numberOfThreads, double& seconds)
+  {
+    mitk::FiberBundleX::Pointer fib = bundle->GetDeepCopy();
+    fib->SetNumberOfThreads(numberOfThreads);
+    if (operation == ColorCoding)
+      fib->GetFiberPolyData()->GetPointData()->RemoveArray(mitk::FiberBundleX::COLORCODING_ORIENTATION_BASED);
+
+    itk::TimeProbe probe;
+    probe.Start();
+    switch (operation)
+    {
+    case Resample: fib->ResampleFibers(0.5); break;
+    case Compress: fib->CompressFibers(0.1); break;
+    case CurvatureThreshold: fib->ApplyCurvatureThreshold(6, false); break;
+    case RemoveShort: fib->RemoveShortFibers(fib->GetMedianFiberLength()); break;
+    case RemoveLong: fib->RemoveLongFibers(fib->GetMedianFiberLength()); break;
+    case Smoothing: fib->DoFiberSmoothing(1); break;
+    case ColorCoding: fib->DoColorCodingOrientationBased(); break;
+    }
+    probe.Stop();
+    seconds = probe.GetTotal();
+    return fib;
+  }
+
+  bool EqualColors(mitk::FiberBundleX* a, mitk::FiberBundleX* b)
+  {
+    vtkDataArray* colorsA = a->GetFiberPolyData()->GetPointData()->GetArray(mitk::FiberBundleX::COLORCODING_ORIENTATION_BASED);
+    vtkDataArray* colorsB = b->GetFiberPolyData()->GetPointData()->GetArray(mitk::FiberBundleX::COLORCODING_ORIENTATION_BASED);
+    if (colorsA == NULL || colorsB == NULL || colorsA->GetNumberOfTuples() != colorsB->GetNumberOfTuples())
+      return false;
+    for (vtkIdType i = 0; i < colorsA->GetNumberOfTuples() * 4; ++i)
+      if (colorsA->GetVariantValue(i) != colorsB->GetVariantValue(i))
+        return false;
+    return true;
+  }
+}
+
+int mitkFiberBundleXProcessingBenchmarkTest(int argc, char* argv[])
+{
+  MITK_TEST_BEGIN("mitkFiberBundleXProcessingBenchmarkTest");
+
+  unsigned int numFibers = argc > 1 ? atoi(argv[1]) : 1000000;
+  unsigned int numThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+
+  itk::TimeProbe creationProbe;
+  creationProbe.Start();
+  mitk::FiberBundleX::Pointer bundle = CreateBundle(numFibers);
+  creationProbe.Stop();
+  MITK_TEST_CONDITION_REQUIRED(bundle->GetNumFibers() == (int)numFibers, "Synthetic bundle contains " << numFibers << " fibers");
+  MITK_TEST_OUTPUT(<< "bundle created in " << creationProbe.GetTotal() << " s");
+
+  // the spline smoothing creates vtk objects for each fiber and is benchmarked on a subset
+  mitk::FiberBundleX::Pointer smallBundle = CreateBundle(std::min(numFibers, 20000u));
+
+  for (int operation = Resample; operation <= ColorCoding; ++operation)
+  {
+    mitk::FiberBundleX* input = (operation == Smoothing) ? smallBundle.GetPointer() : bundle.GetPointer();
+
+    double sequentialSeconds = 0;
+    double parallelSeconds = 0;
+    mitk::FiberBundleX::Pointer reference = Run(input, (Operation)operation, 1, sequentialSeconds);
+    mitk::FiberBundleX::Pointer result = Run(input, (Operation)operation, numThreads, parallelSeconds);
+
+    MITK_TEST_OUTPUT(<< OperationNames[operation] << " on " << input->GetNumFibers() << " fibers: 1 thread " << sequentialSeconds << " s, "
+                     << numThreads << " threads " << parallelSeconds << " s (speedup " << (parallelSeconds > 0 ? sequentialSeconds / parallelSeconds : 0.0) << ")");
+    MITK_TEST_CONDITION(result->Equals(reference), OperationNames[operation] << " with " << numThreads << " threads equals the single threaded result");
+    if (operation == ColorCoding)
+      MITK_TEST_CONDITION(EqualColors(result, reference), "Colors with " << numThreads << " threads equal the single threaded colors");
+  }
+
+  MITK_TEST_END();
+}
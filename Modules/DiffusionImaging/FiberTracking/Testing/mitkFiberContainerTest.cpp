@@ -0,0 +1,172 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkFiberBundleX.h>
+#include <mitkFiberContainer.h>
+#include <vtkPolyLine.h>
+#include <vtkCellArray.h>
+#include <itkMultiThreader.h>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    struct ConcurrentQueryData
+    {
+        const mitk::FiberContainer*                 Fibers;
+        double                                      Bounds[6];
+        std::vector< std::vector< unsigned int > >  Results;
+    };
+
+    ITK_THREAD_RETURN_TYPE ConcurrentQueryCallback(void* arg)
+    {
+        itk::MultiThreader::ThreadInfoStruct* info = static_cast< itk::MultiThreader::ThreadInfoStruct* >(arg);
+        ConcurrentQueryData* data = static_cast< ConcurrentQueryData* >(info->UserData);
+        data->Results[info->ThreadID] = data->Fibers->GetFibersInBox(data->Bounds);
+        return ITK_THREAD_RETURN_VALUE;
+    }
+}
+
+/**Documentation
+ *  Test if the structure-of-arrays fiber container matches the fiber polydata and its spatial queries never miss a fiber,
+ *  also if the first queries are concurrent
+ */
+int mitkFiberContainerTest(int /*argc*/, char* /*argv*/[])
+{
+    MITK_TEST_BEGIN("mitkFiberContainerTest");
+
+    // 10x10 straight fibers along x with 11 points each and a curved fiber
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    vtkSmartPointer<vtkCellArray> lines = vtkSmartPointer<vtkCellArray>::New();
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    for (int y=0; y<10; y++)
+        for (int z=0; z<10; z++)
+        {
+            vtkSmartPointer<vtkPolyLine> container = vtkSmartPointer<vtkPolyLine>::New();
+            for (int x=0; x<=10; x++)
+                container->GetPointIds()->InsertNextId(points->InsertNextPoint(x*2.5, y*2.0+0.5, z*2.0+0.5));
+            lines->InsertNextCell(container);
+        }
+    vtkSmartPointer<vtkPolyLine> curved = vtkSmartPointer<vtkPolyLine>::New();
+    for (int i=0; i<20; i++)
+        curved->GetPointIds()->InsertNextId(points->InsertNextPoint(10+5*cos(i*0.2), 10+5*sin(i*0.2), 7.3));
+    lines->InsertNextCell(curved);
+    polyData->SetPoints(points);
+    polyData->SetLines(lines);
+
+    mitk::FiberBundleX::Pointer fib = mitk::FiberBundleX::New(polyData);
+    const mitk::FiberContainer& fibers = fib->GetFiberContainer();
+
+    MITK_TEST_CONDITION_REQUIRED(fibers.GetNumFibers()==(unsigned int)fib->GetNumFibers(), "check number of fibers")
+    MITK_TEST_CONDITION_REQUIRED(fibers.GetNumPoints()==fib->GetNumberOfPoints(), "check number of points")
+
+    bool pointsEqual = true;
+    for (unsigned int i=0; i<fibers.GetNumFibers(); i++)
+    {
+        vtkCell* cell = fib->GetFiberPolyData()->GetCell(i);
+        if (fibers.GetNumPoints(i)!=(unsigned int)cell->GetNumberOfPoints())
+        {
+            pointsEqual = false;
+            continue;
+        }
+        for (unsigned int j=0; j<fibers.GetNumPoints(i); j++)
+        {
+            double* p = cell->GetPoints()->GetPoint(j);
+            const float* q = fibers.GetPoint(i, j);
+            if (p[0]!=q[0] || p[1]!=q[1] || p[2]!=q[2])
+                pointsEqual = false;
+        }
+    }
+    MITK_TEST_CONDITION_REQUIRED(pointsEqual, "check fiber points")
+
+    // every fiber with a point or segment in the box has to be returned
+    bool missed = false;
+    bool tooMany = false;
+    for (int q=0; q<200; q++)
+    {
+        double bounds[6];
+        for (int k=0; k<3; k++)
+        {
+            bounds[2*k] = -3 + (q*7+k*13)%29;
+            bounds[2*k+1] = bounds[2*k] + 0.1 + (q*3+k*5)%7;
+        }
+        std::vector< unsigned int > result = fibers.GetFibersInBox(bounds);
+
+        for (unsigned int i=0; i<fibers.GetNumFibers(); i++)
+        {
+            bool inside = false;
+            for (unsigned int j=0; j<fibers.GetNumPoints(i); j++)
+            {
+                const float* p = fibers.GetPoint(i, j);
+                if (p[0]>=bounds[0] && p[0]<=bounds[1] && p[1]>=bounds[2] && p[1]<=bounds[3] && p[2]>=bounds[4] && p[2]<=bounds[5])
+                    inside = true;
+            }
+            // straight fibers also pass the box if their y/z coordinates and x range overlap it
+            if (i<100)
+            {
+                const float* p = fibers.GetPoint(i, 0);
+                inside = inside || (p[1]>=bounds[2] && p[1]<=bounds[3] && p[2]>=bounds[4] && p[2]<=bounds[5] && bounds[1]>=0 && bounds[0]<=25);
+            }
+
+            bool found = std::binary_search(result.begin(), result.end(), i);
+            if (inside && !found)
+                missed = true;
+
+            // returned fibers have to overlap the box with their bounding box
+            const float* b = fibers.GetFiberBounds(i);
+            if (found && (b[0]>bounds[1] || b[1]<bounds[0] || b[2]>bounds[3] || b[3]<bounds[2] || b[4]>bounds[5] || b[5]<bounds[4]))
+                tooMany = true;
+        }
+    }
+    MITK_TEST_CONDITION_REQUIRED(!missed, "check that box queries find all fibers")
+    MITK_TEST_CONDITION_REQUIRED(!tooMany, "check that box queries only return overlapping fibers")
+
+    // the copy builds its own grid, concurrently queried before it exists
+    mitk::FiberContainer copy(fibers);
+    ConcurrentQueryData queryData;
+    queryData.Fibers = &copy;
+    for (int k=0; k<3; k++)
+    {
+        queryData.Bounds[2*k] = 4;
+        queryData.Bounds[2*k+1] = 12;
+    }
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(8);
+    queryData.Results.resize(threader->GetNumberOfThreads());
+    threader->SetSingleMethod(ConcurrentQueryCallback, &queryData);
+    threader->SingleMethodExecute();
+    std::vector< unsigned int > reference = fibers.GetFibersInBox(queryData.Bounds);
+    bool concurrentEqual = !reference.empty();
+    for (unsigned int t=0; t<queryData.Results.size(); t++)
+        concurrentEqual = concurrentEqual && queryData.Results[t]==reference;
+    MITK_TEST_CONDITION_REQUIRED(concurrentEqual, "check concurrent first queries")
+
+    // the container follows changes of the fibers
+    fib->ResampleFibers(1);
+    MITK_TEST_CONDITION_REQUIRED(fib->GetFiberContainer().GetNumPoints()==fib->GetNumberOfPoints(), "check container update after resampling")
+
+    // a bundle minus itself is empty, minus a part leaves the rest
+    MITK_TEST_CONDITION_REQUIRED(fib->SubtractBundle(fib).IsNull(), "check subtraction of identical bundle")
+    std::vector< long > ids;
+    for (long i=0; i<50; i++)
+        ids.push_back(i);
+    mitk::FiberBundleX::Pointer part = mitk::FiberBundleX::New(fib->GeneratePolyDataByIds(ids));
+    mitk::FiberBundleX::Pointer rest = fib->SubtractBundle(part);
+    MITK_TEST_CONDITION_REQUIRED(rest.IsNotNull() && rest->GetNumFibers()==fib->GetNumFibers()-50, "check subtraction of partial bundle")
+
+    MITK_TEST_END();
+}
@@ -0,0 +1,249 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestingMacros.h>
+#include <mitkTestFixture.h>
+#include <mitkFiberfoxParameters.h>
+#include <itkKspaceImageFilter.h>
+#include <itkDftImageFilter.h>
+#include <itkImageRegionIterator.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkTimeProbe.h>
+
+/**Documentation
+ * Compares the FFT based k-space simulation of Fiberfox with the direct DFT and reports the speedup.
+ * Cases without distortions and eddy currents have to match exactly (up to rounding), the approximated ones closely.
+ */
+class mitkFiberfoxKspaceEngineTestSuite : public mitk::TestFixture
+{
+
+    CPPUNIT_TEST_SUITE(mitkFiberfoxKspaceEngineTestSuite);
+    MITK_TEST(NoArtifacts);
+    MITK_TEST(Relaxation);
+    MITK_TEST(Ghost);
+    MITK_TEST(GibbsRinging);
+    MITK_TEST(Aliasing);
+    MITK_TEST(Eddy);
+    MITK_TEST(Distortions);
+    MITK_TEST(DftImageFilter);
+    MITK_TEST(Benchmark);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+
+    typedef itk::Image< double, 2 >                         SliceType;
+    typedef itk::KspaceImageFilter< double >                KspaceFilterType;
+    typedef KspaceFilterType::OutputImageType               ComplexSliceType;
+
+    FiberfoxParameters<double>          m_Parameters;
+    std::vector< SliceType::Pointer >   m_Compartments;
+    std::vector< double >               m_T2;
+    SliceType::Pointer                  m_FrequencyMap;
+    itk::Size<2>                        m_OutSize;
+
+public:
+
+    void setUp()
+    {
+        m_Parameters = FiberfoxParameters<double>();
+        m_Parameters.m_DoSimulateRelaxation = false;
+        m_Parameters.m_SignalScale = 100;
+        m_FrequencyMap = NULL;
+        CreateCompartments(13, 12, 1);
+    }
+
+    void tearDown()
+    {
+        m_Compartments.clear();
+        m_T2.clear();
+        m_FrequencyMap = NULL;
+    }
+
+    /** Two smooth compartments, sampled upsampling times finer than the k-space. Odd size on purpose. */
+    void CreateCompartments(unsigned int sizeX, unsigned int sizeY, unsigned int upsampling)
+    {
+        m_Compartments.clear();
+        m_T2.clear();
+        m_OutSize[0] = sizeX;
+        m_OutSize[1] = sizeY;
+
+        itk::ImageRegion<2> region;
+        region.SetSize(0, sizeX*upsampling);
+        region.SetSize(1, sizeY*upsampling);
+        for (unsigned int i=0; i<2; i++)
+        {
+            SliceType::Pointer slice = SliceType::New();
+            slice->SetRegions(region);
+            slice->Allocate();
+            itk::ImageRegionIterator< SliceType > it(slice, region);
+            while (!it.IsAtEnd())
+            {
+                double x = it.GetIndex()[0];
+                double y = it.GetIndex()[1];
+                it.Set( i==0 ? 1+sin(x/3)*cos(y/5) : (x*y)/(sizeX*sizeY*upsampling*upsampling) );
+                ++it;
+            }
+            m_Compartments.push_back(slice);
+            m_T2.push_back(i==0 ? 80 : 120);
+        }
+    }
+
+    ComplexSliceType::Pointer SimulateKspace(bool useFft)
+    {
+        m_Parameters.m_DoUseFft = useFft;
+        KspaceFilterType::Pointer filter = KspaceFilterType::New();
+        filter->SetParameters(m_Parameters);
+        filter->SetCompartmentImages(m_Compartments);
+        filter->SetT2(m_T2);
+        filter->SetZ(2);
+        filter->SetOutSize(m_OutSize);
+        filter->SetFrequencyMapSlice(m_FrequencyMap);
+        itk::Vector<double,3> gradient; gradient[0] = 0.6; gradient[1] = 0.8; gradient[2] = 0;
+        filter->SetDiffusionGradientDirection(gradient);
+        filter->SetUseConstantRandSeed(true);
+        filter->Update();
+        return filter->GetOutput();
+    }
+
+    /** Largest deviation of the FFT result relative to the largest k-space magnitude. */
+    double CompareEngines()
+    {
+        return CompareSlices(SimulateKspace(false), SimulateKspace(true));
+    }
+
+    double CompareSlices(ComplexSliceType::Pointer dft, ComplexSliceType::Pointer fft)
+    {
+        double maxDifference = 0;
+        double maxMagnitude = 0;
+        itk::ImageRegionConstIterator< ComplexSliceType > it1(dft, dft->GetLargestPossibleRegion());
+        itk::ImageRegionConstIterator< ComplexSliceType > it2(fft, fft->GetLargestPossibleRegion());
+        while (!it1.IsAtEnd())
+        {
+            maxDifference = std::max(maxDifference, (double)std::abs(it1.Get()-it2.Get()));
+            maxMagnitude = std::max(maxMagnitude, (double)std::abs(it1.Get()));
+            ++it1;
+            ++it2;
+        }
+        return maxMagnitude>0 ? maxDifference/maxMagnitude : maxDifference;
+    }
+
+    void NoArtifacts()
+    {
+        CPPUNIT_ASSERT_MESSAGE("FFT equals DFT without artifacts", CompareEngines()<1e-10);
+    }
+
+    void Relaxation()
+    {
+        m_Parameters.m_DoSimulateRelaxation = true;
+        CPPUNIT_ASSERT_MESSAGE("FFT equals DFT with T2 and T2* relaxation", CompareEngines()<1e-10);
+    }
+
+    void Ghost()
+    {
+        m_Parameters.m_DoSimulateRelaxation = true;
+        m_Parameters.m_KspaceLineOffset = 0.25;
+        CPPUNIT_ASSERT_MESSAGE("FFT equals DFT with N/2 ghosts", CompareEngines()<1e-10);
+    }
+
+    void GibbsRinging()
+    {
+        CreateCompartments(13, 12, 2);
+        m_Parameters.m_DoSimulateRelaxation = true;
+        CPPUNIT_ASSERT_MESSAGE("FFT equals DFT with cropped k-space", CompareEngines()<1e-10);
+    }
+
+    void Aliasing()
+    {
+        CreateCompartments(13, 12, 1);
+        m_OutSize[1] = 9;
+        m_Parameters.m_DoSimulateRelaxation = true;
+        CPPUNIT_ASSERT_MESSAGE("FFT equals DFT with reduced FOV", CompareEngines()<1e-10);
+    }
+
+    void Eddy()
+    {
+        m_Parameters.m_DoSimulateRelaxation = true;
+        m_Parameters.m_KspaceLineOffset = 0.1;
+        m_Parameters.m_EddyStrength = 0.05;
+        CPPUNIT_ASSERT_MESSAGE("Non-uniform FFT approximates DFT with eddy currents", CompareEngines()<1e-3);
+    }
+
+    void Distortions()
+    {
+        m_FrequencyMap = SliceType::New();
+        m_FrequencyMap->SetRegions(m_Compartments.at(0)->GetLargestPossibleRegion());
+        m_FrequencyMap->Allocate();
+        itk::ImageRegionIterator< SliceType > it(m_FrequencyMap, m_FrequencyMap->GetLargestPossibleRegion());
+        while (!it.IsAtEnd())
+        {
+            it.Set( 5*sin(it.GetIndex()[0]*0.3)+3*cos(it.GetIndex()[1]*0.2) );
+            ++it;
+        }
+        m_Parameters.m_DoSimulateRelaxation = true;
+        CPPUNIT_ASSERT_MESSAGE("Time segmentation approximates DFT with distortions", CompareEngines()<1e-3);
+    }
+
+    void DftImageFilter()
+    {
+        ComplexSliceType::Pointer kspace = SimulateKspace(true);
+
+        typedef itk::DftImageFilter< double > DftFilterType;
+        DftFilterType::Pointer dft = DftFilterType::New();
+        dft->SetInput(kspace);
+        dft->Update();
+        SliceType::Pointer reference = dft->GetOutput();
+
+        DftFilterType::Pointer fft = DftFilterType::New();
+        fft->SetInput(kspace);
+        fft->SetUseFft(true);
+        fft->Update();
+        SliceType::Pointer result = fft->GetOutput();
+
+        double maxDifference = 0;
+        itk::ImageRegionConstIterator< SliceType > it1(reference, reference->GetLargestPossibleRegion());
+        itk::ImageRegionConstIterator< SliceType > it2(result, result->GetLargestPossibleRegion());
+        while (!it1.IsAtEnd())
+        {
+            maxDifference = std::max(maxDifference, fabs(it1.Get()-it2.Get()));
+            ++it1;
+            ++it2;
+        }
+        CPPUNIT_ASSERT_MESSAGE("FFT image reconstruction equals DFT", maxDifference<1e-8);
+    }
+
+    void Benchmark()
+    {
+        CreateCompartments(48, 48, 1);
+        m_Parameters.m_DoSimulateRelaxation = true;
+
+        itk::TimeProbe dftProbe;
+        dftProbe.Start();
+        ComplexSliceType::Pointer dft = SimulateKspace(false);
+        dftProbe.Stop();
+
+        itk::TimeProbe fftProbe;
+        fftProbe.Start();
+        ComplexSliceType::Pointer fft = SimulateKspace(true);
+        fftProbe.Stop();
+
+        // timings depend on the machine load, so they are only reported
+        MITK_INFO << "48x48 slice with relaxation: DFT " << dftProbe.GetTotal() << " s, FFT " << fftProbe.GetTotal() << " s"
+                  << " (speedup " << (fftProbe.GetTotal()>0 ? dftProbe.GetTotal()/fftProbe.GetTotal() : 0.0) << ")";
+        CPPUNIT_ASSERT_MESSAGE("FFT equals DFT in the benchmark", CompareSlices(dft, fft)<1e-10);
+    }
+};
+
+MITK_TEST_SUITE_REGISTRATION(mitkFiberfoxKspaceEngine)
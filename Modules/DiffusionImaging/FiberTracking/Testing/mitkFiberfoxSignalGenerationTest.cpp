@@ -55,10 +55,12 @@ bool CompareDwi(itk::VectorImage< short, 3 >* dwi1, itk::VectorImage< short, 3 >
     return true;
 }
 
-void StartSimulation(FiberfoxParameters<double> parameters, FiberBundleX::Pointer fiberBundle, mitk::DiffusionImage<short>::Pointer refImage, string message)
+void StartSimulation(FiberfoxParameters<double> parameters, FiberBundleX::Pointer fiberBundle, mitk::DiffusionImage<short>::Pointer refImage, string message, unsigned int numberOfThreads=0)
 {
     itk::TractsToDWIImageFilter< short >::Pointer tractsToDwiFilter = itk::TractsToDWIImageFilter< short >::New();
     tractsToDwiFilter->SetUseConstantRandSeed(true);
+    if (numberOfThreads>0)
+        tractsToDwiFilter->SetNumberOfThreads(numberOfThreads);
     tractsToDwiFilter->SetParameters(parameters);
     tractsToDwiFilter->SetFiberBundle(fiberBundle);
     tractsToDwiFilter->Update();
@@ -250,6 +252,9 @@ int mitkFiberfoxSignalGenerationTest(int argc, char* argv[])
         parameters.m_SpikeAmplitude = 1;
         StartSimulation(parameters, fiberBundle, spikes, argv[14]);
 
+        // the result must not depend on the number of threads simulating the k-space slices
+        StartSimulation(parameters, fiberBundle, spikes, string(argv[14])+" (single threaded)", 1);
+
         // Rician noise
         parameters.m_Spikes = 0;
         parameters.m_NoiseModel = ricianNoiseModel;
@@ -77,11 +77,22 @@ int mitkGibbsTrackingTest(int argc, char* argv[])
 
     mitk::FiberBundleX::Pointer fib2 = mitk::FiberBundleX::New(gibbsTracker->GetFiberBundle());
     MITK_TEST_CONDITION_REQUIRED(fib1->Equals(fib2), "check if gibbs tracking has changed");
+    MITK_TEST_CONDITION(gibbsTracker->GetIsGridConsistent(), "check particle grid consistency after sequential tracking");
 
     gibbsTracker->SetRandomSeed(0);
     gibbsTracker->Update();
     fib2 = mitk::FiberBundleX::New(gibbsTracker->GetFiberBundle());
     MITK_TEST_CONDITION_REQUIRED(!fib1->Equals(fib2), "check if gibbs tracking has changed after wrong seed");
+
+    // concurrent sampling of the particle grid domains, the result depends on the scheduling of the threads
+    gibbsTracker->SetRandomSeed(1);
+    gibbsTracker->SetNumberOfThreads(4);
+    gibbsTracker->Update();
+    fib2 = mitk::FiberBundleX::New(gibbsTracker->GetFiberBundle());
+    MITK_TEST_CONDITION_REQUIRED(gibbsTracker->GetIsGridConsistent(), "check particle grid consistency after concurrent tracking");
+    MITK_TEST_CONDITION_REQUIRED(fib2->GetNumFibers()>0, "check if concurrent gibbs tracking reconstructs fibers");
+    MITK_TEST_CONDITION(fib2->GetNumFibers()>fib1->GetNumFibers()/2 && fib2->GetNumFibers()<fib1->GetNumFibers()*2, "check if concurrent gibbs tracking reconstructs a comparable number of fibers");
+    MITK_TEST_CONDITION(gibbsTracker->GetProposalsPerSecond()>0, "check proposal throughput");
   }
   catch(...)
   {
@@ -108,6 +108,13 @@ int mitkStreamlineTrackingTest(int argc, char* argv[])
             MITK_INFO << "OUTPUT: " << mitk::IOUtil::GetTempPath();
         }
         MITK_TEST_CONDITION_REQUIRED(ok, "Check if tractograms are equal.");
+
+        // the seeds are distributed over the threads, the result must not depend on the number of threads
+        filter->SetNumberOfThreads(4);
+        filter->Modified();
+        filter->Update();
+        mitk::FiberBundleX::Pointer fib3 = mitk::FiberBundleX::New(filter->GetFiberPolyData());
+        MITK_TEST_CONDITION_REQUIRED(fib3->Equals(fib2), "Check if tractogram tracked with 4 threads equals the reference.");
     }
     catch (itk::ExceptionObject e)
     {
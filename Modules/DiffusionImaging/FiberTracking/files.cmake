@@ -5,6 +5,9 @@ set(CPP_FILES
   IODataStructures/FiberBundleX/mitkFiberBundleXReader.cpp
   IODataStructures/FiberBundleX/mitkFiberBundleXSerializer.cpp
   IODataStructures/FiberBundleX/mitkTrackvis.cpp
+  IODataStructures/FiberBundleX/mitkFiberContainer.cpp
+  IODataStructures/FiberBundleX/mitkParallelFiberProcessor.cpp
+  IODataStructures/FiberBundleX/mitkFiberBundleXBinaryIO.cpp
   IODataStructures/PlanarFigureComposite/mitkPlanarFigureComposite.cpp
 
   # Interactions
@@ -26,6 +29,9 @@ set(H_FILES
   IODataStructures/FiberBundleX/mitkFiberBundleXReader.h
   IODataStructures/FiberBundleX/mitkFiberBundleXSerializer.h
   IODataStructures/FiberBundleX/mitkTrackvis.h
+  IODataStructures/FiberBundleX/mitkFiberContainer.h
+  IODataStructures/FiberBundleX/mitkParallelFiberProcessor.h
+  IODataStructures/FiberBundleX/mitkFiberBundleXBinaryIO.h
   IODataStructures/mitkFiberfoxParameters.h
 
   # Algorithms
@@ -38,6 +44,7 @@ set(H_FILES
   Algorithms/itkTractsToVectorImageFilter.h
   Algorithms/itkKspaceImageFilter.h
   Algorithms/itkDftImageFilter.h
+  Algorithms/itkComplexFft.h
   Algorithms/itkAddArtifactsToDwiImageFilter.h
   Algorithms/itkFieldmapGeneratorFilter.h
   Algorithms/itkEvaluateDirectionImagesFilter.h
@@ -59,6 +59,7 @@ int DwiDenoising(int argc, char* argv[])
   parser.addArgument("compare", "c", ctkCommandLineParser::Int, "compare radius", us::Any(), true);
   parser.addArgument("joint", "j", ctkCommandLineParser::Bool, "use joint information");
   parser.addArgument("rician", "r", ctkCommandLineParser::Bool, "use rician adaption");
+  parser.addArgument("exact", "e", ctkCommandLineParser::Bool, "use the slow voxelwise computation instead of the blockwise one");
 
   map<string, us::Any> parsedArgs = parser.parseArguments(argc, argv);
   if (parsedArgs.size()==0)
@@ -83,6 +84,9 @@ int DwiDenoising(int argc, char* argv[])
   bool rician = false;
   if (parsedArgs.count("rician"))
     rician = true;
+  bool exact = false;
+  if (parsedArgs.count("exact"))
+    exact = true;
 
   try
   {
@@ -108,6 +112,7 @@ int DwiDenoising(int argc, char* argv[])
 
       filter->SetUseJointInformation(joint);
       filter->SetUseRicianAdaption(rician);
+      filter->SetUseFastMode(!exact);
       filter->SetSearchRadius(search);
       filter->SetComparisonRadius(compare);
       filter->SetVariance(variance);
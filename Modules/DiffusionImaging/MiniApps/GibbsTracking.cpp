@@ -94,6 +94,7 @@ int GibbsTracking(int argc, char* argv[])
     parser.addArgument("shConvention", "s", ctkCommandLineParser::String, "sh coefficient convention (FSL, MRtrix)", string("FSL"), true);
     parser.addArgument("outFile", "o", ctkCommandLineParser::String, "output fiber bundle (.fib)", us::Any(), false);
     parser.addArgument("noFlip", "f", ctkCommandLineParser::Bool, "do not flip input image to match MITK coordinate convention");
+    parser.addArgument("threads", "t", ctkCommandLineParser::Int, "number of threads, more than one samples the particle grid concurrently (not reproducible with a fixed random seed)", us::Any(), true);
 
     map<string, us::Any> parsedArgs = parser.parseArguments(argc, argv);
     if (parsedArgs.size()==0)
@@ -210,6 +211,8 @@ int GibbsTracking(int argc, char* argv[])
 
         gibbsTracker->SetDuplicateImage(false);
         gibbsTracker->SetLoadParameterFile( paramFileName );
+        if (parsedArgs.count("threads"))
+            gibbsTracker->SetNumberOfThreads( us::any_cast<int>(parsedArgs["threads"]) );
 //        gibbsTracker->SetLutPath( "" );
         gibbsTracker->Update();
 
@@ -22,8 +22,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkIGTTimeStamp.h"
 #include "mitkIGTException.h"
 
+#include <algorithm>
+
 mitk::TrackingDeviceSource::TrackingDeviceSource()
-  : mitk::NavigationDataSource(), m_TrackingDevice(NULL)
+  : mitk::NavigationDataSource(), m_TrackingDevice(NULL), m_SampleMode(LatestSample)
 {
 }
 
@@ -72,6 +74,17 @@ void mitk::TrackingDeviceSource::GenerateData()
     mitk::TrackingTool* t = m_TrackingDevice->GetTool(i);
     assert(t);
 
+    // devices which fill the sample queue are read without locking the tool
+    mitk::TrackingSampleQueue* queue = t->GetSampleQueue();
+    if (queue->GetNumberOfAddedSamples() > 0)
+    {
+      mitk::TrackingSampleQueue::Sample sample;
+      bool newSample = (m_SampleMode == AllSamples) ? queue->Pop(sample) : queue->PopLatest(sample);
+      if (newSample)
+        this->SetOutputFromSample(nd, sample);
+      continue;
+    }
+
     if ((t->IsEnabled() == false) || (t->IsDataValid() == false))
     {
       nd->SetDataValid(false);
@@ -94,6 +107,30 @@ void mitk::TrackingDeviceSource::GenerateData()
   }
 }
 
+void mitk::TrackingDeviceSource::SetOutputFromSample(mitk::NavigationData* nd, const mitk::TrackingSampleQueue::Sample& sample)
+{
+  nd->SetIGTTimeStamp(sample.IGTTimeStamp);
+  nd->SetDataValid(sample.DataValid);
+  if (!sample.DataValid)
+    return;
+
+  nd->SetPosition(sample.Position);
+  nd->SetOrientation(sample.Orientation);
+  nd->SetOrientationAccuracy(sample.TrackingError);
+  nd->SetPositionAccuracy(sample.TrackingError);
+}
+
+unsigned int mitk::TrackingDeviceSource::GetNumberOfPendingSamples() const
+{
+  if (m_TrackingDevice.IsNull())
+    return 0;
+
+  unsigned int pendingSamples = 0;
+  for (unsigned int i = 0; i < m_TrackingDevice->GetToolCount(); ++i)
+    pendingSamples = std::max(pendingSamples, m_TrackingDevice->GetTool(i)->GetSampleQueue()->GetNumberOfSamples());
+  return pendingSamples;
+}
+
 void mitk::TrackingDeviceSource::SetTrackingDevice( mitk::TrackingDevice* td )
 {
   MITK_DEBUG << "Setting TrackingDevice to " << td;
@@ -160,6 +197,11 @@ void mitk::TrackingDeviceSource::StartTracking()
     throw std::invalid_argument("mitk::TrackingDeviceSource: No tracking device set");
   if (m_TrackingDevice->GetState() == mitk::TrackingDevice::Tracking)
     return;
+
+  // discard samples of a previous tracking session
+  for (unsigned int i = 0; i < m_TrackingDevice->GetToolCount(); ++i)
+    m_TrackingDevice->GetTool(i)->GetSampleQueue()->Clear();
+
   if (m_TrackingDevice->StartTracking() == false)
     throw std::runtime_error("mitk::TrackingDeviceSource: Could not start tracking");
 }
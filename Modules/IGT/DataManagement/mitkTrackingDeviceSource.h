@@ -37,6 +37,15 @@ namespace mitk {
   * \warning If a tool is removed from the tracking device, there will be a mismatch between
   * the outputs and the tool number!
   *
+  * Tracking devices which fill the sample queues of their tools (see
+  * mitk::TrackingTool::GetSampleQueue()) are read without locking the tools. For them,
+  * the SampleMode decides what an update delivers: with LatestSample (default), the
+  * outputs contain the newest sample and older ones are discarded; with AllSamples, each
+  * update delivers the next sample, so that downstream filters (e.g.
+  * mitk::NavigationDataSmoothingFilter, mitk::NavigationDataRecorder) see every sample at
+  * the rate of the hardware. Update until GetNumberOfPendingSamples() is zero to consume
+  * all of them. Outputs of tools without a new sample are not changed.
+  *
   * \ingroup IGT
   */
   class MitkIGT_EXPORT TrackingDeviceSource : public NavigationDataSource
@@ -46,6 +55,8 @@ namespace mitk {
     itkFactorylessNewMacro(Self)
     itkCloneMacro(Self)
 
+    enum SampleMode { LatestSample, AllSamples };
+
     /**
     * \brief sets the tracking device that will be used as a source for tracking data
     */
@@ -108,6 +119,17 @@ namespace mitk {
     */
     virtual void UpdateOutputInformation();
 
+    /**
+    * \brief Sets whether an update delivers the newest or the next sample of each tool. Default is LatestSample.
+    */
+    itkSetMacro(SampleMode, SampleMode);
+    itkGetConstMacro(SampleMode, SampleMode);
+
+    /**
+    * \brief Returns the highest number of samples which are waiting in the queue of a tool.
+    */
+    unsigned int GetNumberOfPendingSamples() const;
+
   protected:
     TrackingDeviceSource();
     virtual ~TrackingDeviceSource();
@@ -129,7 +151,13 @@ namespace mitk {
     **/
     void CreateOutputs();
 
+    /**
+    * \brief Copies a sample of a tool into its output NavigationData
+    **/
+    void SetOutputFromSample(mitk::NavigationData* nd, const mitk::TrackingSampleQueue::Sample& sample);
+
     mitk::TrackingDevice::Pointer m_TrackingDevice;  ///< the tracking device that is used as a source for this filter object
+    SampleMode m_SampleMode;                         ///< whether an update delivers the newest or the next sample of each tool
   };
 } // namespace mitk
 #endif /* MITKTrackingDeviceSource_H_HEADER_INCLUDED_ */
\ No newline at end of file
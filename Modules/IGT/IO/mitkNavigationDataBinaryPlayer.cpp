@@ -0,0 +1,242 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkNavigationDataBinaryPlayer.h"
+
+#include <mitkIGTTimeStamp.h>
+
+#include "mitkIGTException.h"
+
+mitk::NavigationDataBinaryPlayer::NavigationDataBinaryPlayer()
+  : m_Repeat(false),
+    m_CurPlayerState(PlayerStopped),
+    m_CurrentTimeStep(0),
+    m_StartPlayingTimeStamp(0.0),
+    m_PauseTimeStamp(0.0),
+    m_TimeStampSinceStart(0.0)
+{
+  this->SetName("Navigation Data Binary Player Source");
+
+  // to get a start time
+  mitk::IGTTimeStamp::GetInstance()->Start(this);
+}
+
+mitk::NavigationDataBinaryPlayer::~NavigationDataBinaryPlayer()
+{
+  this->StopPlaying();
+  mitk::IGTTimeStamp::GetInstance()->Stop(this);
+}
+
+void mitk::NavigationDataBinaryPlayer::SetFileName(const std::string& fileName)
+{
+  NavigationDataBinaryReader::Pointer reader = NavigationDataBinaryReader::New();
+  reader->Open(fileName);
+
+  unsigned int numberOfTools = reader->GetNumberOfTools();
+  if ( this->GetNumberOfOutputs() == 0 )
+  {
+    this->SetNumberOfRequiredOutputs(numberOfTools);
+    for ( unsigned int n = 0; n < numberOfTools; ++n )
+    {
+      this->SetNthOutput(n, this->MakeOutput(n));
+    }
+  }
+  else if ( this->GetNumberOfOutputs() != numberOfTools )
+  {
+    mitkThrowException(mitk::IGTException)
+      << "Number of tools cannot be changed in existing player. Please create "
+      << "a new player, if the file has another number of tools.";
+  }
+
+  for ( unsigned int n = 0; n < numberOfTools; ++n )
+  {
+    this->GetOutput(n)->SetName(reader->GetToolName(n));
+  }
+
+  m_Reader = reader;
+  m_CurPlayerState = PlayerStopped;
+  m_CurrentTimeStep = 0;
+  m_TimeStampSinceStart = 0;
+  this->Modified();
+}
+
+void mitk::NavigationDataBinaryPlayer::UpdateOutputInformation()
+{
+  this->Modified();  // make sure that we need to be updated
+  Superclass::UpdateOutputInformation();
+}
+
+void mitk::NavigationDataBinaryPlayer::GenerateData()
+{
+  if ( m_Reader.IsNull() || m_Reader->GetNumberOfTimeSteps() == 0 )
+  {
+    MITK_WARN << "Cannot do anything without recorded navigation datas.";
+    return;
+  }
+
+  if ( m_CurPlayerState == PlayerStopped )
+  {
+    //The output is not valid anymore
+    this->GraftEmptyOutput();
+    return;
+  }
+
+  if ( m_CurPlayerState == PlayerRunning )
+  {
+    m_TimeStampSinceStart = mitk::IGTTimeStamp::GetInstance()->GetElapsed() - m_StartPlayingTimeStamp;
+
+    // timestamps are relative to the first time step, so playing starts immediately
+    m_CurrentTimeStep = m_Reader->FindTimeStep(m_TimeStampSinceStart + m_Reader->GetTimeStamp(0));
+  }
+
+  for ( unsigned int index = 0; index < this->GetNumberOfOutputs(); index++ )
+  {
+    mitk::NavigationData* output = this->GetOutput(index);
+    if ( !output ) { mitkThrowException(mitk::IGTException) << "Output of index " << index << " is null."; }
+
+    m_Reader->GetNavigationData(m_CurrentTimeStep, index, output);
+  }
+
+  // stop playing if the last navigation datas were put into the outputs
+  if ( m_CurPlayerState == PlayerRunning && this->IsAtEnd() )
+  {
+    this->StopPlaying();
+
+    // start playing again if repeat is enabled
+    if ( m_Repeat ) { this->StartPlaying(); }
+  }
+}
+
+void mitk::NavigationDataBinaryPlayer::GraftEmptyOutput()
+{
+  for ( unsigned int index = 0; index < this->GetNumberOfOutputs(); index++ )
+  {
+    mitk::NavigationData* output = this->GetOutput(index);
+    assert(output);
+
+    mitk::NavigationData::PositionType position;
+    mitk::NavigationData::OrientationType orientation(0.0,0.0,0.0,0.0);
+    position.Fill(0.0);
+
+    output->SetPosition(position);
+    output->SetOrientation(orientation);
+    output->SetDataValid(false);
+  }
+}
+
+void mitk::NavigationDataBinaryPlayer::StartPlaying()
+{
+  if ( m_Reader.IsNull() )
+  {
+    mitkThrowException(mitk::IGTException) << "File name has to be set before playing.";
+  }
+
+  m_CurPlayerState = PlayerRunning;
+  m_CurrentTimeStep = 0;
+
+  // reset playing timestamps
+  m_PauseTimeStamp = 0;
+  m_TimeStampSinceStart = 0;
+
+  // timestamp for indicating playing start set to current elapsed time
+  m_StartPlayingTimeStamp = mitk::IGTTimeStamp::GetInstance()->GetElapsed();
+}
+
+void mitk::NavigationDataBinaryPlayer::StopPlaying()
+{
+  m_CurPlayerState = PlayerStopped;
+}
+
+void mitk::NavigationDataBinaryPlayer::Pause()
+{
+  //player runs and pause was called -> pause the player
+  if ( m_CurPlayerState == PlayerRunning )
+  {
+    m_CurPlayerState = PlayerPaused;
+    m_PauseTimeStamp = mitk::IGTTimeStamp::GetInstance()->GetElapsed();
+  }
+  else
+  {
+    MITK_ERROR << "Player is either not started or already is paused" << std::endl;
+  }
+}
+
+void mitk::NavigationDataBinaryPlayer::Resume()
+{
+  // player is in pause mode -> play at the last position
+  if ( m_CurPlayerState == PlayerPaused )
+  {
+    m_CurPlayerState = PlayerRunning;
+
+    // in this case m_StartPlayingTimeStamp is set to the total elapsed time with NO playback
+    m_StartPlayingTimeStamp = mitk::IGTTimeStamp::GetInstance()->GetElapsed()
+      - (m_PauseTimeStamp - m_StartPlayingTimeStamp);
+  }
+  else
+  {
+    MITK_ERROR << "Player is not paused!" << std::endl;
+  }
+}
+
+void mitk::NavigationDataBinaryPlayer::SeekToTimeStamp(TimeStampType timeStampSinceStart)
+{
+  if ( m_Reader.IsNull() )
+  {
+    mitkThrowException(mitk::IGTException) << "File name has to be set before seeking.";
+  }
+
+  TimeStampType now = mitk::IGTTimeStamp::GetInstance()->GetElapsed();
+  if ( m_CurPlayerState == PlayerStopped )
+  {
+    m_CurPlayerState = PlayerPaused;
+    m_PauseTimeStamp = now;
+  }
+
+  // move the start of playing, so the time since start is the requested one
+  m_StartPlayingTimeStamp = (m_CurPlayerState == PlayerPaused ? m_PauseTimeStamp : now) - timeStampSinceStart;
+  m_TimeStampSinceStart = timeStampSinceStart;
+
+  if ( m_Reader->GetNumberOfTimeSteps() > 0 )
+  {
+    m_CurrentTimeStep = m_Reader->FindTimeStep(timeStampSinceStart + m_Reader->GetTimeStamp(0));
+  }
+  this->Modified();
+}
+
+mitk::NavigationDataBinaryPlayer::PlayerState mitk::NavigationDataBinaryPlayer::GetCurrentPlayerState()
+{
+  return m_CurPlayerState;
+}
+
+mitk::NavigationDataBinaryPlayer::TimeStampType mitk::NavigationDataBinaryPlayer::GetTimeStampSinceStart()
+{
+  return m_TimeStampSinceStart;
+}
+
+unsigned int mitk::NavigationDataBinaryPlayer::GetNumberOfSnapshots()
+{
+  return m_Reader.IsNull() ? 0 : m_Reader->GetNumberOfTimeSteps();
+}
+
+unsigned int mitk::NavigationDataBinaryPlayer::GetCurrentSnapshotNumber()
+{
+  return m_CurrentTimeStep;
+}
+
+bool mitk::NavigationDataBinaryPlayer::IsAtEnd()
+{
+  return m_CurrentTimeStep + 1 >= this->GetNumberOfSnapshots();
+}
@@ -0,0 +1,134 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKNavigationDataBinaryPlayer_H_HEADER_INCLUDED_
+#define MITKNavigationDataBinaryPlayer_H_HEADER_INCLUDED_
+
+#include "mitkNavigationDataSource.h"
+#include "mitkNavigationDataBinaryReader.h"
+
+namespace mitk {
+  /**Documentation
+  * \brief Plays files written by mitk::NavigationDataBinaryWriter (e.g. via
+  * mitk::NavigationDataRecorder::SetFileName()) in real time.
+  *
+  * Works like mitk::NavigationDataPlayer, but reads the navigation datas directly
+  * from the memory mapped file instead of a mitk::NavigationDataSet, so recordings
+  * do not have to fit into memory. The time step belonging to the current playing
+  * time is found by binary search, which also allows to jump to any position of
+  * the recording with SeekToTimeStamp().
+  *
+  * While the player is paused, the outputs keep the navigation datas of the
+  * current position; while it is stopped, the outputs are invalid.
+  *
+  * \ingroup IGT
+  */
+  class MitkIGT_EXPORT NavigationDataBinaryPlayer : public NavigationDataSource
+  {
+  public:
+    mitkClassMacro(NavigationDataBinaryPlayer, NavigationDataSource);
+    itkFactorylessNewMacro(Self)
+    itkCloneMacro(Self)
+
+    enum PlayerState { PlayerStopped, PlayerRunning, PlayerPaused };
+    typedef mitk::NavigationData::TimeStampType TimeStampType;
+
+    /**
+    * \brief Opens the given file and creates one output per recorded tool.
+    * @throw mitk::IGTIOException if the file cannot be read
+    * @throw mitk::IGTException if the player already has outputs for another number of tools
+    */
+    void SetFileName(const std::string& fileName);
+
+    itkGetConstObjectMacro(Reader, NavigationDataBinaryReader);
+
+    /**
+    * \brief Set to true if the player should start again after the last time step.
+    */
+    itkSetMacro(Repeat, bool);
+    itkGetMacro(Repeat, bool);
+
+    /**
+    * \brief Used for pipeline update just to tell the pipeline that we always have to update
+    */
+    virtual void UpdateOutputInformation();
+
+    /**
+    * \brief Starts playing at the first time step.
+    * @throw mitk::IGTException if no file was set
+    */
+    void StartPlaying();
+
+    void StopPlaying();
+
+    void Pause();
+
+    void Resume();
+
+    /**
+    * \brief Continues playing (or pausing) at the given time, measured from the first time step
+    * of the recording. A stopped player is paused at that time.
+    * @throw mitk::IGTException if no file was set
+    */
+    void SeekToTimeStamp(TimeStampType timeStampSinceStart);
+
+    PlayerState GetCurrentPlayerState();
+
+    TimeStampType GetTimeStampSinceStart();
+
+    unsigned int GetNumberOfSnapshots();
+
+    unsigned int GetCurrentSnapshotNumber();
+
+    /**
+    * \return true if the last time step is in the outputs
+    */
+    bool IsAtEnd();
+
+  protected:
+    NavigationDataBinaryPlayer();
+    virtual ~NavigationDataBinaryPlayer();
+
+    /**
+    * \brief Set outputs to the navigation datas of the time step corresponding to the current time.
+    */
+    virtual void GenerateData();
+
+    void GraftEmptyOutput();
+
+    NavigationDataBinaryReader::Pointer m_Reader;
+
+    bool m_Repeat;
+
+    PlayerState m_CurPlayerState;
+
+    unsigned int m_CurrentTimeStep;
+
+    /**
+    * \brief The start time of the playing, moved by Resume() and SeekToTimeStamp().
+    */
+    TimeStampType m_StartPlayingTimeStamp;
+
+    /**
+    * \brief Stores the time when a pause began.
+    */
+    TimeStampType m_PauseTimeStamp;
+
+    TimeStampType m_TimeStampSinceStart;
+  };
+} // namespace mitk
+
+#endif /* MITKNavigationDataBinaryPlayer_H_HEADER_INCLUDED_ */
@@ -0,0 +1,169 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkNavigationDataBinaryReader.h"
+
+#include "mitkIGTException.h"
+#include "mitkIGTIOException.h"
+
+#include <itksys/SystemTools.hxx>
+
+#include <cstring>
+#include <fstream>
+
+mitk::NavigationDataBinaryReader::NavigationDataBinaryReader()
+  : m_NumberOfTimeSteps(0),
+    m_MappedFile(mitk::MemoryMappedFile::New()),
+    m_Records(NULL)
+{
+}
+
+mitk::NavigationDataBinaryReader::~NavigationDataBinaryReader()
+{
+}
+
+mitk::NavigationDataSet::Pointer mitk::NavigationDataBinaryReader::Read(std::string fileName)
+{
+  this->Open(fileName);
+
+  mitk::NavigationDataSet::Pointer navigationDataSet = mitk::NavigationDataSet::New(this->GetNumberOfTools());
+  for ( unsigned int timeStep = 0; timeStep < m_NumberOfTimeSteps; ++timeStep )
+  {
+    std::vector<mitk::NavigationData::Pointer> navigationDatas;
+    for ( unsigned int tool = 0; tool < this->GetNumberOfTools(); ++tool )
+    {
+      mitk::NavigationData::Pointer navigationData = mitk::NavigationData::New();
+      this->GetNavigationData(timeStep, tool, navigationData);
+      navigationData->SetName(m_ToolNames[tool]);
+      navigationDatas.push_back(navigationData);
+    }
+    navigationDataSet->AddNavigationDatas(navigationDatas);
+  }
+  return navigationDataSet;
+}
+
+void mitk::NavigationDataBinaryReader::Open(const std::string& fileName)
+{
+  m_FileName = fileName;
+  m_ToolNames.clear();
+  m_NumberOfTimeSteps = 0;
+  m_MappedFile->Unmap();
+  m_Records = NULL;
+
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  char header[NavigationDataBinaryWriter::HEADER_SIZE];
+  itk::uint32_t version = 0;
+  itk::uint32_t numberOfTools = 0;
+  if ( file.read(header, sizeof(header)) )
+  {
+    memcpy(&version, header + 8, sizeof(version));
+    memcpy(&numberOfTools, header + 12, sizeof(numberOfTools));
+  }
+  if ( ! file || memcmp(header, NavigationDataBinaryWriter::FILE_IDENTIFIER, strlen(NavigationDataBinaryWriter::FILE_IDENTIFIER)) != 0
+    || version != NavigationDataBinaryWriter::FILE_VERSION )
+  {
+    mitkThrowException(mitk::IGTIOException) << fileName << " is not a navigation data file or has an unsupported version.";
+  }
+
+  for ( unsigned int tool = 0; tool < numberOfTools; ++tool )
+  {
+    char name[NavigationDataBinaryWriter::TOOL_NAME_SIZE];
+    if ( ! file.read(name, sizeof(name)) )
+    {
+      mitkThrowException(mitk::IGTIOException) << "Header of the navigation data file " << fileName << " is incomplete.";
+    }
+    name[sizeof(name) - 1] = '\0';
+    m_ToolNames.push_back(name);
+  }
+  file.close();
+
+  // an incomplete last time step (e.g. after a crash while recording) is ignored
+  itk::uint64_t dataOffset = NavigationDataBinaryWriter::GetDataOffset(numberOfTools);
+  itk::uint64_t fileSize = itksys::SystemTools::FileLength(fileName.c_str());
+  itk::uint64_t timeStepSize = numberOfTools * sizeof(NavigationDataBinaryWriter::Record);
+  if ( timeStepSize == 0 || fileSize <= dataOffset ) { return; }
+
+  unsigned int numberOfTimeSteps = (fileSize - dataOffset) / timeStepSize;
+  if ( numberOfTimeSteps == 0 ) { return; }
+
+  if ( ! m_MappedFile->Map(fileName, dataOffset, numberOfTimeSteps * timeStepSize) )
+  {
+    mitkThrowException(mitk::IGTIOException) << "Could not map the navigation data file " << fileName;
+  }
+  m_Records = static_cast<const NavigationDataBinaryWriter::Record*>(m_MappedFile->GetData());
+  m_NumberOfTimeSteps = numberOfTimeSteps;
+}
+
+unsigned int mitk::NavigationDataBinaryReader::GetNumberOfTools() const
+{
+  return m_ToolNames.size();
+}
+
+std::string mitk::NavigationDataBinaryReader::GetToolName(unsigned int tool) const
+{
+  if ( tool >= m_ToolNames.size() )
+  {
+    mitkThrowException(mitk::IGTException) << "Tool " << tool << " does not exist, the file has " << m_ToolNames.size() << " tools.";
+  }
+  return m_ToolNames[tool];
+}
+
+unsigned int mitk::NavigationDataBinaryReader::GetNumberOfTimeSteps() const
+{
+  return m_NumberOfTimeSteps;
+}
+
+mitk::NavigationDataBinaryReader::TimeStampType mitk::NavigationDataBinaryReader::GetTimeStamp(unsigned int timeStep) const
+{
+  return this->GetRecord(timeStep, 0).TimeStamp;
+}
+
+unsigned int mitk::NavigationDataBinaryReader::FindTimeStep(TimeStampType timeStamp) const
+{
+  // binary search for the first time step after the given timestamp
+  const unsigned int numberOfTools = this->GetNumberOfTools();
+  unsigned int first = 0;
+  unsigned int count = m_NumberOfTimeSteps;
+  while ( count > 0 )
+  {
+    unsigned int step = count / 2;
+    if ( m_Records[(first + step) * numberOfTools].TimeStamp <= timeStamp )
+    {
+      first += step + 1;
+      count -= step + 1;
+    }
+    else
+    {
+      count = step;
+    }
+  }
+  return first > 0 ? first - 1 : 0;
+}
+
+void mitk::NavigationDataBinaryReader::GetNavigationData(unsigned int timeStep, unsigned int tool, mitk::NavigationData* navigationData) const
+{
+  NavigationDataBinaryWriter::RecordToNavigationData(this->GetRecord(timeStep, tool), navigationData);
+}
+
+const mitk::NavigationDataBinaryWriter::Record& mitk::NavigationDataBinaryReader::GetRecord(unsigned int timeStep, unsigned int tool) const
+{
+  if ( timeStep >= m_NumberOfTimeSteps || tool >= m_ToolNames.size() )
+  {
+    mitkThrowException(mitk::IGTException) << "Time step " << timeStep << " of tool " << tool << " does not exist in "
+      << m_FileName << " (" << m_NumberOfTimeSteps << " time steps, " << m_ToolNames.size() << " tools).";
+  }
+  return m_Records[timeStep * m_ToolNames.size() + tool];
+}
@@ -0,0 +1,97 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKNavigationDataBinaryReader_H_HEADER_INCLUDED_
+#define MITKNavigationDataBinaryReader_H_HEADER_INCLUDED_
+
+#include "mitkNavigationDataReaderInterface.h"
+#include "mitkNavigationDataBinaryWriter.h"
+
+#include <mitkMemoryMappedFile.h>
+
+namespace mitk {
+  /**
+  * \brief Gives random access to a file written by mitk::NavigationDataBinaryWriter.
+  *
+  * The records of the file are memory mapped by Open(), so only the time steps
+  * which are actually accessed are loaded by the operating system. FindTimeStep()
+  * looks up a timestamp by binary search; the timestamps of the first tool are
+  * expected to be non-decreasing, as they are in recordings of
+  * mitk::NavigationDataRecorder.
+  *
+  * Read() converts the whole file into a mitk::NavigationDataSet for use with the
+  * other players.
+  *
+  * \ingroup IGT
+  */
+  class MitkIGT_EXPORT NavigationDataBinaryReader : public NavigationDataReaderInterface
+  {
+  public:
+    mitkClassMacro(NavigationDataBinaryReader, NavigationDataReaderInterface);
+    itkNewMacro(Self);
+
+    typedef mitk::NavigationData::TimeStampType TimeStampType;
+
+    /**
+    * \brief Reads the whole file into a new mitk::NavigationDataSet.
+    * @throw mitk::IGTIOException if the file cannot be opened or is no navigation data file
+    */
+    virtual mitk::NavigationDataSet::Pointer Read(std::string fileName);
+
+    /**
+    * \brief Reads the header and maps the records of the given file.
+    * @throw mitk::IGTIOException if the file cannot be opened or is no navigation data file
+    */
+    void Open(const std::string& fileName);
+
+    unsigned int GetNumberOfTools() const;
+
+    std::string GetToolName(unsigned int tool) const;
+
+    /** \brief Number of complete time steps in the file. */
+    unsigned int GetNumberOfTimeSteps() const;
+
+    /** \brief Timestamp of the first tool at the given time step. */
+    TimeStampType GetTimeStamp(unsigned int timeStep) const;
+
+    /**
+    * \brief Returns the last time step whose timestamp is not greater than the given one,
+    * or 0 if the given timestamp is before the first time step.
+    */
+    unsigned int FindTimeStep(TimeStampType timeStamp) const;
+
+    /**
+    * \brief Copies the state of the given tool at the given time step into the given navigation data.
+    * @throw mitk::IGTException if the time step or tool does not exist
+    */
+    void GetNavigationData(unsigned int timeStep, unsigned int tool, mitk::NavigationData* navigationData) const;
+
+  protected:
+    NavigationDataBinaryReader();
+    virtual ~NavigationDataBinaryReader();
+
+    const NavigationDataBinaryWriter::Record& GetRecord(unsigned int timeStep, unsigned int tool) const;
+
+  private:
+    std::string                     m_FileName;
+    std::vector<std::string>        m_ToolNames;
+    unsigned int                    m_NumberOfTimeSteps;
+    mitk::MemoryMappedFile::Pointer m_MappedFile;
+    const NavigationDataBinaryWriter::Record* m_Records;
+  };
+} // namespace mitk
+
+#endif // MITKNavigationDataBinaryReader_H_HEADER_INCLUDED_
@@ -0,0 +1,202 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkNavigationDataBinaryWriter.h"
+
+#include "mitkIGTException.h"
+#include "mitkIGTIOException.h"
+
+#include <algorithm>
+#include <cstring>
+
+const char* mitk::NavigationDataBinaryWriter::FILE_EXTENSION = ".ndbin";
+const char* mitk::NavigationDataBinaryWriter::FILE_IDENTIFIER = "MITKNDB";
+const itk::uint32_t mitk::NavigationDataBinaryWriter::FILE_VERSION = 1;
+
+mitk::NavigationDataBinaryWriter::NavigationDataBinaryWriter()
+  : m_NumberOfTools(0),
+    m_NumberOfTimeSteps(0)
+{
+}
+
+mitk::NavigationDataBinaryWriter::~NavigationDataBinaryWriter()
+{
+  this->Close();
+}
+
+itk::uint64_t mitk::NavigationDataBinaryWriter::GetDataOffset(unsigned int numberOfTools)
+{
+  return HEADER_SIZE + static_cast<itk::uint64_t>(numberOfTools) * TOOL_NAME_SIZE;
+}
+
+void mitk::NavigationDataBinaryWriter::NavigationDataToRecord(const mitk::NavigationData* navigationData, Record& record)
+{
+  memset(&record, 0, sizeof(Record));
+
+  record.TimeStamp = navigationData->GetIGTTimeStamp();
+
+  mitk::NavigationData::PositionType position = navigationData->GetPosition();
+  for ( unsigned int i = 0; i < 3; ++i ) { record.Position[i] = position[i]; }
+
+  mitk::NavigationData::OrientationType orientation = navigationData->GetOrientation();
+  for ( unsigned int i = 0; i < 4; ++i ) { record.Orientation[i] = orientation[i]; }
+
+  mitk::NavigationData::CovarianceMatrixType covariance = navigationData->GetCovErrorMatrix();
+  unsigned int element = 0;
+  for ( unsigned int row = 0; row < 6; ++row )
+  {
+    for ( unsigned int column = row; column < 6; ++column )
+    {
+      record.Covariance[element++] = covariance[row][column];
+    }
+  }
+
+  if ( navigationData->IsDataValid() ) { record.Flags |= DataValidFlag; }
+  if ( navigationData->GetHasPosition() ) { record.Flags |= HasPositionFlag; }
+  if ( navigationData->GetHasOrientation() ) { record.Flags |= HasOrientationFlag; }
+}
+
+void mitk::NavigationDataBinaryWriter::RecordToNavigationData(const Record& record, mitk::NavigationData* navigationData)
+{
+  navigationData->SetIGTTimeStamp(record.TimeStamp);
+
+  mitk::NavigationData::PositionType position;
+  for ( unsigned int i = 0; i < 3; ++i ) { position[i] = record.Position[i]; }
+  navigationData->SetPosition(position);
+
+  mitk::NavigationData::OrientationType orientation(record.Orientation[0], record.Orientation[1],
+    record.Orientation[2], record.Orientation[3]);
+  navigationData->SetOrientation(orientation);
+
+  mitk::NavigationData::CovarianceMatrixType covariance;
+  unsigned int element = 0;
+  for ( unsigned int row = 0; row < 6; ++row )
+  {
+    for ( unsigned int column = row; column < 6; ++column )
+    {
+      covariance[row][column] = covariance[column][row] = record.Covariance[element++];
+    }
+  }
+  navigationData->SetCovErrorMatrix(covariance);
+
+  navigationData->SetDataValid((record.Flags & DataValidFlag) != 0);
+  navigationData->SetHasPosition((record.Flags & HasPositionFlag) != 0);
+  navigationData->SetHasOrientation((record.Flags & HasOrientationFlag) != 0);
+}
+
+void mitk::NavigationDataBinaryWriter::Open(const std::string& fileName, const std::vector<std::string>& toolNames)
+{
+  this->Close();
+
+  m_File.open(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if ( ! m_File.is_open() )
+  {
+    mitkThrowException(mitk::IGTIOException) << "Could not create the navigation data file " << fileName;
+  }
+
+  m_FileName = fileName;
+  m_NumberOfTools = toolNames.size();
+  m_NumberOfTimeSteps = 0;
+  m_Records.resize(m_NumberOfTools);
+
+  char header[HEADER_SIZE];
+  memset(header, 0, sizeof(header));
+  memcpy(header, FILE_IDENTIFIER, strlen(FILE_IDENTIFIER));
+  memcpy(header + 8, &FILE_VERSION, sizeof(itk::uint32_t));
+  itk::uint32_t numberOfTools = m_NumberOfTools;
+  memcpy(header + 12, &numberOfTools, sizeof(itk::uint32_t));
+  m_File.write(header, sizeof(header));
+
+  for ( std::vector<std::string>::const_iterator it = toolNames.begin(); it != toolNames.end(); ++it )
+  {
+    char name[TOOL_NAME_SIZE];
+    memset(name, 0, sizeof(name));
+    memcpy(name, it->c_str(), std::min<size_t>(it->size(), TOOL_NAME_SIZE - 1));
+    m_File.write(name, sizeof(name));
+  }
+
+  if ( m_File.fail() )
+  {
+    m_File.close();
+    mitkThrowException(mitk::IGTIOException) << "Could not write the header of the navigation data file " << fileName;
+  }
+}
+
+void mitk::NavigationDataBinaryWriter::Close()
+{
+  if ( ! m_File.is_open() ) { return; }
+
+  m_File.close();
+  if ( m_File.fail() )
+  {
+    MITK_ERROR("NavigationDataBinaryWriter") << "Error while writing the navigation data file " << m_FileName;
+  }
+}
+
+bool mitk::NavigationDataBinaryWriter::GetIsOpen() const
+{
+  return m_File.is_open();
+}
+
+void mitk::NavigationDataBinaryWriter::AddTimeStep(const std::vector<mitk::NavigationData::Pointer>& navigationDatas)
+{
+  if ( ! m_File.is_open() )
+  {
+    mitkThrowException(mitk::IGTException) << "Navigation data file has to be opened before adding time steps.";
+  }
+  if ( navigationDatas.size() != m_NumberOfTools )
+  {
+    mitkThrowException(mitk::IGTException) << "Time step has " << navigationDatas.size()
+      << " navigation datas, but the file was opened for " << m_NumberOfTools << " tools.";
+  }
+
+  // one write per time step, so the records of a time step stay together
+  for ( unsigned int tool = 0; tool < m_NumberOfTools; ++tool )
+  {
+    NavigationDataToRecord(navigationDatas[tool], m_Records[tool]);
+  }
+  if ( m_NumberOfTools > 0 )
+  {
+    m_File.write(reinterpret_cast<const char*>(&m_Records[0]), m_NumberOfTools * sizeof(Record));
+  }
+  ++m_NumberOfTimeSteps;
+}
+
+void mitk::NavigationDataBinaryWriter::Flush()
+{
+  if ( m_File.is_open() ) { m_File.flush(); }
+}
+
+unsigned int mitk::NavigationDataBinaryWriter::GetNumberOfTimeSteps() const
+{
+  return m_NumberOfTimeSteps;
+}
+
+void mitk::NavigationDataBinaryWriter::Write(const std::string& fileName, mitk::NavigationDataSet::Pointer navigationDataSet)
+{
+  std::vector<std::string> toolNames;
+  for ( unsigned int tool = 0; tool < navigationDataSet->GetNumberOfTools(); ++tool )
+  {
+    toolNames.push_back(navigationDataSet->Size() > 0 ? navigationDataSet->Begin()->at(tool)->GetName() : "");
+  }
+
+  this->Open(fileName, toolNames);
+  for ( mitk::NavigationDataSet::NavigationDataSetIterator it = navigationDataSet->Begin(); it != navigationDataSet->End(); ++it )
+  {
+    this->AddTimeStep(*it);
+  }
+  this->Close();
+}
@@ -0,0 +1,126 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKNavigationDataBinaryWriter_H_HEADER_INCLUDED_
+#define MITKNavigationDataBinaryWriter_H_HEADER_INCLUDED_
+
+#include "mitkNavigationData.h"
+#include "mitkNavigationDataSet.h"
+
+#include <itkObject.h>
+#include <itkIntTypes.h>
+
+#include <fstream>
+
+namespace mitk {
+  /**
+  * \brief Writes navigation data incrementally into a compact binary file.
+  *
+  * The file starts with a header of HEADER_SIZE bytes (identifier, version and
+  * number of tools), followed by the names of the tools (TOOL_NAME_SIZE bytes
+  * each, zero padded). After that, every time step is appended as one Record
+  * per tool. As all records have the same size, time step i of tool t starts at
+  * GetDataOffset(numberOfTools) + (i * numberOfTools + t) * sizeof(Record),
+  * which allows mitk::NavigationDataBinaryReader to map the file and to access
+  * any time step directly. A file whose last time step is incomplete (e.g.
+  * because the application crashed while recording) can still be read up to
+  * the last complete time step.
+  *
+  * Numbers are stored in the byte order of the machine writing the file.
+  *
+  * \ingroup IGT
+  */
+  class MitkIGT_EXPORT NavigationDataBinaryWriter : public itk::Object
+  {
+  public:
+    mitkClassMacro(NavigationDataBinaryWriter, itk::Object);
+    itkNewMacro(Self);
+
+    static const char* FILE_EXTENSION;         ///< ".ndbin"
+    static const char* FILE_IDENTIFIER;        ///< "MITKNDB", first bytes of the header
+    static const itk::uint32_t FILE_VERSION;   ///< stored behind the identifier
+
+    enum { HEADER_SIZE = 16, TOOL_NAME_SIZE = 64 };
+
+    enum RecordFlags
+    {
+      DataValidFlag = 1,
+      HasPositionFlag = 2,
+      HasOrientationFlag = 4
+    };
+
+    /**
+    * \brief State of one tool at one time step.
+    */
+    struct Record
+    {
+      double        TimeStamp;        ///< IGT timestamp of the navigation data
+      double        Position[3];
+      double        Orientation[4];   ///< x, y, z, r as in mitk::Quaternion
+      double        Covariance[21];   ///< upper triangle of the (symmetric) 6x6 covariance matrix, row by row
+      itk::uint32_t Flags;            ///< combination of RecordFlags
+      itk::uint32_t Reserved;
+    };
+
+    /** \brief Position of the first record in a file with the given number of tools. */
+    static itk::uint64_t GetDataOffset(unsigned int numberOfTools);
+
+    static void NavigationDataToRecord(const mitk::NavigationData* navigationData, Record& record);
+    static void RecordToNavigationData(const Record& record, mitk::NavigationData* navigationData);
+
+    /**
+    * \brief Creates (or overwrites) the given file and writes the header.
+    * Longer tool names are truncated to TOOL_NAME_SIZE - 1 characters.
+    * @throw mitk::IGTIOException if the file cannot be created
+    */
+    void Open(const std::string& fileName, const std::vector<std::string>& toolNames);
+
+    void Close();
+
+    bool GetIsOpen() const;
+
+    /**
+    * \brief Appends one time step, i.e. one navigation data per tool.
+    * @throw mitk::IGTException if the file is not open or the number of navigation datas does not match the number of tools
+    */
+    void AddTimeStep(const std::vector<mitk::NavigationData::Pointer>& navigationDatas);
+
+    /** \brief Passes all time steps added so far to the operating system. */
+    void Flush();
+
+    /** \brief Number of time steps added since Open(). */
+    unsigned int GetNumberOfTimeSteps() const;
+
+    /**
+    * \brief Writes a complete mitk::NavigationDataSet into the given file.
+    * @throw mitk::IGTIOException if the file cannot be created
+    */
+    void Write(const std::string& fileName, mitk::NavigationDataSet::Pointer navigationDataSet);
+
+  protected:
+    NavigationDataBinaryWriter();
+    virtual ~NavigationDataBinaryWriter();
+
+  private:
+    std::string         m_FileName;
+    std::ofstream       m_File;
+    unsigned int        m_NumberOfTools;
+    unsigned int        m_NumberOfTimeSteps;
+    std::vector<Record> m_Records;   ///< records of the time step being written, reused for every time step
+  };
+} // namespace mitk
+
+#endif // MITKNavigationDataBinaryWriter_H_HEADER_INCLUDED_
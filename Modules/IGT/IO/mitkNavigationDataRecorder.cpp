@@ -24,6 +24,7 @@ mitk::NavigationDataRecorder::NavigationDataRecorder()
   m_Recording = false;
   m_StandardizedTimeInitialized = false;
   m_RecordCountLimit = -1;
+  m_BinaryWriter = mitk::NavigationDataBinaryWriter::New();
 }
 
 mitk::NavigationDataRecorder::~NavigationDataRecorder()
@@ -60,14 +61,21 @@ void mitk::NavigationDataRecorder::GenerateData()
     }
   }
 
-  // if limitation is set and has been reached, stop recording
-  if ((m_RecordCountLimit > 0) && (m_NavigationDataSet->Size() >= m_RecordCountLimit)) m_Recording = false;
   // We can skip the rest of the method, if recording is deactivated
   if  (!m_Recording) return;
 
+  // if limitation is set and has been reached, stop recording
+  if ((m_RecordCountLimit > 0) && (this->GetNumberOfRecordedSteps() >= m_RecordCountLimit))
+  {
+    m_Recording = false;
+    return;
+  }
 
-  // Add data to set
-  m_NavigationDataSet->AddNavigationDatas(clonedDatas);
+  // Add data to file or set
+  if (m_BinaryWriter->GetIsOpen())
+    m_BinaryWriter->AddTimeStep(clonedDatas);
+  else
+    m_NavigationDataSet->AddNavigationDatas(clonedDatas);
 }
 
 void mitk::NavigationDataRecorder::StartRecording()
@@ -86,6 +94,10 @@ void mitk::NavigationDataRecorder::StartRecording()
 
   if (m_NavigationDataSet.IsNull())
     m_NavigationDataSet = mitk::NavigationDataSet::New(GetNumberOfIndexedInputs());
+
+  // a file stays open until ResetRecording(), so a stopped recording is continued
+  if (! m_BinaryWriter->GetIsOpen())
+    this->OpenFile();
 }
 
 void mitk::NavigationDataRecorder::StopRecording()
@@ -96,20 +108,44 @@ void mitk::NavigationDataRecorder::StopRecording()
     return;
   }
   m_Recording = false;
+  m_BinaryWriter->Flush();
 }
 
 void mitk::NavigationDataRecorder::ResetRecording()
 {
   m_NavigationDataSet = mitk::NavigationDataSet::New(GetNumberOfIndexedInputs());
+  m_BinaryWriter->Close();
 
   if (m_Recording)
   {
     mitk::IGTTimeStamp::GetInstance()->Stop(this);
     mitk::IGTTimeStamp::GetInstance()->Start(this);
+    this->OpenFile();
   }
 }
 
 int mitk::NavigationDataRecorder::GetNumberOfRecordedSteps()
 {
+  if (m_BinaryWriter->GetIsOpen())
+    return m_BinaryWriter->GetNumberOfTimeSteps();
   return m_NavigationDataSet->Size();
-}
\ No newline at end of file
+}
+
+void mitk::NavigationDataRecorder::OpenFile()
+{
+  if (m_FileName.empty()) return;
+
+  std::vector<std::string> toolNames;
+  for (unsigned int index = 0; index < GetNumberOfIndexedInputs(); index++)
+    toolNames.push_back(this->GetInput(index)->GetName());
+
+  try
+  {
+    m_BinaryWriter->Open(m_FileName, toolNames);
+  }
+  catch (...)
+  {
+    m_Recording = false;
+    throw;
+  }
+}
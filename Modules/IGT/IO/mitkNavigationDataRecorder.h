@@ -20,6 +20,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkNavigationDataToNavigationDataFilter.h"
 #include "mitkNavigationData.h"
 #include "mitkNavigationDataSet.h"
+#include "mitkNavigationDataBinaryWriter.h"
 
 namespace mitk
 {
@@ -31,6 +32,11 @@ namespace mitk
   * With StopRecording() the stream is stopped, but can be resumed anytime.
   * To start recording to a new NavigationDataSet, call ResetRecording();
   *
+  * If a file name is set with SetFileName() before recording starts, the data is written
+  * to that file with mitk::NavigationDataBinaryWriter while recording instead of being kept
+  * in the NavigationDataSet, which then stays empty. Such recordings can be played with
+  * mitk::NavigationDataBinaryPlayer or read with mitk::NavigationDataBinaryReader.
+  *
   * \warning Do not add inputs while the recorder ist recording. The recorder can't handle that and will cause a nullpointer exception.
   * \ingroup IGT
   */
@@ -70,8 +76,22 @@ namespace mitk
     */
     itkSetMacro(StandardizeTime, bool);
 
+    /**
+    * \brief Sets the file the data is written to while recording. An empty file name (default)
+    * records into the NavigationDataSet. Changes take effect with the next StartRecording() after
+    * ResetRecording().
+    */
+    itkSetStringMacro(FileName);
+    itkGetStringMacro(FileName);
+
+    /**
+    * \brief Returns the writer of the file recording, which is only open while a file is recorded.
+    */
+    itkGetObjectMacro(BinaryWriter, mitk::NavigationDataBinaryWriter);
+
     /**
     * \brief Starts recording NavigationData into the NAvigationDataSet
+    * @throw mitk::IGTIOException if a file name is set and the file cannot be created
     */
     virtual void StartRecording();
 
@@ -80,6 +100,7 @@ namespace mitk
     *
     * Recording can be resumed to the same Dataset by just calling StartRecording() again.
     * Call ResetRecording() to start recording to a new Dataset;
+    * When recording to a file, everything recorded so far is passed to the operating system.
     */
     virtual void StopRecording();
 
@@ -87,6 +108,7 @@ namespace mitk
     * \brief Resets the Datasets and the timestamp, so a new recording can happen.
     *
     * Do not forget to save the old Dataset, it will be lost after calling this function.
+    * A file which is being recorded is closed.
     */
     virtual void ResetRecording();
 
@@ -100,6 +122,12 @@ namespace mitk
 
     virtual void GenerateData();
 
+    /**
+    * \brief Opens the file to record into, if a file name is set.
+    * @throw mitk::IGTIOException if the file cannot be created; recording is stopped then
+    */
+    void OpenFile();
+
     NavigationDataRecorder();
 
     virtual ~NavigationDataRecorder();
@@ -115,6 +143,10 @@ namespace mitk
     bool m_StandardizedTimeInitialized; //< set to true the first time start recording is called.
 
     int m_RecordCountLimit; ///< limits the number of frames, recording will be stopped if the limit is reached. -1 disables the limit
+
+    std::string m_FileName; ///< file to record into, empty to record into the NavigationDataSet
+
+    mitk::NavigationDataBinaryWriter::Pointer m_BinaryWriter;
   };
 }
 #endif // #define _MITK_POINT_SET_SOURCE_H
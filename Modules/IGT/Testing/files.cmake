@@ -29,6 +29,7 @@ set(MODULE_TESTS
    mitkNavigationDataReferenceTransformFilterTest.cpp
    mitkNavigationDataSequentialPlayerTest.cpp
    mitkNavigationDataSetReaderWriterTest.cpp
+   mitkNavigationDataBinaryReaderWriterTest.cpp
    mitkNavigationDataSourceTest.cpp
    mitkNavigationDataToMessageFilterTest.cpp
    mitkNavigationDataToNavigationDataFilterTest.cpp
@@ -45,6 +46,7 @@ set(MODULE_TESTS
   #  mitkNavigationDataPlayerTest.cpp # random fails see bug 16485.
   #  We decided to won't fix because of complete restructuring via bug 15959.
    mitkTrackingDeviceSourceTest.cpp
+   mitkTrackingSampleQueueTest.cpp
    mitkTrackingDeviceSourceConfiguratorTest.cpp
    mitkNavigationDataEvaluationFilterTest.cpp
    mitkTrackingTypesTest.cpp
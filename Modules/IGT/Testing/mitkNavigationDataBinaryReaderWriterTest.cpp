@@ -0,0 +1,236 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include <mitkTestFixture.h>
+#include <mitkTestingMacros.h>
+
+#include <mitkNavigationDataBinaryWriter.h>
+#include <mitkNavigationDataBinaryReader.h>
+#include <mitkNavigationDataBinaryPlayer.h>
+#include <mitkNavigationDataRecorder.h>
+#include <mitkNavigationDataSequentialPlayer.h>
+#include <mitkIOUtil.h>
+
+#include <cstdio>
+#include <fstream>
+
+//for exceptions
+#include "mitkIGTException.h"
+#include "mitkIGTIOException.h"
+
+class mitkNavigationDataBinaryReaderWriterTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(mitkNavigationDataBinaryReaderWriterTestSuite);
+  MITK_TEST(TestWriteRead);
+  MITK_TEST(TestFindTimeStep);
+  MITK_TEST(TestIncompleteTimeStep);
+  MITK_TEST(TestWrongFile);
+  MITK_TEST(TestRecordToFile);
+  MITK_TEST(TestPlayerSeek);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+
+  static const unsigned int NumberOfTimeSteps = 100;
+
+  mitk::NavigationDataSet::Pointer m_NavigationDataSet;
+  std::string m_FileName;
+
+public:
+
+  void setUp()
+  {
+    // two tools, recorded every 10 ms, the second one is invalid at every third time step
+    m_NavigationDataSet = mitk::NavigationDataSet::New(2);
+    for (unsigned int i = 0; i < NumberOfTimeSteps; i++)
+    {
+      std::vector<mitk::NavigationData::Pointer> navigationDatas;
+      for (unsigned int tool = 0; tool < 2; tool++)
+      {
+        mitk::NavigationData::Pointer nd = mitk::NavigationData::New();
+        mitk::NavigationData::PositionType position;
+        position[0] = i; position[1] = tool; position[2] = i * 0.5;
+        nd->SetPosition(position);
+        nd->SetOrientation(mitk::NavigationData::OrientationType(0.1 * tool, 0.2, 0.3, 0.4 + i));
+        nd->SetPositionAccuracy(0.01 * (i + 1));
+        nd->SetOrientationAccuracy(0.02 * (tool + 1));
+        nd->SetIGTTimeStamp(1000.0 + 10.0 * i);
+        nd->SetDataValid(tool == 0 || i % 3 != 0);
+        nd->SetHasOrientation(tool == 0);
+        nd->SetName(tool == 0 ? "Pointer" : "Reference");
+        navigationDatas.push_back(nd);
+      }
+      m_NavigationDataSet->AddNavigationDatas(navigationDatas);
+    }
+
+    std::ofstream tmpStream;
+    m_FileName = mitk::IOUtil::CreateTemporaryFile(tmpStream, std::string("XXXXXX") + mitk::NavigationDataBinaryWriter::FILE_EXTENSION);
+    tmpStream.close();
+  }
+
+  void tearDown()
+  {
+    std::remove(m_FileName.c_str());
+  }
+
+  void TestWriteRead()
+  {
+    mitk::NavigationDataBinaryWriter::Pointer writer = mitk::NavigationDataBinaryWriter::New();
+    writer->Write(m_FileName, m_NavigationDataSet);
+    CPPUNIT_ASSERT_MESSAGE("Testing if the writer was closed", !writer->GetIsOpen());
+    CPPUNIT_ASSERT_MESSAGE("Testing number of written time steps", writer->GetNumberOfTimeSteps() == NumberOfTimeSteps);
+
+    mitk::NavigationDataBinaryReader::Pointer reader = mitk::NavigationDataBinaryReader::New();
+    reader->Open(m_FileName);
+    CPPUNIT_ASSERT_MESSAGE("Testing number of tools", reader->GetNumberOfTools() == 2);
+    CPPUNIT_ASSERT_MESSAGE("Testing tool names", reader->GetToolName(0) == "Pointer" && reader->GetToolName(1) == "Reference");
+    CPPUNIT_ASSERT_MESSAGE("Testing number of time steps", reader->GetNumberOfTimeSteps() == NumberOfTimeSteps);
+    CPPUNIT_ASSERT_MESSAGE("Testing if the recorded data is equal to the original", compareDataSet(reader->Read(m_FileName)));
+    CPPUNIT_ASSERT_THROW_MESSAGE("Testing if a missing time step throws", reader->GetTimeStamp(NumberOfTimeSteps), mitk::IGTException);
+  }
+
+  void TestFindTimeStep()
+  {
+    mitk::NavigationDataBinaryWriter::Pointer writer = mitk::NavigationDataBinaryWriter::New();
+    writer->Write(m_FileName, m_NavigationDataSet);
+
+    mitk::NavigationDataBinaryReader::Pointer reader = mitk::NavigationDataBinaryReader::New();
+    reader->Open(m_FileName);
+    CPPUNIT_ASSERT_MESSAGE("Testing timestamp before the first time step", reader->FindTimeStep(0.0) == 0);
+    CPPUNIT_ASSERT_MESSAGE("Testing timestamp of the first time step", reader->FindTimeStep(1000.0) == 0);
+    CPPUNIT_ASSERT_MESSAGE("Testing timestamp between two time steps", reader->FindTimeStep(1015.0) == 1);
+    CPPUNIT_ASSERT_MESSAGE("Testing timestamp of a time step", reader->FindTimeStep(1020.0) == 2);
+    CPPUNIT_ASSERT_MESSAGE("Testing timestamp after the last time step", reader->FindTimeStep(1.0e6) == NumberOfTimeSteps - 1);
+
+    for (unsigned int i = 0; i < NumberOfTimeSteps; i++)
+    {
+      CPPUNIT_ASSERT_MESSAGE("Testing if every time step is found by its timestamp", reader->FindTimeStep(reader->GetTimeStamp(i)) == i);
+    }
+  }
+
+  void TestIncompleteTimeStep()
+  {
+    mitk::NavigationDataBinaryWriter::Pointer writer = mitk::NavigationDataBinaryWriter::New();
+    writer->Write(m_FileName, m_NavigationDataSet);
+
+    // simulate a recording which was interrupted in the middle of a time step
+    std::ofstream file(m_FileName.c_str(), std::ios::out | std::ios::binary | std::ios::app);
+    mitk::NavigationDataBinaryWriter::Record record;
+    mitk::NavigationDataBinaryWriter::NavigationDataToRecord(m_NavigationDataSet->GetNavigationDataForIndex(0, 0), record);
+    file.write(reinterpret_cast<const char*>(&record), sizeof(record) + 1);
+    file.close();
+
+    mitk::NavigationDataBinaryReader::Pointer reader = mitk::NavigationDataBinaryReader::New();
+    reader->Open(m_FileName);
+    CPPUNIT_ASSERT_MESSAGE("Testing if the incomplete time step is ignored", reader->GetNumberOfTimeSteps() == NumberOfTimeSteps);
+  }
+
+  void TestWrongFile()
+  {
+    std::ofstream file(m_FileName.c_str());
+    file << "<?xml version=\"1.0\" ?>";
+    file.close();
+
+    mitk::NavigationDataBinaryReader::Pointer reader = mitk::NavigationDataBinaryReader::New();
+    CPPUNIT_ASSERT_THROW_MESSAGE("Testing if other files are rejected", reader->Open(m_FileName), mitk::IGTIOException);
+  }
+
+  void TestRecordToFile()
+  {
+    mitk::NavigationDataSequentialPlayer::Pointer player = mitk::NavigationDataSequentialPlayer::New();
+    player->SetNavigationDataSet(m_NavigationDataSet);
+
+    mitk::NavigationDataRecorder::Pointer recorder = mitk::NavigationDataRecorder::New();
+    recorder->SetStandardizeTime(false);
+    recorder->SetFileName(m_FileName);
+    recorder->ConnectTo(player);
+
+    recorder->StartRecording();
+    while (!player->IsAtEnd())
+    {
+      recorder->Update();
+      player->GoToNextSnapshot();
+    }
+    CPPUNIT_ASSERT_MESSAGE("Testing number of recorded steps", recorder->GetNumberOfRecordedSteps() == static_cast<int>(NumberOfTimeSteps));
+    recorder->StopRecording();
+    CPPUNIT_ASSERT_MESSAGE("Testing if nothing was kept in memory", recorder->GetNavigationDataSet()->Size() == 0);
+
+    // the file can be read while it is still open for recording
+    mitk::NavigationDataBinaryReader::Pointer reader = mitk::NavigationDataBinaryReader::New();
+    CPPUNIT_ASSERT_MESSAGE("Testing if the recorded file is equal to the original", compareDataSet(reader->Read(m_FileName)));
+
+    recorder->ResetRecording();
+    CPPUNIT_ASSERT_MESSAGE("Testing if the file was closed", !recorder->GetBinaryWriter()->GetIsOpen());
+  }
+
+  void TestPlayerSeek()
+  {
+    mitk::NavigationDataBinaryWriter::Pointer writer = mitk::NavigationDataBinaryWriter::New();
+    writer->Write(m_FileName, m_NavigationDataSet);
+
+    mitk::NavigationDataBinaryPlayer::Pointer player = mitk::NavigationDataBinaryPlayer::New();
+    player->SetFileName(m_FileName);
+    CPPUNIT_ASSERT_MESSAGE("Testing number of outputs", player->GetNumberOfOutputs() == 2);
+    CPPUNIT_ASSERT_MESSAGE("Testing number of snapshots", player->GetNumberOfSnapshots() == NumberOfTimeSteps);
+
+    player->Update();
+    CPPUNIT_ASSERT_MESSAGE("Testing if outputs of a stopped player are invalid", !player->GetOutput(0)->IsDataValid());
+
+    player->SeekToTimeStamp(505.0);
+    CPPUNIT_ASSERT_MESSAGE("Testing if seeking pauses a stopped player", player->GetCurrentPlayerState() == mitk::NavigationDataBinaryPlayer::PlayerPaused);
+    player->Update();
+    CPPUNIT_ASSERT_MESSAGE("Testing current snapshot after seeking", player->GetCurrentSnapshotNumber() == 50);
+    CPPUNIT_ASSERT_MESSAGE("Testing output after seeking", player->GetOutput(0)->GetPosition()[0] == 50.0
+      && player->GetOutput(0)->GetIGTTimeStamp() == 1500.0 && player->GetOutput(0)->IsDataValid());
+    CPPUNIT_ASSERT_MESSAGE("Testing name of output", std::string(player->GetOutput(1)->GetName()) == "Reference");
+
+    player->SeekToTimeStamp(1.0e6);
+    player->Update();
+    CPPUNIT_ASSERT_MESSAGE("Testing seeking behind the end", player->IsAtEnd());
+
+    player->Resume();
+    player->Update();
+    CPPUNIT_ASSERT_MESSAGE("Testing if the player stops at the end", player->GetCurrentPlayerState() == mitk::NavigationDataBinaryPlayer::PlayerStopped);
+  }
+
+private:
+
+  /*
+  * compares the given set against the member variable, including the accuracies and flags
+  */
+  bool compareDataSet(mitk::NavigationDataSet::Pointer recorded)
+  {
+    if (recorded->Size() != m_NavigationDataSet->Size() || recorded->GetNumberOfTools() != m_NavigationDataSet->GetNumberOfTools()) {return false;}
+
+    for (unsigned int tool = 0; tool < recorded->GetNumberOfTools(); tool++)
+    {
+      for (unsigned int i = 0; i < recorded->Size(); i++)
+      {
+        mitk::NavigationData::Pointer ref = m_NavigationDataSet->GetNavigationDataForIndex(i,tool);
+        mitk::NavigationData::Pointer rec = recorded->GetNavigationDataForIndex(i,tool);
+        if (!(ref->GetOrientation().as_vector() == rec->GetOrientation().as_vector())) {return false;}
+        if (!(ref->GetPosition().GetVnlVector() == rec->GetPosition().GetVnlVector())) {return false;}
+        if (ref->GetCovErrorMatrix() != rec->GetCovErrorMatrix()) {return false;}
+        if (ref->GetIGTTimeStamp() != rec->GetIGTTimeStamp()) {return false;}
+        if (ref->IsDataValid() != rec->IsDataValid()) {return false;}
+        if (ref->GetHasPosition() != rec->GetHasPosition() || ref->GetHasOrientation() != rec->GetHasOrientation()) {return false;}
+        if (std::string(ref->GetName()) != rec->GetName()) {return false;}
+      }
+    }
+    return true;
+  }
+};
+MITK_TEST_SUITE_REGISTRATION(mitkNavigationDataBinaryReaderWriter)
@@ -0,0 +1,194 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTrackingSampleQueue.h"
+#include "mitkTrackingDeviceSource.h"
+#include "mitkVirtualTrackingDevice.h"
+
+#include "mitkTestingMacros.h"
+#include "itksys/SystemTools.hxx"
+#include <itkMultiThreader.h>
+
+class mitkTrackingSampleQueueTestClass
+{
+public:
+
+  static const unsigned int NumberOfProducedSamples = 100000;
+
+  static mitk::TrackingSampleQueue::Sample CreateSample(double timeStamp)
+  {
+    mitk::TrackingSampleQueue::Sample sample;
+    sample.Position.Fill(timeStamp);
+    sample.Orientation = mitk::Quaternion(0.0, 0.0, 0.0, 1.0);
+    sample.TrackingError = 0.5;
+    sample.DataValid = true;
+    sample.IGTTimeStamp = timeStamp;
+    return sample;
+  }
+
+  static void TestQueue()
+  {
+    mitk::TrackingSampleQueue queue(3);
+    mitk::TrackingSampleQueue::Sample sample;
+    MITK_TEST_CONDITION(queue.GetCapacity() == 3, "Testing GetCapacity()");
+    MITK_TEST_CONDITION(!queue.Pop(sample) && !queue.PopLatest(sample), "Testing Pop() of an empty queue");
+
+    for (unsigned int i = 1; i <= 4; ++i)
+    {
+      queue.Add(CreateSample(i));
+    }
+    MITK_TEST_CONDITION(queue.GetNumberOfSamples() == 3, "Testing if a full queue holds capacity samples");
+    MITK_TEST_CONDITION(queue.GetNumberOfAddedSamples() == 4 && queue.GetNumberOfDroppedSamples() == 1, "Testing if the sample added to a full queue was dropped");
+
+    MITK_TEST_CONDITION(queue.Pop(sample) && sample.IGTTimeStamp == 1.0, "Testing if Pop() returns the oldest sample");
+    queue.Add(CreateSample(5));
+    MITK_TEST_CONDITION(queue.PopLatest(sample) && sample.IGTTimeStamp == 5.0 && sample.Position[0] == 5.0, "Testing if PopLatest() returns the newest sample");
+    MITK_TEST_CONDITION(queue.GetNumberOfSamples() == 0, "Testing if PopLatest() removes all samples");
+
+    // the slots wrap around several times
+    for (unsigned int i = 6; i <= 20; ++i)
+    {
+      queue.Add(CreateSample(i));
+      MITK_TEST_CONDITION(queue.Pop(sample) && sample.IGTTimeStamp == i, "Testing Add() and Pop() of sample " << i);
+    }
+
+    queue.Add(CreateSample(21));
+    queue.Clear();
+    MITK_TEST_CONDITION(!queue.Pop(sample), "Testing Clear()");
+  }
+
+  static void TestOverflow()
+  {
+    mitk::TrackingSampleQueue queue(3);
+    mitk::TrackingSampleQueue::Sample sample;
+    for (unsigned int i = 1; i <= 10; ++i)
+    {
+      queue.Add(CreateSample(i));
+    }
+    MITK_TEST_CONDITION(queue.GetNumberOfDroppedSamples() == 7, "Testing if samples added to a full queue were dropped");
+    MITK_TEST_CONDITION(queue.PopLatest(sample) && sample.IGTTimeStamp == 10.0 && sample.Position[0] == 10.0, "Testing if PopLatest() of an overflowed queue returns the newest sample");
+    MITK_TEST_CONDITION(!queue.PopLatest(sample) && !queue.Pop(sample), "Testing if the newest sample is delivered only once");
+
+    queue.Add(CreateSample(11));
+    queue.Clear();
+    MITK_TEST_CONDITION(!queue.PopLatest(sample), "Testing if Clear() discards the newest sample");
+
+    // the newest pose of an overflowed queue reaches the output of the source
+    mitk::VirtualTrackingDevice::Pointer tracker = mitk::VirtualTrackingDevice::New();
+    tracker->AddTool("T0");
+    mitk::TrackingDeviceSource::Pointer source = mitk::TrackingDeviceSource::New();
+    source->SetTrackingDevice(tracker);
+    mitk::TrackingSampleQueue* toolQueue = tracker->GetTool(0)->GetSampleQueue();
+    unsigned int numberOfSamples = toolQueue->GetCapacity() + 10;
+    for (unsigned int i = 1; i <= numberOfSamples; ++i)
+    {
+      toolQueue->Add(CreateSample(i));
+    }
+    source->Update();
+    mitk::NavigationData* nd = source->GetOutput(0);
+    MITK_TEST_CONDITION(toolQueue->GetNumberOfDroppedSamples() == 10, "Testing if the tool queue overflowed");
+    MITK_TEST_CONDITION(nd->GetIGTTimeStamp() == numberOfSamples && nd->GetPosition()[0] == numberOfSamples, "Testing if LatestSample delivers the newest pose of an overflowed queue");
+  }
+
+  static ITK_THREAD_RETURN_TYPE ProducerThread(void* pInfoStruct)
+  {
+    struct itk::MultiThreader::ThreadInfoStruct * pInfo = (struct itk::MultiThreader::ThreadInfoStruct*)pInfoStruct;
+    mitk::TrackingSampleQueue* queue = (mitk::TrackingSampleQueue*) pInfo->UserData;
+
+    for (unsigned int i = 1; i <= NumberOfProducedSamples; ++i)
+    {
+      queue->Add(CreateSample(i));
+    }
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  static void TestConcurrentAccess()
+  {
+    mitk::TrackingSampleQueue queue(16);
+    itk::MultiThreader::Pointer multiThreader = itk::MultiThreader::New();
+    int threadID = multiThreader->SpawnThread(ProducerThread, &queue);
+
+    // samples have to arrive complete and in order, dropped ones are missing
+    unsigned int received = 0;
+    unsigned int errors = 0;
+    double lastTimeStamp = 0.0;
+    mitk::TrackingSampleQueue::Sample sample;
+    while (received + queue.GetNumberOfDroppedSamples() < NumberOfProducedSamples)
+    {
+      if (!queue.Pop(sample)) continue;
+      ++received;
+      if (sample.IGTTimeStamp <= lastTimeStamp || sample.Position[0] != sample.IGTTimeStamp || sample.Position[2] != sample.IGTTimeStamp)
+        ++errors;
+      lastTimeStamp = sample.IGTTimeStamp;
+    }
+    multiThreader->TerminateThread(threadID);
+
+    MITK_TEST_CONDITION(errors == 0, "Testing if samples arrive complete and in order (" << errors << " errors)");
+    MITK_TEST_CONDITION(received + queue.GetNumberOfDroppedSamples() == NumberOfProducedSamples, "Testing if every sample was received or counted as dropped");
+    MITK_TEST_CONDITION(queue.GetNumberOfSamples() == 0, "Testing if the queue is empty afterwards");
+  }
+
+  static void TestTrackingDeviceSource()
+  {
+    mitk::VirtualTrackingDevice::Pointer tracker = mitk::VirtualTrackingDevice::New();
+    tracker->SetRefreshRate(10);
+    tracker->AddTool("T0");
+    tracker->AddTool("T1");
+
+    mitk::TrackingDeviceSource::Pointer source = mitk::TrackingDeviceSource::New();
+    source->SetTrackingDevice(tracker);
+    MITK_TEST_CONDITION(source->GetSampleMode() == mitk::TrackingDeviceSource::LatestSample, "Testing default sample mode");
+    source->SetSampleMode(mitk::TrackingDeviceSource::AllSamples);
+    source->Connect();
+    source->StartTracking();
+    itksys::SystemTools::Delay(300); // allow the tracking thread to add some samples
+    source->StopTracking();
+
+    MITK_TEST_CONDITION_REQUIRED(source->GetNumberOfPendingSamples() > 1, "Testing if the virtual tracking device added samples");
+
+    // every update delivers the next sample
+    unsigned int updates = 0;
+    double lastTimeStamp = -1.0;
+    bool increasing = true;
+    while (source->GetNumberOfPendingSamples() > 0)
+    {
+      source->Update();
+      ++updates;
+      mitk::NavigationData* nd = source->GetOutput(0);
+      if (!nd->IsDataValid() || nd->GetIGTTimeStamp() < lastTimeStamp) increasing = false;
+      lastTimeStamp = nd->GetIGTTimeStamp();
+    }
+    MITK_TEST_CONDITION(updates == tracker->GetTool(0)->GetSampleQueue()->GetNumberOfAddedSamples(), "Testing if every sample was delivered");
+    MITK_TEST_CONDITION(increasing, "Testing if samples are delivered in order");
+
+    source->Disconnect();
+  }
+};
+
+/**Documentation
+ *  test for the class "TrackingSampleQueue" and its use by "TrackingDeviceSource".
+ */
+int mitkTrackingSampleQueueTest(int /* argc */, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("TrackingSampleQueue");
+
+  mitkTrackingSampleQueueTestClass::TestQueue();
+  mitkTrackingSampleQueueTestClass::TestOverflow();
+  mitkTrackingSampleQueueTestClass::TestConcurrentAccess();
+  mitkTrackingSampleQueueTestClass::TestTrackingDeviceSource();
+
+  MITK_TEST_END();
+}
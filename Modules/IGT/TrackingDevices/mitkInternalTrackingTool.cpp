@@ -268,3 +268,17 @@ void mitk::InternalTrackingTool::SetErrorMessage(const char* _arg)
     this->m_ErrorMessage = "";
   this->Modified();
 }
+
+void mitk::InternalTrackingTool::AddSample(double igtTimeStamp)
+{
+  this->SetIGTTimeStamp(igtTimeStamp);
+
+  mitk::TrackingSampleQueue::Sample sample;
+  this->GetPosition(sample.Position);
+  this->GetOrientation(sample.Orientation);
+  sample.TrackingError = this->GetTrackingError();
+  sample.DataValid = this->IsEnabled() && this->IsDataValid();
+  sample.IGTTimeStamp = igtTimeStamp;
+
+  m_SampleQueue.Add(sample);
+}
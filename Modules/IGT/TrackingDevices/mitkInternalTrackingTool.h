@@ -60,6 +60,7 @@ namespace mitk {
     virtual void SetDataValid(bool _arg);                       ///< sets if the tracking data (position & Orientation) is valid
     virtual void SetErrorMessage(const char* _arg);             ///< sets the error message
     virtual void SetToolTip(Point3D toolTipPosition, Quaternion orientation = Quaternion(0,0,0,1), ScalarType eps=0.0); ///< defines a tool tip for this tool in tool coordinates. GetPosition() and GetOrientation() return the data of the tool tip if it is defined. By default no tooltip is defined.
+    virtual void AddSample(double igtTimeStamp);                ///< sets the IGT timestamp and adds the current state of the tool to the sample queue. To be called by the tracking thread after the data of a measurement was set.
 
   protected:
     itkFactorylessNewMacro(Self)
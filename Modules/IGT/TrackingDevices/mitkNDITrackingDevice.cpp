@@ -766,6 +766,8 @@ void mitk::NDITrackingDevice::TrackTools()
       if (returnvalue != NDIOKAY)
         break;
     }
+    if (returnvalue == NDIOKAY)
+      this->AddToolSamples();
     /* Update the local copy of m_StopTracking */
     this->m_StopTrackingMutex->Lock();
     localStopTracking = m_StopTracking;
@@ -853,6 +855,8 @@ void mitk::NDITrackingDevice::TrackToolsAndMarkers()
     {
       std::cout << "Error in TX: could not read data. Possibly no markers present." << std::endl;
     }
+    if (returnvalue == NDIOKAY)
+      this->AddToolSamples();
     /* Update the local copy of m_StopTracking */
     this->m_StopTrackingMutex->Lock();
     localStopTracking = m_StopTracking;
@@ -869,6 +873,15 @@ void mitk::NDITrackingDevice::TrackToolsAndMarkers()
 }
 
 
+void mitk::NDITrackingDevice::AddToolSamples()
+{
+  double timeStamp = mitk::IGTTimeStamp::GetInstance()->GetElapsed();
+  MutexLockHolder toolsMutexLockHolder(*m_ToolsMutex); // lock and unlock the mutex
+  for (Tool6DContainerType::iterator it = m_6DTools.begin(); it != m_6DTools.end(); ++it)
+    (*it)->AddSample(timeStamp);
+}
+
+
 mitk::TrackingTool* mitk::NDITrackingDevice::GetTool(unsigned int toolNumber) const
 {
   MutexLockHolder toolsMutexLockHolder(*m_ToolsMutex); // lock and unlock the mutex
@@ -295,6 +295,11 @@ public:
     static ITK_THREAD_RETURN_TYPE ThreadStartTracking(void* data);
 
   protected:
+    /**
+    * \brief Adds the current state of all 6D tools to their sample queues. Called by the tracking thread after each successful TX.
+    */
+    void AddToolSamples();
+
     NDITrackingDevice();          ///< Constructor
     virtual ~NDITrackingDevice(); ///< Destructor
 
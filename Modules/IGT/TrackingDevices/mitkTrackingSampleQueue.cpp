@@ -0,0 +1,132 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkTrackingSampleQueue.h"
+
+mitk::TrackingSampleQueue::TrackingSampleQueue(unsigned int capacity)
+  : m_Size(capacity > 0 ? capacity + 1 : 2),
+    m_Samples(new Slot[m_Size]),
+    m_LastDelivered(0)
+{
+  m_Latest.Number = 0;
+}
+
+mitk::TrackingSampleQueue::~TrackingSampleQueue()
+{
+  delete[] m_Samples;
+}
+
+// Head and tail are each changed by one side only. Their stores are full memory
+// barriers: a slot is written completely before the producer publishes it by
+// moving the head, and read completely before the consumer releases it by
+// moving the tail.
+//
+// The latest-sample slot is a sequence lock: the producer makes the sequence odd,
+// writes the slot and makes it even again. The consumer retries until it has read
+// the slot between two equal, even sequence values.
+
+bool mitk::TrackingSampleQueue::Add(const Sample& sample)
+{
+  long number = m_NumberOfAddedSamples.Increment();
+
+  m_LatestSequence.Increment();
+  m_Latest.Data = sample;
+  m_Latest.Number = number;
+  m_LatestSequence.Increment();
+
+  long head = m_Head.Get();
+  long next = (head + 1) % m_Size;
+  if (next == m_Tail.Get())
+  {
+    m_NumberOfDroppedSamples.Increment();
+    return false;
+  }
+
+  m_Samples[head].Data = sample;
+  m_Samples[head].Number = number;
+  m_Head.Set(next);
+  return true;
+}
+
+bool mitk::TrackingSampleQueue::Pop(Sample& sample)
+{
+  for (;;)
+  {
+    long tail = m_Tail.Get();
+    if (tail == m_Head.Get())
+      return false;
+
+    Slot slot = m_Samples[tail];
+    m_Tail.Set((tail + 1) % m_Size);
+
+    // skip samples older than one already delivered by PopLatest()
+    if (slot.Number > m_LastDelivered)
+    {
+      sample = slot.Data;
+      m_LastDelivered = slot.Number;
+      return true;
+    }
+  }
+}
+
+bool mitk::TrackingSampleQueue::PopLatest(Sample& sample)
+{
+  // everything in the queue is at most as new as the latest-sample slot
+  m_Tail.Set(m_Head.Get());
+
+  Slot latest;
+  long sequence;
+  do
+  {
+    sequence = m_LatestSequence.Get();
+    latest = m_Latest;
+  } while ((sequence & 1) != 0 || sequence != m_LatestSequence.Get());
+
+  if (latest.Number <= m_LastDelivered)
+    return false;
+
+  sample = latest.Data;
+  m_LastDelivered = latest.Number;
+  return true;
+}
+
+void mitk::TrackingSampleQueue::Clear()
+{
+  m_Tail.Set(m_Head.Get());
+  m_LastDelivered = m_NumberOfAddedSamples.Get();
+}
+
+unsigned int mitk::TrackingSampleQueue::GetNumberOfSamples() const
+{
+  long tail = m_Tail.Get();
+  long head = m_Head.Get();
+  return (head + m_Size - tail) % m_Size;
+}
+
+unsigned int mitk::TrackingSampleQueue::GetCapacity() const
+{
+  return m_Size - 1;
+}
+
+unsigned long mitk::TrackingSampleQueue::GetNumberOfAddedSamples() const
+{
+  return m_NumberOfAddedSamples.Get();
+}
+
+unsigned long mitk::TrackingSampleQueue::GetNumberOfDroppedSamples() const
+{
+  return m_NumberOfDroppedSamples.Get();
+}
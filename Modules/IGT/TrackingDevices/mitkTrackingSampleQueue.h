@@ -0,0 +1,115 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKTRACKINGSAMPLEQUEUE_H_HEADER_INCLUDED_
+#define MITKTRACKINGSAMPLEQUEUE_H_HEADER_INCLUDED_
+
+#include <MitkIGTExports.h>
+#include <mitkNumericTypes.h>
+#include <mitkAtomicInteger.h>
+
+namespace mitk
+{
+  /**Documentation
+  * \brief Lock-free queue of timestamped tracking samples of one tool.
+  *
+  * The queue connects exactly one producer, the tracking thread of a tracking
+  * device, with exactly one consumer, usually mitk::TrackingDeviceSource. Neither
+  * side ever waits for the other: the producer drops a sample if the queue is
+  * full (counted in GetNumberOfDroppedSamples()), the consumer gets false if the
+  * queue is empty. Besides the queue, the producer publishes every sample in a
+  * separate latest-sample slot guarded by a sequence counter, so that PopLatest()
+  * returns the newest sample even if it has been dropped from the full queue.
+  *
+  * Add() may only be called by the producer; Pop(), PopLatest() and Clear() may
+  * only be called by the consumer. All other methods may be called by anyone.
+  *
+  * \ingroup IGT
+  */
+  class MitkIGT_EXPORT TrackingSampleQueue
+  {
+  public:
+    /**
+    * \brief State of a tool at the time a tracking device measured it.
+    */
+    struct Sample
+    {
+      Point3D    Position;       ///< position in tracking device coordinates, including the tool tip
+      Quaternion Orientation;    ///< orientation in tracking device coordinates, including the tool tip
+      float      TrackingError;
+      bool       DataValid;      ///< false if the tool was not visible or disabled
+      double     IGTTimeStamp;   ///< time of the measurement in milliseconds, see mitk::IGTTimeStamp
+    };
+
+    /** \brief Creates a queue which holds up to the given number of samples. */
+    explicit TrackingSampleQueue(unsigned int capacity = 256);
+    ~TrackingSampleQueue();
+
+    /**
+    * \brief Appends a sample (producer only).
+    * \return false if the queue is full and the sample was dropped
+    */
+    bool Add(const Sample& sample);
+
+    /**
+    * \brief Removes the oldest sample (consumer only).
+    * \return false if the queue is empty
+    */
+    bool Pop(Sample& sample);
+
+    /**
+    * \brief Removes all samples and returns the newest sample added, even if it has been dropped (consumer only).
+    * \return false if no sample has been added since the last sample delivered by Pop() or PopLatest()
+    */
+    bool PopLatest(Sample& sample);
+
+    /** \brief Removes all samples, including the newest one (consumer only). */
+    void Clear();
+
+    /** \brief Number of samples waiting for the consumer. */
+    unsigned int GetNumberOfSamples() const;
+
+    unsigned int GetCapacity() const;
+
+    /** \brief Number of samples passed to Add() so far, including the dropped ones. */
+    unsigned long GetNumberOfAddedSamples() const;
+
+    /** \brief Number of samples dropped because the queue was full. */
+    unsigned long GetNumberOfDroppedSamples() const;
+
+  private:
+    TrackingSampleQueue(const TrackingSampleQueue&);            // Not implemented on purpose.
+    TrackingSampleQueue& operator=(const TrackingSampleQueue&); // Not implemented on purpose.
+
+    struct Slot
+    {
+      Sample Data;
+      long   Number;                 ///< position of the sample in the sequence of added samples, starting at 1
+    };
+
+    unsigned int  m_Size;            ///< number of slots, one more than the capacity to tell a full queue from an empty one
+    Slot*         m_Samples;
+    AtomicInteger m_Head;            ///< next slot to write, only changed by the producer
+    AtomicInteger m_Tail;            ///< next slot to read, only changed by the consumer
+    AtomicInteger m_NumberOfAddedSamples;
+    AtomicInteger m_NumberOfDroppedSamples;
+    Slot          m_Latest;          ///< newest sample, written by the producer even if the queue is full
+    AtomicInteger m_LatestSequence;  ///< odd while the producer writes m_Latest
+    long          m_LastDelivered;   ///< number of the newest sample delivered to the consumer, only used by the consumer
+  };
+} // namespace mitk
+
+#endif /* MITKTRACKINGSAMPLEQUEUE_H_HEADER_INCLUDED_ */
@@ -47,6 +47,11 @@ const char* mitk::TrackingTool::GetToolName() const
 }
 
 
+mitk::TrackingSampleQueue* mitk::TrackingTool::GetSampleQueue()
+{
+  return &m_SampleQueue;
+}
+
 const char* mitk::TrackingTool::GetErrorMessage() const
 {
  MutexLockHolder lock(*m_MyMutex); // lock and unlock the mutex
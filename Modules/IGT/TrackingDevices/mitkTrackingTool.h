@@ -23,6 +23,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkCommon.h>
 #include <mitkNumericTypes.h>
 #include <itkFastMutexLock.h>
+#include "mitkTrackingSampleQueue.h"
 
 namespace mitk
 {
@@ -53,6 +54,17 @@ namespace mitk
     itkSetMacro(IGTTimeStamp, double);               ///< Sets the IGT timestamp of the tracking tool object (time in milliseconds)
     itkGetConstMacro(IGTTimeStamp, double);          ///< Gets the IGT timestamp of the tracking tool object (time in milliseconds). Returns 0 if the timestamp was not set.
 
+    /**
+    * \brief Returns the queue of samples measured by the tracking device.
+    *
+    * Tracking devices which support it add every measured state of the tool to this queue
+    * from their tracking thread (see mitk::InternalTrackingTool::AddSample()). If
+    * GetNumberOfAddedSamples() of the queue is zero, the device does not fill the queue and
+    * only the current state of the tool is available. The queue has a single consumer, which
+    * usually is the mitk::TrackingDeviceSource of the device.
+    */
+    TrackingSampleQueue* GetSampleQueue();
+
   protected:
     TrackingTool();
     virtual ~TrackingTool();
@@ -60,6 +72,7 @@ namespace mitk
     std::string m_ErrorMessage;                      ///< if a tool is invalid, this member should contain a human readable explanation of why it is invalid
     double m_IGTTimeStamp;                           ///< contains the time at which the tracking data was recorded
     itk::FastMutexLock::Pointer m_MyMutex;           ///< mutex to control concurrent access to the tool
+    TrackingSampleQueue m_SampleQueue;               ///< samples measured by the tracking thread, not guarded by m_MyMutex
   };
 } // namespace mitk
 #endif /* MITKTRACKINGTOOL_H_HEADER_INCLUDED_ */
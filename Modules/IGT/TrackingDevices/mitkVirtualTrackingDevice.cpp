@@ -265,6 +265,7 @@ void mitk::VirtualTrackingDevice::TrackTools()
 
         currentTool->SetTrackingError( 2 * (rand() / (RAND_MAX + 1.0)));  // tracking error in 0 .. 2 Range
         currentTool->SetDataValid(true);
+        currentTool->AddSample(mitk::IGTTimeStamp::GetInstance()->GetElapsed());
         currentTool->Modified();
       }
       itksys::SystemTools::Delay(m_RefreshRate);
@@ -43,6 +43,9 @@ set(CPP_FILES
   IO/mitkNavigationDataReaderCSV.cpp
   IO/mitkNavigationDataSetWriterXML.cpp
   IO/mitkNavigationDataSetWriterCSV.cpp
+  IO/mitkNavigationDataBinaryWriter.cpp
+  IO/mitkNavigationDataBinaryReader.cpp
+  IO/mitkNavigationDataBinaryPlayer.cpp
 
   Rendering/mitkCameraVisualization.cpp
   Rendering/mitkNavigationDataObjectVisualizationFilter.cpp
@@ -55,6 +58,7 @@ set(CPP_FILES
   TrackingDevices/mitkNDITrackingDevice.cpp
   TrackingDevices/mitkTrackingDevice.cpp
   TrackingDevices/mitkTrackingTool.cpp
+  TrackingDevices/mitkTrackingSampleQueue.cpp
   TrackingDevices/mitkTrackingVolumeGenerator.cpp
   TrackingDevices/mitkVirtualTrackingDevice.cpp
   TrackingDevices/mitkVirtualTrackingTool.cpp
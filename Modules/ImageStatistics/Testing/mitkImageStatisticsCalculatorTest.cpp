@@ -21,6 +21,11 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkPlanarPolygon.h"
 
 #include "mitkDicomSeriesReader.h"
+#include "mitkImageGenerator.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
+
+#include <cmath>
 
 /**
  * \brief Test class for mitkImageStatisticsCalculator
@@ -28,6 +33,9 @@ See LICENSE.txt or http://www.mitk.org for details.
  * This test covers:
  * - instantiation of an ImageStatisticsCalculator class
  * - correctness of statistics when using PlanarFigures for masking
+ * - correctness of statistics of multiple labels when using an image mask
+ * - incremental update of the statistics when a PlanarFigure is moved
+ * - incremental update of the statistics when pixels leave a shrinking PlanarFigure
  */
 class mitkImageStatisticsCalculatorTestSuite : public mitk::TestFixture
 {
@@ -45,6 +53,9 @@ class mitkImageStatisticsCalculatorTestSuite : public mitk::TestFixture
   MITK_TEST(TestCase10);
   MITK_TEST(TestCase11);
   MITK_TEST(TestCase12);
+  MITK_TEST(TestMultipleLabels);
+  MITK_TEST(TestPlanarFigureIncrementalUpdate);
+  MITK_TEST(TestPlanarFigureIncrementalRemoval);
   CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -66,6 +77,10 @@ public:
   void TestCase11();
   void TestCase12();
 
+  void TestMultipleLabels();
+  void TestPlanarFigureIncrementalUpdate();
+  void TestPlanarFigureIncrementalRemoval();
+
 private:
 
   mitk::Image::Pointer m_Image;
@@ -391,6 +406,174 @@ void mitkImageStatisticsCalculatorTestSuite::VerifyStatistics(const mitk::ImageS
                        "'  is equal to the desired value '" << testSD <<"'" );
 }
 
+void mitkImageStatisticsCalculatorTestSuite::TestMultipleLabels()
+{
+  /*****************************
+   * gradient image masked by three labels (0, 1, 2)
+   * -> statistics of labels 1 and 2 match a direct computation
+   ******************************/
+  const unsigned int numberOfPixels = 8 * 8 * 4;
+  mitk::Image::Pointer image = mitk::ImageGenerator::GenerateGradientImage<short>(8, 8, 4);
+  mitk::Image::Pointer mask = mitk::ImageGenerator::GenerateGradientImage<unsigned short>(8, 8, 4);
+  {
+    mitk::ImageWriteAccessor maskAccess(mask);
+    unsigned short* labels = static_cast<unsigned short*>(maskAccess.GetData());
+    for (unsigned int i = 0; i < numberOfPixels; ++i)
+    {
+      labels[i] = (i * 7) % 3;
+    }
+  }
+
+  mitk::ImageStatisticsCalculator::Pointer statisticsCalculator = mitk::ImageStatisticsCalculator::New();
+  statisticsCalculator->SetImage( image );
+  statisticsCalculator->SetImageMask( mask );
+  statisticsCalculator->SetMaskingModeToImage();
+  statisticsCalculator->ComputeStatistics();
+
+  const mitk::ImageStatisticsCalculator::StatisticsContainer& statistics = statisticsCalculator->GetStatisticsVector();
+  MITK_TEST_CONDITION_REQUIRED( statistics.size() == 2, "Statistics of two labels" );
+
+  mitk::ImageReadAccessor imageAccess(image);
+  mitk::ImageReadAccessor maskAccess(mask);
+  const short* values = static_cast<const short*>(imageAccess.GetData());
+  const unsigned short* labels = static_cast<const unsigned short*>(maskAccess.GetData());
+
+  for (unsigned int label = 1; label <= 2; ++label)
+  {
+    unsigned int n = 0;
+    double sum = 0.0, min = 1e10, max = -1e10;
+    for (unsigned int i = 0; i < numberOfPixels; ++i)
+    {
+      if (labels[i] == label)
+      {
+        ++n;
+        sum += values[i];
+        min = std::min<double>(min, values[i]);
+        max = std::max<double>(max, values[i]);
+      }
+    }
+    double mean = sum / n;
+    double squaredDeviations = 0.0;
+    for (unsigned int i = 0; i < numberOfPixels; ++i)
+    {
+      if (labels[i] == label)
+      {
+        squaredDeviations += (values[i] - mean) * (values[i] - mean);
+      }
+    }
+    double sigma = std::sqrt(squaredDeviations / (n - 1));
+
+    const mitk::ImageStatisticsCalculator::Statistics& labelStatistics = statistics[label - 1];
+    MITK_TEST_CONDITION( labelStatistics.Label == static_cast<int>(label), "Labels in ascending order" );
+    MITK_TEST_CONDITION( labelStatistics.N == n, "Number of pixels of label " << label );
+    MITK_TEST_CONDITION( labelStatistics.Min == min, "Minimum of label " << label );
+    MITK_TEST_CONDITION( labelStatistics.Max == max, "Maximum of label " << label );
+    MITK_TEST_CONDITION( std::fabs(labelStatistics.Mean - mean) < mitk::eps, "Mean of label " << label );
+    MITK_TEST_CONDITION( std::fabs(labelStatistics.Sigma - sigma) < mitk::eps, "Sigma of label " << label );
+
+    const mitk::ImageStatisticsCalculator::HistogramType* histogram = statisticsCalculator->GetHistogram( 0, label - 1 );
+    MITK_TEST_CONDITION( histogram != NULL && histogram->GetTotalFrequency() == n, "Histogram contains all pixels of label " << label );
+  }
+}
+
+void mitkImageStatisticsCalculatorTestSuite::TestPlanarFigureIncrementalUpdate()
+{
+  /*****************************
+   * figure of TestCase12, one control point is dragged afterwards
+   * -> updated statistics equal statistics computed from scratch
+   ******************************/
+  mitk::PlanarPolygon::Pointer figure = mitk::PlanarPolygon::New();
+  figure->SetPlaneGeometry( m_Geometry );
+  mitk::Point2D pnt1; pnt1[0] = 9.5; pnt1[1] = 0.5;
+  figure->PlaceFigure( pnt1 );
+
+  mitk::Point2D pnt2; pnt2[0] = 9.5; pnt2[1] = 2.5;
+  figure->SetControlPoint( 1, pnt2, true );
+  mitk::Point2D pnt3; pnt3[0] = 11.5; pnt3[1] = 2.5;
+  figure->SetControlPoint( 2, pnt3, true );
+  figure->GetPolyLine(0);
+
+  mitk::ImageStatisticsCalculator::Pointer statisticsCalculator = mitk::ImageStatisticsCalculator::New();
+  statisticsCalculator->SetImage( m_Image );
+  statisticsCalculator->SetMaskingModeToPlanarFigure();
+  statisticsCalculator->SetPlanarFigure( figure );
+  statisticsCalculator->ComputeStatistics();
+  this->VerifyStatistics(statisticsCalculator->GetStatistics(), 212.66, 73.32);
+
+  // grow and shrink the figure, pixels enter and leave the mask
+  mitk::Point2D dragged[2];
+  dragged[0][0] = 11.5; dragged[0][1] = 4.5;
+  dragged[1][0] = 10.5; dragged[1][1] = 1.5;
+  for (unsigned int i = 0; i < 2; ++i)
+  {
+    figure->SetControlPoint( 2, dragged[i], false );
+    figure->Modified();
+    figure->GetPolyLine(0);
+
+    MITK_TEST_CONDITION( statisticsCalculator->ComputeStatistics(), "Moved figure is recomputed" );
+    const mitk::ImageStatisticsCalculator::Statistics updated = statisticsCalculator->GetStatistics();
+    const mitk::ImageStatisticsCalculator::Statistics reference = ComputeStatistics(m_Image, figure.GetPointer());
+
+    MITK_TEST_CONDITION( updated.N == reference.N, "Number of pixels after drag " << i );
+    MITK_TEST_CONDITION( updated.Min == reference.Min, "Minimum after drag " << i );
+    MITK_TEST_CONDITION( updated.Max == reference.Max, "Maximum after drag " << i );
+    MITK_TEST_CONDITION( std::fabs(updated.Mean - reference.Mean) < mitk::eps, "Mean after drag " << i );
+    MITK_TEST_CONDITION( std::fabs(updated.Sigma - reference.Sigma) < mitk::eps, "Sigma after drag " << i );
+    MITK_TEST_CONDITION( updated.Median == reference.Median, "Median after drag " << i );
+  }
+}
+
+void mitkImageStatisticsCalculatorTestSuite::TestPlanarFigureIncrementalRemoval()
+{
+  /*****************************
+   * large rectangle that is shrunk step by step, pixels only leave the mask
+   * -> updated statistics, including the indices of the extrema, equal
+   *    statistics computed from scratch
+   ******************************/
+  mitk::PlanarPolygon::Pointer figure = mitk::PlanarPolygon::New();
+  figure->SetPlaneGeometry( m_Geometry );
+  mitk::Point2D pnt1; pnt1[0] = 8.5; pnt1[1] = 0.5;
+  figure->PlaceFigure( pnt1 );
+
+  mitk::Point2D pnt2; pnt2[0] = 8.5; pnt2[1] = 5.4999;
+  figure->SetControlPoint( 1, pnt2, true );
+  mitk::Point2D pnt3; pnt3[0] = 13.5; pnt3[1] = 5.4999;
+  figure->SetControlPoint( 2, pnt3, true );
+  mitk::Point2D pnt4; pnt4[0] = 13.5; pnt4[1] = 0.5;
+  figure->SetControlPoint( 3, pnt4, true );
+  figure->GetPolyLine(0);
+
+  mitk::ImageStatisticsCalculator::Pointer statisticsCalculator = mitk::ImageStatisticsCalculator::New();
+  statisticsCalculator->SetImage( m_Image );
+  statisticsCalculator->SetMaskingModeToPlanarFigure();
+  statisticsCalculator->SetPlanarFigure( figure );
+  statisticsCalculator->ComputeStatistics();
+
+  unsigned int previousN = statisticsCalculator->GetStatistics().N;
+  for (unsigned int i = 1; i <= 4; ++i)
+  {
+    mitk::Point2D corner; corner[0] = 13.5 - i; corner[1] = 5.4999 - i;
+    figure->SetControlPoint( 2, corner, false );
+    figure->Modified();
+    figure->GetPolyLine(0);
+
+    MITK_TEST_CONDITION( statisticsCalculator->ComputeStatistics(), "Shrunk figure is recomputed" );
+    const mitk::ImageStatisticsCalculator::Statistics updated = statisticsCalculator->GetStatistics();
+    const mitk::ImageStatisticsCalculator::Statistics reference = ComputeStatistics(m_Image, figure.GetPointer());
+
+    MITK_TEST_CONDITION( updated.N < previousN, "Pixels left the figure in step " << i );
+    MITK_TEST_CONDITION( updated.N == reference.N, "Number of pixels after step " << i );
+    MITK_TEST_CONDITION( updated.Min == reference.Min, "Minimum after step " << i );
+    MITK_TEST_CONDITION( updated.Max == reference.Max, "Maximum after step " << i );
+    MITK_TEST_CONDITION( updated.MinIndex == reference.MinIndex, "Index of the minimum after step " << i );
+    MITK_TEST_CONDITION( updated.MaxIndex == reference.MaxIndex, "Index of the maximum after step " << i );
+    MITK_TEST_CONDITION( std::fabs(updated.Mean - reference.Mean) < mitk::eps, "Mean after step " << i );
+    MITK_TEST_CONDITION( std::fabs(updated.Variance - reference.Variance) < mitk::eps, "Variance after step " << i );
+    MITK_TEST_CONDITION( updated.Median == reference.Median, "Median after step " << i );
+    previousN = updated.N;
+  }
+}
+
 void mitkImageStatisticsCalculatorTestSuite::TestUninitializedImage()
 {
   /*****************************
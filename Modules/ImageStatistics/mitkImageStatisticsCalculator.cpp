@@ -20,14 +20,9 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkImageCast.h"
 #include "mitkExtractImageFilter.h"
 
-#include <itkScalarImageToHistogramGenerator.h>
-
 #include <itkChangeInformationImageFilter.h>
-#include <itkExtractImageFilter.h>
-#include <itkMinimumMaximumImageCalculator.h>
-#include <itkStatisticsImageFilter.h>
-#include <itkLabelStatisticsImageFilter.h>
-#include <itkMaskImageFilter.h>
+#include <itkImageRegionConstIterator.h>
+#include <itkMultiThreader.h>
 #include <itkImageFileWriter.h>
 #include <itkRescaleIntensityImageFilter.h>
 
@@ -51,10 +46,262 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkLassoStencilSource.h>
 #include <vtkMetaImageWriter.h>
 
-#include <list>
+#include <algorithm>
 
 #include <exception>
 
+namespace
+{
+  typedef mitk::ImageStatisticsCalculator::StatisticsAccumulator StatisticsAccumulator;
+  typedef mitk::ImageStatisticsCalculator::AccumulatorContainer AccumulatorContainer;
+
+  /** Number of possible labels of the unsigned short masks */
+  const unsigned int NumberOfLabels = 65536;
+
+  /** Limit for the histogram bins of all threads (labels * bins * threads) */
+  const unsigned long MaximumNumberOfThreadBins = 1 << 25;
+
+  template < typename TPixel, unsigned int VImageDimension >
+  struct AccumulateThreadData
+  {
+    typedef itk::Image< TPixel, VImageDimension > ImageType;
+    typedef itk::Image< unsigned short, VImageDimension > MaskImageType;
+
+    const ImageType *Image;
+    const MaskImageType *Mask;
+    typename ImageType::RegionType Region;
+
+    // value range and labels per thread
+    std::vector< double > Minima;
+    std::vector< double > Maxima;
+    std::vector< std::vector< unsigned char > > LabelsPresent;
+
+    // accumulators per thread, indexed by SlotOfLabel
+    std::vector< int > SlotOfLabel;
+    double HistogramMinimum;
+    double BinWidth;
+    unsigned int NumberOfBins;
+    std::vector< AccumulatorContainer > Accumulators;
+  };
+
+  /** Restricts region to the slab of the given thread along the slowest axis. Returns false if it is empty. */
+  template < typename TRegion >
+  bool SplitRegion( TRegion &region, unsigned int threadId, unsigned int numberOfThreads )
+  {
+    const unsigned int splitAxis = TRegion::ImageDimension - 1;
+    const itk::SizeValueType extent = region.GetSize( splitAxis );
+    const itk::SizeValueType chunk = ( extent + numberOfThreads - 1 ) / numberOfThreads;
+    const itk::SizeValueType begin = std::min< itk::SizeValueType >( extent, chunk * threadId );
+    const itk::SizeValueType end = std::min< itk::SizeValueType >( extent, begin + chunk );
+    if ( begin == end )
+    {
+      return false;
+    }
+    region.SetIndex( splitAxis, region.GetIndex( splitAxis ) + begin );
+    region.SetSize( splitAxis, end - begin );
+    return true;
+  }
+
+  inline unsigned int GetHistogramBin( double value, double minimum, double binWidth, unsigned int numberOfBins )
+  {
+    if ( binWidth <= 0.0 || value <= minimum )
+    {
+      return 0;
+    }
+    return std::min( static_cast< unsigned int >( ( value - minimum ) / binWidth ), numberOfBins - 1 );
+  }
+
+  template < typename TIterator >
+  inline void UpdateExtrema( StatisticsAccumulator &accumulator, double value, const TIterator &it )
+  {
+    if ( value < accumulator.Min )
+    {
+      accumulator.Min = value;
+      const typename TIterator::IndexType index = it.GetIndex();
+      for ( unsigned int i = 0; i < accumulator.MinIndex.size(); ++i )
+      {
+        accumulator.MinIndex[i] = index[i];
+      }
+    }
+    if ( value > accumulator.Max )
+    {
+      accumulator.Max = value;
+      const typename TIterator::IndexType index = it.GetIndex();
+      for ( unsigned int i = 0; i < accumulator.MaxIndex.size(); ++i )
+      {
+        accumulator.MaxIndex[i] = index[i];
+      }
+    }
+  }
+
+  template < typename TIterator >
+  inline void AccumulatePixel( StatisticsAccumulator &accumulator, double value, unsigned int bin, const TIterator &it )
+  {
+    ++accumulator.N;
+    const double delta = value - accumulator.Mean;
+    accumulator.Mean += delta / accumulator.N;
+    accumulator.SquaredDeviations += delta * ( value - accumulator.Mean );
+    accumulator.Frequencies[bin] += 1.0;
+    UpdateExtrema( accumulator, value, it );
+  }
+
+  /** Adds the mean and squared deviations of part to those of result */
+  void MergeMoments( StatisticsAccumulator &result, const StatisticsAccumulator &part )
+  {
+    const double n = static_cast< double >( result.N ) + part.N;
+    const double delta = part.Mean - result.Mean;
+    result.Mean += delta * part.N / n;
+    result.SquaredDeviations += part.SquaredDeviations + delta * delta * result.N * part.N / n;
+    result.N += part.N;
+  }
+
+  /** Merges the accumulator of a later part of the image, so that the first extremum is kept */
+  void MergeAccumulator( StatisticsAccumulator &result, const StatisticsAccumulator &part )
+  {
+    if ( part.N == 0 )
+    {
+      return;
+    }
+    MergeMoments( result, part );
+    for ( unsigned int bin = 0; bin < result.Frequencies.size(); ++bin )
+    {
+      result.Frequencies[bin] += part.Frequencies[bin];
+    }
+    if ( part.Min < result.Min )
+    {
+      result.Min = part.Min;
+      result.MinIndex = part.MinIndex;
+    }
+    if ( part.Max > result.Max )
+    {
+      result.Max = part.Max;
+      result.MaxIndex = part.MaxIndex;
+    }
+  }
+
+  /** Removes the pixels of part, which must be contained in result. The extrema are not updated. */
+  void RemoveAccumulator( StatisticsAccumulator &result, const StatisticsAccumulator &part )
+  {
+    if ( part.N == 0 )
+    {
+      return;
+    }
+    for ( unsigned int bin = 0; bin < result.Frequencies.size(); ++bin )
+    {
+      result.Frequencies[bin] -= part.Frequencies[bin];
+    }
+    if ( part.N >= result.N )
+    {
+      result.N = 0;
+      result.Mean = 0.0;
+      result.SquaredDeviations = 0.0;
+      return;
+    }
+    const unsigned int n = result.N - part.N;
+    const double mean = result.Mean + ( result.Mean - part.Mean ) * part.N / n;
+    const double delta = part.Mean - mean;
+    result.SquaredDeviations = std::max( 0.0,
+      result.SquaredDeviations - part.SquaredDeviations - delta * delta * n * part.N / result.N );
+    result.Mean = mean;
+    result.N = n;
+  }
+
+  template < typename TPixel, unsigned int VImageDimension >
+  ITK_THREAD_RETURN_TYPE ValueRangeThread( void *arg )
+  {
+    typedef AccumulateThreadData< TPixel, VImageDimension > ThreadDataType;
+    typedef typename ThreadDataType::ImageType ImageType;
+    typedef typename ThreadDataType::MaskImageType MaskImageType;
+
+    itk::MultiThreader::ThreadInfoStruct *info = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+    ThreadDataType *data = static_cast< ThreadDataType * >( info->UserData );
+    const unsigned int threadId = info->ThreadID;
+
+    typename ImageType::RegionType region = data->Region;
+    if ( !SplitRegion( region, threadId, info->NumberOfThreads ) )
+    {
+      return ITK_THREAD_RETURN_VALUE;
+    }
+
+    double minimum = data->Minima[threadId];
+    double maximum = data->Maxima[threadId];
+    itk::ImageRegionConstIterator< ImageType > imageIt( data->Image, region );
+    if ( data->Mask != NULL )
+    {
+      std::vector< unsigned char > &labelsPresent = data->LabelsPresent[threadId];
+      itk::ImageRegionConstIterator< MaskImageType > maskIt( data->Mask, region );
+      for ( ; !imageIt.IsAtEnd(); ++imageIt, ++maskIt )
+      {
+        const double value = imageIt.Get();
+        minimum = std::min( minimum, value );
+        maximum = std::max( maximum, value );
+        labelsPresent[maskIt.Get()] = 1;
+      }
+    }
+    else
+    {
+      for ( ; !imageIt.IsAtEnd(); ++imageIt )
+      {
+        const double value = imageIt.Get();
+        minimum = std::min( minimum, value );
+        maximum = std::max( maximum, value );
+      }
+    }
+    data->Minima[threadId] = minimum;
+    data->Maxima[threadId] = maximum;
+
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  template < typename TPixel, unsigned int VImageDimension >
+  ITK_THREAD_RETURN_TYPE AccumulateThread( void *arg )
+  {
+    typedef AccumulateThreadData< TPixel, VImageDimension > ThreadDataType;
+    typedef typename ThreadDataType::ImageType ImageType;
+    typedef typename ThreadDataType::MaskImageType MaskImageType;
+
+    itk::MultiThreader::ThreadInfoStruct *info = static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+    ThreadDataType *data = static_cast< ThreadDataType * >( info->UserData );
+    const unsigned int threadId = info->ThreadID;
+
+    typename ImageType::RegionType region = data->Region;
+    if ( !SplitRegion( region, threadId, info->NumberOfThreads ) )
+    {
+      return ITK_THREAD_RETURN_VALUE;
+    }
+
+    AccumulatorContainer &accumulators = data->Accumulators[threadId];
+    itk::ImageRegionConstIterator< ImageType > imageIt( data->Image, region );
+    if ( data->Mask != NULL )
+    {
+      itk::ImageRegionConstIterator< MaskImageType > maskIt( data->Mask, region );
+      for ( ; !imageIt.IsAtEnd(); ++imageIt, ++maskIt )
+      {
+        const int slot = data->SlotOfLabel[maskIt.Get()];
+        if ( slot < 0 )
+        {
+          continue;
+        }
+        const double value = imageIt.Get();
+        AccumulatePixel( accumulators[slot], value,
+          GetHistogramBin( value, data->HistogramMinimum, data->BinWidth, data->NumberOfBins ), imageIt );
+      }
+    }
+    else
+    {
+      StatisticsAccumulator &accumulator = accumulators.front();
+      for ( ; !imageIt.IsAtEnd(); ++imageIt )
+      {
+        const double value = imageIt.Get();
+        AccumulatePixel( accumulator, value,
+          GetHistogramBin( value, data->HistogramMinimum, data->BinWidth, data->NumberOfBins ), imageIt );
+      }
+    }
+
+    return ITK_THREAD_RETURN_VALUE;
+  }
+}
+
 namespace mitk
 {
 
@@ -90,6 +337,7 @@ void ImageStatisticsCalculator::SetImage( const mitk::Image *image )
   if ( m_Image != image )
   {
     m_Image = image;
+    m_PlanarFigureCache = PlanarFigureCache();
     this->Modified();
 
     unsigned int numberOfTimeSteps = image->GetTimeSteps();
@@ -389,8 +637,21 @@ bool ImageStatisticsCalculator::ComputeStatistics( unsigned int timeStep )
         statisticsContainer,
         histogramContainer );
     }
+    else if ( m_MaskingMode == MASKING_MODE_PLANARFIGURE && m_PlanarFigureCache.Valid )
+    {
+      // Same slice as before, only evaluate the pixels that entered or left the figure
+      m_PlanarFigureCache.Valid = false;
+      AccessFixedDimensionByItk_3(
+        m_InternalImage,
+        InternalUpdatePlanarFigureStatistics,
+        2,
+        m_InternalImageMask2D.GetPointer(),
+        statisticsContainer,
+        histogramContainer );
+    }
     else
     {
+      m_PlanarFigureCache.Valid = false;
       AccessFixedDimensionByItk_3(
         m_InternalImage,
         InternalCalculateStatisticsMasked,
@@ -399,6 +660,12 @@ bool ImageStatisticsCalculator::ComputeStatistics( unsigned int timeStep )
         statisticsContainer,
         histogramContainer );
     }
+
+    if ( m_MaskingMode == MASKING_MODE_PLANARFIGURE )
+    {
+      m_PlanarFigureCache.Mask = m_InternalImageMask2D;
+      m_PlanarFigureCache.Valid = true;
+    }
   }
   else
   {
@@ -414,6 +681,23 @@ bool ImageStatisticsCalculator::ComputeStatistics( unsigned int timeStep )
 }
 
 
+bool ImageStatisticsCalculator::ComputeStatisticsOfAllTimeSteps()
+{
+  if ( m_Image.IsNull() )
+  {
+    mitkThrow() << "Image not set!";
+  }
+
+  bool statisticsChanged = false;
+  for ( unsigned int t = 0; t < m_Image->GetTimeSteps(); ++t )
+  {
+    // compute first, the statistics of every time step need to be up to date
+    statisticsChanged = this->ComputeStatistics( t ) || statisticsChanged;
+  }
+  return statisticsChanged;
+}
+
+
 const ImageStatisticsCalculator::HistogramType *
 ImageStatisticsCalculator::GetHistogram( unsigned int timeStep, unsigned int label ) const
 {
@@ -656,10 +940,35 @@ void ImageStatisticsCalculator::ExtractImageAndMask( unsigned int timeStep )
       m_PlanarFigureSlice = slice;
 
 
+      // The slice and the previous mask can be reused as long as the image
+      // and the settings remain, only the figure itself changed then
+      if ( !m_PlanarFigureCache.Valid
+        || m_PlanarFigureCache.TimeStep != timeStep
+        || m_PlanarFigureCache.Axis != axis
+        || m_PlanarFigureCache.Slice != slice
+        || m_PlanarFigureCache.ImageMTime != m_Image->GetMTime()
+        || m_PlanarFigureCache.HistogramBinSize != m_HistogramBinSize
+        || m_PlanarFigureCache.DoIgnorePixelValue != m_DoIgnorePixelValue
+        || m_PlanarFigureCache.IgnorePixelValue != m_IgnorePixelValue )
+      {
+        m_PlanarFigureCache = PlanarFigureCache();
+        m_PlanarFigureCache.TimeStep = timeStep;
+        m_PlanarFigureCache.Axis = axis;
+        m_PlanarFigureCache.Slice = slice;
+        m_PlanarFigureCache.ImageMTime = m_Image->GetMTime();
+        m_PlanarFigureCache.HistogramBinSize = m_HistogramBinSize;
+        m_PlanarFigureCache.DoIgnorePixelValue = m_DoIgnorePixelValue;
+        m_PlanarFigureCache.IgnorePixelValue = m_IgnorePixelValue;
+      }
+
       // Extract slice with given position and direction from image
       unsigned int dimension = timeSliceImage->GetDimension();
 
-      if (dimension != 2)
+      if ( m_PlanarFigureCache.SliceImage.IsNotNull() )
+      {
+        m_InternalImage = m_PlanarFigureCache.SliceImage;
+      }
+      else if (dimension != 2)
       {
         ExtractImageFilter::Pointer imageExtractor = ExtractImageFilter::New();
         imageExtractor->SetInput( timeSliceImage );
@@ -672,6 +981,7 @@ void ImageStatisticsCalculator::ExtractImageAndMask( unsigned int timeStep )
       {
         m_InternalImage = timeSliceImage;
       }
+      m_PlanarFigureCache.SliceImage = m_InternalImage;
 
       // Compute mask from PlanarFigure
       AccessFixedDimensionByItk_1(
@@ -730,82 +1040,24 @@ void ImageStatisticsCalculator::InternalCalculateStatisticsUnmasked(
   StatisticsContainer *statisticsContainer,
   HistogramContainer* histogramContainer )
 {
-  typedef itk::Image< TPixel, VImageDimension > ImageType;
-  typedef itk::Image< unsigned short, VImageDimension > MaskImageType;
-  typedef typename ImageType::IndexType IndexType;
-
-  typedef itk::Statistics::ScalarImageToHistogramGenerator< ImageType >
-    HistogramGeneratorType;
-
   statisticsContainer->clear();
   histogramContainer->clear();
 
-  // Progress listening...
-  typedef itk::SimpleMemberCommand< ImageStatisticsCalculator > ITKCommandType;
-  ITKCommandType::Pointer progressListener;
-  progressListener = ITKCommandType::New();
-  progressListener->SetCallbackFunction( this,
-    &ImageStatisticsCalculator::UnmaskedStatisticsProgressUpdate );
+  AccumulatorContainer accumulators;
+  double histogramMinimum, histogramMaximum;
+  this->InternalAccumulateStatistics( image,
+    static_cast< const itk::Image< unsigned short, VImageDimension > * >( NULL ),
+    image->GetBufferedRegion(), accumulators, histogramMinimum, histogramMaximum );
 
-
-  // Issue 100 artificial progress events since ScalarIMageToHistogramGenerator
-  // does not (yet?) support progress reporting
-  this->InvokeEvent( itk::StartEvent() );
-  for ( unsigned int i = 0; i < 100; ++i )
+  for ( AccumulatorContainer::const_iterator it = accumulators.begin(); it != accumulators.end(); ++it )
   {
-    this->UnmaskedStatisticsProgressUpdate();
-  }
-
-  // Calculate statistics (separate filter)
-  typedef itk::StatisticsImageFilter< ImageType > StatisticsFilterType;
-  typename StatisticsFilterType::Pointer statisticsFilter = StatisticsFilterType::New();
-  statisticsFilter->SetInput( image );
-  unsigned long observerTag = statisticsFilter->AddObserver( itk::ProgressEvent(), progressListener );
-  statisticsFilter->Update();
-  statisticsFilter->RemoveObserver( observerTag );
-  this->InvokeEvent( itk::EndEvent() );
-
-  // Calculate minimum and maximum
-  typedef itk::MinimumMaximumImageCalculator< ImageType > MinMaxFilterType;
-  typename MinMaxFilterType::Pointer minMaxFilter = MinMaxFilterType::New();
-  minMaxFilter->SetImage( image );
-  unsigned long observerTag2 = minMaxFilter->AddObserver( itk::ProgressEvent(), progressListener );
-  minMaxFilter->Compute();
-  minMaxFilter->RemoveObserver( observerTag2 );
-  this->InvokeEvent( itk::EndEvent() );
-
-  Statistics statistics; statistics.Reset();
-  statistics.Label = 1;
-  statistics.N = image->GetBufferedRegion().GetNumberOfPixels();
-  statistics.Min = statisticsFilter->GetMinimum();
-  statistics.Max = statisticsFilter->GetMaximum();
-  statistics.Mean = statisticsFilter->GetMean();
-  statistics.Median = 0.0;
-  statistics.Sigma = statisticsFilter->GetSigma();
-  statistics.RMS = sqrt( statistics.Mean * statistics.Mean + statistics.Sigma * statistics.Sigma );
+    Statistics statistics;
+    HistogramType::ConstPointer histogram;
+    this->AccumulatorToStatistics( *it, histogramMinimum, histogramMaximum, statistics, histogram );
 
-  statistics.MinIndex.set_size(image->GetImageDimension());
-  statistics.MaxIndex.set_size(image->GetImageDimension());
-  for (unsigned int i=0; i<statistics.MaxIndex.size(); i++)
-  {
-      statistics.MaxIndex[i] = minMaxFilter->GetIndexOfMaximum()[i];
-      statistics.MinIndex[i] = minMaxFilter->GetIndexOfMinimum()[i];
+    statisticsContainer->push_back( statistics );
+    histogramContainer->push_back( histogram );
   }
-
-  statisticsContainer->push_back( statistics );
-
-  // Calculate histogram
-  unsigned int numberOfBins = std::floor( ( (statistics.Max - statistics.Min + 1) / m_HistogramBinSize) + 0.5 );
-
-  typename HistogramGeneratorType::Pointer histogramGenerator = HistogramGeneratorType::New();
-  histogramGenerator->SetInput( image );
-  histogramGenerator->SetMarginalScale( 100 );
-  histogramGenerator->SetNumberOfBins( numberOfBins );
-  histogramGenerator->SetHistogramMin( statistics.Min );
-  histogramGenerator->SetHistogramMax( statistics.Max );
-  histogramGenerator->Compute();
-
-  histogramContainer->push_back( histogramGenerator->GetOutput() );
 }
 
 template < typename TPixel, unsigned int VImageDimension >
@@ -850,12 +1102,7 @@ void ImageStatisticsCalculator::InternalCalculateStatisticsMasked(
   typedef typename ImageType::PointType PointType;
   typedef typename ImageType::SpacingType SpacingType;
 
-  typedef itk::LabelStatisticsImageFilter< ImageType, MaskImageType > LabelStatisticsFilterType;
-
   typedef itk::ChangeInformationImageFilter< MaskImageType > ChangeInformationFilterType;
-
-  typedef itk::ExtractImageFilter< ImageType, ImageType > ExtractImageFilterType;
-
   statisticsContainer->clear();
   histogramContainer->clear();
 
@@ -934,159 +1181,346 @@ void ImageStatisticsCalculator::InternalCalculateStatisticsMasked(
       << image->GetLargestPossibleRegion() << "; Mask region: " << adaptedMaskImage->GetLargestPossibleRegion() << ")" );
   }
 
+  // Only the mask region is considered, the histogram range is the value range of the image within it
+  AccumulatorContainer accumulators;
+  double histogramMinimum, histogramMaximum;
+  this->InternalAccumulateStatistics( image, adaptedMaskImage.GetPointer(),
+    adaptedMaskImage->GetBufferedRegion(), accumulators, histogramMinimum, histogramMaximum );
 
-  // If mask region is smaller than image region, extract the sub-sampled region from the original image
-  typename ImageType::SizeType imageSize = image->GetBufferedRegion().GetSize();
-  typename ImageType::SizeType maskSize = maskImage->GetBufferedRegion().GetSize();
-  bool maskSmallerImage = false;
-  for ( unsigned int i = 0; i < ImageType::ImageDimension; ++i )
+  if ( m_MaskingMode == MASKING_MODE_PLANARFIGURE )
   {
-    if ( maskSize[i] < imageSize[i] )
+    // Planar figure masks consist of label 1 only; keep its accumulator for incremental updates
+    StatisticsAccumulator accumulator;
+    if ( !accumulators.empty() )
+    {
+      accumulator = accumulators.front();
+    }
+    else
     {
-      maskSmallerImage = true;
+      accumulator.Label = 1;
+      accumulator.MinIndex.set_size( VImageDimension );
+      accumulator.MaxIndex.set_size( VImageDimension );
+      accumulator.Frequencies.assign( this->GetNumberOfHistogramBins( histogramMinimum, histogramMaximum ), 0.0 );
     }
+    m_PlanarFigureCache.Accumulator = accumulator;
+    m_PlanarFigureCache.HistogramMinimum = histogramMinimum;
+    m_PlanarFigureCache.HistogramMaximum = histogramMaximum;
   }
 
-  typename ImageType::ConstPointer adaptedImage;
-  if ( maskSmallerImage )
+  if ( accumulators.empty() )
   {
-    typename ExtractImageFilterType::Pointer extractImageFilter = ExtractImageFilterType::New();
-    extractImageFilter->SetInput( image );
-    extractImageFilter->SetExtractionRegion( adaptedMaskImage->GetBufferedRegion() );
-    extractImageFilter->Update();
-    adaptedImage = extractImageFilter->GetOutput();
+    histogramContainer->push_back( HistogramType::ConstPointer( m_EmptyHistogram ) );
+    statisticsContainer->push_back( Statistics() );
+    return;
   }
-  else
+
+  for ( AccumulatorContainer::const_iterator it = accumulators.begin(); it != accumulators.end(); ++it )
   {
-    adaptedImage = image;
+    Statistics statistics;
+    HistogramType::ConstPointer histogram;
+    this->AccumulatorToStatistics( *it, histogramMinimum, histogramMaximum, statistics, histogram );
+
+    statisticsContainer->push_back( statistics );
+    histogramContainer->push_back( histogram );
   }
+}
 
-  // Initialize Filter
-  typedef itk::StatisticsImageFilter< ImageType > StatisticsFilterType;
-  typename StatisticsFilterType::Pointer statisticsFilter = StatisticsFilterType::New();
-  statisticsFilter->SetInput( adaptedImage );
 
-  statisticsFilter->Update();
+template < typename TPixel, unsigned int VImageDimension >
+void ImageStatisticsCalculator::InternalUpdatePlanarFigureStatistics(
+  const itk::Image< TPixel, VImageDimension > *image,
+  itk::Image< unsigned short, VImageDimension > *maskImage,
+  StatisticsContainer* statisticsContainer,
+  HistogramContainer* histogramContainer )
+{
+  typedef itk::Image< TPixel, VImageDimension > ImageType;
+  typedef itk::Image< unsigned short, VImageDimension > MaskImageType;
 
-  int numberOfBins = std::floor( ( (statisticsFilter->GetMaximum() - statisticsFilter->GetMinimum() + 1) / m_HistogramBinSize) + 0.5 );
+  const MaskImageType *previousMask = m_PlanarFigureCache.Mask.GetPointer();
+  if ( previousMask == NULL
+    || previousMask->GetBufferedRegion() != maskImage->GetBufferedRegion()
+    || image->GetBufferedRegion() != maskImage->GetBufferedRegion() )
+  {
+    this->InternalCalculateStatisticsMasked( image, maskImage, statisticsContainer, histogramContainer );
+    return;
+  }
 
-  typename LabelStatisticsFilterType::Pointer labelStatisticsFilter;
-  labelStatisticsFilter = LabelStatisticsFilterType::New();
-  labelStatisticsFilter->SetInput( adaptedImage );
-  labelStatisticsFilter->SetLabelInput( adaptedMaskImage );
-  labelStatisticsFilter->UseHistogramsOn();
-  labelStatisticsFilter->SetHistogramParameters( numberOfBins, statisticsFilter->GetMinimum(), statisticsFilter->GetMaximum() );
+  statisticsContainer->clear();
+  histogramContainer->clear();
 
+  StatisticsAccumulator &accumulator = m_PlanarFigureCache.Accumulator;
+  const double histogramMinimum = m_PlanarFigureCache.HistogramMinimum;
+  const double histogramMaximum = m_PlanarFigureCache.HistogramMaximum;
+  const unsigned int numberOfBins = accumulator.Frequencies.size();
+  const double binWidth = ( histogramMaximum - histogramMinimum ) / numberOfBins;
+
+  // Only pixels that entered or left the figure change the statistics. They
+  // are collected separately and combined with the cached ones pairwise.
+  StatisticsAccumulator added, removed;
+  added.MinIndex.set_size( VImageDimension );
+  added.MaxIndex.set_size( VImageDimension );
+  added.Frequencies.assign( numberOfBins, 0.0 );
+  removed.MinIndex.set_size( VImageDimension );
+  removed.MaxIndex.set_size( VImageDimension );
+  removed.Frequencies.assign( numberOfBins, 0.0 );
+
+  const typename ImageType::RegionType region = maskImage->GetBufferedRegion();
+  itk::ImageRegionConstIterator< ImageType > imageIt( image, region );
+  itk::ImageRegionConstIterator< MaskImageType > previousIt( previousMask, region );
+  itk::ImageRegionConstIterator< MaskImageType > maskIt( maskImage, region );
+  for ( ; !maskIt.IsAtEnd(); ++imageIt, ++previousIt, ++maskIt )
+  {
+    const bool inside = maskIt.Get() != 0;
+    if ( inside == ( previousIt.Get() != 0 ) )
+    {
+      continue;
+    }
 
-  // Add progress listening
-  typedef itk::SimpleMemberCommand< ImageStatisticsCalculator > ITKCommandType;
-  ITKCommandType::Pointer progressListener;
-  progressListener = ITKCommandType::New();
-  progressListener->SetCallbackFunction( this,
-    &ImageStatisticsCalculator::MaskedStatisticsProgressUpdate );
-  unsigned long observerTag = labelStatisticsFilter->AddObserver(
-    itk::ProgressEvent(), progressListener );
+    const double value = imageIt.Get();
+    AccumulatePixel( inside ? added : removed, value,
+      GetHistogramBin( value, histogramMinimum, binWidth, numberOfBins ), imageIt );
+  }
 
-  // Execute filter
-  this->InvokeEvent( itk::StartEvent() );
+  // The full computation reports the first extremum in raster order. Removing
+  // an extremum or adding a pixel of equal value may change which one that is,
+  // the extrema are searched again then.
+  const bool rescanExtrema = ( removed.N > 0 && ( removed.Min <= accumulator.Min || removed.Max >= accumulator.Max ) )
+    || ( added.N > 0 && ( added.Min == accumulator.Min || added.Max == accumulator.Max ) );
 
-  // Make sure that only the mask region is considered (otherwise, if the mask region is smaller
-  // than the image region, the Update() would result in an exception).
-  labelStatisticsFilter->GetOutput()->SetRequestedRegion( adaptedMaskImage->GetLargestPossibleRegion() );
+  RemoveAccumulator( accumulator, removed );
+  MergeAccumulator( accumulator, added );
 
+  if ( accumulator.N == 0 )
+  {
+    accumulator.Min = itk::NumericTraits< double >::max();
+    accumulator.Max = itk::NumericTraits< double >::NonpositiveMin();
 
-  // Execute the filter
-  labelStatisticsFilter->Update();
-  this->InvokeEvent( itk::EndEvent() );
-  labelStatisticsFilter->RemoveObserver( observerTag );
+    histogramContainer->push_back( HistogramType::ConstPointer( m_EmptyHistogram ) );
+    statisticsContainer->push_back( Statistics() );
+    return;
+  }
 
-  // Find all relevant labels of mask (other than 0)
-  std::list< int > relevantLabels;
-  bool maskNonEmpty = false;
-  unsigned int i;
-  for ( i = 1; i < 4096; ++i )
+  if ( rescanExtrema )
   {
-    if ( labelStatisticsFilter->HasLabel( i ) )
+    accumulator.Min = itk::NumericTraits< double >::max();
+    accumulator.Max = itk::NumericTraits< double >::NonpositiveMin();
+    for ( imageIt.GoToBegin(), maskIt.GoToBegin(); !maskIt.IsAtEnd(); ++imageIt, ++maskIt )
     {
-      relevantLabels.push_back( i );
-      maskNonEmpty = true;
+      if ( maskIt.Get() != 0 )
+      {
+        UpdateExtrema( accumulator, imageIt.Get(), imageIt );
+      }
     }
   }
-  if ( maskNonEmpty )
+
+  Statistics statistics;
+  HistogramType::ConstPointer histogram;
+  this->AccumulatorToStatistics( accumulator, histogramMinimum, histogramMaximum, statistics, histogram );
+
+  statisticsContainer->push_back( statistics );
+  histogramContainer->push_back( histogram );
+}
+
+
+template < typename TPixel, unsigned int VImageDimension >
+void ImageStatisticsCalculator::InternalAccumulateStatistics(
+  const itk::Image< TPixel, VImageDimension > *image,
+  const itk::Image< unsigned short, VImageDimension > *maskImage,
+  const typename itk::Image< TPixel, VImageDimension >::RegionType &region,
+  AccumulatorContainer &accumulators,
+  double &histogramMinimum, double &histogramMaximum )
+{
+  typedef AccumulateThreadData< TPixel, VImageDimension > ThreadDataType;
+
+  accumulators.clear();
+  histogramMinimum = itk::NumericTraits< double >::max();
+  histogramMaximum = itk::NumericTraits< double >::NonpositiveMin();
+
+  ThreadDataType data;
+  data.Image = image;
+  data.Mask = maskImage;
+  data.Region = region;
+
+  const itk::SizeValueType extent = region.GetSize( VImageDimension - 1 );
+  unsigned int numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  if ( extent < numberOfThreads )
   {
-    std::list< int >::iterator it;
-    for ( it = relevantLabels.begin(), i = 0;
-          it != relevantLabels.end();
-          ++it, ++i )
-    {
-      histogramContainer->push_back( HistogramType::ConstPointer( labelStatisticsFilter->GetHistogram( (*it) ) ) );
-
-      Statistics statistics;
-      statistics.Label = (*it);
-      statistics.N = labelStatisticsFilter->GetCount( *it );
-      statistics.Min = labelStatisticsFilter->GetMinimum( *it );
-      statistics.Max = labelStatisticsFilter->GetMaximum( *it );
-      statistics.Mean = labelStatisticsFilter->GetMean( *it );
-      statistics.Median = labelStatisticsFilter->GetMedian( *it );
-      statistics.Sigma = labelStatisticsFilter->GetSigma( *it );
-      statistics.RMS = sqrt( statistics.Mean * statistics.Mean
-        + statistics.Sigma * statistics.Sigma );
-
-      // restrict image to mask area for min/max index calculation
-      typedef itk::MaskImageFilter< ImageType, MaskImageType, ImageType > MaskImageFilterType;
-      typename MaskImageFilterType::Pointer masker = MaskImageFilterType::New();
-      masker->SetOutsideValue( (statistics.Min+statistics.Max)/2 );
-      masker->SetInput1(adaptedImage);
-      masker->SetInput2(adaptedMaskImage);
-      masker->Update();
-      // get index of minimum and maximum
-      typedef itk::MinimumMaximumImageCalculator< ImageType > MinMaxFilterType;
-      typename MinMaxFilterType::Pointer minMaxFilter = MinMaxFilterType::New();
-      minMaxFilter->SetImage( masker->GetOutput() );
-      unsigned long observerTag2 = minMaxFilter->AddObserver( itk::ProgressEvent(), progressListener );
-      minMaxFilter->Compute();
-      minMaxFilter->RemoveObserver( observerTag2 );
-      this->InvokeEvent( itk::EndEvent() );
-
-        statistics.MinIndex.set_size(adaptedImage->GetImageDimension());
-        statistics.MaxIndex.set_size(adaptedImage->GetImageDimension());
-
-        typename MinMaxFilterType::IndexType tempMaxIndex = minMaxFilter->GetIndexOfMaximum();
-        typename MinMaxFilterType::IndexType tempMinIndex = minMaxFilter->GetIndexOfMinimum();
+    numberOfThreads = std::max< itk::SizeValueType >( extent, 1 );
+  }
 
-// FIX BUG 14644
-        //If a PlanarFigure is used for segmentation the
-        //adaptedImage is a single slice (2D). Adding the
-        // 3. dimension.
-        if (m_MaskingMode == MASKING_MODE_PLANARFIGURE && m_Image->GetDimension()==3)
-        {
-            statistics.MaxIndex.set_size(m_Image->GetDimension());
-            statistics.MaxIndex[m_PlanarFigureCoordinate0]=tempMaxIndex[0];
-            statistics.MaxIndex[m_PlanarFigureCoordinate1]=tempMaxIndex[1];
-            statistics.MaxIndex[m_PlanarFigureAxis]=m_PlanarFigureSlice;
-
-            statistics.MinIndex.set_size(m_Image->GetDimension());
-            statistics.MinIndex[m_PlanarFigureCoordinate0]=tempMinIndex[0];
-            statistics.MinIndex[m_PlanarFigureCoordinate1]=tempMinIndex[1];
-            statistics.MinIndex[m_PlanarFigureAxis]=m_PlanarFigureSlice;
-        } else
+  this->InvokeEvent( itk::StartEvent() );
+
+  // First pass: value range (for the histogram) and labels present in the mask
+  data.Minima.assign( numberOfThreads, histogramMinimum );
+  data.Maxima.assign( numberOfThreads, histogramMaximum );
+  if ( maskImage != NULL )
+  {
+    data.LabelsPresent.assign( numberOfThreads, std::vector< unsigned char >( NumberOfLabels, 0 ) );
+  }
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( numberOfThreads );
+  threader->SetSingleMethod( ValueRangeThread< TPixel, VImageDimension >, &data );
+  threader->SingleMethodExecute();
+  this->InvokeEvent( itk::ProgressEvent() );
+
+  for ( unsigned int thread = 0; thread < numberOfThreads; ++thread )
+  {
+    histogramMinimum = std::min( histogramMinimum, data.Minima[thread] );
+    histogramMaximum = std::max( histogramMaximum, data.Maxima[thread] );
+  }
+  if ( histogramMinimum > histogramMaximum )
+  {
+    // empty region
+    this->InvokeEvent( itk::EndEvent() );
+    return;
+  }
+
+  data.NumberOfBins = this->GetNumberOfHistogramBins( histogramMinimum, histogramMaximum );
+  data.HistogramMinimum = histogramMinimum;
+  data.BinWidth = ( histogramMaximum - histogramMinimum ) / data.NumberOfBins;
+
+  StatisticsAccumulator initialAccumulator;
+  initialAccumulator.MinIndex.set_size( VImageDimension );
+  initialAccumulator.MaxIndex.set_size( VImageDimension );
+  initialAccumulator.MinIndex.fill( 0 );
+  initialAccumulator.MaxIndex.fill( 0 );
+  initialAccumulator.Frequencies.assign( data.NumberOfBins, 0.0 );
+
+  // Labels in ascending order
+  if ( maskImage != NULL )
+  {
+    data.SlotOfLabel.assign( NumberOfLabels, -1 );
+    for ( unsigned int label = 1; label < NumberOfLabels; ++label )
+    {
+      for ( unsigned int thread = 0; thread < numberOfThreads; ++thread )
+      {
+        if ( data.LabelsPresent[thread][label] )
         {
-          for (unsigned int i = 0; i<statistics.MaxIndex.size(); i++)
-          {
-            statistics.MaxIndex[i] = tempMaxIndex[i];
-            statistics.MinIndex[i] = tempMinIndex[i];
-          }
+          data.SlotOfLabel[label] = accumulators.size();
+          initialAccumulator.Label = label;
+          accumulators.push_back( initialAccumulator );
+          break;
         }
-// FIX END
+      }
+    }
+  }
+  else
+  {
+    initialAccumulator.Label = 1;
+    accumulators.push_back( initialAccumulator );
+  }
+
+  if ( accumulators.empty() )
+  {
+    this->InvokeEvent( itk::EndEvent() );
+    return;
+  }
+
+  // Every thread fills its own histograms, limit their memory for fine bins and many labels
+  while ( numberOfThreads > 1 && numberOfThreads * accumulators.size() * data.NumberOfBins > MaximumNumberOfThreadBins )
+  {
+    --numberOfThreads;
+  }
 
-      statisticsContainer->push_back( statistics );
+  // Second pass: moments, extrema and histograms per label
+  data.Accumulators.assign( numberOfThreads, accumulators );
+  threader->SetNumberOfThreads( numberOfThreads );
+  threader->SetSingleMethod( AccumulateThread< TPixel, VImageDimension >, &data );
+  threader->SingleMethodExecute();
+  this->InvokeEvent( itk::ProgressEvent() );
+
+  // Threads work on consecutive parts, merging in thread order keeps the first extremum
+  for ( unsigned int thread = 0; thread < numberOfThreads; ++thread )
+  {
+    for ( unsigned int slot = 0; slot < accumulators.size(); ++slot )
+    {
+      MergeAccumulator( accumulators[slot], data.Accumulators[thread][slot] );
     }
   }
+
+  this->InvokeEvent( itk::EndEvent() );
+}
+
+
+void ImageStatisticsCalculator::AccumulatorToStatistics(
+  const StatisticsAccumulator &accumulator,
+  double histogramMinimum, double histogramMaximum,
+  Statistics &statistics, HistogramType::ConstPointer &histogram ) const
+{
+  statistics.Reset();
+  statistics.Label = accumulator.Label;
+  statistics.N = accumulator.N;
+  statistics.Min = accumulator.Min;
+  statistics.Max = accumulator.Max;
+  statistics.Mean = accumulator.Mean;
+  if ( accumulator.N > 1 )
+  {
+    statistics.Variance = accumulator.SquaredDeviations / ( accumulator.N - 1 );
+  }
+  statistics.Sigma = sqrt( statistics.Variance );
+  statistics.RMS = sqrt( statistics.Mean * statistics.Mean
+    + statistics.Sigma * statistics.Sigma );
+
+  HistogramType::Pointer newHistogram = HistogramType::New();
+  newHistogram->SetMeasurementVectorSize( 1 );
+  HistogramType::SizeType histogramSize( 1 );
+  histogramSize.Fill( accumulator.Frequencies.size() );
+  HistogramType::MeasurementVectorType lowerBound( 1 );
+  HistogramType::MeasurementVectorType upperBound( 1 );
+  lowerBound.Fill( histogramMinimum );
+  upperBound.Fill( histogramMaximum );
+  newHistogram->Initialize( histogramSize, lowerBound, upperBound );
+
+  // The median is the center of the bin containing the middle pixel, as in itk::LabelStatisticsImageFilter
+  double count = 0.0;
+  bool medianFound = false;
+  for ( unsigned int bin = 0; bin < accumulator.Frequencies.size(); ++bin )
+  {
+    newHistogram->SetFrequency( bin, accumulator.Frequencies[bin] );
+    count += accumulator.Frequencies[bin];
+    if ( !medianFound && count >= accumulator.N / 2.0 )
+    {
+      statistics.Median = ( newHistogram->GetBinMin( 0, bin ) + newHistogram->GetBinMax( 0, bin ) ) / 2.0;
+      medianFound = true;
+    }
+  }
+  histogram = newHistogram.GetPointer();
+
+// FIX BUG 14644
+  //If a PlanarFigure is used for segmentation the
+  //statistics are computed on a single slice (2D). Adding the
+  // 3. dimension.
+  if ( m_MaskingMode == MASKING_MODE_PLANARFIGURE && m_Image->GetDimension() == 3 && accumulator.MinIndex.size() == 2 )
+  {
+    statistics.MaxIndex.set_size( 3 );
+    statistics.MaxIndex[m_PlanarFigureCoordinate0] = accumulator.MaxIndex[0];
+    statistics.MaxIndex[m_PlanarFigureCoordinate1] = accumulator.MaxIndex[1];
+    statistics.MaxIndex[m_PlanarFigureAxis] = m_PlanarFigureSlice;
+
+    statistics.MinIndex.set_size( 3 );
+    statistics.MinIndex[m_PlanarFigureCoordinate0] = accumulator.MinIndex[0];
+    statistics.MinIndex[m_PlanarFigureCoordinate1] = accumulator.MinIndex[1];
+    statistics.MinIndex[m_PlanarFigureAxis] = m_PlanarFigureSlice;
+  }
   else
   {
-    histogramContainer->push_back( HistogramType::ConstPointer( m_EmptyHistogram ) );
-    statisticsContainer->push_back( Statistics() );
+    statistics.MinIndex = accumulator.MinIndex;
+    statistics.MaxIndex = accumulator.MaxIndex;
+  }
+// FIX END
+}
+
+
+unsigned int ImageStatisticsCalculator::GetNumberOfHistogramBins( double minimum, double maximum ) const
+{
+  if ( !( maximum >= minimum ) )
+  {
+    return 1;
   }
+  const unsigned int binSize = m_HistogramBinSize > 0 ? m_HistogramBinSize : 1;
+  unsigned int numberOfBins = std::floor( ( (maximum - minimum + 1) / binSize ) + 0.5 );
+  return std::max( numberOfBins, 1u );
 }
 
 
@@ -1269,22 +1703,4 @@ void ImageStatisticsCalculator::InternalCalculateMaskFromPlanarFigure(
 }
 
 
-void ImageStatisticsCalculator::UnmaskedStatisticsProgressUpdate()
-{
-  // Need to throw away every second progress event to reach a final count of
-  // 100 since two consecutive filters are used in this case
-  static int updateCounter = 0;
-  if ( updateCounter++ % 2 == 0 )
-  {
-    this->InvokeEvent( itk::ProgressEvent() );
-  }
-}
-
-
-void ImageStatisticsCalculator::MaskedStatisticsProgressUpdate()
-{
-  this->InvokeEvent( itk::ProgressEvent() );
-}
-
-
 }
@@ -54,6 +54,11 @@ namespace mitk
  * switching back and forth between operation modes without modifying mask or
  * image, the information doesn't need to be recalculated.
  *
+ * Statistics and histograms of all labels are computed in a single
+ * multi-threaded pass over the image. When a planar figure is modified on
+ * the same slice, the statistics are updated from the pixels that entered or
+ * left the figure only, instead of evaluating the whole mask again.
+ *
  * Note: currently time-resolved and multi-channel pictures are not properly
  * supported.
  */
@@ -104,8 +109,39 @@ public:
     }
   };
 
+  /** \brief Running statistics of a single label.
+   *
+   * Statistics and histogram of the label are derived from them, and pixels
+   * can be added or removed without visiting the other pixels again. Mean and
+   * the sum of squared deviations from it are updated as proposed by Welford
+   * and combined pairwise (Chan et al.), which does not lose precision the
+   * way a difference of sums of squares does. */
+  struct StatisticsAccumulator
+  {
+    StatisticsAccumulator()
+      : Label( 0 ),
+        N( 0 ),
+        Mean( 0.0 ),
+        SquaredDeviations( 0.0 ),
+        Min( itk::NumericTraits< double >::max() ),
+        Max( itk::NumericTraits< double >::NonpositiveMin() )
+    {
+    }
+
+    int Label;
+    unsigned int N;
+    double Mean;
+    double SquaredDeviations;
+    double Min;
+    double Max;
+    vnl_vector< int > MinIndex;
+    vnl_vector< int > MaxIndex;
+    std::vector< double > Frequencies;
+  };
+
   typedef std::vector< HistogramType::ConstPointer > HistogramContainer;
   typedef std::vector< Statistics > StatisticsContainer;
+  typedef std::vector< StatisticsAccumulator > AccumulatorContainer;
 
 
   mitkClassMacro( ImageStatisticsCalculator, itk::Object );
@@ -162,6 +198,12 @@ public:
    * case, false is returned; otherwise, true.*/
   virtual bool ComputeStatistics( unsigned int timeStep = 0 );
 
+  /** \brief Compute statistics (together with histogram) of all time steps
+   * for the current masking mode.
+   *
+   * Returns true if the statistics of any time step were recomputed. */
+  virtual bool ComputeStatisticsOfAllTimeSteps();
+
 
   /** \brief Retrieve the histogram depending on the current masking mode.
    *
@@ -229,6 +271,36 @@ protected:
     StatisticsContainer* statisticsContainer,
     HistogramContainer* histogramContainer );
 
+  /** \brief Updates the planar figure statistics of the previous
+   * computation by the pixels in which maskImage differs from the previous
+   * mask. See m_PlanarFigureCache. */
+  template < typename TPixel, unsigned int VImageDimension >
+  void InternalUpdatePlanarFigureStatistics(
+    const itk::Image< TPixel, VImageDimension > *image,
+    itk::Image< unsigned short, VImageDimension > *maskImage,
+    StatisticsContainer* statisticsContainer,
+    HistogramContainer* histogramContainer );
+
+  /** \brief Accumulates the pixels of region per label of maskImage (or as
+   * label 1 if maskImage is NULL), multi-threaded along the slowest axis.
+   *
+   * The histogram range is the value range of the image within region. */
+  template < typename TPixel, unsigned int VImageDimension >
+  void InternalAccumulateStatistics(
+    const itk::Image< TPixel, VImageDimension > *image,
+    const itk::Image< unsigned short, VImageDimension > *maskImage,
+    const typename itk::Image< TPixel, VImageDimension >::RegionType &region,
+    AccumulatorContainer &accumulators,
+    double &histogramMinimum, double &histogramMaximum );
+
+  /** \brief Converts the accumulated moments into statistics and histogram */
+  void AccumulatorToStatistics( const StatisticsAccumulator &accumulator,
+    double histogramMinimum, double histogramMaximum,
+    Statistics &statistics, HistogramType::ConstPointer &histogram ) const;
+
+  /** \brief Number of histogram bins for the given value range */
+  unsigned int GetNumberOfHistogramBins( double minimum, double maximum ) const;
+
   template < typename TPixel, unsigned int VImageDimension >
   void InternalCalculateMaskFromPlanarFigure(
     const itk::Image< TPixel, VImageDimension > *image, unsigned int axis );
@@ -281,9 +353,40 @@ protected:
   }
 
 
-  void UnmaskedStatisticsProgressUpdate();
+  /** \brief State of the last planar figure computation. As long as image,
+   * slice and settings stay the same, the accumulated sums of the previous
+   * mask are updated instead of recomputed. */
+  struct PlanarFigureCache
+  {
+    PlanarFigureCache()
+      : Valid( false ),
+        TimeStep( 0 ),
+        Axis( 0 ),
+        Slice( 0 ),
+        ImageMTime( 0 ),
+        HistogramBinSize( 0 ),
+        DoIgnorePixelValue( false ),
+        IgnorePixelValue( 0.0 ),
+        HistogramMinimum( 0.0 ),
+        HistogramMaximum( 0.0 )
+    {
+    }
 
-  void MaskedStatisticsProgressUpdate();
+    bool Valid;
+    unsigned int TimeStep;
+    unsigned int Axis;
+    unsigned int Slice;
+    unsigned long ImageMTime;
+    unsigned int HistogramBinSize;
+    bool DoIgnorePixelValue;
+    double IgnorePixelValue;
+
+    mitk::Image::ConstPointer SliceImage;
+    MaskImage2DType::Pointer Mask;
+    StatisticsAccumulator Accumulator;
+    double HistogramMinimum;
+    double HistogramMaximum;
+  };
 
 
   /** m_Image contains the input image (e.g. 2D, 3D, 3D+t)*/
@@ -335,6 +438,8 @@ protected:
 
   unsigned int m_HistogramBinSize;    ///Bin size for histogram resoluion.
 
+  PlanarFigureCache m_PlanarFigureCache;
+
 };
 
 }
@@ -17,11 +17,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkDiffSliceOperation.h"
 
 #include <itkCommand.h>
+#include "itk_zlib.h"
 
 mitk::DiffSliceOperation::DiffSliceOperation():Operation(1)
 {
   m_TimeStep = 0;
-  m_Slice = NULL;
+  m_UncompressedSliceSize = 0;
+  m_SliceScalarType = VTK_VOID;
+  m_SliceNumberOfComponents = 0;
   m_Image = NULL;
   m_WorldGeometry = NULL;
   m_SliceGeometry = NULL;
@@ -50,10 +53,7 @@ mitk::DiffSliceOperation::DiffSliceOperation(mitk::Image* imageVolume,
 
   m_TimeStep = timestep;
 
-  /*m_zlibSliceContainer = CompressedImageContainer::New();
-  m_zlibSliceContainer->SetImage( slice );*/
-  m_Slice = vtkSmartPointer<vtkImageData>::New();
-  m_Slice->DeepCopy(slice);
+  this->SetImage(slice);
 
   m_Image = imageVolume;
 
@@ -75,9 +75,7 @@ mitk::DiffSliceOperation::DiffSliceOperation(mitk::Image* imageVolume,
 mitk::DiffSliceOperation::~DiffSliceOperation()
 {
 
-  m_Slice = NULL;
   m_WorldGeometry = NULL;
-  //m_zlibSliceContainer = NULL;
 
   if (m_ImageIsValid)
   {
@@ -87,15 +85,67 @@ mitk::DiffSliceOperation::~DiffSliceOperation()
   m_Image = NULL;
 }
 
-vtkImageData* mitk::DiffSliceOperation::GetSlice()
+void mitk::DiffSliceOperation::SetImage(vtkImageData* slice)
 {
-  //Image::ConstPointer image = m_zlibSliceContainer->GetImage().GetPointer();
-  return m_Slice;
+  m_CompressedSlice.clear();
+  m_UncompressedSliceSize = 0;
+
+  if (!slice)
+    return;
+
+  slice->GetExtent(m_SliceExtent);
+  slice->GetSpacing(m_SliceSpacing);
+  slice->GetOrigin(m_SliceOrigin);
+  m_SliceScalarType = slice->GetScalarType();
+  m_SliceNumberOfComponents = slice->GetNumberOfScalarComponents();
+  m_UncompressedSliceSize = slice->GetNumberOfPoints() * m_SliceNumberOfComponents * slice->GetScalarSize();
+
+  //compress with the fastest level as this is done twice for each edited slice
+  ::uLongf destLen( ::compressBound(m_UncompressedSliceSize) );
+  m_CompressedSlice.resize(destLen);
+  int zlibRetVal = ::compress2(&m_CompressedSlice[0], &destLen, static_cast<const ::Bytef*>(slice->GetScalarPointer()),
+                               m_UncompressedSliceSize, Z_BEST_SPEED);
+  if (zlibRetVal != Z_OK)
+  {
+    MITK_ERROR << "Could not compress slice for undo operation (zlib error " << zlibRetVal << ")";
+    m_CompressedSlice.clear();
+    return;
+  }
+
+  // shrink the buffer to the needed amount of memory
+  std::vector<unsigned char>(m_CompressedSlice.begin(), m_CompressedSlice.begin() + destLen).swap(m_CompressedSlice);
+}
+
+vtkSmartPointer<vtkImageData> mitk::DiffSliceOperation::GetSlice()
+{
+  if (m_CompressedSlice.empty())
+    return vtkSmartPointer<vtkImageData>();
+
+  vtkSmartPointer<vtkImageData> slice = vtkSmartPointer<vtkImageData>::New();
+  slice->SetExtent(m_SliceExtent);
+  slice->SetSpacing(m_SliceSpacing);
+  slice->SetOrigin(m_SliceOrigin);
+  slice->AllocateScalars(m_SliceScalarType, m_SliceNumberOfComponents);
+
+  ::uLongf destLen(m_UncompressedSliceSize);
+  int zlibRetVal = ::uncompress(static_cast< ::Bytef*>(slice->GetScalarPointer()), &destLen, &m_CompressedSlice[0], m_CompressedSlice.size());
+  if (zlibRetVal != Z_OK || destLen != m_UncompressedSliceSize)
+  {
+    MITK_ERROR << "Could not uncompress slice of undo operation (zlib error " << zlibRetVal << ")";
+    return vtkSmartPointer<vtkImageData>();
+  }
+
+  return slice;
+}
+
+unsigned long mitk::DiffSliceOperation::GetMemorySize()
+{
+  return m_CompressedSlice.size();
 }
 
 bool mitk::DiffSliceOperation::IsValid()
 {
-  return m_ImageIsValid && (m_Slice.GetPointer() != NULL) && (m_WorldGeometry.IsNotNull());//TODO improve
+  return m_ImageIsValid && !m_CompressedSlice.empty() && (m_WorldGeometry.IsNotNull());//TODO improve
 }
 
 void mitk::DiffSliceOperation::OnImageDeleted()
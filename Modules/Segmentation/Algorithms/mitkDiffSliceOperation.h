@@ -20,12 +20,13 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <MitkSegmentationExports.h>
 #include "mitkCommon.h"
 #include <mitkOperation.h>
-//#include "mitkCompressedImageContainer.h"
 
 #include <mitkImage.h>
 #include <vtkSmartPointer.h>
 #include <vtkImageData.h>
 
+#include <vector>
+
 //DEPRECATED
 #include <mitkTimeGeometry.h>
 
@@ -43,6 +44,9 @@ namespace mitk
      currentWorldGeometry   specifies the axis where the slice has to be applied in the volume.
 
     This Operation can be used to realize undo-redo functionality for e.g. segmentation purposes.
+
+    The slice is kept zlib-compressed, because an undo stack holds two slices per edit and segmentation
+    slices mostly consist of a few homogeneous regions. GetSlice() restores the slice on demand.
   */
   class MitkSegmentation_EXPORT DiffSliceOperation : public Operation
   {
@@ -78,10 +82,13 @@ namespace mitk
     /** \brief Get th image volume.*/
     mitk::Image* GetImage(){return this->m_Image;}
 
-    /** \brief Set thee slice to be applied.*/
-    void SetImage(vtkImageData* slice){ this->m_Slice = slice;}
-    /** \brief Get the slice that is applied in the operation.*/
-    vtkImageData* GetSlice();
+    /** \brief Set thee slice to be applied. The slice is compressed, so it can be released afterwards.*/
+    void SetImage(vtkImageData* slice);
+    /** \brief Get the slice that is applied in the operation. The slice is uncompressed on each call.*/
+    vtkSmartPointer<vtkImageData> GetSlice();
+
+    /** \brief Returns the number of bytes of the compressed slice.*/
+    virtual unsigned long GetMemorySize();
 
     /** \brief Get timeStep.*/
     void SetTimeStep(unsigned int timestep){this->m_TimeStep = timestep;}
@@ -117,11 +124,16 @@ namespace mitk
     /** \brief Callback for image observer.*/
     void OnImageDeleted();
 
-    //CompressedImageContainer::Pointer m_zlibSliceContainer;
-
     mitk::Image* m_Image;
 
-    vtkSmartPointer<vtkImageData> m_Slice;
+    /** \brief The zlib-compressed scalars of the slice and the information needed to restore it.*/
+    std::vector<unsigned char> m_CompressedSlice;
+    unsigned long m_UncompressedSliceSize;
+    int m_SliceExtent[6];
+    double m_SliceSpacing[3];
+    double m_SliceOrigin[3];
+    int m_SliceScalarType;
+    int m_SliceNumberOfComponents;
 
     SlicedGeometry3D::Pointer m_SliceGeometry;
 
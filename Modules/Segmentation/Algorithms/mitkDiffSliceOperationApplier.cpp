@@ -41,8 +41,10 @@ void mitk::DiffSliceOperationApplier::ExecuteOperation( Operation* operation )
     //the actual overwrite filter (vtk)
     vtkSmartPointer<mitkVtkImageOverwrite> reslice = vtkSmartPointer<mitkVtkImageOverwrite>::New();
 
-    //Set the slice as 'input'
-    reslice->SetInputSlice(imageOperation->GetSlice());
+    //Set the slice as 'input'. The slice is restored from its compressed representation
+    //and is kept alive until the volume is overwritten
+    vtkSmartPointer<vtkImageData> slice = imageOperation->GetSlice();
+    reslice->SetInputSlice(slice);
 
     //set overwrite mode to true to write back to the image volume
     reslice->SetOverwriteMode(true);
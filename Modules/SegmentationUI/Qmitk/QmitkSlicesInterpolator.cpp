@@ -102,6 +102,10 @@ QmitkSlicesInterpolator::QmitkSlicesInterpolator(QWidget* parent, const char*  /
   m_ChkShowPositionNodes = new QCheckBox("Show Position Nodes", m_GroupBoxEnableExclusiveInterpolationMode);
   vboxLayout->addWidget(m_ChkShowPositionNodes);
 
+  m_ChkIncremental3D = new QCheckBox("Incremental 3D Interpolation", m_GroupBoxEnableExclusiveInterpolationMode);
+  m_ChkIncremental3D->setToolTip("Reuses the previous interpolation when a contour is added or edited. Faster for many contours, but the surface slightly differs.");
+  vboxLayout->addWidget(m_ChkIncremental3D);
+
   this->HideAllInterpolationControls();
 
   connect(m_CmbInterpolation, SIGNAL(currentIndexChanged(int)), this, SLOT(OnInterpolationMethodChanged(int)));
@@ -110,6 +114,7 @@ QmitkSlicesInterpolator::QmitkSlicesInterpolator(QWidget* parent, const char*  /
   connect(m_BtnApply3D, SIGNAL(clicked()), this, SLOT(OnAccept3DInterpolationClicked()));
   connect(m_ChkShowPositionNodes, SIGNAL(toggled(bool)), this, SLOT(OnShowMarkers(bool)));
   connect(m_ChkShowPositionNodes, SIGNAL(toggled(bool)), this, SIGNAL(SignalShowMarkerNodes(bool)));
+  connect(m_ChkIncremental3D, SIGNAL(toggled(bool)), this, SLOT(OnIncremental3DInterpolationToggled(bool)));
 
   QHBoxLayout* layout = new QHBoxLayout(this);
   layout->addWidget(m_GroupBoxEnableExclusiveInterpolationMode);
@@ -350,6 +355,7 @@ void QmitkSlicesInterpolator::Show3DInterpolationControls(bool show)
 {
   m_BtnApply3D->setVisible(show);
   m_ChkShowPositionNodes->setVisible(show);
+  m_ChkIncremental3D->setVisible(show);
 }
 
 
@@ -392,6 +398,12 @@ void QmitkSlicesInterpolator::OnInterpolationMethodChanged(int index)
   }
 }
 
+void QmitkSlicesInterpolator::OnIncremental3DInterpolationToggled(bool state)
+{
+  // Triggers a new interpolation via OnSurfaceInterpolationInfoChanged()
+  m_SurfaceInterpolator->SetUseIncrementalInterpolation(state);
+}
+
 void QmitkSlicesInterpolator::OnShowMarkers(bool state)
 {
   mitk::DataStorage::SetOfObjects::ConstPointer allContourMarkers = m_DataStorage->GetSubset(mitk::NodePredicateProperty::New("isContourMarker"
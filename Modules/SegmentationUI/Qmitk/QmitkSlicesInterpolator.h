@@ -184,6 +184,7 @@ class MitkSegmentationUI_EXPORT QmitkSlicesInterpolator : public QWidget
     void On3DInterpolationEnabled(bool);
     void OnInterpolationDisabled(bool);
     void OnShowMarkers(bool);
+    void OnIncremental3DInterpolationToggled(bool);
 
     void Run3DInterpolation();
 
@@ -252,6 +253,7 @@ private:
     QPushButton* m_BtnApplyForAllSlices2D;
     QPushButton* m_BtnApply3D;
     QCheckBox* m_ChkShowPositionNodes;
+    QCheckBox* m_ChkIncremental3D;
 
     mitk::DataNode::Pointer m_FeedbackNode;
     mitk::DataNode::Pointer m_InterpolatedSurfaceNode;
@@ -20,17 +20,45 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <mitkTestFixture.h>
 #include <mitkTestingMacros.h>
 #include <mitkComputeContourSetNormalsFilter.h>
+#include <mitkImageReadAccessor.h>
+#include <itkCommand.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// Aborts the observed filter, used to interrupt the solver at its first progress event
+class AbortFilterCommand : public itk::Command
+{
+public:
+  typedef AbortFilterCommand Self;
+  typedef itk::SmartPointer<Self> Pointer;
+  itkNewMacro(Self);
+
+  void Execute(itk::Object* caller, const itk::EventObject&)
+  {
+    static_cast<itk::ProcessObject*>(caller)->SetAbortGenerateData(true);
+  }
+
+  void Execute(const itk::Object*, const itk::EventObject&)
+  {
+  }
+};
 
 class mitkCreateDistanceImageFromSurfaceFilterTestSuite : public mitk::TestFixture
 {
   CPPUNIT_TEST_SUITE(mitkCreateDistanceImageFromSurfaceFilterTestSuite);
   MITK_TEST(TestCreateDistanceImageForLiver);
   MITK_TEST(TestCreateDistanceImageForTube);
+  MITK_TEST(TestCompactSupportSolverForLiver);
+  MITK_TEST(TestFarFieldApproximationForLiver);
+  MITK_TEST(TestReuseWeightsForLiver);
+  MITK_TEST(TestUpdateAfterAbortForLiver);
+  MITK_TEST(TestNumberOfThreadsForLiver);
   CPPUNIT_TEST_SUITE_END();
 
 private:
 
   std::vector<mitk::Surface::Pointer> contourList;
+  mitk::ComputeContourSetNormalsFilter::Pointer m_NormalsFilter;
 
 public:
 
@@ -129,6 +157,192 @@ public:
     CPPUNIT_ASSERT_MESSAGE("HolesDistanceImages are not equal!", mitk::Equal(*(holesDistanceImageReference), *(holeDistanceImage), 0.0001, true));
   }
 
+  void LoadLiverContours()
+  {
+    unsigned int NUMBER_OF_LIVER_CONTOURS = 18;
+
+    for (unsigned int i = 0; i <= NUMBER_OF_LIVER_CONTOURS; ++i)
+    {
+      std::stringstream s;
+      s << "SurfaceInterpolation/InterpolateLiver/LiverContourWithNormals_";
+      s << i;
+      s << ".vtk";
+      mitk::Surface::Pointer contour = mitk::IOUtil::LoadSurface(GetTestDataFilePath(s.str()));
+      contourList.push_back(contour);
+    }
+  }
+
+  // Connects the loaded contours to the filter, without updating it
+  void SetLiverInputs(mitk::CreateDistanceImageFromSurfaceFilter* interpolateSurfaceFilter)
+  {
+    mitk::Image::Pointer segmentationImage = mitk::IOUtil::LoadImage(GetTestDataFilePath("SurfaceInterpolation/Reference/LiverSegmentation.nrrd"));
+
+    m_NormalsFilter = mitk::ComputeContourSetNormalsFilter::New();
+
+    itk::ImageBase<3>::Pointer itkImage = itk::ImageBase<3>::New();
+    AccessFixedDimensionByItk_1( segmentationImage, GetImageBase, 3, itkImage );
+    interpolateSurfaceFilter->SetReferenceImage( itkImage.GetPointer() );
+
+    for (unsigned int j = 0; j < contourList.size(); j++)
+    {
+      m_NormalsFilter->SetInput(j, contourList.at(j));
+      interpolateSurfaceFilter->SetInput(j, m_NormalsFilter->GetOutput(j));
+    }
+  }
+
+  mitk::Image::Pointer InterpolateLiver(mitk::CreateDistanceImageFromSurfaceFilter* interpolateSurfaceFilter)
+  {
+    this->LoadLiverContours();
+    this->SetLiverInputs(interpolateSurfaceFilter);
+
+    interpolateSurfaceFilter->Update();
+
+    return interpolateSurfaceFilter->GetOutput();
+  }
+
+  // Replaces the last contour by a copy moved within its plane
+  void MoveLastContour()
+  {
+    mitk::Surface::Pointer moved = contourList.back()->Clone();
+    vtkPoints* points = moved->GetVtkPolyData()->GetPoints();
+    for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i)
+    {
+      double point[3];
+      points->GetPoint(i, point);
+      point[0] += 2.0;
+      points->SetPoint(i, point);
+    }
+    points->Modified();
+    moved->GetVtkPolyData()->Modified();
+    moved->Modified();
+    contourList.back() = moved;
+  }
+
+  // Returns the portion of pixels for which the two distance images disagree about inside/outside
+  double GetPortionOfDifferentSigns(mitk::Image* reference, mitk::Image* result)
+  {
+    unsigned int numberOfPixels = 1;
+    for (unsigned int dim = 0; dim < 3; ++dim)
+    {
+      CPPUNIT_ASSERT_EQUAL(reference->GetDimension(dim), result->GetDimension(dim));
+      numberOfPixels *= result->GetDimension(dim);
+    }
+
+    mitk::ImageReadAccessor referenceAccessor(reference);
+    mitk::ImageReadAccessor resultAccessor(result);
+    const double* referenceData = static_cast<const double*>(referenceAccessor.GetData());
+    const double* resultData = static_cast<const double*>(resultAccessor.GetData());
+
+    unsigned int numberOfDifferentSigns = 0;
+    for (unsigned int i = 0; i < numberOfPixels; ++i)
+    {
+      if ( (referenceData[i] < 0) != (resultData[i] < 0) )
+        ++numberOfDifferentSigns;
+    }
+    return static_cast<double>(numberOfDifferentSigns) / numberOfPixels;
+  }
+
+  // The compact support solver uses a different RBF, so the distance values differ from the reference.
+  // However, the sign of the distance (inside/outside) must agree for nearly all pixels.
+  void TestCompactSupportSolverForLiver()
+  {
+    mitk::CreateDistanceImageFromSurfaceFilter::Pointer m_InterpolateSurfaceFilter = mitk::CreateDistanceImageFromSurfaceFilter::New();
+    m_InterpolateSurfaceFilter->SetSolverType(mitk::CreateDistanceImageFromSurfaceFilter::COMPACT_SUPPORT);
+
+    mitk::Image::Pointer liverDistanceImage = this->InterpolateLiver(m_InterpolateSurfaceFilter);
+    CPPUNIT_ASSERT(liverDistanceImage.IsNotNull());
+
+    mitk::Image::Pointer liverDistanceImageReference = mitk::IOUtil::LoadImage(GetTestDataFilePath("SurfaceInterpolation/Reference/LiverDistanceImage.nrrd"));
+
+    CPPUNIT_ASSERT_MESSAGE("Inside/outside classification differs for more than 5% of the pixels!",
+                           this->GetPortionOfDifferentSigns(liverDistanceImageReference, liverDistanceImage) < 0.05);
+  }
+
+  // The far field approximation must not change the inside/outside classification noticeably
+  void TestFarFieldApproximationForLiver()
+  {
+    mitk::CreateDistanceImageFromSurfaceFilter::Pointer m_InterpolateSurfaceFilter = mitk::CreateDistanceImageFromSurfaceFilter::New();
+    m_InterpolateSurfaceFilter->SetFarFieldRatio(0.25);
+
+    mitk::Image::Pointer liverDistanceImage = this->InterpolateLiver(m_InterpolateSurfaceFilter);
+    CPPUNIT_ASSERT(liverDistanceImage.IsNotNull());
+
+    mitk::Image::Pointer liverDistanceImageReference = mitk::IOUtil::LoadImage(GetTestDataFilePath("SurfaceInterpolation/Reference/LiverDistanceImage.nrrd"));
+
+    CPPUNIT_ASSERT_MESSAGE("Inside/outside classification differs for more than 1% of the pixels!",
+                           this->GetPortionOfDifferentSigns(liverDistanceImageReference, liverDistanceImage) < 0.01);
+  }
+
+  // Updating again after a contour changed, with the weights of the previous update as initial guess, must deliver
+  // the result of an update from scratch. The centers of the moved contour have no previous weights.
+  void TestReuseWeightsForLiver()
+  {
+    mitk::CreateDistanceImageFromSurfaceFilter::Pointer m_InterpolateSurfaceFilter = mitk::CreateDistanceImageFromSurfaceFilter::New();
+    m_InterpolateSurfaceFilter->SetSolverType(mitk::CreateDistanceImageFromSurfaceFilter::COMPACT_SUPPORT);
+    m_InterpolateSurfaceFilter->ReuseWeightsOn();
+
+    mitk::Image::Pointer liverDistanceImage = this->InterpolateLiver(m_InterpolateSurfaceFilter);
+    CPPUNIT_ASSERT(liverDistanceImage.IsNotNull());
+
+    this->MoveLastContour();
+    this->SetLiverInputs(m_InterpolateSurfaceFilter);
+    m_InterpolateSurfaceFilter->Update();
+    mitk::Image::Pointer reusedDistanceImage = m_InterpolateSurfaceFilter->GetOutput()->Clone();
+
+    mitk::CreateDistanceImageFromSurfaceFilter::Pointer referenceFilter = mitk::CreateDistanceImageFromSurfaceFilter::New();
+    referenceFilter->SetSolverType(mitk::CreateDistanceImageFromSurfaceFilter::COMPACT_SUPPORT);
+    this->SetLiverInputs(referenceFilter);
+    referenceFilter->Update();
+
+    CPPUNIT_ASSERT_MESSAGE("Reusing the weights changed the distance image!",
+                           mitk::Equal(*(referenceFilter->GetOutput()), *(reusedDistanceImage), 0.0001, true));
+  }
+
+  // An update that has been aborted must not affect the next update
+  void TestUpdateAfterAbortForLiver()
+  {
+    mitk::CreateDistanceImageFromSurfaceFilter::Pointer m_InterpolateSurfaceFilter = mitk::CreateDistanceImageFromSurfaceFilter::New();
+    m_InterpolateSurfaceFilter->SetSolverType(mitk::CreateDistanceImageFromSurfaceFilter::COMPACT_SUPPORT);
+
+    this->LoadLiverContours();
+    this->SetLiverInputs(m_InterpolateSurfaceFilter);
+
+    unsigned long observerTag = m_InterpolateSurfaceFilter->AddObserver(itk::ProgressEvent(), AbortFilterCommand::New());
+    CPPUNIT_ASSERT_THROW(m_InterpolateSurfaceFilter->Update(), itk::ProcessAborted);
+    m_InterpolateSurfaceFilter->RemoveObserver(observerTag);
+
+    m_InterpolateSurfaceFilter->Modified();
+    CPPUNIT_ASSERT_NO_THROW(m_InterpolateSurfaceFilter->Update());
+
+    mitk::CreateDistanceImageFromSurfaceFilter::Pointer referenceFilter = mitk::CreateDistanceImageFromSurfaceFilter::New();
+    referenceFilter->SetSolverType(mitk::CreateDistanceImageFromSurfaceFilter::COMPACT_SUPPORT);
+    this->SetLiverInputs(referenceFilter);
+    referenceFilter->Update();
+
+    CPPUNIT_ASSERT_MESSAGE("The aborted update changed the result of the next one!",
+                           mitk::Equal(*(referenceFilter->GetOutput()), *(m_InterpolateSurfaceFilter->GetOutput()), 0.0001, true));
+  }
+
+  // The narrow band is grown by all threads in arbitrary order, which must not change the result
+  void TestNumberOfThreadsForLiver()
+  {
+    mitk::CreateDistanceImageFromSurfaceFilter::Pointer singleThreadedFilter = mitk::CreateDistanceImageFromSurfaceFilter::New();
+    singleThreadedFilter->SetNumberOfThreads(1);
+
+    mitk::Image::Pointer singleThreadedDistanceImage = this->InterpolateLiver(singleThreadedFilter);
+    CPPUNIT_ASSERT(singleThreadedDistanceImage.IsNotNull());
+
+    contourList.clear();
+    mitk::CreateDistanceImageFromSurfaceFilter::Pointer multiThreadedFilter = mitk::CreateDistanceImageFromSurfaceFilter::New();
+    multiThreadedFilter->SetNumberOfThreads(8);
+
+    mitk::Image::Pointer multiThreadedDistanceImage = this->InterpolateLiver(multiThreadedFilter);
+    CPPUNIT_ASSERT(multiThreadedDistanceImage.IsNotNull());
+
+    CPPUNIT_ASSERT_MESSAGE("The distance image depends on the number of threads!",
+                           mitk::Equal(*(singleThreadedDistanceImage), *(multiThreadedDistanceImage), 0.0001, true));
+  }
+
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkCreateDistanceImageFromSurfaceFilter)
@@ -16,12 +16,28 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkCreateDistanceImageFromSurfaceFilter.h"
 
+namespace
+{
+  //Value of the pixels outside of the surface which are not within the narrow band
+  const double OutsideValue = 10;
+}
+
 mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImageFromSurfaceFilter()
 {
   m_DistanceImageVolume = 50000;
   this->m_UseProgressBar = false;
   this->m_ProgressStepSize = 5;
 
+  m_SolverType = DENSE_QR;
+  m_SupportRadius = 0.0;
+  m_CurrentSupportRadius = 0.0;
+  m_MaximumNumberOfIterations = 0;
+  m_SolverTolerance = 1e-6;
+  m_GridCellSize = 0.0;
+  m_GridDimensions[0] = m_GridDimensions[1] = m_GridDimensions[2] = 0;
+  m_FarFieldRatio = 0.0;
+  m_ReuseWeights = false;
+
   mitk::Image::Pointer output = mitk::Image::New();
   this->SetNthOutput(0, output.GetPointer());
 }
@@ -33,12 +49,28 @@ mitk::CreateDistanceImageFromSurfaceFilter::~CreateDistanceImageFromSurfaceFilte
 
 void mitk::CreateDistanceImageFromSurfaceFilter::GenerateData()
 {
+  //An aborted update leaves its equation system behind, it must not be extended
+  this->ClearEquationSystem();
+
   //First of all we have to build the equation-system from the existing contour-edge-points
   this->CreateSolutionMatrixAndFunctionValues();
 
-  //Then we solve the equation-system via QR - decomposition. The interpolation weights are obtained in that way
-  vnl_qr<double> solver (m_SolutionMatrix);
-  m_Weights = solver.solve(m_FunctionValues);
+  //Then we solve the equation-system. The interpolation weights are obtained in that way
+  if (m_SolverType == COMPACT_SUPPORT)
+  {
+    this->SolveSparseEquationSystem();
+  }
+  else
+  {
+    vnl_qr<double> solver (m_SolutionMatrix);
+    m_Weights = solver.solve(m_FunctionValues);
+
+    if (m_FarFieldRatio > 0)
+    {
+      this->BuildCenterGrid(0.0);
+      this->CalculateCellMoments();
+    }
+  }
 
   //Setting progressbar
   if (this->m_UseProgressBar)
@@ -46,15 +78,28 @@ void mitk::CreateDistanceImageFromSurfaceFilter::GenerateData()
 
   //The last step is to create the distance map with the interpolated distance function
   this->CreateDistanceImage();
+  this->ClearEquationSystem();
+
+  //Setting progressbar
+  if (this->m_UseProgressBar)
+    mitk::ProgressBar::GetInstance()->Progress(3);
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::ClearEquationSystem()
+{
   m_Centers.clear();
   m_FunctionValues.clear();
   m_Normals.clear();
   m_Weights.clear();
   m_SolutionMatrix.clear();
-
-  //Setting progressbar
-  if (this->m_UseProgressBar)
-    mitk::ProgressBar::GetInstance()->Progress(3);
+  m_SparseSolutionMatrix = SparseSolutionMatrix();
+  m_CenterGrid.clear();
+  m_GridCellSize = 0.0;
+  m_GridDimensions[0] = m_GridDimensions[1] = m_GridDimensions[2] = 0;
+  m_CellCentroids.clear();
+  m_CellWeightedOffsets.clear();
+  m_CellWeightSums.clear();
+  m_CellRadii.clear();
 }
 
 void mitk::CreateDistanceImageFromSurfaceFilter::CreateSolutionMatrixAndFunctionValues()
@@ -166,6 +211,12 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateSolutionMatrixAndFunction
   }
 
   //Now we have created all centers and all function values. Next step is to create the solution matrix
+  if (m_SolverType == COMPACT_SUPPORT)
+  {
+    this->CreateSparseSolutionMatrix();
+    return;
+  }
+
   numberOfCenters = m_Centers.size();
   m_SolutionMatrix.set_size(numberOfCenters, numberOfCenters);
 
@@ -191,6 +242,365 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateSolutionMatrixAndFunction
 
 }
 
+double mitk::CreateDistanceImageFromSurfaceFilter::GetDefaultSupportRadius(double boundingBoxDiagonal)
+{
+  double radius = 0.25 * boundingBoxDiagonal;
+  return radius > 0 ? radius : 1.0;
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::CreateSparseSolutionMatrix()
+{
+  unsigned int numberOfCenters = m_Centers.size();
+
+  m_CurrentSupportRadius = m_SupportRadius;
+  if (m_CurrentSupportRadius <= 0)
+  {
+    //No radius given, so we take a quarter of the diagonal of the bounding box of all centers
+    PointType minPoint = m_Centers.at(0);
+    PointType maxPoint = m_Centers.at(0);
+    for (unsigned int i = 1; i < numberOfCenters; i++)
+    {
+      for (unsigned int dim = 0; dim < 3; dim++)
+      {
+        minPoint[dim] = std::min(minPoint[dim], m_Centers.at(i)[dim]);
+        maxPoint[dim] = std::max(maxPoint[dim], m_Centers.at(i)[dim]);
+      }
+    }
+    m_CurrentSupportRadius = GetDefaultSupportRadius((maxPoint - minPoint).two_norm());
+  }
+
+  this->BuildCenterGrid(m_CurrentSupportRadius);
+
+  m_SparseSolutionMatrix = SparseSolutionMatrix(numberOfCenters, numberOfCenters);
+  m_Weights.set_size(numberOfCenters);
+
+  //Only centers within the support radius contribute to a row, so each row is set at once
+  std::vector<unsigned int> neighbors;
+  std::vector<int> columns;
+  std::vector<double> values;
+  double norm;
+
+  for (unsigned int i = 0; i < numberOfCenters; i++)
+  {
+    this->GetCentersInNeighborhood(m_Centers.at(i), neighbors);
+
+    columns.clear();
+    values.clear();
+
+    for (std::vector<unsigned int>::const_iterator it = neighbors.begin(); it != neighbors.end(); ++it)
+    {
+      norm = (m_Centers.at(i) - m_Centers.at(*it)).two_norm();
+      if (norm < m_CurrentSupportRadius)
+      {
+        columns.push_back(*it);
+        values.push_back(this->EvaluateCompactRBF(norm));
+      }
+    }
+    m_SparseSolutionMatrix.set_row(i, columns, values);
+  }
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::SolveSparseEquationSystem()
+{
+  /*
+  * The matrix of the Wendland RBF is symmetric and positive definite, hence we use the conjugate
+  * gradient method. Its diagonal is Phi(0) = 1, so a Jacobi preconditioner would not change anything.
+  */
+  unsigned int numberOfCenters = m_Centers.size();
+
+  m_Weights.set_size(numberOfCenters);
+  m_Weights.fill(0);
+
+  FunctionValues residual = m_FunctionValues;
+  FunctionValues matrixTimesDirection (numberOfCenters);
+
+  if (m_ReuseWeights && !m_PreviousWeights.empty())
+  {
+    //Start from the previous solution. Only the residual of the changed centers is large then.
+    for (unsigned int i = 0; i < numberOfCenters; i++)
+    {
+      WeightMap::const_iterator previous = m_PreviousWeights.find(m_Centers[i]);
+      if (previous != m_PreviousWeights.end())
+        m_Weights[i] = previous->second;
+    }
+    m_SparseSolutionMatrix.mult(m_Weights, matrixTimesDirection);
+    residual -= matrixTimesDirection;
+  }
+
+  FunctionValues direction = residual;
+
+  double residualNorm = dot_product(residual, residual);
+  double threshold = m_SolverTolerance * m_SolverTolerance * m_FunctionValues.squared_magnitude();
+
+  unsigned int maxIterations = m_MaximumNumberOfIterations > 0 ? m_MaximumNumberOfIterations : numberOfCenters;
+  unsigned int iteration = 0;
+
+  for ( ; iteration < maxIterations && residualNorm > threshold; iteration++)
+  {
+    this->UpdateProgress( static_cast<float>(iteration) / maxIterations );
+    if (this->GetAbortGenerateData())
+      throw itk::ProcessAborted(__FILE__, __LINE__);
+
+    m_SparseSolutionMatrix.mult(direction, matrixTimesDirection);
+
+    double alpha = residualNorm / dot_product(direction, matrixTimesDirection);
+    m_Weights += alpha * direction;
+    residual -= alpha * matrixTimesDirection;
+
+    double newResidualNorm = dot_product(residual, residual);
+    direction = residual + (newResidualNorm / residualNorm) * direction;
+    residualNorm = newResidualNorm;
+  }
+
+  if (residualNorm > threshold)
+  {
+    MITK_WARN << "mitk::CreateDistanceImageFromSurfaceFilter: Conjugate gradient solver did not converge after "
+              << iteration << " iterations. Residual: " << sqrt(residualNorm);
+  }
+
+  if (m_ReuseWeights)
+  {
+    m_PreviousWeights.clear();
+    for (unsigned int i = 0; i < numberOfCenters; i++)
+    {
+      m_PreviousWeights[m_Centers[i]] = m_Weights[i];
+    }
+  }
+}
+
+double mitk::CreateDistanceImageFromSurfaceFilter::EvaluateCompactRBF(double r) const
+{
+  if (r >= m_CurrentSupportRadius)
+    return 0.0;
+
+  double q = r / m_CurrentSupportRadius;
+  double oneMinusQ = 1.0 - q;
+  return oneMinusQ * oneMinusQ * oneMinusQ * oneMinusQ * (4.0 * q + 1.0);
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::BuildCenterGrid(double cellSize)
+{
+  PointType minPoint = m_Centers.at(0);
+  PointType maxPoint = m_Centers.at(0);
+  for (CenterList::const_iterator it = m_Centers.begin(); it != m_Centers.end(); ++it)
+  {
+    for (unsigned int dim = 0; dim < 3; dim++)
+    {
+      minPoint[dim] = std::min(minPoint[dim], (*it)[dim]);
+      maxPoint[dim] = std::max(maxPoint[dim], (*it)[dim]);
+    }
+  }
+
+  //If no size is given we take a tenth of the diagonal of the bounding box
+  if (cellSize <= 0)
+    cellSize = 0.1 * (maxPoint - minPoint).two_norm();
+  if (cellSize <= 0)
+    cellSize = 1.0;
+
+  //The cells must not be smaller than the given size. If the size is tiny compared to the extent
+  //of the contours the cells are enlarged, so that the number of (mostly empty) cells stays bounded.
+  double maxNumberOfCells = 8.0 * m_Centers.size() + 1.0;
+  m_GridCellSize = cellSize;
+  double numberOfCells;
+  do
+  {
+    numberOfCells = 1.0;
+    for (unsigned int dim = 0; dim < 3; dim++)
+    {
+      m_GridDimensions[dim] = static_cast<int>( (maxPoint[dim] - minPoint[dim]) / m_GridCellSize ) + 1;
+      numberOfCells *= m_GridDimensions[dim];
+    }
+    if (numberOfCells > maxNumberOfCells)
+      m_GridCellSize *= 2.0;
+  }
+  while (numberOfCells > maxNumberOfCells);
+
+  m_GridOrigin = minPoint;
+  m_CenterGrid.assign(static_cast<size_t>(numberOfCells), std::vector<unsigned int>());
+
+  for (unsigned int i = 0; i < m_Centers.size(); i++)
+  {
+    int cellIndex[3];
+    for (unsigned int dim = 0; dim < 3; dim++)
+    {
+      cellIndex[dim] = std::min( static_cast<int>( (m_Centers.at(i)[dim] - m_GridOrigin[dim]) / m_GridCellSize ),
+                                 m_GridDimensions[dim] - 1 );
+    }
+    m_CenterGrid.at(cellIndex[0] + m_GridDimensions[0] * (cellIndex[1] + m_GridDimensions[1] * cellIndex[2])).push_back(i);
+  }
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::GetCentersInNeighborhood(const PointType& p, std::vector<unsigned int>& centerIds) const
+{
+  centerIds.clear();
+
+  int cellIndex[3];
+  for (unsigned int dim = 0; dim < 3; dim++)
+  {
+    cellIndex[dim] = static_cast<int>( floor( (p[dim] - m_GridOrigin[dim]) / m_GridCellSize ) );
+  }
+
+  for (int z = cellIndex[2] - 1; z <= cellIndex[2] + 1; z++)
+  {
+    if (z < 0 || z >= m_GridDimensions[2])
+      continue;
+    for (int y = cellIndex[1] - 1; y <= cellIndex[1] + 1; y++)
+    {
+      if (y < 0 || y >= m_GridDimensions[1])
+        continue;
+      for (int x = cellIndex[0] - 1; x <= cellIndex[0] + 1; x++)
+      {
+        if (x < 0 || x >= m_GridDimensions[0])
+          continue;
+        const std::vector<unsigned int>& cell = m_CenterGrid[x + m_GridDimensions[0] * (y + m_GridDimensions[1] * z)];
+        centerIds.insert(centerIds.end(), cell.begin(), cell.end());
+      }
+    }
+  }
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::CalculateCellMoments()
+{
+  unsigned int numberOfCells = m_CenterGrid.size();
+
+  m_CellCentroids.assign(numberOfCells, PointType(0.0));
+  m_CellWeightedOffsets.assign(numberOfCells, PointType(0.0));
+  m_CellWeightSums.assign(numberOfCells, 0.0);
+  m_CellRadii.assign(numberOfCells, 0.0);
+
+  for (unsigned int cell = 0; cell < numberOfCells; cell++)
+  {
+    const std::vector<unsigned int>& centerIds = m_CenterGrid[cell];
+    if (centerIds.empty())
+      continue;
+
+    PointType centroid (0.0);
+    for (std::vector<unsigned int>::const_iterator it = centerIds.begin(); it != centerIds.end(); ++it)
+    {
+      centroid += m_Centers[*it];
+    }
+    centroid /= static_cast<double>(centerIds.size());
+
+    PointType weightedOffset (0.0);
+    double weightSum (0);
+    double radius (0);
+    for (std::vector<unsigned int>::const_iterator it = centerIds.begin(); it != centerIds.end(); ++it)
+    {
+      PointType offset = m_Centers[*it] - centroid;
+      weightedOffset += m_Weights[*it] * offset;
+      weightSum += m_Weights[*it];
+      radius = std::max(radius, offset.two_norm());
+    }
+
+    m_CellCentroids[cell] = centroid;
+    m_CellWeightedOffsets[cell] = weightedOffset;
+    m_CellWeightSums[cell] = weightSum;
+    m_CellRadii[cell] = radius;
+  }
+}
+
+void mitk::CreateDistanceImageFromSurfaceFilter::GrowNarrowBand(DistanceImageType* distanceImage, std::vector<bool>& visited,
+                                                                 const std::vector<IndexType>& seeds)
+{
+  NarrowBandStruct str;
+  str.Filter = this;
+  str.Image = distanceImage;
+  str.Visited = &visited;
+  str.Queue.assign(seeds.begin(), seeds.end());
+  str.NumberOfBusyThreads = 0;
+  str.Aborted = false;
+  str.QueueChanged = itk::ConditionVariable::New();
+
+  this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
+  this->GetMultiThreader()->SetSingleMethod(this->GrowNarrowBandCallback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  if (str.Aborted)
+    throw itk::ProcessAborted(__FILE__, __LINE__);
+}
+
+ITK_THREAD_RETURN_TYPE mitk::CreateDistanceImageFromSurfaceFilter::GrowNarrowBandCallback(void* arg)
+{
+  itk::ThreadIdType threadCount = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+
+  NarrowBandStruct* str = (NarrowBandStruct *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  CreateDistanceImageFromSurfaceFilter* filter = str->Filter;
+  DistanceImageType* distanceImage = str->Image;
+  DistanceImageType::RegionType region = distanceImage->GetLargestPossibleRegion();
+
+  DistanceImageType::OffsetType neighborOffsets[6];
+  for (unsigned int i = 0; i < 6; i++)
+  {
+    neighborOffsets[i].Fill(0);
+    neighborOffsets[i][i/2] = (i%2 == 0) ? -1 : 1;
+  }
+
+  std::vector<IndexType> batch;
+  std::vector<double> distances;
+  DistanceImageType::PointType pointInWorldCoordinates;
+  PointType point;
+
+  str->Mutex.Lock();
+  for (;;)
+  {
+    //Wait until there is work or all threads ran out of it
+    while (str->Queue.empty() && str->NumberOfBusyThreads > 0 && !str->Aborted)
+      str->QueueChanged->Wait(&str->Mutex);
+
+    if (str->Queue.empty() || str->Aborted)
+      break;
+
+    //Take a share of the queue, so that all threads get work while the band is small,
+    //but not too much, so that the lock is not taken for every single pixel
+    size_t batchSize = std::min<size_t>( std::max<size_t>(str->Queue.size() / threadCount, 1), 256 );
+    batch.assign(str->Queue.begin(), str->Queue.begin() + batchSize);
+    str->Queue.erase(str->Queue.begin(), str->Queue.begin() + batchSize);
+    ++str->NumberOfBusyThreads;
+    str->Mutex.Unlock();
+
+    distances.resize(batch.size());
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+      distanceImage->TransformIndexToPhysicalPoint(batch[i], pointInWorldCoordinates);
+      point[0] = pointInWorldCoordinates[0];
+      point[1] = pointInWorldCoordinates[1];
+      point[2] = pointInWorldCoordinates[2];
+      distances[i] = filter->CalculateDistanceValue(point);
+    }
+
+    str->Mutex.Lock();
+    --str->NumberOfBusyThreads;
+    if (filter->GetAbortGenerateData())
+      str->Aborted = true;
+
+    //Pixels within the band are kept and their not yet visited neighbors are queued
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+      if ( abs(distances[i]) > filter->m_DistanceImageSpacing )
+        continue;
+
+      distanceImage->SetPixel(batch[i], distances[i]);
+      for (unsigned int n = 0; n < 6; n++)
+      {
+        IndexType neighbor = batch[i] + neighborOffsets[n];
+        if ( !region.IsInside(neighbor) )
+          continue;
+
+        DistanceImageType::OffsetValueType offset = distanceImage->ComputeOffset(neighbor);
+        if ( (*str->Visited)[offset] )
+          continue;
+        (*str->Visited)[offset] = true;
+        str->Queue.push_back(neighbor);
+      }
+    }
+    str->QueueChanged->Broadcast();
+  }
+  str->QueueChanged->Broadcast();
+  str->Mutex.Unlock();
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 void mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImage()
 {
   DistanceImageType::Pointer distanceImg = DistanceImageType::New();
@@ -265,8 +675,8 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImage()
   distanceImg->SetSpacing( m_DistanceImageSpacing );
   distanceImg->Allocate();
 
-  //First of all the image is initialized with the value 10 for each pixel
-  distanceImg->FillBuffer(10);
+  //First of all the image is initialized with the outside value for each pixel
+  distanceImg->FillBuffer(OutsideValue);
 
   // Now we move the origin of the distanceImage 2 index-Coordinates
   // in all directions
@@ -282,13 +692,16 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImage()
   * Now we must calculate the distance for each pixel. But instead of calculating the distance value
   * for all of the image's pixels we proceed similar to the region growing algorithm:
   *
-  * 1. Take the first pixel from the narrowband_point_list and calculate the distance for each neighbor (6er)
-  * 2. If the current index's distance value is below a certain threshold push it into the list
-  * 3. Next iteration take the next index from the list and originAsIndex with 1. again
+  * Starting at the first center, the not yet visited neighbors (6er) of all pixels whose distance value
+  * is below a certain threshold are evaluated. The threads of the filter take the pixels from a shared
+  * queue and put the neighbors of the pixels within the band back into it, until the queue is empty.
+  * As the distance of a pixel does not depend on the order in which the pixels are visited, each pixel
+  * needs to be calculated only once and the result does not depend on the number of threads.
   *
-  * This is done until the narrowband_point_list is empty.
+  * The pixels outside of the band are not evaluated at all. They are set to +/-OutsideValue below, since only the
+  * zero level set within the band is used to extract the surface. Hence no coarse-to-fine evaluation
+  * of the remaining image is done.
   */
-  std::queue<DistanceImageType::IndexType> narrowbandPoints;
   PointType currentPoint = m_Centers.at(0);
   double distance = this->CalculateDistanceValue(currentPoint);
 
@@ -304,50 +717,26 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImage()
 
   assert( lpRegion.IsInside(currentIndex) ); // we are quite certain this should hold
 
-  narrowbandPoints.push(currentIndex);
   distanceImg->SetPixel(currentIndex, distance);
 
-  NeighborhoodImageIterator::RadiusType radius;
-  radius.Fill(1);
-  NeighborhoodImageIterator nIt(radius, distanceImg, distanceImg->GetLargestPossibleRegion());
-  unsigned int relativeNbIdx[] = {4, 10, 12, 14, 16, 22};
+  std::vector<bool> visited (lpRegion.GetNumberOfPixels(), false);
+  visited[distanceImg->ComputeOffset(currentIndex)] = true;
 
-  bool isInBounds = false;
-  while ( !narrowbandPoints.empty() )
+  // the neighbors of the first center are evaluated regardless of its distance
+  std::vector<DistanceImageType::IndexType> seeds;
+  for (unsigned int i = 0; i < 6; i++)
   {
+    DistanceImageType::IndexType neighbor = currentIndex;
+    neighbor[i/2] += (i%2 == 0) ? -1 : 1;
+    if ( !lpRegion.IsInside(neighbor) )
+      continue;
 
-    nIt.SetLocation(narrowbandPoints.front());
-    narrowbandPoints.pop();
-
-    unsigned int* relativeNb = &relativeNbIdx[0];
-    for (int i = 0; i < 6; i++)
-    {
-      nIt.GetPixel(*relativeNb, isInBounds);
-      if( isInBounds && nIt.GetPixel(*relativeNb) == 10)
-      {
-        currentIndex = nIt.GetIndex(*relativeNb);
-
-        // Transform the currently checked point from index-coordinates to
-        // world-coordinates
-        distanceImg->TransformIndexToPhysicalPoint( currentIndex, currentPointAsPoint );
-
-        // create a vnl_vector
-        currentPoint[0] = currentPointAsPoint[0];
-        currentPoint[1] = currentPointAsPoint[1];
-        currentPoint[2] = currentPointAsPoint[2];
-
-        // and check the distance
-        distance = this->CalculateDistanceValue(currentPoint);
-        if ( abs(distance) <= m_DistanceImageSpacing )
-        {
-          nIt.SetPixel(*relativeNb, distance);
-          narrowbandPoints.push(currentIndex);
-        }
-      }
-      relativeNb++;
-    }
+    visited[distanceImg->ComputeOffset(neighbor)] = true;
+    seeds.push_back(neighbor);
   }
 
+  this->GrowNarrowBand(distanceImg, visited, seeds);
+
 
   ImageIterator imgRegionIterator (distanceImg, distanceImg->GetLargestPossibleRegion());
   imgRegionIterator.GoToBegin();
@@ -361,27 +750,27 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImage()
   MITK_INFO<<"Size: ["<<_size[0]<<","<<_size[1]<<","<<_size[2]<<"] Center: ["<<center[0]<<","<<center[1]<<","<<center[2]<<"]";
 
 
-  //Set every pixel inside the surface to -10 except the edge point (so that the received surface is closed)
+  //Set every pixel inside the surface to -OutsideValue except the edge point (so that the received surface is closed)
   while (!imgRegionIterator.IsAtEnd()) {
 
-    if ( imgRegionIterator.Get() == 10 && prevPixelVal < 0 )
+    if ( imgRegionIterator.Get() == OutsideValue && prevPixelVal < 0 )
     {
 
-      while (imgRegionIterator.Get() == 10)
+      while (imgRegionIterator.Get() == OutsideValue)
       {
         if (imgRegionIterator.GetIndex()[0] == _size[0] || imgRegionIterator.GetIndex()[1] == _size[1] || imgRegionIterator.GetIndex()[2] == _size[2]
             || imgRegionIterator.GetIndex()[0] == 0U || imgRegionIterator.GetIndex()[1] == 0U || imgRegionIterator.GetIndex()[2] == 0U )
         {
-          imgRegionIterator.Set(10);
-          prevPixelVal = 10;
+          imgRegionIterator.Set(OutsideValue);
+          prevPixelVal = OutsideValue;
           ++imgRegionIterator;
           break;
         }
         else
         {
-          imgRegionIterator.Set(-10);
+          imgRegionIterator.Set(-OutsideValue);
           ++imgRegionIterator;
-          prevPixelVal = -10;
+          prevPixelVal = -OutsideValue;
         }
 
       }
@@ -391,8 +780,8 @@ void mitk::CreateDistanceImageFromSurfaceFilter::CreateDistanceImage()
              || imgRegionIterator.GetIndex()[0] == 0U || imgRegionIterator.GetIndex()[1] == 0U || imgRegionIterator.GetIndex()[2] == 0U)
 
     {
-      imgRegionIterator.Set(10);
-      prevPixelVal = 10;
+      imgRegionIterator.Set(OutsideValue);
+      prevPixelVal = OutsideValue;
       ++imgRegionIterator;
     }
     else
@@ -423,15 +812,21 @@ void mitk::CreateDistanceImageFromSurfaceFilter::FillImageRegion(DistanceImageTy
 }
 
 
-double mitk::CreateDistanceImageFromSurfaceFilter::CalculateDistanceValue(PointType p)
+double mitk::CreateDistanceImageFromSurfaceFilter::CalculateDistanceValue(const PointType& p) const
 {
+  if (m_SolverType == COMPACT_SUPPORT)
+    return this->CalculateCompactDistanceValue(p);
+
+  if (m_FarFieldRatio > 0)
+    return this->CalculateApproximatedDistanceValue(p);
+
   double distanceValue (0);
   PointType p1;
   PointType p2;
   double norm;
 
-  CenterList::iterator centerIter;
-  InterpolationWeights::iterator weightsIter;
+  CenterList::const_iterator centerIter;
+  InterpolationWeights::const_iterator weightsIter;
 
   for ( centerIter=m_Centers.begin(), weightsIter=m_Weights.begin();
     centerIter!=m_Centers.end() && weightsIter!=m_Weights.end();
@@ -445,6 +840,68 @@ double mitk::CreateDistanceImageFromSurfaceFilter::CalculateDistanceValue(PointT
   return distanceValue;
 }
 
+double mitk::CreateDistanceImageFromSurfaceFilter::CalculateApproximatedDistanceValue(const PointType& p) const
+{
+  /*
+  * For a cell whose centers c_i lie far away from p, |p - c_i| is expanded around the cell's centroid c:
+  * |p - c_i| ~ |p - c| - u * (c_i - c) with u = (p - c) / |p - c|
+  * Hence the contribution of the cell is sum(w_i) * |p - c| - u * sum(w_i * (c_i - c)).
+  * The error of this approximation decreases with the ratio of the cell's radius and |p - c|.
+  */
+  double distanceValue (0);
+  double norm;
+
+  for (unsigned int cell = 0; cell < m_CenterGrid.size(); cell++)
+  {
+    const std::vector<unsigned int>& centerIds = m_CenterGrid[cell];
+    if (centerIds.empty())
+      continue;
+
+    PointType direction = p - m_CellCentroids[cell];
+    norm = direction.two_norm();
+
+    if (m_CellRadii[cell] < m_FarFieldRatio * norm)
+    {
+      distanceValue += m_CellWeightSums[cell] * norm - dot_product(direction, m_CellWeightedOffsets[cell]) / norm;
+    }
+    else
+    {
+      for (std::vector<unsigned int>::const_iterator it = centerIds.begin(); it != centerIds.end(); ++it)
+      {
+        distanceValue += m_Weights[*it] * (p - m_Centers[*it]).two_norm();
+      }
+    }
+  }
+  return distanceValue;
+}
+
+double mitk::CreateDistanceImageFromSurfaceFilter::CalculateCompactDistanceValue(const PointType& p) const
+{
+  std::vector<unsigned int> neighbors;
+  this->GetCentersInNeighborhood(p, neighbors);
+
+  double distanceValue (0);
+  double minNorm = m_CurrentSupportRadius;
+  double norm;
+
+  for (std::vector<unsigned int>::const_iterator it = neighbors.begin(); it != neighbors.end(); ++it)
+  {
+    norm = (p - m_Centers[*it]).two_norm();
+    if (norm < m_CurrentSupportRadius)
+    {
+      distanceValue += m_Weights[*it] * this->EvaluateCompactRBF(norm);
+      minNorm = std::min(minNorm, norm);
+    }
+  }
+
+  //Far away from all centers the compactly supported interpolant decays to zero and would be taken for
+  //the surface. Hence such points are reported as lying outside, like the initial value of the distance image.
+  if (minNorm > 0.5 * m_CurrentSupportRadius)
+    return OutsideValue;
+
+  return distanceValue;
+}
+
 void mitk::CreateDistanceImageFromSurfaceFilter::GenerateOutputInformation()
 {
 }
@@ -534,6 +991,9 @@ void mitk::CreateDistanceImageFromSurfaceFilter::Reset()
   this->SetNumberOfIndexedInputs(0);
   this->SetNumberOfIndexedOutputs(1);
 
+  m_PreviousWeights.clear();
+  this->ClearEquationSystem();
+
   mitk::Image::Pointer output = mitk::Image::New();
   this->SetNthOutput(0, output.GetPointer());
 }
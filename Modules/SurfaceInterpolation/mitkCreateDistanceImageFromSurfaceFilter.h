@@ -32,13 +32,17 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vnl/vnl_matrix.h"
 #include "vnl/vnl_vector.h"
 #include "vnl/vnl_vector_fixed.h"
+#include "vnl/vnl_sparse_matrix.h"
 #include "vnl/algo/vnl_qr.h"
 
 #include "itkImageBase.h"
 #include "itkImageRegionIteratorWithIndex.h"
 #include "itkNeighborhoodIterator.h"
+#include "itkSimpleMutexLock.h"
+#include "itkConditionVariable.h"
 
-#include <queue>
+#include <map>
+#include <deque>
 
 namespace mitk {
 
@@ -66,6 +70,24 @@ namespace mitk {
          Note that the obtained distance image has always an isotropig spacing. The size (in this case volume) of the image can be
          adjusted by calling SetDistanceImageVolume(unsigned int volume) which specifies the number ob pixels enclosed by the image.
 
+         Two solver types are available (see SetSolverType()):
+         \li DENSE_QR Uses the global RBF Phi(r) = r and solves the dense equation system via QR decomposition.
+             This needs O(N^2) memory and O(N^3) time for N centers.
+         \li COMPACT_SUPPORT Uses the compactly supported Wendland RBF Phi(r) = (1-r/s)^4 * (4r/s+1) with the
+             support radius s. The resulting equation system is sparse and positive definite and is solved
+             iteratively with the conjugate gradient method. Memory and time scale roughly linearly with the number
+             of centers as long as the support radius is small compared to the extent of the contours.
+
+         The distance image is only evaluated within a narrow band around the surface. The band is grown starting at
+         the first center by multiple threads, which share one queue of pixels to be evaluated. The pixels outside of
+         the band are not evaluated but set to +/-10.
+         For the DENSE_QR solver the evaluation can additionally be accelerated by SetFarFieldRatio().
+
+         If the filter is updated repeatedly with slightly changed contours (e.g. during interactive segmentation)
+         the COMPACT_SUPPORT solver can start from the weights of the previous update (see SetReuseWeights()).
+         Only the equation rows of new or moved centers then need a considerable number of iterations.
+         A running update can be cancelled via SetAbortGenerateData(true), which throws an itk::ProcessAborted.
+
   \ingroup Process
 
   $Author: fetzer$
@@ -89,8 +111,15 @@ namespace mitk {
     typedef vnl_vector<double> FunctionValues;
     typedef vnl_vector<double> InterpolationWeights;
 
+    typedef vnl_sparse_matrix<double> SparseSolutionMatrix;
+
     typedef std::vector<Surface::Pointer> SurfaceList;
 
+    enum Solver_Type
+    {
+      DENSE_QR, COMPACT_SUPPORT
+    };
+
 
     mitkClassMacro(CreateDistanceImageFromSurfaceFilter,ImageSource);
     itkFactorylessNewMacro(Self)
@@ -117,9 +146,55 @@ namespace mitk {
     */
     itkSetMacro(DistanceImageVolume, unsigned int);
 
+    /**
+    \brief Set the solver which is used to calculate the interpolation weights. Default is DENSE_QR.
+    */
+    itkSetMacro(SolverType, Solver_Type);
+    itkGetMacro(SolverType, Solver_Type);
+
+    /**
+    \brief Set the support radius (in mm) of the compactly supported RBF used by the COMPACT_SUPPORT solver.
+           The radius has to be larger than half of the distance between two neighboring contours.
+           If the radius is not positive it is set to a quarter of the diagonal of the contours' bounding box.
+    */
+    itkSetMacro(SupportRadius, double);
+    itkGetMacro(SupportRadius, double);
+
+    /**
+    \brief The support radius used if SupportRadius is not positive: a quarter of the given diagonal, or 1 mm if the diagonal is zero.
+    */
+    static double GetDefaultSupportRadius(double boundingBoxDiagonal);
+
+    /**
+    \brief Set the maximum number of conjugate gradient iterations of the COMPACT_SUPPORT solver.
+           If zero the number of centers is used.
+    */
+    itkSetMacro(MaximumNumberOfIterations, unsigned int);
+
+    /**
+    \brief Set the relative residual at which the COMPACT_SUPPORT solver stops iterating
+    */
+    itkSetMacro(SolverTolerance, double);
+
+    /**
+    \brief Set whether the COMPACT_SUPPORT solver starts from the weights of the previous update.
+           Centers which did not exist in the previous update start with a weight of zero.
+    */
+    itkSetMacro(ReuseWeights, bool);
+    itkGetMacro(ReuseWeights, bool);
+    itkBooleanMacro(ReuseWeights);
+
+    /**
+    \brief Set the ratio between the radius of a grid cell of centers and its distance to an evaluated point
+           below which the contribution of the cell is approximated by a first order expansion around the
+           cell's centroid. Only used by the DENSE_QR solver. The default 0 evaluates the interpolant exactly.
+    */
+    itkSetMacro(FarFieldRatio, double);
+    itkGetMacro(FarFieldRatio, double);
+
     void PrintEquationSystem();
 
-    //Resets the filter, i.e. removes all inputs and outputs
+    //Resets the filter, i.e. removes all inputs and outputs and discards the weights of the previous update
     void Reset();
 
     /**
@@ -148,8 +223,63 @@ namespace mitk {
 
   private:
 
+    /**
+    * \brief Discards centers, normals, function values, weights, matrices and the center grid. Called before and
+    * after each update, so that an update that has been aborted in between does not affect the next one.
+    */
+    void ClearEquationSystem();
+
     void CreateSolutionMatrixAndFunctionValues();
-    double CalculateDistanceValue(PointType p);
+    void CreateSparseSolutionMatrix();
+    void SolveSparseEquationSystem();
+    double CalculateDistanceValue(const PointType& p) const;
+    double CalculateCompactDistanceValue(const PointType& p) const;
+    double CalculateApproximatedDistanceValue(const PointType& p) const;
+
+    /**
+    * \brief Calculates the distance values of the narrow band around the surface, starting with the given
+    * pixels. All threads of the filter's multi threader take pixels from one shared queue until the band
+    * is complete. Throws an itk::ProcessAborted if the filter has been aborted meanwhile.
+    */
+    void GrowNarrowBand(DistanceImageType* distanceImage, std::vector<bool>& visited, const std::vector<IndexType>& seeds);
+
+    struct NarrowBandStruct
+    {
+      CreateDistanceImageFromSurfaceFilter* Filter;
+      DistanceImageType* Image;
+      std::vector<bool>* Visited;
+      std::deque<IndexType> Queue;
+      unsigned int NumberOfBusyThreads;
+      bool Aborted;
+      itk::SimpleMutexLock Mutex;
+      itk::ConditionVariable::Pointer QueueChanged;
+    };
+
+    static ITK_THREAD_RETURN_TYPE GrowNarrowBandCallback(void* arg);
+
+    /**
+    * \brief Evaluates the Wendland RBF for the distance r and the support radius of the filter
+    */
+    double EvaluateCompactRBF(double r) const;
+
+    /**
+    * \brief Sorts all centers into a regular grid whose cells are at least as large as the given size.
+    * For the COMPACT_SUPPORT solver the size is the support radius, thus all centers within the support
+    * radius of a point are contained in the 27 cells around it.
+    */
+    void BuildCenterGrid(double cellSize);
+
+    /**
+    * \brief Calculates centroid, radius, sum of weights and weighted offsets of each grid cell, which are
+    * needed to approximate the contribution of distant cells
+    */
+    void CalculateCellMoments();
+
+    /**
+    * \brief Fills the given list with the indices of all centers that lie in the grid cell of the given point
+    * or in one of its 26 neighbors.
+    */
+    void GetCentersInNeighborhood(const PointType& p, std::vector<unsigned int>& centerIds) const;
 
     void CreateDistanceImage ();
 
@@ -181,8 +311,48 @@ namespace mitk {
     FunctionValues m_FunctionValues;
     InterpolationWeights m_Weights;
     SolutionMatrix m_SolutionMatrix;
+    SparseSolutionMatrix m_SparseSolutionMatrix;
     double m_DistanceImageSpacing;
 
+    Solver_Type m_SolverType;
+    double m_SupportRadius;
+    double m_CurrentSupportRadius;
+    unsigned int m_MaximumNumberOfIterations;
+    double m_SolverTolerance;
+
+    //Regular grid of the centers used by the compact support solver
+    PointType m_GridOrigin;
+    double m_GridCellSize;
+    int m_GridDimensions[3];
+    std::vector< std::vector<unsigned int> > m_CenterGrid;
+
+    //Ratio of cell radius and distance below which a cell is approximated by its moments, 0 disables it
+    double m_FarFieldRatio;
+
+    //Weights of the previous update used as initial guess by the compact support solver
+    struct PointTypeLess
+    {
+      bool operator()(const PointType& a, const PointType& b) const
+      {
+        for (unsigned int dim = 0; dim < 3; dim++)
+        {
+          if (a[dim] != b[dim])
+            return a[dim] < b[dim];
+        }
+        return false;
+      }
+    };
+    typedef std::map<PointType, double, PointTypeLess> WeightMap;
+
+    bool m_ReuseWeights;
+    WeightMap m_PreviousWeights;
+
+    //Moments of the grid cells used for the far field approximation
+    std::vector<PointType> m_CellCentroids;
+    std::vector<PointType> m_CellWeightedOffsets;
+    std::vector<double> m_CellWeightSums;
+    std::vector<double> m_CellRadii;
+
     itk::ImageBase<3>::Pointer m_ReferenceImage;
 
     unsigned int m_DistanceImageVolume;
@@ -21,6 +21,8 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkImageToSurfaceFilter.h"
 
+#include <vtkBoundingBox.h>
+
 mitk::SurfaceInterpolationController::SurfaceInterpolationController()
   :m_SelectedSegmentation(0)
 {
@@ -76,66 +78,78 @@ mitk::SurfaceInterpolationController* mitk::SurfaceInterpolationController::GetI
 
 void mitk::SurfaceInterpolationController::AddNewContour (mitk::Surface::Pointer newContour ,RestorePlanePositionOperation* op)
 {
-  AffineTransform3D::Pointer transform = AffineTransform3D::New();
-  transform = op->GetTransform();
+  //A running interpolation is outdated now, wait until it has returned before changing the filters' inputs
+  this->AbortInterpolation();
+  {
+    itk::MutexLockHolder<itk::SimpleMutexLock> lock(m_InterpolationMutex);
 
-  mitk::Vector3D direction = op->GetDirectionVector();
-  int pos (-1);
+    AffineTransform3D::Pointer transform = AffineTransform3D::New();
+    transform = op->GetTransform();
 
-  for (unsigned int i = 0; i < m_MapOfContourLists[m_SelectedSegmentation].size(); i++)
-  {
-      itk::Matrix<ScalarType> diffM = transform->GetMatrix()-m_MapOfContourLists[m_SelectedSegmentation].at(i).position->GetTransform()->GetMatrix();
-      bool isSameMatrix(true);
-      for (unsigned int j = 0; j < 3; j++)
-      {
-        if (fabs(diffM[j][0]) > 0.0001 && fabs(diffM[j][1]) > 0.0001 && fabs(diffM[j][2]) > 0.0001)
+    mitk::Vector3D direction = op->GetDirectionVector();
+    int pos (-1);
+
+    for (unsigned int i = 0; i < m_MapOfContourLists[m_SelectedSegmentation].size(); i++)
+    {
+        itk::Matrix<ScalarType> diffM = transform->GetMatrix()-m_MapOfContourLists[m_SelectedSegmentation].at(i).position->GetTransform()->GetMatrix();
+        bool isSameMatrix(true);
+        for (unsigned int j = 0; j < 3; j++)
+        {
+          if (fabs(diffM[j][0]) > 0.0001 && fabs(diffM[j][1]) > 0.0001 && fabs(diffM[j][2]) > 0.0001)
+          {
+            isSameMatrix = false;
+            break;
+          }
+        }
+        itk::Vector<ScalarType> diffV = m_MapOfContourLists[m_SelectedSegmentation].at(i).position->GetTransform()->GetOffset()-transform->GetOffset();
+        if ( isSameMatrix && m_MapOfContourLists[m_SelectedSegmentation].at(i).position->GetPos() == op->GetPos() && (fabs(diffV[0]) < 0.0001 && fabs(diffV[1]) < 0.0001 && fabs(diffV[2]) < 0.0001) )
         {
-          isSameMatrix = false;
+          pos = i;
           break;
         }
-      }
-      itk::Vector<ScalarType> diffV = m_MapOfContourLists[m_SelectedSegmentation].at(i).position->GetTransform()->GetOffset()-transform->GetOffset();
-      if ( isSameMatrix && m_MapOfContourLists[m_SelectedSegmentation].at(i).position->GetPos() == op->GetPos() && (fabs(diffV[0]) < 0.0001 && fabs(diffV[1]) < 0.0001 && fabs(diffV[2]) < 0.0001) )
-      {
-        pos = i;
-        break;
-      }
 
-  }
+    }
 
-  //Don't save a new empty contour
-  if (pos == -1 && newContour->GetVtkPolyData()->GetNumberOfPoints() > 0)
-  {
-    mitk::RestorePlanePositionOperation* newOp = new mitk::RestorePlanePositionOperation (OpRESTOREPLANEPOSITION, op->GetWidth(),
-      op->GetHeight(), op->GetSpacing(), op->GetPos(), direction, transform);
-    ContourPositionPair newData;
-    newData.contour = newContour;
-    newData.position = newOp;
-
-    m_ReduceFilter->SetInput(m_MapOfContourLists[m_SelectedSegmentation].size(), newContour);
-    m_MapOfContourLists[m_SelectedSegmentation].push_back(newData);
-  }
-  //Edit a existing contour. If the contour is empty, edit it anyway so that the interpolation will always be consistent
-  else if (pos != -1)
-  {
-    m_MapOfContourLists[m_SelectedSegmentation].at(pos).contour = newContour;
-    m_ReduceFilter->SetInput(pos, newContour);
-  }
+    //Don't save a new empty contour
+    if (pos == -1 && newContour->GetVtkPolyData()->GetNumberOfPoints() > 0)
+    {
+      mitk::RestorePlanePositionOperation* newOp = new mitk::RestorePlanePositionOperation (OpRESTOREPLANEPOSITION, op->GetWidth(),
+        op->GetHeight(), op->GetSpacing(), op->GetPos(), direction, transform);
+      ContourPositionPair newData;
+      newData.contour = newContour;
+      newData.position = newOp;
+
+      m_ReduceFilter->SetInput(m_MapOfContourLists[m_SelectedSegmentation].size(), newContour);
+      m_MapOfContourLists[m_SelectedSegmentation].push_back(newData);
+    }
+    //Edit a existing contour. If the contour is empty, edit it anyway so that the interpolation will always be consistent
+    else if (pos != -1)
+    {
+      m_MapOfContourLists[m_SelectedSegmentation].at(pos).contour = newContour;
+      m_ReduceFilter->SetInput(pos, newContour);
+    }
 
-  m_ReduceFilter->Update();
-  m_CurrentNumberOfReducedContours = m_ReduceFilter->GetNumberOfOutputs();
+    m_ReduceFilter->Update();
+    m_CurrentNumberOfReducedContours = m_ReduceFilter->GetNumberOfOutputs();
 
-  for (unsigned int i = 0; i < m_CurrentNumberOfReducedContours; i++)
-  {
-    m_NormalsFilter->SetInput(i, m_ReduceFilter->GetOutput(i));
-    m_InterpolateSurfaceFilter->SetInput(i, m_NormalsFilter->GetOutput(i));
+    for (unsigned int i = 0; i < m_CurrentNumberOfReducedContours; i++)
+    {
+      m_NormalsFilter->SetInput(i, m_ReduceFilter->GetOutput(i));
+      m_InterpolateSurfaceFilter->SetInput(i, m_NormalsFilter->GetOutput(i));
+    }
   }
 
+  //Not within the lock, since observers may start a new interpolation and wait for the previous one
   this->Modified();
 }
 
 void mitk::SurfaceInterpolationController::Interpolate()
 {
+  itk::MutexLockHolder<itk::SimpleMutexLock> lock(m_InterpolationMutex);
+
+  //Aborts requested before this point referred to contours which have been replaced meanwhile
+  m_InterpolationAborted.Set(0);
+
   if (m_CurrentNumberOfReducedContours< 2)
   {
     //If no interpolation is possible reset the interpolation result
@@ -149,8 +163,23 @@ void mitk::SurfaceInterpolationController::Interpolate()
     */
   //mitk::ProgressBar::GetInstance()->AddStepsToDo(8);
 
-  // update the filter and get teh resulting distance-image
-  m_InterpolateSurfaceFilter->Update();
+  // update the filters and get the resulting distance-image. ITK resets the abort flag of each filter
+  // when it starts, so an abort during the update of an upstream filter is checked here.
+  try
+  {
+    m_NormalsFilter->Update();
+    if (this->IsInterpolationAborted())
+      return;
+
+    m_InterpolateSurfaceFilter->Update();
+    if (this->IsInterpolationAborted())
+      return;
+  }
+  catch (itk::ProcessAborted&)
+  {
+    //The contours have changed meanwhile, a new interpolation will follow
+    return;
+  }
   Image::Pointer distanceImage = m_InterpolateSurfaceFilter->GetOutput();
 
   // create a surface from the distance-image
@@ -180,6 +209,33 @@ void mitk::SurfaceInterpolationController::Interpolate()
   m_InterpolationResult->DisconnectPipeline();
 }
 
+void mitk::SurfaceInterpolationController::AbortInterpolation()
+{
+  m_InterpolationAborted.Set(1);
+  m_InterpolateSurfaceFilter->SetAbortGenerateData(true);
+}
+
+bool mitk::SurfaceInterpolationController::IsInterpolationAborted() const
+{
+  return m_InterpolationAborted.Get() != 0;
+}
+
+void mitk::SurfaceInterpolationController::SetUseIncrementalInterpolation(bool incremental)
+{
+  this->AbortInterpolation();
+  {
+    itk::MutexLockHolder<itk::SimpleMutexLock> lock(m_InterpolationMutex);
+
+    if (incremental)
+      m_InterpolateSurfaceFilter->SetSolverType(CreateDistanceImageFromSurfaceFilter::COMPACT_SUPPORT);
+    else
+      m_InterpolateSurfaceFilter->SetSolverType(CreateDistanceImageFromSurfaceFilter::DENSE_QR);
+
+    m_InterpolateSurfaceFilter->SetReuseWeights(incremental);
+  }
+  this->Modified();
+}
+
 mitk::Surface::Pointer mitk::SurfaceInterpolationController::GetInterpolationResult()
 {
     return m_InterpolationResult;
@@ -224,7 +280,35 @@ mitk::Image* mitk::SurfaceInterpolationController::GetImage()
 double mitk::SurfaceInterpolationController::EstimatePortionOfNeededMemory()
 {
   double numberOfPointsAfterReduction = m_ReduceFilter->GetNumberOfPointsAfterReduction()*3;
+
   double sizeOfPoints = pow(numberOfPointsAfterReduction,2)*sizeof(double);
+
+  if (m_InterpolateSurfaceFilter->GetSolverType() == CreateDistanceImageFromSurfaceFilter::COMPACT_SUPPORT)
+  {
+    vtkBoundingBox bounds;
+    for (unsigned int i = 0; i < m_ReduceFilter->GetNumberOfOutputs(); i++)
+    {
+      bounds.AddBounds(m_ReduceFilter->GetOutput(i)->GetVtkPolyData()->GetBounds());
+    }
+
+    double supportRadius = m_InterpolateSurfaceFilter->GetSupportRadius();
+    if (supportRadius <= 0)
+      supportRadius = CreateDistanceImageFromSurfaceFilter::GetDefaultSupportRadius(bounds.GetDiagonalLength());
+
+    //Portion of the bounding box covered by the cube around the support sphere of a center,
+    //i.e. an upper bound of the portion of centers within the support radius
+    double portionOfNeighbors = 1.0;
+    for (unsigned int dim = 0; dim < 3; dim++)
+    {
+      double extent = bounds.GetLength(dim);
+      if (extent > 2*supportRadius)
+        portionOfNeighbors *= 2*supportRadius / extent;
+    }
+
+    //The sparse matrix stores an index and a value per entry
+    sizeOfPoints = pow(numberOfPointsAfterReduction,2)*portionOfNeighbors*sizeof(std::pair<unsigned int, double>);
+  }
+
   double totalMem = mitk::MemoryUtilities::GetTotalSizeOfPhysicalRam();
   double percentage = sizeOfPoints/totalMem;
   return percentage;
@@ -241,51 +325,56 @@ void mitk::SurfaceInterpolationController::SetCurrentSegmentationInterpolationLi
   if (segmentation == m_SelectedSegmentation)
     return;
 
-  m_ReduceFilter->Reset();
-  m_NormalsFilter->Reset();
-  m_InterpolateSurfaceFilter->Reset();
-
-  if (segmentation == 0)
+  this->AbortInterpolation();
   {
-    m_SelectedSegmentation = 0;
-    return;
-  }
-  ContourListMap::iterator it = m_MapOfContourLists.find(segmentation);
+    itk::MutexLockHolder<itk::SimpleMutexLock> lock(m_InterpolationMutex);
 
-  m_SelectedSegmentation = segmentation;
+    m_ReduceFilter->Reset();
+    m_NormalsFilter->Reset();
+    m_InterpolateSurfaceFilter->Reset();
 
+    if (segmentation == 0)
+    {
+      m_SelectedSegmentation = 0;
+      return;
+    }
+    ContourListMap::iterator it = m_MapOfContourLists.find(segmentation);
 
-  itk::ImageBase<3>::Pointer itkImage = itk::ImageBase<3>::New();
-  AccessFixedDimensionByItk_1( m_SelectedSegmentation, GetImageBase, 3, itkImage );
-  m_InterpolateSurfaceFilter->SetReferenceImage( itkImage.GetPointer() );
+    m_SelectedSegmentation = segmentation;
 
-  if (it == m_MapOfContourLists.end())
-  {
-    ContourPositionPairList newList;
-    m_MapOfContourLists.insert(std::pair<mitk::Image*, ContourPositionPairList>(segmentation, newList));
-    m_InterpolationResult = 0;
-    m_CurrentNumberOfReducedContours = 0;
 
-    itk::MemberCommand<SurfaceInterpolationController>::Pointer command = itk::MemberCommand<SurfaceInterpolationController>::New();
-    command->SetCallbackFunction(this, &SurfaceInterpolationController::OnSegmentationDeleted);
-    m_SegmentationObserverTags.insert( std::pair<mitk::Image*, unsigned long>( segmentation, segmentation->AddObserver( itk::DeleteEvent(), command ) ) );
+    itk::ImageBase<3>::Pointer itkImage = itk::ImageBase<3>::New();
+    AccessFixedDimensionByItk_1( m_SelectedSegmentation, GetImageBase, 3, itkImage );
+    m_InterpolateSurfaceFilter->SetReferenceImage( itkImage.GetPointer() );
 
-  }
-  else
-  {
-    for (unsigned int i = 0; i < m_MapOfContourLists[m_SelectedSegmentation].size(); i++)
+    if (it == m_MapOfContourLists.end())
     {
-      m_ReduceFilter->SetInput(i, m_MapOfContourLists[m_SelectedSegmentation].at(i).contour);
+      ContourPositionPairList newList;
+      m_MapOfContourLists.insert(std::pair<mitk::Image*, ContourPositionPairList>(segmentation, newList));
+      m_InterpolationResult = 0;
+      m_CurrentNumberOfReducedContours = 0;
+
+      itk::MemberCommand<SurfaceInterpolationController>::Pointer command = itk::MemberCommand<SurfaceInterpolationController>::New();
+      command->SetCallbackFunction(this, &SurfaceInterpolationController::OnSegmentationDeleted);
+      m_SegmentationObserverTags.insert( std::pair<mitk::Image*, unsigned long>( segmentation, segmentation->AddObserver( itk::DeleteEvent(), command ) ) );
+
     }
+    else
+    {
+      for (unsigned int i = 0; i < m_MapOfContourLists[m_SelectedSegmentation].size(); i++)
+      {
+        m_ReduceFilter->SetInput(i, m_MapOfContourLists[m_SelectedSegmentation].at(i).contour);
+      }
 
-    m_ReduceFilter->Update();
+      m_ReduceFilter->Update();
 
-    m_CurrentNumberOfReducedContours = m_ReduceFilter->GetNumberOfOutputs();
+      m_CurrentNumberOfReducedContours = m_ReduceFilter->GetNumberOfOutputs();
 
-    for (unsigned int i = 0; i < m_CurrentNumberOfReducedContours; i++)
-    {
-      m_NormalsFilter->SetInput(i, m_ReduceFilter->GetOutput(i));
-      m_InterpolateSurfaceFilter->SetInput(i, m_NormalsFilter->GetOutput(i));
+      for (unsigned int i = 0; i < m_CurrentNumberOfReducedContours; i++)
+      {
+        m_NormalsFilter->SetInput(i, m_ReduceFilter->GetOutput(i));
+        m_InterpolateSurfaceFilter->SetInput(i, m_NormalsFilter->GetOutput(i));
+      }
     }
   }
   Modified();
@@ -298,6 +387,9 @@ void mitk::SurfaceInterpolationController::RemoveSegmentationFromContourList(mit
     m_MapOfContourLists.erase(segmentation);
     if (m_SelectedSegmentation == segmentation)
     {
+      this->AbortInterpolation();
+      itk::MutexLockHolder<itk::SimpleMutexLock> lock(m_InterpolationMutex);
+
       SetSegmentationImage(NULL);
       m_SelectedSegmentation = 0;
     }
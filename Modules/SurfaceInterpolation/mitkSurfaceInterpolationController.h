@@ -46,6 +46,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "vtkProperty.h"
 
 #include "mitkProgressBar.h"
+#include "mitkAtomicInteger.h"
+
+#include <itkSimpleMutexLock.h>
+#include <itkMutexLockHolder.h>
 
 namespace mitk
 {
@@ -62,15 +66,32 @@ namespace mitk
     static SurfaceInterpolationController* GetInstance();
 
     /**
-     * Adds a new extracted contour to the list
+     * Adds a new extracted contour to the list. A running interpolation is aborted and this method
+     * waits until it has returned before the contour is passed to the filters.
      */
     void AddNewContour(Surface::Pointer newContour, RestorePlanePositionOperation *op);
 
     /**
-     * Interpolates the 3D surface from the given extracted contours
+     * Interpolates the 3D surface from the given extracted contours.
+     * If the interpolation is aborted (see AbortInterpolation()) the previous result is kept.
      */
     void Interpolate ();
 
+    /**
+     * Cancels a running interpolation, e.g. because its contours are outdated. This method may be called
+     * from a thread other than the one running Interpolate(). Adding a contour or changing the segmentation
+     * aborts a running interpolation automatically. The abort is remembered by the controller until the
+     * interpolation has returned, so it also takes effect while upstream filters are updated.
+     */
+    void AbortInterpolation();
+
+    /**
+     * Enables the incremental interpolation. The distance image is then calculated with the compact support
+     * solver, which starts from the weights of the previous interpolation. Hence adding or editing a single
+     * contour only needs a few solver iterations. A running interpolation is aborted.
+     */
+    void SetUseIncrementalInterpolation(bool incremental);
+
     mitk::Surface::Pointer GetInterpolationResult();
 
     /**
@@ -117,6 +138,8 @@ namespace mitk
 
     /**
      * Estimates the memory which is needed to build up the equationsystem for the interpolation.
+     * For the incremental interpolation only the entries of centers within the support radius of each other
+     * are counted, assuming the centers are evenly distributed in the bounding box of the contours.
      * \returns The percentage of the real memory which will be used by the interpolation
      */
     double EstimatePortionOfNeededMemory();
@@ -133,6 +156,12 @@ namespace mitk
 
    void OnSegmentationDeleted(const itk::Object *caller, const itk::EventObject &event);
 
+   /**
+    * Returns whether the running interpolation was aborted. Checked between the stages of the pipeline,
+    * since ITK resets the abort flag of a filter when the filter starts.
+    */
+   bool IsInterpolationAborted() const;
+
    struct ContourPositionPair {
      Surface::Pointer contour;
      RestorePlanePositionOperation* position;
@@ -162,6 +191,11 @@ namespace mitk
     mitk::Image* m_SelectedSegmentation;
 
     std::map<mitk::Image*, unsigned long> m_SegmentationObserverTags;
+
+    //Held by Interpolate() while the filters are updated and by all methods changing the filters' inputs
+    itk::SimpleMutexLock m_InterpolationMutex;
+    //Non-zero if the running interpolation has been aborted
+    AtomicInteger m_InterpolationAborted;
  };
 }
 #endif
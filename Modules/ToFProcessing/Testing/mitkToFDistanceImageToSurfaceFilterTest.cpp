@@ -19,6 +19,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <mitkImage.h>
 #include <mitkImagePixelReadAccessor.h>
+#include <mitkImagePixelWriteAccessor.h>
 #include <mitkImageGenerator.h>
 #include <mitkSurface.h>
 #include <mitkToFProcessingCommon.h>
@@ -28,6 +29,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include <vtkPoints.h>
 #include <vtkPolyData.h>
+#include <vtkCellArray.h>
 #include <vtkSmartPointer.h>
 
 /**
@@ -381,6 +383,52 @@ int mitkToFDistanceImageToSurfaceFilterTest(int /* argc */, char* /*argv*/[])
   }
   MITK_TEST_CONDITION_REQUIRED(compareToInput,"Testing backward transformation compared to original image with interpixeldistance");
 
+  // test a second frame with changed intrinsics, the filter has to recompute its ray table
+  MITK_INFO<<"Test filter with changed intrinsics and invalid pixels";
+  principalPoint[0] += 10.0;
+  principalPoint[1] -= 10.0;
+  cameraIntrinsics->SetPrincipalPoint(principalPoint[0],principalPoint[1]);
+  filter->SetReconstructionMode(mitk::ToFDistanceImageToSurfaceFilter::Kinect);
+  filter->SetGenerateTriangularMesh(true);
+  filter->SetTriangulationThreshold(0.0);
+  mitk::Image::Pointer secondImage = mitk::ImageGenerator::GenerateRandomImage<float>(dimX,dimY,1,1,1,1,1,1000.0,1.0);
+  {
+    // the first row is invalid, it gets neither points nor triangles
+    mitk::ImagePixelWriteAccessor<float,2> writeAccess(secondImage, secondImage->GetSliceData());
+    for (unsigned int i=0; i<dimX; i++)
+    {
+      itk::Index<2> index = {{ i, 0 }};
+      writeAccess.SetPixelByIndex(index, 0.0);
+    }
+  }
+  filter->SetInput(secondImage);
+  filter->Update();
+  vtkPolyData* mesh = filter->GetOutput()->GetVtkPolyData();
+  MITK_TEST_CONDITION_REQUIRED(mesh->GetNumberOfPoints() == dimX*(dimY-1),"Test if invalid pixels are left out");
+  MITK_TEST_CONDITION_REQUIRED(mesh->GetPolys()->GetNumberOfCells() == 2*(dimX-1)*(dimY-2),"Test if all valid pixels are triangulated");
+
+  pointSetsEqual = true;
+  mitk::ImagePixelReadAccessor<float,2> secondReadAccess(secondImage, secondImage->GetSliceData());
+  for (unsigned int j=1; j<dimY; j++)
+  {
+    for (unsigned int i=0; i<dimX; i++)
+    {
+      itk::Index<2> index = {{ i, j }};
+      ToFPoint3D expectedPoint = mitk::ToFProcessingCommon::KinectIndexToCartesianCoordinates(i,j,secondReadAccess.GetPixelByIndex(index),focalLengthXY,principalPoint);
+      vtkIdType pointID = filter->GetVertexIdList()->GetId(i+j*dimX);
+      double* res = mesh->GetPoint(pointID);
+      ToFPoint3D resultPoint;
+      resultPoint[0] = res[0];
+      resultPoint[1] = res[1];
+      resultPoint[2] = res[2];
+      if (pointID != (vtkIdType)(i+(j-1)*dimX) || !mitk::Equal(expectedPoint,resultPoint))
+      {
+        pointSetsEqual = false;
+      }
+    }
+  }
+  MITK_TEST_CONDITION_REQUIRED(pointSetsEqual,"Testing filter with changed intrinsics and invalid pixels");
+
   //clean up
   delete point;
   //  expectedResult->Delete();
@@ -30,12 +30,17 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkIdList.h>
 
 #include <math.h>
+#include <algorithm>
 #include <vtkMath.h>
 
 mitk::ToFDistanceImageToSurfaceFilter::ToFDistanceImageToSurfaceFilter() :
   m_IplScalarImage(NULL), m_CameraIntrinsics(), m_TextureImageWidth(0), m_TextureImageHeight(0), m_InterPixelDistance(), m_TextureIndex(0),
-  m_GenerateTriangularMesh(true), m_TriangulationThreshold(0.0)
+  m_GenerateTriangularMesh(true), m_TriangulationThreshold(0.0),
+  m_Points(vtkSmartPointer<vtkPoints>::New()), m_Polys(vtkSmartPointer<vtkCellArray>::New()), m_Vertices(vtkSmartPointer<vtkCellArray>::New()),
+  m_ScalarArray(vtkSmartPointer<vtkFloatArray>::New()), m_TextureCoords(vtkSmartPointer<vtkFloatArray>::New())
 {
+  m_Points->SetDataTypeToDouble();
+  m_TextureCoords->SetNumberOfComponents(2);
   m_InterPixelDistance.Fill(0.045);
   m_CameraIntrinsics = mitk::CameraIntrinsics::New();
   m_CameraIntrinsics->SetFocalLength(273.138946533,273.485900879);
@@ -99,28 +104,21 @@ void mitk::ToFDistanceImageToSurfaceFilter::GenerateData()
   int xDimension = input->GetDimension(0);
   int yDimension = input->GetDimension(1);
   unsigned int size = xDimension*yDimension; //size of the image-array
-  std::vector<bool> isPointValid;
-  isPointValid.resize(size);
-  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
-  points->SetDataTypeToDouble();
-  vtkSmartPointer<vtkCellArray> polys = vtkSmartPointer<vtkCellArray>::New();
-  vtkSmartPointer<vtkCellArray> vertices = vtkSmartPointer<vtkCellArray>::New();
-  vtkSmartPointer<vtkFloatArray> scalarArray = vtkSmartPointer<vtkFloatArray>::New();
-  vtkSmartPointer<vtkFloatArray> textureCoords = vtkSmartPointer<vtkFloatArray>::New();
-  textureCoords->SetNumberOfComponents(2);
-  textureCoords->Allocate(size);
+
+  if (!this->UpdateRayTable(input))
+  {
+    MITK_ERROR << "Incorrect reconstruction mode!";
+    return;
+  }
 
   //Make a vtkIdList to save the ID's of the polyData corresponding to the image
   //pixel ID's. See below for more documentation.
-  m_VertexIdList = vtkSmartPointer<vtkIdList>::New();
-  //Allocate the object once else it would automatically allocate new memory
-  //for every vertex and perform a copy which is expensive.
-  m_VertexIdList->Allocate(size);
-  m_VertexIdList->SetNumberOfIds(size);
-  for(unsigned int i = 0; i < size; ++i)
+  if (m_VertexIdList == NULL)
   {
-    m_VertexIdList->SetId(i, 0);
+    m_VertexIdList = vtkSmartPointer<vtkIdList>::New();
   }
+  //The list keeps its memory if the size did not grow, every id is written below.
+  m_VertexIdList->SetNumberOfIds(size);
 
   float* scalarFloatData = NULL;
 
@@ -136,6 +134,119 @@ void mitk::ToFDistanceImageToSurfaceFilter::GenerateData()
 
   ImageReadAccessor inputAcc(input, input->GetSliceData(0,0,0));
   float* inputFloatData = (float*)inputAcc.GetData();
+
+  m_PointGrid.resize(3*size);
+  m_PointValid.resize(size);
+  m_CellTypes.resize(size);
+  m_RowPointOffsets.resize(yDimension);
+  m_RowTriangleOffsets.resize(yDimension);
+  m_RowVertexOffsets.resize(yDimension);
+
+  ConversionStruct str;
+  str.Filter = this;
+  str.Distances = inputFloatData;
+  str.Scalars = scalarFloatData;
+  str.XDimension = xDimension;
+  str.YDimension = yDimension;
+
+  this->GetMultiThreader()->SetNumberOfThreads(this->GetNumberOfThreads());
+  this->GetMultiThreader()->SetSingleMethod(this->ThreadedConversionCallback, &str);
+
+  //calculate world coordinates and count the valid points of each row
+  str.Phase = ConvertPoints;
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  //VTK would insert empty points into the polydata if we used the pixel ID's
+  //as point ID's. Thus, the valid points are stored consecutively and each row
+  //starts at the number of valid points in the rows above.
+  vtkIdType numberOfPoints = 0;
+  for (int j=0; j<yDimension; j++)
+  {
+    vtkIdType rowPoints = m_RowPointOffsets[j];
+    m_RowPointOffsets[j] = numberOfPoints;
+    numberOfPoints += rowPoints;
+  }
+
+  m_Points->SetNumberOfPoints(numberOfPoints);
+  m_TextureCoords->SetNumberOfTuples(numberOfPoints);
+  m_ScalarArray->SetNumberOfTuples(scalarFloatData ? numberOfPoints : 0);
+
+  //copy the valid points into the output and decide which cells each pixel gets
+  str.Phase = CompactPoints;
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  vtkIdType numberOfTriangles = 0;
+  vtkIdType numberOfVertices = 0;
+  for (int j=0; j<yDimension; j++)
+  {
+    vtkIdType rowTriangles = m_RowTriangleOffsets[j];
+    vtkIdType rowVertices = m_RowVertexOffsets[j];
+    m_RowTriangleOffsets[j] = numberOfTriangles;
+    m_RowVertexOffsets[j] = numberOfVertices;
+    numberOfTriangles += rowTriangles;
+    numberOfVertices += rowVertices;
+  }
+
+  //the cell arrays keep their memory if the number of cells did not grow,
+  //Reset() makes sure no cells of a larger previous frame remain
+  m_Polys->Reset();
+  m_Vertices->Reset();
+  m_Polys->WritePointer(numberOfTriangles, 4*numberOfTriangles);
+  m_Vertices->WritePointer(numberOfVertices, 2*numberOfVertices);
+
+  str.Phase = WriteCells;
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  m_Points->Modified();
+  m_Polys->Modified();
+  m_Vertices->Modified();
+  m_ScalarArray->Modified();
+  m_TextureCoords->Modified();
+  m_VertexIdList->Modified();
+
+  //A new polydata makes the output recompute its bounding box, the
+  //buffers are shared with the polydata of the previous frame.
+  vtkSmartPointer<vtkPolyData> mesh = vtkSmartPointer<vtkPolyData>::New();
+  mesh->SetPoints(m_Points);
+  mesh->SetPolys(m_Polys);
+  mesh->SetVerts(m_Vertices);
+  //Pass the scalars to the polydata (if they were set).
+  if (m_ScalarArray->GetNumberOfTuples()>0)
+  {
+    mesh->GetPointData()->SetScalars(m_ScalarArray);
+  }
+  //Pass the TextureCoords to the polydata anyway (to save them).
+  mesh->GetPointData()->SetTCoords(m_TextureCoords);
+  output->SetVtkPolyData(mesh);
+}
+
+bool mitk::ToFDistanceImageToSurfaceFilter::UpdateRayTable(mitk::Image* input)
+{
+  int xDimension = input->GetDimension(0);
+  int yDimension = input->GetDimension(1);
+  mitk::Point3D origin = input->GetGeometry()->GetOrigin();
+  mitk::Vector3D spacing = input->GetGeometry()->GetSpacing();
+
+  std::vector<double> parameters;
+  parameters.push_back(m_ReconstructionMode);
+  parameters.push_back(xDimension);
+  parameters.push_back(yDimension);
+  parameters.push_back(origin[0]);
+  parameters.push_back(origin[1]);
+  parameters.push_back(spacing[0]);
+  parameters.push_back(spacing[1]);
+  parameters.push_back(m_CameraIntrinsics->GetFocalLengthX());
+  parameters.push_back(m_CameraIntrinsics->GetFocalLengthY());
+  parameters.push_back(m_CameraIntrinsics->GetPrincipalPointX());
+  parameters.push_back(m_CameraIntrinsics->GetPrincipalPointY());
+  parameters.push_back(m_InterPixelDistance[0]);
+  parameters.push_back(m_InterPixelDistance[1]);
+
+  if (parameters == m_RayTableParameters)
+  {
+    return true;
+  }
+
   //calculate world coordinates
   mitk::ToFProcessingCommon::ToFPoint2D focalLengthInPixelUnits;
   mitk::ToFProcessingCommon::ToFScalarType focalLengthInMm;
@@ -143,27 +254,33 @@ void mitk::ToFDistanceImageToSurfaceFilter::GenerateData()
   {
     focalLengthInPixelUnits[0] = m_CameraIntrinsics->GetFocalLengthX();
     focalLengthInPixelUnits[1] = m_CameraIntrinsics->GetFocalLengthY();
+    m_RayTableFocalLength = focalLengthInPixelUnits;
   }
   else if( m_ReconstructionMode == WithInterPixelDistance)
   {
     //convert focallength from pixel to mm
     focalLengthInMm = (m_CameraIntrinsics->GetFocalLengthX()*m_InterPixelDistance[0]+m_CameraIntrinsics->GetFocalLengthY()*m_InterPixelDistance[1])/2.0;
+    m_RayTableFocalLength.Fill(focalLengthInMm);
+  }
+  else
+  {
+    m_RayTableParameters.clear();
+    return false;
   }
 
   mitk::ToFProcessingCommon::ToFPoint2D principalPoint;
   principalPoint[0] = m_CameraIntrinsics->GetPrincipalPointX();
   principalPoint[1] = m_CameraIntrinsics->GetPrincipalPointY();
 
-  mitk::Point3D origin = input->GetGeometry()->GetOrigin();
-  mitk::Vector3D spacing = input->GetGeometry()->GetSpacing();
-
+  //The entries are computed exactly like in ToFProcessingCommon, so that
+  //distance*numerator/denominator yields the same coordinates as the
+  //IndexToCartesianCoordinates methods.
+  m_RayTable.resize(3*xDimension*yDimension);
   for (int j=0; j<yDimension; j++)
   {
     for (int i=0; i<xDimension; i++)
     {
-      unsigned int pixelID = i+j*xDimension;
-
-      mitk::ToFProcessingCommon::ToFScalarType distance = (double)inputFloatData[pixelID];
+      double* ray = &m_RayTable[3*(i+j*xDimension)];
 
       /** Here we have to incorporate spacing and origin to allow processing of cropped/resampled images
       * Usually origin will be [0, 0, 0] and spacing will be [1, 1, 1], but just in case the image is moved
@@ -171,135 +288,226 @@ void mitk::ToFDistanceImageToSurfaceFilter::GenerateData()
       unsigned int completeIndexX = i*spacing[0]+origin[0];
       unsigned int completeIndexY = j*spacing[1]+origin[1];
 
-      mitk::ToFProcessingCommon::ToFPoint3D cartesianCoordinates;
       switch (m_ReconstructionMode)
       {
       case WithOutInterPixelDistance:
       {
-        cartesianCoordinates = mitk::ToFProcessingCommon::IndexToCartesianCoordinates(completeIndexX,completeIndexY,distance,focalLengthInPixelUnits,principalPoint);
+        mitk::ToFProcessingCommon::ToFScalarType imageX = completeIndexX - principalPoint[0];
+        mitk::ToFProcessingCommon::ToFScalarType imageY = completeIndexY - principalPoint[1];
+        mitk::ToFProcessingCommon::ToFScalarType imageY_in_pX = imageY * (focalLengthInPixelUnits[0] / focalLengthInPixelUnits[1]);
+        ray[0] = imageX;
+        ray[1] = imageY_in_pX;
+        ray[2] = sqrt(imageX*imageX + imageY_in_pX*imageY_in_pX + focalLengthInPixelUnits[0]*focalLengthInPixelUnits[0]);
         break;
       }
       case WithInterPixelDistance:
       {
-        cartesianCoordinates = mitk::ToFProcessingCommon::IndexToCartesianCoordinatesWithInterpixdist(completeIndexX,completeIndexY,distance,focalLengthInMm,m_InterPixelDistance,principalPoint);
+        mitk::ToFProcessingCommon::ToFScalarType imageX = (( completeIndexX - principalPoint[0] ) * m_InterPixelDistance[0]);
+        mitk::ToFProcessingCommon::ToFScalarType imageY = (( completeIndexY - principalPoint[1] ) * m_InterPixelDistance[1]);
+        ray[0] = imageX;
+        ray[1] = imageY;
+        ray[2] = sqrt(imageX*imageX + imageY*imageY + focalLengthInMm*focalLengthInMm);
         break;
       }
-      case Kinect:
+      default: // Kinect, the denominators are the focal lengths
       {
-        cartesianCoordinates = mitk::ToFProcessingCommon::KinectIndexToCartesianCoordinates(completeIndexX,completeIndexY,distance,focalLengthInPixelUnits,principalPoint);
-        break;
+        ray[0] = completeIndexX - principalPoint[0];
+        ray[1] = completeIndexY - principalPoint[1];
+        ray[2] = 1.0;
+      }
       }
-      default:
+    }
+  }
+
+  m_RayTableParameters = parameters;
+  return true;
+}
+
+ITK_THREAD_RETURN_TYPE mitk::ToFDistanceImageToSurfaceFilter::ThreadedConversionCallback(void* arg)
+{
+  itk::ThreadIdType threadId = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->ThreadID;
+  itk::ThreadIdType threadCount = ((itk::MultiThreader::ThreadInfoStruct *)(arg))->NumberOfThreads;
+
+  ConversionStruct* str = (ConversionStruct *)(((itk::MultiThreader::ThreadInfoStruct *)(arg))->UserData);
+  ToFDistanceImageToSurfaceFilter* filter = str->Filter;
+  int xDimension = str->XDimension;
+  int yDimension = str->YDimension;
+
+  //Each thread processes a contiguous block of rows and writes to its own part of the result
+  int chunkSize = (yDimension + threadCount - 1) / threadCount;
+  int begin = threadId * chunkSize;
+  int end = std::min(begin + chunkSize, yDimension);
+
+  for (int j=begin; j<end; j++)
+  {
+    unsigned int rowStart = j*xDimension;
+    const float* distances = str->Distances + rowStart;
+    const double* ray = &filter->m_RayTable[3*rowStart];
+    double* points = &filter->m_PointGrid[3*rowStart];
+    unsigned char* isPointValid = &filter->m_PointValid[rowStart];
+    unsigned char* cellTypes = &filter->m_CellTypes[rowStart];
+
+    switch (str->Phase)
+    {
+    case ConvertPoints:
+    {
+      //The loops have no branches and no calls, so the compiler can vectorize them.
+      if (filter->m_ReconstructionMode == Kinect)
       {
-        MITK_ERROR << "Incorrect reconstruction mode!";
+        double focalLengthX = filter->m_RayTableFocalLength[0];
+        double focalLengthY = filter->m_RayTableFocalLength[1];
+        for (int i=0; i<xDimension; i++)
+        {
+          double distance = distances[i];
+          points[3*i]   = distance * ray[3*i] / focalLengthX;
+          points[3*i+1] = distance * ray[3*i+1] / focalLengthY;
+          points[3*i+2] = distance;
+        }
       }
+      else
+      {
+        double focalLength = filter->m_RayTableFocalLength[0];
+        for (int i=0; i<xDimension; i++)
+        {
+          double distance = distances[i];
+          points[3*i]   = distance * ray[3*i] / ray[3*i+2];   //Strahlensatz: x / imageX = distance / d
+          points[3*i+1] = distance * ray[3*i+1] / ray[3*i+2]; //Strahlensatz: y / imageY = distance / d
+          points[3*i+2] = distance * focalLength / ray[3*i+2]; //Strahlensatz: z / f = distance / d
+        }
       }
+
       //Epsilon here, because we may have small float values like 0.00000001 which in fact represents 0.
-      if (distance<=mitk::eps)
+      vtkIdType numberOfValidPoints = 0;
+      for (int i=0; i<xDimension; i++)
       {
-        isPointValid[pixelID] = false;
+        isPointValid[i] = (double)distances[i] > mitk::eps;
+        numberOfValidPoints += isPointValid[i];
       }
-      else
+      filter->m_RowPointOffsets[j] = numberOfValidPoints;
+      break;
+    }
+    case CompactPoints:
+    {
+      double* outputPoints = static_cast<double*>(filter->m_Points->GetVoidPointer(0));
+      float* textureCoords = filter->m_TextureCoords->GetPointer(0);
+      float* scalars = str->Scalars ? filter->m_ScalarArray->GetPointer(0) : NULL;
+      vtkIdType* vertexIds = filter->m_VertexIdList->GetPointer(rowStart);
+      vtkIdType id = filter->m_RowPointOffsets[j];
+      vtkIdType numberOfTriangles = 0;
+      vtkIdType numberOfVertices = 0;
+
+      for (int i=0; i<xDimension; i++)
       {
-        isPointValid[pixelID] = true;
-        //VTK would insert empty points into the polydata if we use
-        //points->InsertPoint(pixelID, cartesianCoordinates.GetDataPointer()).
-        //If we use points->InsertNextPoint(...) instead, the ID's do not
-        //correspond to the image pixel ID's. Thus, we have to save them
-        //in the vertexIdList.
-        m_VertexIdList->SetId(pixelID, points->InsertNextPoint(cartesianCoordinates.GetDataPointer()));
-
-        if (m_GenerateTriangularMesh)
+        cellTypes[i] = NoCell;
+        if (!isPointValid[i])
+        {
+          vertexIds[i] = 0;
+          continue;
+        }
+
+        vertexIds[i] = id;
+        outputPoints[3*id]   = points[3*i];
+        outputPoints[3*id+1] = points[3*i+1];
+        outputPoints[3*id+2] = points[3*i+2];
+        //Scalar values are necessary for mapping colors/texture onto the surface
+        if (scalars)
         {
-          if((i >= 1) && (j >= 1))
+          scalars[id] = str->Scalars[rowStart+i];
+        }
+        //These Texture Coordinates will map color pixel and vertices 1:1 (e.g. for Kinect).
+        textureCoords[2*id]   = ((float)i)/xDimension; // correct video texture scale for kinect
+        textureCoords[2*id+1] = ((float)j)/yDimension; //don't flip. we don't need to flip.
+        ++id;
+
+        if (filter->m_GenerateTriangularMesh)
+        {
+          //We can only start triangulation if we are at vertex (1,1),
+          //because we need the other 3 vertices near this one.
+          //To go one pixel line back in the image array, we have to
+          //subtract 1x xDimension.
+          if ((i >= 1) && (j >= 1) && isPointValid[i-1] && isPointValid[i-xDimension] && isPointValid[i-1-xDimension])
           {
-            //This little piece of art explains the ID's:
-            //
-            // P(x_1y_1)---P(xy_1)
-            // |           |
-            // |           |
-            // |           |
-            // P(x_1y)-----P(xy)
-            //
-            //We can only start triangulation if we are at vertex (1,1),
-            //because we need the other 3 vertices near this one.
-            //To go one pixel line back in the image array, we have to
-            //subtract 1x xDimension.
-            vtkIdType xy = pixelID;
-            vtkIdType x_1y = pixelID-1;
-            vtkIdType xy_1 = pixelID-xDimension;
-            vtkIdType x_1y_1 = xy_1-1;
-
-            //Find the corresponding vertex ID's in the saved vertexIdList:
-            vtkIdType xyV = m_VertexIdList->GetId(xy);
-            vtkIdType x_1yV = m_VertexIdList->GetId(x_1y);
-            vtkIdType xy_1V = m_VertexIdList->GetId(xy_1);
-            vtkIdType x_1y_1V = m_VertexIdList->GetId(x_1y_1);
-
-            if (isPointValid[xy]&&isPointValid[x_1y]&&isPointValid[x_1y_1]&&isPointValid[xy_1]) // check if points of cell are valid
+            const double* pointXY = &points[3*i];
+            const double* pointX_1Y = &points[3*(i-1)];
+            const double* pointXY_1 = pointXY - 3*xDimension;
+            const double* pointX_1Y_1 = pointX_1Y - 3*xDimension;
+            double threshold = filter->m_TriangulationThreshold;
+
+            if( (mitk::Equal(threshold, 0.0)) || ((vtkMath::Distance2BetweenPoints(pointXY, pointX_1Y) <= threshold)
+                                                  && (vtkMath::Distance2BetweenPoints(pointXY, pointXY_1) <= threshold)
+                                                  && (vtkMath::Distance2BetweenPoints(pointX_1Y, pointX_1Y_1) <= threshold)
+                                                  && (vtkMath::Distance2BetweenPoints(pointXY_1, pointX_1Y_1) <= threshold)))
+            {
+              cellTypes[i] = TriangleCells;
+              numberOfTriangles += 2;
+            }
+            else
             {
-              double pointXY[3], pointX_1Y[3], pointXY_1[3], pointX_1Y_1[3];
-
-              points->GetPoint(xyV, pointXY);
-              points->GetPoint(x_1yV, pointX_1Y);
-              points->GetPoint(xy_1V, pointXY_1);
-              points->GetPoint(x_1y_1V, pointX_1Y_1);
-
-              if( (mitk::Equal(m_TriangulationThreshold, 0.0)) || ((vtkMath::Distance2BetweenPoints(pointXY, pointX_1Y) <= m_TriangulationThreshold)
-                                                                   && (vtkMath::Distance2BetweenPoints(pointXY, pointXY_1) <= m_TriangulationThreshold)
-                                                                   && (vtkMath::Distance2BetweenPoints(pointX_1Y, pointX_1Y_1) <= m_TriangulationThreshold)
-                                                                   && (vtkMath::Distance2BetweenPoints(pointXY_1, pointX_1Y_1) <= m_TriangulationThreshold)))
-              {
-                polys->InsertNextCell(3);
-                polys->InsertCellPoint(x_1yV);
-                polys->InsertCellPoint(xyV);
-                polys->InsertCellPoint(x_1y_1V);
-
-                polys->InsertNextCell(3);
-                polys->InsertCellPoint(x_1y_1V);
-                polys->InsertCellPoint(xyV);
-                polys->InsertCellPoint(xy_1V);
-              }
-              else
-              {
-                //We dont want triangulation, but we want to keep the vertex
-                vertices->InsertNextCell(1);
-                vertices->InsertCellPoint(xyV);
-              }
+              //We dont want triangulation, but we want to keep the vertex
+              cellTypes[i] = VertexCell;
+              ++numberOfVertices;
             }
           }
         }
         else
         {
           //We dont want triangulation, we only want vertices
-          vertices->InsertNextCell(1);
-          vertices->InsertCellPoint(m_VertexIdList->GetId(pixelID));
+          cellTypes[i] = VertexCell;
+          ++numberOfVertices;
         }
-        //Scalar values are necessary for mapping colors/texture onto the surface
-        if (scalarFloatData)
+      }
+      filter->m_RowTriangleOffsets[j] = numberOfTriangles;
+      filter->m_RowVertexOffsets[j] = numberOfVertices;
+      break;
+    }
+    case WriteCells:
+    {
+      //Each cell is stored as the number of its points followed by the point ID's.
+      vtkIdType* polys = filter->m_Polys->GetPointer() + 4*filter->m_RowTriangleOffsets[j];
+      vtkIdType* vertices = filter->m_Vertices->GetPointer() + 2*filter->m_RowVertexOffsets[j];
+      const vtkIdType* vertexIds = filter->m_VertexIdList->GetPointer(rowStart);
+
+      for (int i=0; i<xDimension; i++)
+      {
+        if (cellTypes[i] == TriangleCells)
         {
-          scalarArray->InsertTuple1(m_VertexIdList->GetId(pixelID), scalarFloatData[pixelID]);
+          //This little piece of art explains the ID's:
+          //
+          // P(x_1y_1)---P(xy_1)
+          // |           |
+          // |           |
+          // |           |
+          // P(x_1y)-----P(xy)
+          //
+          vtkIdType xyV = vertexIds[i];
+          vtkIdType x_1yV = vertexIds[i-1];
+          vtkIdType xy_1V = vertexIds[i-xDimension];
+          vtkIdType x_1y_1V = vertexIds[i-1-xDimension];
+
+          polys[0] = 3;
+          polys[1] = x_1yV;
+          polys[2] = xyV;
+          polys[3] = x_1y_1V;
+
+          polys[4] = 3;
+          polys[5] = x_1y_1V;
+          polys[6] = xyV;
+          polys[7] = xy_1V;
+          polys += 8;
+        }
+        else if (cellTypes[i] == VertexCell)
+        {
+          vertices[0] = 1;
+          vertices[1] = vertexIds[i];
+          vertices += 2;
         }
-        //These Texture Coordinates will map color pixel and vertices 1:1 (e.g. for Kinect).
-        float xNorm = (((float)i)/xDimension);// correct video texture scale for kinect
-        float yNorm = ((float)j)/yDimension; //don't flip. we don't need to flip.
-        textureCoords->InsertTuple2(m_VertexIdList->GetId(pixelID), xNorm, yNorm);
       }
+      break;
+    }
     }
   }
 
-  vtkSmartPointer<vtkPolyData> mesh = vtkSmartPointer<vtkPolyData>::New();
-  mesh->SetPoints(points);
-  mesh->SetPolys(polys);
-  mesh->SetVerts(vertices);
-  //Pass the scalars to the polydata (if they were set).
-  if (scalarArray->GetNumberOfTuples()>0)
-  {
-    mesh->GetPointData()->SetScalars(scalarArray);
-  }
-  //Pass the TextureCoords to the polydata anyway (to save them).
-  mesh->GetPointData()->SetTCoords(textureCoords);
-  output->SetVtkPolyData(mesh);
+  return ITK_THREAD_RETURN_VALUE;
 }
 
 void mitk::ToFDistanceImageToSurfaceFilter::CreateOutputsForAllInputs()
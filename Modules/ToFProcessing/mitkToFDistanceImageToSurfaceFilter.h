@@ -29,6 +29,12 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <vtkSmartPointer.h>
 #include <vtkIdList.h>
 
+#include <itkMultiThreader.h>
+
+class vtkPoints;
+class vtkCellArray;
+class vtkFloatArray;
+
 namespace mitk
 {
   /**
@@ -43,6 +49,14 @@ namespace mitk
   * The definition of the image plane and its coordinate systems (pixel and mm) is depicted in the following image
   * \image html ../Modules/ToFProcessing/Documentation/ImagePlane.png
   *
+  * The projection of each pixel depends only on the intrinsics, the reconstruction mode and the image geometry.
+  * It is kept in a per-pixel ray table which is only recomputed when one of them changes, so a frame is converted
+  * with one multiplication and division per coordinate. The conversion and the mesh generation are split across
+  * the threads of the filter (SetNumberOfThreads()).
+  *
+  * \warning The points, cells and point data arrays of the output are reused for the next frame. Use
+  * vtkPolyData::DeepCopy() to keep the surface of a frame.
+  *
   * @ingroup SurfaceFilters
   * @ingroup ToFProcessing
   */
@@ -172,6 +186,31 @@ namespace mitk
     */
     void CreateOutputsForAllInputs();
 
+    /*!
+    \brief Recomputes m_RayTable if the intrinsics, the reconstruction mode or the geometry of the input changed.
+    \return false if the reconstruction mode is invalid
+    */
+    bool UpdateRayTable(mitk::Image* input);
+
+    enum ConversionPhase { ConvertPoints, CompactPoints, WriteCells };
+
+    enum CellType { NoCell = 0, TriangleCells = 1, VertexCell = 2 };
+
+    struct ConversionStruct
+    {
+      ToFDistanceImageToSurfaceFilter* Filter;
+      ConversionPhase Phase;
+      const float* Distances;
+      const float* Scalars;
+      int XDimension;
+      int YDimension;
+    };
+
+    /*!
+    \brief Executes one phase of GenerateData() for a contiguous block of image rows per thread.
+    */
+    static ITK_THREAD_RETURN_TYPE ThreadedConversionCallback(void* arg);
+
     IplImage* m_IplScalarImage; ///< Scalar image used for surface texturing
 
     mitk::CameraIntrinsics::Pointer m_CameraIntrinsics; ///< Specifies the intrinsic parameters
@@ -189,6 +228,22 @@ namespace mitk
 
     double m_TriangulationThreshold;
 
+    std::vector<double> m_RayTableParameters; ///< Intrinsics, reconstruction mode and image geometry m_RayTable was computed for.
+    std::vector<double> m_RayTable; ///< Per pixel: numerators of x and y and the denominator of the projection, see ToFProcessingCommon.
+    ToFProcessingCommon::ToFPoint2D m_RayTableFocalLength; ///< Focal length used with m_RayTable (in mm for WithInterPixelDistance).
+
+    std::vector<double> m_PointGrid; ///< Cartesian coordinates of every pixel of the current frame.
+    std::vector<unsigned char> m_PointValid; ///< 1 if the distance of the pixel is valid. Not a vector<bool>, as threads write neighboring elements.
+    std::vector<unsigned char> m_CellTypes; ///< CellType generated for each pixel.
+    std::vector<vtkIdType> m_RowPointOffsets; ///< Number of valid points in each row, then the id of the first point of each row.
+    std::vector<vtkIdType> m_RowTriangleOffsets; ///< Number of triangles in each row, then the index of the first triangle of each row.
+    std::vector<vtkIdType> m_RowVertexOffsets; ///< Number of vertex cells in each row, then the index of the first vertex cell of each row.
+
+    vtkSmartPointer<vtkPoints> m_Points; ///< Points of the output, reused across frames.
+    vtkSmartPointer<vtkCellArray> m_Polys; ///< Triangles of the output, reused across frames.
+    vtkSmartPointer<vtkCellArray> m_Vertices; ///< Vertex cells of the output, reused across frames.
+    vtkSmartPointer<vtkFloatArray> m_ScalarArray; ///< Scalars of the output, reused across frames.
+    vtkSmartPointer<vtkFloatArray> m_TextureCoords; ///< Texture coordinates of the output, reused across frames.
   };
 } //END mitk namespace
 #endif
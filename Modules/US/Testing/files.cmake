@@ -2,6 +2,7 @@ SET(MODULE_TESTS
    mitkUSDeviceTest.cpp
    mitkUSProbeTest.cpp
    mitkUSImageLoggingFilterTest.cpp
+   mitkUSImageRingBufferTest.cpp
 
    # -----------------------------------------------------------------------
 
@@ -16,8 +16,73 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkUSVideoDevice.h"
 #include "mitkUSProbe.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
 #include "mitkTestingMacros.h"
 
+#include <cstring>
+
+/**
+* Image source writing frames of 8x8 pixels, all pixels of a frame have the
+* number of the frame as value.
+*/
+class mitkUSDeviceTestImageSource : public mitk::USImageSource
+{
+public:
+  mitkClassMacro(mitkUSDeviceTestImageSource, mitk::USImageSource);
+  itkFactorylessNewMacro(Self)
+
+protected:
+  mitkUSDeviceTestImageSource() : m_FrameValue(0) {}
+
+  virtual void GetNextRawImage( mitk::Image::Pointer& image )
+  {
+    if ( image.IsNull() ) { image = mitk::Image::New(); }
+    if ( ! image->IsInitialized() )
+    {
+      unsigned int dimensions[2] = { 8, 8 };
+      image->Initialize(mitk::MakeScalarPixelType<unsigned char>(), 2, dimensions);
+    }
+
+    ++m_FrameValue;
+    mitk::ImageWriteAccessor writeAccessor(image, image->GetSliceData(0,0,0));
+    std::memset(writeAccessor.GetData(), m_FrameValue, 8*8);
+    image->Modified();
+  }
+
+  unsigned char m_FrameValue;
+};
+
+/**
+* Device delivering the frames of mitkUSDeviceTestImageSource. Frames are
+* only grabbed by calling GrabImage(), no acquisition thread is started.
+*/
+class mitkUSDeviceTestDevice : public mitk::USDevice
+{
+public:
+  mitkClassMacro(mitkUSDeviceTestDevice, mitk::USDevice);
+  itkFactorylessNewMacro(Self)
+
+  virtual std::string GetDeviceClass() { return "org.mitk.modules.us.USDeviceTestDevice"; }
+  virtual mitk::USImageSource::Pointer GetUSImageSource() { return m_ImageSource.GetPointer(); }
+
+protected:
+  mitkUSDeviceTestDevice()
+    : mitk::USDevice("Manufacturer", "Model"),
+      m_ImageSource(mitkUSDeviceTestImageSource::New())
+  {
+    this->SetSpawnAcquireThread(false);
+  }
+
+  virtual bool OnInitialization() { return true; }
+  virtual bool OnConnection() { return true; }
+  virtual bool OnDisconnection() { return true; }
+  virtual bool OnActivation() { return true; }
+  virtual bool OnDeactivation() { return true; }
+
+  mitkUSDeviceTestImageSource::Pointer m_ImageSource;
+};
+
 class mitkUSDeviceTestClass
 {
 public:
@@ -39,6 +104,76 @@ public:
   static void TestActivateProbe()
   {
   }
+
+  static void WriteZeroFrame(mitk::USImageRingBuffer* ringBuffer)
+  {
+    if ( ! ringBuffer->BeginWrite() ) { return; }
+    mitk::Image::Pointer& image = ringBuffer->GetWriteImage();
+    {
+      mitk::ImageWriteAccessor writeAccessor(image, image->GetSliceData(0,0,0));
+      std::memset(writeAccessor.GetData(), 0, 8*8);
+    }
+    ringBuffer->EndWrite();
+  }
+
+  static unsigned char GetOutputValue(mitk::USDevice* device)
+  {
+    mitk::Image::Pointer output = device->GetOutput();
+    mitk::ImageReadAccessor readAccessor(output, output->GetSliceData(0,0,0));
+    return static_cast<const unsigned char*>(readAccessor.GetData())[8*8-1];
+  }
+
+  static void TestOutputOfRingBuffer()
+  {
+    mitkUSDeviceTestDevice::Pointer device = mitkUSDeviceTestDevice::New();
+    mitk::USImageRingBuffer::Pointer ringBuffer = device->GetUSImageSource()->GetRingBuffer();
+
+    device->Update();
+    MITK_TEST_CONDITION(! device->GetOutput()->IsInitialized(), "Output should stay empty before the first frame");
+
+    device->GrabImage();
+    device->Modified();
+    device->Update();
+    MITK_TEST_CONDITION_REQUIRED(device->GetOutput()->IsInitialized()
+      && device->GetOutput()->GetDimension(0) == 8 && device->GetOutput()->GetDimension(1) == 8, "Output should have the size of the frame");
+    MITK_TEST_CONDITION(GetOutputValue(device) == 1, "Output should contain the first frame");
+
+    // the output references the slot of its frame, which the producer skips
+    // while the other slots are still available
+    for ( unsigned int i = 0; i < ringBuffer->GetNumberOfSlots(); ++i )
+    {
+      device->GrabImage();
+    }
+    MITK_TEST_CONDITION(ringBuffer->GetNumberOfDroppedFrames() == 0, "No frame should be dropped while only the device reads the ring buffer");
+    MITK_TEST_CONDITION(GetOutputValue(device) == 1, "Output should keep the first frame while the producer writes the other slots");
+
+    device->Modified();
+    device->Update();
+    MITK_TEST_CONDITION(GetOutputValue(device) == ringBuffer->GetNumberOfSlots() + 1, "Output should contain the latest frame after an update");
+
+    // with a frame held by a consumer the remaining slots are still available
+    mitk::USImageRingBuffer::Frame heldFrame = ringBuffer->GetLatestFrame();
+    for ( unsigned int i = 0; i < ringBuffer->GetNumberOfSlots() - 1; ++i )
+    {
+      device->GrabImage();
+      device->Modified();
+      device->Update();
+    }
+    MITK_TEST_CONDITION(ringBuffer->GetNumberOfDroppedFrames() == 0, "Updating the device should release the slot of the previous frame");
+    MITK_TEST_CONDITION(GetOutputValue(device) == 2 * ringBuffer->GetNumberOfSlots(), "Output should follow the grabbed frames");
+
+    // an output which outlives the device still holds its frame
+    mitk::Image::Pointer output = device->GetOutput();
+    heldFrame.Release();
+    device = 0;
+    for ( unsigned int i = 0; i < 2 * ringBuffer->GetNumberOfSlots(); ++i )
+    {
+      WriteZeroFrame(ringBuffer);
+    }
+    mitk::ImageReadAccessor outputReadAccessor(output, output->GetSliceData(0,0,0));
+    MITK_TEST_CONDITION(static_cast<const unsigned char*>(outputReadAccessor.GetData())[8*8-1] == 2 * ringBuffer->GetNumberOfSlots(),
+      "Output should keep its frame after the device was destroyed");
+  }
 };
 
 /**
@@ -51,6 +186,7 @@ int mitkUSDeviceTest(int /* argc */, char* /*argv*/[])
   mitkUSDeviceTestClass::TestInstantiation();
   mitkUSDeviceTestClass::TestAddProbe();
   mitkUSDeviceTestClass::TestActivateProbe();
+  mitkUSDeviceTestClass::TestOutputOfRingBuffer();
 
   MITK_TEST_END();
 }
\ No newline at end of file
@@ -15,12 +15,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 ===================================================================*/
 
 #include "mitkUSImageLoggingFilter.h"
+#include "mitkUSImageRecordingReader.h"
 #include <mitkTestingMacros.h>
 #include <mitkTestFixture.h>
 #include <mitkTestingConfig.h>
 #include <mitkIOUtil.h>
 
 #include "mitkImageGenerator.h"
+#include "mitkImageReadAccessor.h"
 
 #include "itksys/SystemTools.hxx"
 
@@ -36,6 +38,7 @@ class mitkUSImageLoggingFilterTestSuite : public mitk::TestFixture
   MITK_TEST(TestFilterWithInvalidPath);
   MITK_TEST(TestWrongImageFileExtensions);
   MITK_TEST(TestJpgFileExtension);
+  MITK_TEST(TestRecording);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -179,6 +182,66 @@ public:
   std::remove(filenames.at(0).c_str());
   std::remove(csvFileName.c_str());
   }
+
+  void TestRecording()
+  {
+  std::string filename = m_TemporaryTestDirectory + "/usImageLoggingFilterTest" + mitk::USImageRecordingWriter::FILE_EXTENSION;
+
+  m_TestFilter->SetInput(m_RandomRestImage1);
+  m_TestFilter->GetRecordingWriter()->SetMaximumQueueSize(2);
+  m_TestFilter->GetRecordingWriter()->BlockWhenQueueIsFullOn();
+  m_TestFilter->StartRecording(filename);
+  CPPUNIT_ASSERT_MESSAGE("Testing if recording was started",m_TestFilter->GetIsRecording());
+
+  for(int i=0; i<5; i++)
+    {
+    m_TestFilter->Update();
+    std::stringstream testmessage;
+    testmessage << "testmessage" << i;
+    m_TestFilter->AddMessageToCurrentImage(testmessage.str());
+    itksys::SystemTools::Delay(50);
+    }
+  m_TestFilter->StopRecording();
+  CPPUNIT_ASSERT_MESSAGE("Testing if recording was stopped",!m_TestFilter->GetIsRecording());
+
+  mitk::USImageRecordingWriter::Pointer writer = m_TestFilter->GetRecordingWriter();
+  CPPUNIT_ASSERT_MESSAGE("Testing if all frames were written",writer->GetNumberOfWrittenFrames() == 5);
+  CPPUNIT_ASSERT_MESSAGE("Testing if no frame was dropped",writer->GetNumberOfDroppedFrames() == 0);
+  CPPUNIT_ASSERT_MESSAGE("Testing if the queue size was respected",writer->GetMaximumQueueFill() <= 2);
+
+  //nothing is kept in memory while recording
+  std::vector<std::string> filenames;
+  std::string csvFileName;
+  m_TestFilter->SaveImages(m_TemporaryTestDirectory,filenames,csvFileName);
+  CPPUNIT_ASSERT_MESSAGE("Testing if no image was logged in memory",filenames.empty());
+  std::remove(csvFileName.c_str());
+
+  mitk::USImageRecordingReader::Pointer reader = mitk::USImageRecordingReader::New();
+  reader->Open(filename);
+  CPPUNIT_ASSERT_MESSAGE("Testing number of recorded frames",reader->GetNumberOfFrames() == 5);
+
+  mitk::ImageReadAccessor inputAccessor(m_RandomRestImage1);
+  size_t size = 100*100*100*sizeof(float);
+  for(unsigned int i=0; i<reader->GetNumberOfFrames(); i++)
+    {
+    mitk::Image::Pointer frame = reader->GetFrame(i);
+    CPPUNIT_ASSERT_MESSAGE("Testing pixel type of recorded frame",frame->GetPixelType() == m_RandomRestImage1->GetPixelType());
+    CPPUNIT_ASSERT_MESSAGE("Testing size of recorded frame",frame->GetDimension() == 3 && frame->GetDimension(2) == 100);
+    mitk::ImageReadAccessor frameAccessor(frame);
+    CPPUNIT_ASSERT_MESSAGE("Testing data of recorded frame",memcmp(frameAccessor.GetData(),inputAccessor.GetData(),size) == 0);
+
+    std::vector<std::string> messages = reader->GetMessages(i);
+    std::stringstream testmessage;
+    testmessage << "testmessage" << i;
+    CPPUNIT_ASSERT_MESSAGE("Testing message of recorded frame",messages.size() == 1 && messages.at(0) == testmessage.str());
+    if(i>0) CPPUNIT_ASSERT_MESSAGE("Testing if timestamps increase",reader->GetTimeStamp(i) > reader->GetTimeStamp(i-1));
+    }
+
+  //clean up
+  reader = NULL;
+  std::remove(filename.c_str());
+  std::remove((filename + mitk::USImageRecordingWriter::INDEX_FILE_EXTENSION).c_str());
+  }
 };
 
 MITK_TEST_SUITE_REGISTRATION(mitkUSImageLoggingFilter)
@@ -0,0 +1,213 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkUSImageRingBuffer.h"
+#include "mitkImageReadAccessor.h"
+#include "mitkImageWriteAccessor.h"
+#include "mitkTestingMacros.h"
+
+#include <itkMultiThreader.h>
+#include <cstring>
+
+class mitkUSImageRingBufferTestClass
+{
+public:
+
+  static const unsigned int NumberOfProducedFrames = 20000;
+
+  struct ProducerData
+  {
+    mitk::USImageRingBuffer* Buffer;
+    mitk::AtomicInteger      Finished;
+  };
+
+  static bool WriteFrame(mitk::USImageRingBuffer* buffer)
+  {
+    if ( ! buffer->BeginWrite() ) { return false; }
+
+    mitk::Image::Pointer& image = buffer->GetWriteImage();
+    if ( ! image->IsInitialized() )
+    {
+      unsigned int dimensions[2] = { 8, 8 };
+      image->Initialize(mitk::MakeScalarPixelType<unsigned char>(), 2, dimensions);
+    }
+    buffer->EndWrite();
+    return true;
+  }
+
+  static void TestEmptyBuffer()
+  {
+    mitk::USImageRingBuffer::Pointer buffer = mitk::USImageRingBuffer::New();
+    MITK_TEST_CONDITION_REQUIRED(buffer->GetNumberOfSlots() == 4, "Ring buffer should have four slots by default");
+    MITK_TEST_CONDITION(! buffer->GetLatestFrame().IsValid(), "Frame of an empty ring buffer should be invalid");
+
+    MITK_TEST_CONDITION_REQUIRED(buffer->BeginWrite(), "Slot can be claimed in an empty ring buffer");
+    buffer->EndWrite(false);
+    MITK_TEST_CONDITION(! buffer->GetLatestFrame().IsValid(), "Invalid frame should not be published");
+    MITK_TEST_CONDITION(buffer->GetNumberOfFrames() == 0, "Invalid frame should not be counted");
+  }
+
+  static void TestLatestFrame()
+  {
+    mitk::USImageRingBuffer::Pointer buffer = mitk::USImageRingBuffer::New(3);
+
+    for ( unsigned int i = 1; i <= 5; ++i )
+    {
+      MITK_TEST_CONDITION_REQUIRED(WriteFrame(buffer), "Frame " << i << " should be written");
+
+      mitk::USImageRingBuffer::Frame frame = buffer->GetLatestFrame();
+      MITK_TEST_CONDITION_REQUIRED(frame.IsValid() && frame.GetImage() != 0, "Latest frame should be valid");
+      MITK_TEST_CONDITION(frame.GetFrameNumber() == i, "Latest frame should have number " << i);
+    }
+
+    MITK_TEST_CONDITION(buffer->GetNumberOfFrames() == 5, "Five frames should be counted");
+    MITK_TEST_CONDITION(buffer->GetNumberOfDroppedFrames() == 0, "No frame should be dropped");
+    MITK_TEST_CONDITION(buffer->GetNumberOfSkippedFrames() == 0, "No frame should be skipped");
+    MITK_TEST_CONDITION(buffer->GetAverageLatency() >= 0, "Latency should not be negative");
+  }
+
+  static void TestHeldFrames()
+  {
+    mitk::USImageRingBuffer::Pointer buffer = mitk::USImageRingBuffer::New(3);
+
+    // hold the first two frames, so only the slot of the third one is left
+    WriteFrame(buffer);
+    mitk::USImageRingBuffer::Frame first = buffer->GetLatestFrame();
+    WriteFrame(buffer);
+    mitk::USImageRingBuffer::Frame second = buffer->GetLatestFrame();
+    mitk::USImageRingBuffer::Frame copy = second;
+
+    MITK_TEST_CONDITION_REQUIRED(WriteFrame(buffer), "Third frame should be written into the free slot");
+    MITK_TEST_CONDITION(! WriteFrame(buffer), "Fourth frame should be dropped while the other slots are held");
+    MITK_TEST_CONDITION(buffer->GetNumberOfDroppedFrames() == 1, "One frame should be dropped");
+    MITK_TEST_CONDITION(first.GetFrameNumber() == 1 && second.GetFrameNumber() == 2, "Held frames should not be overwritten");
+
+    // the slot of the second frame is still referenced by the copy
+    second.Release();
+    MITK_TEST_CONDITION(! second.IsValid(), "Released frame should be invalid");
+    MITK_TEST_CONDITION(! WriteFrame(buffer), "Frame should be dropped while a copy holds the slot");
+
+    copy.Release();
+    MITK_TEST_CONDITION_REQUIRED(WriteFrame(buffer), "Frame should be written after all references were released");
+    MITK_TEST_CONDITION(buffer->GetNumberOfSkippedFrames() == 0, "Overwritten frame was retrieved before and is not skipped");
+    MITK_TEST_CONDITION(buffer->GetLatestFrame().GetFrameNumber() == 4, "Dropped frames should not get a number");
+
+    // frames 5 and 6 are written without retrieving the third one
+    first.Release();
+    WriteFrame(buffer);
+    WriteFrame(buffer);
+    MITK_TEST_CONDITION(buffer->GetNumberOfSkippedFrames() == 1, "Third frame should be counted as skipped");
+
+    buffer->ResetCounters();
+    MITK_TEST_CONDITION(buffer->GetNumberOfFrames() == 0 && buffer->GetNumberOfDroppedFrames() == 0
+      && buffer->GetNumberOfSkippedFrames() == 0 && buffer->GetAverageLatency() == 0, "Counters should be zero after reset");
+  }
+
+  // writes frames whose pixels all have the frame number (modulo 256) as value
+  static ITK_THREAD_RETURN_TYPE ProducerThread(void* pInfoStruct)
+  {
+    struct itk::MultiThreader::ThreadInfoStruct * pInfo = (struct itk::MultiThreader::ThreadInfoStruct*)pInfoStruct;
+    ProducerData* data = static_cast<ProducerData*>(pInfo->UserData);
+
+    unsigned long frameNumber = 0;
+    for ( unsigned int i = 0; i < NumberOfProducedFrames; ++i )
+    {
+      if ( ! data->Buffer->BeginWrite() ) { continue; }
+
+      mitk::Image::Pointer& image = data->Buffer->GetWriteImage();
+      if ( ! image->IsInitialized() )
+      {
+        unsigned int dimensions[2] = { 64, 64 };
+        image->Initialize(mitk::MakeScalarPixelType<unsigned char>(), 2, dimensions);
+      }
+      {
+        mitk::ImageWriteAccessor writeAccessor(image, image->GetSliceData(0,0,0));
+        std::memset(writeAccessor.GetData(), static_cast<unsigned char>(++frameNumber), 64*64);
+      }
+      data->Buffer->EndWrite();
+    }
+
+    data->Finished.Set(1);
+    return ITK_THREAD_RETURN_VALUE;
+  }
+
+  // true if all pixels of the frame have the value written for its number
+  static bool IsFrameComplete(const mitk::USImageRingBuffer::Frame& frame)
+  {
+    mitk::Image* image = frame.GetImage();
+    mitk::ImageReadAccessor readAccessor(image, image->GetSliceData(0,0,0));
+    const unsigned char* pixels = static_cast<const unsigned char*>(readAccessor.GetData());
+    unsigned char value = static_cast<unsigned char>(frame.GetFrameNumber());
+    for ( unsigned int i = 0; i < 64*64; ++i )
+    {
+      if ( pixels[i] != value ) { return false; }
+    }
+    return true;
+  }
+
+  static void TestConcurrentAccess()
+  {
+    mitk::USImageRingBuffer::Pointer buffer = mitk::USImageRingBuffer::New();
+    ProducerData data;
+    data.Buffer = buffer.GetPointer();
+
+    itk::MultiThreader::Pointer multiThreader = itk::MultiThreader::New();
+    int threadID = multiThreader->SpawnThread(ProducerThread, &data);
+
+    // frames have to be complete, in order and unchanged while they are held
+    unsigned int received = 0;
+    unsigned int errors = 0;
+    unsigned long lastFrameNumber = 0;
+    mitk::USImageRingBuffer::Frame heldFrame;
+    while ( data.Finished.Get() == 0 )
+    {
+      mitk::USImageRingBuffer::Frame frame = buffer->GetLatestFrame();
+      if ( ! frame.IsValid() || frame.GetFrameNumber() == lastFrameNumber ) { continue; }
+
+      ++received;
+      if ( frame.GetFrameNumber() < lastFrameNumber || ! IsFrameComplete(frame) ) { ++errors; }
+      lastFrameNumber = frame.GetFrameNumber();
+
+      // every tenth frame is held while later frames are written, like the output of a device
+      if ( heldFrame.IsValid() && ! IsFrameComplete(heldFrame) ) { ++errors; }
+      if ( received % 10 == 0 ) { heldFrame = frame; }
+    }
+    multiThreader->TerminateThread(threadID);
+
+    mitk::USImageRingBuffer::Frame lastFrame = buffer->GetLatestFrame();
+    MITK_TEST_CONDITION_REQUIRED(lastFrame.IsValid(), "Latest frame should be valid after the producer finished");
+    MITK_TEST_CONDITION(lastFrame.GetFrameNumber() == buffer->GetNumberOfFrames() && IsFrameComplete(lastFrame),
+      "Latest frame should be the last published one (" << received << " frames received while writing)");
+    MITK_TEST_CONDITION(errors == 0, "Frames should be complete and in order (" << errors << " errors)");
+    MITK_TEST_CONDITION(buffer->GetNumberOfFrames() + buffer->GetNumberOfDroppedFrames() == NumberOfProducedFrames,
+      "Every frame should be published or counted as dropped");
+  }
+};
+
+/**
+* This function is testing methods of the class USImageRingBuffer.
+*/
+int mitkUSImageRingBufferTest(int /* argc */, char* /*argv*/[])
+{
+  MITK_TEST_BEGIN("mitkUSImageRingBufferTest");
+
+    mitkUSImageRingBufferTestClass::TestEmptyBuffer();
+    mitkUSImageRingBufferTestClass::TestLatestFrame();
+    mitkUSImageRingBufferTestClass::TestHeldFrames();
+    mitkUSImageRingBufferTestClass::TestConcurrentAccess();
+
+  MITK_TEST_END();
+}
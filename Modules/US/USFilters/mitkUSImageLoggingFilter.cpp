@@ -21,12 +21,14 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <Poco/Path.h>
 
 mitk::USImageLoggingFilter::USImageLoggingFilter() : m_SystemTimeClock(RealTimeClock::New()),
-                                                     m_ImageExtension(".nrrd")
+                                                     m_ImageExtension(".nrrd"),
+                                                     m_RecordingWriter(USImageRecordingWriter::New())
 {
 }
 
 mitk::USImageLoggingFilter::~USImageLoggingFilter()
 {
+  this->StopRecording();
 }
 
 void mitk::USImageLoggingFilter::GenerateData()
@@ -40,36 +42,16 @@ void mitk::USImageLoggingFilter::GenerateData()
     return;
     }
 
-  //a clone is needed for a output and to store it.
-  mitk::Image::Pointer inputClone = inputImage->Clone();
-
-
-  //simply redirecy the input to the output
-  //this->SetNumberOfRequiredOutputs(1);
-  //this->SetNthOutput(0, inputClone->Clone());
-  //outputImage->Graft(inputImage);
-  //this->SetOutput(this->GetInput());
-  /*if (!this->GetOutput()->IsInitialized())
+  //while recording the writer copies the image into its queue, nothing is kept in memory
+  if(m_RecordingWriter->GetIsOpen())
     {
-    this->SetNumberOfRequiredOutputs(1);
-    mitk::Image::Pointer newOutput = mitk::Image::New();
-    this->SetNthOutput(0, newOutput);
-    }
-  memcpy(this->GetOutput(),this->GetInput());*/
-
-  //this->SetNthOutput(0,inputImage.);
-  //this->AllocateOutputs();
-  //this->GraftOutput(inputClone);
-
-  /*
-  if (!this->GetOutput()->IsInitialized())
-    {
-    mitk::Image::Pointer newOutput = mitk::Image::New();
-    this->SetNthOutput(0, newOutput);
+    m_RecordingWriter->AddFrame(inputImage, m_SystemTimeClock->GetCurrentStamp());
+    return;
     }
-  this->GetOutput()Graft(this->GetInput());
-  */
 
+  //the input (e.g. the output of a mitk::USDevice) references memory which is
+  //overwritten by later frames, so the logged image is the only copy made
+  mitk::Image::Pointer inputClone = inputImage->Clone();
 
   m_LoggedImages.push_back(inputClone);
   m_LoggedMITKSystemTimes.push_back(m_SystemTimeClock->GetCurrentStamp());
@@ -78,6 +60,11 @@ void mitk::USImageLoggingFilter::GenerateData()
 
 void mitk::USImageLoggingFilter::AddMessageToCurrentImage(std::string message)
 {
+  if(m_RecordingWriter->GetIsOpen())
+    {
+    m_RecordingWriter->AddMessage(message, m_SystemTimeClock->GetCurrentStamp());
+    return;
+    }
   m_LoggedMessages.insert(std::make_pair(static_cast<int>(m_LoggedImages.size()-1),message));
 }
 
@@ -152,3 +139,18 @@ bool mitk::USImageLoggingFilter::SetImageFilesExtension(std::string extension)
   return true;
   }
  }
+
+void mitk::USImageLoggingFilter::StartRecording(const std::string& fileName)
+{
+  m_RecordingWriter->Open(fileName);
+}
+
+void mitk::USImageLoggingFilter::StopRecording()
+{
+  m_RecordingWriter->Close();
+}
+
+bool mitk::USImageLoggingFilter::GetIsRecording() const
+{
+  return m_RecordingWriter->GetIsOpen();
+}
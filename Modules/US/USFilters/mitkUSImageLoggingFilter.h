@@ -21,6 +21,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include <MitkUSExports.h>
 #include <mitkImageToImageFilter.h>
 #include <mitkRealTimeClock.h>
+#include "mitkUSImageRecordingWriter.h"
 
 
 namespace mitk {
@@ -29,6 +30,10 @@ namespace mitk {
    *  add messages. All data (images, timestamps and messages) is written to the harddisc when
    *  the method SaveImages(...) is called.
    *
+   *  For long acquisitions the images can be streamed to disk instead: between StartRecording(...) and
+   *  StopRecording() no images are kept in memory, a mitk::USImageRecordingWriter writes them together with
+   *  their timestamps and messages in a background thread. Use mitk::USImageRecordingReader for playback.
+   *
    *  Caution: only supports logging of one input at the moment, multiple inputs are ignored!
    *
    *  \ingroup US
@@ -76,6 +81,21 @@ namespace mitk {
      */
     bool SetImageFilesExtension(std::string extension);
 
+    /** Starts streaming all following images, timestamps and messages to the given recording file instead of
+     *  keeping them in memory for SaveImages(...). The queue size and the behaviour for a full queue can be
+     *  configured at GetRecordingWriter() before.
+     *  @throw mitk::Exception Throws an exception if the recording file cannot be created.
+     */
+    void StartRecording(const std::string& fileName);
+
+    /** Writes the remaining queued images and closes the recording file. */
+    void StopRecording();
+
+    bool GetIsRecording() const;
+
+    /** Writer used for recording, provides the statistics of the recording queue. */
+    itkGetMacro(RecordingWriter, mitk::USImageRecordingWriter::Pointer);
+
 
   protected:
     USImageLoggingFilter();
@@ -88,6 +108,7 @@ namespace mitk {
     std::map<int, std::string> m_LoggedMessages; ///< (Optional) messages for every logged image
     std::vector<double> m_LoggedMITKSystemTimes; ///< Logged system times for every logged image
     std::string m_ImageExtension; ///< stores the image extension, default is ".nrrd"
+    mitk::USImageRecordingWriter::Pointer m_RecordingWriter; ///< streams the images to disk while recording
 
   };
 } // namespace mitk
@@ -0,0 +1,158 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkUSImageRecordingReader.h"
+
+#include <mitkException.h>
+#include <itkRGBPixel.h>
+#include <itksys/SystemTools.hxx>
+
+#include <cstring>
+
+namespace
+{
+  bool ReadHeader(std::ifstream& file, const char* identifier)
+  {
+    char header[mitk::USImageRecordingWriter::HEADER_SIZE];
+    itk::uint32_t version;
+    if ( ! file.read(header, sizeof(header)) ) { return false; }
+    memcpy(&version, header + 8, sizeof(version));
+    return memcmp(header, identifier, strlen(identifier)) == 0 && version == mitk::USImageRecordingWriter::FILE_VERSION;
+  }
+
+  mitk::PixelType GetPixelType(itk::uint32_t code)
+  {
+    switch ( code )
+    {
+    case mitk::USImageRecordingWriter::UCharPixelType: return mitk::MakeScalarPixelType<unsigned char>();
+    case mitk::USImageRecordingWriter::CharPixelType: return mitk::MakeScalarPixelType<char>();
+    case mitk::USImageRecordingWriter::UShortPixelType: return mitk::MakeScalarPixelType<unsigned short>();
+    case mitk::USImageRecordingWriter::ShortPixelType: return mitk::MakeScalarPixelType<short>();
+    case mitk::USImageRecordingWriter::FloatPixelType: return mitk::MakeScalarPixelType<float>();
+    case mitk::USImageRecordingWriter::DoublePixelType: return mitk::MakeScalarPixelType<double>();
+    case mitk::USImageRecordingWriter::RGBUCharPixelType: return mitk::MakePixelType<itk::Image<itk::RGBPixel<unsigned char>, 2> >();
+    default: break;
+    }
+    mitkThrow() << "Unknown pixel type " << code << " in recording.";
+  }
+}
+
+mitk::USImageRecordingReader::USImageRecordingReader()
+{
+}
+
+mitk::USImageRecordingReader::~USImageRecordingReader()
+{
+}
+
+void mitk::USImageRecordingReader::Open(const std::string& fileName)
+{
+  m_FileName = fileName;
+  m_Frames.clear();
+  m_Messages.clear();
+
+  std::ifstream dataFile(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::ifstream indexFile((fileName + USImageRecordingWriter::INDEX_FILE_EXTENSION).c_str(), std::ios::in | std::ios::binary);
+  if ( ! ReadHeader(dataFile, USImageRecordingWriter::DATA_FILE_IDENTIFIER)
+    || ! ReadHeader(indexFile, USImageRecordingWriter::INDEX_FILE_IDENTIFIER) )
+  {
+    mitkThrow() << fileName << " is not an ultrasound recording or has an unsupported version.";
+  }
+
+  // entries whose data did not reach the data file yet are ignored
+  itk::uint64_t dataFileSize = itksys::SystemTools::FileLength(fileName.c_str());
+
+  USImageRecordingWriter::IndexEntry entry;
+  while ( indexFile.read(reinterpret_cast<char*>(&entry), sizeof(entry)) )
+  {
+    if ( entry.Offset + entry.Size > dataFileSize ) { break; }
+
+    if ( entry.Type == USImageRecordingWriter::FrameRecord )
+    {
+      if ( entry.Frame != m_Frames.size() )
+      {
+        mitkThrow() << "Recording " << fileName << " is corrupt (frame " << m_Frames.size() << " is missing).";
+      }
+      m_Frames.push_back(entry);
+    }
+    else if ( entry.Type == USImageRecordingWriter::MessageRecord )
+    {
+      std::string message(entry.Size, '\0');
+      dataFile.seekg(entry.Offset);
+      if ( entry.Size > 0 && ! dataFile.read(&message[0], entry.Size) ) { break; }
+      m_Messages.insert(std::make_pair(static_cast<unsigned int>(entry.Frame), message));
+    }
+  }
+}
+
+unsigned int mitk::USImageRecordingReader::GetNumberOfFrames() const
+{
+  return m_Frames.size();
+}
+
+const mitk::USImageRecordingWriter::IndexEntry& mitk::USImageRecordingReader::GetFrameEntry(unsigned int frame) const
+{
+  if ( frame >= m_Frames.size() )
+  {
+    mitkThrow() << "Frame " << frame << " does not exist, the recording has " << m_Frames.size() << " frames.";
+  }
+  return m_Frames[frame];
+}
+
+mitk::Image::Pointer mitk::USImageRecordingReader::GetFrame(unsigned int frame) const
+{
+  const USImageRecordingWriter::IndexEntry& entry = this->GetFrameEntry(frame);
+
+  mitk::MemoryMappedFile::Pointer mappedFile = mitk::MemoryMappedFile::New();
+  if ( ! mappedFile->Map(m_FileName, entry.Offset, entry.Size) )
+  {
+    mitkThrow() << "Could not map frame " << frame << " of " << m_FileName;
+  }
+
+  unsigned int dimensions[3] = { entry.Dimensions[0], entry.Dimensions[1], entry.Dimensions[2] };
+  mitk::Image::Pointer image = mitk::Image::New();
+  image->Initialize(GetPixelType(entry.PixelType), entry.Dimension, dimensions);
+
+  mitk::Vector3D spacing;
+  spacing[0] = entry.Spacing[0];
+  spacing[1] = entry.Spacing[1];
+  spacing[2] = entry.Spacing[2];
+  image->GetGeometry()->SetSpacing(spacing);
+
+  // the image keeps the file mapped as long as it exists
+  if ( ! image->SetMappedChannel(mappedFile) )
+  {
+    mitkThrow() << "Could not use the mapped data of frame " << frame << " of " << m_FileName;
+  }
+  return image;
+}
+
+double mitk::USImageRecordingReader::GetTimeStamp(unsigned int frame) const
+{
+  return this->GetFrameEntry(frame).TimeStamp;
+}
+
+std::vector<std::string> mitk::USImageRecordingReader::GetMessages(unsigned int frame) const
+{
+  std::vector<std::string> messages;
+  typedef std::multimap<unsigned int, std::string>::const_iterator MessageIterator;
+  std::pair<MessageIterator, MessageIterator> range = m_Messages.equal_range(frame);
+  for ( MessageIterator it = range.first; it != range.second; ++it )
+  {
+    messages.push_back(it->second);
+  }
+  return messages;
+}
@@ -0,0 +1,80 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKUSImageRecordingReader_H_HEADER_INCLUDED_
+#define MITKUSImageRecordingReader_H_HEADER_INCLUDED_
+
+// MITK
+#include <MitkUSExports.h>
+#include "mitkUSImageRecordingWriter.h"
+#include <mitkMemoryMappedFile.h>
+
+#include <map>
+
+namespace mitk {
+  /**
+  * \brief Plays back a recording written by mitk::USImageRecordingWriter.
+  *
+  * Only the index of the recording is read when opening it. The pixel data
+  * of a frame is memory mapped when the frame is requested, so the images
+  * returned by GetFrame() use the file directly and the operating system only
+  * loads the parts which are actually accessed.
+  *
+  * A recording which is still being written can be opened; it contains the
+  * frames written up to the time of opening.
+  *
+  * \ingroup US
+  */
+  class MitkUS_EXPORT USImageRecordingReader : public itk::Object
+  {
+  public:
+    mitkClassMacro(USImageRecordingReader, itk::Object);
+    itkNewMacro(Self);
+
+    /**
+    * \brief Reads the index of the given recording.
+    * \throw mitk::Exception if the file is not a recording or cannot be read
+    */
+    void Open(const std::string& fileName);
+
+    unsigned int GetNumberOfFrames() const;
+
+    /**
+    * \brief Returns the given frame as image which references the memory mapped pixel data.
+    * \throw mitk::Exception if the frame does not exist or cannot be mapped
+    */
+    mitk::Image::Pointer GetFrame(unsigned int frame) const;
+
+    /** \brief Timestamp of the given frame in milliseconds, see mitk::RealTimeClock. */
+    double GetTimeStamp(unsigned int frame) const;
+
+    /** \brief Messages added to the given frame, in the order they were added. */
+    std::vector<std::string> GetMessages(unsigned int frame) const;
+
+  protected:
+    USImageRecordingReader();
+    virtual ~USImageRecordingReader();
+
+    const USImageRecordingWriter::IndexEntry& GetFrameEntry(unsigned int frame) const;
+
+  private:
+    std::string                                  m_FileName;
+    std::vector<USImageRecordingWriter::IndexEntry> m_Frames;
+    std::multimap<unsigned int, std::string>     m_Messages;
+  };
+} // namespace mitk
+
+#endif // MITKUSImageRecordingReader_H_HEADER_INCLUDED_
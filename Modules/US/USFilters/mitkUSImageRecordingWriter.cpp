@@ -0,0 +1,326 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkUSImageRecordingWriter.h"
+
+#include <mitkImageReadAccessor.h>
+#include <mitkException.h>
+#include <itkRGBPixel.h>
+
+#include <cstring>
+
+const char* mitk::USImageRecordingWriter::FILE_EXTENSION = ".usrec";
+const char* mitk::USImageRecordingWriter::INDEX_FILE_EXTENSION = ".idx";
+
+const char* mitk::USImageRecordingWriter::DATA_FILE_IDENTIFIER = "MITKUSR";
+const char* mitk::USImageRecordingWriter::INDEX_FILE_IDENTIFIER = "MITKUSI";
+const itk::uint32_t mitk::USImageRecordingWriter::FILE_VERSION = 1;
+
+namespace
+{
+  void WriteHeader(std::ofstream& file, const char* identifier)
+  {
+    char header[mitk::USImageRecordingWriter::HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+    memcpy(header, identifier, strlen(identifier));
+    memcpy(header + 8, &mitk::USImageRecordingWriter::FILE_VERSION, sizeof(itk::uint32_t));
+    file.write(header, sizeof(header));
+  }
+}
+
+mitk::USImageRecordingWriter::PixelTypeCode mitk::USImageRecordingWriter::GetPixelTypeCode(const mitk::PixelType& pixelType)
+{
+  if ( pixelType == mitk::MakeScalarPixelType<unsigned char>() ) { return UCharPixelType; }
+  if ( pixelType == mitk::MakeScalarPixelType<char>() ) { return CharPixelType; }
+  if ( pixelType == mitk::MakeScalarPixelType<unsigned short>() ) { return UShortPixelType; }
+  if ( pixelType == mitk::MakeScalarPixelType<short>() ) { return ShortPixelType; }
+  if ( pixelType == mitk::MakeScalarPixelType<float>() ) { return FloatPixelType; }
+  if ( pixelType == mitk::MakeScalarPixelType<double>() ) { return DoublePixelType; }
+  if ( pixelType == mitk::MakePixelType<itk::Image<itk::RGBPixel<unsigned char>, 2> >() ) { return RGBUCharPixelType; }
+  return UnknownPixelType;
+}
+
+mitk::USImageRecordingWriter::USImageRecordingWriter()
+  : m_DataOffset(0),
+    m_MaximumQueueSize(64),
+    m_BlockWhenQueueIsFull(false),
+    m_StopWriting(false),
+    m_QueueChanged(itk::ConditionVariable::New()),
+    m_MultiThreader(itk::MultiThreader::New()),
+    m_ThreadID(-1),
+    m_NumberOfFrames(0),
+    m_NumberOfWrittenFrames(0),
+    m_NumberOfDroppedFrames(0),
+    m_MaximumQueueFill(0),
+    m_BlockingTime(0),
+    m_Clock(mitk::RealTimeClock::New())
+{
+}
+
+mitk::USImageRecordingWriter::~USImageRecordingWriter()
+{
+  this->Close();
+
+  for ( std::vector<std::vector<char>*>::iterator it = m_FreeBuffers.begin(); it != m_FreeBuffers.end(); ++it )
+  {
+    delete *it;
+  }
+}
+
+void mitk::USImageRecordingWriter::Open(const std::string& fileName)
+{
+  this->Close();
+
+  m_DataFile.open(fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  m_IndexFile.open((fileName + INDEX_FILE_EXTENSION).c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if ( ! m_DataFile.is_open() || ! m_IndexFile.is_open() )
+  {
+    m_DataFile.close();
+    m_IndexFile.close();
+    mitkThrow() << "Could not create the recording " << fileName;
+  }
+
+  WriteHeader(m_DataFile, DATA_FILE_IDENTIFIER);
+  WriteHeader(m_IndexFile, INDEX_FILE_IDENTIFIER);
+  m_DataOffset = HEADER_SIZE;
+
+  m_FileName = fileName;
+  m_StopWriting = false;
+  m_NumberOfFrames = 0;
+  m_NumberOfWrittenFrames = 0;
+  m_NumberOfDroppedFrames = 0;
+  m_MaximumQueueFill = 0;
+  m_BlockingTime = 0;
+
+  m_ThreadID = m_MultiThreader->SpawnThread(WriterThread, this);
+}
+
+void mitk::USImageRecordingWriter::Close()
+{
+  if ( m_ThreadID < 0 ) { return; }
+
+  // the writer thread leaves as soon as the queue is empty
+  m_QueueMutex.Lock();
+  m_StopWriting = true;
+  m_QueueChanged->Broadcast();
+  m_QueueMutex.Unlock();
+
+  m_MultiThreader->TerminateThread(m_ThreadID);
+  m_ThreadID = -1;
+
+  m_DataFile.close();
+  m_IndexFile.close();
+  if ( m_DataFile.fail() || m_IndexFile.fail() )
+  {
+    MITK_ERROR("USImageRecordingWriter") << "Error while writing the recording " << m_FileName;
+  }
+}
+
+bool mitk::USImageRecordingWriter::GetIsOpen() const
+{
+  return m_ThreadID >= 0;
+}
+
+bool mitk::USImageRecordingWriter::AddFrame(const mitk::Image* image, double timeStamp)
+{
+  if ( m_ThreadID < 0 || image == NULL || ! image->IsInitialized() ) { return false; }
+
+  PixelTypeCode pixelType = GetPixelTypeCode(image->GetPixelType());
+  if ( pixelType == UnknownPixelType )
+  {
+    MITK_WARN("USImageRecordingWriter") << "Images of pixel type " << image->GetPixelType().GetTypeAsString() << " cannot be recorded.";
+    return false;
+  }
+
+  QueueItem item;
+  memset(&item.Entry, 0, sizeof(IndexEntry));
+  item.Entry.Type = FrameRecord;
+  item.Entry.TimeStamp = timeStamp;
+  item.Entry.PixelType = pixelType;
+  item.Entry.Dimension = image->GetDimension() < 3 ? image->GetDimension() : 3;
+  item.Entry.Size = image->GetPixelType().GetSize();
+  for ( unsigned int i = 0; i < 3; ++i )
+  {
+    item.Entry.Dimensions[i] = i < item.Entry.Dimension ? image->GetDimension(i) : 1;
+    item.Entry.Spacing[i] = image->GetGeometry()->GetSpacing()[i];
+    item.Entry.Size *= item.Entry.Dimensions[i];
+  }
+
+  // acquired before locking, the accessor may throw
+  mitk::ImageReadAccessor imageReadAccessor(image);
+
+  m_QueueMutex.Lock();
+
+  if ( m_Queue.size() >= m_MaximumQueueSize )
+  {
+    if ( ! m_BlockWhenQueueIsFull )
+    {
+      ++m_NumberOfDroppedFrames;
+      m_QueueMutex.Unlock();
+      return false;
+    }
+
+    double start = m_Clock->GetCurrentStamp();
+    while ( m_Queue.size() >= m_MaximumQueueSize )
+    {
+      m_QueueChanged->Wait(&m_QueueMutex);
+    }
+    m_BlockingTime += m_Clock->GetCurrentStamp() - start;
+  }
+
+  if ( m_FreeBuffers.empty() )
+  {
+    item.Data = new std::vector<char>();
+  }
+  else
+  {
+    item.Data = m_FreeBuffers.back();
+    m_FreeBuffers.pop_back();
+  }
+  item.Entry.Frame = m_NumberOfFrames++;
+
+  // the lock is held until the item is queued, so that frames of concurrent
+  // callers and messages for them are queued in the order of their numbers
+  item.Data->resize(item.Entry.Size);
+  memcpy(&(*item.Data)[0], imageReadAccessor.GetData(), item.Entry.Size);
+
+  m_Queue.push_back(item);
+  if ( m_Queue.size() > m_MaximumQueueFill ) { m_MaximumQueueFill = m_Queue.size(); }
+  m_QueueChanged->Broadcast();
+  m_QueueMutex.Unlock();
+
+  return true;
+}
+
+void mitk::USImageRecordingWriter::AddMessage(const std::string& message, double timeStamp)
+{
+  if ( m_ThreadID < 0 ) { return; }
+
+  QueueItem item;
+  memset(&item.Entry, 0, sizeof(IndexEntry));
+  item.Entry.Type = MessageRecord;
+  item.Entry.TimeStamp = timeStamp;
+  item.Entry.Size = message.size();
+  item.Data = NULL;
+  item.Message = message;
+
+  // messages are small and never dropped
+  m_QueueMutex.Lock();
+  if ( m_NumberOfFrames == 0 )
+  {
+    m_QueueMutex.Unlock();
+    MITK_WARN("USImageRecordingWriter") << "No frame recorded yet, message is ignored.";
+    return;
+  }
+  item.Entry.Frame = m_NumberOfFrames - 1;
+  m_Queue.push_back(item);
+  m_QueueChanged->Broadcast();
+  m_QueueMutex.Unlock();
+}
+
+unsigned int mitk::USImageRecordingWriter::GetNumberOfFrames() const
+{
+  m_QueueMutex.Lock();
+  unsigned int value = m_NumberOfFrames;
+  m_QueueMutex.Unlock();
+  return value;
+}
+
+unsigned int mitk::USImageRecordingWriter::GetNumberOfWrittenFrames() const
+{
+  m_QueueMutex.Lock();
+  unsigned int value = m_NumberOfWrittenFrames;
+  m_QueueMutex.Unlock();
+  return value;
+}
+
+unsigned int mitk::USImageRecordingWriter::GetNumberOfDroppedFrames() const
+{
+  m_QueueMutex.Lock();
+  unsigned int value = m_NumberOfDroppedFrames;
+  m_QueueMutex.Unlock();
+  return value;
+}
+
+unsigned int mitk::USImageRecordingWriter::GetMaximumQueueFill() const
+{
+  m_QueueMutex.Lock();
+  unsigned int value = m_MaximumQueueFill;
+  m_QueueMutex.Unlock();
+  return value;
+}
+
+double mitk::USImageRecordingWriter::GetBlockingTime() const
+{
+  m_QueueMutex.Lock();
+  double value = m_BlockingTime;
+  m_QueueMutex.Unlock();
+  return value;
+}
+
+void mitk::USImageRecordingWriter::Write(const QueueItem& item)
+{
+  IndexEntry entry = item.Entry;
+  entry.Offset = m_DataOffset;
+
+  if ( item.Entry.Type == FrameRecord ) { m_DataFile.write(&(*item.Data)[0], entry.Size); }
+  else { m_DataFile.write(item.Message.data(), entry.Size); }
+  m_DataOffset += entry.Size;
+
+  m_IndexFile.write(reinterpret_cast<const char*>(&entry), sizeof(IndexEntry));
+}
+
+ITK_THREAD_RETURN_TYPE mitk::USImageRecordingWriter::WriterThread(void* pInfoStruct)
+{
+  /* extract this pointer from Thread Info structure */
+  struct itk::MultiThreader::ThreadInfoStruct * pInfo = (struct itk::MultiThreader::ThreadInfoStruct*)pInfoStruct;
+  mitk::USImageRecordingWriter* writer = (mitk::USImageRecordingWriter*) pInfo->UserData;
+
+  writer->m_QueueMutex.Lock();
+  while ( true )
+  {
+    if ( writer->m_Queue.empty() )
+    {
+      // everything queued is on disk (at least for the operating system)
+      // before waiting, so the recording can be read while it is written
+      writer->m_QueueMutex.Unlock();
+      writer->m_DataFile.flush();
+      writer->m_IndexFile.flush();
+      writer->m_QueueMutex.Lock();
+
+      if ( writer->m_StopWriting && writer->m_Queue.empty() ) { break; }
+      if ( writer->m_Queue.empty() ) { writer->m_QueueChanged->Wait(&writer->m_QueueMutex); }
+      continue;
+    }
+
+    QueueItem item = writer->m_Queue.front();
+    writer->m_Queue.pop_front();
+    writer->m_QueueChanged->Broadcast();
+    writer->m_QueueMutex.Unlock();
+
+    writer->Write(item);
+
+    writer->m_QueueMutex.Lock();
+    if ( item.Data != NULL )
+    {
+      writer->m_FreeBuffers.push_back(item.Data);
+      ++writer->m_NumberOfWrittenFrames;
+    }
+  }
+  writer->m_QueueMutex.Unlock();
+
+  return ITK_THREAD_RETURN_VALUE;
+}
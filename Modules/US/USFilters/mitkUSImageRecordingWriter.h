@@ -0,0 +1,200 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKUSImageRecordingWriter_H_HEADER_INCLUDED_
+#define MITKUSImageRecordingWriter_H_HEADER_INCLUDED_
+
+// MITK
+#include <MitkUSExports.h>
+#include <mitkCommon.h>
+#include <mitkImage.h>
+#include <mitkRealTimeClock.h>
+
+// ITK
+#include <itkObject.h>
+#include <itkObjectFactory.h>
+#include <itkIntTypes.h>
+#include <itkNumericTraits.h>
+#include <itkMultiThreader.h>
+#include <itkConditionVariable.h>
+#include <itkMutexLock.h>
+
+#include <deque>
+#include <fstream>
+
+namespace mitk {
+  /**
+  * \brief Streams ultrasound frames, their timestamps and messages to disk
+  * in a background thread.
+  *
+  * A recording consists of two append-only files: the data file given to
+  * Open() holds the raw pixel data of the frames and the text of the
+  * messages, the index file (data file name + INDEX_FILE_EXTENSION) holds one
+  * IndexEntry per frame or message. Both files start with a header of
+  * HEADER_SIZE bytes.
+  * Entries are only appended to the index after the data they refer to, so a
+  * recording which was interrupted can still be read up to the last complete
+  * entry. Use mitk::USImageRecordingReader for playback.
+  *
+  * AddFrame() copies the frame into a queue, from which the writer thread
+  * writes it. The queue holds at most MaximumQueueSize frames. If it is full,
+  * AddFrame() either waits for the writer thread (BlockWhenQueueIsFull) or
+  * drops the frame; both are counted. AddFrame() and AddMessage() may be
+  * called from several threads, entries are written in the order in which
+  * the frames got their numbers.
+  *
+  * \ingroup US
+  */
+  class MitkUS_EXPORT USImageRecordingWriter : public itk::Object
+  {
+  public:
+    mitkClassMacro(USImageRecordingWriter, itk::Object);
+    itkNewMacro(Self);
+
+    static const char* FILE_EXTENSION;        ///< ".usrec"
+    static const char* INDEX_FILE_EXTENSION;  ///< ".idx", appended to the file name of the data file
+    static const char* DATA_FILE_IDENTIFIER;  ///< "MITKUSR", first bytes of the data file header
+    static const char* INDEX_FILE_IDENTIFIER; ///< "MITKUSI", first bytes of the index file header
+    static const itk::uint32_t FILE_VERSION;  ///< stored behind the identifier in both headers
+
+    enum { HEADER_SIZE = 16 };
+
+    enum RecordType
+    {
+      FrameRecord = 1,
+      MessageRecord = 2
+    };
+
+    /**
+    * \brief Pixel types which can be recorded.
+    */
+    enum PixelTypeCode
+    {
+      UnknownPixelType = 0,
+      UCharPixelType,
+      CharPixelType,
+      UShortPixelType,
+      ShortPixelType,
+      FloatPixelType,
+      DoublePixelType,
+      RGBUCharPixelType
+    };
+
+    /**
+    * \brief One entry of the index file.
+    */
+    struct IndexEntry
+    {
+      itk::uint64_t Offset;         ///< position of the data in the data file
+      itk::uint64_t Size;           ///< number of bytes in the data file
+      double        TimeStamp;      ///< milliseconds, see mitk::RealTimeClock
+      double        Spacing[3];     ///< frames only
+      itk::uint32_t Type;           ///< RecordType
+      itk::uint32_t PixelType;      ///< PixelTypeCode, frames only
+      itk::uint32_t Dimension;      ///< frames only
+      itk::uint32_t Dimensions[3];  ///< frames only
+      itk::uint32_t Frame;          ///< number of the frame (counting from 0) or of the frame a message belongs to
+      itk::uint32_t Reserved;
+    };
+
+    /** \brief Returns the code of the given pixel type or UnknownPixelType if it cannot be recorded. */
+    static PixelTypeCode GetPixelTypeCode(const mitk::PixelType& pixelType);
+
+    /**
+    * \brief Creates (or overwrites) the files of a recording and starts the writer thread.
+    * \throw mitk::Exception if the files cannot be created
+    */
+    void Open(const std::string& fileName);
+
+    /**
+    * \brief Waits until all queued frames are written, stops the writer thread and closes the files.
+    */
+    void Close();
+
+    bool GetIsOpen() const;
+
+    /**
+    * \brief Queues a copy of the first time step of the given image.
+    * \return false if the frame was dropped or cannot be recorded
+    */
+    bool AddFrame(const mitk::Image* image, double timeStamp);
+
+    /**
+    * \brief Queues a message for the frame added last.
+    */
+    void AddMessage(const std::string& message, double timeStamp);
+
+    itkSetClampMacro(MaximumQueueSize, unsigned int, 1, itk::NumericTraits<unsigned int>::max());
+    itkGetConstMacro(MaximumQueueSize, unsigned int);
+    itkSetMacro(BlockWhenQueueIsFull, bool);
+    itkGetConstMacro(BlockWhenQueueIsFull, bool);
+    itkBooleanMacro(BlockWhenQueueIsFull);
+
+    /** \brief Number of frames accepted by AddFrame() since Open(). */
+    unsigned int GetNumberOfFrames() const;
+    /** \brief Number of frames written to disk since Open(). */
+    unsigned int GetNumberOfWrittenFrames() const;
+    /** \brief Number of frames dropped because the queue was full. */
+    unsigned int GetNumberOfDroppedFrames() const;
+    /** \brief Highest number of frames waiting in the queue at once. */
+    unsigned int GetMaximumQueueFill() const;
+    /** \brief Total time AddFrame() waited for a full queue, in milliseconds. */
+    double GetBlockingTime() const;
+
+  protected:
+    USImageRecordingWriter();
+    virtual ~USImageRecordingWriter();
+
+    struct QueueItem
+    {
+      IndexEntry         Entry;
+      std::vector<char>* Data;     ///< pixel data of a frame, taken from m_FreeBuffers
+      std::string        Message;
+    };
+
+    static ITK_THREAD_RETURN_TYPE WriterThread(void* pInfoStruct);
+
+    /** \brief Writes one item, called by the writer thread without holding the queue mutex. */
+    void Write(const QueueItem& item);
+
+  private:
+    std::string                      m_FileName;
+    std::ofstream                    m_DataFile;
+    std::ofstream                    m_IndexFile;
+    itk::uint64_t                    m_DataOffset;
+
+    unsigned int                     m_MaximumQueueSize;
+    bool                             m_BlockWhenQueueIsFull;
+
+    std::deque<QueueItem>            m_Queue;
+    std::vector<std::vector<char>*>  m_FreeBuffers;
+    bool                             m_StopWriting;
+    mutable itk::SimpleMutexLock     m_QueueMutex;
+    itk::ConditionVariable::Pointer  m_QueueChanged;      ///< signaled on new items and on written items
+
+    itk::MultiThreader::Pointer      m_MultiThreader;
+    int                              m_ThreadID;
+
+    unsigned int                     m_NumberOfFrames;
+    unsigned int                     m_NumberOfWrittenFrames;
+    unsigned int                     m_NumberOfDroppedFrames;
+    unsigned int                     m_MaximumQueueFill;
+    double                           m_BlockingTime;
+    mitk::RealTimeClock::Pointer     m_Clock;
+  };
+} // namespace mitk
+
+#endif // MITKUSImageRecordingWriter_H_HEADER_INCLUDED_
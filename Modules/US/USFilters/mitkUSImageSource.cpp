@@ -16,6 +16,10 @@ See LICENSE.txt or http://www.mitk.org for details.
 
 #include "mitkUSImageSource.h"
 #include "mitkProperties.h"
+#include "mitkImageWriteAccessor.h"
+
+#include <itkRGBPixel.h>
+#include <cstring>
 
 const char* mitk::USImageSource::IMAGE_PROPERTY_IDENTIFIER = "id_nummer";
 
@@ -23,7 +27,8 @@ mitk::USImageSource::USImageSource()
 : m_OpenCVToMitkFilter(mitk::OpenCVToMitkImageFilter::New()),
   m_MitkToOpenCVFilter(0),
   m_ImageFilter(mitk::BasicCombinationOpenCVImageFilter::New()),
-  m_CurrentImageId(0)
+  m_CurrentImageId(0),
+  m_RingBuffer(mitk::USImageRingBuffer::New())
 {
 }
 
@@ -89,6 +94,105 @@ mitk::Image::Pointer mitk::USImageSource::GetNextImage()
   }
 }
 
+bool mitk::USImageSource::GrabNextImage()
+{
+  // a frame without free slot is grabbed nevertheless, so that the
+  // acquisition keeps the pace of the device
+  bool hasSlot = m_RingBuffer->BeginWrite();
+  mitk::Image::Pointer& image = hasSlot ? m_RingBuffer->GetWriteImage() : m_DroppedImage;
+
+  // subclasses may write into the given image or replace it
+  const mitk::Image* previousImage = image.GetPointer();
+  unsigned long previousMTime = image.IsNotNull() ? image->GetMTime() : 0;
+
+  if ( m_ImageFilter.IsNotNull() && ! m_ImageFilter->GetIsEmpty() )
+  {
+    this->GetNextRawImage(m_FilterImage);
+
+    if ( ! m_FilterImage.empty() )
+    {
+      m_ImageFilter->FilterImage(m_FilterImage, m_CurrentImageId);
+      this->CopyOpenCVImage(m_FilterImage, image);
+    }
+  }
+  else
+  {
+    this->GetNextRawImage(image);
+  }
+
+  bool isValid = image.IsNotNull() && image->IsInitialized()
+    && ( image.GetPointer() != previousImage || image->GetMTime() != previousMTime );
+
+  if ( isValid )
+  {
+    mitk::IntProperty* idProperty = dynamic_cast<mitk::IntProperty*>(image->GetProperty(IMAGE_PROPERTY_IDENTIFIER).GetPointer());
+    if ( idProperty ) { idProperty->SetValue(m_CurrentImageId); }
+    else { image->SetProperty(IMAGE_PROPERTY_IDENTIFIER, mitk::IntProperty::New(m_CurrentImageId)); }
+    m_CurrentImageId++;
+  }
+
+  if ( hasSlot ) { m_RingBuffer->EndWrite(isValid); }
+
+  return hasSlot && isValid;
+}
+
+void mitk::USImageSource::CopyOpenCVImage( const cv::Mat& cvImage, mitk::Image::Pointer& image )
+{
+  int type = cvImage.type();
+  if ( type != CV_8UC1 && type != CV_8UC3 && type != CV_16UC1 && type != CV_32FC1 )
+  {
+    // the remaining types are uncommon for ultrasound images and are
+    // converted into a new image
+    m_OpenCVToMitkFilter->SetOpenCVMat(cvImage);
+    m_OpenCVToMitkFilter->Update();
+    image = m_OpenCVToMitkFilter->GetOutput();
+    return;
+  }
+
+  mitk::PixelType pixelType =
+    type == CV_8UC1 ? mitk::MakeScalarPixelType<unsigned char>()
+    : type == CV_16UC1 ? mitk::MakeScalarPixelType<unsigned short>()
+    : type == CV_32FC1 ? mitk::MakeScalarPixelType<float>()
+    : mitk::MakePixelType<itk::Image<itk::RGBPixel<unsigned char>, 2> >();
+
+  if ( image.IsNull() ) { image = mitk::Image::New(); }
+
+  if ( ! image->IsInitialized() || image->GetPixelType() != pixelType
+    || image->GetDimension(0) != static_cast<unsigned int>(cvImage.cols)
+    || image->GetDimension(1) != static_cast<unsigned int>(cvImage.rows) )
+  {
+    unsigned int dimensions[2] = { static_cast<unsigned int>(cvImage.cols), static_cast<unsigned int>(cvImage.rows) };
+    image->Initialize(pixelType, 2, dimensions);
+  }
+
+  {
+    mitk::ImageWriteAccessor imageWriteAccessor(image, image->GetVolumeData(0));
+    unsigned char* target = static_cast<unsigned char*>(imageWriteAccessor.GetData());
+    const size_t rowSize = cvImage.cols * cvImage.elemSize();
+
+    for ( int row = 0; row < cvImage.rows; ++row, target += rowSize )
+    {
+      const unsigned char* source = cvImage.ptr<unsigned char>(row);
+      if ( type == CV_8UC3 )
+      {
+        // OpenCV stores the channels in BGR order
+        for ( size_t i = 0; i < rowSize; i += 3 )
+        {
+          target[i]     = source[i + 2];
+          target[i + 1] = source[i + 1];
+          target[i + 2] = source[i];
+        }
+      }
+      else
+      {
+        memcpy(target, source, rowSize);
+      }
+    }
+  }
+
+  image->Modified();
+}
+
 void mitk::USImageSource::GetNextRawImage( cv::Mat& image )
 {
   // create filter object if it does not exist yet
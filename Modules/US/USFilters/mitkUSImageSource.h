@@ -26,6 +26,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 #include "mitkBasicCombinationOpenCVImageFilter.h"
 #include "mitkOpenCVToMitkImageFilter.h"
 #include "mitkImageToOpenCVImageFilter.h"
+#include "mitkUSImageRingBuffer.h"
 
 // OpenCV
 #include "cv.h"
@@ -38,6 +39,10 @@ namespace mitk {
   * get the next image from the image source. This image will be filtered by
   * the filter set with mitk::USImageSource::SetImageFilter().
   *
+  * For continuous acquisition mitk::USImageSource::GrabNextImage() writes the
+  * next image directly into a slot of the mitk::USImageRingBuffer of the
+  * source, from which any number of consumers can read it without copying.
+  *
   * \ingroup US
   */
   class MitkUS_EXPORT USImageSource : public itk::Object
@@ -62,6 +67,24 @@ namespace mitk {
     */
     mitk::Image::Pointer GetNextImage( );
 
+    /**
+    * \brief Writes the next frame directly into the ring buffer of this
+    * image source. The frame is filtered if a filter was set by
+    * mitk::USImageSource::SetImageFilter().
+    *
+    * The images of the ring buffer slots are reused, subclasses are expected
+    * to write into the given image in mitk::USImageSource::GetNextRawImage()
+    * instead of creating a new one for every frame.
+    *
+    * \return false if the frame was dropped because no slot was available or no image was received
+    */
+    bool GrabNextImage( );
+
+    /**
+    * \brief Ring buffer holding the last frames grabbed by mitk::USImageSource::GrabNextImage().
+    */
+    itkGetMacro(RingBuffer, mitk::USImageRingBuffer::Pointer);
+
   protected:
     USImageSource();
     virtual ~USImageSource();
@@ -81,6 +104,14 @@ namespace mitk {
     */
     virtual void GetNextRawImage( mitk::Image::Pointer& ) = 0;
 
+    /**
+    * \brief Copies the given OpenCV image into the given mitk::Image.
+    * The image is only initialized again if its size or pixel type differs
+    * from the OpenCV image, so the memory of the image is reused for all
+    * frames of the same size. Color images are converted from BGR to RGB.
+    */
+    void CopyOpenCVImage( const cv::Mat& cvImage, mitk::Image::Pointer& image );
+
     /**
     * \brief Used to convert from OpenCV Images to MITK Images.
     */
@@ -97,6 +128,10 @@ namespace mitk {
     BasicCombinationOpenCVImageFilter::Pointer m_ImageFilter;
 
     int                                        m_CurrentImageId;
+
+    mitk::USImageRingBuffer::Pointer           m_RingBuffer;
+    cv::Mat                                    m_FilterImage;  ///< reused for the filtered frames of GrabNextImage()
+    mitk::Image::Pointer                       m_DroppedImage; ///< receives the frames for which no ring buffer slot was available
   };
 } // namespace mitk
 #endif /* MITKUSImageSource_H_HEADER_INCLUDED_ */
@@ -198,15 +198,10 @@ void mitk::USImageVideoSource::GetNextRawImage( mitk::Image::Pointer& image )
   cv::Mat cv_img;
 
   this->GetNextRawImage(cv_img);
+  if ( cv_img.empty() ) { return; }
 
-  // convert to MITK-Image
-  IplImage ipl_img = cv_img;
-
-  this->m_OpenCVToMitkFilter->SetOpenCVImage(&ipl_img);
-  this->m_OpenCVToMitkFilter->Update();
-
-  // OpenCVToMitkImageFilter returns a standard mitk::image. We then transform it into an USImage
-  image = this->m_OpenCVToMitkFilter->GetOutput();
+  // copy into the given image, which keeps its memory if the size did not change
+  this->CopyOpenCVImage(cv_img, image);
 
   // clean up
   cv_img.release();
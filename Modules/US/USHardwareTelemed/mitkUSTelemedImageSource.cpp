@@ -40,8 +40,13 @@ void mitk::USTelemedImageSource::GetNextRawImage( mitk::Image::Pointer& image)
   {
     m_ImageMutex->Lock();
 
-    // copy contents of the given image into the member variable
-    image->Initialize(m_Image->GetPixelType(), m_Image->GetDimension(), m_Image->GetDimensions());
+    // copy contents of the member variable into the given image, which is
+    // only initialized again if the size or pixel type changed
+    if ( ! image->IsInitialized() || image->GetPixelType() != m_Image->GetPixelType()
+      || image->GetDimension(0) != m_Image->GetDimension(0) || image->GetDimension(1) != m_Image->GetDimension(1) )
+    {
+      image->Initialize(m_Image->GetPixelType(), m_Image->GetDimension(), m_Image->GetDimensions());
+    }
     mitk::ImageReadAccessor inputReadAccessor(m_Image, m_Image->GetSliceData(0,0,0));
     image->SetSlice(inputReadAccessor.GetData());
 
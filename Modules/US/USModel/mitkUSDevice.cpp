@@ -50,7 +50,6 @@ mitk::USDevice::USDevice(std::string manufacturer, std::string model)
   m_Name(model),
   m_SpawnAcquireThread(true),
   m_MultiThreader(itk::MultiThreader::New()),
-  m_ImageMutex(itk::FastMutexLock::New()),
   m_ThreadID(-1),
   m_UnregisteringStarted(false)
 {
@@ -75,7 +74,6 @@ mitk::USDevice::USDevice(mitk::USImageMetadata::Pointer metadata)
   m_DeviceState(State_NoState),
   m_SpawnAcquireThread(true),
   m_MultiThreader(itk::MultiThreader::New()),
-  m_ImageMutex(itk::FastMutexLock::New()),
   m_ThreadID(-1),
   m_UnregisteringStarted(false)
 {
@@ -459,10 +457,9 @@ output->Graft( graft );
 
 void mitk::USDevice::GrabImage()
 {
-  mitk::Image::Pointer image = this->GetUSImageSource()->GetNextImage();
-  m_ImageMutex->Lock();
-  this->SetImage(image);
-  m_ImageMutex->Unlock();
+  // the image source writes directly into its ring buffer, from which
+  // GenerateData() gets the latest frame without locking
+  this->GetUSImageSource()->GrabNextImage();
 }
 
 //########### GETTER & SETTER ##################//
@@ -496,22 +493,30 @@ std::string mitk::USDevice::GetDeviceComment(){
 
 void mitk::USDevice::GenerateData()
 {
-  m_ImageMutex->Lock();
-
-  if ( m_Image.IsNull() || ! m_Image->IsInitialized() ) { m_ImageMutex->Unlock(); return; }
+  mitk::USImageSource::Pointer imageSource = this->GetUSImageSource();
+  if ( imageSource.IsNull() ) { return; }
 
   mitk::Image::Pointer output = this->GetOutput();
-
-  if ( ! output->IsInitialized()
-    || output->GetDimension(0) != m_Image->GetDimension(0) || output->GetDimension(1) != m_Image->GetDimension(1) )
+  if ( m_OutputFrameHolder.IsNull() || m_OutputFrameHolder->Output != output.GetPointer() )
   {
-    output->Initialize(m_Image->GetPixelType(), m_Image->GetDimension(), m_Image->GetDimensions());
+    m_OutputFrameHolder = OutputFrameHolder::New();
+    m_OutputFrameHolder->Output = output;
+    output->AddObserver(itk::DeleteEvent(), m_OutputFrameHolder);
   }
 
-  mitk::ImageReadAccessor inputReadAccessor(m_Image, m_Image->GetSliceData(0,0,0));
-  output->SetSlice(inputReadAccessor.GetData());
+  mitk::USImageRingBuffer::Frame frame = imageSource->GetRingBuffer()->GetLatestFrame();
+  if ( ! frame.IsValid() || frame.GetFrameNumber() == m_OutputFrameHolder->Frame.GetFrameNumber() ) { return; }
+
+  mitk::Image* image = frame.GetImage();
+
+  // initializing drops the reference on the memory of the previous frame, then
+  // the output references the memory of the ring buffer slot without copying it
+  output->Initialize(image->GetPixelType(), image->GetDimension(), image->GetDimensions());
+  mitk::ImageReadAccessor inputReadAccessor(image);
+  output->SetImportVolume(const_cast<void*>(inputReadAccessor.GetData()), 0, 0, mitk::Image::ReferenceMemory);
 
-  m_ImageMutex->Unlock();
+  // the slot is not written again while the output references it
+  m_OutputFrameHolder->Frame = frame;
 };
 
 std::string mitk::USDevice::GetServicePropertyLabel()
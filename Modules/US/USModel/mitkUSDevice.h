@@ -33,6 +33,7 @@ See LICENSE.txt or http://www.mitk.org for details.
 // ITK
 #include <itkObjectFactory.h>
 #include <itkConditionVariable.h>
+#include <itkCommand.h>
 
 // Microservices
 #include <usServiceInterface.h>
@@ -294,14 +295,12 @@ class USControlInterfaceDoppler;
     virtual USImageSource::Pointer GetUSImageSource() = 0;
 
   protected:
-    itkSetMacro(Image, mitk::Image::Pointer);
     itkSetMacro(SpawnAcquireThread, bool);
     itkGetMacro(SpawnAcquireThread, bool);
 
     static ITK_THREAD_RETURN_TYPE Acquire(void* pInfoStruct);
     static ITK_THREAD_RETURN_TYPE ConnectThread(void* pInfoStruct);
 
-    mitk::Image::Pointer m_Image;
     mitk::Image::Pointer m_OutputImage;
 
     bool m_IsFreezed;
@@ -396,6 +395,8 @@ class USControlInterfaceDoppler;
     /**
     * \brief Grabs the next frame from the Video input.
     * This method is called internally, whenever Update() is invoked by an Output.
+    * The output references the memory of the latest ring buffer frame instead of
+    * copying it, so it must not be modified and changes with the next update.
     */
     virtual void GenerateData();
 
@@ -423,10 +424,32 @@ class USControlInterfaceDoppler;
     itk::ConditionVariable::Pointer m_FreezeBarrier;
     itk::SimpleMutexLock        m_FreezeMutex;
     itk::MultiThreader::Pointer m_MultiThreader; ///< itk::MultiThreader used for thread handling
-    itk::FastMutexLock::Pointer m_ImageMutex; ///< mutex for images provided by the image source
     int m_ThreadID; ///< ID of the started thread
 
     bool m_UnregisteringStarted;
+
+    /**
+    * \brief Holds the ring buffer frame whose memory is referenced by the output.
+    * It is registered as (inactive) observer of the output, so the output owns
+    * it and the slot is not written again as long as the output exists.
+    */
+    class OutputFrameHolder : public itk::Command
+    {
+    public:
+      mitkClassMacro(OutputFrameHolder, itk::Command);
+      itkFactorylessNewMacro(Self)
+
+      void Execute(itk::Object*, const itk::EventObject&) {}
+      void Execute(const itk::Object*, const itk::EventObject&) {}
+
+      const itk::Object*             Output; ///< output the holder is registered at, not referenced
+      mitk::USImageRingBuffer::Frame Frame;
+
+    protected:
+      OutputFrameHolder() : Output(0) {}
+    };
+
+    OutputFrameHolder::Pointer m_OutputFrameHolder;
   };
 } // namespace mitk
 
@@ -0,0 +1,243 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#include "mitkUSImageRingBuffer.h"
+
+#include <mitkException.h>
+#include <itkMutexLockHolder.h>
+
+mitk::USImageRingBuffer::Frame::Frame()
+  : m_Slot(0)
+{
+}
+
+mitk::USImageRingBuffer::Frame::Frame(USImageRingBuffer* buffer, unsigned int slot)
+  : m_Buffer(buffer), m_Slot(slot)
+{
+  // the reference on the slot was already taken by the ring buffer
+}
+
+mitk::USImageRingBuffer::Frame::Frame(const Frame& other)
+  : m_Buffer(other.m_Buffer), m_Slot(other.m_Slot)
+{
+  if ( m_Buffer.IsNotNull() ) { m_Buffer->m_Slots[m_Slot].References.Increment(); }
+}
+
+mitk::USImageRingBuffer::Frame::~Frame()
+{
+  this->Release();
+}
+
+mitk::USImageRingBuffer::Frame& mitk::USImageRingBuffer::Frame::operator=(const Frame& other)
+{
+  if ( this != &other )
+  {
+    // take the new reference first, other could share the slot with this
+    if ( other.m_Buffer.IsNotNull() ) { other.m_Buffer->m_Slots[other.m_Slot].References.Increment(); }
+    this->Release();
+    m_Buffer = other.m_Buffer;
+    m_Slot = other.m_Slot;
+  }
+  return *this;
+}
+
+bool mitk::USImageRingBuffer::Frame::IsValid() const
+{
+  return m_Buffer.IsNotNull();
+}
+
+mitk::Image* mitk::USImageRingBuffer::Frame::GetImage() const
+{
+  if ( m_Buffer.IsNull() ) { return 0; }
+  return m_Buffer->m_Slots[m_Slot].Image.GetPointer();
+}
+
+unsigned long mitk::USImageRingBuffer::Frame::GetFrameNumber() const
+{
+  if ( m_Buffer.IsNull() ) { return 0; }
+  return m_Buffer->m_Slots[m_Slot].FrameNumber;
+}
+
+double mitk::USImageRingBuffer::Frame::GetTimeStamp() const
+{
+  if ( m_Buffer.IsNull() ) { return 0; }
+  return m_Buffer->m_Slots[m_Slot].TimeStamp;
+}
+
+void mitk::USImageRingBuffer::Frame::Release()
+{
+  if ( m_Buffer.IsNotNull() )
+  {
+    m_Buffer->m_Slots[m_Slot].References.Decrement();
+    m_Buffer = 0;
+  }
+}
+
+mitk::USImageRingBuffer::USImageRingBuffer(unsigned int numberOfSlots)
+  : m_NumberOfSlots(numberOfSlots < 2 ? 2 : numberOfSlots),
+    m_Slots(0),
+    m_WriteSlot(-1),
+    m_NextFrameNumber(1),
+    m_LatestSlot(-1),
+    m_Clock(mitk::RealTimeClock::New()),
+    m_LatencySum(0),
+    m_NumberOfLatencies(0)
+{
+  m_Slots = new Slot[m_NumberOfSlots];
+  for ( unsigned int i = 0; i < m_NumberOfSlots; ++i )
+  {
+    m_Slots[i].Image = mitk::Image::New();
+  }
+}
+
+mitk::USImageRingBuffer::~USImageRingBuffer()
+{
+  // frames hold a smart pointer on the buffer, so none can be left here
+  delete[] m_Slots;
+}
+
+bool mitk::USImageRingBuffer::BeginWrite()
+{
+  if ( m_WriteSlot >= 0 )
+  {
+    MITK_WARN("USImageRingBuffer") << "BeginWrite() called twice without EndWrite().";
+    return true;
+  }
+
+  // search round robin beginning behind the latest slot, which is left
+  // untouched so that consumers always find a complete frame
+  long latest = m_LatestSlot.Get();
+  unsigned int start = latest < 0 ? 0 : static_cast<unsigned int>(latest) + 1;
+  for ( unsigned int i = 0; i < m_NumberOfSlots; ++i )
+  {
+    unsigned int slot = (start + i) % m_NumberOfSlots;
+    if ( static_cast<long>(slot) == latest ) { continue; }
+
+    if ( m_Slots[slot].References.CompareAndSwap(0, -1) )
+    {
+      if ( m_Slots[slot].FrameNumber != 0 && m_Slots[slot].Retrieved.Get() == 0 )
+      {
+        m_NumberOfSkippedFrames.Increment();
+      }
+      m_WriteSlot = static_cast<int>(slot);
+      return true;
+    }
+  }
+
+  m_NumberOfDroppedFrames.Increment();
+  return false;
+}
+
+mitk::Image::Pointer& mitk::USImageRingBuffer::GetWriteImage()
+{
+  if ( m_WriteSlot < 0 )
+  {
+    mitkThrow() << "No slot claimed, BeginWrite() must be called before writing a frame.";
+  }
+  return m_Slots[m_WriteSlot].Image;
+}
+
+void mitk::USImageRingBuffer::EndWrite(bool isValid)
+{
+  if ( m_WriteSlot < 0 ) { return; }
+
+  Slot& slot = m_Slots[m_WriteSlot];
+  if ( isValid && slot.Image.IsNotNull() && slot.Image->IsInitialized() )
+  {
+    slot.FrameNumber = m_NextFrameNumber++;
+    slot.TimeStamp = m_Clock->GetCurrentStamp();
+    slot.Retrieved.CompareAndSwap(1, 0);
+    slot.References.CompareAndSwap(-1, 0);
+
+    // consumers may get the slot from now on
+    m_LatestSlot.Set(m_WriteSlot);
+    m_NumberOfFrames.Increment();
+  }
+  else
+  {
+    slot.FrameNumber = 0;
+    slot.References.CompareAndSwap(-1, 0);
+  }
+
+  m_WriteSlot = -1;
+}
+
+mitk::USImageRingBuffer::Frame mitk::USImageRingBuffer::GetLatestFrame()
+{
+  while ( true )
+  {
+    long latest = m_LatestSlot.Get();
+    if ( latest < 0 ) { return Frame(); }
+
+    Slot& slot = m_Slots[latest];
+    long references = slot.References.Get();
+
+    // the producer overwrites the slot, there must be a newer latest one
+    if ( references < 0 ) { continue; }
+
+    if ( slot.References.CompareAndSwap(references, references + 1) )
+    {
+      // the slot was released without publishing after reading latest
+      if ( slot.FrameNumber == 0 )
+      {
+        slot.References.Decrement();
+        continue;
+      }
+
+      if ( slot.Retrieved.CompareAndSwap(0, 1) )
+      {
+        double latency = m_Clock->GetCurrentStamp() - slot.TimeStamp;
+        itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_LatencyMutex);
+        m_LatencySum += latency;
+        ++m_NumberOfLatencies;
+      }
+
+      return Frame(this, static_cast<unsigned int>(latest));
+    }
+  }
+}
+
+unsigned long mitk::USImageRingBuffer::GetNumberOfFrames() const
+{
+  return m_NumberOfFrames.Get();
+}
+
+unsigned long mitk::USImageRingBuffer::GetNumberOfDroppedFrames() const
+{
+  return m_NumberOfDroppedFrames.Get();
+}
+
+unsigned long mitk::USImageRingBuffer::GetNumberOfSkippedFrames() const
+{
+  return m_NumberOfSkippedFrames.Get();
+}
+
+double mitk::USImageRingBuffer::GetAverageLatency() const
+{
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_LatencyMutex);
+  return m_NumberOfLatencies > 0 ? m_LatencySum / m_NumberOfLatencies : 0;
+}
+
+void mitk::USImageRingBuffer::ResetCounters()
+{
+  m_NumberOfFrames.Set(0);
+  m_NumberOfDroppedFrames.Set(0);
+  m_NumberOfSkippedFrames.Set(0);
+
+  itk::MutexLockHolder<itk::SimpleFastMutexLock> lock(m_LatencyMutex);
+  m_LatencySum = 0;
+  m_NumberOfLatencies = 0;
+}
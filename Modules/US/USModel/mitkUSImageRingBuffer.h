@@ -0,0 +1,173 @@
+/*===================================================================
+
+The Medical Imaging Interaction Toolkit (MITK)
+
+Copyright (c) German Cancer Research Center,
+Division of Medical and Biological Informatics.
+All rights reserved.
+
+This software is distributed WITHOUT ANY WARRANTY; without
+even the implied warranty of MERCHANTABILITY or FITNESS FOR
+A PARTICULAR PURPOSE.
+
+See LICENSE.txt or http://www.mitk.org for details.
+
+===================================================================*/
+
+#ifndef MITKUSImageRingBuffer_H_HEADER_INCLUDED_
+#define MITKUSImageRingBuffer_H_HEADER_INCLUDED_
+
+// MITK
+#include <MitkUSExports.h>
+#include <mitkCommon.h>
+#include <mitkImage.h>
+#include <mitkAtomicInteger.h>
+#include <mitkRealTimeClock.h>
+
+// ITK
+#include <itkObject.h>
+#include <itkObjectFactory.h>
+#include <itkSimpleFastMutexLock.h>
+
+namespace mitk {
+  /**
+  * \brief Preallocated ring of image slots between one producer and any
+  * number of consumers.
+  *
+  * The producer (the acquisition thread of an mitk::USDevice) claims a slot
+  * with BeginWrite(), writes the frame directly into the image returned by
+  * GetWriteImage() and publishes it with EndWrite(). The images of the slots
+  * are kept between frames, so the producer only has to reinitialize them if
+  * the size or the pixel type of the frames changes.
+  *
+  * Consumers get the most recent frame by GetLatestFrame(). The returned
+  * mitk::USImageRingBuffer::Frame holds a reference on its slot, which is not
+  * written again until all frames referencing it are released. Consumers must
+  * not modify the image of a frame. Neither side takes a lock: every slot has
+  * an atomic reference count, which is -1 while the producer writes into it.
+  *
+  * If all slots are referenced by consumers, the producer has nowhere to write
+  * and the frame is dropped. A published frame that was overwritten before any
+  * consumer read it is counted as skipped. The latency is the time between
+  * publishing a frame and the first consumer getting it.
+  *
+  * \ingroup US
+  */
+  class MitkUS_EXPORT USImageRingBuffer : public itk::Object
+  {
+  public:
+    mitkClassMacro(USImageRingBuffer, itk::Object);
+    itkNewMacro(Self);
+    mitkNewMacro1Param(Self, unsigned int);
+
+    /**
+    * \brief Reference on one published frame of the ring buffer.
+    * Frames can be copied freely, the slot is released when the last copy
+    * referencing it is destroyed.
+    */
+    class MitkUS_EXPORT Frame
+    {
+    public:
+      Frame();
+      Frame(const Frame& other);
+      ~Frame();
+      Frame& operator=(const Frame& other);
+
+      /** \brief False if there was no published frame. */
+      bool IsValid() const;
+
+      /** \brief Image of the frame. Must not be modified. */
+      mitk::Image* GetImage() const;
+
+      /** \brief Consecutive number of the frame, starting at 1 (0 if invalid). */
+      unsigned long GetFrameNumber() const;
+
+      /** \brief Time of publishing the frame in milliseconds (see mitk::RealTimeClock). */
+      double GetTimeStamp() const;
+
+      /** \brief Releases the slot, the frame is invalid afterwards. */
+      void Release();
+
+    private:
+      friend class USImageRingBuffer;
+      Frame(USImageRingBuffer* buffer, unsigned int slot);
+
+      USImageRingBuffer::Pointer m_Buffer;
+      unsigned int               m_Slot;
+    };
+
+    itkGetConstMacro(NumberOfSlots, unsigned int);
+
+    /**
+    * \brief Claims a slot for the next frame. Returns false (and counts a
+    * dropped frame) if all slots except the latest one are referenced by
+    * consumers. Must only be called by the producer thread.
+    */
+    bool BeginWrite();
+
+    /**
+    * \brief Image of the slot claimed by BeginWrite(). The producer may set
+    * a new image or write into the existing one.
+    */
+    mitk::Image::Pointer& GetWriteImage();
+
+    /**
+    * \brief Publishes the frame written into the claimed slot. If isValid is
+    * false, the slot is released without publishing anything.
+    */
+    void EndWrite(bool isValid = true);
+
+    /**
+    * \brief Returns the most recently published frame or an invalid frame if
+    * nothing was published yet. Can be called from any thread.
+    */
+    Frame GetLatestFrame();
+
+    /** \brief Number of published frames. */
+    unsigned long GetNumberOfFrames() const;
+    /** \brief Number of frames which could not be written because all slots were referenced. */
+    unsigned long GetNumberOfDroppedFrames() const;
+    /** \brief Number of published frames which were overwritten before any consumer got them. */
+    unsigned long GetNumberOfSkippedFrames() const;
+    /** \brief Average time between publishing a frame and its first retrieval in milliseconds. */
+    double GetAverageLatency() const;
+    /** \brief Sets all frame counters and the latency statistics to zero. */
+    void ResetCounters();
+
+  protected:
+    USImageRingBuffer(unsigned int numberOfSlots = 4);
+    virtual ~USImageRingBuffer();
+
+    struct Slot
+    {
+      Slot() : FrameNumber(0), TimeStamp(0) {}
+
+      mitk::Image::Pointer Image;
+      mitk::AtomicInteger  References;   ///< number of frames referencing the slot, -1 while written
+      mitk::AtomicInteger  Retrieved;    ///< set by the first consumer getting the frame
+      unsigned long        FrameNumber;  ///< 0 if the slot holds no published frame
+      double               TimeStamp;
+    };
+
+  private:
+    USImageRingBuffer(const Self&); // Not implemented on purpose.
+    void operator=(const Self&);    // Not implemented on purpose.
+
+    unsigned int                 m_NumberOfSlots;
+    Slot*                        m_Slots;
+    int                          m_WriteSlot;         ///< slot claimed by the producer, -1 if none
+    unsigned long                m_NextFrameNumber;   ///< only accessed by the producer
+    mitk::AtomicInteger          m_LatestSlot;        ///< most recently published slot, -1 if none
+
+    mitk::AtomicInteger          m_NumberOfFrames;
+    mitk::AtomicInteger          m_NumberOfDroppedFrames;
+    mitk::AtomicInteger          m_NumberOfSkippedFrames;
+
+    mitk::RealTimeClock::Pointer m_Clock;
+    mutable itk::SimpleFastMutexLock m_LatencyMutex;  ///< guards the latency statistics only
+    double                       m_LatencySum;
+    unsigned long                m_NumberOfLatencies;
+  };
+} // namespace mitk
+
+#endif // MITKUSImageRingBuffer_H_HEADER_INCLUDED_
@@ -11,9 +11,12 @@ USModel/mitkUSVideoDevice.cpp
 USModel/mitkUSVideoDeviceCustomControls.cpp
 USModel/mitkUSProbe.cpp
 USModel/mitkUSDevicePersistence.cpp
+USModel/mitkUSImageRingBuffer.cpp
 
 ## Filters and Sources
 USFilters/mitkUSImageLoggingFilter.cpp
+USFilters/mitkUSImageRecordingReader.cpp
+USFilters/mitkUSImageRecordingWriter.cpp
 USFilters/mitkUSImageSource.cpp
 USFilters/mitkUSImageVideoSource.cpp
 
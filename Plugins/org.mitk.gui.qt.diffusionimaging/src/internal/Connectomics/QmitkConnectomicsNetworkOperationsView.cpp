@@ -388,6 +388,7 @@ void QmitkConnectomicsNetworkOperationsView::OnModularizePushButtonClicked()
         permutation->SetStepSize( stepSize );
 
         manager->SetPermutation( permutation.GetPointer() );
+        manager->SetNumberOfChains( itk::MultiThreader::GetGlobalDefaultNumberOfThreads() );
 
         manager->RunSimulatedAnnealing( startTemperature, stepSize );
 
@@ -495,6 +495,7 @@ FiberfoxParameters< ScalarType > QmitkFiberfoxView::UpdateImageParameters()
     parameters.m_tEcho = m_Controls->m_TEbox->value();
     parameters.m_Repetitions = m_Controls->m_RepetitionsBox->value();
     parameters.m_DoDisablePartialVolume = m_Controls->m_EnforcePureFiberVoxelsBox->isChecked();
+    parameters.m_DoUseFft = m_Controls->m_UseFftBox->isChecked();
     parameters.m_AxonRadius = m_Controls->m_FiberRadius->value();
     parameters.m_SignalScale = m_Controls->m_SignalScaleBox->value();
 
@@ -886,6 +887,7 @@ FiberfoxParameters< ScalarType > QmitkFiberfoxView::UpdateImageParameters()
     parameters.m_ResultNode->AddProperty("Fiberfox.b-value", DoubleProperty::New(parameters.m_Bvalue));
     parameters.m_ResultNode->AddProperty("Fiberfox.NoPartialVolume", BoolProperty::New(parameters.m_DoDisablePartialVolume));
     parameters.m_ResultNode->AddProperty("Fiberfox.Relaxation", BoolProperty::New(parameters.m_DoSimulateRelaxation));
+    parameters.m_ResultNode->AddProperty("Fiberfox.UseFft", BoolProperty::New(parameters.m_DoUseFft));
     parameters.m_ResultNode->AddProperty("binary", BoolProperty::New(false));
 
     return parameters;
@@ -969,6 +971,7 @@ void QmitkFiberfoxView::SaveParameters()
     parameters.put("fiberfox.image.artifacts.aliasingfactor", m_Controls->m_WrapBox->value());
     parameters.put("fiberfox.image.artifacts.doAddMotion", m_Controls->m_AddMotion->isChecked());
     parameters.put("fiberfox.image.artifacts.randomMotion", m_Controls->m_RandomMotion->isChecked());
+    parameters.put("fiberfox.image.artifacts.useFft", m_Controls->m_UseFftBox->isChecked());
     parameters.put("fiberfox.image.artifacts.translation0", m_Controls->m_MaxTranslationBoxX->value());
     parameters.put("fiberfox.image.artifacts.translation1", m_Controls->m_MaxTranslationBoxY->value());
     parameters.put("fiberfox.image.artifacts.translation2", m_Controls->m_MaxTranslationBoxZ->value());
@@ -1107,6 +1110,7 @@ void QmitkFiberfoxView::LoadParameters()
             m_Controls->m_AddGibbsRinging->setChecked(v1.second.get<bool>("artifacts.addringing"));
             m_Controls->m_AddMotion->setChecked(v1.second.get<bool>("artifacts.doAddMotion"));
             m_Controls->m_RandomMotion->setChecked(v1.second.get<bool>("artifacts.randomMotion"));
+            m_Controls->m_UseFftBox->setChecked(v1.second.get<bool>("artifacts.useFft", false));
             m_Controls->m_MaxTranslationBoxX->setValue(v1.second.get<double>("artifacts.translation0"));
             m_Controls->m_MaxTranslationBoxY->setValue(v1.second.get<double>("artifacts.translation1"));
             m_Controls->m_MaxTranslationBoxZ->setValue(v1.second.get<double>("artifacts.translation2"));
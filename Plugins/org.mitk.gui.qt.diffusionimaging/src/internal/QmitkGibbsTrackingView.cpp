@@ -66,6 +66,7 @@ void QmitkTrackingWorker::run()
     m_View->m_GlobalTracker->SetMinFiberLength(m_View->m_Controls->m_FiberLengthSlider->value());
     m_View->m_GlobalTracker->SetCurvatureThreshold(cos((float)m_View->m_Controls->m_CurvatureThresholdSlider->value()*M_PI/180));
     m_View->m_GlobalTracker->SetRandomSeed(m_View->m_Controls->m_RandomSeedSlider->value());
+    m_View->m_GlobalTracker->SetNumberOfThreads(m_View->m_Controls->m_NumberOfThreadsSlider->value());
     try{
       m_View->m_GlobalTracker->Update();
     }
@@ -217,6 +218,7 @@ void QmitkGibbsTrackingView::CreateQtPartControl( QWidget *parent )
         connect( m_Controls->m_EndTempSlider, SIGNAL(valueChanged(int)), this, SLOT(SetEndTemp(int)) );
         connect( m_Controls->m_CurvatureThresholdSlider, SIGNAL(valueChanged(int)), this, SLOT(SetCurvatureThreshold(int)) );
         connect( m_Controls->m_RandomSeedSlider, SIGNAL(valueChanged(int)), this, SLOT(SetRandomSeed(int)) );
+        connect( m_Controls->m_NumberOfThreadsSlider, SIGNAL(valueChanged(int)), this, SLOT(SetNumberOfThreads(int)) );
         connect( m_Controls->m_OutputFileButton, SIGNAL(clicked()), this, SLOT(SetOutputFile()) );
     }
 }
@@ -239,6 +241,11 @@ void QmitkGibbsTrackingView::SetRandomSeed(int value)
         m_Controls->m_RandomSeedLabel->setText("auto");
 }
 
+void QmitkGibbsTrackingView::SetNumberOfThreads(int value)
+{
+    m_Controls->m_NumberOfThreadsLabel->setText(QString::number(value));
+}
+
 void QmitkGibbsTrackingView::SetParticleWeight(int value)
 {
     if (value>0)
@@ -377,7 +384,7 @@ void QmitkGibbsTrackingView::UpdateTrackingStatus()
     unsigned long minutes = (m_ElapsedTime%3600)/60;
     unsigned long seconds = m_ElapsedTime%60;
 
-    m_Controls->m_ProposalAcceptance->setText(QString::number(m_GlobalTracker->GetProposalAcceptance()*100)+"%");
+    m_Controls->m_ProposalAcceptance->setText(QString::number(m_GlobalTracker->GetProposalAcceptance()*100)+"% ("+QString::number((int)m_GlobalTracker->GetProposalsPerSecond())+" proposals/s)");
 
     m_Controls->m_TrackingTimeLabel->setText( QString::number(hours)+QString("h ")+QString::number(minutes)+QString("m ")+QString::number(seconds)+QString("s") );
     m_Controls->m_NumConnectionsLabel->setText( QString::number(m_GlobalTracker->GetNumConnections()) );
@@ -115,6 +115,7 @@ protected slots:
   void SetEndTemp(int value);
   void SetCurvatureThreshold(int value);
   void SetRandomSeed(int value);
+  void SetNumberOfThreads(int value);
   void SetOutputFile();
 
 private:
@@ -158,30 +158,27 @@ void QmitkImageStatisticsCalculationThread::run()
   calculator->SetIgnorePixelValue(0);
   calculator->SetHistogramBinSize( m_HistogramBinSize );
 
-  for (unsigned int i = 0; i < m_StatisticsImage->GetTimeSteps(); i++)
+  try
   {
-    try
-    {
-      statisticChanged = calculator->ComputeStatistics(i);
-    }
-    catch ( mitk::Exception& e)
-    {
-      //m_message = e.GetDescription();
-      MITK_ERROR<< "MITK Exception: " << e.what();
-      statisticCalculationSuccessful = false;
-    }
-    catch ( const std::runtime_error &e )
-    {
-      //m_message = "Failure: " + std::string(e.what());
-      MITK_ERROR<< "Runtime Exception: " << e.what();
-      statisticCalculationSuccessful = false;
-    }
-    catch ( const std::exception &e )
-    {
-      //m_message = "Failure: " + std::string(e.what());
-      MITK_ERROR<< "Standard Exception: " << e.what();
-      statisticCalculationSuccessful = false;
-    }
+    statisticChanged = calculator->ComputeStatisticsOfAllTimeSteps();
+  }
+  catch ( mitk::Exception& e)
+  {
+    //m_message = e.GetDescription();
+    MITK_ERROR<< "MITK Exception: " << e.what();
+    statisticCalculationSuccessful = false;
+  }
+  catch ( const std::runtime_error &e )
+  {
+    //m_message = "Failure: " + std::string(e.what());
+    MITK_ERROR<< "Runtime Exception: " << e.what();
+    statisticCalculationSuccessful = false;
+  }
+  catch ( const std::exception &e )
+  {
+    //m_message = "Failure: " + std::string(e.what());
+    MITK_ERROR<< "Standard Exception: " << e.what();
+    statisticCalculationSuccessful = false;
   }
 
   this->m_StatisticChanged = statisticChanged;